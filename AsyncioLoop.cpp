@@ -0,0 +1,253 @@
+#include "AsyncioLoop.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QTimer>
+
+#include <pybind11/eval.h>
+
+#include <cmath>
+#include <stdexcept>
+
+// Python侧的循环实现
+//
+// 选择器登记的文件描述符同步给C++创建QSocketNotifier。step()由C++在通知或定时到期时调用，
+// 以0超时运行一轮_run_once()，返回距下一轮的秒数。_run_once()、_ready和_scheduled
+// 是BaseEventLoop的内部成员，3.10到3.13保持一致。
+static const char* const kLoopSource = R"(
+import asyncio
+import selectors
+from asyncio import events as asyncio_events
+
+
+class QtSelector(selectors.DefaultSelector):
+    def __init__(self, watch, unwatch):
+        super().__init__()
+        self._watch = watch
+        self._unwatch = unwatch
+        self.polling = False
+
+    def register(self, fileobj, events, data=None):
+        key = super().register(fileobj, events, data)
+        self._watch(key.fd, key.events)
+        return key
+
+    def unregister(self, fileobj):
+        key = super().unregister(fileobj)
+        self._unwatch(key.fd)
+        return key
+
+    def modify(self, fileobj, events, data=None):
+        key = super().modify(fileobj, events, data)
+        self._watch(key.fd, key.events)
+        return key
+
+    def select(self, timeout=None):
+        return super().select(0 if self.polling else timeout)
+
+    def close(self):
+        for key in list(self.get_map().values()):
+            self._unwatch(key.fd)
+        super().close()
+
+
+class QtEventLoop(asyncio.SelectorEventLoop):
+    def __init__(self, watch, unwatch):
+        super().__init__(QtSelector(watch, unwatch))
+
+    def step(self):
+        if self.is_running() or self.is_closed():
+            return None
+        self._selector.polling = True
+        asyncio_events._set_running_loop(self)
+        try:
+            self._run_once()
+        finally:
+            asyncio_events._set_running_loop(None)
+            self._selector.polling = False
+        if self._ready:
+            return 0.0
+        if self._scheduled:
+            return max(0.0, self._scheduled[0].when() - self.time())
+        return None
+
+    def run_cell(self, coroutine):
+        task = self.create_task(coroutine)
+        try:
+            return self.run_until_complete(task)
+        except BaseException:
+            task.cancel()
+            raise
+
+    def shutdown(self, timeout):
+        if self.is_closed():
+            return
+        tasks = asyncio.all_tasks(self)
+        for task in tasks:
+            task.cancel()
+        if tasks:
+            self.run_until_complete(asyncio.wait(tasks, timeout=timeout))
+        self.run_until_complete(self.shutdown_asyncgens())
+        self.close()
+)";
+
+// 关闭循环时等待任务响应取消的最长时间
+static const double kShutdownTimeoutSeconds = 1.0;
+
+AsyncioLoop::AsyncioLoop(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &AsyncioLoop::step);
+}
+
+AsyncioLoop::~AsyncioLoop()
+{
+    close();
+}
+
+py::object AsyncioLoop::install()
+{
+    if (m_loop && m_loop.attr("is_closed")().cast<bool>()) {
+        m_loop = py::object();
+    }
+
+    if (!m_loop) {
+        py::dict scope;
+        scope["__name__"]     = "qt_asyncio";
+        scope["__builtins__"] = py::module_::import("builtins");
+        py::exec(kLoopSource, scope);
+
+        py::cpp_function watchFunction([this](qintptr fd, int events) { watch(fd, events); });
+        py::cpp_function unwatchFunction([this](qintptr fd) { unwatch(fd); });
+        m_loop = scope["QtEventLoop"](watchFunction, unwatchFunction);
+
+        // 线程结束前在该线程中关闭循环，套接字通知器随之注销
+        connect(QThread::currentThread(), &QThread::finished, this, &AsyncioLoop::close, Qt::DirectConnection);
+    }
+
+    py::module_::import("asyncio").attr("set_event_loop")(m_loop);
+    return m_loop;
+}
+
+py::object AsyncioLoop::runUntilComplete(py::object coroutine)
+{
+    py::object loop = install();
+    return loop.attr("run_cell")(coroutine);
+}
+
+void AsyncioLoop::wake()
+{
+    QMetaObject::invokeMethod(this, [this]() { scheduleStep(0.0); }, Qt::QueuedConnection);
+}
+
+int AsyncioLoop::pendingTasks() const
+{
+    if (!m_loop || m_loop.attr("is_closed")().cast<bool>()) {
+        return 0;
+    }
+    return static_cast<int>(py::len(py::module_::import("asyncio").attr("all_tasks")(m_loop)));
+}
+
+void AsyncioLoop::close()
+{
+    m_timer->stop();
+    if (!m_loop) {
+        return;
+    }
+
+    if (!Py_IsInitialized()) {
+        // 解释器已销毁，对象随之失效
+        m_loop.release();
+        return;
+    }
+
+    py::gil_scoped_acquire acquire;
+    try {
+        m_loop.attr("shutdown")(kShutdownTimeoutSeconds);
+    }
+    catch (py::error_already_set& e) {
+        e.discard_as_unraisable("AsyncioLoop.close");
+    }
+    m_loop = py::object();
+
+    // 选择器关闭时已逐个注销，这里只处理遗留的通知器
+    const QHash<qintptr, Notifiers> remaining = m_notifiers;
+    m_notifiers.clear();
+    for (const Notifiers& notifiers : remaining) {
+        delete notifiers.read;
+        delete notifiers.write;
+    }
+}
+
+void AsyncioLoop::step()
+{
+    if (!m_loop) {
+        return;
+    }
+
+    double delaySeconds = -1.0;
+    {
+        py::gil_scoped_acquire acquire;
+        try {
+            py::object delay = m_loop.attr("step")();
+            if (!delay.is_none()) {
+                delaySeconds = delay.cast<double>();
+            }
+        }
+        catch (py::error_already_set& e) {
+            // 回调中的普通异常由循环的异常处理器报告，到这里的是KeyboardInterrupt、SystemExit等
+            e.discard_as_unraisable("AsyncioLoop.step");
+            delaySeconds = 0.0;
+        }
+    }
+    scheduleStep(delaySeconds);
+}
+
+void AsyncioLoop::scheduleStep(double delaySeconds)
+{
+    if (!m_loop || delaySeconds < 0) {
+        m_timer->stop();
+        return;
+    }
+
+    // 向上取整，到期时该回调一定已经可以运行
+    m_timer->start(static_cast<int>(std::ceil(delaySeconds * 1000.0)));
+}
+
+void AsyncioLoop::watch(qintptr fd, int events)
+{
+    // 通知器只能在所在线程中创建和销毁；其他线程应使用call_soon_threadsafe()
+    if (QThread::currentThread() != thread()) {
+        throw std::runtime_error("the Qt asyncio loop can only be used from the runner thread");
+    }
+
+    Notifiers& notifiers = m_notifiers[fd];
+
+    auto update = [this, fd](QSocketNotifier*& notifier, QSocketNotifier::Type type, bool wanted) {
+        if (wanted && !notifier) {
+            notifier = new QSocketNotifier(fd, type, this);
+            connect(notifier, &QSocketNotifier::activated, this, [this]() { scheduleStep(0.0); });
+        }
+        else if (!wanted && notifier) {
+            delete notifier;
+            notifier = nullptr;
+        }
+    };
+    update(notifiers.read, QSocketNotifier::Read, events & 1);
+    update(notifiers.write, QSocketNotifier::Write, events & 2);
+}
+
+void AsyncioLoop::unwatch(qintptr fd)
+{
+    if (QThread::currentThread() != thread()) {
+        throw std::runtime_error("the Qt asyncio loop can only be used from the runner thread");
+    }
+
+    Notifiers notifiers = m_notifiers.take(fd);
+    delete notifiers.read;
+    delete notifiers.write;
+}
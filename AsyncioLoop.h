@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * @class AsyncioLoop
+ * @brief 由所在线程的Qt事件循环驱动的asyncio事件循环
+ *
+ * Python侧是asyncio.SelectorEventLoop的子类，选择器在登记文件描述符的同时创建QSocketNotifier，
+ * 最近的定时回调用一个QTimer表示。线程回到Qt事件循环后，套接字可读写或定时到期时
+ * 以不阻塞的方式运行一轮asyncio回调，因此后台任务（遥测读取、HTTP轮询等）在两次运行之间继续工作。
+ *
+ * 运行中的代码使用顶层await时，runUntilComplete()在同一个循环上运行到结束，
+ * 期间用循环自己的选择器等待，调试钩子照常生效；此前创建的后台任务也同时运行。
+ * 代码中的asyncio.run()仍然新建独立的循环，不受影响。
+ *
+ * 对象必须位于运行代码的线程中（随CodeRunner一起移动），除wake()外的接口只能在该线程调用。
+ * 后台回调在运行之间执行，输出写到默认目标；单个回调长时间不返回时会推迟下一次运行。
+ * 循环在线程结束时关闭：取消剩余任务，最多等待1秒。
+ */
+class AsyncioLoop : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit AsyncioLoop(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（关闭循环）
+     */
+    ~AsyncioLoop() override;
+
+    /**
+     * @brief 创建循环（首次调用时）并设为当前线程的事件循环（需持有GIL）
+     *
+     * 每次运行前调用：代码中的asyncio.run()结束时会清除当前线程的事件循环。
+     * @return py::object 事件循环
+     */
+    py::object install();
+
+    /**
+     * @brief 在循环上运行协程直到结束（需持有GIL）
+     *
+     * 中止或出错时取消该协程对应的任务，Python异常以py::error_already_set抛出。
+     * @param coroutine 协程对象
+     * @return py::object 协程的返回值
+     */
+    py::object runUntilComplete(py::object coroutine);
+
+    /**
+     * @brief 安排尽快运行一轮回调（线程安全）
+     *
+     * 运行结束后调用，使运行期间创建但尚未开始的任务在后台开始运行。
+     */
+    void wake();
+
+    /**
+     * @brief 后台任务数（需持有GIL）
+     * @return int 未结束的任务数，循环未创建时为0
+     */
+    int pendingTasks() const;
+
+public slots:
+    /**
+     * @brief 取消所有任务并关闭循环（自行获取GIL）
+     */
+    void close();
+
+private:
+    /**
+     * @brief 运行一轮回调并按下一个定时回调重新安排（在所在线程中调用）
+     */
+    void step();
+
+    /**
+     * @brief 安排下一轮
+     * @param delaySeconds 距下一轮的秒数，小于0表示没有定时回调
+     */
+    void scheduleStep(double delaySeconds);
+
+    /**
+     * @brief 选择器登记或修改文件描述符时调用（需持有GIL）
+     * @param fd 文件描述符或套接字
+     * @param events selectors.EVENT_READ/EVENT_WRITE的组合
+     */
+    void watch(qintptr fd, int events);
+
+    /**
+     * @brief 选择器注销文件描述符时调用
+     * @param fd 文件描述符或套接字
+     */
+    void unwatch(qintptr fd);
+
+private:
+    struct Notifiers
+    {
+        QSocketNotifier* read  = nullptr;
+        QSocketNotifier* write = nullptr;
+    };
+
+    py::object                m_loop;              // Python侧的事件循环，未创建时为空
+    QHash<qintptr, Notifiers> m_notifiers;         // 按文件描述符
+    QTimer*                   m_timer = nullptr;   // 下一轮的时刻
+};
@@ -0,0 +1,753 @@
+#include "BatchKernels.h"
+#include "BufferBridge.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BATCH_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BATCH_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC和Clang按函数启用指令集，整个文件仍按基线编译；MSVC不需要标注即可使用内建函数
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+namespace BatchKernels {
+
+namespace {
+
+struct Table
+{
+    Isa isa;
+    double (*sum)(const double*, size_t);
+    void (*minMax)(const double*, size_t, double*, double*);
+    double (*dot)(const double*, const double*, size_t);
+    void (*scale)(double*, size_t, double);
+    void (*axpy)(double, const double*, double*, size_t);
+    size_t (*trailingBytes)(const char*, size_t);   // 去掉末尾0后的字节数
+};
+
+// ---------------------------------------------------------------- 标量实现
+
+double sumScalar(const double* data, size_t size)
+{
+    double total = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+void minMaxScalar(const double* data, size_t size, double* minimum, double* maximum)
+{
+    double low  = data[0];
+    double high = data[0];
+    for (size_t i = 1; i < size; ++i) {
+        low  = std::min(low, data[i]);
+        high = std::max(high, data[i]);
+    }
+    *minimum = low;
+    *maximum = high;
+}
+
+double dotScalar(const double* a, const double* b, size_t size)
+{
+    double total = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+void scaleScalar(double* data, size_t size, double factor)
+{
+    for (size_t i = 0; i < size; ++i) {
+        data[i] *= factor;
+    }
+}
+
+void axpyScalar(double alpha, const double* x, double* y, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+size_t trailingBytesScalar(const char* item, size_t bytes)
+{
+    while (bytes > 0 && item[bytes - 1] == 0) {
+        --bytes;
+    }
+    return bytes;
+}
+
+const Table kScalarTable = {
+    Scalar, sumScalar, minMaxScalar, dotScalar, scaleScalar, axpyScalar, trailingBytesScalar};
+
+#ifdef BATCH_KERNELS_X86
+
+// ---------------------------------------------------------------- x86
+
+inline int highestBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanReverse(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+KERNEL_TARGET("avx2") double horizontalSum(__m256d value)
+{
+    __m128d low = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+KERNEL_TARGET("avx2") double sumAvx2(const double* data, size_t size)
+{
+    // 四组累加器隐藏加法延迟，循环受内存带宽限制
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(data + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(data + i + 12));
+    }
+    for (; i + 4 <= size; i += 4) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+    }
+
+    double total = horizontalSum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < size; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+KERNEL_TARGET("avx2") void minMaxAvx2(const double* data, size_t size, double* minimum, double* maximum)
+{
+    __m256d low  = _mm256_set1_pd(data[0]);
+    __m256d high = low;
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m256d value = _mm256_loadu_pd(data + i);
+        low                 = _mm256_min_pd(low, value);
+        high                = _mm256_max_pd(high, value);
+    }
+
+    alignas(32) double lows[4];
+    alignas(32) double highs[4];
+    _mm256_store_pd(lows, low);
+    _mm256_store_pd(highs, high);
+
+    double resultLow  = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+    double resultHigh = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+    for (; i < size; ++i) {
+        resultLow  = std::min(resultLow, data[i]);
+        resultHigh = std::max(resultHigh, data[i]);
+    }
+    *minimum = resultLow;
+    *maximum = resultHigh;
+}
+
+KERNEL_TARGET("avx2") double dotAvx2(const double* a, const double* b, size_t size)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+
+    double total = horizontalSum(_mm256_add_pd(acc0, acc1));
+    for (; i < size; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+KERNEL_TARGET("avx2") void scaleAvx2(double* data, size_t size, double factor)
+{
+    const __m256d multiplier = _mm256_set1_pd(factor);
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), multiplier));
+    }
+    for (; i < size; ++i) {
+        data[i] *= factor;
+    }
+}
+
+KERNEL_TARGET("avx2") void axpyAvx2(double alpha, const double* x, double* y, size_t size)
+{
+    const __m256d multiplier = _mm256_set1_pd(alpha);
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m256d product = _mm256_mul_pd(_mm256_loadu_pd(x + i), multiplier);
+        _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), product));
+    }
+    for (; i < size; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+KERNEL_TARGET("avx2") size_t trailingBytesAvx2(const char* item, size_t bytes)
+{
+    // 从末尾每次比较32字节，全为0时跳过，否则取最高的非0字节
+    const __m256i zero = _mm256_setzero_si256();
+    while (bytes >= 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(item + bytes - 32));
+        const unsigned int nonZero =
+            ~static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero)));
+        if (nonZero) {
+            return bytes - 32 + highestBit(nonZero) + 1;
+        }
+        bytes -= 32;
+    }
+    return trailingBytesScalar(item, bytes);
+}
+
+const Table kAvx2Table = {Avx2, sumAvx2, minMaxAvx2, dotAvx2, scaleAvx2, axpyAvx2, trailingBytesAvx2};
+
+KERNEL_TARGET("avx512f") double sumAvx512(const double* data, size_t size)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd();
+    __m512d acc3 = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        acc0 = _mm512_add_pd(acc0, _mm512_loadu_pd(data + i));
+        acc1 = _mm512_add_pd(acc1, _mm512_loadu_pd(data + i + 8));
+        acc2 = _mm512_add_pd(acc2, _mm512_loadu_pd(data + i + 16));
+        acc3 = _mm512_add_pd(acc3, _mm512_loadu_pd(data + i + 24));
+    }
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm512_add_pd(acc0, _mm512_loadu_pd(data + i));
+    }
+
+    double total = _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+    for (; i < size; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+KERNEL_TARGET("avx512f") void minMaxAvx512(const double* data, size_t size, double* minimum, double* maximum)
+{
+    __m512d low  = _mm512_set1_pd(data[0]);
+    __m512d high = low;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const __m512d value = _mm512_loadu_pd(data + i);
+        low                 = _mm512_min_pd(low, value);
+        high                = _mm512_max_pd(high, value);
+    }
+
+    double resultLow  = _mm512_reduce_min_pd(low);
+    double resultHigh = _mm512_reduce_max_pd(high);
+    for (; i < size; ++i) {
+        resultLow  = std::min(resultLow, data[i]);
+        resultHigh = std::max(resultHigh, data[i]);
+    }
+    *minimum = resultLow;
+    *maximum = resultHigh;
+}
+
+KERNEL_TARGET("avx512f") double dotAvx512(const double* a, const double* b, size_t size)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+        acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8)));
+    }
+
+    double total = _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+    for (; i < size; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+KERNEL_TARGET("avx512f") void scaleAvx512(double* data, size_t size, double factor)
+{
+    const __m512d multiplier = _mm512_set1_pd(factor);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        _mm512_storeu_pd(data + i, _mm512_mul_pd(_mm512_loadu_pd(data + i), multiplier));
+    }
+    for (; i < size; ++i) {
+        data[i] *= factor;
+    }
+}
+
+KERNEL_TARGET("avx512f") void axpyAvx512(double alpha, const double* x, double* y, size_t size)
+{
+    const __m512d multiplier = _mm512_set1_pd(alpha);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const __m512d product = _mm512_mul_pd(_mm512_loadu_pd(x + i), multiplier);
+        _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), product));
+    }
+    for (; i < size; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// 逐字节比较需要AVX-512BW，字符串长度沿用AVX2实现（支持AVX-512的CPU都支持AVX2）
+const Table kAvx512Table = {
+    Avx512, sumAvx512, minMaxAvx512, dotAvx512, scaleAvx512, axpyAvx512, trailingBytesAvx2};
+
+// CPU支持且操作系统保存了对应的寄存器状态才可以使用
+void detectX86(bool* avx2, bool* avx512)
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    unsigned int maxLeaf = 0;
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    maxLeaf = static_cast<unsigned int>(info[0]);
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+#else
+    if (!__get_cpuid(0, &maxLeaf, &ebx, &ecx, &edx) || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return;
+    }
+#endif
+
+    const bool osXSave = (ecx & (1u << 27)) != 0;
+    const bool avx     = (ecx & (1u << 28)) != 0;
+    if (!osXSave || !avx || maxLeaf < 7) {
+        return;
+    }
+
+#if defined(_MSC_VER)
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    ebx = static_cast<unsigned int>(info[1]);
+#else
+    unsigned int xcr0Low = 0, xcr0High = 0;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    const unsigned long long xcr0 = (static_cast<unsigned long long>(xcr0High) << 32) | xcr0Low;
+    __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+#endif
+
+    // XMM、YMM状态；AVX-512另需opmask和ZMM状态
+    const bool ymmState = (xcr0 & 0x06) == 0x06;
+    const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+    *avx2               = ymmState && (ebx & (1u << 5)) != 0;
+    *avx512             = *avx2 && zmmState && (ebx & (1u << 16)) != 0;
+}
+
+#endif   // BATCH_KERNELS_X86
+
+#ifdef BATCH_KERNELS_NEON
+
+// ---------------------------------------------------------------- AArch64 NEON
+
+double sumNeon(const double* data, size_t size)
+{
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    float64x2_t acc2 = vdupq_n_f64(0.0);
+    float64x2_t acc3 = vdupq_n_f64(0.0);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = vaddq_f64(acc0, vld1q_f64(data + i));
+        acc1 = vaddq_f64(acc1, vld1q_f64(data + i + 2));
+        acc2 = vaddq_f64(acc2, vld1q_f64(data + i + 4));
+        acc3 = vaddq_f64(acc3, vld1q_f64(data + i + 6));
+    }
+
+    double total = vaddvq_f64(vaddq_f64(vaddq_f64(acc0, acc1), vaddq_f64(acc2, acc3)));
+    for (; i < size; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+void minMaxNeon(const double* data, size_t size, double* minimum, double* maximum)
+{
+    float64x2_t low  = vdupq_n_f64(data[0]);
+    float64x2_t high = low;
+
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        const float64x2_t value = vld1q_f64(data + i);
+        low                     = vminq_f64(low, value);
+        high                    = vmaxq_f64(high, value);
+    }
+
+    double resultLow  = vminvq_f64(low);
+    double resultHigh = vmaxvq_f64(high);
+    for (; i < size; ++i) {
+        resultLow  = std::min(resultLow, data[i]);
+        resultHigh = std::max(resultHigh, data[i]);
+    }
+    *minimum = resultLow;
+    *maximum = resultHigh;
+}
+
+double dotNeon(const double* a, const double* b, size_t size)
+{
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        acc0 = vfmaq_f64(acc0, vld1q_f64(a + i), vld1q_f64(b + i));
+        acc1 = vfmaq_f64(acc1, vld1q_f64(a + i + 2), vld1q_f64(b + i + 2));
+    }
+
+    double total = vaddvq_f64(vaddq_f64(acc0, acc1));
+    for (; i < size; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+void scaleNeon(double* data, size_t size, double factor)
+{
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        vst1q_f64(data + i, vmulq_n_f64(vld1q_f64(data + i), factor));
+    }
+    for (; i < size; ++i) {
+        data[i] *= factor;
+    }
+}
+
+void axpyNeon(double alpha, const double* x, double* y, size_t size)
+{
+    const float64x2_t multiplier = vdupq_n_f64(alpha);
+
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        vst1q_f64(y + i, vfmaq_f64(vld1q_f64(y + i), vld1q_f64(x + i), multiplier));
+    }
+    for (; i < size; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+size_t trailingBytesNeon(const char* item, size_t bytes)
+{
+    // 从末尾每次检查16字节，全为0时跳过
+    while (bytes >= 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(item + bytes - 16));
+        if (vmaxvq_u8(chunk) != 0) {
+            return trailingBytesScalar(item, bytes);
+        }
+        bytes -= 16;
+    }
+    return trailingBytesScalar(item, bytes);
+}
+
+const Table kNeonTable = {Neon, sumNeon, minMaxNeon, dotNeon, scaleNeon, axpyNeon, trailingBytesNeon};
+
+#endif   // BATCH_KERNELS_NEON
+
+const Table* tableFor(Isa isa)
+{
+    switch (isa) {
+#ifdef BATCH_KERNELS_X86
+    case Avx512:
+        return &kAvx512Table;
+    case Avx2:
+        return &kAvx2Table;
+#endif
+#ifdef BATCH_KERNELS_NEON
+    case Neon:
+        return &kNeonTable;
+#endif
+    default:
+        return &kScalarTable;
+    }
+}
+
+std::atomic<const Table*> s_table{nullptr};
+
+const Table& table()
+{
+    const Table* current = s_table.load(std::memory_order_acquire);
+    if (!current) {
+        current = tableFor(bestIsa());
+        s_table.store(current, std::memory_order_release);
+    }
+    return *current;
+}
+
+// 数组参数不做类型转换，类型或布局不符时报错
+using Array = py::array_t<double, py::array::c_style>;
+
+}   // namespace
+
+Isa bestIsa()
+{
+    static const Isa best = []() {
+#if defined(BATCH_KERNELS_X86)
+        bool avx2 = false, avx512 = false;
+        detectX86(&avx2, &avx512);
+        return avx512 ? Avx512 : (avx2 ? Avx2 : Scalar);
+#elif defined(BATCH_KERNELS_NEON)
+        // AArch64上NEON是基线指令集
+        return Neon;
+#else
+        return Scalar;
+#endif
+    }();
+    return best;
+}
+
+Isa activeIsa()
+{
+    return table().isa;
+}
+
+Isa setIsa(Isa isa)
+{
+    const Isa best = bestIsa();
+
+    // 标量总是可用；x86上支持AVX-512时也可以选择AVX2，其余不支持的选择使用最快的实现
+    bool supported = isa == Scalar || isa == best;
+    if (isa == Avx2 && best == Avx512) {
+        supported = true;
+    }
+
+    const Table* selected = tableFor(supported ? isa : best);
+    s_table.store(selected, std::memory_order_release);
+    return selected->isa;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa) {
+    case Neon:
+        return "neon";
+    case Avx2:
+        return "avx2";
+    case Avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+double sum(const double* data, size_t size)
+{
+    return table().sum(data, size);
+}
+
+void minMax(const double* data, size_t size, double* minimum, double* maximum)
+{
+    if (size > 0) {
+        table().minMax(data, size, minimum, maximum);
+    }
+}
+
+double dot(const double* a, const double* b, size_t size)
+{
+    return table().dot(a, b, size);
+}
+
+void scale(double* data, size_t size, double factor)
+{
+    table().scale(data, size, factor);
+}
+
+void axpy(double alpha, const double* x, double* y, size_t size)
+{
+    table().axpy(alpha, x, y, size);
+}
+
+void fixedStringLengths(const char* data, size_t count, size_t itemBytes, size_t unitBytes, int64_t* lengths)
+{
+    size_t (*trailingBytes)(const char*, size_t) = table().trailingBytes;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t bytes = trailingBytes(data + i * itemBytes, itemBytes);
+        lengths[i]         = static_cast<int64_t>((bytes + unitBytes - 1) / unitBytes);
+    }
+}
+
+void bind(py::module_& m)
+{
+    // 数组在调用期间由pybind11持有引用，释放GIL后指针仍然有效
+    m.def(
+        "sum",
+        [](const Array& array) {
+            BufferBridge::requireMainInterpreter();
+            const double*          data = array.data();
+            const size_t           size = static_cast<size_t>(array.size());
+            py::gil_scoped_release release;
+            return sum(data, size);
+        },
+        py::arg("array").noconvert(),
+        "Sum the elements of a float64 array");
+
+    m.def(
+        "minmax",
+        [](const Array& array) {
+            BufferBridge::requireMainInterpreter();
+            if (array.size() == 0) {
+                throw py::value_error("minmax() of an empty array");
+            }
+            const double* data    = array.data();
+            const size_t  size    = static_cast<size_t>(array.size());
+            double        minimum = 0.0;
+            double        maximum = 0.0;
+            {
+                py::gil_scoped_release release;
+                minMax(data, size, &minimum, &maximum);
+            }
+            return py::make_tuple(minimum, maximum);
+        },
+        py::arg("array").noconvert(),
+        "Return (min, max) of a float64 array");
+
+    m.def(
+        "dot",
+        [](const Array& a, const Array& b) {
+            BufferBridge::requireMainInterpreter();
+            if (a.size() != b.size()) {
+                throw py::value_error("dot() arrays must have the same size");
+            }
+            const double*          left  = a.data();
+            const double*          right = b.data();
+            const size_t           size  = static_cast<size_t>(a.size());
+            py::gil_scoped_release release;
+            return dot(left, right, size);
+        },
+        py::arg("a").noconvert(),
+        py::arg("b").noconvert(),
+        "Dot product of two float64 arrays");
+
+    m.def(
+        "scale",
+        [](Array& array, double factor) {
+            BufferBridge::requireMainInterpreter();
+            double*                data = array.mutable_data();
+            const size_t           size = static_cast<size_t>(array.size());
+            py::gil_scoped_release release;
+            scale(data, size, factor);
+        },
+        py::arg("array").noconvert(),
+        py::arg("factor"),
+        "Multiply a writable float64 array by factor in place");
+
+    m.def(
+        "axpy",
+        [](double alpha, const Array& x, Array& y) {
+            BufferBridge::requireMainInterpreter();
+            if (x.size() != y.size()) {
+                throw py::value_error("axpy() arrays must have the same size");
+            }
+            const double*          input  = x.data();
+            double*                output = y.mutable_data();
+            const size_t           size   = static_cast<size_t>(x.size());
+            py::gil_scoped_release release;
+            axpy(alpha, input, output, size);
+        },
+        py::arg("alpha"),
+        py::arg("x").noconvert(),
+        py::arg("y").noconvert(),
+        "Compute y += alpha * x in place");
+
+    m.def(
+        "str_lengths",
+        [](py::object strings) {
+            BufferBridge::requireMainInterpreter();
+
+            // NumPy的定宽字符串数组：释放GIL后按块扫描末尾的0
+            if (py::isinstance<py::array>(strings)) {
+                py::array  array = py::reinterpret_borrow<py::array>(strings);
+                const char kind  = array.dtype().kind();
+                if ((kind != 'S' && kind != 'U') || !(array.flags() & py::array::c_style)) {
+                    throw py::type_error("str_lengths() expects a C-contiguous bytes (S) or str (U) array");
+                }
+
+                py::array_t<int64_t> lengths(array.size());
+                const char*          data      = static_cast<const char*>(array.data());
+                const size_t         count     = static_cast<size_t>(array.size());
+                const size_t         itemBytes = static_cast<size_t>(array.itemsize());
+                int64_t*             output    = lengths.mutable_data();
+                {
+                    py::gil_scoped_release release;
+                    fixedStringLengths(data, count, itemBytes, kind == 'U' ? 4 : 1, output);
+                }
+                return lengths;
+            }
+
+            // str或bytes的序列：长度保存在对象头中，逐个读取即可，不需要转换编码
+            py::sequence         sequence = strings.cast<py::sequence>();
+            const py::ssize_t    count    = static_cast<py::ssize_t>(sequence.size());
+            py::array_t<int64_t> lengths(count);
+            int64_t*             output = lengths.mutable_data();
+            for (py::ssize_t i = 0; i < count; ++i) {
+                py::object item = sequence[i];
+                if (PyUnicode_Check(item.ptr())) {
+                    output[i] = PyUnicode_GET_LENGTH(item.ptr());
+                }
+                else if (PyBytes_Check(item.ptr())) {
+                    output[i] = PyBytes_GET_SIZE(item.ptr());
+                }
+                else {
+                    throw py::type_error("str_lengths() items must be str or bytes");
+                }
+            }
+            return lengths;
+        },
+        py::arg("strings"),
+        "Lengths of every string in a sequence or a fixed-width NumPy string array");
+
+    m.def("kernel_isa", []() { return isaName(activeIsa()); });
+
+    m.def(
+        "set_kernel_isa",
+        [](const std::string& name) {
+            for (Isa isa : {Scalar, Neon, Avx2, Avx512}) {
+                if (name == isaName(isa)) {
+                    return isaName(setIsa(isa));
+                }
+            }
+            throw py::value_error("unknown instruction set: " + name);
+        },
+        py::arg("name"),
+        "Select the kernel implementation; unsupported choices fall back to the best available");
+}
+
+}   // namespace BatchKernels
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/**
+ * @brief cpp_module中的批量计算内核
+ *
+ * 一次调用处理整个数组，避免在Python循环中逐个调用C++函数的开销。
+ * 每个内核有标量、AVX2、AVX-512（x86）和NEON（AArch64）实现，
+ * 首次调用时按CPU和操作系统支持的指令集选择最快的一种。
+ * 从Python调用时运行期间释放GIL。
+ *
+ * 归约结果与逐个累加的顺序不同，浮点舍入可能与NumPy有末位差异；
+ * 数组含NaN时min/max的结果未定义。
+ */
+namespace BatchKernels {
+
+/**
+ * @brief 指令集
+ */
+enum Isa
+{
+    Scalar,
+    Neon,
+    Avx2,
+    Avx512
+};
+
+/**
+ * @brief 当前使用的指令集
+ * @return Isa 指令集
+ */
+Isa activeIsa();
+
+/**
+ * @brief CPU和操作系统支持的最快指令集
+ * @return Isa 指令集
+ */
+Isa bestIsa();
+
+/**
+ * @brief 指定使用的指令集（用于对比各实现，超出支持范围时降为bestIsa()）
+ * @param isa 指令集
+ * @return Isa 实际使用的指令集
+ */
+Isa setIsa(Isa isa);
+
+/**
+ * @brief 指令集名称
+ * @param isa 指令集
+ * @return const char* "scalar"、"neon"、"avx2"或"avx512"
+ */
+const char* isaName(Isa isa);
+
+/**
+ * @brief 求和
+ * @param data 数据
+ * @param size 元素个数
+ * @return double 和
+ */
+double sum(const double* data, size_t size);
+
+/**
+ * @brief 最小值和最大值（size为0时不修改输出）
+ * @param data 数据
+ * @param size 元素个数
+ * @param minimum 输出最小值
+ * @param maximum 输出最大值
+ */
+void minMax(const double* data, size_t size, double* minimum, double* maximum);
+
+/**
+ * @brief 点积
+ * @param a 第一个数组
+ * @param b 第二个数组
+ * @param size 元素个数
+ * @return double 点积
+ */
+double dot(const double* a, const double* b, size_t size);
+
+/**
+ * @brief 原地乘以常数：data[i] *= factor
+ * @param data 数据
+ * @param size 元素个数
+ * @param factor 系数
+ */
+void scale(double* data, size_t size, double factor);
+
+/**
+ * @brief 原地累加：y[i] += alpha * x[i]
+ * @param alpha 系数
+ * @param x 输入
+ * @param y 输入输出
+ * @param size 元素个数
+ */
+void axpy(double alpha, const double* x, double* y, size_t size);
+
+/**
+ * @brief 定宽字符串数组中每个字符串的长度（NumPy的S和U类型，末尾以0填充）
+ *
+ * 长度为最后一个非0单元之后的位置，与NumPy去掉末尾0的规则一致。
+ * @param data 数据
+ * @param count 字符串个数
+ * @param itemBytes 每个字符串占用的字节数
+ * @param unitBytes 每个字符的字节数（S为1，U为4）
+ * @param lengths 输出长度（字符数）
+ */
+void fixedStringLengths(const char* data, size_t count, size_t itemBytes, size_t unitBytes, int64_t* lengths);
+
+/**
+ * @brief 在cpp_module中注册批量内核
+ * @param m 模块对象
+ */
+void bind(py::module_& m);
+
+}   // namespace BatchKernels
@@ -0,0 +1,264 @@
+#include "BatchRunner.h"
+#include "ConfigManager.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstdio>
+
+const char* const BatchRunner::kBatchArgument = "--batch";
+
+// 每个执行进程最多预先排队的任务数，脚本按需读取，不一次载入全部文件
+static const int kQueuedPerWorker = 2;
+
+// 标准输出和标准错误按UTF-8整块写出，多个脚本的输出不会交错
+static void writeText(FILE* stream, const QString& text)
+{
+    const QByteArray bytes = text.toUtf8();
+    fwrite(bytes.constData(), 1, static_cast<size_t>(bytes.size()), stream);
+    fflush(stream);
+}
+
+int BatchRunner::main(const QStringList& arguments)
+{
+    BatchRunner runner;
+    QString     error;
+    if (!runner.parseArguments(arguments, &error)) {
+        writeText(stderr, error + "\n");
+        printUsage();
+        return 2;
+    }
+    return runner.exec();
+}
+
+BatchRunner::BatchRunner(QObject* parent)
+    : QObject(parent)
+{
+    connect(&m_pool, &ProcessPool::jobFinished, this, &BatchRunner::onJobFinished);
+}
+
+void BatchRunner::printUsage()
+{
+    writeText(stderr,
+              QString("用法: %1 %2 [--jobs N] [--output-dir 目录] [--timeout 秒] [--input 文件] 脚本或目录...\n"
+                      "  --jobs N          并行的执行进程数，默认CPU核心数\n"
+                      "  --output-dir 目录 每个脚本的输出写入 目录/相对路径.log\n"
+                      "  --timeout 秒      单个脚本的墙钟时间上限，0表示不限制，默认使用设置中的值\n"
+                      "  --input 文件      每个脚本的标准输入，- 表示本进程的标准输入，默认为空\n")
+                  .arg(QFileInfo(QCoreApplication::applicationFilePath()).fileName(), kBatchArgument));
+}
+
+bool BatchRunner::parseArguments(const QStringList& arguments, QString* error)
+{
+    QStringList paths;
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString& argument = arguments[i];
+        if (argument == kBatchArgument) {
+            continue;
+        }
+
+        const bool hasValue = i + 1 < arguments.size();
+        bool       ok       = true;
+        if (argument == "--jobs") {
+            m_jobs = hasValue ? arguments[++i].toInt(&ok) : -1;
+            if (!hasValue || !ok || m_jobs < 0) {
+                *error = "--jobs 需要一个非负整数";
+                return false;
+            }
+        }
+        else if (argument == "--timeout") {
+            m_timeoutSec = hasValue ? arguments[++i].toInt(&ok) : -1;
+            if (!hasValue || !ok || m_timeoutSec < 0) {
+                *error = "--timeout 需要一个非负整数（秒）";
+                return false;
+            }
+        }
+        else if (argument == "--output-dir") {
+            if (!hasValue) {
+                *error = "--output-dir 需要一个目录";
+                return false;
+            }
+            m_outputDir = arguments[++i];
+        }
+        else if (argument == "--input") {
+            if (!hasValue) {
+                *error = "--input 需要一个文件";
+                return false;
+            }
+            // 读取一次，每个脚本得到同样的输入
+            const QString path = arguments[++i];
+            QFile         file(path);
+            const bool    opened = path == "-" ? file.open(stdin, QIODevice::ReadOnly) : file.open(QIODevice::ReadOnly);
+            if (!opened) {
+                *error = QString("无法读取输入文件: %1").arg(path);
+                return false;
+            }
+            m_input = file.readAll();
+        }
+        else if (argument.startsWith("--")) {
+            *error = QString("未知参数: %1").arg(argument);
+            return false;
+        }
+        else {
+            paths.append(argument);
+        }
+    }
+
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            const QDir    root(info.absoluteFilePath());
+            QList<Script> found;
+            QDirIterator  it(root.absolutePath(), QStringList() << "*.py", QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                Script script;
+                script.path     = it.next();
+                script.relative = root.relativeFilePath(script.path);
+                found.append(script);
+            }
+            std::sort(found.begin(), found.end(), [](const Script& a, const Script& b) { return a.path < b.path; });
+            m_scripts.append(found);
+        }
+        else if (info.isFile()) {
+            Script script;
+            script.path     = info.absoluteFilePath();
+            script.relative = info.fileName();
+            m_scripts.append(script);
+        }
+        else {
+            *error = QString("找不到脚本或目录: %1").arg(path);
+            return false;
+        }
+    }
+
+    if (m_scripts.isEmpty()) {
+        *error = "没有要运行的脚本";
+        return false;
+    }
+    return true;
+}
+
+int BatchRunner::exec()
+{
+    if (!m_outputDir.isEmpty() && !QDir().mkpath(m_outputDir)) {
+        writeText(stderr, QString("无法创建输出目录: %1\n").arg(m_outputDir));
+        return 2;
+    }
+
+    const ConfigManager& config = ConfigManager::instance();
+    RunWatchdog::Budgets budgets;
+    budgets.wallMs   = (m_timeoutSec >= 0 ? m_timeoutSec : config.getWallTimeLimit()) * 1000LL;
+    budgets.cpuMs    = config.getCpuTimeLimit() * 1000LL;
+    budgets.memoryMB = config.getMemoryLimit();
+    m_pool.setBudgets(budgets);
+
+    m_elapsed.start();
+    if (!m_pool.start(m_jobs)) {
+        writeText(stderr, "执行进程启动失败\n");
+        return 2;
+    }
+
+    submitMore();
+    m_pool.waitForDone();
+
+    // 关闭执行进程前取统计，关闭后工作者数为0
+    const ProcessPool::Metrics metrics = m_pool.metrics();
+    m_pool.shutdown();
+
+    QString summary = QString("\n共 %1 个脚本：%2 个成功，%3 个失败，用时 %4 秒，%5 个执行进程，利用率 %6%\n")
+                          .arg(m_scripts.size())
+                          .arg(m_passed)
+                          .arg(m_failed.size())
+                          .arg(m_elapsed.elapsed() / 1000.0, 0, 'f', 2)
+                          .arg(metrics.workers)
+                          .arg(metrics.utilisation * 100.0, 0, 'f', 1);
+    for (const QString& failed : m_failed) {
+        summary += QString("  失败: %1\n").arg(failed);
+    }
+    writeText(stderr, summary);
+
+    return m_failed.isEmpty() ? 0 : 1;
+}
+
+void BatchRunner::submitMore()
+{
+    const int limit = m_pool.workerCount() * kQueuedPerWorker;
+    while (m_pending.size() < limit && m_nextScript < m_scripts.size()) {
+        const int     index  = m_nextScript++;
+        const Script& script = m_scripts[index];
+
+        QFile file(script.path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            report(script, true, 0, QString("无法读取脚本: %1\n").arg(file.errorString()));
+            continue;
+        }
+
+        const std::shared_ptr<ProcessPool::Job> job = m_pool.submit(QString::fromUtf8(file.readAll()), m_input);
+        if (!job) {
+            report(script, true, 0, "执行进程不可用\n");
+            continue;
+        }
+        m_pending.insert(job->id, std::make_pair(index, job));
+    }
+}
+
+void BatchRunner::onJobFinished(int jobId, bool failed)
+{
+    // 运行器在事件循环中才开始任务，submit()返回前不会有任务结束
+    const auto it = m_pending.find(jobId);
+    if (it == m_pending.end()) {
+        return;
+    }
+    const Script                            script = m_scripts[it.value().first];
+    const std::shared_ptr<ProcessPool::Job> job    = it.value().second;
+    m_pending.erase(it);
+
+    QString text = job->output;
+    if (!job->error.isEmpty()) {
+        if (!text.isEmpty() && !text.endsWith('\n')) {
+            text += '\n';
+        }
+        text += job->error;
+        if (!text.endsWith('\n')) {
+            text += '\n';
+        }
+    }
+    report(script, failed, job->summary.elapsedNs / 1000000, text);
+
+    submitMore();
+}
+
+void BatchRunner::report(const Script& script, bool failed, qint64 elapsedMs, const QString& text)
+{
+    if (failed) {
+        m_failed.append(script.path);
+    }
+    else {
+        ++m_passed;
+    }
+
+    const QString status = QString("%1 (%2 %3 ms)").arg(script.relative, failed ? "FAIL" : "PASS").arg(elapsedMs);
+    if (m_outputDir.isEmpty()) {
+        QString block = QString("===== %1 =====\n").arg(status) + text;
+        if (!block.endsWith('\n')) {
+            block += '\n';
+        }
+        writeText(stdout, block);
+        return;
+    }
+
+    const QString   logPath = QDir(m_outputDir).filePath(script.relative + ".log");
+    QFile           log(logPath);
+    const QFileInfo logInfo(logPath);
+    if (!QDir().mkpath(logInfo.absolutePath()) || !log.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        writeText(stderr, QString("无法写入 %1: %2\n").arg(logPath, log.errorString()));
+    }
+    else {
+        log.write(text.toUtf8());
+    }
+    writeText(stdout, status + "\n");
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ProcessPool.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <utility>
+
+/**
+ * @class BatchRunner
+ * @brief 无界面的批量运行模式
+ *
+ * 以 --batch [--jobs N] [--output-dir 目录] [--timeout 秒] [--input 文件] 路径... 启动时，进程不创建任何窗口：
+ * - 路径可以是脚本或目录，目录递归展开为其中的 *.py，按路径排序
+ * - 脚本交给ProcessPool，在N个执行进程中并行运行（默认CPU核心数），与界面使用同样的嵌入和cpp_module
+ * - 每个脚本的标准输入是 --input 指定的文件内容（- 表示本进程的标准输入），读完后input()抛出EOFError
+ * - 每个脚本结束时把输出整块写到标准输出；指定输出目录时写入 目录/相对路径.log，标准输出只打印状态行
+ * - 结束后在标准错误打印汇总；全部成功返回0，有脚本失败返回1，参数错误或执行进程无法启动返回2
+ */
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 以批量模式启动时的命令行参数
+    static const char* const kBatchArgument;
+
+    /**
+     * @brief 批量模式入口（需要已创建QCoreApplication）
+     * @param arguments 完整的命令行参数
+     * @return int 进程退出码
+     */
+    static int main(const QStringList& arguments);
+
+private:
+    // 一个待运行的脚本
+    struct Script
+    {
+        QString path;        // 绝对路径
+        QString relative;    // 相对于所在参数目录的路径，用于显示和输出文件名
+    };
+
+    explicit BatchRunner(QObject* parent = nullptr);
+
+    /**
+     * @brief 解析命令行参数并展开脚本列表
+     * @param arguments 完整的命令行参数
+     * @param error 失败时输出原因
+     * @return bool 成功返回true
+     */
+    bool parseArguments(const QStringList& arguments, QString* error);
+
+    /**
+     * @brief 启动进程池并运行所有脚本
+     * @return int 进程退出码
+     */
+    int exec();
+
+    /**
+     * @brief 提交脚本直到在途任务数达到上限
+     */
+    void submitMore();
+
+    /**
+     * @brief 任务结束处理：输出结果并补充任务
+     * @param jobId 任务编号
+     * @param failed 是否失败
+     */
+    void onJobFinished(int jobId, bool failed);
+
+    /**
+     * @brief 输出一个脚本的结果并计入汇总
+     * @param script 脚本
+     * @param failed 是否失败
+     * @param elapsedMs 运行毫秒数
+     * @param text 输出和错误信息
+     */
+    void report(const Script& script, bool failed, qint64 elapsedMs, const QString& text);
+
+    /**
+     * @brief 打印使用说明
+     */
+    static void printUsage();
+
+private:
+    ProcessPool   m_pool;
+    int           m_jobs       = 0;    // 执行进程数，0表示CPU核心数
+    int           m_timeoutSec = -1;   // 单个脚本的墙钟时间上限，-1表示使用设置中的值
+    QString       m_outputDir;
+    QByteArray    m_input;             // 每个脚本的标准输入
+    QList<Script> m_scripts;
+    int           m_nextScript = 0;
+
+    QHash<int, std::pair<int, std::shared_ptr<ProcessPool::Job>>> m_pending;   // 任务编号 -> 脚本序号和任务
+    QStringList                                                  m_failed;
+    int                                                          m_passed = 0;
+    QElapsedTimer                                                m_elapsed;
+};
@@ -0,0 +1,537 @@
+#include "BreakpointTable.h"
+#include "PythonLexer.h"
+
+#include <frameobject.h>
+
+// 条件表达式编译时使用的文件名，出现在错误信息中
+static const char* const kConditionFileName = "<breakpoint condition>";
+
+// 在栈帧的全局和局部变量上求值代码对象，返回新引用，出错时返回nullptr并设置异常
+static PyObject* evalInFrame(PyObject* code, PyFrameObject* frame)
+{
+#if PY_VERSION_HEX >= 0x030B0000
+    PyObject* globals = PyFrame_GetGlobals(frame);
+    PyObject* locals  = PyFrame_GetLocals(frame);
+#else
+    if (PyFrame_FastToLocalsWithError(frame) < 0) {
+        return nullptr;
+    }
+    PyObject* globals = frame->f_globals;
+    PyObject* locals  = frame->f_locals;
+    Py_XINCREF(globals);
+    Py_XINCREF(locals);
+#endif
+
+    PyObject* result = nullptr;
+    if (globals) {
+        result = PyEval_EvalCode(code, globals, locals ? locals : globals);
+    }
+    Py_XDECREF(globals);
+    Py_XDECREF(locals);
+    return result;
+}
+
+// 只能出现在语句中、不能出现在表达式中的关键字
+static bool isStatementKeyword(const QStringRef& word)
+{
+    static const char* const kStatementKeywords[] = {"as", "assert", "break", "class", "continue", "def", "del",
+                                                      "elif", "except", "finally", "from", "global", "import",
+                                                      "nonlocal", "pass", "raise", "return", "try", "while",
+                                                      "with", "yield"};
+    for (const char* keyword : kStatementKeywords) {
+        if (word == QLatin1String(keyword)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 词法分析得到的单行字符串记号（可能带前缀）是否以未转义的引号结束；
+// 未结束的单引号字符串被词法分析器截止到行尾
+static bool isClosedString(const QStringRef& token)
+{
+    int quoteAt = 0;
+    while (quoteAt < token.size() && token.at(quoteAt) != '\'' && token.at(quoteAt) != '"') {
+        ++quoteAt;
+    }
+    const bool triple = quoteAt + 2 < token.size() && token.at(quoteAt + 1) == token.at(quoteAt) &&
+                        token.at(quoteAt + 2) == token.at(quoteAt);
+    const int  quotes = triple ? 3 : 1;
+    if (token.size() < quoteAt + 2 * quotes || token.at(token.size() - 1) != token.at(quoteAt)) {
+        return false;
+    }
+    // 结束引号前连续的反斜杠为奇数个时引号被转义
+    int backslashes = 0;
+    for (int i = token.size() - quotes - 1; i > quoteAt && token.at(i) == '\\'; --i) {
+        ++backslashes;
+    }
+    return backslashes % 2 == 0;
+}
+
+// 对象的str()结果（UTF-8），出错时为错误信息
+static QByteArray pythonText(PyObject* value)
+{
+    PyObject* text = PyObject_Str(value);
+    if (text) {
+        Py_ssize_t  size = 0;
+        const char* utf8 = PyUnicode_AsUTF8AndSize(text, &size);
+        if (utf8) {
+            QByteArray result(utf8, static_cast<int>(size));
+            Py_DECREF(text);
+            return result;
+        }
+        Py_DECREF(text);
+    }
+    PyErr_Clear();
+    return "<str() failed>";
+}
+
+BreakpointTable::BreakpointTable(const QVector<Breakpoint>& breakpoints)
+{
+    int maxLine = -1;
+    for (const Breakpoint& breakpoint : breakpoints) {
+        maxLine = qMax(maxLine, breakpoint.line);
+    }
+    const size_t words = static_cast<size_t>(maxLine + 64) / 64;
+    m_lines.assign(words, 0);
+    m_conditionalLines.assign(words, 0);
+
+    for (const Breakpoint& breakpoint : breakpoints) {
+        const int line = breakpoint.line;
+        if (line < 0) {
+            continue;
+        }
+        const quint64 bit = quint64(1) << (line & 63);
+        m_lines[line >> 6] |= bit;
+
+        // 同一行先设条件后设普通断点时，以最后一个为准
+        if (!breakpoint.isConditional() && !breakpoint.isLogpoint()) {
+            m_conditionalLines[line >> 6] &= ~bit;
+            m_entries.remove(line);
+            continue;
+        }
+
+        Entry entry;
+        if (!parseHitCondition(breakpoint.hitCondition, &entry.hitOperator, &entry.hitValue)) {
+            // 格式错误的命中次数按每次命中处理（编辑器中已校验过）
+            entry.hitOperator = AnyHit;
+            entry.hitValue    = 0;
+        }
+        entry.condition = breakpoint.condition.trimmed().toUtf8();
+
+        if (breakpoint.isLogpoint()) {
+            QStringList literals;
+            QStringList expressions;
+            entry.logpoint   = true;
+            entry.logMessage = breakpoint.logMessage.toUtf8();
+            if (parseLogMessage(breakpoint.logMessage, &literals, &expressions)) {
+                for (const QString& literal : literals) {
+                    entry.logLiterals.append(literal.toUtf8());
+                }
+                if (!expressions.isEmpty()) {
+                    entry.logSource = ("(" + expressions.join(", ") + ",)").toUtf8();
+                }
+            }
+            else {
+                // 括号不配对的消息原样输出（编辑器中已校验过）
+                entry.logLiterals.append(entry.logMessage);
+            }
+        }
+
+        m_conditionalLines[line >> 6] |= bit;
+        m_entries.insert(line, entry);
+    }
+}
+
+BreakpointTable::~BreakpointTable()
+{
+    if (!m_hasCode) {
+        return;
+    }
+
+    // 解释器已经关闭时代码对象随之失效，不能再减引用
+    if (!Py_IsInitialized()) {
+        return;
+    }
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    for (const Entry& entry : qAsConst(m_entries)) {
+        Py_XDECREF(entry.code);
+        Py_XDECREF(entry.logCode);
+    }
+    PyGILState_Release(gstate);
+}
+
+bool BreakpointTable::containsRange(int first, int last) const
+{
+    first = qMax(first, 0);
+    if (last < first || m_lines.empty()) {
+        return false;
+    }
+
+    const size_t firstWord = static_cast<size_t>(first) >> 6;
+    const size_t lastWord  = static_cast<size_t>(last) >> 6;
+    const size_t endWord   = qMin(lastWord + 1, m_lines.size());
+    for (size_t index = firstWord; index < endWord; ++index) {
+        quint64 bits = m_lines[index];
+        if (index == firstWord) {
+            bits &= ~quint64(0) << (first & 63);
+        }
+        if (index == lastWord) {
+            bits &= ~quint64(0) >> (63 - (last & 63));
+        }
+        if (bits) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BreakpointTable::Action
+BreakpointTable::evaluate(int line, PyFrameObject* frame, QString* error, QByteArray* log) const
+{
+    if (!testBit(m_lines, line)) {
+        return Continue;
+    }
+    // 普通断点不查哈希表
+    if (!testBit(m_conditionalLines, line)) {
+        return Pause;
+    }
+    const Entry& entry = m_entries.constFind(line).value();
+
+    // 命中次数在C++中判断，不满足时不执行条件表达式
+    const qint64 hits = ++entry.hits;
+    switch (entry.hitOperator) {
+    case AnyHit:
+        break;
+    case EqualHit:
+        if (hits != entry.hitValue) {
+            return Continue;
+        }
+        break;
+    case AtLeastHit:
+        if (hits < entry.hitValue) {
+            return Continue;
+        }
+        break;
+    case GreaterHit:
+        if (hits <= entry.hitValue) {
+            return Continue;
+        }
+        break;
+    case MultipleHit:
+        if (hits % entry.hitValue != 0) {
+            return Continue;
+        }
+        break;
+    }
+
+    const int truth = evaluateCondition(entry, frame, error);
+    if (truth == 0) {
+        return Continue;
+    }
+    if (truth < 0 && entry.logpoint) {
+        // 日志点不打断运行，错误作为这一次的日志消息，与正常输出一样可以丢弃
+        *log = "<" + error->toUtf8() + ">";
+        error->clear();
+        return Log;
+    }
+    if (truth < 0) {
+        return Pause;
+    }
+    if (!entry.logpoint) {
+        return Pause;
+    }
+    *log = formatLog(entry, frame, error);
+    return Log;
+}
+
+void BreakpointTable::resetHits() const
+{
+    for (const Entry& entry : qAsConst(m_entries)) {
+        entry.hits = 0;
+    }
+}
+
+bool BreakpointTable::isValidHitCondition(const QString& hitCondition)
+{
+    HitOperator op;
+    qint64      value;
+    return parseHitCondition(hitCondition, &op, &value);
+}
+
+QString BreakpointTable::checkCondition(const QString& condition)
+{
+    const QString source = condition.trimmed();
+    if (source.isEmpty()) {
+        return QString();
+    }
+
+    QVector<PythonLexer::Token> tokens;
+    const int state = PythonLexer::lexLine(source, PythonLexer::kInitialState, &tokens);
+    if (PythonLexer::isInString(state)) {
+        return "字符串没有结束";
+    }
+
+    QString closers;              // 尚未闭合的括号对应的右括号
+    bool    lambda     = false;   // 最外层出现过lambda，之后的=是参数默认值
+    int     tokenIndex = 0;
+    for (int i = 0; i < source.size();) {
+        if (tokenIndex < tokens.size() && tokens[tokenIndex].start == i) {
+            const PythonLexer::Token& token = tokens[tokenIndex++];
+            const QStringRef          text  = source.midRef(token.start, token.length);
+            if (token.kind == PythonLexer::String && !isClosedString(text)) {
+                return "字符串没有结束";
+            }
+            if (token.kind == PythonLexer::Keyword) {
+                if (isStatementKeyword(text)) {
+                    return QString("表达式中不能使用%1").arg(text.toString());
+                }
+                lambda = lambda || (closers.isEmpty() && text == QLatin1String("lambda"));
+            }
+            i = token.start + token.length;
+            continue;
+        }
+
+        const QChar ch = source.at(i);
+        if (ch == '(' || ch == '[' || ch == '{') {
+            closers.append(ch == '(' ? ')' : (ch == '[' ? ']' : '}'));
+        }
+        else if (ch == ')' || ch == ']' || ch == '}') {
+            if (!closers.endsWith(ch)) {
+                return QString("括号%1不配对").arg(ch);
+            }
+            closers.chop(1);
+        }
+        else if (ch == ';' && closers.isEmpty()) {
+            return "条件只能是一个表达式";
+        }
+        else if (ch == '\\') {
+            return "条件只能写在一行";
+        }
+        else if (ch == '=' && closers.isEmpty() && !lambda) {
+            // 排除==、!=、<=、>=和:=，剩下的是赋值（多半想写==）
+            const QChar previous = i > 0 ? source.at(i - 1) : QChar();
+            const QChar next     = i + 1 < source.size() ? source.at(i + 1) : QChar();
+            if (next == '=') {
+                ++i;
+            }
+            else if (previous != '=' && previous != '!' && previous != '<' && previous != '>' &&
+                     previous != ':') {
+                return "表达式中不能赋值（比较请用==）";
+            }
+        }
+        ++i;
+    }
+    if (!closers.isEmpty()) {
+        return "括号没有闭合";
+    }
+    return QString();
+}
+
+bool BreakpointTable::parseHitCondition(const QString& text, HitOperator* op, qint64* value)
+{
+    QString trimmed = text.trimmed();
+    *op    = AnyHit;
+    *value = 0;
+    if (trimmed.isEmpty()) {
+        return true;
+    }
+
+    HitOperator parsed = EqualHit;
+    if (trimmed.startsWith(">=")) {
+        parsed  = AtLeastHit;
+        trimmed = trimmed.mid(2);
+    }
+    else if (trimmed.startsWith("==")) {
+        trimmed = trimmed.mid(2);
+    }
+    else if (trimmed.startsWith('>')) {
+        parsed  = GreaterHit;
+        trimmed = trimmed.mid(1);
+    }
+    else if (trimmed.startsWith('%')) {
+        parsed  = MultipleHit;
+        trimmed = trimmed.mid(1);
+    }
+
+    bool         ok    = false;
+    const qint64 count = trimmed.trimmed().toLongLong(&ok);
+    // >0表示第1次以后，允许为0；其余方式次数至少为1
+    if (!ok || count < 0 || (count == 0 && parsed != GreaterHit)) {
+        return false;
+    }
+
+    *op    = parsed;
+    *value = count;
+    return true;
+}
+
+QString BreakpointTable::takeErrorMessage()
+{
+    PyObject* type      = nullptr;
+    PyObject* value     = nullptr;
+    PyObject* traceback = nullptr;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+
+    QString message;
+    if (type) {
+        message = QString::fromUtf8(reinterpret_cast<PyTypeObject*>(type)->tp_name);
+    }
+    if (value) {
+        PyObject* text = PyObject_Str(value);
+        if (text) {
+            const char* utf8 = PyUnicode_AsUTF8(text);
+            if (utf8 && *utf8) {
+                message += QString(": ") + QString::fromUtf8(utf8);
+            }
+            Py_DECREF(text);
+        }
+    }
+    PyErr_Clear();
+
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(traceback);
+    return message;
+}
+
+bool BreakpointTable::parseLogMessage(const QString& message,
+                                      QStringList*   literals,
+                                      QStringList*   expressions)
+{
+    literals->clear();
+    expressions->clear();
+
+    QString literal;
+    int     i = 0;
+    while (i < message.size()) {
+        const QChar ch = message.at(i);
+        if (ch == '{' && i + 1 < message.size() && message.at(i + 1) == '{') {
+            literal += '{';
+            i += 2;
+        }
+        else if (ch == '}' && i + 1 < message.size() && message.at(i + 1) == '}') {
+            literal += '}';
+            i += 2;
+        }
+        else if (ch == '{') {
+            // 表达式中可以有嵌套的括号（字典、集合字面量等）
+            int depth = 1;
+            int end   = i + 1;
+            while (end < message.size() && depth > 0) {
+                if (message.at(end) == '{') {
+                    ++depth;
+                }
+                else if (message.at(end) == '}') {
+                    --depth;
+                }
+                ++end;
+            }
+            const QString expression = message.mid(i + 1, end - i - 2).trimmed();
+            if (depth != 0 || expression.isEmpty()) {
+                return false;
+            }
+            literals->append(literal);
+            expressions->append(expression);
+            literal.clear();
+            i = end;
+        }
+        else if (ch == '}') {
+            return false;
+        }
+        else {
+            literal += ch;
+            ++i;
+        }
+    }
+    literals->append(literal);
+    return true;
+}
+
+QString BreakpointTable::checkLogMessage(const QString& message)
+{
+    QStringList literals;
+    QStringList expressions;
+    if (!parseLogMessage(message, &literals, &expressions)) {
+        return "花括号不配对（文本中的花括号写作{{和}}）";
+    }
+    for (const QString& expression : qAsConst(expressions)) {
+        const QString error = checkCondition(expression);
+        if (!error.isEmpty()) {
+            return QString("{%1}: %2").arg(expression, error);
+        }
+    }
+    return QString();
+}
+
+int BreakpointTable::evaluateCondition(const Entry& entry, PyFrameObject* frame, QString* error) const
+{
+    if (entry.condition.isEmpty() || entry.compileFailed || !frame) {
+        return 1;
+    }
+
+    // 条件只编译一次，之后复用代码对象
+    if (!entry.code) {
+        entry.code = Py_CompileString(entry.condition.constData(), kConditionFileName, Py_eval_input);
+        if (!entry.code) {
+            entry.compileFailed = true;
+            *error              = takeErrorMessage();
+            return 1;
+        }
+        m_hasCode = true;
+    }
+
+    PyObject* result = evalInFrame(entry.code, frame);
+    int       truth  = -1;
+    if (result) {
+        truth = PyObject_IsTrue(result);
+        Py_DECREF(result);
+    }
+    if (truth < 0) {
+        *error = takeErrorMessage();
+    }
+    return truth;
+}
+
+QByteArray BreakpointTable::formatLog(const Entry& entry, PyFrameObject* frame, QString* error) const
+{
+    if (entry.logSource.isEmpty()) {
+        return entry.logLiterals.value(0);
+    }
+
+    if (!entry.logCode && !entry.logCompileFailed) {
+        entry.logCode = Py_CompileString(entry.logSource.constData(), kConditionFileName, Py_eval_input);
+        if (!entry.logCode) {
+            entry.logCompileFailed = true;
+            *error                 = takeErrorMessage();
+        }
+        else {
+            m_hasCode = true;
+        }
+    }
+    if (entry.logCompileFailed || !frame) {
+        return entry.logMessage;
+    }
+
+    // 所有表达式一次求值；出错时每个位置都显示错误信息
+    PyObject*  values = evalInFrame(entry.logCode, frame);
+    QByteArray failure;
+    if (!values) {
+        failure = "<" + takeErrorMessage().toUtf8() + ">";
+    }
+
+    QByteArray text = entry.logLiterals.value(0);
+    for (int i = 1; i < entry.logLiterals.size(); ++i) {
+        if (values && i - 1 < PyTuple_GET_SIZE(values)) {
+            text += pythonText(PyTuple_GET_ITEM(values, i - 1));
+        }
+        else {
+            text += failure;
+        }
+        text += entry.logLiterals.at(i);
+    }
+    Py_XDECREF(values);
+    return text;
+}
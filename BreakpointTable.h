@@ -0,0 +1,235 @@
+#pragma once
+
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <vector>
+
+#include <Python.h>
+
+/**
+ * @struct Breakpoint
+ * @brief 编辑器中设置的一个断点
+ */
+struct Breakpoint
+{
+    int     line = 0;       // 行号（从1开始）
+    QString condition;      // 暂停条件（Python表达式），为空时无条件
+    QString hitCondition;   // 命中次数条件：5或==5（第5次）、>=5、>5、%5（每5次），为空时每次
+    QString logMessage;     // 日志消息，非空时为日志点：输出消息而不暂停，{表达式}替换为求值结果
+
+    /**
+     * @brief 是否带有条件或命中次数
+     * @return bool 普通断点返回false
+     */
+    bool isConditional() const
+    {
+        return !condition.trimmed().isEmpty() || !hitCondition.trimmed().isEmpty();
+    }
+
+    /**
+     * @brief 是否为日志点
+     * @return bool 设置了日志消息返回true
+     */
+    bool isLogpoint() const { return !logMessage.trimmed().isEmpty(); }
+};
+
+Q_DECLARE_METATYPE(Breakpoint)
+
+/**
+ * @class BreakpointTable
+ * @brief 运行线程使用的不可变断点表
+ *
+ * 断点集合在构造后不再改变，由CodeRunner通过原子指针整体替换。
+ * 行号用位图索引，追踪钩子查表只是一次位测试，与断点数量无关（整个函数每行一个断点也不额外增加开销）；
+ * 普通断点只占位图中的一位，只有条件断点另外保存命中计数和条件。条件断点的判断分两步：
+ * - 命中次数在C++中计数和比较，次数不满足时不执行任何Python代码
+ * - 条件表达式第一次用到时编译成代码对象并缓存，之后每次只在栈帧的全局和局部变量上求值
+ *
+ * 条件的编译错误只报告一次，之后该断点按无条件处理；求值时的异常每次报告并暂停，
+ * 便于检查出错时的变量。命中次数在每次运行开始时清零。
+ *
+ * 日志点在满足命中次数和条件后不暂停，而是输出日志消息：消息中的{表达式}合成一个元组
+ * 预先编译，每次命中只求值一次再与文本拼接；表达式或条件出错时错误信息代替值出现在消息中，
+ * 不写入标准错误，也不暂停。
+ *
+ * contains()可在任意线程调用；evaluate()和resetHits()只在运行线程中调用，需持有GIL。
+ */
+class BreakpointTable
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param breakpoints 断点列表，同一行只保留最后一个
+     */
+    explicit BreakpointTable(const QVector<Breakpoint>& breakpoints);
+
+    /**
+     * @brief 析构函数（释放已编译的条件，需要时获取GIL）
+     */
+    ~BreakpointTable();
+
+    BreakpointTable(const BreakpointTable&)            = delete;
+    BreakpointTable& operator=(const BreakpointTable&) = delete;
+
+    /**
+     * @brief 判断某行是否设置了断点
+     * @param line 行号
+     * @return bool 设置了断点返回true
+     */
+    bool contains(int line) const { return testBit(m_lines, line); }
+
+    /**
+     * @brief 判断行号范围内是否设置了断点（按64位字比较，与范围长度和断点数量基本无关）
+     * @param first 第一行
+     * @param last 最后一行（含）
+     * @return bool 范围内有断点返回true
+     */
+    bool containsRange(int first, int last) const;
+
+    /**
+     * @brief 执行到断点行时的处理
+     */
+    enum Action
+    {
+        Continue = 0,   // 继续运行
+        Pause,          // 暂停
+        Log             // 输出日志消息后继续运行
+    };
+
+    /**
+     * @brief 执行到断点行时判断如何处理
+     * @param line 行号
+     * @param frame 当前栈帧，条件和日志消息在其变量上求值
+     * @param error 条件出错时写入错误信息
+     * @param log 返回Log时写入日志消息（UTF-8）
+     * @return Action 处理方式
+     */
+    Action evaluate(int line, PyFrameObject* frame, QString* error, QByteArray* log) const;
+
+    /**
+     * @brief 清零所有断点的命中次数
+     */
+    void resetHits() const;
+
+    /**
+     * @brief 检查命中次数条件的格式
+     * @param hitCondition 命中次数条件
+     * @return bool 为空或格式正确返回true
+     */
+    static bool isValidHitCondition(const QString& hitCondition);
+
+    /**
+     * @brief 按PythonLexer的记号检查条件表达式的常见语法错误，不获取GIL
+     *
+     * 检查未结束的字符串、括号配对、语句关键字、赋值（多半想写==）和多条语句，
+     * 其余错误在运行线程第一次编译条件时报告。
+     * @param condition 条件表达式
+     * @return QString 错误信息，没有发现错误时为空
+     */
+    static QString checkCondition(const QString& condition);
+
+    /**
+     * @brief 检查日志消息的格式和其中表达式的语法（同checkCondition()，不获取GIL）
+     * @param message 日志消息
+     * @return QString 错误信息，没有发现错误时为空
+     */
+    static QString checkLogMessage(const QString& message);
+
+    /**
+     * @brief 取出当前的Python异常并格式化（持有GIL时调用，监视表达式共用）
+     * @return QString 异常类型和信息
+     */
+    static QString takeErrorMessage();
+
+private:
+    /**
+     * @brief 命中次数的比较方式
+     */
+    enum HitOperator
+    {
+        AnyHit = 0,    // 每次命中
+        EqualHit,      // 第N次
+        AtLeastHit,    // 第N次及以后
+        GreaterHit,    // 第N次以后
+        MultipleHit    // 每N次
+    };
+
+    struct Entry
+    {
+        HitOperator hitOperator = AnyHit;
+        qint64      hitValue    = 0;
+        QByteArray  condition;   // UTF-8源码，为空时无条件
+
+        // 日志点：文本段比表达式多一段，表达式合成一个元组编译
+        bool                logpoint = false;
+        QByteArray          logMessage;    // 原始消息，表达式无法编译时原样输出
+        QVector<QByteArray> logLiterals;   // 表达式之间的文本（已处理{{和}}）
+        QByteArray          logSource;     // 表达式元组的源码，消息不含表达式时为空
+
+        // 以下只在运行线程中访问
+        mutable qint64    hits             = 0;
+        mutable PyObject* code             = nullptr;   // 已编译的条件
+        mutable bool      compileFailed    = false;
+        mutable PyObject* logCode          = nullptr;   // 已编译的表达式元组
+        mutable bool      logCompileFailed = false;
+    };
+
+    /**
+     * @brief 解析命中次数条件
+     * @param text 条件文本
+     * @param op 比较方式
+     * @param value 次数
+     * @return bool 格式正确返回true
+     */
+    static bool parseHitCondition(const QString& text, HitOperator* op, qint64* value);
+
+    /**
+     * @brief 拆分日志消息
+     * @param message 日志消息
+     * @param literals 表达式之间的文本，比表达式多一段
+     * @param expressions {}中的表达式
+     * @return bool 括号配对返回true
+     */
+    static bool
+    parseLogMessage(const QString& message, QStringList* literals, QStringList* expressions);
+
+    /**
+     * @brief 求值条件
+     * @param entry 断点
+     * @param frame 当前栈帧
+     * @param error 出错时写入错误信息
+     * @return int 1为真，0为假，-1为出错
+     */
+    int evaluateCondition(const Entry& entry, PyFrameObject* frame, QString* error) const;
+
+    /**
+     * @brief 生成日志消息
+     * @param entry 日志点
+     * @param frame 当前栈帧
+     * @param error 表达式编译失败时写入错误信息（只报告一次）
+     * @return QByteArray UTF-8消息
+     */
+    QByteArray formatLog(const Entry& entry, PyFrameObject* frame, QString* error) const;
+
+    /**
+     * @brief 位测试
+     * @param bits 位图
+     * @param line 行号
+     * @return bool 对应位为1返回true
+     */
+    static bool testBit(const std::vector<quint64>& bits, int line)
+    {
+        const size_t index = static_cast<size_t>(static_cast<unsigned int>(line)) >> 6;
+        return index < bits.size() && (bits[index] >> (line & 63)) & 1;
+    }
+
+private:
+    std::vector<quint64> m_lines;              // 设置了断点的行
+    std::vector<quint64> m_conditionalLines;   // 带条件、命中次数或日志消息的行
+    QHash<int, Entry>    m_entries;            // 这些行的命中计数、条件和日志消息
+    mutable bool         m_hasCode = false;    // 是否持有已编译的条件或日志表达式
+};
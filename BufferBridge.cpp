@@ -0,0 +1,206 @@
+#include "BufferBridge.h"
+
+#include <QMutexLocker>
+
+#include <pybind11/stl.h>
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// 数组base中capsule的名称，用于识别由toArray()创建的数组
+static const char* const kCapsuleName = "QtPythonEmbed.SampleBuffer";
+
+std::shared_ptr<SampleBuffer> SampleBuffer::allocate(size_t size)
+{
+    std::shared_ptr<double> memory(new double[size](), std::default_delete<double[]>());
+
+    std::shared_ptr<SampleBuffer> buffer(new SampleBuffer);
+    buffer->m_data  = memory.get();
+    buffer->m_size  = size;
+    buffer->m_owner = std::move(memory);
+    return buffer;
+}
+
+std::shared_ptr<SampleBuffer>
+SampleBuffer::wrap(double* data, size_t size, std::shared_ptr<void> owner, bool writable)
+{
+    std::shared_ptr<SampleBuffer> buffer(new SampleBuffer);
+    buffer->m_data     = data;
+    buffer->m_size     = size;
+    buffer->m_writable = writable;
+    buffer->m_owner    = std::move(owner);
+    return buffer;
+}
+
+BufferRegistry& BufferRegistry::instance()
+{
+    static BufferRegistry instance;
+    return instance;
+}
+
+void BufferRegistry::publish(const QString& name, std::shared_ptr<SampleBuffer> buffer)
+{
+    // 被替换的缓冲区在锁外释放：持有Python数组时释放需要获取GIL
+    std::shared_ptr<SampleBuffer> previous;
+    {
+        QMutexLocker locker(&m_mutex);
+        previous        = m_buffers.value(name);
+        m_buffers[name] = std::move(buffer);
+    }
+}
+
+std::shared_ptr<SampleBuffer> BufferRegistry::find(const QString& name) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_buffers.value(name);
+}
+
+void BufferRegistry::remove(const QString& name)
+{
+    std::shared_ptr<SampleBuffer> previous;
+    {
+        QMutexLocker locker(&m_mutex);
+        previous = m_buffers.take(name);
+    }
+}
+
+void BufferRegistry::clear()
+{
+    QHash<QString, std::shared_ptr<SampleBuffer>> previous;
+    {
+        QMutexLocker locker(&m_mutex);
+        previous.swap(m_buffers);
+    }
+}
+
+QStringList BufferRegistry::names() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_buffers.keys();
+}
+
+namespace BufferBridge {
+
+static void releaseCapsule(PyObject* capsule)
+{
+    delete static_cast<std::shared_ptr<SampleBuffer>*>(PyCapsule_GetPointer(capsule, kCapsuleName));
+}
+
+void requireMainInterpreter()
+{
+    if (PyInterpreterState_Get() != PyInterpreterState_Main()) {
+        throw std::runtime_error("NumPy buffers are only available in the main interpreter");
+    }
+}
+
+py::array_t<double> toArray(const std::shared_ptr<SampleBuffer>& buffer)
+{
+    std::shared_ptr<SampleBuffer>* holder = new std::shared_ptr<SampleBuffer>(buffer);
+    py::object base = py::reinterpret_steal<py::object>(PyCapsule_New(holder, kCapsuleName, releaseCapsule));
+    if (!base) {
+        delete holder;
+        throw py::error_already_set();
+    }
+
+    // 提供base时pybind11不复制数据，数组只是这块内存的视图
+    py::array_t<double> array({static_cast<py::ssize_t>(buffer->size())},
+                              {static_cast<py::ssize_t>(sizeof(double))},
+                              buffer->data(),
+                              base);
+    if (!buffer->isWritable()) {
+        array.attr("flags").attr("writeable") = false;
+    }
+    return array;
+}
+
+std::shared_ptr<SampleBuffer> fromArray(const py::array_t<double, py::array::c_style>& array)
+{
+    // 沿着视图链找到最初的内存持有者
+    py::object base = array.base();
+    while (py::isinstance<py::array>(base)) {
+        base = py::reinterpret_borrow<py::array>(base).base();
+    }
+
+    // 覆盖完整缓冲区的视图直接复用原缓冲区，不再经由Python对象保持内存
+    if (PyCapsule_IsValid(base.ptr(), kCapsuleName)) {
+        const std::shared_ptr<SampleBuffer>& original =
+            *static_cast<std::shared_ptr<SampleBuffer>*>(PyCapsule_GetPointer(base.ptr(), kCapsuleName));
+        if (original->data() == array.data() && original->size() == static_cast<size_t>(array.size()) &&
+            original->isWritable() == array.writeable()) {
+            return original;
+        }
+    }
+
+    // 其他数组：缓冲区持有数组的引用，最后一个使用者释放时在GIL下归还
+    PyObject* object = array.ptr();
+    Py_INCREF(object);
+    std::shared_ptr<void> owner(object, [](void* pointer) {
+        if (!Py_IsInitialized()) {
+            return;
+        }
+        py::gil_scoped_acquire acquire;
+        Py_DECREF(static_cast<PyObject*>(pointer));
+    });
+
+    return SampleBuffer::wrap(const_cast<double*>(array.data()),
+                              static_cast<size_t>(array.size()),
+                              std::move(owner),
+                              array.writeable());
+}
+
+void bind(py::module_& m)
+{
+    // 数组参数使用noconvert：类型或布局不符时报错，而不是悄悄复制一份
+    using Array = py::array_t<double, py::array::c_style>;
+
+    m.def(
+        "new_buffer",
+        [](py::ssize_t size) {
+            requireMainInterpreter();
+            if (size < 0) {
+                throw py::value_error("buffer size must be non-negative");
+            }
+            return toArray(SampleBuffer::allocate(static_cast<size_t>(size)));
+        },
+        py::arg("size"),
+        "Allocate a zero-filled float64 array owned by C++");
+
+    m.def(
+        "buffer",
+        [](const std::string& name) {
+            requireMainInterpreter();
+            std::shared_ptr<SampleBuffer> buffer = BufferRegistry::instance().find(QString::fromStdString(name));
+            if (!buffer) {
+                throw py::key_error(name);
+            }
+            return toArray(buffer);
+        },
+        py::arg("name"),
+        "Return a published buffer as a float64 array sharing its memory");
+
+    m.def(
+        "publish",
+        [](const std::string& name, const Array& array) {
+            requireMainInterpreter();
+            BufferRegistry::instance().publish(QString::fromStdString(name), fromArray(array));
+        },
+        py::arg("name"),
+        py::arg("array").noconvert(),
+        "Publish a C-contiguous float64 array to C++ without copying");
+
+    m.def(
+        "unpublish",
+        [](const std::string& name) { BufferRegistry::instance().remove(QString::fromStdString(name)); },
+        py::arg("name"));
+
+    m.def("buffer_names", []() {
+        std::vector<std::string> names;
+        for (const QString& name : BufferRegistry::instance().names()) {
+            names.push_back(name.toStdString());
+        }
+        return names;
+    });
+}
+
+}   // namespace BufferBridge
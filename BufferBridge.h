@@ -0,0 +1,151 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <cstddef>
+#include <memory>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/**
+ * @class SampleBuffer
+ * @brief 一段连续的double数据，C++和Python共享同一块内存
+ *
+ * 内存由owner保持：C++分配的缓冲区由自身持有，来自NumPy数组的缓冲区持有该数组的引用。
+ * 最后一个shared_ptr释放时才释放内存，与数据在哪一侧使用无关。
+ * 缓冲区本身不加锁，两侧同时写入时由调用方同步。
+ */
+class SampleBuffer
+{
+public:
+    /**
+     * @brief 分配C++持有的缓冲区（内容清零）
+     * @param size 元素个数
+     * @return std::shared_ptr<SampleBuffer> 缓冲区
+     */
+    static std::shared_ptr<SampleBuffer> allocate(size_t size);
+
+    /**
+     * @brief 包装外部内存（不复制）
+     * @param data 数据指针
+     * @param size 元素个数
+     * @param owner 保持内存有效的对象，释放时内存随之失效
+     * @param writable 是否可写
+     * @return std::shared_ptr<SampleBuffer> 缓冲区
+     */
+    static std::shared_ptr<SampleBuffer>
+    wrap(double* data, size_t size, std::shared_ptr<void> owner, bool writable = true);
+
+    double* data() const { return m_data; }
+    size_t  size() const { return m_size; }
+    bool    isWritable() const { return m_writable; }
+
+private:
+    SampleBuffer() = default;
+
+    double*               m_data     = nullptr;
+    size_t                m_size     = 0;
+    bool                  m_writable = true;
+    std::shared_ptr<void> m_owner;
+};
+
+/**
+ * @class BufferRegistry
+ * @brief 按名称交换缓冲区，供宿主程序和Python代码互相传递数据
+ *
+ * 宿主程序publish()后，Python中cpp_module.buffer(name)得到共享内存的NumPy数组；
+ * Python中cpp_module.publish(name, array)后，宿主程序find(name)得到数组的内存。
+ * 所有接口线程安全，不需要持有GIL。
+ */
+class BufferRegistry
+{
+public:
+    /**
+     * @brief 获取单例实例
+     * @return BufferRegistry& 单例引用
+     */
+    static BufferRegistry& instance();
+
+    /**
+     * @brief 发布缓冲区（同名的旧缓冲区被替换）
+     * @param name 名称
+     * @param buffer 缓冲区
+     */
+    void publish(const QString& name, std::shared_ptr<SampleBuffer> buffer);
+
+    /**
+     * @brief 查找缓冲区
+     * @param name 名称
+     * @return std::shared_ptr<SampleBuffer> 缓冲区，不存在时为空
+     */
+    std::shared_ptr<SampleBuffer> find(const QString& name) const;
+
+    /**
+     * @brief 移除缓冲区（已取得的引用仍然有效）
+     * @param name 名称
+     */
+    void remove(const QString& name);
+
+    /**
+     * @brief 移除全部缓冲区（解释器销毁前调用，释放其中持有的Python数组）
+     */
+    void clear();
+
+    /**
+     * @brief 已发布的名称
+     * @return QStringList 名称列表
+     */
+    QStringList names() const;
+
+private:
+    BufferRegistry() = default;
+
+    mutable QMutex                                m_mutex;
+    QHash<QString, std::shared_ptr<SampleBuffer>> m_buffers;
+};
+
+/**
+ * @brief cpp_module中缓冲区接口的实现（需持有GIL）
+ *
+ * 数组只在主解释器中可用：NumPy不支持子解释器。
+ */
+namespace BufferBridge {
+
+/**
+ * @brief 当前解释器不是主解释器时抛出异常
+ */
+void requireMainInterpreter();
+
+/**
+ * @brief 把缓冲区包装为NumPy数组，不复制数据
+ *
+ * 数组的base是持有缓冲区引用的capsule，数组（及其切片）存活期间内存不会释放。
+ * @param buffer 缓冲区
+ * @return py::array_t<double> 一维数组
+ */
+py::array_t<double> toArray(const std::shared_ptr<SampleBuffer>& buffer);
+
+/**
+ * @brief 取得NumPy数组的内存，不复制数据
+ *
+ * 数组来自toArray()时直接返回原缓冲区，否则返回持有该数组引用的缓冲区。
+ * @param array C连续的float64数组
+ * @return std::shared_ptr<SampleBuffer> 缓冲区
+ */
+std::shared_ptr<SampleBuffer> fromArray(const py::array_t<double, py::array::c_style>& array);
+
+/**
+ * @brief 在cpp_module中注册缓冲区相关函数
+ * @param m 模块对象
+ */
+void bind(py::module_& m);
+
+}   // namespace BufferBridge
@@ -0,0 +1,272 @@
+#include "CellDependencies.h"
+#include "CellIndex.h"
+#include "PythonInterpreterManager.h"
+
+#include <QDebug>
+
+#include <pybind11/eval.h>
+
+// Python侧的分析函数
+//
+// 读写按字节码统计，dis对各版本的指令给出统一的argval（名字）；
+// 原地修改和import *在字节码中不易识别，按语法树补充。
+static const char* const kAnalyzerSource = R"(
+import ast
+import dis
+import types
+
+_LOADS = {"LOAD_NAME", "LOAD_GLOBAL", "LOAD_FROM_DICT_OR_GLOBALS"}
+_TOP_STORES = {"STORE_NAME", "DELETE_NAME"}
+_STORES = {"STORE_GLOBAL", "DELETE_GLOBAL"}
+_MUTATORS = {"append", "extend", "insert", "remove", "pop", "clear", "sort", "reverse",
+             "update", "setdefault", "popitem", "add", "discard"}
+
+
+def _root(node):
+    while isinstance(node, (ast.Attribute, ast.Subscript)):
+        node = node.value
+    return node.id if isinstance(node, ast.Name) else None
+
+
+def _mutated(tree):
+    names = set()
+    for node in ast.walk(tree):
+        targets = ()
+        if isinstance(node, (ast.Assign, ast.Delete)):
+            targets = node.targets
+        elif isinstance(node, (ast.AugAssign, ast.AnnAssign)):
+            targets = (node.target,)
+        elif isinstance(node, ast.Call) and isinstance(node.func, ast.Attribute) \
+                and node.func.attr in _MUTATORS:
+            targets = (node.func,)
+        elif isinstance(node, ast.ImportFrom) and any(alias.name == "*" for alias in node.names):
+            names.add("*")
+        for target in targets:
+            if isinstance(target, (ast.Attribute, ast.Subscript)):
+                name = _root(target)
+                if name:
+                    names.add(name)
+    return names
+
+
+def _nested(code, reads, writes):
+    for ins in dis.get_instructions(code):
+        if ins.opname in _LOADS:
+            reads.add(ins.argval)
+        elif ins.opname in _STORES:
+            writes.add(ins.argval)
+    for const in code.co_consts:
+        if isinstance(const, types.CodeType):
+            _nested(const, reads, writes)
+
+
+def analyze(source):
+    tree = ast.parse(source, "<cell>")
+    code = compile(tree, "<cell>", "exec", ast.PyCF_ALLOW_TOP_LEVEL_AWAIT, dont_inherit=True)
+    reads, writes = set(), set()
+    for ins in dis.get_instructions(code):
+        if ins.opname in _LOADS:
+            if ins.argval not in writes:
+                reads.add(ins.argval)
+        elif ins.opname in _TOP_STORES or ins.opname in _STORES:
+            writes.add(ins.argval)
+    nested_reads = set()
+    for const in code.co_consts:
+        if isinstance(const, types.CodeType):
+            _nested(const, nested_reads, writes)
+    reads |= nested_reads - writes
+    mutated = _mutated(tree)
+    return list(reads | (mutated - {"*"})), list(writes | mutated)
+)";
+
+// 缓存超过单元格数的该倍数时丢弃已不在缓冲区中的内容
+static const int kCacheSlack = 4;
+
+CellDependencies::CellDependencies(QObject* parent)
+    : QObject(parent)
+{
+    m_thread = std::thread(&CellDependencies::workerLoop, this);
+}
+
+CellDependencies::~CellDependencies()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void CellDependencies::update(const QString& text, const CellIndex& index)
+{
+    const QVector<CellIndex::Cell>& cells = index.cells();
+    QVector<int>                    missing;
+    for (int i = 0; i < cells.size(); ++i) {
+        if (!cells[i].isEmpty && !m_names.contains(cells[i].hash)) {
+            missing.append(i);
+        }
+    }
+
+    if (m_names.size() + missing.size() > kCacheSlack * cells.size()) {
+        QHash<uint, Names> kept;
+        for (const CellIndex::Cell& cell : cells) {
+            if (m_names.contains(cell.hash)) {
+                kept.insert(cell.hash, m_names.value(cell.hash));
+            }
+        }
+        m_names.swap(kept);
+    }
+
+    // 只提交当前缓冲区中缺少的单元格，编辑前提交、尚未开始分析的旧内容不再分析
+    QVector<QPair<uint, QString>> queue;
+    m_pending.clear();
+    for (int i : missing) {
+        if (!m_pending.contains(cells[i].hash)) {
+            m_pending.insert(cells[i].hash);
+            queue.append(qMakePair(cells[i].hash, index.source(text, i)));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.swap(queue);
+    }
+    if (!m_pending.isEmpty()) {
+        m_wake.notify_one();
+    }
+}
+
+void CellDependencies::workerLoop()
+{
+    PythonInterpreterManager& manager = PythonInterpreterManager::instance();
+    for (;;) {
+        QVector<QPair<uint, QString>> queue;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return !m_queue.isEmpty() || m_stopping; });
+            if (m_stopping) {
+                break;
+            }
+            queue.swap(m_queue);
+        }
+
+        QHash<uint, Names> names;
+        QVector<uint>      skipped;
+        if (!manager.isInitialized() || manager.isInitializing()) {
+            // 解释器已销毁时原来的函数对象随之失效；正在重新初始化时完成后再分析
+            if (m_analyze) {
+                m_analyze.release();
+            }
+            for (const QPair<uint, QString>& cell : queue) {
+                skipped.append(cell.first);
+            }
+        }
+        else {
+            if (m_analyzeGeneration != manager.generation()) {
+                // 函数对象属于重新初始化之前的解释器
+                if (m_analyze) {
+                    m_analyze.release();
+                }
+                m_analyzeGeneration = manager.generation();
+            }
+
+            // 运行期间在这里等待GIL，不影响界面线程
+            py::gil_scoped_acquire acquire;
+            for (const QPair<uint, QString>& cell : queue) {
+                names.insert(cell.first, analyze(cell.second));
+            }
+        }
+        QMetaObject::invokeMethod(
+            this, [this, names, skipped]() { applyNames(names, skipped); }, Qt::QueuedConnection);
+    }
+
+    if (!m_analyze) {
+        return;
+    }
+    // 解释器已销毁或重新初始化过时只放弃函数对象
+    if (!Py_IsInitialized() || m_analyzeGeneration != manager.generation()) {
+        m_analyze.release();
+        return;
+    }
+    py::gil_scoped_acquire acquire;
+    m_analyze = py::object();
+}
+
+void CellDependencies::applyNames(const QHash<uint, Names>& names, const QVector<uint>& skipped)
+{
+    for (auto it = names.cbegin(); it != names.cend(); ++it) {
+        m_names.insert(it.key(), it.value());
+        m_pending.remove(it.key());
+    }
+    // 没有分析的单元格不缓存，下次update()重新提交
+    for (uint hash : skipped) {
+        m_pending.remove(hash);
+    }
+    emit analyzed();
+}
+
+CellDependencies::Names CellDependencies::analyze(const QString& source)
+{
+    Names names;
+    try {
+        if (!m_analyze) {
+            py::dict scope;
+            scope["__name__"]     = "qt_cell_dependencies";
+            scope["__builtins__"] = py::module_::import("builtins");
+            py::exec(kAnalyzerSource, scope);
+            m_analyze = scope["analyze"];
+        }
+
+        py::tuple result = m_analyze(source.toStdString());
+        for (py::handle name : result[0]) {
+            names.reads.insert(QString::fromStdString(name.cast<std::string>()));
+        }
+        for (py::handle name : result[1]) {
+            names.writes.insert(QString::fromStdString(name.cast<std::string>()));
+        }
+        names.analyzed = true;
+    }
+    catch (py::error_already_set& e) {
+        // 语法错误在运行时报告，这里只按无法分析处理
+        if (!e.matches(PyExc_SyntaxError)) {
+            qWarning() << "Cell dependency analysis failed:" << e.what();
+        }
+    }
+    return names;
+}
+
+QVector<int> CellDependencies::affected(const CellIndex& index, const QVector<int>& changed) const
+{
+    const QVector<CellIndex::Cell>& cells = index.cells();
+    QSet<int>                       changedSet;
+    for (int i : changed) {
+        changedSet.insert(i);
+    }
+
+    // 按顺序模拟一遍运行：重新运行的单元格写入的名字变脏，读取脏名字的单元格随之重新运行
+    QVector<int>  result;
+    QSet<QString> dirty;
+    bool          everything = false;   // 之后的所有单元格都需要重新运行
+    for (int i = 0; i < cells.size(); ++i) {
+        if (cells[i].isEmpty) {
+            continue;
+        }
+
+        const Names names = m_names.value(cells[i].hash);
+        bool        rerun = everything || changedSet.contains(i);
+        if (!rerun && !dirty.isEmpty()) {
+            // 无法分析的单元格视为读取所有名字
+            rerun = !names.analyzed || names.reads.intersects(dirty);
+        }
+        if (!rerun) {
+            continue;
+        }
+
+        result.append(i);
+        if (!names.analyzed || names.writes.contains(QStringLiteral("*"))) {
+            everything = true;
+        }
+        dirty.unite(names.writes);
+    }
+    return result;
+}
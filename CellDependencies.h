@@ -0,0 +1,130 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+class CellIndex;
+
+/**
+ * @class CellDependencies
+ * @brief 单元格之间通过全局变量形成的依赖
+ *
+ * 每个单元格编译后按字节码统计读写的全局名字：顶层的LOAD_NAME/LOAD_GLOBAL为读取
+ * （本单元格先前已赋值的名字除外），STORE_NAME/DELETE_NAME/STORE_GLOBAL为写入，
+ * 嵌套的函数、类和推导式中读取的全局名字也计为读取。字节码看不到对已有对象的原地修改，
+ * 另外按语法树把下标和属性赋值（data[0] = ...）、常见的就地修改方法（data.append(...)等）
+ * 的根名字同时计为读取和写入；from ... import *写入的名字不确定，视为写入所有名字。
+ *
+ * 已修改的单元格重新运行后，其写入的名字变"脏"；此后读取脏名字的单元格也需要重新运行，
+ * 其写入的名字同样变脏。与它们无关的单元格（通常是开头加载数据的单元格）保留上次的结果。
+ * 无法分析的单元格（语法错误、解释器未就绪）按最保守的方式处理。
+ *
+ * 分析结果按单元格内容哈希缓存，编辑后只分析新内容。分析需要GIL，在后台线程中进行，
+ * 其他标签页运行脚本时界面线程不会等待；结果按单元格哈希送回界面线程写入缓存，然后发出analyzed()。
+ * 尚未得到结果的单元格按无法分析处理。除后台线程外所有接口都在界面线程中调用。
+ */
+class CellDependencies : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 单元格读写的全局名字
+     */
+    struct Names
+    {
+        QSet<QString> reads;
+        QSet<QString> writes;              // 含"*"时表示可能写入任意名字
+        bool          analyzed = false;    // false表示无法分析
+    };
+
+    explicit CellDependencies(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（停止后台线程）
+     */
+    ~CellDependencies() override;
+
+    /**
+     * @brief 把尚未缓存的单元格交给后台线程分析，取代尚未开始分析的单元格
+     * @param text 缓冲区文本
+     * @param index 按该文本划分好的单元格
+     */
+    void update(const QString& text, const CellIndex& index);
+
+    /**
+     * @brief 是否还有已提交、尚未送回结果的单元格
+     */
+    bool isPending() const { return !m_pending.isEmpty(); }
+
+    /**
+     * @brief 获取单元格的分析结果
+     * @param hash 单元格内容哈希
+     * @return Names 读写的名字，未分析时analyzed为false
+     */
+    Names names(uint hash) const { return m_names.value(hash); }
+
+    /**
+     * @brief 计算需要重新运行的单元格
+     * @param index 单元格划分
+     * @param changed 已修改的单元格下标
+     * @return QVector<int> 已修改的单元格及所有依赖其结果的单元格，按行号排列
+     */
+    QVector<int> affected(const CellIndex& index, const QVector<int>& changed) const;
+
+signals:
+    /**
+     * @brief 一批分析结果已写入缓存
+     */
+    void analyzed();
+
+private:
+    /**
+     * @brief 后台线程主循环
+     */
+    void workerLoop();
+
+    /**
+     * @brief 分析一个单元格（后台线程，需持有GIL）
+     * @param source 单元格代码
+     * @return Names 读写的名字
+     */
+    Names analyze(const QString& source);
+
+    /**
+     * @brief 写入后台线程送回的结果（界面线程）
+     * @param names 按单元格哈希的分析结果
+     * @param skipped 解释器未就绪、没有分析的单元格哈希
+     */
+    void applyNames(const QHash<uint, Names>& names, const QVector<uint>& skipped);
+
+private:
+    // 以下只在界面线程中访问
+    QHash<uint, Names> m_names;     // 按单元格内容哈希缓存的分析结果
+    QSet<uint>         m_pending;   // 已提交、尚未送回结果的单元格哈希
+
+    // 以下只在后台线程中访问
+    py::object m_analyze;                 // Python侧的分析函数，首次使用时创建
+    quint64    m_analyzeGeneration = 0;   // m_analyze所属的解释器代数
+
+    // 后台线程，待分析的单元格由m_mutex保护
+    std::thread                   m_thread;
+    std::mutex                    m_mutex;
+    std::condition_variable       m_wake;
+    QVector<QPair<uint, QString>> m_queue;   // （单元格哈希，代码）
+    bool                          m_stopping = false;
+};
@@ -0,0 +1,173 @@
+#include "CellIndex.h"
+
+#include <QHash>
+#include <QStringList>
+
+#include <algorithm>
+
+bool CellIndex::isMarker(const QString& line)
+{
+    // 只认顶格的标记，缩进的"# %%"属于某个代码块内部
+    if (!line.startsWith(QLatin1Char('#'))) {
+        return false;
+    }
+    int pos = 1;
+    while (pos < line.size() && line[pos] == QLatin1Char(' ')) {
+        ++pos;
+    }
+    return line.mid(pos, 2) == QLatin1String("%%");
+}
+
+void CellIndex::update(const QString& text)
+{
+    m_cells.clear();
+
+    const QStringList lines = text.split(QLatin1Char('\n'));
+
+    Cell    cell;
+    QString content;       // 规范化后的内容，用于计算哈希
+    int     blankRun = 0;  // 尚未写入content的连续空行
+
+    auto closeCell = [&](int lastLine) {
+        cell.lastLine = lastLine;
+        cell.hash     = qHash(content);
+        // 第一个标记之前只有空行和注释时不单独成为单元格
+        if (cell.hasMarker || !cell.isEmpty) {
+            m_cells.append(cell);
+        }
+    };
+
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString& line   = lines[i];
+        const int      lineNo = i + 1;
+
+        if (isMarker(line)) {
+            if (lineNo > 1) {
+                closeCell(lineNo - 1);
+            }
+            cell           = Cell();
+            cell.firstLine = lineNo;
+            cell.hasMarker = true;
+            cell.title     = line.mid(line.indexOf(QLatin1String("%%")) + 2).trimmed();
+            content.clear();
+            blankRun = 0;
+            continue;
+        }
+
+        // 忽略行尾空白；开头和末尾的空行不影响内容
+        int end = line.size();
+        while (end > 0 && line[end - 1].isSpace()) {
+            --end;
+        }
+        if (end == 0) {
+            ++blankRun;
+            continue;
+        }
+        if (!content.isEmpty()) {
+            content += QString(blankRun + 1, QLatin1Char('\n'));
+        }
+        content += line.left(end);
+        blankRun = 0;
+
+        if (!line.trimmed().startsWith(QLatin1Char('#'))) {
+            cell.isEmpty = false;
+        }
+    }
+    closeCell(lines.size());
+}
+
+int CellIndex::cellAt(int line) const
+{
+    if (m_cells.isEmpty()) {
+        return -1;
+    }
+
+    // 第一个满足firstLine > line的单元格的前一个；第一个单元格之前的空行归入第一个单元格
+    auto it = std::upper_bound(m_cells.cbegin(), m_cells.cend(), line, [](int value, const Cell& cell) {
+        return value < cell.firstLine;
+    });
+    return it == m_cells.cbegin() ? 0 : static_cast<int>(it - m_cells.cbegin()) - 1;
+}
+
+bool CellIndex::isStale(int index) const
+{
+    if (index < 0 || index >= m_cells.size()) {
+        return false;
+    }
+    const Cell& cell = m_cells[index];
+    return !cell.isEmpty && !m_executed.contains(cell.hash);
+}
+
+QVector<int> CellIndex::staleCells() const
+{
+    QVector<int> result;
+    for (int i = 0; i < m_cells.size(); ++i) {
+        if (isStale(i)) {
+            result.append(i);
+        }
+    }
+    return result;
+}
+
+QVector<uint> CellIndex::hashes(const QVector<int>& indexes) const
+{
+    QVector<uint> result;
+    result.reserve(indexes.size());
+    for (int index : indexes) {
+        if (index >= 0 && index < m_cells.size() && !m_cells[index].isEmpty) {
+            result.append(m_cells[index].hash);
+        }
+    }
+    return result;
+}
+
+void CellIndex::markExecuted(const QVector<uint>& hashes)
+{
+    for (uint hash : hashes) {
+        m_executed.insert(hash);
+    }
+}
+
+void CellIndex::invalidate()
+{
+    m_executed.clear();
+}
+
+QString CellIndex::code(const QString& text, const QVector<int>& indexes) const
+{
+    QVector<bool> selected;
+    selected.fill(false, m_cells.size());
+    int lastLine = 0;
+    for (int index : indexes) {
+        if (index >= 0 && index < m_cells.size()) {
+            selected[index] = true;
+            lastLine        = std::max(lastLine, m_cells[index].lastLine);
+        }
+    }
+    if (lastLine == 0) {
+        return QString();
+    }
+
+    const QStringList lines = text.split(QLatin1Char('\n'));
+    QStringList       result;
+    result.reserve(lastLine);
+
+    int cell = 0;
+    for (int lineNo = 1; lineNo <= lastLine && lineNo <= lines.size(); ++lineNo) {
+        while (cell + 1 < m_cells.size() && m_cells[cell + 1].firstLine <= lineNo) {
+            ++cell;
+        }
+        const bool inCell = lineNo >= m_cells[cell].firstLine && lineNo <= m_cells[cell].lastLine;
+        result.append(inCell && selected[cell] ? lines[lineNo - 1] : QString());
+    }
+    return result.join(QLatin1Char('\n'));
+}
+
+QString CellIndex::source(const QString& text, int index) const
+{
+    if (index < 0 || index >= m_cells.size()) {
+        return QString();
+    }
+    const Cell& cell = m_cells[index];
+    return text.section(QLatin1Char('\n'), cell.firstLine - 1, cell.lastLine - 1);
+}
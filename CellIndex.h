@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class CellIndex
+ * @brief 编辑缓冲区按"# %%"标记划分的单元格及其运行状态
+ *
+ * 顶格的"# %%"（或"#%%"）注释行开始一个新单元格，该行其余文字作为标题；
+ * 第一个标记之前的代码自成一个单元格，没有标记时整个缓冲区是一个单元格。
+ *
+ * 每个单元格按内容（不含标记行、忽略行尾空白和末尾的空行）计算哈希。
+ * 运行过的内容记入已运行集合，单元格内容不在集合中即为"已修改"：
+ * 插入、删除或移动其他单元格不影响判断，改回运行时的内容后又恢复为未修改。
+ * 命名空间重置后调用invalidate()，所有单元格重新变为已修改。
+ *
+ * 不涉及Python，只在界面线程中使用。
+ */
+class CellIndex
+{
+public:
+    /**
+     * @brief 单元格信息
+     */
+    struct Cell
+    {
+        int     firstLine = 1;       // 首行（标记行），1-based
+        int     lastLine  = 1;       // 末行（含），1-based
+        bool    hasMarker = false;   // 首行是否为标记行
+        bool    isEmpty   = true;    // 只有空行和注释
+        uint    hash      = 0;       // 内容哈希
+        QString title;               // 标记行中"%%"之后的文字
+    };
+
+    /**
+     * @brief 判断一行是否为单元格标记
+     * @param line 行文本
+     * @return bool 是标记返回true
+     */
+    static bool isMarker(const QString& line);
+
+    /**
+     * @brief 按缓冲区文本重新划分单元格（已运行集合保留）
+     * @param text 缓冲区文本
+     */
+    void update(const QString& text);
+
+    /**
+     * @brief 获取所有单元格
+     * @return const QVector<Cell>& 按行号排列的单元格
+     */
+    const QVector<Cell>& cells() const { return m_cells; }
+
+    /**
+     * @brief 查找包含某一行的单元格
+     * @param line 行号（1-based）
+     * @return int 单元格下标，没有单元格时为-1
+     */
+    int cellAt(int line) const;
+
+    /**
+     * @brief 单元格自上次运行后是否被修改过（从未运行也算已修改，空单元格不算）
+     * @param index 单元格下标
+     * @return bool 已修改返回true
+     */
+    bool isStale(int index) const;
+
+    /**
+     * @brief 获取所有已修改的单元格
+     * @return QVector<int> 单元格下标，按行号排列
+     */
+    QVector<int> staleCells() const;
+
+    /**
+     * @brief 获取单元格的内容哈希，运行成功后交给markExecuted()
+     * @param indexes 单元格下标
+     * @return QVector<uint> 哈希
+     */
+    QVector<uint> hashes(const QVector<int>& indexes) const;
+
+    /**
+     * @brief 把内容记为已运行
+     * @param hashes 运行的单元格的内容哈希
+     */
+    void markExecuted(const QVector<uint>& hashes);
+
+    /**
+     * @brief 清空已运行集合（命名空间重置后调用）
+     */
+    void invalidate();
+
+    /**
+     * @brief 生成只包含指定单元格的代码
+     *
+     * 其他单元格的行替换为空行，行号与编辑器一致，断点和逐行分析照常对应。
+     * @param text 缓冲区文本（与最近一次update()相同）
+     * @param indexes 单元格下标
+     * @return QString 代码，没有选中的单元格时为空
+     */
+    QString code(const QString& text, const QVector<int>& indexes) const;
+
+    /**
+     * @brief 获取单个单元格的代码（不补空行）
+     * @param text 缓冲区文本（与最近一次update()相同）
+     * @param index 单元格下标
+     * @return QString 从首行到末行的代码
+     */
+    QString source(const QString& text, int index) const;
+
+private:
+    QVector<Cell> m_cells;
+    QSet<uint>    m_executed;   // 运行过的单元格内容哈希
+};
@@ -0,0 +1,172 @@
+#include "CodeCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <marshal.h>
+
+// 字节码文件头：解释器魔数（4字节），随后是marshal数据
+static const int kHeaderSize = 4;
+
+CodeCache::CodeCache()
+{
+    m_memory.setMaxCost(32);
+}
+
+void CodeCache::setMaxMemoryEntries(int entries)
+{
+    m_memory.setMaxCost(qMax(0, entries));
+}
+
+void CodeCache::setDiskDirectory(const QString& directory)
+{
+    m_diskDirectory = directory;
+    if (!m_diskDirectory.isEmpty() && !QDir().mkpath(m_diskDirectory)) {
+        qWarning() << "Cannot create bytecode cache directory:" << m_diskDirectory;
+        m_diskDirectory.clear();
+    }
+}
+
+void CodeCache::setMaxDiskEntries(int entries)
+{
+    m_maxDiskEntries = qMax(0, entries);
+}
+
+py::object CodeCache::compile(const QByteArray& source, const char* filename, int flags)
+{
+    if (m_magic == 0) {
+        m_magic = PyImport_GetMagicNumber();
+    }
+
+    QByteArray key = cacheKey(source, filename, flags);
+
+    // 内存缓存
+    if (py::object* cached = m_memory.object(key)) {
+        ++m_hits;
+        return *cached;
+    }
+
+    // 磁盘缓存
+    py::object code = loadFromDisk(key);
+    if (code) {
+        ++m_hits;
+    }
+    else {
+        ++m_misses;
+        PyCompilerFlags compilerFlags = {flags, PY_MINOR_VERSION};
+        code                          = py::reinterpret_steal<py::object>(
+            Py_CompileStringExFlags(source.constData(), filename, Py_file_input, &compilerFlags, -1));
+        if (!code) {
+            throw py::error_already_set();
+        }
+        storeToDisk(key, code);
+    }
+
+    // 每个条目的代价为1，最大代价即条目数
+    if (m_memory.maxCost() > 0) {
+        m_memory.insert(key, new py::object(code));
+    }
+
+    return code;
+}
+
+void CodeCache::clear()
+{
+    m_memory.clear();
+}
+
+QByteArray CodeCache::cacheKey(const QByteArray& source, const char* filename, int flags) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(reinterpret_cast<const char*>(&m_magic), sizeof(m_magic));
+    hash.addData(reinterpret_cast<const char*>(&flags), sizeof(flags));
+    hash.addData(filename, static_cast<int>(qstrlen(filename)) + 1);
+    hash.addData(source);
+    return hash.result().toHex();
+}
+
+QString CodeCache::diskPath(const QByteArray& key) const
+{
+    return QDir(m_diskDirectory).filePath(QString::fromLatin1(key) + ".pyc");
+}
+
+py::object CodeCache::loadFromDisk(const QByteArray& key) const
+{
+    if (m_diskDirectory.isEmpty()) {
+        return py::object();
+    }
+
+    QFile file(diskPath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return py::object();
+    }
+
+    QByteArray data = file.readAll();
+    if (data.size() <= kHeaderSize ||
+        qFromLittleEndian<qint32>(data.constData()) != static_cast<qint32>(m_magic)) {
+        file.remove();
+        return py::object();
+    }
+
+    py::object code = py::reinterpret_steal<py::object>(PyMarshal_ReadObjectFromString(
+        data.constData() + kHeaderSize, data.size() - kHeaderSize));
+    if (!code || !PyCode_Check(code.ptr())) {
+        // 损坏的缓存文件直接丢弃，回退到重新编译
+        PyErr_Clear();
+        file.remove();
+        return py::object();
+    }
+
+    // 更新修改时间，用于按最近使用淘汰
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return code;
+}
+
+void CodeCache::storeToDisk(const QByteArray& key, const py::object& code) const
+{
+    if (m_diskDirectory.isEmpty() || m_maxDiskEntries == 0) {
+        return;
+    }
+
+    py::object marshalled = py::reinterpret_steal<py::object>(
+        PyMarshal_WriteObjectToString(code.ptr(), Py_MARSHAL_VERSION));
+    if (!marshalled) {
+        PyErr_Clear();
+        return;
+    }
+
+    char header[kHeaderSize];
+    qToLittleEndian<qint32>(static_cast<qint32>(m_magic), header);
+
+    // 先写临时文件再替换，避免并发运行的实例读到写了一半的文件
+    QSaveFile file(diskPath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(header, kHeaderSize);
+    file.write(PyBytes_AS_STRING(marshalled.ptr()), PyBytes_GET_SIZE(marshalled.ptr()));
+    if (!file.commit()) {
+        qWarning() << "Failed to write bytecode cache:" << file.fileName();
+        return;
+    }
+
+    pruneDisk();
+}
+
+void CodeCache::pruneDisk() const
+{
+    QDir          dir(m_diskDirectory);
+    QFileInfoList files =
+        dir.entryInfoList(QStringList() << "*.pyc", QDir::Files, QDir::Time);
+
+    // 按修改时间从新到旧排列，删除超出限制的部分
+    for (int i = m_maxDiskEntries; i < files.size(); ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+}
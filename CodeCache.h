@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QString>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/**
+ * @class CodeCache
+ * @brief 编译后代码对象的缓存
+ *
+ * 以源码内容、文件名和解释器字节码魔数的SHA-256作为键：
+ * - 内存中按LRU保留最近使用的代码对象，重复运行同一段代码不再重新编译
+ * - 可选地把marshal后的字节码写入磁盘，应用重启后未修改的代码也跳过词法/语法分析和编译
+ *
+ * 所有接口都必须在持有GIL时调用。
+ */
+class CodeCache
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    CodeCache();
+
+    /**
+     * @brief 设置内存中最多缓存的代码对象数量
+     * @param entries 条目数，0表示关闭内存缓存
+     */
+    void setMaxMemoryEntries(int entries);
+
+    /**
+     * @brief 设置磁盘缓存目录
+     * @param directory 目录路径，为空表示关闭磁盘缓存
+     */
+    void setDiskDirectory(const QString& directory);
+
+    /**
+     * @brief 获取磁盘缓存目录
+     * @return QString 目录路径，为空表示磁盘缓存已关闭
+     */
+    QString diskDirectory() const { return m_diskDirectory; }
+
+    /**
+     * @brief 设置磁盘上最多保留的字节码文件数量
+     * @param entries 文件数，超出后删除最久未使用的文件
+     */
+    void setMaxDiskEntries(int entries);
+
+    /**
+     * @brief 获取源码对应的代码对象，未命中时编译并写入缓存
+     * @param source UTF-8源码
+     * @param filename 编译使用的文件名
+     * @param flags 编译选项（PyCF_*，如PyCF_ALLOW_TOP_LEVEL_AWAIT），不同选项分别缓存
+     * @return py::object 代码对象，编译失败时抛出py::error_already_set
+     */
+    py::object compile(const QByteArray& source, const char* filename, int flags = 0);
+
+    /**
+     * @brief 清空内存缓存（解释器销毁前必须调用）
+     */
+    void clear();
+
+    /**
+     * @brief 获取命中次数（内存和磁盘）
+     * @return quint64 命中次数
+     */
+    quint64 hits() const { return m_hits; }
+
+    /**
+     * @brief 获取未命中（实际编译）次数
+     * @return quint64 未命中次数
+     */
+    quint64 misses() const { return m_misses; }
+
+private:
+    /**
+     * @brief 计算缓存键
+     * @param source UTF-8源码
+     * @param filename 文件名
+     * @param flags 编译选项
+     * @return QByteArray 十六进制摘要
+     */
+    QByteArray cacheKey(const QByteArray& source, const char* filename, int flags) const;
+
+    /**
+     * @brief 获取缓存键对应的字节码文件路径
+     * @param key 缓存键
+     * @return QString 文件路径
+     */
+    QString diskPath(const QByteArray& key) const;
+
+    /**
+     * @brief 从磁盘加载字节码
+     * @param key 缓存键
+     * @return py::object 代码对象，不存在或无效时为空对象
+     */
+    py::object loadFromDisk(const QByteArray& key) const;
+
+    /**
+     * @brief 把代码对象marshal后写入磁盘
+     * @param key 缓存键
+     * @param code 代码对象
+     */
+    void storeToDisk(const QByteArray& key, const py::object& code) const;
+
+    /**
+     * @brief 删除超出数量限制的旧字节码文件
+     */
+    void pruneDisk() const;
+
+private:
+    QCache<QByteArray, py::object> m_memory;           // 键 -> 代码对象，按LRU淘汰
+    QString                        m_diskDirectory;    // 字节码目录，为空表示关闭
+    int                            m_maxDiskEntries = 256;
+    long                           m_magic          = 0;   // 解释器字节码魔数，版本变化时缓存自动失效
+    quint64                        m_hits           = 0;
+    quint64                        m_misses         = 0;
+};
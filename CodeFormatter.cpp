@@ -0,0 +1,228 @@
+#include "CodeFormatter.h"
+#include "PythonInterpreterManager.h"
+
+#include <QDebug>
+
+#include <vector>
+
+CodeFormatter::CodeFormatter(QObject* parent)
+    : QObject(parent)
+{
+    m_thread = std::thread(&CodeFormatter::workerLoop, this);
+}
+
+CodeFormatter::~CodeFormatter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void CodeFormatter::format(const QString& text, quint64 revision)
+{
+    std::unique_ptr<Job> job(new Job);
+    job->text     = text;
+    job->revision = revision;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = std::move(job);
+    }
+    m_wake.notify_one();
+}
+
+QStringList CodeFormatter::basicFormat(const QStringList& lines)
+{
+    QStringList formattedLines;
+    for (const QString& line : lines) {
+        const QString trimmedLine = line.trimmed();
+        if (!trimmedLine.isEmpty()) {
+            // 统一缩进：制表符按4个空格计
+            int indent = 0;
+            for (QChar c : line) {
+                if (c == ' ') {
+                    ++indent;
+                }
+                else if (c == '\t') {
+                    indent += 4;
+                }
+                else {
+                    break;
+                }
+            }
+            formattedLines.append(QString(indent, ' ') + trimmedLine);
+        }
+        else if (!formattedLines.isEmpty() && !formattedLines.last().isEmpty()) {
+            // 保持最多一个空行
+            formattedLines.append(QString());
+        }
+    }
+    return formattedLines;
+}
+
+QVector<CodeFormatter::LineEdit> CodeFormatter::diffLines(const QStringList& before, const QStringList& after)
+{
+    QVector<LineEdit> edits;
+
+    // 相同的开头和结尾
+    int prefix = 0;
+    while (prefix < before.size() && prefix < after.size() && before[prefix] == after[prefix]) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < before.size() - prefix && suffix < after.size() - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+        ++suffix;
+    }
+    const int n = before.size() - prefix - suffix;
+    const int m = after.size() - prefix - suffix;
+    if (n == 0 && m == 0) {
+        return edits;
+    }
+
+    // Myers算法：v[k]为第d步在对角线k上走到的最远的x，每步结束后保存v[-d..d]用于回溯
+    const int                     offset = n + m + 1;
+    std::vector<int>              v(2 * offset + 1, 0);
+    std::vector<std::vector<int>> trace;
+    int                           distance = -1;
+    const int                     maxD     = qMin(n + m, kMaxEditDistance);
+    for (int d = 0; d <= maxD && distance < 0; ++d) {
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) ? v[offset + k + 1]
+                                                                                   : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && before[prefix + x] == after[prefix + y]) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                distance = d;
+            }
+        }
+        trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+    }
+
+    // 差异太大：中间部分整体替换
+    if (distance < 0) {
+        LineEdit edit;
+        edit.line    = prefix;
+        edit.removed = n;
+        edit.lines   = after.mid(prefix, m);
+        edits.append(edit);
+        return edits;
+    }
+
+    // 从终点回溯，得到逆序的删除（type 0，删除原文第a行）和插入（type 1，在原文第a行前插入新文第b行）
+    struct Op
+    {
+        int type;
+        int a;
+        int b;
+    };
+    std::vector<Op> ops;
+    int             x = n;
+    int             y = m;
+    for (int d = distance; d > 0; --d) {
+        const std::vector<int>& previous = trace[d - 1];
+        auto                    at       = [&previous, d](int k) { return previous[k + d - 1]; };
+        const int               k        = x - y;
+        const bool              down     = k == -d || (k != d && at(k - 1) < at(k + 1));
+        const int               prevK    = down ? k + 1 : k - 1;
+        const int               prevX    = at(prevK);
+        const int               prevY    = prevX - prevK;
+        if (down) {
+            ops.push_back(Op{1, prevX, prevY});
+        }
+        else {
+            ops.push_back(Op{0, prevX, prevY});
+        }
+        x = prevX;
+        y = prevY;
+    }
+
+    // 相邻的删除和插入合并为一段
+    for (auto it = ops.rbegin(); it != ops.rend(); ++it) {
+        const int line = prefix + it->a;
+        if (edits.isEmpty() || edits.last().line + edits.last().removed != line) {
+            LineEdit edit;
+            edit.line = line;
+            edits.append(edit);
+        }
+        if (it->type == 0) {
+            ++edits.last().removed;
+        }
+        else {
+            edits.last().lines.append(after[prefix + it->b]);
+        }
+    }
+    return edits;
+}
+
+int CodeFormatter::formatWithBlack(const QString& source, QString* formatted, QString* error)
+{
+    if (!PythonInterpreterManager::instance().isInitialized()) {
+        return 0;
+    }
+
+    // 用户代码运行期间在这里等待GIL，不影响界面线程
+    py::gil_scoped_acquire acquire;
+    try {
+        py::module_ black = py::module_::import("black");
+        py::object  mode  = black.attr("Mode")();
+        *formatted =
+            QString::fromStdString(black.attr("format_str")(source.toStdString(), py::arg("mode") = mode).cast<std::string>());
+        return 1;
+    }
+    catch (py::error_already_set& e) {
+        if (e.matches(PyExc_ImportError)) {
+            return 0;
+        }
+        *error = QString::fromStdString(e.what());
+        return -1;
+    }
+}
+
+void CodeFormatter::workerLoop()
+{
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_job || m_stopping; });
+            if (m_stopping) {
+                break;
+            }
+            job = std::move(m_job);
+        }
+
+        const QStringList before = job->text.split('\n');
+        QStringList       after;
+        QString           formatterName = "black";
+        QString           formatted;
+        QString           error;
+        const int         status = formatWithBlack(job->text, &formatted, &error);
+        if (status < 0) {
+            const quint64 revision = job->revision;
+            QMetaObject::invokeMethod(
+                this, [this, revision, error]() { emit failed(revision, error); }, Qt::QueuedConnection);
+            continue;
+        }
+        if (status > 0) {
+            after = formatted.split('\n');
+        }
+        else {
+            formatterName = "内置";
+            after         = basicFormat(before);
+        }
+
+        const QVector<LineEdit> edits    = diffLines(before, after);
+        const quint64           revision = job->revision;
+        QMetaObject::invokeMethod(
+            this,
+            [this, revision, edits, formatterName]() { emit finished(revision, edits, formatterName); },
+            Qt::QueuedConnection);
+    }
+}
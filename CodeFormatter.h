@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class CodeFormatter
+ * @brief 在后台线程中格式化代码，结果以逐行编辑的形式交给编辑器
+ *
+ * 已安装black时在嵌入的解释器中调用black.format_str（后台线程自行获取GIL），
+ * 未安装或解释器尚未就绪时使用内置的简单格式化（统一缩进、去掉行尾空白、合并连续空行）。
+ * 格式化前后的行用Myers差分算法比较，只输出有变化的行段，编辑器在一个编辑块中应用，
+ * 保留文档排版、撤销栈和高亮状态，界面线程的耗时只与改动的行数有关。
+ *
+ * format()只在界面线程中调用，finished()和failed()也在界面线程中发出；
+ * 后台线程只保留最新的一次请求。
+ */
+class CodeFormatter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 一段行编辑：把原文第line行起的removed行替换为lines（行号从0开始）
+     */
+    struct LineEdit
+    {
+        int         line    = 0;
+        int         removed = 0;
+        QStringList lines;
+    };
+
+    explicit CodeFormatter(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（停止后台线程）
+     */
+    ~CodeFormatter() override;
+
+    /**
+     * @brief 提交格式化
+     * @param text 代码
+     * @param revision 代码的版本，随结果原样返回，编辑器据此丢弃过期的结果
+     */
+    void format(const QString& text, quint64 revision);
+
+    /**
+     * @brief 内置的简单格式化：制表符缩进换成4个空格，去掉行尾空白，合并连续空行，去掉开头的空行
+     * @param lines 原文的行
+     * @return QStringList 格式化后的行
+     */
+    static QStringList basicFormat(const QStringList& lines);
+
+    /**
+     * @brief 比较两组行，输出把before变为after的行编辑（按行号排列，互不重叠）
+     *
+     * 先去掉相同的开头和结尾，中间部分用Myers算法；差异超过kMaxEditDistance行时
+     * 中间部分作为一段整体替换。
+     * @param before 原文的行
+     * @param after 新的行
+     * @return QVector<LineEdit> 行编辑
+     */
+    static QVector<LineEdit> diffLines(const QStringList& before, const QStringList& after);
+
+    // 差分算法搜索的最大编辑距离（行）
+    static const int kMaxEditDistance = 1024;
+
+signals:
+    /**
+     * @brief 格式化完成
+     * @param revision format()传入的版本
+     * @param edits 行编辑，没有变化时为空
+     * @param formatterName 使用的格式化工具（"black"或"内置"）
+     */
+    void finished(quint64 revision, const QVector<CodeFormatter::LineEdit>& edits, const QString& formatterName);
+
+    /**
+     * @brief 格式化失败（如代码有语法错误）
+     * @param revision format()传入的版本
+     * @param error 失败原因
+     */
+    void failed(quint64 revision, const QString& error);
+
+private:
+    // 一次格式化请求
+    struct Job
+    {
+        QString text;
+        quint64 revision = 0;
+    };
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void workerLoop();
+
+    /**
+     * @brief 用black格式化
+     * @param source 代码
+     * @param formatted 输出格式化后的代码
+     * @param error black报告错误时输出原因
+     * @return int 1成功，0未安装black或解释器未就绪，-1 black报告错误
+     */
+    static int formatWithBlack(const QString& source, QString* formatted, QString* error);
+
+private:
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    std::unique_ptr<Job>    m_job;
+    bool                    m_stopping = false;
+};
@@ -1,8 +1,13 @@
 #include "CodeRunner.h"
+#include "ExecutionRecording.h"
+#include "GilWaitMeter.h"
+#include "PythonHandles.h"
 #include "PythonInterpreterManager.h"
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QMetaObject>
 #include <QMetaType>
 #include <QMutex>
@@ -13,92 +18,927 @@
 #include <Python.h>
 #include <frameobject.h>
 
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @brief 一个线程的调试上下文
+ *
+ * 运行线程在运行开始时创建，用户线程在启动时登记（见CodeRunner::threadStarted()）。
+ * 追踪函数和sys.monitoring回调通过线程局部指针找到所属运行器，调用深度按线程分别计算，
+ * 一个线程中的调用和返回不会影响另一个线程的逐过程和跳出。
+ */
+struct CodeRunner::ThreadContext : std::enable_shared_from_this<CodeRunner::ThreadContext>
+{
+    CodeRunner*       runner = nullptr;   // 所属运行器，运行结束时清空（持有GIL和s_threadMutex时修改）
+    PyThreadState*    state  = nullptr;   // 线程状态，线程结束后清空（持有s_threadMutex时修改）
+    unsigned long     id     = 0;
+    QString           name;
+    bool              main      = false;   // 运行线程
+    int               callDepth = 0;       // 用户代码的调用深度（仅本线程访问）
+    int               stepDepth = 0;       // 最近一次从暂停恢复时的调用深度
+    std::vector<PyCodeObject*> stepCodes;  // 单步开始时栈上的用户代码，只比较地址（sys.monitoring后端）
+    std::atomic<bool> traceAttached{false};   // PyEval_SetTrace追踪函数是否已挂载在该线程上
+};
+
+// 当前线程的调试上下文，静态追踪函数和sys.monitoring回调据此找到运行器；
+// 每个运行器有自己的运行线程，多个编辑器标签页同时运行时互不干扰
+static thread_local CodeRunner::ThreadContext* t_context = nullptr;
+
+// 保护各运行器的线程列表和上下文中的runner、state（用户线程结束时不持有GIL）
+static QMutex s_threadMutex;
+
+/**
+ * @brief 用户线程持有自己的上下文，线程结束时通知运行器
+ */
+struct ThreadSlot
+{
+    std::shared_ptr<CodeRunner::ThreadContext> context;
+
+    ~ThreadSlot()
+    {
+        if (context) {
+            CodeRunner::threadExited(context.get());
+        }
+    }
+};
+
+static thread_local ThreadSlot t_threadSlot;
+
+// threading.settrace()安装的线程启动钩子，首次使用时创建（属于当前解释器，重新初始化前清除）
+static PyMethodDef s_threadStartDef  = {"qt_debug_thread_started", nullptr, METH_VARARGS, nullptr};
+static PyObject*   s_threadStartHook = nullptr;
+
+// 替换threading.Thread.start的包装，self为原来的方法：在启动线程中记下它的调试上下文，
+// 新线程据此登记到启动它的运行器
+static PyMethodDef s_threadStartingDef = {
+    "qt_debug_thread_start", nullptr, METH_VARARGS | METH_KEYWORDS, nullptr};
+
+// Thread对象上保存启动线程的调试上下文的属性
+static const char kThreadParentAttr[]    = "_qt_debug_parent";
+static const char kThreadParentCapsule[] = "qt_debug_parent";
+
+// 正在运行的运行器数，第一个开始时安装线程启动钩子，最后一个结束时移除（仅在持有GIL时访问）
+static int s_runningCount = 0;
+
+// 判断线程状态是否仍属于解释器中存活的线程（需持有GIL）；用户线程的状态在线程局部变量析构前就已删除
+static bool isLiveThread(PyThreadState* state, unsigned long id)
+{
+    if (!state) {
+        return false;
+    }
+    for (PyThreadState* thread = PyInterpreterState_ThreadHead(PyInterpreterState_Get()); thread;
+         thread = PyThreadState_Next(thread)) {
+        if (thread == state) {
+            return thread->thread_id == id;
+        }
+    }
+    return false;
+}
+
+// 接管全局Python输出的运行器（用户代码自己创建的线程没有绑定输出，输出到最近开始的运行器），仅在持有GIL时访问
+static CodeRunner* s_outputOwner = nullptr;
+
+// 运行器编号，用于区分各运行器的录制文件
+static std::atomic<int> s_runnerCount{0};
+
+// 软中止的宽限期，超时后升级为强制停止
+static const int kHardStopGraceMs = 2000;
+
+// 单调时钟（纳秒），用于统计中止响应时间
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 调试钩子的每次回调计为一个事件，耗时扣除期间暂停等待的时间
+struct CodeRunner::TraceTimer
+{
+    explicit TraceTimer(CodeRunner* runner)
+        : runner(runner)
+        , startNs(monotonicNs())
+        , pausedNs(runner->m_pausedNs)
+    {
+    }
+
+    ~TraceTimer()
+    {
+        runner->m_traceNs += monotonicNs() - startNs - (runner->m_pausedNs - pausedNs);
+        ++runner->m_traceEvents;
+    }
+
+    CodeRunner* runner;
+    qint64      startNs;
+    qint64      pausedNs;
+};
+
+// 代码对象extra槽中保存的分类标记（低两位）；用户代码的其余位保存最后一行的行号，0表示未知
+enum CodeKind : intptr_t
+{
+    CodeKindUnknown = 0,
+    CodeKindLibrary = 1,
+    CodeKindUser    = 2
+};
+
+static const int      kCodeKindBits = 2;
+static const intptr_t kCodeKindMask = (intptr_t(1) << kCodeKindBits) - 1;
 
-// 全局变量，用于在静态追踪函数中访问CodeRunner实例
-static CodeRunner* g_currentRunner = nullptr;
+// 代码对象extra槽索引，首次使用时向解释器申请（仅在持有GIL时访问）。
+// 属于当前解释器，重新初始化前由releasePythonState()清除
+static Py_ssize_t s_codeExtraIndex     = -1;
+static bool       s_codeExtraRequested = false;
+
+static Py_ssize_t codeExtraIndex()
+{
+    if (!s_codeExtraRequested) {
+        s_codeExtraIndex     = _PyEval_RequestCodeExtraIndex(nullptr);
+        s_codeExtraRequested = true;
+    }
+    return s_codeExtraIndex;
+}
 
 CodeRunner::CodeRunner(QObject* parent)
     : QObject(parent)
+    , m_asyncioLoop(new AsyncioLoop(this))
 {
-    g_currentRunner = this;
+    // 控制操作（挂载钩子）串行执行
+    m_controlPool.setMaxThreadCount(1);
+
+    // 同时录制的运行器各写自己的文件
+    const int index = s_runnerCount.fetch_add(1);
+    m_recordingPath = QDir::temp().filePath(
+        index == 0 ? QString("QtPythonEmbed-%1.pyrec").arg(QCoreApplication::applicationPid())
+                   : QString("QtPythonEmbed-%1-%2.pyrec").arg(QCoreApplication::applicationPid()).arg(index));
+
+    m_pythonOutput = [this](int stream, const char* data, int size) { writeOutput(stream, data, size); };
+    m_input.setWaitHandler([this](bool waiting) { emit inputWaitChanged(waiting); });
 
     qRegisterMetaType<QSet<int>>("QSet<int>");
     qRegisterMetaType<CodeRunner::DebugState>("CodeRunner::DebugState");
+    qRegisterMetaType<CodeRunner::RunSummary>("CodeRunner::RunSummary");
+    qRegisterMetaType<QVector<CodeRunner::DebugThread>>("QVector<CodeRunner::DebugThread>");
+    qRegisterMetaType<VariableInspector::Page>("VariableInspector::Page");
+    qRegisterMetaType<QVector<WatchList::Value>>("QVector<WatchList::Value>");
 }
 
 CodeRunner::~CodeRunner()
 {
     abortExecution();
+    m_controlPool.waitForDone();
+
+    delete m_breakpoints.exchange(nullptr);
+
+    // 注销sys.monitoring回调需要GIL
+    if (m_monitoringHook && Py_IsInitialized()) {
+        py::gil_scoped_acquire acquire;
+        m_monitoringHook.reset();
+    }
+}
+
+std::shared_ptr<LineChannel> CodeRunner::lineChannel() const
+{
+    return std::atomic_load(&m_lineChannel);
+}
+
+std::shared_ptr<FrameChannel> CodeRunner::frameChannel() const
+{
+    QMutexLocker locker(&m_frameMutex);
+    if (!m_frameChannel) {
+        m_frameChannel = FrameChannel::createLocal();
+    }
+    return m_frameChannel;
+}
+
+void CodeRunner::setFrameChannel(std::shared_ptr<FrameChannel> channel)
+{
+    QMutexLocker locker(&m_frameMutex);
+    m_frameChannel = std::move(channel);
+}
+
+std::shared_ptr<LineProfile> CodeRunner::lineProfile() const
+{
+    return std::atomic_load(&m_lineProfile);
+}
+
+std::shared_ptr<FlameGraph> CodeRunner::flameGraph() const
+{
+    return std::atomic_load(&m_flameGraph);
+}
+
+std::shared_ptr<MemoryReport> CodeRunner::memoryReport() const
+{
+    return std::atomic_load(&m_memoryReport);
+}
+
+void CodeRunner::setRecordingPath(const QString& path)
+{
+    QMutexLocker locker(&m_recordingMutex);
+    m_recordingPath = path;
+}
+
+void CodeRunner::setNamespaceContext(const QString& context)
+{
+    QMutexLocker locker(&m_recordingMutex);
+    m_namespaceContext = context;
+}
+
+std::shared_ptr<ExecutionRecording> CodeRunner::recording() const
+{
+    return std::atomic_load(&m_recordingResult);
 }
 
 void CodeRunner::runCode(const QString& code)
 {
-    if (m_isExecuting) {
-        qWarning() << "Code execution already in progress";
+    RunScheduler::Request request;
+    request.code      = code;
+    request.priority  = RunScheduler::Interactive;
+    request.profiling = m_profilingRequested;
+    request.sampling  = m_samplingRequested;
+    request.memory    = m_memoryRequested;
+    {
+        QMutexLocker locker(&m_budgetMutex);
+        request.budgets = m_budgets;
+    }
+    submitRun(request);
+}
+
+void CodeRunner::setBudgets(const RunWatchdog::Budgets& budgets)
+{
+    QMutexLocker locker(&m_budgetMutex);
+    m_budgets = budgets;
+}
+
+std::shared_ptr<RunScheduler::Ticket> CodeRunner::submitRun(const RunScheduler::Request& request)
+{
+    std::shared_ptr<RunScheduler::Ticket> ticket = m_scheduler.submit(request);
+    emit queueChanged(m_scheduler.depth());
+
+    // 在运行器所在线程中调度，调用线程不会阻塞
+    QMetaObject::invokeMethod(this, [this]() { dispatchNextRun(); }, Qt::QueuedConnection);
+    return ticket;
+}
+
+void CodeRunner::cancelRun(int ticketId)
+{
+    if (m_scheduler.cancel(ticketId) == RunScheduler::Running) {
+        abortExecution();
+    }
+    emit queueChanged(m_scheduler.depth());
+}
+
+void CodeRunner::dispatchNextRun()
+{
+    RunScheduler::Request                 request;
+    std::shared_ptr<RunScheduler::Ticket> ticket = m_scheduler.begin(&request);
+    if (!ticket) {
         return;
     }
 
-    m_shouldAbort = false;
-    m_isExecuting = true;
+    emit queueChanged(m_scheduler.depth());
+    beginRun(request);
+}
 
-    // 在事件循环中异步执行，避免阻塞UI线程
-    QMetaObject::invokeMethod(
-        this, [this, code]() { executePythonCodeSafely(code); }, Qt::QueuedConnection);
+void CodeRunner::beginRun(const RunScheduler::Request& request)
+{
+    m_isExecuting      = true;
+    m_shouldAbort      = false;
+    m_hardStop         = false;
+    m_abortRequestedNs = 0;
+
+    executePythonCodeSafely(request.code,
+                            request.profiling,
+                            request.sampling,
+                            request.memory,
+                            request.objects,
+                            request.recording,
+                            request.recordLocals,
+                            request.budgets);
+    finishRun();
+}
+
+void CodeRunner::finishRun()
+{
+    m_scheduler.finish();
+    QMetaObject::invokeMethod(this, [this]() { dispatchNextRun(); }, Qt::QueuedConnection);
 }
 
 void CodeRunner::abortExecution()
 {
-    m_shouldAbort = true;
+    if (m_shouldAbort.exchange(true)) {
+        return;
+    }
 
-    // 唤醒可能正在等待的调试线程
-    QMutexLocker locker(&m_debugMutex);
-    m_debugCondition.wakeAll();
+    {
+        // 唤醒可能正在等待的调试线程
+        QMutexLocker locker(&m_debugMutex);
+        m_debugCondition.wakeAll();
+    }
+
+    {
+        // 与运行结束时清除中断互斥：运行已结束时不再打断，不会留下无人清除的中断标志
+        QMutexLocker locker(&m_abortMutex);
+        if (!m_isExecuting) {
+            return;
+        }
+
+        m_abortRequestedNs = monotonicNs();
+
+        // 唤醒可中断的time.sleep和等待输入的读取（等待输出空间的写入会在50毫秒内自行检查中止标志）；
+        // 本次运行启动的线程继承了同一个中断门，其他运行器的线程不受影响
+        m_interruptGate->interrupt();
+        m_input.interrupt();
+    }
+
+    m_controlPool.start([this]() { superviseAbort(); });
+}
+
+void CodeRunner::writeInput(const QByteArray& data)
+{
+    m_input.write(data);
+}
+
+void CodeRunner::closeInput()
+{
+    m_input.close();
+}
+
+void CodeRunner::superviseAbort()
+{
+    {
+        py::gil_scoped_acquire acquire;
+        raiseAbortException();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (m_isExecuting && m_shouldAbort) {
+        QThread::msleep(10);
+
+        if (!m_hardStop && timer.elapsed() >= kHardStopGraceMs) {
+            // 代码捕获了中止异常或仍在长时间运行：挂载钩子，每个事件都重新抛出
+            m_hardStop = true;
+
+            py::gil_scoped_acquire acquire;
+            if (m_threadState && m_mainThread && !m_mainThread->traceAttached) {
+                attachTraceHook(m_mainThread.get());
+            }
+            raiseAbortException();
+        }
+    }
+}
+
+void CodeRunner::releasePythonState()
+{
+    m_asyncioLoop->close();
+
+    // 断点表中已编译的条件属于旧解释器，换成尚未编译的新表
+    {
+        QMutexLocker locker(&m_breakpointMutex);
+        m_retiredBreakpoints.clear();
+        const BreakpointTable* table =
+            m_breakpointList.isEmpty() ? nullptr : new BreakpointTable(m_breakpointList);
+        delete m_breakpoints.exchange(table, std::memory_order_acq_rel);
+    }
+
+    // 监视表达式在下次暂停时重新编译
+    {
+        QMutexLocker locker(&m_debugMutex);
+        m_watchesChanged = !m_watchExpressions.isEmpty();
+    }
+
+    if (!Py_IsInitialized()) {
+        return;
+    }
+
+    py::gil_scoped_acquire acquire;
+    m_watchList.setExpressions(QStringList());
+    m_variableInspector.release();
+    m_memoryProfiler.release();
+    m_monitoringHook.reset();
+    m_monitoringAttached = false;
+    Py_CLEAR(s_threadStartHook);
+    s_codeExtraRequested = false;
 }
 
-void CodeRunner::setExecutionDelay(int delayMs)
+void CodeRunner::raiseAbortException()
 {
-    m_executionDelay = delayMs;
+    // 持有GIL时m_threadState是稳定的，为空表示运行已结束
+    if (m_threadState && m_shouldAbort) {
+        PyThreadState_SetAsyncExc(m_threadId, PyExc_KeyboardInterrupt);
+    }
 }
 
-void CodeRunner::setBreakpoints(const QSet<int>& breakpoints)
+void CodeRunner::setBreakpoints(const QVector<Breakpoint>& breakpoints)
 {
-    m_breakpoints = breakpoints;
+    {
+        QMutexLocker locker(&m_breakpointMutex);
+        m_breakpointList = breakpoints;
+
+        // 没有代码在执行时，追踪函数不可能持有旧表，可以安全回收
+        if (!m_isExecuting) {
+            m_retiredBreakpoints.clear();
+        }
+
+        // 发布新的不可变断点表，旧表延迟到空闲时回收
+        const BreakpointTable* table =
+            breakpoints.isEmpty() ? nullptr : new BreakpointTable(breakpoints);
+        const BreakpointTable* previous = m_breakpoints.exchange(table, std::memory_order_acq_rel);
+        if (previous) {
+            m_retiredBreakpoints.emplace_back(previous);
+        }
+    }
+
+    // 运行过程中设置了断点，按需挂载追踪钩子
+    if (!breakpoints.isEmpty()) {
+        requestTraceHook();
+    }
+}
+
+void CodeRunner::setBreakpoints(const QSet<int>& lines)
+{
+    QVector<Breakpoint> breakpoints;
+    breakpoints.reserve(lines.size());
+    for (int line : lines) {
+        Breakpoint breakpoint;
+        breakpoint.line = line;
+        breakpoints.append(breakpoint);
+    }
+    setBreakpoints(breakpoints);
 }
 
 bool CodeRunner::isBreakpoint(int lineNumber) const
 {
-    return m_breakpoints.contains(lineNumber);
+    const BreakpointTable* table = m_breakpoints.load(std::memory_order_acquire);
+    return table && table->contains(lineNumber);
+}
+
+bool CodeRunner::shouldBreak(PyFrameObject* frame, int lineNumber)
+{
+    const BreakpointTable* table = m_breakpoints.load(std::memory_order_acquire);
+    if (!table || !table->contains(lineNumber)) {
+        return false;
+    }
+
+    // 条件出错时把错误写到标准错误并暂停，便于检查出错时的变量
+    QString                       error;
+    QByteArray                    log;
+    const BreakpointTable::Action action = table->evaluate(lineNumber, frame, &error, &log);
+    if (!error.isEmpty()) {
+        const QByteArray message =
+            QString("第%1行的断点条件出错：%2\n").arg(lineNumber).arg(error).toUtf8();
+        writeOutput(OutputChannel::StdErr, message.constData(), message.size());
+    }
+    if (action == BreakpointTable::Log) {
+        writeLogpoint(lineNumber, log);
+    }
+    return action == BreakpointTable::Pause;
+}
+
+void CodeRunner::writeLogpoint(int lineNumber, const QByteArray& message)
+{
+    ++m_logpointHits;
+
+    QByteArray record;
+    record.reserve(message.size() + 16);
+    record.append('[').append(QByteArray::number(lineNumber)).append("] ").append(message).append('\n');
+
+    // 日志点可能每秒命中成千上万次，跟不上时丢弃而不是反压到用户代码
+    bool wake = false;
+    if (!m_outputChannel.tryWriteAll(OutputChannel::Log, record.constData(), record.size(), &wake)) {
+        ++m_logpointsDropped;
+        return;
+    }
+    if (wake) {
+        emit outputReady();
+    }
+}
+
+bool CodeRunner::isTraceHookRequired() const
+{
+    return m_breakpoints.load(std::memory_order_acquire) != nullptr ||
+           m_debugState.load(std::memory_order_acquire) != Running ||
+           m_hardStop.load(std::memory_order_acquire) ||
+           m_profiling.load(std::memory_order_acquire) ||
+           m_recording.load(std::memory_order_acquire);
+}
+
+bool CodeRunner::isTraceHookRequired(const ThreadContext* context) const
+{
+    if (context->main && (m_hardStop.load(std::memory_order_acquire) || m_profiling.load(std::memory_order_acquire) ||
+                          m_recording.load(std::memory_order_acquire))) {
+        return true;
+    }
+    return isDebugTarget(context) && (m_breakpoints.load(std::memory_order_acquire) != nullptr ||
+                                      m_debugState.load(std::memory_order_acquire) != Running);
+}
+
+bool CodeRunner::isDebugTarget(const ThreadContext* context) const
+{
+    const unsigned long selected = m_selectedThread.load(std::memory_order_acquire);
+    return selected == 0 ? context->main : context->id == selected;
+}
+
+bool CodeRunner::shouldStep(const ThreadContext* context, DebugState state) const
+{
+    // 单步命令由另一个线程的暂停发出时（切换了调试线程），没有可比较的深度，在下一行暂停
+    if (m_steppingThread.load(std::memory_order_acquire) != context->id) {
+        return true;
+    }
+    switch (state) {
+    case StepOver:
+        // 逐过程：被调用的函数返回之前不暂停
+        return context->callDepth <= context->stepDepth;
+    case StepOut:
+        // 跳出：回到调用者之后暂停
+        return context->callDepth < context->stepDepth;
+    default:
+        return true;
+    }
+}
+
+void CodeRunner::requestTraceHook()
+{
+    // 追踪函数按线程挂载，sys.monitoring后端在断点或状态变化时都需要刷新事件，
+    // 是否已挂载在控制线程中判断
+    if (!m_isExecuting) {
+        return;
+    }
+
+    m_controlPool.start([this]() {
+        py::gil_scoped_acquire acquire;
+
+        // 持有GIL时m_threadState是稳定的：运行线程在释放GIL前会将其清空
+        if (m_threadState && isTraceHookRequired()) {
+            attachDebugHook();
+        }
+    });
+}
+
+void CodeRunner::selectDebugBackend()
+{
+    DebugBackend backend = TraceBackend;
+
+    // 分析和录制运行需要每个行事件，sys.monitoring关闭事件的做法不适用
+    if (m_preferredBackend == MonitoringBackend && !m_profiling && !m_recording &&
+        PythonInterpreterManager::instance().hasSysMonitoring()) {
+        if (!m_monitoringHook) {
+            m_monitoringHook.reset(new MonitoringHook(monitorLine, monitorFrame));
+        }
+        if (m_monitoringHook->acquire()) {
+            backend = MonitoringBackend;
+        }
+    }
+
+    m_activeBackend = backend;
+}
+
+void CodeRunner::attachDebugHook()
+{
+    QMutexLocker locker(&s_threadMutex);
+    if (m_activeBackend == MonitoringBackend) {
+        const bool stepping = m_debugState.load(std::memory_order_acquire) != Running;
+        m_monitoringHook->activate(stepping);
+        for (const std::shared_ptr<ThreadContext>& context : m_threads) {
+            if (isDebugTarget(context.get()) && isLiveThread(context->state, context->id)) {
+                armRunningFrames(context->state);
+            }
+        }
+        m_monitoringHook->restart();
+        m_monitoringAttached = true;
+        return;
+    }
+
+    // 只在需要的线程上挂载，其余线程以原速运行；不再需要的线程在下一个事件中自行卸载
+    for (const std::shared_ptr<ThreadContext>& context : m_threads) {
+        if (!context->traceAttached && isTraceHookRequired(context.get()) &&
+            isLiveThread(context->state, context->id)) {
+            attachTraceHook(context.get());
+        }
+    }
+}
+
+void CodeRunner::attachTraceHook(ThreadContext* context)
+{
+    context->traceAttached = true;
+#if PY_VERSION_HEX < 0x030D0000
+    _PyEval_SetTrace(context->state, pythonTraceFunction, nullptr);
+#else
+    // 不需要追踪的线程在下一个事件中由追踪函数自行卸载
+    PyEval_SetTraceAllThreads(pythonTraceFunction, nullptr);
+#endif
+}
+
+void CodeRunner::armRunningFrames(PyThreadState* state)
+{
+    PyFrameObject* frame = PyThreadState_GetFrame(state);
+    while (frame) {
+        PyCodeObject* code = PyFrame_GetCode(frame);
+        if (isUserCode(code)) {
+            m_monitoringHook->arm(code);
+        }
+        Py_DECREF(code);
+
+        PyFrameObject* back = PyFrame_GetBack(frame);
+        Py_DECREF(frame);
+        frame = back;
+    }
+}
+
+bool CodeRunner::releaseTraceHookIfIdle(ThreadContext* context)
+{
+    if (isTraceHookRequired(context)) {
+        return false;
+    }
+
+    context->traceAttached = false;
+
+    // 先清除标志再复查，避免与UI线程并发设置断点时丢失挂载请求
+    if (isTraceHookRequired(context)) {
+        context->traceAttached = true;
+        return false;
+    }
+
+    PyEval_SetTrace(nullptr, nullptr);
+    return true;
+}
+
+void CodeRunner::detachTraceHook()
+{
+    // 运行已结束，清除可能尚未触发的中止异常，避免影响下一次运行
+    if (m_shouldAbort && m_threadState) {
+        PyThreadState_SetAsyncExc(m_threadId, nullptr);
+    }
+
+    PyEval_SetTrace(nullptr, nullptr);
+
+    if (m_monitoringAttached) {
+        m_monitoringHook->deactivate();
+        m_monitoringAttached = false;
+    }
+
+    // 用户线程可能比运行活得更久（如没有关闭的线程池），卸载其追踪函数并解除与运行器的关联；
+    // Python 3.13起不能卸载其他线程的追踪函数，解除关联后由追踪函数在该线程的下一个事件中自行卸载
+    {
+        QMutexLocker locker(&s_threadMutex);
+        for (const std::shared_ptr<ThreadContext>& context : m_threads) {
+#if PY_VERSION_HEX < 0x030D0000
+            if (!context->main && context->traceAttached && isLiveThread(context->state, context->id)) {
+                _PyEval_SetTrace(context->state, nullptr, nullptr);
+            }
+#endif
+            context->traceAttached = false;
+            context->runner        = nullptr;
+        }
+        m_threads.clear();
+        emit debugThreadsChanged(QVector<DebugThread>());
+    }
+    m_mainThread.reset();
+    t_context = nullptr;
+
+    m_profiling      = false;
+    m_activeProfile  = nullptr;
+    m_recording      = false;
+    m_activeRecorder = nullptr;
+    m_threadState    = nullptr;
+}
+
+void CodeRunner::pauseExecution()
+{
+    // 逐语句状态会在下一行停下
+    DebugState expected = Running;
+    if (!m_debugState.compare_exchange_strong(expected, StepInto)) {
+        return;
+    }
+    emit debugStateChanged(StepInto);
+
+    requestTraceHook();
+}
+
+void CodeRunner::selectDebugThread(unsigned long id)
+{
+    m_selectedThread.store(id, std::memory_order_release);
+
+    // 新选中的线程按需挂载钩子，原来的线程在下一个事件中自行卸载
+    requestTraceHook();
+}
+
+void CodeRunner::registerThread()
+{
+    // 运行已经结束（钩子尚未移除时启动的线程）
+    if (!m_mainThread) {
+        return;
+    }
+
+    std::shared_ptr<ThreadContext> context = std::make_shared<ThreadContext>();
+    context->runner = this;
+    context->state  = PyThreadState_Get();
+    context->id     = PyThread_get_thread_ident();
+    try {
+        context->name = QString::fromStdString(
+            py::module_::import("threading").attr("current_thread")().attr("name").cast<std::string>());
+    }
+    catch (py::error_already_set&) {
+        context->name = QString("Thread-%1").arg(context->id);
+    }
+    t_threadSlot.context = context;
+    t_context            = context.get();
+
+    // time.sleep在本运行器的中断门上等待，只有本运行器中止时被打断
+    PythonInterpreterManager::bindCurrentThreadGate(m_interruptGate);
+
+    // 新线程不是选中的调试线程，不挂载追踪函数；运行中被选中时由attachDebugHook()挂载
+    QMutexLocker locker(&s_threadMutex);
+    m_threads.push_back(context);
+    emit debugThreadsChanged(debugThreads());
+}
+
+void CodeRunner::threadExited(ThreadContext* context)
+{
+    QMutexLocker locker(&s_threadMutex);
+    context->state     = nullptr;
+    CodeRunner* runner = context->runner;
+    if (!runner) {
+        return;
+    }
+    context->runner = nullptr;
+
+    auto found = std::find_if(runner->m_threads.begin(),
+                              runner->m_threads.end(),
+                              [context](const std::shared_ptr<ThreadContext>& item) { return item.get() == context; });
+    if (found != runner->m_threads.end()) {
+        runner->m_threads.erase(found);
+    }
+
+    // 选中的线程结束后回到运行线程
+    unsigned long expected = context->id;
+    runner->m_selectedThread.compare_exchange_strong(expected, 0);
+    emit runner->debugThreadsChanged(runner->debugThreads());
+}
+
+QVector<CodeRunner::DebugThread> CodeRunner::debugThreads() const
+{
+    QVector<DebugThread> threads;
+    threads.reserve(static_cast<int>(m_threads.size()));
+    for (const std::shared_ptr<ThreadContext>& context : m_threads) {
+        DebugThread thread;
+        thread.id   = context->id;
+        thread.name = context->name;
+        thread.main = context->main;
+        threads.append(thread);
+    }
+    return threads;
+}
+
+PyObject* CodeRunner::threadStarted(PyObject* self, PyObject* args)
+{
+    Q_UNUSED(self);
+    Q_UNUSED(args);
+
+    // threading在新线程中调用sys.settrace()，第一个调用事件到达这里；之后的事件由运行器决定是否追踪
+    PyEval_SetTrace(nullptr, nullptr);
+
+    // 登记到启动本线程的线程所属的运行器（Thread.start()的包装记下了它的调试上下文），
+    // 不是运行中的代码启动的线程不登记；同时运行的其他运行器不受影响
+    CodeRunner* runner = nullptr;
+    if (PyObject* threading = PyImport_ImportModule("threading")) {
+        PyObject* thread  = PyObject_CallMethod(threading, "current_thread", nullptr);
+        PyObject* capsule = thread ? PyObject_GetAttrString(thread, kThreadParentAttr) : nullptr;
+        if (capsule && PyCapsule_IsValid(capsule, kThreadParentCapsule)) {
+            const auto* parent =
+                static_cast<std::shared_ptr<ThreadContext>*>(PyCapsule_GetPointer(capsule, kThreadParentCapsule));
+            QMutexLocker locker(&s_threadMutex);
+            runner = (*parent)->runner;
+        }
+        if (capsule) {
+            PyObject_DelAttrString(thread, kThreadParentAttr);
+        }
+        Py_XDECREF(capsule);
+        Py_XDECREF(thread);
+        Py_DECREF(threading);
+    }
+    PyErr_Clear();
+
+    // 持有GIL时运行器不会解除与上下文的关联
+    if (runner) {
+        runner->registerThread();
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* CodeRunner::threadStarting(PyObject* self, PyObject* args, PyObject* kwargs)
+{
+    // 运行线程或已登记的用户线程启动新线程：把自己的调试上下文记在Thread对象上
+    ThreadContext* context = t_context;
+    if (context && context->runner && PyTuple_GET_SIZE(args) > 0) {
+        auto*     parent  = new std::shared_ptr<ThreadContext>(context->shared_from_this());
+        PyObject* capsule = PyCapsule_New(parent, kThreadParentCapsule, [](PyObject* object) {
+            delete static_cast<std::shared_ptr<ThreadContext>*>(PyCapsule_GetPointer(object, kThreadParentCapsule));
+        });
+        if (!capsule) {
+            delete parent;
+        }
+        else if (PyObject_SetAttrString(PyTuple_GET_ITEM(args, 0), kThreadParentAttr, capsule) < 0) {
+            PyErr_Clear();
+        }
+        Py_XDECREF(capsule);
+    }
+
+    // self是原来的Thread.start
+    return PyObject_Call(self, args, kwargs);
+}
+
+void CodeRunner::setThreadStartHook(bool install)
+{
+    PyObject *errType, *errValue, *errTraceback;
+    PyErr_Fetch(&errType, &errValue, &errTraceback);
+
+    if (!s_threadStartHook && install) {
+        s_threadStartDef.ml_meth = threadStarted;
+        s_threadStartHook        = PyCFunction_New(&s_threadStartDef, nullptr);
+    }
+
+    // 用户代码或其他调试器安装的钩子保持原样
+    if (PyObject* threading = s_threadStartHook ? PyImport_ImportModule("threading") : nullptr) {
+        // Thread.start()的包装在第一次安装时替换，之后保留：没有运行时只多一次函数调用
+        PyObject* threadType = install ? PyObject_GetAttrString(threading, "Thread") : nullptr;
+        PyObject* start      = threadType ? PyObject_GetAttrString(threadType, "start") : nullptr;
+        const auto wrapper   = reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(threadStarting));
+        if (start && !(PyCFunction_Check(start) && PyCFunction_GET_FUNCTION(start) == wrapper)) {
+            s_threadStartingDef.ml_meth = wrapper;
+            PyObject* function = PyCFunction_New(&s_threadStartingDef, start);
+            PyObject* method   = function ? PyInstanceMethod_New(function) : nullptr;
+            if (method) {
+                PyObject_SetAttrString(threadType, "start", method);
+            }
+            Py_XDECREF(method);
+            Py_XDECREF(function);
+        }
+        Py_XDECREF(start);
+        Py_XDECREF(threadType);
+
+        PyObject* current = PyObject_CallMethod(threading, "gettrace", nullptr);
+        if (current && (current == Py_None || current == s_threadStartHook)) {
+            PyObject* result = PyObject_CallMethod(threading, "settrace", "O", install ? s_threadStartHook : Py_None);
+            Py_XDECREF(result);
+        }
+        Py_XDECREF(current);
+        Py_DECREF(threading);
+    }
+    PyErr_Clear();
+
+    PyErr_Restore(errType, errValue, errTraceback);
+}
+
+void CodeRunner::requestVariables(quint64 handle, int start, int count)
+{
+    QMutexLocker locker(&m_debugMutex);
+    if (m_debugState.load(std::memory_order_acquire) != Paused) {
+        return;
+    }
+    m_variableRequests.append({handle, start, count});
+    m_debugCondition.wakeAll();
+}
+
+void CodeRunner::setWatchExpressions(const QStringList& expressions)
+{
+    QMutexLocker locker(&m_debugMutex);
+    m_watchExpressions = expressions;
+    m_watchesChanged   = true;
+    m_debugCondition.wakeAll();
 }
 
 void CodeRunner::continueExecution()
 {
     QMutexLocker locker(&m_debugMutex);
-    m_debugState = Running;
-    emit debugStateChanged(m_debugState);
+    m_debugState.store(Running, std::memory_order_release);
+    emit debugStateChanged(Running);
     m_debugCondition.wakeAll();
 }
 
 void CodeRunner::stepInto()
 {
     QMutexLocker locker(&m_debugMutex);
-    m_debugState = StepInto;
-    emit debugStateChanged(m_debugState);
+    m_debugState.store(StepInto, std::memory_order_release);
+    emit debugStateChanged(StepInto);
     m_debugCondition.wakeAll();
 }
 
 void CodeRunner::stepOver()
 {
     QMutexLocker locker(&m_debugMutex);
-    m_debugState = StepOver;
-    emit debugStateChanged(m_debugState);
+    m_debugState.store(StepOver, std::memory_order_release);
+    emit debugStateChanged(StepOver);
     m_debugCondition.wakeAll();
 }
 
 void CodeRunner::stepOut()
 {
     QMutexLocker locker(&m_debugMutex);
-    m_debugState = StepOut;
-    emit debugStateChanged(m_debugState);
+    m_debugState.store(StepOut, std::memory_order_release);
+    emit debugStateChanged(StepOut);
     m_debugCondition.wakeAll();
 }
 
@@ -107,130 +947,545 @@ int CodeRunner::pythonTraceFunction(PyObject* obj, PyFrameObject* frame, int eve
     Q_UNUSED(obj);
     Q_UNUSED(arg);
 
-    if (!g_currentRunner || g_currentRunner->m_shouldAbort || !frame) {
+    // 快速路径只读取原子变量，不获取任何锁
+    ThreadContext* context = t_context;
+    CodeRunner*    runner  = context ? context->runner : nullptr;
+    if (!runner) {
+        // 不属于任何运行的线程（PyEval_SetTraceAllThreads挂载到了所有线程，或运行已结束）：卸载钩子
+        PyEval_SetTrace(nullptr, nullptr);
         return 0;
     }
+    if (!frame) {
+        return 0;
+    }
+    TraceTimer timer(runner);
 
-    // 获取当前执行的文件名
-    PyObject* filename   = frame->f_code->co_filename;
-    bool      isUserCode = false;
+    if (runner->m_shouldAbort.load(std::memory_order_relaxed)) {
+        // 强制停止：在每个事件上抛出异常，except和finally中的代码也会被打断
+        if (runner->m_hardStop.load(std::memory_order_relaxed)) {
+            PyErr_SetString(PyExc_KeyboardInterrupt, "Execution stopped");
+            return -1;
+        }
+        return 0;
+    }
 
-    if (filename && PyUnicode_Check(filename)) {
-        const char* filenameStr = PyUnicode_AsUTF8(filename);
-        // 过滤：只处理用户代码，通常通过exec或eval执行的代码文件名为"<string>"或"<module>"
-        QString filenameQStr = QString::fromUtf8(filenameStr);
-        if (filenameQStr == "<string>" || filenameQStr == "<module>") {
-            isUserCode = true;
+    // 没有断点且不在暂停/单步状态、或者不再是调试线程时卸载钩子，回到无追踪的全速运行
+    if (runner->releaseTraceHookIfIdle(context)) {
+        return 0;
+    }
+
+    // 库代码（标准库、site-packages）的栈帧关闭行事件后直接返回，
+    // 只有编辑器中的代码保留逐行追踪
+    if (!isUserFrame(frame)) {
+        if (event == PyTrace_CALL) {
+            setLineEvents(frame, false);
         }
+        return 0;
     }
 
     int lineNumber = PyFrame_GetLineNumber(frame);
 
-    // 只在执行用户代码时发送lineExecuted信号
-    if (isUserCode) {
-        // 使用Qt的invokeMethod在主线程中发出信号
-        QMetaObject::invokeMethod(
-            g_currentRunner,
-            [lineNumber]() { emit g_currentRunner->lineExecuted(lineNumber); },
-            Qt::DirectConnection);
+    // 逐行统计和录制只记录运行线程
+    if (context->main) {
+        if (runner->m_activeProfile) {
+            runner->profileEvent(event, lineNumber);
+        }
+
+        if (runner->m_activeRecorder) {
+            runner->m_activeRecorder->record(event, frame, lineNumber);
+            // 记录变量时求repr可能取走刚到达的中止异常，重新设置
+            if (runner->m_shouldAbort.load(std::memory_order_relaxed)) {
+                PyThreadState_SetAsyncExc(runner->m_threadId, PyExc_KeyboardInterrupt);
+            }
+        }
     }
 
-    // 检查是否是断点，只在执行用户代码时检查
-    if (isUserCode && g_currentRunner->isBreakpoint(lineNumber) &&
-        g_currentRunner->m_debugState == Running) {
-        QMutexLocker locker(&g_currentRunner->m_debugMutex);
-        g_currentRunner->m_debugState = Paused;
-        emit g_currentRunner->debugStateChanged(g_currentRunner->m_debugState);
-        g_currentRunner->m_debugCondition.wait(&g_currentRunner->m_debugMutex);
+    // 处理函数调用和返回事件，调用深度按线程计算
+    if (event == PyTrace_CALL) {
+        context->callDepth++;
+    }
+    else if (event == PyTrace_RETURN) {
+        context->callDepth--;
+    }
 
-        // 检查是否需要中止
-        if (g_currentRunner->m_shouldAbort) {
-            return 0;
-        }
+    // 分析或录制时运行线程不是调试线程，不显示执行行、不检查断点
+    if (!runner->isDebugTarget(context)) {
+        return 0;
+    }
+
+    // 行事件只写入执行行通道，由编辑器按刷新率采样
+    if (event == PyTrace_LINE) {
+        runner->m_activeLineChannel->record(lineNumber);
     }
 
-    // 处理调试状态
-    QMutexLocker locker(&g_currentRunner->m_debugMutex);
+    DebugState state       = runner->m_debugState.load(std::memory_order_acquire);
+    bool       shouldPause = false;
 
-    // 检查是否需要中止
-    if (g_currentRunner->m_shouldAbort) {
+    // 逐过程和跳出：目标栈帧之下新调用的函数关闭行事件，只产生调用和返回事件用于计算深度，
+    // 被跳过的函数不再逐行进入追踪函数；暂停时prepareStep()重新开启栈上各帧的行事件
+    if (event == PyTrace_CALL && (state == StepOver || state == StepOut) &&
+        !runner->shouldStep(context, state) && runner->canSkipLines(context, frame)) {
+        setLineEvents(frame, false);
         return 0;
     }
 
-    // 保存当前调试状态
-    DebugState currentState = g_currentRunner->m_debugState;
+    switch (state) {
+    case Running:
+        // 断点只在行事件上检查，查表无锁；命中次数和条件只在断点行上计算
+        shouldPause = event == PyTrace_LINE && runner->shouldBreak(frame, lineNumber);
+        break;
+    case Paused:
+        shouldPause = true;
+        break;
+    case StepInto:
+    case StepOver:
+    case StepOut:
+        // 逐语句：执行到下一行后暂停；逐过程和跳出按本线程的调用深度跳过函数内部，
+        // 被跳过的函数中的断点照常命中
+        shouldPause = event == PyTrace_LINE &&
+                      (runner->shouldStep(context, state) || runner->shouldBreak(frame, lineNumber));
+        break;
+    }
 
-    // 处理暂停状态
-    if (currentState == Paused) {
-        // 已经暂停，等待调试命令
-        emit g_currentRunner->debugStateChanged(g_currentRunner->m_debugState);
-        g_currentRunner->m_debugCondition.wait(&g_currentRunner->m_debugMutex);
+    // 只有真正需要暂停时才使用互斥量和条件变量
+    if (shouldPause) {
+        runner->pauseAndWait(lineNumber);
+    }
 
-        // 检查是否需要中止
-        if (g_currentRunner->m_shouldAbort) {
-            return 0;
-        }
+    // 只有设置了异常时才能返回非0
+    return 0;
+}
 
-        // 更新当前状态为用户选择的调试命令
-        currentState = g_currentRunner->m_debugState;
+void CodeRunner::finishRecording()
+{
+    if (!m_recorder.isRecording()) {
+        return;
     }
 
-    // 处理函数调用和返回事件
-    if (event == PyTrace_CALL) {
-        g_currentRunner->m_callDepth++;
+    // 等待后台线程写完并建立检查点；失败时只报告，不影响运行结果
+    std::shared_ptr<ExecutionRecording> result = m_recorder.stop();
+    if (!result) {
+        const QByteArray message = (m_recorder.errorString() + "\n").toUtf8();
+        writeOutput(OutputChannel::StdErr, message.constData(), message.size());
     }
-    else if (event == PyTrace_RETURN) {
-        g_currentRunner->m_callDepth--;
+    std::atomic_store(&m_recordingResult, result);
+}
+
+void CodeRunner::releaseOutput()
+{
+    PythonInterpreterManager::bindCurrentThread(nullptr, nullptr);
+    FrameChannel::bindCurrentThread(nullptr);
+
+    // 未读的输入不留给下一次运行，仍在等待输入的线程得到EOF
+    m_input.clear();
+
+    // 其他运行器在本次运行期间开始时全局输出已经交给它
+    if (s_outputOwner == this) {
+        PythonInterpreterManager::instance().redirectPythonOutput(nullptr);
+        PythonInterpreterManager::instance().redirectPythonInput(nullptr);
+        s_outputOwner = nullptr;
     }
 
-    // 处理调试命令
-    if (currentState == StepInto) {
-        // 逐语句：执行当前行，然后暂停
-        if (event == PyTrace_LINE) {
-            g_currentRunner->m_debugState = Paused;
-            emit g_currentRunner->debugStateChanged(g_currentRunner->m_debugState);
-            g_currentRunner->m_debugCondition.wait(&g_currentRunner->m_debugMutex);
+    // 最后一个运行的运行器结束时移除线程启动钩子
+    if (m_holdsThreadHook) {
+        m_holdsThreadHook = false;
+        if (--s_runningCount == 0) {
+            setThreadStartHook(false);
+        }
+    }
+}
 
-            // 检查是否需要中止
-            if (g_currentRunner->m_shouldAbort) {
-                return 0;
+void CodeRunner::profileEvent(int event, int lineNumber)
+{
+    const qint64 wallNs = monotonicNs();
+    const qint64 cpuNs  = LineProfile::threadCpuNs();
+
+    switch (event) {
+    case PyTrace_CALL:
+        m_profileStack.push_back({-1, wallNs, cpuNs});
+        break;
+    case PyTrace_LINE: {
+        if (m_profileStack.empty()) {
+            m_profileStack.push_back({-1, wallNs, cpuNs});
+        }
+        ProfileFrame& frame = m_profileStack.back();
+        if (frame.line > 0) {
+            m_activeProfile->record(frame.line, wallNs - frame.wallNs, cpuNs - frame.cpuNs);
+        }
+        frame = {lineNumber, wallNs, cpuNs};
+        break;
+    }
+    case PyTrace_RETURN:
+        if (!m_profileStack.empty()) {
+            const ProfileFrame& frame = m_profileStack.back();
+            if (frame.line > 0) {
+                m_activeProfile->record(frame.line, wallNs - frame.wallNs, cpuNs - frame.cpuNs);
             }
+            m_profileStack.pop_back();
         }
+        break;
+    default:
+        break;
     }
-    else if (currentState == StepOver) {
-        // 逐过程：执行当前行，然后暂停
-        if (event == PyTrace_LINE) {
-            g_currentRunner->m_debugState = Paused;
-            emit g_currentRunner->debugStateChanged(g_currentRunner->m_debugState);
-            g_currentRunner->m_debugCondition.wait(&g_currentRunner->m_debugMutex);
+}
 
-            // 检查是否需要中止
-            if (g_currentRunner->m_shouldAbort) {
-                return 0;
-            }
+void CodeRunner::pauseAndWait(int lineNumber)
+{
+    if (m_shouldAbort) {
+        return;
+    }
+    // 监视表达式在进入暂停前一起求值，结果先于暂停状态到达界面
+    evaluateWatches();
+
+    QMutexLocker locker(&m_debugMutex);
+    if (m_shouldAbort) {
+        return;
+    }
+
+    m_debugState.store(Paused, std::memory_order_release);
+    emit lineExecuted(lineNumber);
+    emit debugStateChanged(Paused);
+
+    // 等待调试命令期间释放GIL，避免其他线程获取GIL时被阻塞
+    const qint64   pauseStartNs = monotonicNs();
+    PyThreadState* threadState  = PyEval_SaveThread();
+    bool           inspecting   = false;
+    while (m_debugState.load(std::memory_order_acquire) == Paused && !m_shouldAbort) {
+        if (m_variableRequests.isEmpty() && !m_watchesChanged) {
+            m_debugCondition.wait(&m_debugMutex);
+            continue;
+        }
+
+        // 变量请求和监视表达式变化：同样先释放互斥量再获取GIL，取值期间调试命令不会被阻塞
+        const QVector<VariableRequest> requests = m_variableRequests;
+        const bool                     watches  = m_watchesChanged;
+        m_variableRequests.clear();
+        locker.unlock();
+        PyEval_RestoreThread(threadState);
+        if (watches) {
+            evaluateWatches();
+        }
+        if (!requests.isEmpty() && !inspecting) {
+            m_variableInspector.attach(PyEval_GetFrame());
+            inspecting = true;
         }
-        else if (event == PyTrace_CALL) {
-            // 函数调用时，跳过函数内部
-            g_currentRunner->m_debugState = Running;
+        for (const VariableRequest& request : requests) {
+            emit variablesReady(m_variableInspector.fetch(request.handle, request.start, request.count));
+        }
+        threadState = PyEval_SaveThread();
+        locker.relock();
+    }
+    m_variableRequests.clear();
+    locker.unlock();
+
+    // 先释放互斥量再重新获取GIL，持有GIL的控制线程可能正在等待该互斥量
+    PyEval_RestoreThread(threadState);
+    m_pausedNs += monotonicNs() - pauseStartNs;
+
+    // 逐过程和跳出以恢复时本线程的调用深度为基准
+    if (ThreadContext* context = t_context) {
+        context->stepDepth = context->callDepth;
+        m_steppingThread.store(context->id, std::memory_order_release);
+        if (!m_shouldAbort) {
+            prepareStep(context);
+        }
+    }
+    if (inspecting) {
+        m_variableInspector.detach();
+        // 取值期间到达的中止异常可能被查看器吞掉，重新设置
+        if (m_shouldAbort) {
+            PyThreadState_SetAsyncExc(m_threadId, PyExc_KeyboardInterrupt);
         }
     }
-    else if (currentState == StepOut) {
-        // 跳出：执行到函数返回，然后暂停
-        if (event == PyTrace_LINE) {
-            g_currentRunner->m_debugState = Paused;
-            emit g_currentRunner->debugStateChanged(g_currentRunner->m_debugState);
-            g_currentRunner->m_debugCondition.wait(&g_currentRunner->m_debugMutex);
 
-            // 检查是否需要中止
-            if (g_currentRunner->m_shouldAbort) {
-                return 0;
+    // sys.monitoring后端：按新的调试状态切换全局事件，继续运行且没有断点时全部关闭
+    if (m_monitoringAttached && !m_shouldAbort) {
+        if (isTraceHookRequired()) {
+            attachDebugHook();
+        }
+        else {
+            m_monitoringHook->deactivate();
+            m_monitoringAttached = false;
+        }
+    }
+}
+
+void CodeRunner::evaluateWatches()
+{
+    QStringList expressions;
+    bool        changed = false;
+    {
+        QMutexLocker locker(&m_debugMutex);
+        std::swap(changed, m_watchesChanged);
+        if (changed) {
+            expressions = m_watchExpressions;
+        }
+    }
+    // 列表变化时才重新编译
+    if (changed) {
+        m_watchList.setExpressions(expressions);
+    }
+    if (m_watchList.isEmpty()) {
+        return;
+    }
+
+    // 所有表达式在这一次持有GIL期间求值，作为一条消息发出
+    emit watchesReady(m_watchList.evaluate(PyEval_GetFrame()));
+
+    // 求值期间到达的中止异常会作为表达式的错误被取走，重新设置
+    if (m_shouldAbort) {
+        PyThreadState_SetAsyncExc(m_threadId, PyExc_KeyboardInterrupt);
+    }
+}
+
+MonitoringHook::Action CodeRunner::monitorLine(PyCodeObject* code, int line)
+{
+    // sys.monitoring的事件属于整个解释器，调试线程之外的事件直接忽略（不能关闭，位置是共享的）
+    ThreadContext* context = t_context;
+    CodeRunner*    runner  = context ? context->runner : nullptr;
+    if (!runner || !runner->m_monitoringAttached || !runner->isDebugTarget(context) ||
+        runner->m_shouldAbort.load(std::memory_order_relaxed)) {
+        return MonitoringHook::Continue;
+    }
+    TraceTimer timer(runner);
+
+    if (!isUserCode(code)) {
+        return MonitoringHook::Disable;
+    }
+
+    runner->m_activeLineChannel->record(line);
+
+    // 自由运行时只有断点所在的行保留事件，其余行第一次执行后关闭
+    const DebugState state = runner->m_debugState.load(std::memory_order_acquire);
+    if (state == Running) {
+        if (!runner->isBreakpoint(line)) {
+            return MonitoringHook::Disable;
+        }
+        // 条件断点的行保留事件，条件不满足时继续运行
+        if (!runner->shouldBreak(PyEval_GetFrame(), line)) {
+            return MonitoringHook::Continue;
+        }
+    }
+    else if (!runner->shouldStep(context, state)) {
+        // 逐过程和跳出跳过的函数：断点照常命中，其余行关闭到下次暂停（恢复时restart()重新开启）。
+        // 位置的关闭对所有栈帧生效，单步开始时栈上的代码返回后还要停下，保留事件
+        if (!runner->isBreakpoint(line)) {
+            const std::vector<PyCodeObject*>& codes = context->stepCodes;
+            return std::find(codes.begin(), codes.end(), code) == codes.end() ? MonitoringHook::Disable
+                                                                               : MonitoringHook::Continue;
+        }
+        if (!runner->shouldBreak(PyEval_GetFrame(), line)) {
+            return MonitoringHook::Continue;
+        }
+    }
+
+    runner->pauseAndWait(line);
+    return MonitoringHook::Continue;
+}
+
+MonitoringHook::Action CodeRunner::monitorFrame(PyCodeObject* code, bool entering)
+{
+    ThreadContext* context = t_context;
+    CodeRunner*    runner  = context ? context->runner : nullptr;
+    if (!runner || !runner->m_monitoringAttached || !runner->isDebugTarget(context) ||
+        runner->m_shouldAbort.load(std::memory_order_relaxed)) {
+        return MonitoringHook::Continue;
+    }
+    TraceTimer timer(runner);
+
+    if (!isUserCode(code)) {
+        return MonitoringHook::Disable;
+    }
+
+    // 单步期间函数进入和返回事件全部开启，调用深度与追踪函数后端一样用于逐过程和跳出
+    if (entering) {
+        runner->m_monitoringHook->arm(code);
+        context->callDepth++;
+    }
+    else {
+        context->callDepth--;
+    }
+
+    return runner->m_debugState.load(std::memory_order_acquire) == Running ? MonitoringHook::Disable
+                                                                          : MonitoringHook::Continue;
+}
+
+void CodeRunner::writeOutput(int stream, const char* data, int size)
+{
+    while (size > 0 && !m_shouldAbort) {
+        bool wake    = false;
+        int  written = m_outputChannel.tryWrite(
+            static_cast<OutputChannel::Stream>(stream), data, size, &wake);
+
+        // 直接发出信号，由Qt排队到界面线程（运行线程的事件循环此时处于阻塞状态）
+        if (wake) {
+            emit outputReady();
+        }
+
+        if (written > 0) {
+            m_outputBytes += written;
+            m_outputNewlines += std::count(data, data + written, '\n');
+            m_outputLineOpen = data[written - 1] != '\n';
+        }
+
+        data += written;
+        size -= written;
+
+        // 界面线程跟不上时等待其取走数据，等待期间释放GIL
+        if (size > 0) {
+            py::gil_scoped_release release;
+            m_outputChannel.waitForSpace(50);
+        }
+    }
+}
+
+bool CodeRunner::isUserFrame(PyFrameObject* frame)
+{
+    PyCodeObject* code   = PyFrame_GetCode(frame);
+    bool          isUser = isUserCode(code);
+    Py_DECREF(code);
+    return isUser;
+}
+
+bool CodeRunner::isUserCode(PyCodeObject* code)
+{
+    Py_ssize_t index = codeExtraIndex();
+    void*      extra = nullptr;
+
+    if (index >= 0 && _PyCode_GetExtra(reinterpret_cast<PyObject*>(code), index, &extra) == 0 &&
+        extra) {
+        return (reinterpret_cast<intptr_t>(extra) & kCodeKindMask) == CodeKindUser;
+    }
+
+    PyObject* filename = code->co_filename;
+    bool      isUser   = filename && PyUnicode_Check(filename) &&
+                  PyUnicode_CompareWithASCIIString(
+                      filename, PythonInterpreterManager::editorFileName()) == 0;
+
+    if (index >= 0) {
+        // 用户代码同时记下最后一行，逐过程时据此判断函数中是否有断点
+        intptr_t value = CodeKindLibrary;
+        if (isUser) {
+            value = CodeKindUser | (static_cast<intptr_t>(computeLastLine(code)) << kCodeKindBits);
+        }
+        _PyCode_SetExtra(reinterpret_cast<PyObject*>(code), index, reinterpret_cast<void*>(value));
+    }
+
+    return isUser;
+}
+
+int CodeRunner::userCodeLastLine(PyCodeObject* code)
+{
+    Py_ssize_t index = codeExtraIndex();
+    void*      extra = nullptr;
+    if (index < 0 || _PyCode_GetExtra(reinterpret_cast<PyObject*>(code), index, &extra) < 0) {
+        PyErr_Clear();
+        return 0;
+    }
+    const intptr_t value = reinterpret_cast<intptr_t>(extra);
+    return (value & kCodeKindMask) == CodeKindUser ? static_cast<int>(value >> kCodeKindBits) : 0;
+}
+
+int CodeRunner::computeLastLine(PyCodeObject* code)
+{
+    // 分类时可能有正在传播的异常，先保存，结束时恢复
+    PyObject* type      = nullptr;
+    PyObject* value     = nullptr;
+    PyObject* traceback = nullptr;
+    PyErr_Fetch(&type, &value, &traceback);
+
+    // co_lines()逐段给出(起始, 结束, 行号)，没有对应行的段行号为None；3.10之前没有该方法，按未知处理
+    int       lastLine = 0;
+    PyObject* lines    = PyObject_CallMethodNoArgs(reinterpret_cast<PyObject*>(code),
+                                                PythonHandles::current().names.codeLines);
+    PyObject* iterator = lines ? PyObject_GetIter(lines) : nullptr;
+    Py_XDECREF(lines);
+    if (iterator) {
+        while (PyObject* item = PyIter_Next(iterator)) {
+            if (PyTuple_Check(item) && PyTuple_GET_SIZE(item) == 3 && PyLong_Check(PyTuple_GET_ITEM(item, 2))) {
+                lastLine = qMax(lastLine, static_cast<int>(PyLong_AsLong(PyTuple_GET_ITEM(item, 2))));
             }
+            Py_DECREF(item);
         }
+        Py_DECREF(iterator);
     }
-    // Running状态不需要特殊处理，直接继续执行
+    PyErr_Clear();
 
-    // 追踪函数必须返回0，否则会导致Python解释器崩溃
-    return 0;
+    PyErr_Restore(type, value, traceback);
+    return lastLine;
+}
+
+bool CodeRunner::hasBreakpointIn(PyCodeObject* code) const
+{
+    const BreakpointTable* table = m_breakpoints.load(std::memory_order_acquire);
+    if (!table) {
+        return false;
+    }
+    // 范围未知时按有断点处理
+    const int lastLine = userCodeLastLine(code);
+    return lastLine <= 0 || table->containsRange(code->co_firstlineno, lastLine);
+}
+
+bool CodeRunner::canSkipLines(const ThreadContext* context, PyFrameObject* frame) const
+{
+    // 逐行统计和录制需要运行线程的每个行事件
+    if (context->main && (m_activeProfile || m_activeRecorder)) {
+        return false;
+    }
+
+    // 生成器和协程的栈帧挂起时不在栈上，暂停时无法重新开启，保留行事件
+    PyCodeObject* code = PyFrame_GetCode(frame);
+    const bool    skip =
+        !(code->co_flags & (CO_GENERATOR | CO_COROUTINE | CO_ASYNC_GENERATOR)) && !hasBreakpointIn(code);
+    Py_DECREF(code);
+    return skip;
+}
+
+void CodeRunner::prepareStep(ThreadContext* context)
+{
+    const DebugState state = m_debugState.load(std::memory_order_acquire);
+    context->stepCodes.clear();
+
+    PyFrameObject* current = PyEval_GetFrame();
+    Py_XINCREF(current);
+    PyFrameObject* frame = current;
+    Py_XINCREF(frame);
+    while (frame) {
+        PyCodeObject* code = PyFrame_GetCode(frame);
+        if (isUserCode(code)) {
+            if (!m_monitoringAttached) {
+                setLineEvents(frame, true);
+            }
+            else if (state == StepOver || state == StepOut) {
+                context->stepCodes.push_back(code);
+            }
+        }
+        Py_DECREF(code);
+
+        PyFrameObject* back = PyFrame_GetBack(frame);
+        Py_DECREF(frame);
+        frame = back;
+    }
+
+    // 跳出：当前栈帧剩余的行不会暂停，没有断点时一起关闭，返回到调用者的行时才停下
+    if (current && !m_monitoringAttached && state == StepOut && isUserFrame(current) &&
+        canSkipLines(context, current)) {
+        setLineEvents(current, false);
+    }
+    Py_XDECREF(current);
+}
+
+void CodeRunner::setLineEvents(PyFrameObject* frame, bool enabled)
+{
+#if PY_VERSION_HEX < 0x030B0000
+    frame->f_trace_lines = enabled ? 1 : 0;
+#else
+    // 3.11起PyFrameObject不再公开，通过属性设置
+    PyObject* name = PythonHandles::current().names.traceLines;
+    if (PyObject_SetAttr(reinterpret_cast<PyObject*>(frame), name, enabled ? Py_True : Py_False) < 0) {
+        PyErr_Clear();
+    }
+#endif
 }
 
 int CodeRunner::getLineNumber(PyFrameObject* frame) const
@@ -250,19 +1505,44 @@ QString CodeRunner::getFileName(PyFrameObject* frame) const
         return QString();
     }
 
-    PyObject* filename = frame->f_code->co_filename;
+    PyCodeObject* code     = PyFrame_GetCode(frame);
+    PyObject*     filename = code->co_filename;
+    QString       result;
 
     if (filename && PyUnicode_Check(filename)) {
-        return QString::fromUtf8(PyUnicode_AsUTF8(filename));
+        result = QString::fromUtf8(PyUnicode_AsUTF8(filename));
     }
 
-    return QString();
+    Py_DECREF(code);
+    return result;
 }
 
-void CodeRunner::executePythonCodeSafely(const QString& code)
+void CodeRunner::executePythonCodeSafely(const QString&              code,
+                                         bool                        profiling,
+                                         bool                        sampling,
+                                         bool                        memory,
+                                         bool                        objects,
+                                         bool                        recording,
+                                         bool                        recordLocals,
+                                         const RunWatchdog::Budgets& budgets)
 {
     emit executionStarted();
 
+    const qint64               startNs    = monotonicNs();
+    const qint64               startCpuNs = LineProfile::threadCpuNs();
+    const GilWaitMeter::Totals startGil   = GilWaitMeter::totals();
+    qint64                     compileNs  = 0;
+    RunWatchdog::Budget        exceeded   = RunWatchdog::NoBudget;
+
+    m_traceEvents      = 0;
+    m_traceNs          = 0;
+    m_pausedNs         = 0;
+    m_outputBytes      = 0;
+    m_outputNewlines   = 0;
+    m_outputLineOpen   = false;
+    m_logpointHits     = 0;
+    m_logpointsDropped = 0;
+
     try {
         // 获取Python解释器管理器实例
         PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
@@ -275,76 +1555,252 @@ void CodeRunner::executePythonCodeSafely(const QString& code)
         PyGILState_STATE gstate = PyGILState_Ensure();
 
         try {
-            // 重置调试状态
-            m_debugState = Running;
-            m_callDepth  = 0;
-            emit debugStateChanged(m_debugState);
+            // 重置调试状态和断点命中次数
+            m_debugState.store(Running, std::memory_order_release);
+            if (const BreakpointTable* table = m_breakpoints.load(std::memory_order_acquire)) {
+                table->resetHits();
+            }
+            emit debugStateChanged(Running);
+
+            // 为本次运行创建执行行通道
+            std::shared_ptr<LineChannel> channel =
+                std::make_shared<LineChannel>(code.count(QLatin1Char('\n')) + 1);
+            m_activeLineChannel = channel.get();
+            std::atomic_store(&m_lineChannel, channel);
+
+            // 分析运行的逐行统计；普通运行清除上一次的结果
+            std::shared_ptr<LineProfile> profile;
+            if (profiling) {
+                profile = std::make_shared<LineProfile>(channel->lineCount());
+                m_profileStack.clear();
+                m_profileStack.reserve(64);
+            }
+            m_activeProfile = profile.get();
+            m_profiling     = profile != nullptr;
+            std::atomic_store(&m_lineProfile, profile);
+
+            // 录制运行同样需要每个行事件；普通运行清除上一次的结果
+            std::atomic_store(&m_recordingResult, std::shared_ptr<ExecutionRecording>());
+            if (recording) {
+                QString path;
+                {
+                    QMutexLocker locker(&m_recordingMutex);
+                    path = m_recordingPath;
+                }
+                if (m_recorder.start(path, recordLocals)) {
+                    m_activeRecorder = &m_recorder;
+                }
+                else {
+                    const QByteArray message = (m_recorder.errorString() + "\n").toUtf8();
+                    writeOutput(OutputChannel::StdErr, message.constData(), message.size());
+                }
+            }
+            m_recording = m_activeRecorder != nullptr;
+
+            // 追踪函数通过线程的调试上下文找到正在执行的运行器；每次运行从运行线程开始调试
+            m_threadState = PyThreadState_Get();
+            m_threadId    = PyThread_get_thread_ident();
+            m_mainThread  = std::make_shared<ThreadContext>();
+            m_mainThread->runner = this;
+            m_mainThread->state  = m_threadState;
+            m_mainThread->id     = m_threadId;
+            m_mainThread->name   = "运行线程";
+            m_mainThread->main   = true;
+            t_context            = m_mainThread.get();
+            m_selectedThread     = 0;
+            m_steppingThread     = 0;
+            {
+                QMutexLocker locker(&s_threadMutex);
+                m_threads.assign(1, m_mainThread);
+                emit debugThreadsChanged(debugThreads());
+            }
 
-            // 设置Python追踪函数
-            PyEval_SetTrace(pythonTraceFunction, nullptr);
+            // 自由运行模式：只有存在断点时才在开始时安装追踪函数，
+            // 运行中设置断点或暂停时再按需挂载
+            m_interruptGate->reset();
+            m_input.reset();
+            selectDebugBackend();
+            if (isTraceHookRequired()) {
+                attachDebugHook();
+            }
 
-            // 重定向Python输出
-            pyManager.redirectPythonOutput([this](const QString& text) {
-                // 在UI线程中发出信号
-                QMetaObject::invokeMethod(this, [this, text]() { emit outputReceived(text); });
-            });
+            // 运行线程的输出、可中断等待和标准输入绑定到本运行器；未绑定的线程也交给最近开始的运行器
+            PythonInterpreterManager::bindCurrentThread(&m_pythonOutput, m_interruptGate.get(), &m_input);
+            pyManager.redirectPythonOutput(m_pythonOutput);
+            pyManager.redirectPythonInput(&m_input);
+            FrameChannel::bindCurrentThread(frameChannel());
+            s_outputOwner = this;
+
+            // 运行期间启动的threading线程在启动时登记到启动它的运行器，可在调试器中选择；
+            // 钩子在第一个运行开始时安装，多个运行器同时运行时共用
+            m_holdsThreadHook = true;
+            if (s_runningCount++ == 0) {
+                setThreadStartHook(true);
+            }
 
-            // 执行代码
-            py::object result = pyManager.executeCode(code);
+            // 采样分析在用户代码开始前启动；普通运行清除上一次的结果
+            std::atomic_store(&m_flameGraph, std::shared_ptr<FlameGraph>());
+            if (sampling) {
+                m_sampler.start(m_threadState, m_samplingRate);
+            }
 
-            // 清除追踪函数
-            PyEval_SetTrace(nullptr, nullptr);
+            // 内存统计和对象诊断同样在用户代码开始前启动
+            std::atomic_store(&m_memoryReport, std::shared_ptr<MemoryReport>());
+            if (memory || objects) {
+                m_memoryProfiler.start(memory, objects);
+            }
 
-            // 检查是否需要中止
-            if (m_shouldAbort) {
-                PyErr_SetString(PyExc_KeyboardInterrupt, "User aborted execution");
+            // 预算监视不需要追踪钩子：超出时按用户中止的路径抛出异步异常，
+            // 捕获异常的代码在宽限期后同样升级为强制停止
+            m_watchdog.start(
+                budgets,
+                [this]() { return m_debugState.load(std::memory_order_acquire) == Paused; },
+                [this](RunWatchdog::Budget) { abortExecution(); });
+
+            // 在本运行器的会话命名空间中执行代码；代码中的asyncio调用使用运行线程的事件循环
+            QString context;
+            {
+                QMutexLocker locker(&m_recordingMutex);
+                context = m_namespaceContext;
             }
+            py::object globals = pyManager.runNamespace(context);
+            m_asyncioLoop->install();
+            py::object result = pyManager.executeCode(code, &globals);
+            compileNs         = pyManager.lastCompileNs();
+
+            // 顶层await：在同一个循环上运行到结束，之前创建的后台任务同时运行
+            if (!result.is_none()) {
+                try {
+                    m_asyncioLoop->runUntilComplete(result);
+                }
+                catch (const py::error_already_set& e) {
+                    if (!m_shouldAbort && !e.matches(PyExc_KeyboardInterrupt)) {
+                        emit errorOccurred(QString("Python execution error: %1").arg(QString::fromUtf8(e.what())));
+                    }
+                }
+            }
+
+            // 停止预算监视，清除追踪函数，停止采样和内存统计，输出恢复到默认目标
+            m_watchdog.stop();
+            exceeded = m_watchdog.exceeded();
+            detachTraceHook();
+            finishRecording();
+            std::atomic_store(&m_flameGraph, m_sampler.stop());
+            std::atomic_store(&m_memoryReport, m_memoryProfiler.stop());
+            releaseOutput();
+
+            // 运行中创建的任务回到Qt事件循环后开始在后台运行
+            m_asyncioLoop->wake();
         }
         catch (...) {
-            // 释放GIL
-            PyGILState_Release(gstate);
+            compileNs = pyManager.lastCompileNs();
 
-            // 处理Python异常
-            if (PyErr_Occurred()) {
-                PyObject *exc_type, *exc_value, *exc_tb;
-                PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+            // 管理器把Python异常转换为std::runtime_error，消息中带有异常信息
+            QString exceptionMessage = "Unknown error during execution";
+            try {
+                throw;
+            }
+            catch (const std::exception& e) {
+                exceptionMessage = QString::fromUtf8(e.what());
+            }
+            catch (...) {
+            }
 
-                QString errorMsg;
-                if (exc_value && PyUnicode_Check(exc_value)) {
-                    errorMsg = QString::fromUtf8(PyUnicode_AsUTF8(exc_value));
+            // 停止预算监视，清除追踪函数，停止采样和内存统计，输出恢复到默认目标；
+            // 出错的运行同样报告内存（例如MemoryError之前的峰值）
+            m_watchdog.stop();
+            exceeded = m_watchdog.exceeded();
+            detachTraceHook();
+            finishRecording();
+            std::atomic_store(&m_flameGraph, m_sampler.stop());
+            {
+                // 汇总在Python中进行，先保存用户代码的异常
+                PyObject *errType, *errValue, *errTraceback;
+                PyErr_Fetch(&errType, &errValue, &errTraceback);
+                std::atomic_store(&m_memoryReport, m_memoryProfiler.stop());
+                PyErr_Restore(errType, errValue, errTraceback);
+            }
+            releaseOutput();
+
+            // 用户中止导致的异常不作为错误报告，由运行汇总说明
+            if (!m_shouldAbort) {
+                if (PyErr_Occurred()) {
+                    PyObject *exc_type, *exc_value, *exc_tb;
+                    PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+
+                    QString errorMsg;
+                    if (exc_value && PyUnicode_Check(exc_value)) {
+                        errorMsg = QString::fromUtf8(PyUnicode_AsUTF8(exc_value));
+                    }
+                    else {
+                        errorMsg = "Unknown Python error";
+                    }
+
+                    Py_XDECREF(exc_type);
+                    Py_XDECREF(exc_value);
+                    Py_XDECREF(exc_tb);
+                    emit errorOccurred(errorMsg);
                 }
                 else {
-                    errorMsg = "Unknown Python error";
+                    emit errorOccurred(exceptionMessage);
                 }
-
-                QMetaObject::invokeMethod(this,
-                                          [this, errorMsg]() { emit errorOccurred(errorMsg); });
             }
-            else {
-                QMetaObject::invokeMethod(
-                    this, [this]() { emit errorOccurred("Unknown error during execution"); });
-            }
-
-            m_isExecuting = false;
-            emit executionFinished();
-            return;
+            PyErr_Clear();
         }
 
+        // 运行结束是安全点：刷新界面读取的解释器信息（sys.path、已加载的模块可能已变化）
+        pyManager.refreshInterpreterInfo();
+
         // 释放GIL
         PyGILState_Release(gstate);
-
-        // 发送完成信号
-        QMetaObject::invokeMethod(this, [this]() { emit executionFinished(); });
     }
     catch (const std::exception& e) {
-        QString errorMsg = QString("Execution error: %1").arg(e.what());
-        QMetaObject::invokeMethod(this, [this, errorMsg]() { emit errorOccurred(errorMsg); });
+        emit errorOccurred(QString("Execution error: %1").arg(e.what()));
     }
     catch (...) {
-        QMetaObject::invokeMethod(this, [this]() { emit errorOccurred("Unknown error occurred"); });
+        emit errorOccurred("Unknown error occurred");
+    }
+
+    // 运行汇总
+    const qint64 endNs = monotonicNs();
+    RunSummary   summary;
+    summary.elapsedNs   = endNs - startNs;
+    summary.aborted     = m_shouldAbort;
+    summary.hardStopped = m_hardStop;
+    if (const qint64 requestedNs = m_abortRequestedNs.load()) {
+        summary.abortLatencyNs = endNs - requestedNs;
     }
 
-    m_isExecuting = false;
+    const GilWaitMeter::Totals endGil = GilWaitMeter::totals();
+    summary.compileNs   = compileNs;
+    summary.cpuNs       = LineProfile::threadCpuNs() - startCpuNs;
+    summary.traceEvents = m_traceEvents;
+    summary.traceNs     = m_traceNs;
+    summary.uiGilWaitNs = endGil.waitNs - startGil.waitNs;
+    summary.uiGilWaits  = endGil.waits - startGil.waits;
+    summary.outputBytes = m_outputBytes;
+    summary.outputLines = m_outputNewlines + (m_outputLineOpen ? 1 : 0);
+
+    summary.logpointHits     = m_logpointHits;
+    summary.logpointsDropped = m_logpointsDropped;
+
+    // 超出预算的运行按中止处理，另外报告是哪一项预算
+    summary.budgetExceeded = exceeded;
+    if (exceeded != RunWatchdog::NoBudget) {
+        emit errorOccurred(RunWatchdog::describe(exceeded, budgets));
+    }
+
+    // 先清除执行标志再发出完成信号，收到信号后可以立即开始下一次运行；
+    // 中止的运行结束后清除中断，比运行活得更久的线程中的time.sleep不再立即抛出KeyboardInterrupt
+    {
+        QMutexLocker locker(&m_abortMutex);
+        m_isExecuting = false;
+        if (m_shouldAbort) {
+            m_interruptGate->reset();
+        }
+    }
+    emit runSummary(summary);
+    emit executionFinished();
 }
 
 void CodeRunner::handlePythonException(void* exc)
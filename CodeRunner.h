@@ -1,11 +1,33 @@
 #pragma once
 
+#include "AsyncioLoop.h"
+#include "BreakpointTable.h"
+#include "ExecutionRecorder.h"
+#include "FrameChannel.h"
+#include "InputQueue.h"
+#include "InterruptGate.h"
+#include "LineChannel.h"
+#include "LineProfile.h"
+#include "MemoryProfiler.h"
+#include "MonitoringHook.h"
+#include "OutputChannel.h"
+#include "RunScheduler.h"
+#include "SamplingProfiler.h"
+#include "VariableInspector.h"
+#include "WatchList.h"
+
 #include <QMutex>
 #include <QObject>
 #include <QSet>
 #include <QString>
+#include <QThreadPool>
 #include <QWaitCondition>
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <Python.h>
 
 /**
@@ -17,6 +39,9 @@
  * - 线程隔离的Python执行环境
  * - 完善的异常处理
  * - 代码执行状态跟踪
+ *
+ * 运行请求经RunScheduler排队，运行中收到的请求不会丢失，按优先级依次运行。
+ * 公开的控制接口均为虚函数，RemoteCodeRunner以相同接口把执行转移到子进程。
  */
 class CodeRunner : public QObject
 {
@@ -36,6 +61,57 @@ public:
     };
     Q_ENUM(DebugState)
 
+    /**
+     * @brief 调试事件后端
+     */
+    enum DebugBackend
+    {
+        TraceBackend,        // PyEval_SetTrace，所有Python版本可用
+        MonitoringBackend    // sys.monitoring（PEP 669），Python 3.12及以上
+    };
+    Q_ENUM(DebugBackend)
+
+    /**
+     * @brief 一次运行的汇总信息
+     */
+    struct RunSummary
+    {
+        qint64 elapsedNs      = 0;       // 运行耗时
+        bool   aborted        = false;   // 是否被用户中止
+        bool   hardStopped    = false;   // 是否升级为强制停止
+        qint64 abortLatencyNs = -1;      // 从请求中止到运行结束的时间，未中止时为-1
+
+        // 运行指标
+        qint64 compileNs   = 0;   // 编译耗时（命中编译缓存时只有查表时间）
+        qint64 cpuNs       = 0;   // 运行线程的CPU时间
+        qint64 traceEvents = 0;   // 调试钩子处理的事件数（追踪函数和sys.monitoring回调）
+        qint64 traceNs     = 0;   // 调试钩子内部的耗时，不含暂停等待调试命令的时间
+        qint64 uiGilWaitNs = 0;   // 运行期间界面线程等待GIL的时间
+        qint64 uiGilWaits  = 0;   // 运行期间界面线程获取GIL的次数
+        qint64 outputBytes = 0;   // 标准输出和标准错误的字节数
+        qint64 outputLines = 0;   // 输出行数（末尾不完整的一行也计入）
+
+        qint64 logpointHits     = 0;   // 日志点输出的条数（含丢弃的）
+        qint64 logpointsDropped = 0;   // 输出通道已满时丢弃的日志点输出
+
+        int budgetExceeded = RunWatchdog::NoBudget;   // 触发停止的预算（RunWatchdog::Budget）
+    };
+
+    /**
+     * @brief 运行中的一个Python线程，供调试器选择
+     */
+    struct DebugThread
+    {
+        unsigned long id   = 0;       // 线程标识（threading.get_ident()）
+        QString       name;           // threading.Thread的名字
+        bool          main = false;   // 运行线程
+    };
+
+    /**
+     * @brief 一个线程的调试上下文（定义在实现文件中）
+     */
+    struct ThreadContext;
+
     /**
      * @brief 构造函数
      * @param parent 父对象
@@ -45,7 +121,160 @@ public:
     /**
      * @brief 析构函数
      */
-    ~CodeRunner();
+    ~CodeRunner() override;
+
+    /**
+     * @brief 获取当前运行的执行行通道（线程安全）
+     *
+     * 编辑器按刷新率采样其中的最新行号和命中计数。
+     * @return std::shared_ptr<LineChannel> 通道，从未运行过时为空
+     */
+    virtual std::shared_ptr<LineChannel> lineChannel() const;
+
+    /**
+     * @brief 获取Python输出通道
+     *
+     * 运行线程写入，界面线程在收到outputReady()后整批取出。
+     * @return OutputChannel* 输出通道
+     */
+    OutputChannel* outputChannel() { return &m_outputChannel; }
+
+    /**
+     * @brief 获取图像通道（线程安全）
+     *
+     * 运行中cpp_module.show_image()提交的图像写入其中，结果页按刷新率取走最新一帧。
+     * 第一次调用时在堆上创建。
+     * @return std::shared_ptr<FrameChannel> 通道，内存不足时为空
+     */
+    virtual std::shared_ptr<FrameChannel> frameChannel() const;
+
+    /**
+     * @brief 使用指定的图像通道（执行进程中使用共享内存的通道，下一次运行生效）
+     * @param channel 通道
+     */
+    void setFrameChannel(std::shared_ptr<FrameChannel> channel);
+
+    /**
+     * @brief 设置首选的调试后端（下一次运行生效）
+     *
+     * 默认首选sys.monitoring；运行时Python低于3.12或调试器工具编号被占用时自动使用PyEval_SetTrace。
+     * @param backend 首选后端
+     */
+    void setPreferredDebugBackend(DebugBackend backend) { m_preferredBackend = backend; }
+
+    /**
+     * @brief 获取最近一次运行实际使用的调试后端
+     * @return DebugBackend 调试后端
+     */
+    DebugBackend activeDebugBackend() const { return m_activeBackend; }
+
+    /**
+     * @brief 设置之后runCode()提交的运行是否进行逐行性能分析（线程安全）
+     *
+     * 分析运行始终使用PyEval_SetTrace处理每个行事件，速度明显慢于普通运行。
+     * @param enabled 是否分析
+     */
+    void setProfiling(bool enabled) { m_profilingRequested = enabled; }
+
+    /**
+     * @brief 获取最近一次分析运行的逐行统计（线程安全，运行中也可读取）
+     * @return std::shared_ptr<LineProfile> 统计结果，最近一次运行不是分析运行时为空
+     */
+    std::shared_ptr<LineProfile> lineProfile() const;
+
+    /**
+     * @brief 设置之后runCode()提交的运行是否进行采样分析（线程安全）
+     *
+     * 采样线程按固定频率抓取调用栈，不安装追踪函数，开销一般在几个百分点以内。
+     * @param enabled 是否采样
+     */
+    void setSampling(bool enabled) { m_samplingRequested = enabled; }
+
+    /**
+     * @brief 设置采样频率（线程安全，下一次运行生效）
+     * @param rateHz 每秒采样次数
+     */
+    void setSamplingRate(int rateHz) { m_samplingRate = rateHz; }
+
+    /**
+     * @brief 获取最近一次采样运行的火焰图（线程安全）
+     * @return std::shared_ptr<FlameGraph> 采样结果，最近一次运行没有采样时为空
+     */
+    std::shared_ptr<FlameGraph> flameGraph() const;
+
+    /**
+     * @brief 设置之后runCode()提交的运行是否统计内存（线程安全）
+     *
+     * 运行期间开启tracemalloc并采样进程常驻内存，Python分配明显变慢。
+     * @param enabled 是否统计
+     */
+    void setMemoryTracking(bool enabled) { m_memoryRequested = enabled; }
+
+    /**
+     * @brief 获取最近一次统计运行的内存报告（线程安全）
+     * @return std::shared_ptr<MemoryReport> 统计结果，最近一次运行没有统计内存时为空
+     */
+    std::shared_ptr<MemoryReport> memoryReport() const;
+
+    /**
+     * @brief 设置录制文件的路径（下一次录制运行生效）
+     * @param path 文件路径，默认在临时目录中
+     */
+    void setRecordingPath(const QString& path);
+
+    /**
+     * @brief 设置运行使用的会话命名空间上下文（线程安全，下一次运行生效）
+     *
+     * 每个编辑器标签页的运行器使用自己的上下文，会话变量互不影响（见PythonInterpreterManager::runNamespace()）。
+     * @param context 上下文名字，空表示解释器初始的__main__
+     */
+    void setNamespaceContext(const QString& context);
+
+    /**
+     * @brief 获取最近一次录制运行的结果（线程安全）
+     * @return std::shared_ptr<ExecutionRecording> 录制结果，最近一次运行没有录制或录制失败时为空
+     */
+    std::shared_ptr<ExecutionRecording> recording() const;
+
+    /**
+     * @brief 设置之后runCode()提交的运行的时间和内存预算（线程安全）
+     *
+     * 超出预算时由监视线程中止运行（与abortExecution()相同的路径），并报告超出的是哪一项。
+     * @param budgets 预算，各项为0表示不限制
+     */
+    void setBudgets(const RunWatchdog::Budgets& budgets);
+
+    /**
+     * @brief 提交运行请求（线程安全）
+     *
+     * 请求进入调度队列，运行器空闲时在自身所在线程中按优先级开始运行。
+     * @param request 请求
+     * @return std::shared_ptr<RunScheduler::Ticket> 票据，与排队中的同key请求合并时为该请求的票据
+     */
+    std::shared_ptr<RunScheduler::Ticket> submitRun(const RunScheduler::Request& request);
+
+    /**
+     * @brief 取消运行请求（线程安全）
+     *
+     * 排队中的请求不再运行；正在运行的请求按abortExecution()中止。
+     * @param ticketId 票据编号
+     */
+    void cancelRun(int ticketId);
+
+    /**
+     * @brief 获取运行请求队列（用于查询队列深度和排队时间）
+     * @return RunScheduler* 队列
+     */
+    RunScheduler* scheduler() { return &m_scheduler; }
+
+    /**
+     * @brief 获取运行线程的asyncio事件循环
+     *
+     * 每次运行前设为运行线程的当前事件循环；代码可以使用顶层await，
+     * 创建的任务在运行结束后由运行线程的Qt事件循环继续驱动。
+     * @return AsyncioLoop* 事件循环
+     */
+    AsyncioLoop* asyncioLoop() { return m_asyncioLoop; }
 
 signals:
     /**
@@ -59,16 +288,25 @@ signals:
     void executionFinished();
 
     /**
-     * @brief 行执行信号（用于高亮显示）
+     * @brief 运行汇总信号（在executionFinished之前发出）
+     * @param summary 汇总信息
+     */
+    void runSummary(const CodeRunner::RunSummary& summary);
+
+    /**
+     * @brief 行执行信号（暂停时发出，用于立即高亮暂停行）
+     *
+     * 运行过程中的执行行通过lineChannel()采样，不再逐行发信号。
      * @param lineNumber 行号
      */
     void lineExecuted(int lineNumber);
 
     /**
-     * @brief 接收Python输出信号
-     * @param text 输出文本
+     * @brief 输出通道中有新数据的信号
+     *
+     * 每次取走数据后只发出一次，多次写入合并为一次通知。
      */
-    void outputReceived(const QString& text);
+    void outputReady();
 
     /**
      * @brief 错误发生信号
@@ -89,51 +327,221 @@ signals:
      */
     void debugStateChanged(int state);
 
+    /**
+     * @brief 排队中的请求数变化信号（可能在任意线程中发出）
+     * @param depth 排队中的请求数
+     */
+    void queueChanged(int depth);
+
+    /**
+     * @brief 暂停时请求的一页变量（在运行线程中发出）
+     * @param page 一页变量
+     */
+    void variablesReady(const VariableInspector::Page& page);
+
+    /**
+     * @brief 暂停时所有监视表达式的值（在运行线程中发出，每次暂停一次）
+     * @param values 与表达式一一对应的结果
+     */
+    void watchesReady(const QVector<WatchList::Value>& values);
+
+    /**
+     * @brief 运行中的线程变化信号（可能在任意线程中发出，运行结束时为空）
+     * @param threads 运行线程和运行期间启动的、仍在运行的线程
+     */
+    void debugThreadsChanged(const QVector<CodeRunner::DebugThread>& threads);
+
+    /**
+     * @brief 代码开始或结束等待标准输入（在读取输入的线程中发出）
+     * @param waiting 是否正在等待
+     */
+    void inputWaitChanged(bool waiting);
+
 public slots:
     /**
-     * @brief 运行Python代码
+     * @brief 以交互优先级提交一次运行（不合并），分析选项取setProfiling()和setSampling()的当前值
      * @param code Python代码
      */
     void runCode(const QString& code);
 
     /**
      * @brief 中止代码执行
+     *
+     * 通过PyThreadState_SetAsyncExc在运行线程中抛出KeyboardInterrupt，不依赖追踪钩子；
+     * 同时唤醒可中断的time.sleep。宽限期内未结束则升级为强制停止：
+     * 挂载追踪钩子并在每个事件上重新抛出异常，捕获异常的代码也无法继续运行。
+     * 两者都要回到字节码循环才生效，停留在一次C调用中的代码要等调用返回。
      */
-    void abortExecution();
+    virtual void abortExecution();
 
     /**
-     * @brief 设置执行速度（用于调试）
-     * @param delayMs 延迟毫秒数
+     * @brief 向代码的标准输入写入数据（线程安全，运行期间直接调用）
+     *
+     * 运行中的input()和sys.stdin从这里读取；运行开始前写入的数据由下一次运行读取，
+     * 运行结束时未读的数据被丢弃。
+     * @param data UTF-8数据，可以包含多行
      */
-    void setExecutionDelay(int delayMs);
+    virtual void writeInput(const QByteArray& data);
+
+    /**
+     * @brief 结束标准输入（线程安全），读完已写入的数据后input()抛出EOFError
+     */
+    virtual void closeInput();
+
+    /**
+     * @brief 暂停执行（在下一行用户代码处停下）
+     *
+     * 自由运行模式下不安装追踪钩子，暂停请求会按需挂载钩子。
+     */
+    virtual void pauseExecution();
 
     /**
      * @brief 继续执行
      */
-    void continueExecution();
+    virtual void continueExecution();
 
     /**
      * @brief 逐语句执行
      */
-    void stepInto();
+    virtual void stepInto();
 
     /**
      * @brief 逐过程执行
      */
-    void stepOver();
+    virtual void stepOver();
 
     /**
      * @brief 跳出当前函数
      */
-    void stepOut();
+    virtual void stepOut();
+
+    /**
+     * @brief 选择调试的线程（线程安全，运行开始时恢复为运行线程）
+     *
+     * 断点、暂停和单步只作用于选中的线程，其余线程不挂载追踪函数，以原速运行；
+     * 选中的线程暂停时其他线程继续运行。
+     * @param id 线程标识（DebugThread::id），0表示运行线程
+     */
+    virtual void selectDebugThread(unsigned long id);
 
     /**
      * @brief 设置断点列表
-     * @param breakpoints 断点行号集合
+     * @param breakpoints 断点（含条件和命中次数）
+     */
+    virtual void setBreakpoints(const QVector<Breakpoint>& breakpoints);
+
+    /**
+     * @brief 请求暂停栈帧中的一页变量（线程安全，结果通过variablesReady()返回）
+     *
+     * 只在暂停时有效；请求排入队列后唤醒运行线程，由运行线程持有GIL取值。
+     * @param handle 句柄，0为栈帧顶层
+     * @param start 第一项的序号
+     * @param count 最多取的项数
+     */
+    virtual void requestVariables(quint64 handle, int start, int count);
+
+    /**
+     * @brief 设置监视表达式（线程安全）
+     *
+     * 之后每次暂停时一起求值并通过watchesReady()返回；正在暂停时立即重新求值。
+     * @param expressions 表达式列表
+     */
+    virtual void setWatchExpressions(const QStringList& expressions);
+
+    /**
+     * @brief 设置无条件断点
+     * @param lines 断点行号集合
      */
-    void setBreakpoints(const QSet<int>& breakpoints);
+    void setBreakpoints(const QSet<int>& lines);
+
+    /**
+     * @brief 释放持有的Python对象（在运行器所在线程中调用，自行获取GIL）
+     *
+     * 解释器重新初始化前调用（PythonInterpreterManager::aboutToRestart()），不能在运行期间调用。
+     * 断点和监视表达式保留，在新解释器中按需重新编译。
+     */
+    void releasePythonState();
+
+protected:
+    /**
+     * @brief 开始运行调度队列取出的请求（在运行器所在线程中调用）
+     *
+     * 默认实现在当前线程中执行代码并在结束后调用finishRun()；
+     * 子类可以异步运行，结束时自行调用finishRun()。
+     * @param request 请求
+     */
+    virtual void beginRun(const RunScheduler::Request& request);
+
+    /**
+     * @brief 当前请求运行结束，调度下一个请求（线程安全，在executionFinished之后调用）
+     */
+    void finishRun();
 
 private:
+    /**
+     * @brief 运行器空闲时取出并开始下一个请求（在运行器所在线程中调用）
+     */
+    void dispatchNextRun();
+
+    /**
+     * @brief threading.settrace()安装的线程启动钩子（在新线程的第一个事件中调用）
+     *
+     * 取消threading设置的Python层追踪，把线程登记到启动它的线程所属的运行器，并继承该运行器的中断门。
+     * @param self 未使用
+     * @param args (frame, event, arg)
+     * @return PyObject* None
+     */
+    static PyObject* threadStarted(PyObject* self, PyObject* args);
+
+    /**
+     * @brief 替换threading.Thread.start()的包装（在启动线程中调用）
+     *
+     * 启动线程属于某次运行时把它的调试上下文记在Thread对象上，新线程在threadStarted()中据此找到运行器。
+     * @param self 原来的Thread.start
+     * @param args (thread, ...)
+     * @param kwargs 关键字参数
+     * @return PyObject* 原方法的返回值
+     */
+    static PyObject* threadStarting(PyObject* self, PyObject* args, PyObject* kwargs);
+
+    /**
+     * @brief 用户线程结束（线程局部变量析构时调用，不持有GIL）
+     * @param context 线程的调试上下文
+     */
+    static void threadExited(ThreadContext* context);
+
+    /**
+     * @brief 登记当前线程并按需挂载追踪函数（在新线程中调用，需持有GIL）
+     */
+    void registerThread();
+
+    /**
+     * @brief 在threading中安装或移除线程启动钩子（需持有GIL，保留未处理的异常）
+     * @param install 安装为true；移除时只移除本程序安装的钩子
+     */
+    static void setThreadStartHook(bool install);
+
+    /**
+     * @brief 运行中的线程列表（调用方持有s_threadMutex）
+     * @return QVector<DebugThread> 线程列表
+     */
+    QVector<DebugThread> debugThreads() const;
+
+    /**
+     * @brief 判断线程是否为选中的调试线程
+     * @param context 线程的调试上下文
+     * @return bool 是返回true
+     */
+    bool isDebugTarget(const ThreadContext* context) const;
+
+    /**
+     * @brief 单步状态下行事件是否需要暂停（按线程自己的调用深度判断逐过程和跳出）
+     * @param context 线程的调试上下文
+     * @param state 调试状态
+     * @return bool 需要暂停返回true
+     */
+    bool shouldStep(const ThreadContext* context, DebugState state) const;
+
     /**
      * @brief Python追踪函数
      * @param obj 调用对象
@@ -144,6 +552,90 @@ private:
      */
     static int pythonTraceFunction(PyObject* obj, PyFrameObject* frame, int event, PyObject* arg);
 
+    /**
+     * @brief 判断栈帧是否属于编辑器中的用户代码
+     *
+     * 分类结果缓存在代码对象的extra槽中，每个代码对象只比较一次文件名。
+     * @param frame Python栈帧
+     * @return bool 用户代码返回true
+     */
+    static bool isUserFrame(PyFrameObject* frame);
+
+    /**
+     * @brief 判断代码对象是否属于编辑器中的用户代码（结果缓存在extra槽中）
+     * @param code 代码对象
+     * @return bool 用户代码返回true
+     */
+    static bool isUserCode(PyCodeObject* code);
+
+    /**
+     * @brief sys.monitoring行事件处理
+     *
+     * 库代码、未命中断点的行以及逐过程和跳出跳过的函数中的行返回DISABLE，之后这些位置不再产生事件。
+     * @param code 代码对象
+     * @param line 行号
+     * @return MonitoringHook::Action 是否关闭该位置
+     */
+    static MonitoringHook::Action monitorLine(PyCodeObject* code, int line);
+
+    /**
+     * @brief sys.monitoring函数进入/返回事件处理
+     *
+     * 用户代码首次进入时开启其行事件；自由运行状态下返回DISABLE。
+     * @param code 代码对象
+     * @param entering 进入为true，返回为false
+     * @return MonitoringHook::Action 是否关闭该位置
+     */
+    static MonitoringHook::Action monitorFrame(PyCodeObject* code, bool entering);
+
+    /**
+     * @brief 开启或关闭栈帧的行事件（库代码的栈帧，以及逐过程和跳出时跳过的函数）
+     * @param frame Python栈帧
+     * @param enabled 开启为true
+     */
+    static void setLineEvents(PyFrameObject* frame, bool enabled);
+
+    /**
+     * @brief 读取extra槽中缓存的用户代码最后一行
+     * @param code 代码对象（已由isUserCode()分类）
+     * @return int 行号，库代码或未知时为0
+     */
+    static int userCodeLastLine(PyCodeObject* code);
+
+    /**
+     * @brief 遍历co_lines()计算代码对象的最后一行（分类时调用一次，保留正在传播的异常）
+     * @param code 代码对象
+     * @return int 行号，无法取得时为0
+     */
+    static int computeLastLine(PyCodeObject* code);
+
+    /**
+     * @brief 函数的行号范围（co_firstlineno到最后一行）内是否设置了断点
+     * @param code 用户代码对象
+     * @return bool 有断点或范围未知时返回true
+     */
+    bool hasBreakpointIn(PyCodeObject* code) const;
+
+    /**
+     * @brief 逐过程和跳出时能否关闭该栈帧的行事件
+     *
+     * 设置了断点的函数、生成器和协程，以及正在逐行统计或录制的运行线程保留行事件。
+     * 跳过期间新设置的断点在已关闭行事件的栈帧中不生效，之后的调用照常命中。
+     * @param context 线程的调试上下文
+     * @param frame 用户代码栈帧
+     * @return bool 可以关闭返回true
+     */
+    bool canSkipLines(const ThreadContext* context, PyFrameObject* frame) const;
+
+    /**
+     * @brief 从暂停恢复时准备下一次单步（在调试线程中调用，需持有GIL）
+     *
+     * 追踪函数后端重新开启栈上用户代码栈帧的行事件（之前的单步可能关闭过），跳出时关闭当前栈帧的行事件；
+     * sys.monitoring后端记下栈上的用户代码，跳过的函数只关闭不属于它们的位置。
+     * @param context 线程的调试上下文
+     */
+    void prepareStep(ThreadContext* context);
+
     /**
      * @brief 获取行号
      * @param frame Python栈帧
@@ -161,8 +653,22 @@ private:
     /**
      * @brief 安全的Python代码执行
      * @param code Python代码
+     * @param profiling 是否进行逐行性能分析
+     * @param sampling 是否进行采样分析
+     * @param memory 是否统计内存
+     * @param objects 是否做对象存活诊断
+     * @param recording 是否录制
+     * @param recordLocals 录制时是否记录局部变量
+     * @param budgets 时间和内存预算
      */
-    void executePythonCodeSafely(const QString& code);
+    void executePythonCodeSafely(const QString&              code,
+                                 bool                        profiling,
+                                 bool                        sampling,
+                                 bool                        memory,
+                                 bool                        objects,
+                                 bool                        recording,
+                                 bool                        recordLocals,
+                                 const RunWatchdog::Budgets& budgets);
 
     /**
      * @brief 处理Python异常
@@ -177,14 +683,274 @@ private:
      */
     bool isBreakpoint(int lineNumber) const;
 
+    /**
+     * @brief 执行到断点行时判断是否暂停（计数命中次数、求值条件、输出日志点，需持有GIL）
+     * @param frame 当前栈帧
+     * @param lineNumber 行号
+     * @return bool 需要暂停返回true
+     */
+    bool shouldBreak(PyFrameObject* frame, int lineNumber);
+
+    /**
+     * @brief 把日志点消息写入输出通道（在运行线程中调用）
+     *
+     * 与writeOutput()不同，通道已满时直接丢弃并计数，不等待界面线程。
+     * @param lineNumber 日志点所在行
+     * @param message UTF-8消息
+     */
+    void writeLogpoint(int lineNumber, const QByteArray& message);
+
+    /**
+     * @brief 判断当前是否需要追踪钩子
+     * @return bool 存在断点或处于暂停/单步状态时返回true
+     */
+    bool isTraceHookRequired() const;
+
+    /**
+     * @brief 判断线程是否需要追踪函数
+     *
+     * 分析、录制和强制停止只作用于运行线程；断点、暂停和单步只作用于选中的调试线程。
+     * @param context 线程的调试上下文
+     * @return bool 需要返回true
+     */
+    bool isTraceHookRequired(const ThreadContext* context) const;
+
+    /**
+     * @brief 根据首选后端和运行时Python版本选择本次运行的调试后端（需持有GIL）
+     */
+    void selectDebugBackend();
+
+    /**
+     * @brief 按当前调试状态挂载或刷新调试钩子（需持有GIL）
+     *
+     * PyEval_SetTrace后端在需要追踪的线程上各挂载一次（Python 3.13起见attachTraceHook()）；sys.monitoring后端按是否处于暂停/单步切换全局事件，
+     * 为调试线程栈上的用户代码开启行事件，并重新开启返回过DISABLE的位置。
+     */
+    void attachDebugHook();
+
+    /**
+     * @brief 在线程上挂载PyEval_SetTrace追踪函数（需持有GIL，调用方保证线程状态有效）
+     *
+     * Python 3.13起不再公开为其他线程设置追踪函数的接口，改用PyEval_SetTraceAllThreads挂载到所有线程，
+     * 不需要追踪的线程在下一个事件中自行卸载。
+     * @param context 线程的调试上下文
+     */
+    void attachTraceHook(ThreadContext* context);
+
+    /**
+     * @brief 为线程栈上的用户代码开启sys.monitoring行事件（需持有GIL）
+     *
+     * 运行中途挂载时，已经开始执行的栈帧不会再产生函数进入事件。
+     * @param state 线程状态
+     */
+    void armRunningFrames(PyThreadState* state);
+
+    /**
+     * @brief 请求在运行线程上挂载追踪钩子（可在任意线程调用）
+     *
+     * 挂载操作需要GIL，因此投递到控制线程池中完成，调用线程不会阻塞。
+     */
+    void requestTraceHook();
+
+    /**
+     * @brief 不再需要追踪时卸载当前线程的钩子（在被追踪的线程中调用，需持有GIL）
+     * @param context 当前线程的调试上下文
+     * @return bool 钩子已卸载返回true
+     */
+    bool releaseTraceHookIfIdle(ThreadContext* context);
+
+    /**
+     * @brief 无条件卸载所有线程的追踪钩子，解除用户线程与运行器的关联并清除运行线程状态（需持有GIL）
+     */
+    void detachTraceHook();
+
+    /**
+     * @brief 在运行线程中抛出中止异常（需持有GIL）
+     */
+    void raiseAbortException();
+
+    /**
+     * @brief 监视中止过程，超过宽限期后升级为强制停止（在控制线程池中运行）
+     */
+    void superviseAbort();
+
+    /**
+     * @brief 把Python输出写入输出通道（在运行线程中调用，需持有GIL）
+     *
+     * 通道已满时释放GIL等待界面线程取走数据，形成反压。
+     * @param stream 输出流（0为标准输出，1为标准错误）
+     * @param data UTF-8数据
+     * @param size 字节数
+     */
+    void writeOutput(int stream, const char* data, int size);
+
+    /**
+     * @brief 把一次追踪事件计入逐行统计（在运行线程中调用）
+     *
+     * 每个用户代码栈帧记录当前行及其开始时刻，下一个行事件或返回事件时把经过的时间计入该行。
+     * @param event 追踪事件类型
+     * @param lineNumber 行号
+     */
+    void profileEvent(int event, int lineNumber);
+
+    /**
+     * @brief 进入暂停状态并等待调试命令（在调试线程中调用，需持有GIL）
+     *
+     * 只有这里会使用互斥量和条件变量，等待期间释放GIL，其他线程继续运行。
+     * 恢复运行时记录当前线程的调用深度，作为逐过程和跳出的基准，并由prepareStep()准备行事件。
+     * @param lineNumber 暂停所在行号
+     */
+    void pauseAndWait(int lineNumber);
+
+    /**
+     * @brief 停止录制并发布结果（在运行线程中调用，钩子已卸载）
+     */
+    void finishRecording();
+
+    /**
+     * @brief 解除运行线程的输出绑定；全局输出仍指向本运行器时恢复到默认目标（持有GIL）
+     */
+    void releaseOutput();
+
+    /**
+     * @brief 求值所有监视表达式并发出watchesReady()（在运行线程中调用，需持有GIL，不持有m_debugMutex）
+     */
+    void evaluateWatches();
+
+    /**
+     * @brief 调试钩子的事件计数和计时（RAII，在运行线程中使用）
+     */
+    struct TraceTimer;
+
+    // 用户线程的线程局部变量，析构时（线程结束）调用threadExited()
+    friend struct ThreadSlot;
+
 private:
-    bool           m_isExecuting    = false;
-    bool           m_shouldAbort    = false;
-    int            m_executionDelay = 0;
-    int            m_currentLine    = -1;
-    DebugState     m_debugState     = Running;
-    QSet<int>      m_breakpoints;     // 断点行号集合
-    int            m_callDepth = 0;   // 当前调用深度，用于逐过程和跳出
+    // 追踪函数快速路径读取的状态均为原子变量
+    std::atomic<bool>       m_isExecuting{false};
+    std::atomic<bool>       m_shouldAbort{false};
+    std::atomic<bool>       m_hardStop{false};          // 已升级为强制停止
+    std::atomic<qint64>     m_abortRequestedNs{0};      // 请求中止的时刻（单调时钟），0表示未请求
+    std::atomic<DebugState> m_debugState{Running};
+    int                     m_currentLine = -1;
+
+    // 断点表：不可变表，通过原子指针整体替换（nullptr表示没有断点）
+    std::atomic<const BreakpointTable*>                 m_breakpoints{nullptr};
+    std::vector<std::unique_ptr<const BreakpointTable>> m_retiredBreakpoints;   // 待回收的旧断点表
+    QMutex                                              m_breakpointMutex;      // 仅用于串行化写入方
+    QVector<Breakpoint>                                 m_breakpointList;       // 最近设置的断点，由m_breakpointMutex保护
+
+    // 执行行通道：运行线程通过裸指针写入，其他线程通过shared_ptr原子读取
+    std::shared_ptr<LineChannel> m_lineChannel;
+    LineChannel*                 m_activeLineChannel = nullptr;
+
+    // 逐行性能分析：运行线程通过裸指针写入，其他线程通过shared_ptr原子读取
+    struct ProfileFrame
+    {
+        int    line;     // 栈帧当前所在行，-1表示尚未执行任何行
+        qint64 wallNs;   // 该行开始时的墙钟时间
+        qint64 cpuNs;    // 该行开始时的线程CPU时间
+    };
+    std::atomic<bool>            m_profilingRequested{false};
+    std::atomic<bool>            m_profiling{false};   // 本次运行是否为分析运行
+    std::shared_ptr<LineProfile> m_lineProfile;
+    LineProfile*                 m_activeProfile = nullptr;
+    std::vector<ProfileFrame>    m_profileStack;       // 用户代码栈帧（仅运行线程访问）
+
+    // 采样分析：结果在运行结束时发布
+    std::atomic<bool>           m_samplingRequested{false};
+    std::atomic<int>            m_samplingRate{1000};
+    SamplingProfiler            m_sampler;
+    std::shared_ptr<FlameGraph> m_flameGraph;
+
+    // 内存统计：结果在运行结束时发布，跨运行的增长在统计器中累计
+    std::atomic<bool>             m_memoryRequested{false};
+    MemoryProfiler                m_memoryProfiler;
+    std::shared_ptr<MemoryReport> m_memoryReport;
+
+    // 录制运行：追踪函数在运行线程中编码，后台线程写文件，结果在运行结束时发布
+    std::atomic<bool>                   m_recording{false};   // 本次运行是否为录制运行
+    ExecutionRecorder                   m_recorder;
+    ExecutionRecorder*                  m_activeRecorder = nullptr;
+    std::shared_ptr<ExecutionRecording> m_recordingResult;
+    mutable QMutex                      m_recordingMutex;     // 保护m_recordingPath和m_namespaceContext
+    QString                             m_recordingPath;
+    QString                             m_namespaceContext;   // 会话命名空间上下文
+
+    // 时间和内存预算：runCode()使用的默认值，以及监视本次运行的线程
+    mutable QMutex       m_budgetMutex;
+    RunWatchdog::Budgets m_budgets;
+    RunWatchdog          m_watchdog;
+
+    // Python输出通道：运行线程写入，界面线程批量读取
+    OutputChannel m_outputChannel;
+
+    // 图像通道：运行开始时绑定到运行线程
+    mutable QMutex                        m_frameMutex;
+    mutable std::shared_ptr<FrameChannel> m_frameChannel;
+
+    // 运行期间绑定到运行线程的输出回调、可中断等待和标准输入，多个运行器同时运行时互不影响；
+    // 运行中启动的用户线程继承中断门（线程持有引用，可以比运行器活得更久）
+    std::function<void(int, const char*, int)> m_pythonOutput;
+    std::shared_ptr<InterruptGate>             m_interruptGate = std::make_shared<InterruptGate>();
+    InputQueue                                 m_input;
+    QMutex                                     m_abortMutex;   // 串行化中止时的打断和运行结束时的清除中断
+    bool m_holdsThreadHook = false;   // 本次运行计入了线程启动钩子的使用者（仅运行线程访问）
+
+    // 运行指标（仅运行线程访问，运行结束时写入RunSummary）
+    qint64 m_traceEvents      = 0;
+    qint64 m_traceNs          = 0;
+    qint64 m_pausedNs         = 0;       // 暂停等待调试命令的累计时间，从钩子耗时中扣除
+    qint64 m_outputBytes      = 0;
+    qint64 m_outputNewlines   = 0;
+    bool   m_outputLineOpen   = false;   // 最后一次输出不以换行结尾
+    qint64 m_logpointHits     = 0;       // 日志点输出（含丢弃的）
+    qint64 m_logpointsDropped = 0;
+
+    // 仅在暂停等待调试命令时使用
     QMutex         m_debugMutex;
     QWaitCondition m_debugCondition;
+
+    // 暂停时的变量查看：请求由m_debugMutex保护，查看器只在运行线程中持有GIL时访问
+    struct VariableRequest
+    {
+        quint64 handle;
+        int     start;
+        int     count;
+    };
+    QVector<VariableRequest> m_variableRequests;
+    VariableInspector        m_variableInspector;
+
+    // 监视表达式：新列表由m_debugMutex保护，编译和求值只在运行线程中持有GIL时进行
+    QStringList m_watchExpressions;
+    bool        m_watchesChanged = false;
+    WatchList   m_watchList;
+
+    // 追踪钩子按需挂载状态
+    PyThreadState*    m_threadState = nullptr;   // 运行线程的Python线程状态（仅在持有GIL时访问）
+    unsigned long     m_threadId    = 0;         // 运行线程标识，用于PyThreadState_SetAsyncExc
+    std::atomic<bool> m_monitoringAttached{false};   // sys.monitoring事件是否已开启
+
+    // 调试线程：运行线程和运行期间启动的用户线程各有一个上下文，列表由s_threadMutex保护，
+    // 运行结束时清空；上下文中的调用深度只由该线程自己访问
+    std::vector<std::shared_ptr<ThreadContext>> m_threads;
+    std::shared_ptr<ThreadContext>              m_mainThread;            // 运行线程（仅在持有GIL时访问）
+    std::atomic<unsigned long>                  m_selectedThread{0};     // 选中的调试线程，0表示运行线程
+    std::atomic<unsigned long>                  m_steppingThread{0};     // 最近一次从暂停恢复的线程
+    QThreadPool       m_controlPool;             // 执行需要GIL的控制操作，避免阻塞UI线程
+
+    // 运行请求队列
+    RunScheduler m_scheduler;
+
+    // 运行线程的asyncio事件循环（子对象，随运行器移动到运行线程）
+    AsyncioLoop* m_asyncioLoop = nullptr;
+
+    // 调试后端
+    std::atomic<DebugBackend>       m_preferredBackend{MonitoringBackend};
+    std::atomic<DebugBackend>       m_activeBackend{TraceBackend};
+    std::unique_ptr<MonitoringHook> m_monitoringHook;   // 首次使用时创建（仅在持有GIL时访问）
 };
+
+Q_DECLARE_METATYPE(CodeRunner::RunSummary)
+Q_DECLARE_METATYPE(CodeRunner::DebugThread)
+Q_DECLARE_METATYPE(QVector<CodeRunner::DebugThread>)
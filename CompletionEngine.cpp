@@ -0,0 +1,743 @@
+#include "CompletionEngine.h"
+#include "PythonInterpreterManager.h"
+#include "PythonLexer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace {
+
+// Python关键字（含软关键字match、case）
+const char* const kKeywords[] = {"False",  "None",   "True",    "and",      "as",       "assert", "async",
+                                 "await",  "break",  "case",    "class",    "continue", "def",    "del",
+                                 "elif",   "else",   "except",  "finally",  "for",      "from",   "global",
+                                 "if",     "import", "in",      "is",       "lambda",   "match",  "nonlocal",
+                                 "not",    "or",     "pass",    "raise",    "return",   "try",    "while",
+                                 "with",   "yield"};
+
+const QSet<QString>& keywordSet()
+{
+    static const QSet<QString> keywords = []() {
+        QSet<QString> set;
+        for (const char* keyword : kKeywords) {
+            set.insert(QLatin1String(keyword));
+        }
+        return set;
+    }();
+    return keywords;
+}
+
+bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+bool isIdentifier(const QString& name)
+{
+    if (name.isEmpty() || name[0].isDigit()) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), isIdentifierChar);
+}
+
+// 逐个读取一行代码中的名字和符号（字符串和注释已替换为空格）
+class LineReader
+{
+public:
+    explicit LineReader(const QString& code)
+        : m_code(code)
+    {
+    }
+
+    bool atEnd()
+    {
+        skipSpaces();
+        return m_pos >= m_code.size();
+    }
+
+    QChar peek()
+    {
+        skipSpaces();
+        return m_pos < m_code.size() ? m_code[m_pos] : QChar();
+    }
+
+    // 紧跟在当前符号之后的字符（用于区分=和==）
+    QChar peekNext() const
+    {
+        return m_pos + 1 < m_code.size() ? m_code[m_pos + 1] : QChar();
+    }
+
+    bool accept(QChar c)
+    {
+        if (peek() != c) {
+            return false;
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool acceptWord(QLatin1String word)
+    {
+        skipSpaces();
+        const int end = m_pos + word.size();
+        if (m_code.midRef(m_pos, word.size()) != word || (end < m_code.size() && isIdentifierChar(m_code[end]))) {
+            return false;
+        }
+        m_pos = end;
+        return true;
+    }
+
+    QString identifier()
+    {
+        skipSpaces();
+        if (m_pos >= m_code.size() || m_code[m_pos].isDigit()) {
+            return QString();
+        }
+        const int start = m_pos;
+        while (m_pos < m_code.size() && isIdentifierChar(m_code[m_pos])) {
+            ++m_pos;
+        }
+        return m_code.mid(start, m_pos - start);
+    }
+
+    // 点分名字，如os.path
+    QString dottedName()
+    {
+        QString name = identifier();
+        while (!name.isEmpty() && m_pos < m_code.size() && m_code[m_pos] == '.') {
+            ++m_pos;
+            const QString part = identifier();
+            if (part.isEmpty()) {
+                break;
+            }
+            name += '.' + part;
+        }
+        return name;
+    }
+
+    // 跳过一个名字或一个符号
+    void skip()
+    {
+        if (identifier().isEmpty() && m_pos < m_code.size()) {
+            ++m_pos;
+        }
+    }
+
+private:
+    void skipSpaces()
+    {
+        while (m_pos < m_code.size() && m_code[m_pos].isSpace()) {
+            ++m_pos;
+        }
+    }
+
+    const QString& m_code;
+    int            m_pos = 0;
+};
+
+// import a.b as c / import a.b
+void scanImport(LineReader& reader, CompletionEngine::LineSymbols* symbols)
+{
+    do {
+        const QString module = reader.dottedName();
+        if (module.isEmpty()) {
+            return;
+        }
+        if (reader.acceptWord(QLatin1String("as"))) {
+            const QString alias = reader.identifier();
+            if (!alias.isEmpty()) {
+                symbols->imports.append(qMakePair(alias, module));
+            }
+        }
+        else {
+            // import a.b绑定的是a
+            const QString top = module.section('.', 0, 0);
+            symbols->imports.append(qMakePair(top, top));
+        }
+    } while (reader.accept(','));
+}
+
+// from m import x as y, z
+void scanFromImport(LineReader& reader, CompletionEngine::LineSymbols* symbols)
+{
+    QString module;
+    while (reader.accept('.')) {
+        module += '.';   // 相对导入
+    }
+    module += reader.dottedName();
+    if (module.isEmpty() || !reader.acceptWord(QLatin1String("import"))) {
+        return;
+    }
+    reader.accept('(');
+    do {
+        const QString name = reader.identifier();
+        if (name.isEmpty()) {
+            return;
+        }
+        QString alias = name;
+        if (reader.acceptWord(QLatin1String("as"))) {
+            alias = reader.identifier();
+            if (alias.isEmpty()) {
+                return;
+            }
+        }
+        symbols->imports.append(qMakePair(alias, module + '.' + name));
+    } while (reader.accept(','));
+}
+
+// 赋值语句的目标：a = / a, b = / a: int = / self.x =
+void scanAssignment(LineReader& reader, CompletionEngine::LineSymbols* symbols)
+{
+    QStringList names;
+    QStringList attributes;
+    do {
+        reader.accept('(');
+        reader.accept('[');
+        reader.accept('*');
+        const QString name = reader.identifier();
+        if (name.isEmpty() || keywordSet().contains(name)) {
+            return;
+        }
+        if (name == "self" && reader.accept('.')) {
+            const QString attribute = reader.identifier();
+            if (attribute.isEmpty()) {
+                return;
+            }
+            attributes.append(attribute);
+        }
+        else {
+            const QChar next = reader.peek();
+            if (next == '.' || next == '[' || next == '(') {
+                return;   // 属性、下标或调用
+            }
+            names.append(name);
+        }
+        reader.accept(')');
+        reader.accept(']');
+    } while (reader.accept(','));
+
+    const QChar next      = reader.peek();
+    const bool  annotated = next == ':' && names.size() + attributes.size() == 1;
+    const bool  assigned  = next == '=' && reader.peekNext() != '=';
+    if (annotated || assigned) {
+        symbols->names += names;
+        symbols->attributes += attributes;
+    }
+}
+
+}   // namespace
+
+CompletionEngine::LineSymbols CompletionEngine::scanLine(const QString& line, int state)
+{
+    LineSymbols                 symbols;
+    QVector<PythonLexer::Token> tokens;
+    symbols.endState = PythonLexer::lexLine(line, state, &tokens);
+
+    // 括号内或字符串中的续行不是语句的开头
+    if (PythonLexer::isInString(state) || PythonLexer::bracketDepth(state) > 0) {
+        return symbols;
+    }
+
+    // 字符串和注释不参与分析
+    QString code = line;
+    for (const PythonLexer::Token& token : tokens) {
+        if (token.kind == PythonLexer::String || token.kind == PythonLexer::Comment) {
+            for (int i = token.start; i < token.start + token.length && i < code.size(); ++i) {
+                code[i] = ' ';
+            }
+        }
+    }
+
+    LineReader reader(code);
+    reader.acceptWord(QLatin1String("async"));
+    if (reader.acceptWord(QLatin1String("def")) || reader.acceptWord(QLatin1String("class"))) {
+        const QString name = reader.identifier();
+        if (!name.isEmpty()) {
+            symbols.names.append(name);
+        }
+    }
+    else if (reader.acceptWord(QLatin1String("import"))) {
+        scanImport(reader, &symbols);
+    }
+    else if (reader.acceptWord(QLatin1String("from"))) {
+        scanFromImport(reader, &symbols);
+    }
+    else if (reader.acceptWord(QLatin1String("for"))) {
+        do {
+            reader.accept('(');
+            const QString name = reader.identifier();
+            if (name.isEmpty()) {
+                break;
+            }
+            symbols.names.append(name);
+            reader.accept(')');
+        } while (reader.accept(','));
+    }
+    else if (reader.acceptWord(QLatin1String("with")) || reader.acceptWord(QLatin1String("except"))) {
+        // with open(f) as fp / except E as e
+        while (!reader.atEnd()) {
+            if (reader.acceptWord(QLatin1String("as"))) {
+                const QString name = reader.identifier();
+                if (!name.isEmpty()) {
+                    symbols.names.append(name);
+                }
+            }
+            else {
+                reader.skip();
+            }
+        }
+    }
+    else {
+        scanAssignment(reader, &symbols);
+    }
+    return symbols;
+}
+
+CompletionEngine::CompletionEngine(QObject* parent)
+    : QObject(parent)
+{
+    m_thread = std::thread(&CompletionEngine::workerLoop, this);
+}
+
+CompletionEngine::~CompletionEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void CompletionEngine::complete(quint64 id, const QString& text, int position, bool forced)
+{
+    std::unique_ptr<Request> request(new Request);
+    request->id       = id;
+    request->text     = text;
+    request->position = position;
+    request->forced   = forced;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_request = std::move(request);
+    }
+    m_wake.notify_one();
+}
+
+void CompletionEngine::workerLoop()
+{
+    for (;;) {
+        std::unique_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_request || m_stopping; });
+            if (m_stopping) {
+                break;
+            }
+            request = std::move(m_request);
+        }
+
+        QString           prefix;
+        const QStringList candidates = candidatesFor(*request, &prefix);
+        if (superseded()) {
+            continue;   // 已有更新的请求，结果不再需要
+        }
+        const quint64 id = request->id;
+        QMetaObject::invokeMethod(
+            this, [this, id, prefix, candidates]() { emit completed(id, prefix, candidates); }, Qt::QueuedConnection);
+    }
+}
+
+QStringList CompletionEngine::candidatesFor(const Request& request, QString* prefix)
+{
+    const QString& text      = request.text;
+    const int      position  = qBound(0, request.position, text.size());
+    const int      lineStart = position > 0 ? text.lastIndexOf('\n', position - 1) + 1 : 0;
+    const QString  before    = text.mid(lineStart, position - lineStart);
+
+    int start = before.size();
+    while (start > 0 && isIdentifierChar(before[start - 1])) {
+        --start;
+    }
+    *prefix = before.mid(start);
+    if (!prefix->isEmpty() && prefix->at(0).isDigit()) {
+        return QStringList();   // 数字
+    }
+
+    // 光标在字符串或注释中时不补全（按本行单独分析）
+    QVector<PythonLexer::Token> tokens;
+    PythonLexer::lexLine(before, PythonLexer::kInitialState, &tokens);
+    for (const PythonLexer::Token& token : tokens) {
+        if ((token.kind == PythonLexer::String || token.kind == PythonLexer::Comment) &&
+            token.start + token.length >= before.size() && token.start < before.size()) {
+            return QStringList();
+        }
+    }
+
+    static const QRegularExpression importPattern(QStringLiteral("^\\s*(?:import\\s+(?:.*,\\s*)?|from\\s+)([\\w.]*)$"));
+    static const QRegularExpression fromImportPattern(
+        QStringLiteral("^\\s*from\\s+([\\w.]+)\\s+import\\s+(?:.*[,(]\\s*)?\\w*$"));
+    static const QRegularExpression attributePattern(QStringLiteral("([A-Za-z_][\\w.]*)\\.\\w*$"));
+
+    // import a.b / from a.b
+    QRegularExpressionMatch match = importPattern.match(before);
+    if (match.hasMatch()) {
+        if (!loadEnvironment() || superseded()) {
+            return QStringList();
+        }
+        const QString path = match.captured(1);
+        const int     dot  = path.lastIndexOf('.');
+        QSet<QString> names;
+        for (const QString& name : dot < 0 ? topLevelModules() : submodules(path.left(dot))) {
+            names.insert(name);
+        }
+        return rank(names, *prefix);
+    }
+
+    indexBuffer(text.split('\n'));
+    if (superseded()) {
+        return QStringList();
+    }
+
+    // from m import x
+    match = fromImportPattern.match(before);
+    if (match.hasMatch()) {
+        const QString module = match.captured(1);
+        QSet<QString> names;
+        for (const QString& name : moduleMembers(module) + submodules(module)) {
+            names.insert(name);
+        }
+        return rank(names, *prefix);
+    }
+
+    // obj.attr
+    match = attributePattern.match(before);
+    if (match.hasMatch()) {
+        const QString expression = match.captured(1);
+        if (expression.endsWith('.')) {
+            return QStringList();
+        }
+        if (expression == "self") {
+            return rank(m_bufferAttributes, *prefix);
+        }
+        // 只补全导入的模块（及其子模块）
+        const QString first = expression.section('.', 0, 0);
+        auto          it    = m_bufferImports.constFind(first);
+        if (it == m_bufferImports.constEnd()) {
+            return QStringList();
+        }
+        const QString module = it.value() + expression.mid(first.size());
+        QSet<QString> names;
+        for (const QString& name : moduleMembers(module) + submodules(module)) {
+            names.insert(name);
+        }
+        return rank(names, *prefix);
+    }
+
+    if (start > 0 && before[start - 1] == '.') {
+        return QStringList();   // 其他表达式的属性
+    }
+    if (prefix->isEmpty() && !request.forced) {
+        return QStringList();
+    }
+
+    QSet<QString> names = m_bufferNames;
+    for (auto it = m_bufferImports.constBegin(); it != m_bufferImports.constEnd(); ++it) {
+        names.insert(it.key());
+    }
+    for (const QString& keyword : keywordSet()) {
+        names.insert(keyword);
+    }
+    if (loadEnvironment()) {
+        for (const QString& name : m_builtins) {
+            names.insert(name);
+        }
+    }
+    return rank(names, *prefix);
+}
+
+void CompletionEngine::indexBuffer(const QStringList& lines)
+{
+    m_bufferNames.clear();
+    m_bufferAttributes.clear();
+    m_bufferImports.clear();
+
+    // 缓存中多为已删除或改过的行时重建
+    const bool                  prune = m_lineCache.size() > 4 * lines.size() + 1024;
+    QHash<quint64, LineSymbols> kept;
+
+    int state = PythonLexer::kInitialState;
+    for (const QString& line : lines) {
+        const quint64 key = (quint64(qHash(line)) << 32) | quint32(state);
+        auto          it  = m_lineCache.constFind(key);
+        if (it == m_lineCache.constEnd()) {
+            it = m_lineCache.insert(key, scanLine(line, state));
+        }
+        const LineSymbols& symbols = it.value();
+        for (const QString& name : symbols.names) {
+            m_bufferNames.insert(name);
+        }
+        for (const QString& attribute : symbols.attributes) {
+            m_bufferAttributes.insert(attribute);
+        }
+        for (const auto& import : symbols.imports) {
+            m_bufferImports.insert(import.first, import.second);
+        }
+        if (prune) {
+            kept.insert(key, symbols);
+        }
+        state = symbols.endState;
+    }
+    if (prune) {
+        m_lineCache.swap(kept);
+    }
+}
+
+bool CompletionEngine::loadEnvironment()
+{
+    PythonInterpreterManager& manager = PythonInterpreterManager::instance();
+    if (!manager.isInitialized() || manager.isInitializing()) {
+        return false;
+    }
+    const quint64 generation = manager.generation();
+    if (m_environmentGeneration == generation) {
+        return true;
+    }
+
+    // 解释器重新初始化后（可能换了环境）重新读取
+    m_sysPath.clear();
+    m_builtinModules.clear();
+    m_builtins.clear();
+    m_modulesScanned = false;
+    m_topLevelModules.clear();
+    m_moduleMembers.clear();
+
+    // 用户代码运行期间在这里等待GIL，不影响界面线程；只读取一次
+    py::gil_scoped_acquire acquire;
+    try {
+        py::module_ sys = py::module_::import("sys");
+        for (py::handle path : sys.attr("path")) {
+            QString directory = QString::fromStdString(py::str(path).cast<std::string>());
+            m_sysPath.append(directory.isEmpty() ? QDir::currentPath() : directory);
+        }
+        for (py::handle name : sys.attr("builtin_module_names")) {
+            m_builtinModules.insert(QString::fromStdString(py::str(name).cast<std::string>()));
+        }
+        for (py::handle name : py::module_::import("builtins").attr("__dict__")) {
+            m_builtins.append(QString::fromStdString(py::str(name).cast<std::string>()));
+        }
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "Failed to read Python environment for completion:" << e.what();
+        m_sysPath.clear();
+        m_builtinModules.clear();
+        m_builtins.clear();
+        return false;
+    }
+    m_environmentGeneration = generation;
+    return true;
+}
+
+namespace {
+
+// 目录项对应的模块名，不是模块时为空
+QString moduleName(const QFileInfo& entry)
+{
+    QString name;
+    if (entry.isDir()) {
+        if (QFileInfo(QDir(entry.filePath()).filePath(QStringLiteral("__init__.py"))).isFile()) {
+            name = entry.fileName();
+        }
+    }
+    else if (entry.suffix() == "py") {
+        name = entry.completeBaseName();
+    }
+    else if (entry.suffix() == "so" || entry.suffix() == "pyd") {
+        name = entry.fileName().section('.', 0, 0);   // 如_ssl.cpython-311-x86_64-linux-gnu.so
+    }
+    return isIdentifier(name) && name != "__init__" ? name : QString();
+}
+
+QStringList modulesIn(const QString& directory)
+{
+    QSet<QString> names;
+    for (const QFileInfo& entry : QDir(directory).entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QString name = moduleName(entry);
+        if (!name.isEmpty()) {
+            names.insert(name);
+        }
+    }
+    return names.values();
+}
+
+}   // namespace
+
+const QStringList& CompletionEngine::topLevelModules()
+{
+    if (!m_modulesScanned && loadEnvironment()) {
+        QSet<QString> names = m_builtinModules;
+        for (const QString& directory : m_sysPath) {
+            for (const QString& name : modulesIn(directory)) {
+                names.insert(name);
+            }
+        }
+        m_topLevelModules = names.values();
+        m_modulesScanned  = true;
+    }
+    return m_topLevelModules;
+}
+
+QStringList CompletionEngine::submodules(const QString& package)
+{
+    QString packageDir;
+    findModule(package, &packageDir);
+    return packageDir.isEmpty() ? QStringList() : modulesIn(packageDir);
+}
+
+QString CompletionEngine::findModule(const QString& module, QString* packageDir) const
+{
+    const QString relative = QString(module).replace('.', '/');
+    for (const QString& directory : m_sysPath) {
+        const QString path = QDir(directory).filePath(relative);
+        if (QFileInfo(path + "/__init__.py").isFile()) {
+            *packageDir = path;
+            return path + "/__init__.py";
+        }
+        if (QFileInfo(path + ".py").isFile()) {
+            return path + ".py";
+        }
+        if (QFileInfo(path).isDir()) {
+            *packageDir = path;   // 命名空间包
+            return QString();
+        }
+    }
+    return QString();
+}
+
+QStringList CompletionEngine::moduleMembers(const QString& module)
+{
+    if (!loadEnvironment() || module.startsWith('.')) {
+        return QStringList();
+    }
+
+    QString       packageDir;
+    const QString path = findModule(module, &packageDir);
+    auto          it   = m_moduleMembers.find(module);
+    if (!path.isEmpty()) {
+        const QDateTime modified = QFileInfo(path).lastModified();
+        if (it != m_moduleMembers.end() && it->path == path && it->modified == modified) {
+            return it->names;
+        }
+
+        // 源文件的顶层定义
+        QSet<QString> names;
+        QFile         file(path);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream in(&file);
+            in.setCodec("UTF-8");
+            int state = PythonLexer::kInitialState;
+            while (!in.atEnd()) {
+                const QString     line    = in.readLine();
+                const LineSymbols symbols = scanLine(line, state);
+                if (!line.isEmpty() && !line[0].isSpace()) {
+                    for (const QString& name : symbols.names) {
+                        names.insert(name);
+                    }
+                    for (const auto& import : symbols.imports) {
+                        names.insert(import.first);
+                    }
+                }
+                state = symbols.endState;
+            }
+        }
+
+        ModuleEntry entry;
+        entry.path     = path;
+        entry.modified = modified;
+        entry.names    = names.values();
+        m_moduleMembers.insert(module, entry);
+        return entry.names;
+    }
+    if (it != m_moduleMembers.end()) {
+        return it->names;
+    }
+
+    // 没有源文件：只列出已导入的模块（内置模块导入没有副作用，可以直接导入）
+    QStringList names;
+    {
+        py::gil_scoped_acquire acquire;
+        try {
+            py::dict          modules = py::module_::import("sys").attr("modules");
+            const std::string key     = module.toStdString();
+            py::object        object;
+            if (modules.contains(key)) {
+                object = modules[key.c_str()];
+            }
+            else if (m_builtinModules.contains(module)) {
+                object = py::module_::import(key.c_str());
+            }
+            if (object) {
+                for (py::handle name : py::list(object.attr("__dir__")())) {
+                    names.append(QString::fromStdString(py::str(name).cast<std::string>()));
+                }
+            }
+        }
+        catch (py::error_already_set& e) {
+            qWarning() << "Failed to list module members for completion:" << e.what();
+        }
+    }
+    // 尚未导入的模块不缓存，导入后再列出
+    if (!names.isEmpty()) {
+        ModuleEntry entry;
+        entry.names = names;
+        m_moduleMembers.insert(module, entry);
+    }
+    return names;
+}
+
+bool CompletionEngine::superseded()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_request != nullptr || m_stopping;
+}
+
+QStringList CompletionEngine::rank(const QSet<QString>& names, const QString& prefix)
+{
+    // 大小写相同的匹配在前；前缀不以_开头时私有名字排在最后
+    QStringList exact;
+    QStringList others;
+    for (const QString& name : names) {
+        if (name == prefix) {
+            continue;
+        }
+        if (name.startsWith(prefix)) {
+            exact.append(name);
+        }
+        else if (name.startsWith(prefix, Qt::CaseInsensitive)) {
+            others.append(name);
+        }
+    }
+
+    const bool privateFirst = prefix.startsWith('_');
+    auto       lessThan     = [privateFirst](const QString& a, const QString& b) {
+        const bool aPrivate = a.startsWith('_');
+        const bool bPrivate = b.startsWith('_');
+        if (aPrivate != bPrivate && !privateFirst) {
+            return bPrivate;
+        }
+        return a.compare(b, Qt::CaseInsensitive) < 0;
+    };
+    std::sort(exact.begin(), exact.end(), lessThan);
+    std::sort(others.begin(), others.end(), lessThan);
+
+    QStringList ranked = exact + others;
+    if (ranked.size() > kMaxCandidates) {
+        ranked.erase(ranked.begin() + kMaxCandidates, ranked.end());
+    }
+    return ranked;
+}
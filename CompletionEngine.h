@@ -0,0 +1,182 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class CompletionEngine
+ * @brief 后台代码补全：C++实现的符号索引，不在每次按键时占用GIL
+ *
+ * 补全请求交给后台线程，只保留最新的一个请求，被新请求取代的请求不再计算（结果按编号丢弃）。
+ * 符号来源：
+ * - 缓冲区：按行提取def、class、import、赋值、for和as的名字以及self.属性。
+ *   每行的结果按（行内容，行首词法状态）缓存，编辑后只分析新出现的行
+ * - sys.path上的模块：第一次需要时扫描各目录得到顶层模块名，包的子模块按目录列出；
+ *   模块成员从源文件的顶层定义中提取，按文件修改时间缓存。
+ *   没有源文件的模块只在已经导入（在sys.modules中）时用dir()列出，不会为补全导入模块
+ * - 关键字，以及内置名（dir(builtins)）
+ *
+ * 只有读取sys.path、内置名和已导入模块的成员时才短暂获取GIL，且结果都会缓存。
+ * complete()只在界面线程中调用，completed()也在界面线程中发出。
+ */
+class CompletionEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 一次最多返回的候选数
+    static const int kMaxCandidates = 200;
+
+    /**
+     * @brief 一行中定义的符号
+     */
+    struct LineSymbols
+    {
+        QStringList                      names;          // 绑定的名字
+        QStringList                      attributes;     // self.属性
+        QVector<QPair<QString, QString>> imports;        // 导入的名字和对应的模块（可能是模块中的对象）
+        int                              endState = 0;   // 行尾的词法状态
+    };
+
+    /**
+     * @brief 提取一行中定义的符号（与界面无关，可在任意线程中调用）
+     * @param line 行文本
+     * @param state 行首的词法状态（PythonLexer）
+     * @return LineSymbols 符号和行尾状态
+     */
+    static LineSymbols scanLine(const QString& line, int state);
+
+    explicit CompletionEngine(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（停止后台线程）
+     */
+    ~CompletionEngine() override;
+
+    /**
+     * @brief 提交补全请求，取代尚未开始的请求
+     * @param id 请求编号，随结果原样返回
+     * @param text 缓冲区文本
+     * @param position 光标位置（字符偏移）
+     * @param forced 是否为手动触发（光标前没有输入名字时也列出候选）
+     */
+    void complete(quint64 id, const QString& text, int position, bool forced);
+
+signals:
+    /**
+     * @brief 补全完成
+     * @param id complete()传入的编号
+     * @param prefix 光标前已输入的部分名字
+     * @param candidates 候选，已按相关程度排序，可能为空
+     */
+    void completed(quint64 id, const QString& prefix, const QStringList& candidates);
+
+private:
+    // 一次补全请求
+    struct Request
+    {
+        quint64 id       = 0;
+        QString text;
+        int     position = 0;
+        bool    forced   = false;
+    };
+
+    // 模块成员缓存
+    struct ModuleEntry
+    {
+        QString     path;       // 源文件，空表示来自dir()
+        QDateTime   modified;
+        QStringList names;
+    };
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void workerLoop();
+
+    /**
+     * @brief 计算一个请求的候选
+     * @param request 请求
+     * @param prefix 输出光标前已输入的部分名字
+     * @return QStringList 排序后的候选
+     */
+    QStringList candidatesFor(const Request& request, QString* prefix);
+
+    /**
+     * @brief 更新缓冲区的符号（按行缓存）
+     * @param lines 缓冲区的行
+     */
+    void indexBuffer(const QStringList& lines);
+
+    /**
+     * @brief 第一次需要时读取sys.path、内置名和内置模块名（短暂获取GIL），解释器重新初始化后重新读取
+     * @return bool 解释器已就绪返回true
+     */
+    bool loadEnvironment();
+
+    /**
+     * @brief sys.path上的顶层模块名
+     */
+    const QStringList& topLevelModules();
+
+    /**
+     * @brief 包的子模块名
+     * @param package 包的完整名字
+     */
+    QStringList submodules(const QString& package);
+
+    /**
+     * @brief 模块的成员名
+     * @param module 模块的完整名字
+     */
+    QStringList moduleMembers(const QString& module);
+
+    /**
+     * @brief 在sys.path上查找模块
+     * @param module 模块的完整名字
+     * @param packageDir 是包时输出包目录
+     * @return QString 源文件路径，找不到或没有源文件时为空
+     */
+    QString findModule(const QString& module, QString* packageDir) const;
+
+    /**
+     * @brief 是否已有更新的请求在排队
+     */
+    bool superseded();
+
+    /**
+     * @brief 按前缀过滤并排序
+     */
+    static QStringList rank(const QSet<QString>& names, const QString& prefix);
+
+private:
+    // 以下只在后台线程中访问
+    QHash<quint64, LineSymbols>  m_lineCache;       // 按行内容和行首状态缓存
+    QSet<QString>                m_bufferNames;
+    QSet<QString>                m_bufferAttributes;
+    QHash<QString, QString>      m_bufferImports;   // 名字 -> 模块
+    quint64                      m_environmentGeneration = 0;   // 读取时的解释器代数，0表示未读取
+    QStringList                  m_sysPath;
+    QStringList                  m_builtins;
+    QSet<QString>                m_builtinModules;
+    bool                         m_modulesScanned = false;
+    QStringList                  m_topLevelModules;
+    QHash<QString, ModuleEntry>  m_moduleMembers;
+
+    // 后台线程，只保留最新的请求，由m_mutex保护
+    std::thread              m_thread;
+    std::mutex               m_mutex;
+    std::condition_variable  m_wake;
+    std::unique_ptr<Request> m_request;
+    bool                     m_stopping = false;
+};
@@ -1,9 +1,10 @@
 #include "ConfigManager.h"
-#include <QApplication>
+#include "PythonDetector.h"
+#include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
 #include <QStandardPaths>
-#include <QProcess>
+#include <QTimer>
 #include <QDebug>
 
 ConfigManager& ConfigManager::instance()
@@ -22,7 +23,7 @@ void ConfigManager::initialize(const QString& configFile)
     if (!configFile.isEmpty()) {
         m_configFile = configFile;
     } else {
-        QString appName = QApplication::applicationName();
+        QString appName = QCoreApplication::applicationName();
         QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
         QDir().mkpath(configDir);
         m_configFile = configDir + "/" + appName + ".ini";
@@ -32,6 +33,24 @@ void ConfigManager::initialize(const QString& configFile)
     m_settings = new QSettings(m_configFile, QSettings::IniFormat, this);
     m_settings->setParent(this);
 
+    // 连续的修改合并后在后台线程中写入
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &ConfigManager::save);
+    m_writer = std::thread(&ConfigManager::writerLoop, this);
+
+    // 后台检测发现新的环境时，只替换自动检测得到的设置，不覆盖用户指定的路径
+    m_detector = new PythonDetector(m_settings, this);
+    connect(m_detector,
+            &PythonDetector::refreshed,
+            this,
+            [this](const PythonDetector::Result& previous, const PythonDetector::Result& current) {
+                if (m_pythonHome == previous.home && !current.home.isEmpty()) {
+                    setPythonHome(current.home);
+                }
+            });
+
     // 加载配置
     load();
 
@@ -44,13 +63,26 @@ ConfigManager::ConfigManager(QObject* parent)
     , m_editorFont("Consolas")
     , m_editorFontSize(12)
     , m_autoSaveInterval(30)
-    , m_executionDelay(100)
+    , m_largeFileThreshold(16)
+    , m_replayStepInterval(100)
+    , m_outputMaxLines(100000)
     , m_theme("light")
+    , m_codeCacheDirectory(defaultCodeCacheDirectory())
 {
 }
 
 ConfigManager::~ConfigManager()
 {
+    // 提交剩余的修改，写入线程写完后退出
+    save();
+    if (m_writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            m_writerStopping = true;
+        }
+        m_writeWake.notify_one();
+        m_writer.join();
+    }
     if (m_settings) {
         m_settings->sync();
     }
@@ -65,7 +97,7 @@ void ConfigManager::setPythonHome(const QString& path)
 {
     if (m_pythonHome != path) {
         m_pythonHome = path;
-        m_settings->setValue("Python/home", m_pythonHome);
+        store("Python/home", m_pythonHome);
         emit configurationChanged();
         emit pythonPathsChanged();
     }
@@ -73,15 +105,16 @@ void ConfigManager::setPythonHome(const QString& path)
 
 QString ConfigManager::autoDetectPython()
 {
-    QString detectedPath;
-
-    // 首先尝试Conda环境
-    detectedPath = detectCondaPython();
-    if (detectedPath.isEmpty()) {
-        // 然后尝试系统Python
-        detectedPath = detectSystemPython();
+    // 首先尝试Conda环境，然后尝试系统Python（PythonDetector按此优先级选择）
+    PythonDetector::Result result;
+    if (m_detector->cachedResult(&result)) {
+        m_detector->refreshInBackground();
+    }
+    else {
+        result = m_detector->detectNow();
     }
 
+    const QString detectedPath = result.home;
     if (!detectedPath.isEmpty()) {
         setPythonHome(detectedPath);
         qDebug() << "Auto-detected Python at:" << detectedPath;
@@ -99,11 +132,39 @@ void ConfigManager::addPythonPath(const QString& path)
 {
     if (!m_pythonPaths.contains(path)) {
         m_pythonPaths.append(path);
-        m_settings->setValue("Python/paths", m_pythonPaths);
+        store("Python/paths", m_pythonPaths);
         emit pythonPathsChanged();
     }
 }
 
+QStringList ConfigManager::getWarmUpModules() const
+{
+    return m_warmUpModules;
+}
+
+void ConfigManager::setWarmUpModules(const QStringList& modules)
+{
+    if (m_warmUpModules != modules) {
+        m_warmUpModules = modules;
+        store("Python/warmUpModules", m_warmUpModules);
+        emit configurationChanged();
+    }
+}
+
+QStringList ConfigManager::getPluginPaths() const
+{
+    return m_pluginPaths;
+}
+
+void ConfigManager::setPluginPaths(const QStringList& paths)
+{
+    if (m_pluginPaths != paths) {
+        m_pluginPaths = paths;
+        store("Python/pluginPaths", m_pluginPaths);
+        emit configurationChanged();
+    }
+}
+
 QString ConfigManager::getEditorFont() const
 {
     return m_editorFont;
@@ -113,7 +174,7 @@ void ConfigManager::setEditorFont(const QString& font)
 {
     if (m_editorFont != font) {
         m_editorFont = font;
-        m_settings->setValue("Editor/font", m_editorFont);
+        store("Editor/font", m_editorFont);
         emit editorSettingsChanged();
     }
 }
@@ -127,7 +188,7 @@ void ConfigManager::setEditorFontSize(int size)
 {
     if (m_editorFontSize != size && size > 5 && size < 72) {
         m_editorFontSize = size;
-        m_settings->setValue("Editor/fontSize", m_editorFontSize);
+        store("Editor/fontSize", m_editorFontSize);
         emit editorSettingsChanged();
     }
 }
@@ -141,21 +202,245 @@ void ConfigManager::setAutoSaveInterval(int seconds)
 {
     if (m_autoSaveInterval != seconds && seconds > 0) {
         m_autoSaveInterval = seconds;
-        m_settings->setValue("Editor/autoSaveInterval", m_autoSaveInterval);
+        store("Editor/autoSaveInterval", m_autoSaveInterval);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getLargeFileThreshold() const
+{
+    return m_largeFileThreshold;
+}
+
+void ConfigManager::setLargeFileThreshold(int megabytes)
+{
+    if (m_largeFileThreshold != megabytes && megabytes > 0) {
+        m_largeFileThreshold = megabytes;
+        store("Editor/largeFileThresholdMB", m_largeFileThreshold);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getReplayStepInterval() const
+{
+    return m_replayStepInterval;
+}
+
+void ConfigManager::setReplayStepInterval(int intervalMs)
+{
+    if (m_replayStepInterval != intervalMs && intervalMs > 0) {
+        m_replayStepInterval = intervalMs;
+        store("Replay/stepIntervalMs", m_replayStepInterval);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getOutputMaxLines() const
+{
+    return m_outputMaxLines;
+}
+
+void ConfigManager::setOutputMaxLines(int lines)
+{
+    if (m_outputMaxLines != lines && lines > 0) {
+        m_outputMaxLines = lines;
+        store("Output/maxLines", m_outputMaxLines);
+        emit configurationChanged();
+    }
+}
+
+bool ConfigManager::getOutputSpillToDisk() const
+{
+    return m_outputSpillToDisk;
+}
+
+void ConfigManager::setOutputSpillToDisk(bool enabled)
+{
+    if (m_outputSpillToDisk != enabled) {
+        m_outputSpillToDisk = enabled;
+        store("Output/spillToDisk", m_outputSpillToDisk);
+        emit configurationChanged();
+    }
+}
+
+bool ConfigManager::getPersistentNamespace() const
+{
+    return m_persistentNamespace;
+}
+
+void ConfigManager::setPersistentNamespace(bool persistent)
+{
+    if (m_persistentNamespace != persistent) {
+        m_persistentNamespace = persistent;
+        store("Execution/persistentNamespace", m_persistentNamespace);
+        emit configurationChanged();
+    }
+}
+
+bool ConfigManager::getSessionCheckpoint() const
+{
+    return m_sessionCheckpoint;
+}
+
+void ConfigManager::setSessionCheckpoint(bool enabled)
+{
+    if (m_sessionCheckpoint != enabled) {
+        m_sessionCheckpoint = enabled;
+        store("Execution/sessionCheckpoint", m_sessionCheckpoint);
+        emit configurationChanged();
+    }
+}
+
+bool ConfigManager::getSpareWorker() const
+{
+    return m_spareWorker;
+}
+
+void ConfigManager::setSpareWorker(bool spare)
+{
+    if (m_spareWorker != spare) {
+        m_spareWorker = spare;
+        store("Execution/spareWorker", m_spareWorker);
+        emit configurationChanged();
+    }
+}
+
+QString ConfigManager::getServerName() const
+{
+    return m_serverName;
+}
+
+void ConfigManager::setServerName(const QString& name)
+{
+    if (m_serverName != name) {
+        m_serverName = name;
+        store("Server/name", m_serverName);
+        emit configurationChanged();
+    }
+}
+
+QString ConfigManager::getExecutionBackend() const
+{
+    return m_executionBackend;
+}
+
+void ConfigManager::setExecutionBackend(const QString& backend)
+{
+    if (m_executionBackend != backend && (backend == "thread" || backend == "process")) {
+        m_executionBackend = backend;
+        store("Execution/backend", m_executionBackend);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getSamplingRate() const
+{
+    return m_samplingRate;
+}
+
+void ConfigManager::setSamplingRate(int rateHz)
+{
+    if (m_samplingRate != rateHz && rateHz > 0 && rateHz <= 10000) {
+        m_samplingRate = rateHz;
+        store("Profiler/samplingRate", m_samplingRate);
+        emit configurationChanged();
+    }
+}
+
+bool ConfigManager::getMemoryTracking() const
+{
+    return m_memoryTracking;
+}
+
+void ConfigManager::setMemoryTracking(bool enabled)
+{
+    if (m_memoryTracking != enabled) {
+        m_memoryTracking = enabled;
+        store("Profiler/memoryTracking", m_memoryTracking);
         emit configurationChanged();
     }
 }
 
-int ConfigManager::getExecutionDelay() const
+bool ConfigManager::getObjectDiagnostics() const
 {
-    return m_executionDelay;
+    return m_objectDiagnostics;
 }
 
-void ConfigManager::setExecutionDelay(int delayMs)
+void ConfigManager::setObjectDiagnostics(bool enabled)
 {
-    if (m_executionDelay != delayMs && delayMs >= 0) {
-        m_executionDelay = delayMs;
-        m_settings->setValue("Application/executionDelay", m_executionDelay);
+    if (m_objectDiagnostics != enabled) {
+        m_objectDiagnostics = enabled;
+        store("Profiler/objectDiagnostics", m_objectDiagnostics);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getWallTimeLimit() const
+{
+    return m_wallTimeLimit;
+}
+
+void ConfigManager::setWallTimeLimit(int seconds)
+{
+    if (m_wallTimeLimit != seconds && seconds >= 0) {
+        m_wallTimeLimit = seconds;
+        store("Limits/wallTimeSec", m_wallTimeLimit);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getCpuTimeLimit() const
+{
+    return m_cpuTimeLimit;
+}
+
+void ConfigManager::setCpuTimeLimit(int seconds)
+{
+    if (m_cpuTimeLimit != seconds && seconds >= 0) {
+        m_cpuTimeLimit = seconds;
+        store("Limits/cpuTimeSec", m_cpuTimeLimit);
+        emit configurationChanged();
+    }
+}
+
+int ConfigManager::getMemoryLimit() const
+{
+    return m_memoryLimit;
+}
+
+void ConfigManager::setMemoryLimit(int megabytes)
+{
+    if (m_memoryLimit != megabytes && megabytes >= 0) {
+        m_memoryLimit = megabytes;
+        store("Limits/memoryMB", m_memoryLimit);
+        emit configurationChanged();
+    }
+}
+
+QString ConfigManager::getMetricsLogFile() const
+{
+    return m_metricsLogFile;
+}
+
+void ConfigManager::setMetricsLogFile(const QString& path)
+{
+    if (m_metricsLogFile != path) {
+        m_metricsLogFile = path;
+        store("Metrics/logFile", m_metricsLogFile);
+        emit configurationChanged();
+    }
+}
+
+bool ConfigManager::getRecordLocals() const
+{
+    return m_recordLocals;
+}
+
+void ConfigManager::setRecordLocals(bool enabled)
+{
+    if (m_recordLocals != enabled) {
+        m_recordLocals = enabled;
+        store("Record/locals", m_recordLocals);
         emit configurationChanged();
     }
 }
@@ -169,29 +454,50 @@ void ConfigManager::setTheme(const QString& theme)
 {
     if (m_theme != theme) {
         m_theme = theme;
-        m_settings->setValue("Application/theme", m_theme);
+        store("Application/theme", m_theme);
         emit configurationChanged();
     }
 }
 
+int ConfigManager::getCodeCacheMemoryEntries() const
+{
+    return m_codeCacheMemoryEntries;
+}
+
+int ConfigManager::getCodeCacheDiskEntries() const
+{
+    return m_codeCacheDiskEntries;
+}
+
+QString ConfigManager::getCodeCacheDirectory() const
+{
+    return m_codeCacheDirectory;
+}
+
 QByteArray ConfigManager::getWindowGeometry() const
 {
-    return m_settings->value("Window/geometry").toByteArray();
+    return m_windowGeometry;
 }
 
 void ConfigManager::setWindowGeometry(const QByteArray& geometry)
 {
-    m_settings->setValue("Window/geometry", geometry);
+    if (m_windowGeometry != geometry) {
+        m_windowGeometry = geometry;
+        store("Window/geometry", m_windowGeometry);
+    }
 }
 
 QByteArray ConfigManager::getWindowState() const
 {
-    return m_settings->value("Window/state").toByteArray();
+    return m_windowState;
 }
 
 void ConfigManager::setWindowState(const QByteArray& state)
 {
-    m_settings->setValue("Window/state", state);
+    if (m_windowState != state) {
+        m_windowState = state;
+        store("Window/state", m_windowState);
+    }
 }
 
 void ConfigManager::resetToDefaults()
@@ -204,8 +510,78 @@ void ConfigManager::resetToDefaults()
 
 void ConfigManager::save()
 {
-    if (m_settings) {
-        m_settings->sync();
+    if (m_flushTimer) {
+        m_flushTimer->stop();
+    }
+    if (m_pending.isEmpty() || !m_writer.joinable()) {
+        return;
+    }
+
+    // 还在排队的同一配置项只保留最新的值
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+            m_writeQueue.insert(it.key(), it.value());
+        }
+        ++m_queuedBatches;
+    }
+    m_pending.clear();
+    m_writeWake.notify_one();
+}
+
+void ConfigManager::sync()
+{
+    save();
+    if (!m_writer.joinable()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    m_writtenWake.wait(lock, [this]() { return m_writtenBatches >= m_queuedBatches; });
+}
+
+void ConfigManager::store(const QString& key, const QVariant& value)
+{
+    m_pending.insert(key, value);
+    if (m_flushTimer) {
+        m_flushTimer->start();
+    }
+    emit settingChanged(key, value);
+}
+
+void ConfigManager::writerLoop()
+{
+    // 写入线程使用自己的QSettings对象（同一进程中同一文件的QSettings共享内容，sync时合并）
+    QSettings settings(m_configFile, QSettings::IniFormat);
+    for (;;) {
+        QVariantMap values;
+        bool        stopping = false;
+        quint64     batch    = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_writeMutex);
+            m_writeWake.wait(lock, [this]() { return !m_writeQueue.isEmpty() || m_writerStopping; });
+            values.swap(m_writeQueue);
+            stopping = m_writerStopping;
+            batch    = m_queuedBatches;
+        }
+
+        if (!values.isEmpty()) {
+            for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+                settings.setValue(it.key(), it.value());
+            }
+            settings.sync();
+            if (settings.status() != QSettings::NoError) {
+                qWarning() << "Cannot write config file:" << m_configFile;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            m_writtenBatches = batch;
+        }
+        m_writtenWake.notify_all();
+        if (stopping) {
+            break;
+        }
     }
 }
 
@@ -218,98 +594,136 @@ void ConfigManager::load()
     // 加载Python配置
     m_pythonHome = m_settings->value("Python/home").toString();
     m_pythonPaths = m_settings->value("Python/paths").toStringList();
+    // INI中逗号分隔的列表读出后可能带空白
+    m_warmUpModules.clear();
+    for (const QString& module : m_settings->value("Python/warmUpModules").toStringList()) {
+        if (!module.trimmed().isEmpty()) {
+            m_warmUpModules.append(module.trimmed());
+        }
+    }
+    m_pluginPaths.clear();
+    for (const QString& path : m_settings->value("Python/pluginPaths").toStringList()) {
+        if (!path.trimmed().isEmpty()) {
+            m_pluginPaths.append(path.trimmed());
+        }
+    }
 
     // 加载编辑器配置
     m_editorFont = m_settings->value("Editor/font", "Consolas").toString();
     m_editorFontSize = m_settings->value("Editor/fontSize", 12).toInt();
     m_autoSaveInterval = m_settings->value("Editor/autoSaveInterval", 30).toInt();
+    m_largeFileThreshold = qMax(1, m_settings->value("Editor/largeFileThresholdMB", 16).toInt());
 
     // 加载应用配置
-    m_executionDelay = m_settings->value("Application/executionDelay", 100).toInt();
+    // 旧版本的执行延迟改为回放间隔
+    m_replayStepInterval = qMax(1,
+                                m_settings->value("Replay/stepIntervalMs",
+                                                  m_settings->value("Application/executionDelay", 100))
+                                    .toInt());
+    m_outputMaxLines = m_settings->value("Output/maxLines", 100000).toInt();
+    m_outputSpillToDisk = m_settings->value("Output/spillToDisk", false).toBool();
+    m_persistentNamespace = m_settings->value("Execution/persistentNamespace", false).toBool();
+    m_sessionCheckpoint = m_settings->value("Execution/sessionCheckpoint", false).toBool();
+    m_executionBackend = m_settings->value("Execution/backend", "thread").toString();
+    m_spareWorker = m_settings->value("Execution/spareWorker", false).toBool();
+    m_serverName = m_settings->value("Server/name").toString().trimmed();
+    m_samplingRate = qBound(1, m_settings->value("Profiler/samplingRate", 1000).toInt(), 10000);
+    m_memoryTracking = m_settings->value("Profiler/memoryTracking", false).toBool();
+    m_objectDiagnostics = m_settings->value("Profiler/objectDiagnostics", false).toBool();
+    m_metricsLogFile = m_settings->value("Metrics/logFile", defaultMetricsLogFile()).toString();
+    m_wallTimeLimit = qMax(0, m_settings->value("Limits/wallTimeSec", 0).toInt());
+    m_cpuTimeLimit = qMax(0, m_settings->value("Limits/cpuTimeSec", 0).toInt());
+    m_memoryLimit = qMax(0, m_settings->value("Limits/memoryMB", 0).toInt());
+    m_recordLocals = m_settings->value("Record/locals", true).toBool();
     m_theme = m_settings->value("Application/theme", "light").toString();
 
-    // 如果没有配置，则创建默认配置
+    // 加载解释器配置
+    m_codeCacheMemoryEntries = qMax(0, m_settings->value("CodeCache/memoryEntries", 32).toInt());
+    m_codeCacheDiskEntries = qMax(0, m_settings->value("CodeCache/diskEntries", 256).toInt());
+    m_codeCacheDirectory = m_settings->value("CodeCache/diskEnabled", true).toBool()
+                               ? m_settings->value("CodeCache/directory", defaultCodeCacheDirectory()).toString()
+                               : QString();
+
+    // 加载窗口状态
+    m_windowGeometry = m_settings->value("Window/geometry").toByteArray();
+    m_windowState = m_settings->value("Window/state").toByteArray();
+
+    // 如果没有配置，先迁移旧版本的设置，仍然没有时创建默认配置
     if (!m_settings->contains("Python/home")) {
-        createDefaultConfiguration();
+        migrateLegacySettings();
+        if (m_pythonHome.isEmpty()) {
+            createDefaultConfiguration();
+        }
     }
 }
 
-QString ConfigManager::getConfigFilePath() const
+void ConfigManager::migrateLegacySettings()
 {
-    return m_configFile;
-}
+    const QString appDataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QSettings     pythonConfig(QDir(appDataDir).filePath("python_config.ini"), QSettings::IniFormat);
+    QSettings     windowSettings("QtPythonEmbedTest2", "Settings");
 
-QString ConfigManager::detectCondaPython()
-{
-#ifdef Q_OS_WINDOWS
-    QString condaPath = QDir::homePath() + "/miniconda3";
-    QStringList possiblePaths = {
-        QDir::homePath() + "/miniconda3",
-        QDir::homePath() + "/anaconda3",
-        "C:/miniconda3",
-        "C:/anaconda3"
-    };
-    
-    for (const QString& path : possiblePaths) {
-        if (QDir(path).exists()) {
-            QString pythonPath = path + "/python.exe";
-            if (QFileInfo(pythonPath).exists()) {
-                return QFileInfo(pythonPath).canonicalPath();
-            }
-        }
+    QString home = pythonConfig.value("Python/pythonHome").toString();
+    if (home.isEmpty()) {
+        home = windowSettings.value("Python/pythonHome").toString();
     }
-#else
-    // Linux/macOS Conda detection
-    QString condaPath = QDir::homePath() + "/miniconda3";
-    QStringList possiblePaths = {
-        QDir::homePath() + "/miniconda3",
-        QDir::homePath() + "/anaconda3"
-    };
-    
-    for (const QString& path : possiblePaths) {
-        if (QDir(path).exists()) {
-            QString pythonPath = path + "/bin/python";
-            if (QFileInfo(pythonPath).exists()) {
-                return QFileInfo(pythonPath).canonicalPath();
-            }
+    if (!home.isEmpty()) {
+        m_pythonHome = home;
+        store("Python/home", m_pythonHome);
+    }
+
+    QStringList paths = pythonConfig.value("Python/pythonPaths").toStringList();
+    paths.removeAll(QString());
+    if (!paths.isEmpty()) {
+        m_pythonPaths = paths;
+        store("Python/paths", m_pythonPaths);
+    }
+
+    if (pythonConfig.contains("CodeCache/memoryEntries")) {
+        m_codeCacheMemoryEntries = qMax(0, pythonConfig.value("CodeCache/memoryEntries").toInt());
+        store("CodeCache/memoryEntries", m_codeCacheMemoryEntries);
+    }
+    if (pythonConfig.contains("CodeCache/diskEntries")) {
+        m_codeCacheDiskEntries = qMax(0, pythonConfig.value("CodeCache/diskEntries").toInt());
+        store("CodeCache/diskEntries", m_codeCacheDiskEntries);
+    }
+    if (pythonConfig.contains("CodeCache/diskEnabled") || pythonConfig.contains("CodeCache/directory")) {
+        const bool diskEnabled = pythonConfig.value("CodeCache/diskEnabled", true).toBool();
+        m_codeCacheDirectory = diskEnabled
+                                   ? pythonConfig.value("CodeCache/directory", defaultCodeCacheDirectory()).toString()
+                                   : QString();
+        store("CodeCache/diskEnabled", diskEnabled);
+        if (diskEnabled) {
+            store("CodeCache/directory", m_codeCacheDirectory);
         }
     }
-#endif
 
-    return QString();
+    if (m_windowGeometry.isEmpty() && windowSettings.contains("geometry")) {
+        setWindowGeometry(windowSettings.value("geometry").toByteArray());
+    }
+    if (m_windowState.isEmpty() && windowSettings.contains("windowState")) {
+        setWindowState(windowSettings.value("windowState").toByteArray());
+    }
+
+    if (!m_pending.isEmpty()) {
+        qDebug() << "Migrated legacy settings:" << m_pending.keys();
+    }
 }
 
-QString ConfigManager::detectSystemPython()
+QString ConfigManager::defaultMetricsLogFile()
 {
-    // 尝试从环境变量PATH中查找Python
-    QStringList pythonExecutables;
-#ifdef Q_OS_WINDOWS
-    pythonExecutables << "python.exe" << "python3.exe";
-#else
-    pythonExecutables << "python3" << "python";
-#endif
-
-    QString pathEnv = qEnvironmentVariable("PATH");
-    QStringList pathDirs = pathEnv.split(QDir::listSeparator());
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+        .filePath("run_metrics.jsonl");
+}
 
-    for (const QString& dir : pathDirs) {
-        for (const QString& pythonExe : pythonExecutables) {
-            QString pythonPath = QDir(dir).filePath(pythonExe);
-            if (QFileInfo(pythonPath).exists()) {
-                // 验证是否是有效的Python解释器
-                QProcess pythonCheck;
-                pythonCheck.start(pythonPath, QStringList() << "--version");
-                if (pythonCheck.waitForFinished(2000)) {
-                    QString version = pythonCheck.readAllStandardOutput();
-                    if (version.contains("Python")) {
-                        return QFileInfo(pythonPath).canonicalPath();
-                    }
-                }
-            }
-        }
-    }
+QString ConfigManager::defaultCodeCacheDirectory()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("bytecode");
+}
 
-    return QString();
+QString ConfigManager::getConfigFilePath() const
+{
+    return m_configFile;
 }
 
 void ConfigManager::createDefaultConfiguration()
@@ -317,24 +731,60 @@ void ConfigManager::createDefaultConfiguration()
     // 自动检测Python
     m_pythonHome = autoDetectPython();
     m_pythonPaths.clear();
+    m_warmUpModules.clear();
+    m_pluginPaths.clear();
 
     // 设置默认值
     m_editorFont = "Consolas";
     m_editorFontSize = 12;
     m_autoSaveInterval = 30;
-    m_executionDelay = 100;
+    m_largeFileThreshold = 16;
+    m_replayStepInterval = 100;
+    m_outputMaxLines = 100000;
+    m_persistentNamespace = false;
+    m_sessionCheckpoint = false;
+    m_executionBackend = "thread";
+    m_spareWorker = false;
+    m_serverName.clear();
+    m_samplingRate = 1000;
+    m_memoryTracking = false;
+    m_objectDiagnostics = false;
+    m_metricsLogFile = defaultMetricsLogFile();
+    m_wallTimeLimit = 0;
+    m_cpuTimeLimit = 0;
+    m_memoryLimit = 0;
+    m_recordLocals = true;
     m_theme = "light";
 
     // 保存默认值
-    m_settings->setValue("Python/home", m_pythonHome);
-    m_settings->setValue("Python/paths", m_pythonPaths);
-    m_settings->setValue("Editor/font", m_editorFont);
-    m_settings->setValue("Editor/fontSize", m_editorFontSize);
-    m_settings->setValue("Editor/autoSaveInterval", m_autoSaveInterval);
-    m_settings->setValue("Application/executionDelay", m_executionDelay);
-    m_settings->setValue("Application/theme", m_theme);
-
-    m_settings->sync();
+    store("Python/home", m_pythonHome);
+    store("Python/paths", m_pythonPaths);
+    store("Python/warmUpModules", m_warmUpModules);
+    store("Python/pluginPaths", m_pluginPaths);
+    store("Editor/font", m_editorFont);
+    store("Editor/fontSize", m_editorFontSize);
+    store("Editor/autoSaveInterval", m_autoSaveInterval);
+    store("Editor/largeFileThresholdMB", m_largeFileThreshold);
+    store("Replay/stepIntervalMs", m_replayStepInterval);
+    store("Output/maxLines", m_outputMaxLines);
+    store("Output/spillToDisk", m_outputSpillToDisk);
+    store("Execution/persistentNamespace", m_persistentNamespace);
+    store("Execution/sessionCheckpoint", m_sessionCheckpoint);
+    store("Execution/backend", m_executionBackend);
+    store("Execution/spareWorker", m_spareWorker);
+    store("Server/name", m_serverName);
+    store("Profiler/samplingRate", m_samplingRate);
+    store("Profiler/memoryTracking", m_memoryTracking);
+    store("Profiler/objectDiagnostics", m_objectDiagnostics);
+    store("Metrics/logFile", m_metricsLogFile);
+    store("Limits/wallTimeSec", m_wallTimeLimit);
+    store("Limits/cpuTimeSec", m_cpuTimeLimit);
+    store("Limits/memoryMB", m_memoryLimit);
+    store("Record/locals", m_recordLocals);
+    store("Application/theme", m_theme);
+
+    // 执行进程随后读取同一文件，默认配置立即提交
+    save();
 }
 
 bool ConfigManager::initialized() const
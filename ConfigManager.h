@@ -5,6 +5,14 @@
 #include <QStandardPaths>
 #include <QString>
 #include <QStringList>
+#include <QVariantMap>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class PythonDetector;
+class QTimer;
 
 /**
  * @class ConfigManager
@@ -15,12 +23,23 @@
  * - Python环境的自动检测和配置
  * - 用户首选项的保存和加载
  * - 默认配置的管理
+ *
+ * 应用（界面、编辑器、解释器和执行进程）的所有设置都在这里：启动时由initialize()读取一次配置文件，
+ * 之后getter只读内存中的值。setter修改内存中的值并发出settingChanged()，修改的键在
+ * 停顿kFlushDelayMs后合并交给后台线程写入文件，界面线程不做文件I/O；save()立即提交，
+ * 析构时写完所有修改。旧版本分散在python_config.ini和窗口设置中的值在第一次启动时迁移过来。
+ *
+ * 只在界面线程中使用（解释器启动时在后台线程中只读取Python和代码缓存的设置）。
+ * 未调用initialize()时（如基准程序）使用默认值，修改只保存在内存中。
  */
 class ConfigManager : public QObject
 {
     Q_OBJECT
 
 public:
+    // 修改后等待合并写入的时间
+    static const int kFlushDelayMs = 500;
+
     /**
      * @brief 获取单例实例
      * @return ConfigManager& 配置管理器实例
@@ -47,6 +66,8 @@ public:
 
     /**
      * @brief 自动检测Python安装
+     *
+     * 检测缓存有效时直接使用并在后台重新检测，否则立即并行检测。
      * @return QString 检测到的Python路径或空字符串
      */
     QString autoDetectPython();
@@ -63,6 +84,30 @@ public:
      */
     void addPythonPath(const QString& path);
 
+    /**
+     * @brief 获取解释器启动后在后台预导入的模块
+     * @return QStringList 模块名，按导入顺序排列
+     */
+    QStringList getWarmUpModules() const;
+
+    /**
+     * @brief 设置解释器启动后在后台预导入的模块（下次启动时生效）
+     * @param modules 模块名
+     */
+    void setWarmUpModules(const QStringList& modules);
+
+    /**
+     * @brief 获取额外的扩展模块插件目录（程序目录下的plugins总是被扫描）
+     * @return QStringList 目录列表
+     */
+    QStringList getPluginPaths() const;
+
+    /**
+     * @brief 设置额外的扩展模块插件目录（解释器下次初始化时生效）
+     * @param paths 目录列表
+     */
+    void setPluginPaths(const QStringList& paths);
+
     /**
      * @brief 获取编辑器字体
      * @return QString 字体名称
@@ -100,16 +145,226 @@ public:
     void setAutoSaveInterval(int seconds);
 
     /**
-     * @brief 获取代码执行延迟（毫秒）
-     * @return int 延迟毫秒数
+     * @brief 获取大文件阈值（MB），超过阈值的文件以只读方式打开且不做语法高亮
+     * @return int 阈值
+     */
+    int getLargeFileThreshold() const;
+
+    /**
+     * @brief 设置大文件阈值
+     * @param megabytes 阈值（MB）
+     */
+    void setLargeFileThreshold(int megabytes);
+
+    /**
+     * @brief 获取回放时每一步的间隔（毫秒）
+     * @return int 间隔毫秒数
+     */
+    int getReplayStepInterval() const;
+
+    /**
+     * @brief 设置回放时每一步的间隔
+     * @param intervalMs 间隔毫秒数
+     */
+    void setReplayStepInterval(int intervalMs);
+
+    /**
+     * @brief 获取输出窗口最多保留的行数
+     * @return int 行数
+     */
+    int getOutputMaxLines() const;
+
+    /**
+     * @brief 设置输出窗口最多保留的行数
+     * @param lines 行数
+     */
+    void setOutputMaxLines(int lines);
+
+    /**
+     * @brief 超过行数上限的输出是否写入临时文件（导出和搜索仍覆盖全部输出）
+     * @return bool 写入返回true
+     */
+    bool getOutputSpillToDisk() const;
+
+    /**
+     * @brief 设置超过行数上限的输出是否写入临时文件
+     * @param enabled 写入为true
+     */
+    void setOutputSpillToDisk(bool enabled);
+
+    /**
+     * @brief 是否在多次运行之间保留同一个会话命名空间
+     * @return bool 保留返回true，false表示每次运行使用全新的命名空间
+     */
+    bool getPersistentNamespace() const;
+
+    /**
+     * @brief 设置是否在多次运行之间保留同一个会话命名空间
+     * @param persistent 是否保留
+     */
+    void setPersistentNamespace(bool persistent);
+
+    /**
+     * @brief 退出时是否把会话变量保存为检查点，下次启动后第一次运行时恢复
+     * @return bool 保存返回true
+     */
+    bool getSessionCheckpoint() const;
+
+    /**
+     * @brief 设置退出时是否保存会话检查点
+     * @param enabled 是否保存
+     */
+    void setSessionCheckpoint(bool enabled);
+
+    /**
+     * @brief 获取执行后端
+     * @return QString "thread"表示在界面进程的独立线程中运行，"process"表示在执行进程中运行
+     */
+    QString getExecutionBackend() const;
+
+    /**
+     * @brief 设置执行后端（重新启动后生效）
+     * @param backend "thread"或"process"
+     */
+    void setExecutionBackend(const QString& backend);
+
+    /**
+     * @brief 进程后端是否预先启动一个备用执行进程
+     * @return bool 预先启动返回true（多占一个进程的内存，重启解释器时直接换上）
+     */
+    bool getSpareWorker() const;
+
+    /**
+     * @brief 设置进程后端是否预先启动一个备用执行进程
+     * @param spare 是否预先启动
+     */
+    void setSpareWorker(bool spare);
+
+    /**
+     * @brief 获取本地执行服务的套接字名
+     * @return QString 套接字名，为空表示不启动执行服务
+     */
+    QString getServerName() const;
+
+    /**
+     * @brief 设置本地执行服务的套接字名（重新启动后生效）
+     * @param name 套接字名，为空表示不启动
+     */
+    void setServerName(const QString& name);
+
+    /**
+     * @brief 获取采样分析的采样频率
+     * @return int 每秒采样次数
      */
-    int getExecutionDelay() const;
+    int getSamplingRate() const;
 
     /**
-     * @brief 设置代码执行延迟
-     * @param delayMs 延迟毫秒数
+     * @brief 设置采样分析的采样频率
+     * @param rateHz 每秒采样次数（1~10000）
      */
-    void setExecutionDelay(int delayMs);
+    void setSamplingRate(int rateHz);
+
+    /**
+     * @brief 是否在运行期间统计内存（tracemalloc和常驻内存采样）
+     * @return bool 统计返回true
+     */
+    bool getMemoryTracking() const;
+
+    /**
+     * @brief 设置是否在运行期间统计内存
+     * @param enabled 是否统计
+     */
+    void setMemoryTracking(bool enabled);
+
+    /**
+     * @brief 是否在运行前后做对象存活诊断
+     * @return bool 诊断返回true
+     */
+    bool getObjectDiagnostics() const;
+
+    /**
+     * @brief 设置是否在运行前后做对象存活诊断
+     * @param enabled 是否诊断
+     */
+    void setObjectDiagnostics(bool enabled);
+
+    /**
+     * @brief 获取单次运行的墙钟时间上限（暂停等待调试命令的时间不计入）
+     * @return int 秒，0表示不限制
+     */
+    int getWallTimeLimit() const;
+
+    /**
+     * @brief 设置单次运行的墙钟时间上限
+     * @param seconds 秒，0表示不限制
+     */
+    void setWallTimeLimit(int seconds);
+
+    /**
+     * @brief 获取单次运行的CPU时间上限
+     * @return int 秒，0表示不限制
+     */
+    int getCpuTimeLimit() const;
+
+    /**
+     * @brief 设置单次运行的CPU时间上限
+     * @param seconds 秒，0表示不限制
+     */
+    void setCpuTimeLimit(int seconds);
+
+    /**
+     * @brief 获取单次运行的常驻内存增长上限
+     * @return int MB，0表示不限制
+     */
+    int getMemoryLimit() const;
+
+    /**
+     * @brief 设置单次运行的常驻内存增长上限
+     * @param megabytes MB，0表示不限制
+     */
+    void setMemoryLimit(int megabytes);
+
+    /**
+     * @brief 获取运行指标日志文件（每次运行追加一行JSON）
+     * @return QString 文件路径，为空表示不写日志
+     */
+    QString getMetricsLogFile() const;
+
+    /**
+     * @brief 设置运行指标日志文件
+     * @param path 文件路径，为空表示不写日志
+     */
+    void setMetricsLogFile(const QString& path);
+
+    /**
+     * @brief 录制运行时是否同时记录局部变量的变化
+     * @return bool 记录返回true
+     */
+    bool getRecordLocals() const;
+
+    /**
+     * @brief 设置录制运行时是否记录局部变量的变化
+     * @param enabled 是否记录
+     */
+    void setRecordLocals(bool enabled);
+
+    /**
+     * @brief 获取内存中缓存的代码对象数量
+     * @return int 数量，0表示关闭
+     */
+    int getCodeCacheMemoryEntries() const;
+
+    /**
+     * @brief 获取磁盘上保留的字节码文件数量
+     * @return int 数量
+     */
+    int getCodeCacheDiskEntries() const;
+
+    /**
+     * @brief 获取字节码缓存目录
+     * @return QString 目录，为空表示不缓存到磁盘
+     */
+    QString getCodeCacheDirectory() const;
 
     /**
      * @brief 获取主题设置
@@ -153,12 +408,17 @@ public:
     void resetToDefaults();
 
     /**
-     * @brief 保存设置
+     * @brief 立即把尚未写入的修改交给后台线程写入（不等待写完）
      */
     void save();
 
     /**
-     * @brief 加载设置
+     * @brief 把尚未写入的修改写入配置文件并等待写完（新启动的进程需要读到最新的值时调用）
+     */
+    void sync();
+
+    /**
+     * @brief 从配置文件加载设置
      */
     void load();
 
@@ -171,6 +431,13 @@ public:
     bool initialized() const;
 
 signals:
+    /**
+     * @brief 一个设置被修改
+     * @param key 配置项（如"Editor/fontSize"）
+     * @param value 新的值
+     */
+    void settingChanged(const QString& key, const QVariant& value);
+
     /**
      * @brief 配置改变信号
      */
@@ -195,31 +462,86 @@ private:
     ConfigManager& operator=(const ConfigManager&) = delete;
 
     /**
-     * @brief 检测Conda环境
-     * @return QString Conda Python路径或空字符串
+     * @brief 创建默认配置
      */
-    QString detectCondaPython();
+    void createDefaultConfiguration();
 
     /**
-     * @brief 检测系统Python
-     * @return QString 系统Python路径或空字符串
+     * @brief 迁移旧版本python_config.ini和窗口设置（QSettings("QtPythonEmbedTest2", "Settings")）中的值
      */
-    QString detectSystemPython();
+    void migrateLegacySettings();
 
     /**
-     * @brief 创建默认配置
+     * @brief 修改一个配置项：记为待写入并发出settingChanged()
+     * @param key 配置项
+     * @param value 新的值
      */
-    void createDefaultConfiguration();
+    void store(const QString& key, const QVariant& value);
+
+    /**
+     * @brief 后台写入线程主循环
+     */
+    void writerLoop();
+
+    /**
+     * @brief 默认的运行指标日志文件（应用数据目录下的run_metrics.jsonl）
+     * @return QString 文件路径
+     */
+    static QString defaultMetricsLogFile();
+
+    /**
+     * @brief 默认的字节码缓存目录（系统缓存目录下的bytecode）
+     * @return QString 目录
+     */
+    static QString defaultCodeCacheDirectory();
 
 private:
-    QSettings*  m_settings = nullptr;
+    QSettings*  m_settings = nullptr;     // 启动时读取；Python检测的缓存也保存在这里
+    PythonDetector* m_detector = nullptr;   // Python安装检测（结果缓存在配置文件中）
     QString     m_configFile;
     QString     m_pythonHome;
     QStringList m_pythonPaths;
+    QStringList m_warmUpModules;
+    QStringList m_pluginPaths;
     QString     m_editorFont;
     QString     m_theme;
     int         m_editorFontSize;
     int         m_autoSaveInterval;
-    int         m_executionDelay;
+    int         m_largeFileThreshold;
+    int         m_replayStepInterval;
+    int         m_outputMaxLines;
+    bool        m_outputSpillToDisk   = false;
+    bool        m_persistentNamespace = false;
+    bool        m_sessionCheckpoint   = false;
+    QString     m_executionBackend    = "thread";
+    bool        m_spareWorker         = false;
+    QString     m_serverName;
+    int         m_samplingRate        = 1000;
+    bool        m_memoryTracking      = false;
+    bool        m_objectDiagnostics   = false;
+    QString     m_metricsLogFile;
+    int         m_wallTimeLimit       = 0;
+    int         m_cpuTimeLimit        = 0;
+    int         m_memoryLimit         = 0;
+    bool        m_recordLocals        = true;
+    int         m_codeCacheMemoryEntries = 32;
+    int         m_codeCacheDiskEntries   = 256;
+    QString     m_codeCacheDirectory;
+    QByteArray  m_windowGeometry;
+    QByteArray  m_windowState;
     bool        m_initialized = false;
+
+    // 尚未交给写入线程的修改（界面线程），停顿kFlushDelayMs后提交
+    QVariantMap m_pending;
+    QTimer*     m_flushTimer = nullptr;
+
+    // 后台写入线程，由m_writeMutex保护
+    std::thread             m_writer;
+    std::mutex              m_writeMutex;
+    std::condition_variable m_writeWake;
+    QVariantMap             m_writeQueue;
+    bool                    m_writerStopping = false;
+    quint64                 m_queuedBatches  = 0;   // 交给写入线程的批次
+    quint64                 m_writtenBatches = 0;   // 已写入文件的批次
+    std::condition_variable m_writtenWake;
 };
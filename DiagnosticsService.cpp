@@ -0,0 +1,173 @@
+#include "DiagnosticsService.h"
+#include "IpcChannel.h"
+#include "WorkerProtocol.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QThread>
+
+#include <atomic>
+
+// 命令在通道满时的最长等待时间
+static const int kCommandTimeoutMs = 1000;
+
+// 退出时等待诊断进程自行结束的时间
+static const int kShutdownWaitMs = 1000;
+
+// 同一进程中的多个诊断服务使用不同的通道标识
+static std::atomic<int> s_nextChannelId{0};
+
+DiagnosticsService::DiagnosticsService(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QVector<SyntaxCheck::Diagnostic>>();
+}
+
+DiagnosticsService::~DiagnosticsService()
+{
+    m_shuttingDown = true;
+
+    if (m_process) {
+        disconnect(m_process, nullptr, this, nullptr);
+        if (m_channel) {
+            m_channel->send(WorkerProtocol::Shutdown, QByteArray(), kCommandTimeoutMs);
+        }
+        if (!m_process->waitForFinished(kShutdownWaitMs)) {
+            m_process->kill();
+            m_process->waitForFinished();
+        }
+    }
+
+    stopReader();
+}
+
+void DiagnosticsService::check(quint64 revision, const QString& code)
+{
+    m_hasPending      = true;
+    m_pendingRevision = revision;
+    m_pendingCode     = code;
+
+    if (!m_process && !m_unavailable) {
+        spawnWorker();
+    }
+    sendPending();
+}
+
+void DiagnosticsService::spawnWorker()
+{
+    const QString key = QString("QtPythonEmbed-check-%1-%2")
+                            .arg(QCoreApplication::applicationPid())
+                            .arg(s_nextChannelId.fetch_add(1));
+
+    m_ready = false;
+    m_busy  = false;
+    m_channel.reset(new IpcChannel(IpcChannel::Host));
+    if (!m_channel->create(key)) {
+        qCritical() << "Cannot create diagnostics channel" << key << ":" << m_channel->errorString();
+        m_channel.reset();
+        return;
+    }
+
+    // 读取线程只负责接收，消息排队到界面线程处理
+    IpcChannel* channel = m_channel.get();
+    m_readerThread      = QThread::create([this, channel]() {
+        quint16    type = 0;
+        QByteArray payload;
+        while (channel->receive(&type, &payload, true)) {
+            QMetaObject::invokeMethod(
+                this, [this, type, payload]() { handleEvent(type, payload); }, Qt::QueuedConnection);
+        }
+    });
+    m_readerThread->start();
+
+    // 标准输入保持为管道：主进程退出时诊断进程读到EOF后自行退出
+    m_process = new QProcess(this);
+    m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(m_process,
+            QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this,
+            &DiagnosticsService::onWorkerFinished);
+    m_process->start(QCoreApplication::applicationFilePath(), {WorkerProtocol::kWorkerArgument, key});
+}
+
+void DiagnosticsService::stopReader()
+{
+    if (!m_readerThread) {
+        return;
+    }
+
+    m_channel->close();
+    m_readerThread->wait();
+    delete m_readerThread;
+    m_readerThread = nullptr;
+    m_channel.reset();
+}
+
+void DiagnosticsService::sendPending()
+{
+    if (!m_ready || m_busy || !m_hasPending || !m_channel) {
+        return;
+    }
+
+    const QByteArray payload = SyntaxCheck::encodeRequest(m_pendingRevision, m_pendingCode);
+    if (!m_channel->send(WorkerProtocol::CheckSyntax, payload, kCommandTimeoutMs)) {
+        qWarning() << "Cannot send syntax check to diagnostics worker:" << m_channel->errorString();
+        return;
+    }
+    m_busy         = true;
+    m_sentRevision = m_pendingRevision;
+    m_hasPending   = false;
+    m_pendingCode.clear();
+}
+
+void DiagnosticsService::handleEvent(quint16 type, const QByteArray& payload)
+{
+    switch (type) {
+    case WorkerProtocol::Ready:
+        m_ready = true;
+        sendPending();
+        break;
+    case WorkerProtocol::Diagnostics: {
+        quint64                          revision = 0;
+        QVector<SyntaxCheck::Diagnostic> diagnostics;
+        m_busy = false;
+        if (SyntaxCheck::decode(payload, &revision, &diagnostics)) {
+            emit diagnosticsReady(revision, diagnostics);
+        }
+        sendPending();
+        break;
+    }
+    case WorkerProtocol::Error:
+        qWarning() << "Diagnostics worker:" << QString::fromUtf8(payload);
+        break;
+    default:
+        // 诊断进程中的运行器不运行代码，其他事件可以忽略
+        break;
+    }
+}
+
+void DiagnosticsService::onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Q_UNUSED(exitStatus);
+    stopReader();
+
+    m_process->deleteLater();
+    m_process = nullptr;
+
+    const bool wasReady = m_ready;
+    m_ready             = false;
+    m_busy              = false;
+    if (m_shuttingDown) {
+        return;
+    }
+
+    // 正在进行的检查没有结果；启动阶段就退出说明环境有问题，重启只会反复失败
+    qWarning() << "Diagnostics worker exited with code" << exitCode;
+    if (!wasReady) {
+        m_unavailable = true;
+        return;
+    }
+    if (m_hasPending) {
+        spawnWorker();
+    }
+}
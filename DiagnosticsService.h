@@ -0,0 +1,93 @@
+#pragma once
+
+#include "SyntaxCheck.h"
+
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class IpcChannel;
+class QThread;
+
+/**
+ * @class DiagnosticsService
+ * @brief 在独立的诊断进程中检查代码
+ *
+ * 诊断进程与执行进程使用同一个可执行文件和通道（见ExecutionWorker），有自己的解释器和GIL，
+ * 检查代码不会与主进程或执行进程中运行的脚本争抢GIL。进程在第一次检查时启动。
+ *
+ * 同一时刻只有一次检查在进行；期间提交的检查只保留最新的一次，当前检查结束后再发送，
+ * 被取代的检查不会发给诊断进程。诊断进程运行中退出时下一次检查重新启动它，
+ * 在启动阶段就退出（如解释器初始化失败）时不再重试。
+ * 所有接口都在界面线程中调用，diagnosticsReady()也在界面线程中发出。
+ */
+class DiagnosticsService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsService(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（通知诊断进程退出）
+     */
+    ~DiagnosticsService() override;
+
+    /**
+     * @brief 提交检查，取代尚未发送的检查
+     * @param revision 代码的版本，随结果原样返回
+     * @param code 代码
+     */
+    void check(quint64 revision, const QString& code);
+
+signals:
+    /**
+     * @brief 检查完成
+     * @param revision check()传入的版本
+     * @param diagnostics 诊断，没有问题时为空
+     */
+    void diagnosticsReady(quint64 revision, const QVector<SyntaxCheck::Diagnostic>& diagnostics);
+
+private:
+    /**
+     * @brief 启动诊断进程
+     */
+    void spawnWorker();
+
+    /**
+     * @brief 停止读取线程并关闭通道
+     */
+    void stopReader();
+
+    /**
+     * @brief 发送排队的检查（诊断进程就绪且空闲时）
+     */
+    void sendPending();
+
+    /**
+     * @brief 处理诊断进程发来的一条消息（界面线程）
+     */
+    void handleEvent(quint16 type, const QByteArray& payload);
+
+    /**
+     * @brief 诊断进程退出
+     */
+    void onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    QProcess*                   m_process      = nullptr;
+    std::unique_ptr<IpcChannel> m_channel;
+    QThread*                    m_readerThread = nullptr;
+    bool                        m_ready        = false;
+    bool                        m_unavailable  = false;   // 诊断进程在启动阶段退出，不再重试
+    bool                        m_shuttingDown = false;
+
+    bool    m_hasPending      = false;   // 有尚未发送的检查
+    quint64 m_pendingRevision = 0;
+    QString m_pendingCode;
+    bool    m_busy            = false;   // 已发送、尚未收到结果
+    quint64 m_sentRevision    = 0;
+};
@@ -0,0 +1,383 @@
+#include "ExecutionRecorder.h"
+#include "ExecutionRecording.h"
+
+#include <QtEndian>
+
+#include <chrono>
+#include <cstring>
+
+#include <frameobject.h>
+
+// 运行线程编码块的大小
+static const size_t kChunkBytes = 64 * 1024;
+
+// 后台线程积压的块数上限，超过时运行线程等待
+static const size_t kMaxQueuedChunks = 64;
+
+// 文件每次扩展并映射的大小
+static const qint64 kExtentBytes = 16 * 1024 * 1024;
+
+// 变量名和值的长度上限
+static const Py_ssize_t kMaxNameBytes  = 256;
+static const Py_ssize_t kMaxValueChars = 200;
+
+// 头部：8字节标识、版本号、标志（小端）
+static const char   kMagic[8]   = {'Q', 'P', 'Y', 'R', 'E', 'C', '\0', '\0'};
+static const quint32 kVersion   = 1;
+static const qint64  kFlagsOffset = 12;
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 对象的repr（UTF-8，截断到kMaxValueChars个字符），出错时为占位文字
+static QByteArray reprText(PyObject* value)
+{
+    PyObject* text = PyObject_Repr(value);
+    if (!text) {
+        PyErr_Clear();
+        return "<repr() failed>";
+    }
+
+    QByteArray result;
+    if (PyUnicode_GetLength(text) > kMaxValueChars) {
+        PyObject* head = PyUnicode_Substring(text, 0, kMaxValueChars - 3);
+        const char* utf8 = head ? PyUnicode_AsUTF8(head) : nullptr;
+        if (utf8) {
+            result = QByteArray(utf8) + "...";
+        }
+        Py_XDECREF(head);
+    }
+    else {
+        Py_ssize_t  size = 0;
+        const char* utf8 = PyUnicode_AsUTF8AndSize(text, &size);
+        if (utf8) {
+            result = QByteArray(utf8, static_cast<int>(size));
+        }
+    }
+    Py_DECREF(text);
+
+    if (PyErr_Occurred()) {
+        PyErr_Clear();
+        return "<repr() failed>";
+    }
+    return result;
+}
+
+ExecutionRecorder::~ExecutionRecorder()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+    m_file.close();
+}
+
+bool ExecutionRecorder::start(const QString& path, bool recordLocals)
+{
+    if (isRecording()) {
+        stop();
+    }
+
+    m_path  = path;
+    m_error.clear();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        m_error = QString("无法创建录制文件%1：%2").arg(path, m_file.errorString());
+        return false;
+    }
+
+    m_extent       = nullptr;
+    m_extentOffset = 0;
+    m_written      = 0;
+    m_writeError.clear();
+    m_truncated = false;
+    m_stopping  = false;
+    m_queue.clear();
+
+    m_recordLocals = recordLocals;
+    m_lastLine     = 0;
+    m_lastNs       = 0;
+    m_startNs      = monotonicNs();
+    m_frames.clear();
+
+    // 头部和记录一样经过后台线程写入
+    m_chunk.clear();
+    m_chunk.reserve(kChunkBytes);
+    putBytes(kMagic, sizeof(kMagic));
+    quint32 header[2] = {qToLittleEndian(kVersion),
+                         qToLittleEndian<quint32>(recordLocals ? LocalsFlag : 0)};
+    putBytes(reinterpret_cast<const char*>(header), sizeof(header));
+
+    m_thread = std::thread([this]() { writeLoop(); });
+    return true;
+}
+
+void ExecutionRecorder::record(int event, PyFrameObject* frame, int line)
+{
+    if (m_truncated.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    switch (event) {
+    case PyTrace_CALL:
+        reserve(1);
+        putByte(CallRecord);
+        break;
+    case PyTrace_RETURN:
+        reserve(1);
+        putByte(ReturnRecord);
+        if (m_recordLocals) {
+            m_frames.erase(frame);
+        }
+        break;
+    case PyTrace_LINE: {
+        // 行号和时间都与上一个行事件做差，循环中通常各占一个字节
+        const qint64 ns    = monotonicNs() - m_startNs;
+        const qint64 delta = line - m_lastLine;
+        reserve(1 + 10 + 10);
+        putByte(LineRecord);
+        putVarint((static_cast<quint64>(delta) << 1) ^ static_cast<quint64>(delta >> 63));
+        putVarint(static_cast<quint64>(ns - m_lastNs));
+        m_lastLine = line;
+        m_lastNs   = ns;
+
+        if (m_recordLocals) {
+            recordLocals(frame);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+std::shared_ptr<ExecutionRecording> ExecutionRecorder::stop()
+{
+    if (!isRecording()) {
+        return nullptr;
+    }
+
+    flushChunk();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+    m_frames.clear();
+
+    // 去掉最后一个扩展区中未用的部分；截断的录制在头部标记
+    m_file.resize(m_written);
+    if (m_truncated && m_written >= kFlagsOffset + 4 && m_file.seek(kFlagsOffset)) {
+        const quint32 flags = qToLittleEndian<quint32>((m_recordLocals ? LocalsFlag : 0) | TruncatedFlag);
+        m_file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+    }
+    m_file.close();
+
+    if (!m_writeError.isEmpty()) {
+        m_error = QString("写入录制文件失败：%1").arg(m_writeError);
+        return nullptr;
+    }
+    return ExecutionRecording::open(m_path, &m_error);
+}
+
+void ExecutionRecorder::reserve(size_t bytes)
+{
+    if (m_chunk.size() + bytes > kChunkBytes) {
+        flushChunk();
+    }
+}
+
+void ExecutionRecorder::flushChunk()
+{
+    if (m_chunk.empty()) {
+        return;
+    }
+
+    std::vector<char> chunk;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_drained.wait(lock, [this]() { return m_queue.size() < kMaxQueuedChunks; });
+        m_queue.push_back(std::move(m_chunk));
+        if (!m_spare.empty()) {
+            chunk = std::move(m_spare.back());
+            m_spare.pop_back();
+        }
+    }
+    m_wake.notify_one();
+
+    m_chunk = std::move(chunk);
+    m_chunk.clear();
+    m_chunk.reserve(kChunkBytes);
+}
+
+void ExecutionRecorder::putVarint(quint64 value)
+{
+    while (value >= 0x80) {
+        m_chunk.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    m_chunk.push_back(static_cast<char>(value));
+}
+
+void ExecutionRecorder::putBytes(const char* data, size_t size)
+{
+    m_chunk.insert(m_chunk.end(), data, data + size);
+}
+
+void ExecutionRecorder::recordLocals(PyFrameObject* frame)
+{
+#if PY_VERSION_HEX >= 0x030B0000
+    PyObject* locals = PyFrame_GetLocals(frame);
+#else
+    PyObject* locals = nullptr;
+    if (PyFrame_FastToLocalsWithError(frame) == 0) {
+        locals = frame->f_locals;
+        Py_XINCREF(locals);
+    }
+#endif
+    if (!locals) {
+        PyErr_Clear();
+        return;
+    }
+
+    // 只比较地址：绑定没变的变量不求repr，也不分配内存
+    Bindings& bindings = m_frames[frame];
+    auto      check    = [this, &bindings](PyObject* name, PyObject* value) {
+        if (!PyUnicode_Check(name)) {
+            return;
+        }
+        auto it = bindings.find(name);
+        if (it != bindings.end() && it->second == value) {
+            return;
+        }
+        bindings[name] = value;
+        recordLocal(name, value);
+    };
+
+    if (PyDict_Check(locals)) {
+        Py_ssize_t position = 0;
+        PyObject*  name     = nullptr;
+        PyObject*  value    = nullptr;
+        while (PyDict_Next(locals, &position, &name, &value)) {
+            check(name, value);
+        }
+    }
+    else {
+        // 3.13起函数栈帧的locals是代理对象
+        PyObject* items = PyMapping_Items(locals);
+        if (items) {
+            for (Py_ssize_t i = 0; i < PyList_GET_SIZE(items); ++i) {
+                PyObject* item = PyList_GET_ITEM(items, i);
+                check(PyTuple_GET_ITEM(item, 0), PyTuple_GET_ITEM(item, 1));
+            }
+            Py_DECREF(items);
+        }
+        else {
+            PyErr_Clear();
+        }
+    }
+    Py_DECREF(locals);
+}
+
+void ExecutionRecorder::recordLocal(PyObject* name, PyObject* value)
+{
+    Py_ssize_t  nameSize = 0;
+    const char* nameUtf8 = PyUnicode_AsUTF8AndSize(name, &nameSize);
+    if (!nameUtf8) {
+        PyErr_Clear();
+        return;
+    }
+    // 模块级的__name__、__builtins__等不记录
+    if (nameSize >= 2 && nameUtf8[0] == '_' && nameUtf8[1] == '_') {
+        return;
+    }
+    nameSize = qMin(nameSize, kMaxNameBytes);
+
+    const QByteArray text = reprText(value);
+    reserve(1 + 10 + static_cast<size_t>(nameSize) + 10 + static_cast<size_t>(text.size()));
+    putByte(LocalRecord);
+    putVarint(static_cast<quint64>(nameSize));
+    putBytes(nameUtf8, static_cast<size_t>(nameSize));
+    putVarint(static_cast<quint64>(text.size()));
+    putBytes(text.constData(), static_cast<size_t>(text.size()));
+}
+
+void ExecutionRecorder::writeLoop()
+{
+    for (;;) {
+        std::vector<char> chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty()) {
+                break;
+            }
+            chunk = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_drained.notify_one();
+
+        if (!m_truncated.load(std::memory_order_relaxed) && !writeMapped(chunk.data(), chunk.size())) {
+            // 磁盘已满等错误：停止录制，程序继续运行
+            m_truncated = true;
+        }
+
+        chunk.clear();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_spare.size() < 4) {
+            m_spare.push_back(std::move(chunk));
+        }
+    }
+    unmapExtent();
+}
+
+bool ExecutionRecorder::writeMapped(const char* data, size_t size)
+{
+    if (m_written + static_cast<qint64>(size) > kMaxFileBytes) {
+        m_truncated = true;
+        return true;
+    }
+
+    while (size > 0) {
+        if (!m_extent || m_written >= m_extentOffset + kExtentBytes) {
+            // 扩展区按kExtentBytes对齐，扩展文件后重新映射
+            unmapExtent();
+            m_extentOffset = m_written / kExtentBytes * kExtentBytes;
+            if (!m_file.resize(m_extentOffset + kExtentBytes)) {
+                m_writeError = m_file.errorString();
+                return false;
+            }
+            m_extent = m_file.map(m_extentOffset, kExtentBytes);
+            if (!m_extent) {
+                m_writeError = m_file.errorString();
+                return false;
+            }
+        }
+
+        const qint64 room  = m_extentOffset + kExtentBytes - m_written;
+        const size_t count = static_cast<size_t>(qMin<qint64>(room, static_cast<qint64>(size)));
+        std::memcpy(m_extent + (m_written - m_extentOffset), data, count);
+        data += count;
+        size -= count;
+        m_written += static_cast<qint64>(count);
+    }
+    return true;
+}
+
+void ExecutionRecorder::unmapExtent()
+{
+    if (m_extent) {
+        m_file.unmap(m_extent);
+        m_extent = nullptr;
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <Python.h>
+
+class ExecutionRecording;
+
+/**
+ * @class ExecutionRecorder
+ * @brief 录制运行：把用户代码的行事件（可选附带局部变量的变化）写入只追加的二进制日志
+ *
+ * 运行线程在追踪函数中把每个事件编码到64KB的块中：行号和时间戳都与上一个行事件做差，
+ * 行号用zigzag、时间用变长整数，典型的循环每个行事件只占2到3个字节。
+ * 写满的块交给后台线程，后台线程把文件按16MB扩展并映射到内存后直接复制进去，
+ * 运行线程不做文件I/O；后台线程跟不上时运行线程等待（录制必须完整），
+ * 文件超过kMaxFileBytes时停止写入并标记为截断。
+ *
+ * 记录局部变量时，每个行事件比较栈帧中各变量当前绑定的对象与上次是否相同，
+ * 只有重新绑定的变量才求repr（截断到200个字符）并写入；原地修改的容器不会被记录。
+ *
+ * 文件格式：16字节头部（"QPYREC\0"、版本号、标志），之后是一串记录，每条以一个字节的类型开头：
+ * - Line：zigzag(行号差) varint(纳秒差)
+ * - Call / Return：进入和离开用户代码的栈帧，没有负载
+ * - Local：varint(名字长度) 名字 varint(值长度) 值，属于前一个行事件
+ * 类型为0表示文件结束（进程异常退出时未截断的尾部为0）。
+ *
+ * start()、record()和stop()都在持有GIL的运行线程中调用。
+ */
+class ExecutionRecorder
+{
+public:
+    // 文件大小上限
+    static const qint64 kMaxFileBytes = qint64(1) << 30;
+
+    // 记录类型
+    enum RecordType : quint8
+    {
+        EndRecord = 0,
+        LineRecord,
+        CallRecord,
+        ReturnRecord,
+        LocalRecord
+    };
+
+    // 头部标志
+    enum Flag : quint32
+    {
+        LocalsFlag    = 1,   // 记录了局部变量
+        TruncatedFlag = 2    // 达到文件大小上限，之后的事件没有记录
+    };
+
+    ExecutionRecorder() = default;
+
+    /**
+     * @brief 析构函数（停止后台线程）
+     */
+    ~ExecutionRecorder();
+
+    ExecutionRecorder(const ExecutionRecorder&)            = delete;
+    ExecutionRecorder& operator=(const ExecutionRecorder&) = delete;
+
+    /**
+     * @brief 开始录制，截断并重写文件
+     * @param path 日志文件路径
+     * @param recordLocals 是否记录局部变量的变化
+     * @return bool 文件无法打开时返回false，原因见errorString()
+     */
+    bool start(const QString& path, bool recordLocals);
+
+    /**
+     * @brief 记录一个追踪事件（只对用户代码的栈帧调用）
+     * @param event PyTrace_CALL、PyTrace_LINE或PyTrace_RETURN，其余忽略
+     * @param frame 事件所在的栈帧
+     * @param line 行号
+     */
+    void record(int event, PyFrameObject* frame, int line);
+
+    /**
+     * @brief 停止录制并打开录制结果
+     * @return std::shared_ptr<ExecutionRecording> 录制结果，未开始或出错时为空
+     */
+    std::shared_ptr<ExecutionRecording> stop();
+
+    /**
+     * @brief 是否正在录制
+     * @return bool 正在录制返回true
+     */
+    bool isRecording() const { return m_thread.joinable(); }
+
+    /**
+     * @brief 最近一次录制的错误信息
+     * @return QString 没有错误时为空
+     */
+    QString errorString() const { return m_error; }
+
+private:
+    // 一个栈帧中各变量上次记录时绑定的对象（名字和值都只比较地址）
+    using Bindings = std::unordered_map<PyObject*, PyObject*>;
+
+    /**
+     * @brief 确保当前块还有足够空间，不够时交给后台线程
+     * @param bytes 将要写入的字节数
+     */
+    void reserve(size_t bytes);
+
+    /**
+     * @brief 把当前块交给后台线程（后台线程积压过多时等待）
+     */
+    void flushChunk();
+
+    void putByte(quint8 value) { m_chunk.push_back(static_cast<char>(value)); }
+    void putVarint(quint64 value);
+    void putBytes(const char* data, size_t size);
+
+    /**
+     * @brief 记录栈帧中重新绑定过的局部变量
+     * @param frame 栈帧
+     */
+    void recordLocals(PyFrameObject* frame);
+
+    /**
+     * @brief 记录一个变量的新值
+     * @param name 变量名
+     * @param value 新值
+     */
+    void recordLocal(PyObject* name, PyObject* value);
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void writeLoop();
+
+    /**
+     * @brief 把一块数据复制到文件的映射中，需要时扩展文件（后台线程调用）
+     * @param data 数据
+     * @param size 字节数
+     * @return bool 写入成功返回true
+     */
+    bool writeMapped(const char* data, size_t size);
+
+    /**
+     * @brief 解除当前扩展区的映射（后台线程调用）
+     */
+    void unmapExtent();
+
+private:
+    // 以下只在运行线程中访问
+    std::vector<char> m_chunk;
+    bool              m_recordLocals = false;
+    int               m_lastLine     = 0;
+    qint64            m_startNs      = 0;
+    qint64            m_lastNs       = 0;
+    std::unordered_map<PyFrameObject*, Bindings> m_frames;
+    QString           m_path;
+    QString           m_error;
+
+    // 运行线程与后台线程之间的块队列，由m_mutex保护
+    std::thread                    m_thread;
+    std::mutex                     m_mutex;
+    std::condition_variable        m_wake;      // 有新块或要求停止
+    std::condition_variable        m_drained;   // 队列变短
+    std::deque<std::vector<char>>  m_queue;
+    std::vector<std::vector<char>> m_spare;     // 写完的块，运行线程复用其内存
+    bool                           m_stopping = false;
+    std::atomic<bool>              m_truncated{false};   // 已达到文件大小上限
+
+    // 以下只在后台线程中访问（start()之前和stop()之后由运行线程访问）
+    QFile  m_file;
+    uchar* m_extent       = nullptr;   // 当前扩展区的映射
+    qint64 m_extentOffset = 0;
+    qint64 m_written      = 0;         // 已写入的字节数（含头部）
+    QString m_writeError;
+};
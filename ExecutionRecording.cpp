@@ -0,0 +1,245 @@
+#include "ExecutionRecording.h"
+#include "ExecutionRecorder.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+// 头部：8字节标识、版本号、标志（小端），与ExecutionRecorder一致
+static const char    kMagic[8]   = {'Q', 'P', 'Y', 'R', 'E', 'C', '\0', '\0'};
+static const quint32 kVersion    = 1;
+static const qint64  kHeaderSize = 16;
+
+// 行号在检查点区间行集合中的位
+static quint64 lineBit(int line)
+{
+    return quint64(1) << (static_cast<unsigned int>(line) & 63);
+}
+
+ExecutionRecording::~ExecutionRecording()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+}
+
+std::shared_ptr<ExecutionRecording> ExecutionRecording::open(const QString& path, QString* error)
+{
+    std::shared_ptr<ExecutionRecording> recording(new ExecutionRecording);
+    recording->m_file.setFileName(path);
+    if (!recording->m_file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开录制文件%1：%2").arg(path, recording->m_file.errorString());
+        return nullptr;
+    }
+
+    recording->m_size = recording->m_file.size();
+    if (recording->m_size < kHeaderSize) {
+        *error = QString("录制文件%1不完整").arg(path);
+        return nullptr;
+    }
+    recording->m_data = recording->m_file.map(0, recording->m_size);
+    if (!recording->m_data) {
+        *error = QString("无法映射录制文件%1：%2").arg(path, recording->m_file.errorString());
+        return nullptr;
+    }
+
+    const uchar* data = recording->m_data;
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || qFromLittleEndian<quint32>(data + 8) != kVersion) {
+        *error = QString("%1不是录制文件或版本不受支持").arg(path);
+        return nullptr;
+    }
+    const quint32 flags      = qFromLittleEndian<quint32>(data + 12);
+    recording->m_hasLocals   = flags & ExecutionRecorder::LocalsFlag;
+    recording->m_truncated   = flags & ExecutionRecorder::TruncatedFlag;
+
+    // 顺序扫描一遍建立检查点和每个区间执行过的行
+    Cursor cursor;
+    cursor.offset = kHeaderSize;
+    for (;;) {
+        if (cursor.index % kCheckpointInterval == 0) {
+            Cursor checkpoint = cursor;
+            checkpoint.changed.clear();
+            recording->m_checkpoints.push_back(checkpoint);
+            recording->m_lineIndex.push_back(0);
+        }
+        if (!recording->next(&cursor)) {
+            break;
+        }
+        recording->m_lineIndex.back() |= lineBit(cursor.line);
+        recording->m_durationNs = cursor.ns;
+    }
+    recording->m_stepCount = cursor.index;
+    return recording;
+}
+
+ExecutionRecording::Step ExecutionRecording::step(qint64 index) const
+{
+    Step result;
+    if (index < 0 || index >= m_stepCount) {
+        return result;
+    }
+
+    const Cursor cursor = seek(index);
+    if (cursor.index != index + 1) {
+        return result;
+    }
+
+    result.index = index;
+    result.line  = cursor.line;
+    result.ns    = cursor.ns;
+    result.depth = qMax(1, cursor.frames.size());
+    if (!cursor.frames.isEmpty()) {
+        const QHash<QString, QString>& frame = cursor.frames.last();
+        result.locals.reserve(frame.size());
+        for (auto it = frame.constBegin(); it != frame.constEnd(); ++it) {
+            Local local;
+            local.name    = it.key();
+            local.value   = it.value();
+            local.changed = cursor.changed.contains(it.key());
+            result.locals.append(local);
+        }
+        std::sort(result.locals.begin(), result.locals.end(), [](const Local& a, const Local& b) {
+            return a.name < b.name;
+        });
+    }
+    return result;
+}
+
+qint64 ExecutionRecording::findLine(qint64 from, int line, bool forward) const
+{
+    const quint64 bit = lineBit(line);
+
+    if (forward) {
+        qint64 index = qMax<qint64>(from + 1, 0);
+        while (index < m_stepCount) {
+            const size_t interval = static_cast<size_t>(index / kCheckpointInterval);
+            const qint64 end      = qint64(interval + 1) * kCheckpointInterval;
+            // 区间中没有执行过这一行时整段跳过
+            if (m_lineIndex[interval] & bit) {
+                Cursor cursor = m_checkpoints[interval];
+                while (cursor.index < end && next(&cursor)) {
+                    if (cursor.index - 1 >= index && cursor.line == line) {
+                        return cursor.index - 1;
+                    }
+                }
+            }
+            index = end;
+        }
+        return -1;
+    }
+
+    qint64 index = qMin(from - 1, m_stepCount - 1);
+    while (index >= 0) {
+        const size_t interval = static_cast<size_t>(index / kCheckpointInterval);
+        const qint64 begin    = qint64(interval) * kCheckpointInterval;
+        if (m_lineIndex[interval] & bit) {
+            Cursor cursor = m_checkpoints[interval];
+            qint64 found  = -1;
+            while (cursor.index <= index && next(&cursor)) {
+                if (cursor.line == line) {
+                    found = cursor.index - 1;
+                }
+            }
+            if (found >= 0) {
+                return found;
+            }
+        }
+        index = begin - 1;
+    }
+    return -1;
+}
+
+bool ExecutionRecording::next(Cursor* cursor) const
+{
+    bool stepped = false;
+    cursor->changed.clear();
+
+    while (cursor->offset < m_size) {
+        const quint8 type = m_data[cursor->offset];
+
+        // 变量记录属于前一个行事件
+        if (type == ExecutionRecorder::LocalRecord) {
+            qint64  offset     = cursor->offset + 1;
+            quint64 nameSize   = 0;
+            quint64 valueSize  = 0;
+            if (!readVarint(&offset, &nameSize) || nameSize > quint64(m_size - offset)) {
+                return stepped;
+            }
+            const QString name = QString::fromUtf8(reinterpret_cast<const char*>(m_data + offset),
+                                                   static_cast<int>(nameSize));
+            offset += static_cast<qint64>(nameSize);
+            if (!readVarint(&offset, &valueSize) || valueSize > quint64(m_size - offset)) {
+                return stepped;
+            }
+            const QString value = QString::fromUtf8(reinterpret_cast<const char*>(m_data + offset),
+                                                    static_cast<int>(valueSize));
+            cursor->offset = offset + static_cast<qint64>(valueSize);
+
+            if (cursor->frames.isEmpty()) {
+                cursor->frames.append(QHash<QString, QString>());
+            }
+            cursor->frames.last().insert(name, value);
+            cursor->changed.append(name);
+            continue;
+        }
+
+        // 其余记录属于下一步
+        if (stepped) {
+            return true;
+        }
+
+        switch (type) {
+        case ExecutionRecorder::CallRecord:
+            cursor->frames.append(QHash<QString, QString>());
+            ++cursor->offset;
+            break;
+        case ExecutionRecorder::ReturnRecord:
+            if (!cursor->frames.isEmpty()) {
+                cursor->frames.removeLast();
+            }
+            ++cursor->offset;
+            break;
+        case ExecutionRecorder::LineRecord: {
+            qint64  offset    = cursor->offset + 1;
+            quint64 zigzag    = 0;
+            quint64 elapsedNs = 0;
+            if (!readVarint(&offset, &zigzag) || !readVarint(&offset, &elapsedNs)) {
+                return false;
+            }
+            cursor->offset = offset;
+            cursor->line += static_cast<int>(static_cast<qint64>(zigzag >> 1) ^ -static_cast<qint64>(zigzag & 1));
+            cursor->ns += static_cast<qint64>(elapsedNs);
+            ++cursor->index;
+            stepped = true;
+            break;
+        }
+        default:
+            // 文件结束（或未写完的尾部）
+            return stepped;
+        }
+    }
+    return stepped;
+}
+
+bool ExecutionRecording::readVarint(qint64* offset, quint64* value) const
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64 && *offset < m_size; shift += 7) {
+        const quint8 byte = m_data[(*offset)++];
+        result |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+ExecutionRecording::Cursor ExecutionRecording::seek(qint64 index) const
+{
+    Cursor cursor = m_checkpoints[static_cast<size_t>(index / kCheckpointInterval)];
+    while (cursor.index <= index && next(&cursor)) {
+    }
+    return cursor;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <memory>
+#include <vector>
+
+/**
+ * @class ExecutionRecording
+ * @brief 录制运行的结果：只读映射ExecutionRecorder写出的日志，按步随机访问
+ *
+ * 打开时顺序扫描一遍，每kCheckpointInterval步保存一个检查点（文件偏移、上一个行号和时间、
+ * 各层栈帧的变量值），之后取任意一步只需从最近的检查点解码不超过kCheckpointInterval步，
+ * 前后拖动都不需要重新运行代码。检查点中的变量表是隐式共享的，未变化的栈帧不占额外内存。
+ * 打开后不再修改，可以在任意线程中读取。
+ */
+class ExecutionRecording
+{
+public:
+    // 检查点间隔（步）
+    static const int kCheckpointInterval = 4096;
+
+    /**
+     * @brief 一个局部变量
+     */
+    struct Local
+    {
+        QString name;
+        QString value;          // 截断后的repr
+        bool    changed = false;   // 在这一步刚刚变化
+    };
+
+    /**
+     * @brief 一步：执行到某一行之前的状态
+     */
+    struct Step
+    {
+        qint64         index = -1;   // 步序号，从0开始
+        int            line  = 0;    // 将要执行的行号
+        qint64         ns    = 0;    // 距录制开始的纳秒数
+        int            depth = 0;    // 用户代码栈帧的嵌套深度，顶层为1
+        QVector<Local> locals;       // 当前栈帧的变量，按名字排序
+    };
+
+    ~ExecutionRecording();
+
+    ExecutionRecording(const ExecutionRecording&)            = delete;
+    ExecutionRecording& operator=(const ExecutionRecording&) = delete;
+
+    /**
+     * @brief 打开录制文件
+     * @param path 文件路径
+     * @param error 失败时写入原因
+     * @return std::shared_ptr<ExecutionRecording> 格式不对或无法映射时为空
+     */
+    static std::shared_ptr<ExecutionRecording> open(const QString& path, QString* error);
+
+    /**
+     * @brief 总步数
+     * @return qint64 行事件数
+     */
+    qint64 stepCount() const { return m_stepCount; }
+
+    /**
+     * @brief 录制的持续时间
+     * @return qint64 最后一步的时间戳（纳秒）
+     */
+    qint64 durationNs() const { return m_durationNs; }
+
+    /**
+     * @brief 文件大小
+     * @return qint64 字节数
+     */
+    qint64 fileBytes() const { return m_size; }
+
+    /**
+     * @brief 是否记录了局部变量
+     * @return bool 记录了返回true
+     */
+    bool hasLocals() const { return m_hasLocals; }
+
+    /**
+     * @brief 录制是否因文件大小上限而截断
+     * @return bool 截断返回true
+     */
+    bool isTruncated() const { return m_truncated; }
+
+    /**
+     * @brief 取一步的状态
+     * @param index 步序号
+     * @return Step 序号越界时index为-1
+     */
+    Step step(qint64 index) const;
+
+    /**
+     * @brief 查找某一行的上一次或下一次执行
+     * @param from 起始步（不含）
+     * @param line 行号
+     * @param forward true向后查找，false向前查找
+     * @return qint64 找到的步序号，没有时为-1
+     */
+    qint64 findLine(qint64 from, int line, bool forward) const;
+
+private:
+    ExecutionRecording() = default;
+
+    // 解码状态：位于某一步的行记录之前
+    struct Cursor
+    {
+        qint64                           offset = 0;
+        qint64                           index  = 0;   // 下一个行记录的步序号
+        int                              line   = 0;
+        qint64                           ns     = 0;
+        QVector<QHash<QString, QString>> frames;        // 各层栈帧的变量，最后一个是当前栈帧
+        QVector<QString>                 changed;       // 刚解码的一步中变化的变量
+    };
+
+    /**
+     * @brief 解码到下一步的行记录及其后的变量记录之后
+     * @param cursor 解码状态
+     * @return bool 成功解码一步返回true，文件结束或格式错误返回false
+     */
+    bool next(Cursor* cursor) const;
+
+    /**
+     * @brief 读取变长整数
+     * @param offset 读取位置，读完后前移
+     * @param value 输出值
+     * @return bool 没有越界返回true
+     */
+    bool readVarint(qint64* offset, quint64* value) const;
+
+    /**
+     * @brief 定位到某一步之前的状态
+     * @param index 步序号
+     * @return Cursor 解码状态
+     */
+    Cursor seek(qint64 index) const;
+
+private:
+    QFile                m_file;
+    const uchar*         m_data       = nullptr;
+    qint64               m_size       = 0;
+    qint64               m_stepCount  = 0;
+    qint64               m_durationNs = 0;
+    bool                 m_hasLocals  = false;
+    bool                 m_truncated  = false;
+    std::vector<Cursor>  m_checkpoints;   // 第i个位于第i*kCheckpointInterval步之前
+    std::vector<quint64> m_lineIndex;     // 每个检查点区间中执行过的行（每区间一个64位的行号哈希集合）
+};
@@ -0,0 +1,428 @@
+#include "ExecutionServer.h"
+#include "ConfigManager.h"
+#include "PythonInterpreterManager.h"
+#include "RemoteCodeRunner.h"
+#include "ServerProtocol.h"
+
+#include <QDebug>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <chrono>
+
+// 服务运行器的会话命名空间
+static const char* const kNamespaceContext = "server";
+
+// 执行行采样间隔（与编辑器刷新率一致）
+static const int kLineSampleMs = 16;
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+ExecutionServer::ExecutionServer(QObject* parent)
+    : QObject(parent)
+{}
+
+ExecutionServer::~ExecutionServer()
+{
+    close();
+}
+
+bool ExecutionServer::listen(const QString& name)
+{
+    if (m_server) {
+        return true;
+    }
+
+    // 运行器与标签页一样按执行后端创建
+    const ConfigManager& config = ConfigManager::instance();
+    if (config.getExecutionBackend() == "process") {
+        RemoteCodeRunner* remote = new RemoteCodeRunner(this);
+        remote->setPersistentNamespace(config.getPersistentNamespace());
+        m_runner = remote;
+    }
+    else {
+        m_runner       = new CodeRunner;
+        m_runnerThread = new QThread;
+        m_runner->setNamespaceContext(kNamespaceContext);
+        m_runner->moveToThread(m_runnerThread);
+        m_runnerThread->start();
+
+        connect(&PythonInterpreterManager::instance(),
+                &PythonInterpreterManager::aboutToRestart,
+                m_runner,
+                &CodeRunner::releasePythonState,
+                Qt::BlockingQueuedConnection);
+    }
+
+    connect(m_runner, &CodeRunner::executionStarted, this, &ExecutionServer::onExecutionStarted);
+    connect(m_runner, &CodeRunner::executionFinished, this, &ExecutionServer::onExecutionFinished);
+    connect(m_runner, &CodeRunner::outputReady, this, &ExecutionServer::forwardOutput);
+    connect(m_runner, &CodeRunner::runSummary, this, [this](const CodeRunner::RunSummary& summary) {
+        m_lastSummary = summary;
+    });
+    connect(m_runner, &CodeRunner::errorOccurred, this, [this](const QString& error) {
+        auto it = m_runs.find(m_activeRun);
+        if (it != m_runs.end()) {
+            it->failed = true;
+            send(it->client, ServerProtocol::Error, it->tag, error.toUtf8());
+        }
+    });
+    connect(m_runner, &CodeRunner::lineExecuted, this, [this](int line) {
+        auto it = m_runs.find(m_activeRun);
+        if (it != m_runs.end()) {
+            send(it->client, ServerProtocol::Paused, it->tag, ServerProtocol::encodeInteger<qint32>(line));
+        }
+    });
+
+    m_lineTimer = new QTimer(this);
+    m_lineTimer->setInterval(kLineSampleMs);
+    connect(m_lineTimer, &QTimer::timeout, this, &ExecutionServer::forwardLine);
+
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &ExecutionServer::onNewConnection);
+
+    // 上次异常退出时遗留的套接字文件会导致监听失败
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        m_errorString = m_server->errorString();
+        close();
+        return false;
+    }
+
+    qDebug() << "Execution server listening on" << m_server->fullServerName();
+    return true;
+}
+
+void ExecutionServer::close()
+{
+    // 客户端套接字是服务器的子对象，先于服务器释放
+    for (Client* client : m_clients) {
+        client->socket->disconnect(this);
+        client->socket->abort();
+        delete client->socket;
+        delete client;
+    }
+    m_clients.clear();
+    m_runs.clear();
+    m_activeRun = 0;
+
+    if (m_server) {
+        m_server->close();
+        delete m_server;
+        m_server = nullptr;
+    }
+
+    if (m_lineTimer) {
+        delete m_lineTimer;
+        m_lineTimer = nullptr;
+    }
+
+    if (m_runner) {
+        m_runner->disconnect(this);
+        m_runner->abortExecution();
+        if (m_runnerThread) {
+            PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+            if (pyManager.isInitialized() && !pyManager.isInitializing()) {
+                QMetaObject::invokeMethod(m_runner, &CodeRunner::releasePythonState, Qt::BlockingQueuedConnection);
+            }
+            m_runnerThread->quit();
+            m_runnerThread->wait();
+            delete m_runnerThread;
+            m_runnerThread = nullptr;
+
+            if (pyManager.isInitialized() && !pyManager.isInitializing()) {
+                py::gil_scoped_acquire acquire;
+                pyManager.releaseNamespace(kNamespaceContext);
+            }
+        }
+        delete m_runner;
+        m_runner = nullptr;
+    }
+}
+
+bool ExecutionServer::isListening() const
+{
+    return m_server && m_server->isListening();
+}
+
+QString ExecutionServer::fullServerName() const
+{
+    return m_server ? m_server->fullServerName() : QString();
+}
+
+ExecutionServer::Metrics ExecutionServer::metrics() const
+{
+    Metrics metrics = m_metrics;
+    metrics.clients = m_clients.size();
+    return metrics;
+}
+
+void ExecutionServer::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        Client* client = new Client;
+        client->socket = socket;
+        m_clients.insert(socket, client);
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, client]() { onReadyRead(client); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, client]() { onDisconnected(client); });
+    }
+}
+
+void ExecutionServer::onReadyRead(Client* client)
+{
+    const QByteArray data = client->socket->readAll();
+    m_metrics.bytesReceived += static_cast<quint64>(data.size());
+    client->buffer += data;
+
+    // 一次读到的多条命令按顺序处理，回复随之按顺序写出
+    for (;;) {
+        quint16    type = 0;
+        quint32    tag  = 0;
+        QByteArray payload;
+        const int  status = ServerProtocol::takeFrame(&client->buffer, &type, &tag, &payload);
+        if (status == 0) {
+            break;
+        }
+        if (status < 0) {
+            qWarning() << "Execution server: invalid frame, closing connection";
+            client->socket->disconnectFromServer();
+            break;
+        }
+
+        const qint64 startNs = monotonicNs();
+        handleCommand(client, type, tag, payload);
+        const qint64 replyNs = monotonicNs() - startNs;
+        ++m_metrics.commands;
+        m_metrics.totalReplyNs += replyNs;
+        m_metrics.maxReplyNs = qMax(m_metrics.maxReplyNs, replyNs);
+    }
+}
+
+void ExecutionServer::onDisconnected(Client* client)
+{
+    // 排队中的运行取消，正在进行的运行中止；之后的事件没有接收方
+    const QList<int> runIds = m_runs.keys();
+    for (int runId : runIds) {
+        Run& run = m_runs[runId];
+        if (run.client != client) {
+            continue;
+        }
+        run.client = nullptr;
+        m_runner->cancelRun(runId);
+        if (run.ticket->state.load() == RunScheduler::Cancelled) {
+            m_runs.remove(runId);
+        }
+    }
+
+    m_clients.remove(client->socket);
+    client->socket->disconnect(this);
+    client->socket->deleteLater();
+    delete client;
+}
+
+void ExecutionServer::handleCommand(Client* client, quint16 type, quint32 tag, const QByteArray& payload)
+{
+    switch (type) {
+    case ServerProtocol::Run: {
+        const ConfigManager&  config = ConfigManager::instance();
+        RunScheduler::Request request;
+        request.code             = QString::fromUtf8(payload);
+        request.priority         = RunScheduler::Batch;
+        request.budgets.wallMs   = config.getWallTimeLimit() * 1000LL;
+        request.budgets.cpuMs    = config.getCpuTimeLimit() * 1000LL;
+        request.budgets.memoryMB = config.getMemoryLimit();
+
+        Run run;
+        run.client = client;
+        run.tag    = tag;
+        run.ticket = m_runner->submitRun(request);
+        m_runs.insert(run.ticket->id, run);
+        ++m_metrics.runs;
+        send(client, ServerProtocol::Accepted, tag, ServerProtocol::encodeInteger<qint32>(run.ticket->id));
+        break;
+    }
+    case ServerProtocol::Abort: {
+        qint32 runId = 0;
+        if (payload.size() != 4 || !ServerProtocol::PayloadReader(payload).read(&runId)) {
+            send(client, ServerProtocol::Rejected, tag, QByteArray("Abort需要一个int32运行编号"));
+            break;
+        }
+        send(client, ServerProtocol::Ack, tag);
+        abortRun(client, runId);
+        break;
+    }
+    case ServerProtocol::SetBreakpoints: {
+        ServerProtocol::PayloadReader reader(payload);
+        quint32                       count = 0;
+        QVector<Breakpoint>           breakpoints;
+        bool                          ok = reader.read(&count);
+        for (quint32 i = 0; ok && i < count; ++i) {
+            qint32     line = 0;
+            Breakpoint breakpoint;
+            ok = reader.read(&line) && reader.readText(&breakpoint.condition) &&
+                 reader.readText(&breakpoint.hitCondition) && reader.readText(&breakpoint.logMessage);
+            breakpoint.line = line;
+            breakpoints.append(breakpoint);
+        }
+        if (!ok || !reader.atEnd()) {
+            send(client, ServerProtocol::Rejected, tag, QByteArray("断点负载格式错误"));
+            break;
+        }
+        m_runner->setBreakpoints(breakpoints);
+        send(client, ServerProtocol::Ack, tag);
+        break;
+    }
+    case ServerProtocol::Continue:
+        m_runner->continueExecution();
+        send(client, ServerProtocol::Ack, tag);
+        break;
+    case ServerProtocol::StepInto:
+        m_runner->stepInto();
+        send(client, ServerProtocol::Ack, tag);
+        break;
+    case ServerProtocol::StepOver:
+        m_runner->stepOver();
+        send(client, ServerProtocol::Ack, tag);
+        break;
+    case ServerProtocol::StepOut:
+        m_runner->stepOut();
+        send(client, ServerProtocol::Ack, tag);
+        break;
+    case ServerProtocol::Ping:
+        send(client, ServerProtocol::Pong, tag, payload);
+        break;
+    default:
+        send(client, ServerProtocol::Rejected, tag, QString("未知命令: %1").arg(type).toUtf8());
+        break;
+    }
+}
+
+void ExecutionServer::abortRun(Client* client, int runId)
+{
+    auto it = m_runs.find(runId);
+    if (it == m_runs.end() || it->client != client) {
+        return;
+    }
+
+    // 排队中的运行立即结束；正在运行的由运行器中止，结束后照常发送Finished
+    m_runner->cancelRun(runId);
+    if (it->ticket->state.load() == RunScheduler::Cancelled) {
+        const Run run = *it;
+        finishRun(run, ServerProtocol::Cancelled, 0);
+    }
+}
+
+void ExecutionServer::onExecutionStarted()
+{
+    // 服务运行器只运行客户端提交的请求，同一优先级先到先运行：
+    // 已经开始且尚未报告的最早的票据就是这一次运行
+    m_activeRun = 0;
+    for (auto it = m_runs.cbegin(); it != m_runs.cend(); ++it) {
+        if (it->ticket->startedNs != 0 && (m_activeRun == 0 || it.key() < m_activeRun)) {
+            m_activeRun = it.key();
+        }
+    }
+
+    auto it = m_runs.find(m_activeRun);
+    if (it == m_runs.end()) {
+        return;
+    }
+    m_lastSummary = CodeRunner::RunSummary();
+    m_lastLine    = -1;
+    send(it->client,
+         ServerProtocol::Started,
+         it->tag,
+         ServerProtocol::encodeInteger<qint64>(it->ticket->startedNs - it->ticket->submittedNs));
+    m_lineTimer->start();
+}
+
+void ExecutionServer::onExecutionFinished()
+{
+    m_lineTimer->stop();
+    forwardOutput();
+    forwardLine();
+
+    auto it = m_runs.find(m_activeRun);
+    m_activeRun = 0;
+    if (it == m_runs.end()) {
+        return;
+    }
+
+    const Run run    = *it;
+    quint8    status = ServerProtocol::Succeeded;
+    if (m_lastSummary.budgetExceeded != RunWatchdog::NoBudget) {
+        status = ServerProtocol::Failed;
+    }
+    else if (m_lastSummary.aborted) {
+        status = ServerProtocol::Aborted;
+    }
+    else if (run.failed) {
+        status = ServerProtocol::Failed;
+    }
+    finishRun(run, status, m_lastSummary.elapsedNs);
+}
+
+void ExecutionServer::forwardOutput()
+{
+    const QList<OutputChannel::Chunk> chunks = m_runner->outputChannel()->takeAll();
+
+    auto it = m_runs.find(m_activeRun);
+    if (it == m_runs.end()) {
+        return;
+    }
+    for (const OutputChannel::Chunk& chunk : chunks) {
+        send(it->client,
+             ServerProtocol::Output,
+             it->tag,
+             ServerProtocol::encodeInteger<quint8>(static_cast<quint8>(chunk.stream)) + chunk.text.toUtf8());
+    }
+}
+
+void ExecutionServer::forwardLine()
+{
+    auto it = m_runs.find(m_activeRun);
+    if (it == m_runs.end()) {
+        return;
+    }
+    std::shared_ptr<LineChannel> channel = m_runner->lineChannel();
+    if (!channel) {
+        return;
+    }
+
+    const int line = channel->latestLine();
+    if (line != m_lastLine) {
+        m_lastLine = line;
+        send(it->client, ServerProtocol::Line, it->tag, ServerProtocol::encodeInteger<qint32>(line));
+    }
+}
+
+void ExecutionServer::send(Client* client, quint16 type, quint32 tag, const QByteArray& payload)
+{
+    if (!client) {
+        return;
+    }
+    const QByteArray frame = ServerProtocol::encodeFrame(type, tag, payload);
+    m_metrics.bytesSent += static_cast<quint64>(frame.size());
+    client->socket->write(frame);
+}
+
+void ExecutionServer::finishRun(const Run& run, quint8 status, qint64 elapsedNs)
+{
+    ServerProtocol::FinishedPayload finished;
+    finished.status    = status;
+    finished.elapsedNs = elapsedNs;
+    if (run.ticket->startedNs != 0) {
+        finished.queueNs = run.ticket->startedNs - run.ticket->submittedNs;
+    }
+    send(run.client, ServerProtocol::Finished, run.tag, ServerProtocol::encodeFinished(finished));
+    m_runs.remove(run.ticket->id);
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "CodeRunner.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class QLocalServer;
+class QLocalSocket;
+class QThread;
+class QTimer;
+
+/**
+ * @class ExecutionServer
+ * @brief 本地执行服务：外部工具通过本地套接字向正在运行的应用提交代码
+ *
+ * 测试工具或仪表盘连接到QLocalServer，按ServerProtocol发送运行、中止、断点和单步命令，
+ * 接收输出、执行行、暂停和结束事件，不必每次启动一个新的解释器：
+ * - 服务有自己的运行器（与标签页一样按执行后端选择线程或执行进程）和会话命名空间"server"，
+ *   不影响编辑器中的运行
+ * - 多个客户端的运行请求都提交到这个运行器的调度队列，按批量优先级先到先运行；
+ *   客户端可以连续发送命令而不等待回复，每个运行的事件用提交时的标记区分
+ * - 客户端断开时，它排队中的运行被取消，正在进行的运行被中止
+ * - 统计命令数和从收到命令到写出回复的服务端耗时，往返延迟由客户端用Ping测量
+ *
+ * 所有接口都在界面线程中调用，运行器的信号经排队连接回到界面线程处理。
+ */
+class ExecutionServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 服务统计
+     */
+    struct Metrics
+    {
+        int     clients       = 0;   // 当前连接数
+        quint64 commands      = 0;   // 已处理的命令数
+        quint64 runs          = 0;   // 已接受的运行数
+        qint64  totalReplyNs  = 0;   // 处理命令并写出回复的耗时之和
+        qint64  maxReplyNs    = 0;
+        quint64 bytesReceived = 0;
+        quint64 bytesSent     = 0;
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit ExecutionServer(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（断开所有客户端并停止运行器）
+     */
+    ~ExecutionServer() override;
+
+    /**
+     * @brief 创建运行器并开始监听
+     * @param name 本地套接字名（Unix上为套接字文件名，Windows上为命名管道名）
+     * @return bool 成功返回true
+     */
+    bool listen(const QString& name);
+
+    /**
+     * @brief 停止监听，断开所有客户端并停止运行器
+     */
+    void close();
+
+    /**
+     * @brief 是否正在监听
+     */
+    bool isListening() const;
+
+    /**
+     * @brief 实际监听的完整地址（Unix上为套接字文件路径）
+     */
+    QString fullServerName() const;
+
+    /**
+     * @brief 监听失败的原因
+     */
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief 获取服务统计
+     * @return Metrics 统计快照
+     */
+    Metrics metrics() const;
+
+    /**
+     * @brief 服务的运行器（用于解释器重启时释放Python对象）
+     * @return CodeRunner* 运行器，未监听时为空
+     */
+    CodeRunner* runner() const { return m_runner; }
+
+private:
+    // 一个客户端连接
+    struct Client
+    {
+        QLocalSocket* socket = nullptr;
+        QByteArray    buffer;   // 尚未组成完整帧的字节
+    };
+
+    // 一次运行
+    struct Run
+    {
+        Client*                               client = nullptr;   // 客户端已断开时为空
+        quint32                               tag    = 0;
+        std::shared_ptr<RunScheduler::Ticket> ticket;
+        bool                                  failed = false;
+    };
+
+    /**
+     * @brief 接受新连接
+     */
+    void onNewConnection();
+
+    /**
+     * @brief 读取并处理客户端发来的所有完整帧
+     * @param client 客户端
+     */
+    void onReadyRead(Client* client);
+
+    /**
+     * @brief 客户端断开处理：取消或中止它的运行
+     * @param client 客户端
+     */
+    void onDisconnected(Client* client);
+
+    /**
+     * @brief 处理一条命令并写出回复
+     * @param client 客户端
+     * @param type 消息类型
+     * @param tag 标记
+     * @param payload 负载
+     */
+    void handleCommand(Client* client, quint16 type, quint32 tag, const QByteArray& payload);
+
+    /**
+     * @brief 处理中止命令
+     * @param client 客户端
+     * @param runId 运行编号（票据编号）
+     */
+    void abortRun(Client* client, int runId);
+
+    /**
+     * @brief 运行器开始运行：找出正在运行的票据
+     */
+    void onExecutionStarted();
+
+    /**
+     * @brief 运行器结束运行：转发剩余输出并发送Finished
+     */
+    void onExecutionFinished();
+
+    /**
+     * @brief 把运行器输出通道中的数据转发给当前运行的客户端
+     */
+    void forwardOutput();
+
+    /**
+     * @brief 采样最新执行行，有变化时转发
+     */
+    void forwardLine();
+
+    /**
+     * @brief 发送一帧
+     * @param client 客户端，为空时丢弃
+     * @param type 消息类型
+     * @param tag 标记
+     * @param payload 负载
+     */
+    void send(Client* client, quint16 type, quint32 tag, const QByteArray& payload = QByteArray());
+
+    /**
+     * @brief 发送运行结束事件并移除运行
+     * @param run 运行
+     * @param status 结束状态
+     * @param elapsedNs 运行耗时
+     */
+    void finishRun(const Run& run, quint8 status, qint64 elapsedNs);
+
+private:
+    QLocalServer* m_server       = nullptr;
+    CodeRunner*   m_runner       = nullptr;
+    QThread*      m_runnerThread = nullptr;   // 线程后端时运行器所在的线程
+    QTimer*       m_lineTimer    = nullptr;
+    QString       m_errorString;
+
+    QHash<QLocalSocket*, Client*> m_clients;
+    QHash<int, Run>               m_runs;               // 票据编号 -> 运行（排队中和运行中）
+    int                           m_activeRun  = 0;     // 正在运行的票据编号，0表示没有
+    int                           m_lastLine   = -1;
+    CodeRunner::RunSummary        m_lastSummary;
+    Metrics                       m_metrics;
+};
@@ -0,0 +1,335 @@
+#include "ExecutionWorker.h"
+#include "CodeRunner.h"
+#include "PythonInterpreterManager.h"
+#include "SyntaxCheck.h"
+#include "WorkerProtocol.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QMetaObject>
+#include <QThread>
+#include <QTimer>
+
+#include <cstdio>
+#include <thread>
+
+// 单条输出消息的最大字符数，保证远小于通道容量
+static const int kOutputSliceChars = 16 * 1024;
+
+// 执行行采样间隔（与编辑器刷新率一致）
+static const int kLineSampleMs = 16;
+
+int ExecutionWorker::run(const QString& key)
+{
+    ExecutionWorker worker;
+    if (!worker.start(key)) {
+        return 1;
+    }
+
+    // 主进程退出（包括崩溃）时标准输入被关闭，执行进程随之退出
+    std::thread([]() {
+        while (fgetc(stdin) != EOF) {
+        }
+        QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+    }).detach();
+
+    const int exitCode = QCoreApplication::exec();
+    worker.stop();
+    return exitCode;
+}
+
+ExecutionWorker::ExecutionWorker(QObject* parent)
+    : QObject(parent)
+{}
+
+ExecutionWorker::~ExecutionWorker()
+{
+    stop();
+}
+
+bool ExecutionWorker::start(const QString& key)
+{
+    if (!m_channel.attach(key)) {
+        qCritical() << "Execution worker cannot attach channel" << key << ":"
+                    << m_channel.errorString();
+        return false;
+    }
+
+    PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+    if (!pyManager.initialize()) {
+        m_channel.send(WorkerProtocol::Error, QByteArray("Python interpreter initialization failed"));
+        return false;
+    }
+
+    m_runner       = new CodeRunner;
+    m_runnerThread = new QThread;
+
+    // 图像写入共享内存，主进程收到Ready后附加，像素不经过消息通道
+    const QString                 framesKey = key + "-frames";
+    std::shared_ptr<FrameChannel> frames    = FrameChannel::createShared(framesKey);
+    m_runner->setFrameChannel(frames);
+    m_runner->moveToThread(m_runnerThread);
+    m_runnerThread->start();
+
+    // 运行器的信号在运行线程中发出，排队到本线程后按发出顺序转发
+    connect(m_runner, &CodeRunner::outputReady, this, &ExecutionWorker::forwardOutput);
+    connect(m_runner, &CodeRunner::variablesReady, this, [this](const VariableInspector::Page& page) {
+        m_channel.send(WorkerProtocol::Variables, VariableInspector::encode(page));
+    });
+    connect(m_runner, &CodeRunner::watchesReady, this, [this](const QVector<WatchList::Value>& values) {
+        m_channel.send(WorkerProtocol::Watches, WatchList::encode(values));
+    });
+    connect(m_runner, &CodeRunner::executionStarted, this, [this]() {
+        m_lastLine = -1;
+        m_channel.send(WorkerProtocol::Started);
+    });
+    connect(m_runner, &CodeRunner::lineExecuted, this, [this](int line) {
+        forwardOutput();
+        m_channel.send(WorkerProtocol::LineExecuted, WorkerProtocol::encode<qint32>(line));
+    });
+    connect(m_runner, &CodeRunner::debugStateChanged, this, [this](int state) {
+        m_channel.send(WorkerProtocol::DebugState, WorkerProtocol::encode<qint32>(state));
+    });
+    connect(m_runner, &CodeRunner::errorOccurred, this, [this](const QString& error) {
+        forwardOutput();
+        m_channel.send(WorkerProtocol::Error, error.toUtf8());
+    });
+    connect(m_runner, &CodeRunner::runSummary, this, [this](const CodeRunner::RunSummary& summary) {
+        forwardOutput();
+        forwardLine();
+
+        WorkerProtocol::SummaryPayload payload = {};
+        payload.elapsedNs        = summary.elapsedNs;
+        payload.abortLatencyNs   = summary.abortLatencyNs;
+        payload.aborted          = summary.aborted;
+        payload.hardStopped      = summary.hardStopped;
+        payload.budgetExceeded   = static_cast<quint8>(summary.budgetExceeded);
+        payload.compileNs        = summary.compileNs;
+        payload.cpuNs            = summary.cpuNs;
+        payload.traceEvents      = summary.traceEvents;
+        payload.traceNs          = summary.traceNs;
+        payload.outputBytes      = summary.outputBytes;
+        payload.outputLines      = summary.outputLines;
+        payload.logpointHits     = summary.logpointHits;
+        payload.logpointsDropped = summary.logpointsDropped;
+        m_channel.send(WorkerProtocol::Summary, WorkerProtocol::encode(payload));
+    });
+    connect(m_runner, &CodeRunner::inputWaitChanged, this, [this](bool waiting) {
+        // 提示文字先于等待通知到达界面
+        forwardOutput();
+        m_channel.send(WorkerProtocol::InputWaiting, WorkerProtocol::encode<quint8>(waiting ? 1 : 0));
+    });
+    connect(m_runner, &CodeRunner::executionFinished, this, [this]() {
+        m_channel.send(WorkerProtocol::Finished);
+    });
+
+    connect(&pyManager, &PythonInterpreterManager::warmUpFinished, this, [this]() {
+        m_channel.send(WorkerProtocol::WarmedUp,
+                       PythonInterpreterManager::encodeWarmUp(PythonInterpreterManager::instance().warmUpModules()));
+    });
+
+    m_lineTimer = new QTimer(this);
+    m_lineTimer->setInterval(kLineSampleMs);
+    connect(m_lineTimer, &QTimer::timeout, this, &ExecutionWorker::forwardLine);
+    m_lineTimer->start();
+
+    m_commandThread = QThread::create([this]() { commandLoop(); });
+    m_commandThread->start();
+
+    m_channel.send(WorkerProtocol::Ready, frames ? framesKey.toUtf8() : QByteArray());
+    return true;
+}
+
+void ExecutionWorker::stop()
+{
+    if (m_commandThread) {
+        m_channel.close();
+        m_commandThread->wait();
+        delete m_commandThread;
+        m_commandThread = nullptr;
+    }
+
+    if (m_runner) {
+        m_runner->abortExecution();
+        m_runnerThread->quit();
+        m_runnerThread->wait();
+        delete m_runner;
+        delete m_runnerThread;
+        m_runner       = nullptr;
+        m_runnerThread = nullptr;
+
+        // 检查器持有的Python对象在解释器关闭前释放
+        m_syntaxCheck.reset();
+        PythonInterpreterManager::instance().cleanup();
+    }
+}
+
+void ExecutionWorker::commandLoop()
+{
+    quint16    type = 0;
+    QByteArray payload;
+
+    while (m_channel.receive(&type, &payload, true)) {
+        handleCommand(type, payload);
+    }
+}
+
+void ExecutionWorker::handleCommand(quint16 type, const QByteArray& payload)
+{
+    // 调试和中止接口本身是线程安全的，直接在命令线程中调用，不经过忙碌的运行线程
+    switch (type) {
+    case WorkerProtocol::RunCode: {
+        const QString code = QString::fromUtf8(payload);
+        QMetaObject::invokeMethod(m_runner, "runCode", Qt::QueuedConnection, Q_ARG(QString, code));
+        break;
+    }
+    case WorkerProtocol::Abort:
+        m_runner->abortExecution();
+        break;
+    case WorkerProtocol::WriteInput:
+        m_runner->writeInput(payload);
+        break;
+    case WorkerProtocol::CloseInput:
+        m_runner->closeInput();
+        break;
+    case WorkerProtocol::Pause:
+        m_runner->pauseExecution();
+        break;
+    case WorkerProtocol::Continue:
+        m_runner->continueExecution();
+        break;
+    case WorkerProtocol::StepInto:
+        m_runner->stepInto();
+        break;
+    case WorkerProtocol::StepOver:
+        m_runner->stepOver();
+        break;
+    case WorkerProtocol::StepOut:
+        m_runner->stepOut();
+        break;
+    case WorkerProtocol::SetBreakpoints: {
+        QDataStream stream(payload);
+        qint32      count = 0;
+        stream >> count;
+
+        QVector<Breakpoint> breakpoints;
+        for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            qint32     line = 0;
+            Breakpoint breakpoint;
+            stream >> line >> breakpoint.condition >> breakpoint.hitCondition >> breakpoint.logMessage;
+            breakpoint.line = line;
+            breakpoints.append(breakpoint);
+        }
+        if (stream.status() == QDataStream::Ok) {
+            m_runner->setBreakpoints(breakpoints);
+        }
+        break;
+    }
+    case WorkerProtocol::SetPersistentNamespace: {
+        quint8 persistent = 0;
+        if (WorkerProtocol::decode(payload, &persistent)) {
+            PythonInterpreterManager::instance().setPersistentNamespace(persistent != 0);
+        }
+        break;
+    }
+    case WorkerProtocol::RequestVariables: {
+        WorkerProtocol::VariableRequestPayload data;
+        if (WorkerProtocol::decode(payload, &data)) {
+            m_runner->requestVariables(data.handle, data.start, data.count);
+        }
+        break;
+    }
+    case WorkerProtocol::SetWatches: {
+        QDataStream stream(payload);
+        QStringList expressions;
+        stream >> expressions;
+        if (stream.status() == QDataStream::Ok) {
+            m_runner->setWatchExpressions(expressions);
+        }
+        break;
+    }
+    case WorkerProtocol::SetBudgets: {
+        WorkerProtocol::BudgetPayload data;
+        if (WorkerProtocol::decode(payload, &data)) {
+            RunWatchdog::Budgets budgets;
+            budgets.wallMs   = data.wallMs;
+            budgets.cpuMs    = data.cpuMs;
+            budgets.memoryMB = data.memoryMB;
+            m_runner->setBudgets(budgets);
+        }
+        break;
+    }
+    case WorkerProtocol::CheckSyntax: {
+        quint64 id = 0;
+        QString code;
+        if (SyntaxCheck::decodeRequest(payload, &id, &code)) {
+            if (!m_syntaxCheck) {
+                m_syntaxCheck.reset(new SyntaxCheck);
+            }
+            QVector<SyntaxCheck::Diagnostic> diagnostics;
+            {
+                py::gil_scoped_acquire acquire;
+                diagnostics = m_syntaxCheck->check(code);
+            }
+            m_channel.send(WorkerProtocol::Diagnostics, SyntaxCheck::encode(id, diagnostics));
+        }
+        break;
+    }
+    case WorkerProtocol::WarmUp: {
+        QDataStream stream(payload);
+        QStringList modules;
+        stream >> modules;
+        if (stream.status() == QDataStream::Ok) {
+            PythonInterpreterManager::instance().warmUp(modules);
+        }
+        break;
+    }
+    case WorkerProtocol::Shutdown:
+        QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+        break;
+    default:
+        qWarning() << "Execution worker received unknown command" << type;
+        break;
+    }
+}
+
+void ExecutionWorker::forwardOutput()
+{
+    const QList<OutputChannel::Chunk> chunks = m_runner->outputChannel()->takeAll();
+
+    for (const OutputChannel::Chunk& chunk : chunks) {
+        quint16 type = WorkerProtocol::StdOut;
+        if (chunk.stream == OutputChannel::StdErr) {
+            type = WorkerProtocol::StdErr;
+        }
+        else if (chunk.stream == OutputChannel::Log) {
+            type = WorkerProtocol::LogOutput;
+        }
+
+        // 大段输出切片发送，切点不落在代理对中间
+        int start = 0;
+        while (start < chunk.text.size()) {
+            int length = qMin(kOutputSliceChars, chunk.text.size() - start);
+            if (start + length < chunk.text.size() && chunk.text.at(start + length - 1).isHighSurrogate()) {
+                --length;
+            }
+            m_channel.send(type, chunk.text.mid(start, length).toUtf8());
+            start += length;
+        }
+    }
+}
+
+void ExecutionWorker::forwardLine()
+{
+    std::shared_ptr<LineChannel> channel = m_runner->lineChannel();
+    if (!channel) {
+        return;
+    }
+
+    const int line = channel->latestLine();
+    if (line != m_lastLine) {
+        m_lastLine = line;
+        m_channel.send(WorkerProtocol::Line, WorkerProtocol::encode<qint32>(line));
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "IpcChannel.h"
+
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class CodeRunner;
+class SyntaxCheck;
+class QThread;
+class QTimer;
+
+/**
+ * @class ExecutionWorker
+ * @brief 执行进程中的CodeRunner宿主
+ *
+ * 以 --execution-worker <通道标识> 启动时，进程不创建任何窗口：
+ * - 初始化Python解释器，在独立线程中运行一个CodeRunner
+ * - 命令线程阻塞读取主进程发来的命令，直接调用运行器的线程安全接口
+ * - 输出、执行行和调试事件在主线程中整理后写回共享内存通道
+ * - 标准输入关闭（主进程退出）时随之退出，不会遗留孤儿进程
+ *
+ * 诊断进程也以同样的方式启动，只接收CheckSyntax命令，在命令线程中持有本进程的GIL编译检查代码。
+ */
+class ExecutionWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 执行进程入口（需要已创建QCoreApplication）
+     * @param key 通道标识
+     * @return int 进程退出码
+     */
+    static int run(const QString& key);
+
+private:
+    explicit ExecutionWorker(QObject* parent = nullptr);
+    ~ExecutionWorker();
+
+    /**
+     * @brief 附加通道、初始化解释器并启动运行器
+     * @param key 通道标识
+     * @return bool 成功返回true
+     */
+    bool start(const QString& key);
+
+    /**
+     * @brief 停止命令线程和运行器
+     */
+    void stop();
+
+    /**
+     * @brief 命令线程主函数
+     */
+    void commandLoop();
+
+    /**
+     * @brief 处理一条命令（在命令线程中调用）
+     * @param type 消息类型
+     * @param payload 负载
+     */
+    void handleCommand(quint16 type, const QByteArray& payload);
+
+    /**
+     * @brief 把运行器输出通道中的数据转发给主进程
+     */
+    void forwardOutput();
+
+    /**
+     * @brief 采样最新执行行，有变化时转发
+     */
+    void forwardLine();
+
+private:
+    IpcChannel  m_channel{IpcChannel::Worker};
+    CodeRunner* m_runner        = nullptr;
+    QThread*    m_runnerThread  = nullptr;
+    QThread*    m_commandThread = nullptr;
+    QTimer*     m_lineTimer     = nullptr;
+    int         m_lastLine      = -1;
+
+    std::unique_ptr<SyntaxCheck> m_syntaxCheck;   // 只在命令线程中使用
+};
@@ -0,0 +1,130 @@
+#include "FileLoader.h"
+
+#include <cstring>
+
+FileLoader::FileLoader(QObject* parent)
+    : QObject(parent)
+{
+}
+
+FileLoader::~FileLoader()
+{
+    cancel();
+}
+
+bool FileLoader::start(const QString& path)
+{
+    cancel();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_totalBytes = m_file.size();
+    if (m_totalBytes > 0) {
+        m_data = m_file.map(0, m_totalBytes);
+        if (!m_data) {
+            m_error = m_file.errorString();
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_decoded   = false;
+    m_cancelled = false;
+    m_started   = true;
+    m_thread    = std::thread(&FileLoader::decodeLoop, this);
+    return true;
+}
+
+void FileLoader::cancel()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cancelled = true;
+        }
+        m_spaceAvailable.notify_one();
+        m_thread.join();
+    }
+
+    m_chunks.clear();
+    m_started = false;
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_totalBytes = 0;
+}
+
+bool FileLoader::takeChunk(QString* text, qint64* loadedBytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_chunks.empty()) {
+            return false;
+        }
+        Chunk& chunk = m_chunks.front();
+        text->swap(chunk.text);
+        *loadedBytes = chunk.endOffset;
+        m_chunks.pop_front();
+    }
+    m_spaceAvailable.notify_one();
+    return true;
+}
+
+bool FileLoader::isFinished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_decoded && m_chunks.empty();
+}
+
+void FileLoader::decodeLoop()
+{
+    const char* data   = reinterpret_cast<const char*>(m_data);
+    qint64      offset = 0;
+
+    // UTF-8 BOM
+    if (m_totalBytes >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        offset = 3;
+    }
+
+    while (offset < m_totalBytes) {
+        // 在kChunkBytes之后的第一个换行处切分，换行归前一块
+        qint64 end = qMin(offset + kChunkBytes, m_totalBytes);
+        if (end < m_totalBytes) {
+            const void* newline = std::memchr(data + end, '\n', size_t(m_totalBytes - end));
+            end = newline ? static_cast<const char*>(newline) - data + 1 : m_totalBytes;
+        }
+
+        Chunk chunk;
+        chunk.text = QString::fromUtf8(data + offset, int(end - offset));
+        if (chunk.text.contains(QLatin1Char('\r'))) {
+            chunk.text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+        }
+        chunk.endOffset = end;
+        offset          = end;
+
+        bool wasEmpty = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_spaceAvailable.wait(lock, [this]() { return m_cancelled || int(m_chunks.size()) < kMaxQueuedChunks; });
+            if (m_cancelled) {
+                return;
+            }
+            wasEmpty = m_chunks.empty();
+            m_chunks.push_back(std::move(chunk));
+        }
+        if (wasEmpty) {
+            emit chunksAvailable();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decoded = true;
+    }
+    emit chunksAvailable();
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QtGlobal>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class FileLoader
+ * @brief 在后台线程中分块解码文本文件，供编辑器逐块追加
+ *
+ * start()在界面线程中打开文件并映射到内存（不读取内容），后台线程按约kChunkBytes字节一块、
+ * 在换行处切分后解码UTF-8（去掉开头的BOM，\r\n换成\n），放入有界队列；
+ * 队列满时后台线程等待界面线程取走，所以内存中最多只有kMaxQueuedChunks块解码后的文本。
+ * 在换行处切分保证多字节字符不会被切开。
+ *
+ * 队列由空变为非空时发出chunksAvailable()（跨线程排队到界面线程），
+ * 界面线程用takeChunk()取块，isFinished()为true表示所有块都已取走。
+ */
+class FileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 每块的字节数（实际在其后的第一个换行处切分）
+    static const qint64 kChunkBytes = 1 << 20;
+
+    // 队列中最多保留的块数
+    static const int kMaxQueuedChunks = 4;
+
+    explicit FileLoader(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（取消加载）
+     */
+    ~FileLoader() override;
+
+    /**
+     * @brief 开始加载，取消之前未完成的加载
+     * @param path 文件路径
+     * @return bool 文件无法打开或映射时返回false，原因见errorString()
+     */
+    bool start(const QString& path);
+
+    /**
+     * @brief 取消加载，等待后台线程结束并丢弃未取走的块
+     */
+    void cancel();
+
+    /**
+     * @brief 取出一块解码后的文本（界面线程）
+     * @param text 输出的文本
+     * @param loadedBytes 输出到这一块为止的源文件字节数
+     * @return bool 队列为空时返回false
+     */
+    bool takeChunk(QString* text, qint64* loadedBytes);
+
+    /**
+     * @brief 所有块是否都已取走
+     * @return bool 已加载完返回true
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief 是否有一次加载正在进行（已开始且未取完）
+     * @return bool 正在加载返回true
+     */
+    bool isLoading() const { return m_started && !isFinished(); }
+
+    /**
+     * @brief 文件总字节数
+     * @return qint64 字节数
+     */
+    qint64 totalBytes() const { return m_totalBytes; }
+
+    /**
+     * @brief 最近一次失败的原因
+     * @return QString 错误信息
+     */
+    QString errorString() const { return m_error; }
+
+signals:
+    /**
+     * @brief 队列由空变为非空，或后台线程已解码完（在后台线程中发出）
+     */
+    void chunksAvailable();
+
+private:
+    // 一块解码后的文本
+    struct Chunk
+    {
+        QString text;
+        qint64  endOffset = 0;   // 这一块在源文件中的结束位置
+    };
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void decodeLoop();
+
+private:
+    QFile        m_file;
+    const uchar* m_data       = nullptr;   // 映射的文件内容，空文件为nullptr
+    qint64       m_totalBytes = 0;
+    QString      m_error;
+    bool         m_started    = false;
+
+    // 以下由m_mutex保护
+    std::thread             m_thread;
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_spaceAvailable;
+    std::deque<Chunk>       m_chunks;
+    bool                    m_decoded   = false;   // 后台线程已放入最后一块
+    bool                    m_cancelled = false;
+};
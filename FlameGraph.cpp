@@ -0,0 +1,91 @@
+#include "FlameGraph.h"
+
+#include <QStringList>
+
+#include <vector>
+
+FlameGraph::FlameGraph()
+{
+    m_nodes.append(Node());
+}
+
+int FlameGraph::addFrame(const Frame& frame)
+{
+    m_frames.append(frame);
+    return m_frames.size() - 1;
+}
+
+void FlameGraph::addSample(const int* frames, int depth)
+{
+    int current = 0;
+    ++m_nodes[0].samples;
+
+    for (int i = 0; i < depth; ++i) {
+        const quint64 key = (static_cast<quint64>(current) << 32) | static_cast<quint32>(frames[i]);
+
+        auto it = m_childIndex.constFind(key);
+        int  child;
+        if (it != m_childIndex.constEnd()) {
+            child = it.value();
+        }
+        else {
+            Node node;
+            node.frame  = frames[i];
+            node.parent = current;
+            m_nodes.append(node);
+            child = m_nodes.size() - 1;
+            m_nodes[current].children.append(child);
+            m_childIndex.insert(key, child);
+        }
+
+        ++m_nodes[child].samples;
+        current = child;
+    }
+
+    ++m_nodes[current].selfSamples;
+    m_maxDepth = qMax(m_maxDepth, depth);
+}
+
+void FlameGraph::setTiming(int rateHz, qint64 durationNs, qint64 overheadNs)
+{
+    m_rateHz     = rateHz;
+    m_durationNs = durationNs;
+    m_overheadNs = overheadNs;
+}
+
+QString FlameGraph::toFolded() const
+{
+    QString     result;
+    QStringList path;
+
+    // 深度优先遍历，每个有自身样本的节点输出一行
+    struct Entry
+    {
+        int node;
+        int depth;
+    };
+    std::vector<Entry> stack;
+    for (int i = m_nodes[0].children.size() - 1; i >= 0; --i) {
+        stack.push_back({m_nodes[0].children[i], 0});
+    }
+
+    while (!stack.empty()) {
+        const Entry entry = stack.back();
+        const Node& node  = m_nodes[entry.node];
+        stack.pop_back();
+
+        while (path.size() > entry.depth) {
+            path.removeLast();
+        }
+        path.append(m_frames[node.frame].name);
+
+        if (node.selfSamples > 0) {
+            result += path.join(';') + ' ' + QString::number(node.selfSamples) + '\n';
+        }
+        for (int i = node.children.size() - 1; i >= 0; --i) {
+            stack.push_back({node.children[i], entry.depth + 1});
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class FlameGraph
+ * @brief 采样分析结果：按调用栈合并的采样树
+ *
+ * 每个节点是从最外层调用到某个函数的一条调用路径，样本数包含所有子节点；
+ * 函数信息只保存一份，节点通过编号引用，采样时不构造字符串。
+ * 节点0是根节点，代表全部样本。
+ */
+class FlameGraph
+{
+public:
+    /**
+     * @brief 函数信息
+     */
+    struct Frame
+    {
+        QString name;            // 限定名，例如 Foo.bar
+        QString file;                // 源文件
+        int     firstLine = 0;       // 函数定义所在行
+        bool    userCode  = false;   // 是否是编辑器中的代码
+    };
+
+    /**
+     * @brief 采样树节点
+     */
+    struct Node
+    {
+        int          frame       = -1;   // 函数编号，根节点为-1
+        int          parent      = -1;
+        quint64      samples     = 0;    // 经过该节点的样本数
+        quint64      selfSamples = 0;    // 栈顶就是该节点的样本数
+        QVector<int> children;
+    };
+
+    /**
+     * @brief 构造函数（只包含根节点）
+     */
+    FlameGraph();
+
+    /**
+     * @brief 登记一个函数
+     * @param frame 函数信息
+     * @return int 函数编号
+     */
+    int addFrame(const Frame& frame);
+
+    /**
+     * @brief 记录一个样本
+     * @param frames 调用栈上的函数编号，从最外层到最内层
+     * @param depth 调用栈深度
+     */
+    void addSample(const int* frames, int depth);
+
+    /**
+     * @brief 获取函数信息
+     * @param index 函数编号
+     * @return const Frame& 函数信息
+     */
+    const Frame& frame(int index) const { return m_frames[index]; }
+
+    /**
+     * @brief 获取节点
+     * @param index 节点编号，0为根节点
+     * @return const Node& 节点
+     */
+    const Node& node(int index) const { return m_nodes[index]; }
+
+    /**
+     * @brief 获取节点数（含根节点）
+     * @return int 数量
+     */
+    int nodeCount() const { return m_nodes.size(); }
+
+    /**
+     * @brief 获取样本总数
+     * @return quint64 数量
+     */
+    quint64 totalSamples() const { return m_nodes[0].samples; }
+
+    /**
+     * @brief 获取最深的调用栈深度
+     * @return int 深度
+     */
+    int maxDepth() const { return m_maxDepth; }
+
+    /**
+     * @brief 设置采样统计
+     * @param rateHz 设定的采样频率
+     * @param durationNs 采样持续时间
+     * @param overheadNs 采样线程持有GIL的总时间（运行线程因此停顿的时间）
+     */
+    void setTiming(int rateHz, qint64 durationNs, qint64 overheadNs);
+
+    int    rateHz() const { return m_rateHz; }
+    qint64 durationNs() const { return m_durationNs; }
+    qint64 overheadNs() const { return m_overheadNs; }
+
+    /**
+     * @brief 导出为折叠栈格式（每行"外层;内层 样本数"，可直接交给flamegraph.pl等工具）
+     * @return QString 折叠栈文本
+     */
+    QString toFolded() const;
+
+private:
+    QVector<Frame>      m_frames;
+    QVector<Node>       m_nodes;
+    QHash<quint64, int> m_childIndex;   // (父节点 << 32 | 函数编号) -> 子节点
+    int                 m_maxDepth   = 0;
+    int                 m_rateHz     = 0;
+    qint64              m_durationNs = 0;
+    qint64              m_overheadNs = 0;
+};
@@ -0,0 +1,233 @@
+#include "FlameGraphView.h"
+#include "FlameGraph.h"
+
+#include <QContextMenuEvent>
+#include <QFile>
+#include <QFileDialog>
+#include <QMenu>
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTextStream>
+#include <QToolTip>
+
+#include <vector>
+
+FlameGraphView::FlameGraphView(QWidget* parent)
+    : QWidget(parent)
+{
+    setMouseTracking(true);
+    m_rowHeight = fontMetrics().height() + 4;
+}
+
+void FlameGraphView::setFlameGraph(const std::shared_ptr<FlameGraph>& graph)
+{
+    m_graph    = graph;
+    m_zoomNode = 0;
+
+    const int rows = m_graph ? m_graph->maxDepth() + 1 : 0;
+    setMinimumHeight(rows * m_rowHeight);
+
+    layoutBoxes();
+    update();
+}
+
+QSize FlameGraphView::sizeHint() const
+{
+    return QSize(600, minimumHeight());
+}
+
+void FlameGraphView::layoutBoxes()
+{
+    m_boxes.clear();
+    if (!m_graph || m_graph->totalSamples() == 0) {
+        return;
+    }
+
+    const double width = this->width();
+
+    // 放大节点的祖先占满整行
+    QVector<int> ancestors;
+    for (int node = m_zoomNode; node >= 0; node = m_graph->node(node).parent) {
+        ancestors.prepend(node);
+    }
+    for (int depth = 0; depth < ancestors.size() - 1; ++depth) {
+        m_boxes.append({QRectF(0, depth * m_rowHeight, width, m_rowHeight), ancestors[depth]});
+    }
+
+    // 从放大节点开始按样本比例展开，窄于一个像素的子树不再继续
+    const double scale = width / m_graph->node(m_zoomNode).samples;
+
+    struct Entry
+    {
+        int    node;
+        int    depth;
+        double x;
+    };
+    std::vector<Entry> stack;
+    stack.push_back({m_zoomNode, ancestors.size() - 1, 0.0});
+
+    while (!stack.empty()) {
+        const Entry             entry = stack.back();
+        const FlameGraph::Node& node  = m_graph->node(entry.node);
+        stack.pop_back();
+
+        const double boxWidth = node.samples * scale;
+        if (boxWidth < 1.0) {
+            continue;
+        }
+        m_boxes.append({QRectF(entry.x, entry.depth * m_rowHeight, boxWidth, m_rowHeight), entry.node});
+
+        double childX = entry.x;
+        for (int child : node.children) {
+            stack.push_back({child, entry.depth + 1, childX});
+            childX += m_graph->node(child).samples * scale;
+        }
+    }
+}
+
+int FlameGraphView::nodeAt(const QPoint& pos) const
+{
+    for (const Box& box : m_boxes) {
+        if (box.rect.contains(pos)) {
+            return box.node;
+        }
+    }
+    return -1;
+}
+
+QString FlameGraphView::nodeName(int node) const
+{
+    const int frame = m_graph->node(node).frame;
+    return frame < 0 ? QString("全部") : m_graph->frame(frame).name;
+}
+
+void FlameGraphView::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    if (m_boxes.isEmpty()) {
+        painter.setPen(palette().color(QPalette::Disabled, QPalette::Text));
+        painter.drawText(rect(), Qt::AlignCenter, "点击\"采样分析\"运行代码后在这里显示火焰图");
+        return;
+    }
+
+    const QFontMetrics metrics = fontMetrics();
+    for (const Box& box : m_boxes) {
+        const int  frame  = m_graph->node(box.node).frame;
+        const bool isUser = frame >= 0 && m_graph->frame(frame).userCode;
+
+        // 同一函数颜色固定：用户代码偏橙，其他代码偏黄
+        const uint hash = frame >= 0 ? qHash(m_graph->frame(frame).name) : 0;
+        QColor     color =
+            frame < 0 ? QColor(200, 200, 200)
+                      : QColor::fromHsv(isUser ? 10 + hash % 25 : 40 + hash % 20, 140 + hash % 60, 235);
+
+        const QRectF rect = box.rect.adjusted(0, 0, -1, -1);
+        painter.fillRect(rect, color);
+
+        if (rect.width() > 20) {
+            painter.setPen(Qt::black);
+            painter.drawText(rect.adjusted(3, 0, -3, 0),
+                             Qt::AlignVCenter | Qt::AlignLeft,
+                             metrics.elidedText(nodeName(box.node), Qt::ElideRight,
+                                                static_cast<int>(rect.width()) - 6));
+        }
+    }
+}
+
+void FlameGraphView::mouseMoveEvent(QMouseEvent* event)
+{
+    const int node = nodeAt(event->pos());
+    if (node < 0) {
+        QToolTip::hideText();
+        return;
+    }
+
+    const FlameGraph::Node& info  = m_graph->node(node);
+    const double            total = m_graph->totalSamples();
+
+    QString text = QString("%1\n样本 %2（%3%），自身 %4")
+                       .arg(nodeName(node))
+                       .arg(info.samples)
+                       .arg(100.0 * info.samples / total, 0, 'f', 1)
+                       .arg(info.selfSamples);
+    if (info.frame >= 0) {
+        const FlameGraph::Frame& frame = m_graph->frame(info.frame);
+        text += QString("\n%1:%2").arg(frame.file).arg(frame.firstLine);
+    }
+    QToolTip::showText(event->globalPos(), text, this);
+}
+
+void FlameGraphView::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton) {
+        return;
+    }
+
+    const int node = nodeAt(event->pos());
+    if (node >= 0 && node != m_zoomNode) {
+        m_zoomNode = node;
+        layoutBoxes();
+        update();
+    }
+}
+
+void FlameGraphView::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    const int node = nodeAt(event->pos());
+    if (node < 0 || m_graph->node(node).frame < 0) {
+        return;
+    }
+
+    const FlameGraph::Frame& frame = m_graph->frame(m_graph->node(node).frame);
+    if (frame.userCode && frame.firstLine > 0) {
+        emit frameActivated(frame.firstLine);
+    }
+}
+
+void FlameGraphView::contextMenuEvent(QContextMenuEvent* event)
+{
+    if (!m_graph) {
+        return;
+    }
+
+    QMenu    menu(this);
+    QAction* resetAction  = menu.addAction("恢复全部");
+    QAction* exportAction = menu.addAction("导出折叠栈...");
+    resetAction->setEnabled(m_zoomNode != 0);
+
+    QAction* chosen = menu.exec(event->globalPos());
+    if (chosen == resetAction) {
+        m_zoomNode = 0;
+        layoutBoxes();
+        update();
+    }
+    else if (chosen == exportAction) {
+        exportFolded();
+    }
+}
+
+void FlameGraphView::resizeEvent(QResizeEvent*)
+{
+    layoutBoxes();
+}
+
+void FlameGraphView::exportFolded()
+{
+    const QString path =
+        QFileDialog::getSaveFileName(this, "导出折叠栈", "profile.folded", "折叠栈 (*.folded *.txt)");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "导出失败", "无法写入文件：" + file.errorString());
+        return;
+    }
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << m_graph->toFolded();
+}
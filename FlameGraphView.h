@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QRectF>
+#include <QVector>
+#include <QWidget>
+
+#include <memory>
+
+class FlameGraph;
+
+/**
+ * @class FlameGraphView
+ * @brief 火焰图（冰柱图）视图
+ *
+ * 最外层调用在最上方，每个方块的宽度与经过该调用路径的样本数成正比：
+ * - 单击方块放大到该调用路径，单击最上方的"全部"恢复
+ * - 悬停显示函数、样本数和占比，双击用户代码中的函数发出frameActivated
+ * - 右键菜单可以导出折叠栈文本，交给flamegraph.pl等外部工具
+ *
+ * 只绘制宽度不小于一个像素的方块，绘制量与样本数无关。
+ */
+class FlameGraphView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit FlameGraphView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 显示一次采样运行的结果
+     * @param graph 采样结果，为空时清空视图
+     */
+    void setFlameGraph(const std::shared_ptr<FlameGraph>& graph);
+
+    QSize sizeHint() const override;
+
+signals:
+    /**
+     * @brief 用户双击用户代码中的函数
+     * @param lineNumber 函数定义所在行（1-based）
+     */
+    void frameActivated(int lineNumber);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    struct Box
+    {
+        QRectF rect;
+        int    node;
+    };
+
+    /**
+     * @brief 按当前宽度和放大节点重新计算方块位置
+     */
+    void layoutBoxes();
+
+    /**
+     * @brief 查找某个位置上的节点
+     * @param pos 视图坐标
+     * @return int 节点编号，没有方块时返回-1
+     */
+    int nodeAt(const QPoint& pos) const;
+
+    /**
+     * @brief 节点显示的名称
+     * @param node 节点编号
+     * @return QString 名称
+     */
+    QString nodeName(int node) const;
+
+    /**
+     * @brief 把折叠栈导出到文件
+     */
+    void exportFolded();
+
+private:
+    std::shared_ptr<FlameGraph> m_graph;
+    int                         m_zoomNode  = 0;
+    int                         m_rowHeight = 18;
+    QVector<Box>                m_boxes;
+};
@@ -0,0 +1,316 @@
+#include "FrameChannel.h"
+
+#include <QDebug>
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+// 内存布局版本，两端不一致时拒绝附加
+static const quint32 kFrameMagic   = 0x51504652;   // "QPFR"
+static const quint32 kFrameVersion = 1;
+
+// 中间缓冲区编号中的"有新帧"标志
+static const quint32 kDirty = 0x4;
+
+/**
+ * @brief 内存块开头的段头
+ *
+ * middle的低两位是中间缓冲区的编号，kDirty表示生产者提交后消费者尚未取走。
+ */
+struct FrameChannel::Header
+{
+    quint32                          magic;
+    quint32                          version;
+    alignas(64) std::atomic<quint32> middle;
+    alignas(64) std::atomic<quint64> published;
+};
+
+/**
+ * @brief 每块缓冲区的帧信息，随像素一起在三块缓冲区之间轮换
+ */
+struct FrameChannel::Slot
+{
+    qint32  width;
+    qint32  height;
+    quint32 format;
+    qint32  bytesPerLine;
+    quint64 serial;   // 提交序号，0表示从未写入
+    char    title[FrameChannel::kTitleBytes];
+};
+
+static_assert(std::atomic<quint32>::is_always_lock_free && std::atomic<quint64>::is_always_lock_free,
+              "shared memory frame indices require lock-free atomics");
+
+// 段头和每块帧信息占用的字节数（按缓存行取整），像素区随后按64字节对齐
+static const int kHeaderBytes   = 192;
+static const int kSlotInfoBytes = 320;
+
+// 当前线程绑定的通道，以及未绑定线程使用的通道
+static thread_local std::shared_ptr<FrameChannel> t_channel;
+static std::shared_ptr<FrameChannel>              s_defaultChannel;
+
+int FrameChannel::totalBytes()
+{
+    return kHeaderBytes + 3 * (kSlotInfoBytes + kSlotBytes);
+}
+
+std::shared_ptr<FrameChannel> FrameChannel::createLocal()
+{
+    // calloc的大块内存按页延迟提交，从未显示图像的运行器不占用物理内存
+    void* memory = calloc(1, static_cast<size_t>(totalBytes()));
+    if (!memory) {
+        return nullptr;
+    }
+
+    std::shared_ptr<FrameChannel> channel(new FrameChannel);
+    channel->m_heap = memory;
+    channel->map(memory, true);
+    return channel;
+}
+
+std::shared_ptr<FrameChannel> FrameChannel::createShared(const QString& key)
+{
+    std::shared_ptr<FrameChannel> channel(new FrameChannel);
+    channel->m_memory.reset(new QSharedMemory(key));
+    if (!channel->m_memory->create(totalBytes())) {
+        // 上次异常退出遗留的同名段：附加后再分离即可释放
+        if (channel->m_memory->error() == QSharedMemory::AlreadyExists && channel->m_memory->attach()) {
+            channel->m_memory->detach();
+        }
+        if (!channel->m_memory->create(totalBytes())) {
+            qWarning() << "Cannot create frame channel" << key << ":" << channel->m_memory->errorString();
+            return nullptr;
+        }
+    }
+
+    memset(channel->m_memory->data(), 0, static_cast<size_t>(kHeaderBytes + 3 * kSlotInfoBytes));
+    channel->map(channel->m_memory->data(), true);
+    return channel;
+}
+
+std::shared_ptr<FrameChannel> FrameChannel::attachShared(const QString& key)
+{
+    std::shared_ptr<FrameChannel> channel(new FrameChannel);
+    channel->m_memory.reset(new QSharedMemory(key));
+    if (!channel->m_memory->attach() || channel->m_memory->size() < totalBytes()) {
+        qWarning() << "Cannot attach frame channel" << key << ":" << channel->m_memory->errorString();
+        return nullptr;
+    }
+
+    const Header* header = static_cast<const Header*>(channel->m_memory->constData());
+    if (header->magic != kFrameMagic || header->version != kFrameVersion) {
+        qWarning() << "Frame channel layout mismatch" << key;
+        return nullptr;
+    }
+
+    channel->map(channel->m_memory->data(), false);
+    return channel;
+}
+
+FrameChannel::~FrameChannel()
+{
+    free(m_heap);
+}
+
+void FrameChannel::map(void* base, bool initialize)
+{
+    static_assert(sizeof(Header) <= kHeaderBytes && sizeof(Slot) <= kSlotInfoBytes, "frame layout overflow");
+
+    char* bytes = static_cast<char*>(base);
+    m_header    = reinterpret_cast<Header*>(bytes);
+    for (int i = 0; i < 3; ++i) {
+        m_slots[i] = reinterpret_cast<Slot*>(bytes + kHeaderBytes + i * kSlotInfoBytes);
+        m_data[i]  = reinterpret_cast<uchar*>(bytes + kHeaderBytes + 3 * kSlotInfoBytes) + i * kSlotBytes;
+    }
+
+    if (initialize) {
+        new (&m_header->middle) std::atomic<quint32>(1);
+        new (&m_header->published) std::atomic<quint64>(0);
+        m_header->magic   = kFrameMagic;
+        m_header->version = kFrameVersion;
+    }
+}
+
+uchar* FrameChannel::beginFrame(int width, int height, Format format, int* bytesPerLine)
+{
+    const int channels = format == Grayscale8 ? 1 : format == Rgb888 ? 3 : 4;
+    if (width <= 0 || height <= 0 || width > kSlotBytes / channels) {
+        return nullptr;
+    }
+
+    // QImage按行引用像素，每行按4字节对齐
+    const int stride = (width * channels + 3) & ~3;
+    if (static_cast<qint64>(stride) * height > kSlotBytes) {
+        return nullptr;
+    }
+
+    m_producerMutex.lock();
+    Slot* slot         = m_slots[m_back];
+    slot->width        = width;
+    slot->height       = height;
+    slot->format       = format;
+    slot->bytesPerLine = stride;
+    *bytesPerLine      = stride;
+    return m_data[m_back];
+}
+
+void FrameChannel::commitFrame(const QByteArray& title)
+{
+    Slot*     slot = m_slots[m_back];
+    const int size = qMin(title.size(), kTitleBytes - 1);
+    memcpy(slot->title, title.constData(), static_cast<size_t>(size));
+    slot->title[size] = '\0';
+    slot->serial      = m_header->published.load(std::memory_order_relaxed) + 1;
+
+    // 写好的缓冲区换到中间，换回的缓冲区作为下一次的后台缓冲区
+    const quint32 previous = m_header->middle.exchange(m_back | kDirty, std::memory_order_acq_rel);
+    m_back                 = previous & 0x3;
+    m_header->published.fetch_add(1, std::memory_order_release);
+    m_producerMutex.unlock();
+}
+
+bool FrameChannel::acquire()
+{
+    if (!(m_header->middle.load(std::memory_order_relaxed) & kDirty)) {
+        return false;
+    }
+
+    const quint32 previous = m_header->middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front                = previous & 0x3;
+    m_hasFrame             = true;
+    return true;
+}
+
+QImage FrameChannel::image() const
+{
+    if (!m_hasFrame) {
+        return QImage();
+    }
+
+    const Slot*         slot   = m_slots[m_front];
+    const QImage::Format format = slot->format == Grayscale8 ? QImage::Format_Grayscale8
+                                  : slot->format == Rgb888   ? QImage::Format_RGB888
+                                                             : QImage::Format_RGBA8888;
+    return QImage(m_data[m_front], slot->width, slot->height, slot->bytesPerLine, format);
+}
+
+QString FrameChannel::title() const
+{
+    return m_hasFrame ? QString::fromUtf8(m_slots[m_front]->title) : QString();
+}
+
+quint64 FrameChannel::published() const
+{
+    return m_header->published.load(std::memory_order_relaxed);
+}
+
+void FrameChannel::bindCurrentThread(const std::shared_ptr<FrameChannel>& channel)
+{
+    t_channel = channel;
+    if (channel) {
+        std::atomic_store(&s_defaultChannel, channel);
+    }
+}
+
+std::shared_ptr<FrameChannel> FrameChannel::current()
+{
+    if (t_channel) {
+        return t_channel;
+    }
+    return std::atomic_load(&s_defaultChannel);
+}
+
+/**
+ * @brief cpp_module.show_image(image, title="")
+ *
+ * image是uint8的缓冲区对象：形状为(h, w)的灰度图、(h, w, 3)的RGB图或(h, w, 4)的RGBA图，
+ * 如NumPy数组和matplotlib的canvas.buffer_rgba()；也可以直接传入matplotlib的Figure，
+ * 先在Agg画布上绘制再取其RGBA缓冲区。像素按步长逐行拷贝到帧缓冲区，只拷贝一次。
+ */
+static bool showImage(py::object image, const std::string& title)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::current();
+    if (!channel) {
+        return false;
+    }
+
+    if (!PyObject_CheckBuffer(image.ptr()) && py::hasattr(image, "canvas")) {
+        py::object canvas = image.attr("canvas");
+        canvas.attr("draw")();
+        image = canvas.attr("buffer_rgba")();
+    }
+    if (!PyObject_CheckBuffer(image.ptr())) {
+        throw py::type_error("show_image() expects a uint8 buffer, an array or a matplotlib figure");
+    }
+
+    const py::buffer_info info = py::reinterpret_borrow<py::buffer>(image).request();
+    if (info.itemsize != 1 || (info.format != "B" && info.format != "=B" && info.format != "<B")) {
+        throw py::type_error("show_image() expects uint8 pixels");
+    }
+    if (info.ndim != 2 && info.ndim != 3) {
+        throw py::value_error("show_image() expects an image of shape (h, w), (h, w, 3) or (h, w, 4)");
+    }
+
+    const py::ssize_t channels = info.ndim == 2 ? 1 : info.shape[2];
+    if (channels != 1 && channels != 3 && channels != 4) {
+        throw py::value_error("show_image() expects 1, 3 or 4 channels");
+    }
+    if (info.shape[0] > INT_MAX || info.shape[1] > INT_MAX) {
+        throw py::value_error("image is too large for the frame channel");
+    }
+
+    const int                  height = static_cast<int>(info.shape[0]);
+    const int                  width  = static_cast<int>(info.shape[1]);
+    const FrameChannel::Format format = channels == 1   ? FrameChannel::Grayscale8
+                                        : channels == 3 ? FrameChannel::Rgb888
+                                                        : FrameChannel::Rgba8888;
+    const py::ssize_t pixelStride   = info.strides[1];
+    const py::ssize_t channelStride = info.ndim == 3 ? info.strides[2] : 1;
+    const bool        packedRows    = pixelStride == channels && channelStride == 1;
+
+    int    bytesPerLine = 0;
+    uchar* target       = channel->beginFrame(width, height, format, &bytesPerLine);
+    if (!target) {
+        throw py::value_error(QString("image %1x%2 exceeds the frame channel limit of %3 bytes")
+                                  .arg(width)
+                                  .arg(height)
+                                  .arg(FrameChannel::kSlotBytes)
+                                  .toStdString());
+    }
+
+    const uchar* source = static_cast<const uchar*>(info.ptr);
+    for (int y = 0; y < height; ++y) {
+        const uchar* row = source + y * info.strides[0];
+        uchar*       out = target + static_cast<ptrdiff_t>(y) * bytesPerLine;
+        if (packedRows) {
+            memcpy(out, row, static_cast<size_t>(width * channels));
+            continue;
+        }
+        for (int x = 0; x < width; ++x) {
+            const uchar* pixel = row + x * pixelStride;
+            for (py::ssize_t c = 0; c < channels; ++c) {
+                *out++ = pixel[c * channelStride];
+            }
+        }
+    }
+
+    channel->commitFrame(QByteArray::fromStdString(title));
+    return true;
+}
+
+void FrameChannel::bind(py::module_& m)
+{
+    m.def("show_image",
+          showImage,
+          py::arg("image"),
+          py::arg("title") = "",
+          "Show a uint8 image (h, w[, 3|4]) or a matplotlib figure in the image pane; returns False outside a runner");
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <QSharedMemory>
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+namespace pybind11 {
+class module_;
+}
+
+/**
+ * @class FrameChannel
+ * @brief 运行线程（或执行进程）与结果页之间的图像通道
+ *
+ * 三块固定大小的帧缓冲区组成无锁三缓冲：
+ * - 脚本把图像像素直接写入后台缓冲区，提交时与中间缓冲区交换（一次原子交换），
+ *   不等待界面，也不经过PNG编码或base64
+ * - 界面按刷新率取走中间缓冲区中最新的一帧，包装为QImage直接绘制，不复制像素；
+ *   两次取帧之间提交的多帧只显示最后一帧，脚本的帧率不受界面重绘速度限制
+ *
+ * 线程后端的缓冲区在堆上分配；进程后端由执行进程创建共享内存，主进程附加后读取。
+ * 每帧最大kSlotBytes字节（1920x1080的RGBA图像）。
+ */
+class FrameChannel
+{
+public:
+    // 每块帧缓冲区的像素字节数
+    static const int kSlotBytes = 8 * 1024 * 1024;
+
+    // 标题的最大字节数（UTF-8，含结尾的0）
+    static const int kTitleBytes = 256;
+
+    /**
+     * @brief 像素格式
+     */
+    enum Format : quint32
+    {
+        Grayscale8 = 1,   // 每像素1字节
+        Rgb888,           // 每像素3字节
+        Rgba8888          // 每像素4字节
+    };
+
+    /**
+     * @brief 在堆上分配缓冲区（线程后端）
+     * @return std::shared_ptr<FrameChannel> 通道，内存不足时为空
+     */
+    static std::shared_ptr<FrameChannel> createLocal();
+
+    /**
+     * @brief 创建共享内存（执行进程调用）
+     * @param key 共享内存标识
+     * @return std::shared_ptr<FrameChannel> 通道，失败时为空
+     */
+    static std::shared_ptr<FrameChannel> createShared(const QString& key);
+
+    /**
+     * @brief 附加执行进程创建的共享内存（主进程调用）
+     * @param key 共享内存标识
+     * @return std::shared_ptr<FrameChannel> 通道，失败时为空
+     */
+    static std::shared_ptr<FrameChannel> attachShared(const QString& key);
+
+    ~FrameChannel();
+
+    FrameChannel(const FrameChannel&) = delete;
+    FrameChannel& operator=(const FrameChannel&) = delete;
+
+    /**
+     * @brief 开始写入一帧（生产者调用，与commitFrame()成对，期间持有生产者锁）
+     * @param width 宽度
+     * @param height 高度
+     * @param format 像素格式
+     * @param bytesPerLine 输出每行字节数（按4字节对齐）
+     * @return uchar* 后台缓冲区，帧超过kSlotBytes时为空（不持有锁）
+     */
+    uchar* beginFrame(int width, int height, Format format, int* bytesPerLine);
+
+    /**
+     * @brief 提交beginFrame()写入的帧
+     * @param title 标题（UTF-8，超长时截断）
+     */
+    void commitFrame(const QByteArray& title);
+
+    /**
+     * @brief 取走最新提交的帧（界面线程调用）
+     * @return bool 有新帧时返回true
+     */
+    bool acquire();
+
+    /**
+     * @brief 最近一次acquire()取得的帧（界面线程调用，下一次acquire()前有效）
+     *
+     * QImage直接引用缓冲区内存，需要保留时调用copy()。
+     * @return QImage 图像，从未取得过帧时为空
+     */
+    QImage image() const;
+
+    /**
+     * @brief 最近一次acquire()取得的帧的标题
+     */
+    QString title() const;
+
+    /**
+     * @brief 已提交的帧数（任意线程）
+     */
+    quint64 published() const;
+
+    /**
+     * @brief 把当前线程提交的图像交给指定通道（运行线程开始运行时调用，传入空指针解除）
+     *
+     * 同时成为未绑定线程（如脚本自己创建的线程）使用的通道。
+     * @param channel 通道
+     */
+    static void bindCurrentThread(const std::shared_ptr<FrameChannel>& channel);
+
+    /**
+     * @brief 当前线程应提交到的通道
+     * @return std::shared_ptr<FrameChannel> 通道，没有运行器时为空
+     */
+    static std::shared_ptr<FrameChannel> current();
+
+    /**
+     * @brief 在cpp_module中注册show_image()（需持有GIL）
+     * @param m 模块对象
+     */
+    static void bind(pybind11::module_& m);
+
+private:
+    struct Header;
+    struct Slot;
+
+    FrameChannel() = default;
+
+    /**
+     * @brief 映射段头和缓冲区
+     * @param base 内存起始地址
+     * @param initialize 是否初始化段头
+     */
+    void map(void* base, bool initialize);
+
+    /**
+     * @brief 整个内存块的字节数
+     */
+    static int totalBytes();
+
+    std::unique_ptr<QSharedMemory> m_memory;          // 进程后端的共享内存
+    void*                          m_heap = nullptr;  // 线程后端的堆内存
+    Header*                        m_header = nullptr;
+    Slot*                          m_slots[3]{};
+    uchar*                         m_data[3]{};
+
+    QMutex  m_producerMutex;   // 多个Python线程同时提交时串行化生产者
+    quint32 m_back  = 0;       // 生产者持有的缓冲区
+    quint32 m_front = 2;       // 消费者持有的缓冲区
+    bool    m_hasFrame = false;
+};
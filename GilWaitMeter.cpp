@@ -0,0 +1,40 @@
+#include "GilWaitMeter.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <chrono>
+
+std::atomic<qint64> GilWaitMeter::s_waitNs{0};
+std::atomic<qint64> GilWaitMeter::s_waits{0};
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+GilWaitMeter::Acquire::Acquire()
+    : m_startNs(monotonicNs())
+{
+    record(monotonicNs() - m_startNs);
+}
+
+GilWaitMeter::Totals GilWaitMeter::totals()
+{
+    Totals totals;
+    totals.waitNs = s_waitNs.load(std::memory_order_relaxed);
+    totals.waits  = s_waits.load(std::memory_order_relaxed);
+    return totals;
+}
+
+void GilWaitMeter::record(qint64 waitNs)
+{
+    QCoreApplication* app = QCoreApplication::instance();
+    if (!app || QThread::currentThread() != app->thread()) {
+        return;
+    }
+    s_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    s_waits.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+/**
+ * @class GilWaitMeter
+ * @brief 统计界面线程等待GIL的时间
+ *
+ * 界面线程中获取GIL的位置（读取解释器信息、单元格依赖分析等）使用GilWaitMeter::Acquire
+ * 代替py::gil_scoped_acquire，获取前后的时间差累加到进程级的计数中；
+ * 运行器在运行开始和结束时各取一次，差值就是本次运行期间界面线程被GIL阻塞的时间。
+ * 其他线程中使用时只获取GIL，不计入统计。
+ */
+class GilWaitMeter
+{
+public:
+    /**
+     * @brief 计时的GIL获取（RAII，析构时释放）
+     */
+    class Acquire
+    {
+    public:
+        Acquire();
+
+        Acquire(const Acquire&)            = delete;
+        Acquire& operator=(const Acquire&) = delete;
+
+    private:
+        qint64                       m_startNs;   // 声明在m_acquire之前，先于获取GIL初始化
+        pybind11::gil_scoped_acquire m_acquire;
+    };
+
+    /**
+     * @brief 累计等待时间快照
+     */
+    struct Totals
+    {
+        qint64 waitNs = 0;   // 等待GIL的总时间
+        qint64 waits  = 0;   // 获取次数
+    };
+
+    /**
+     * @brief 读取累计值（线程安全）
+     * @return Totals 进程启动以来界面线程的累计等待
+     */
+    static Totals totals();
+
+    /**
+     * @brief 计入一次等待（线程安全，只统计界面线程）
+     * @param waitNs 等待时间
+     */
+    static void record(qint64 waitNs);
+
+private:
+    static std::atomic<qint64> s_waitNs;
+    static std::atomic<qint64> s_waits;
+};
@@ -0,0 +1,338 @@
+#include "HighlightEngine.h"
+
+#include <QColor>
+#include <QFont>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextLayout>
+
+#include <algorithm>
+
+// 后台线程每批分析的块数
+static const int kBatchBlocks = 2000;
+
+// 编辑后在界面线程中直接分析的块数上限，超过后交给后台线程
+static const int kSyncBlocks = 32;
+
+// 可见区域上下额外应用格式的块数
+static const int kViewportMargin = 20;
+
+namespace {
+
+// 块的分析结果，格式在块可见时才应用
+class HighlightData : public QTextBlockUserData
+{
+public:
+    QVector<PythonLexer::Token> tokens;
+    bool                        applied = false;
+};
+
+}   // namespace
+
+HighlightEngine::HighlightEngine(QPlainTextEdit* editor)
+    : QObject(editor)
+    , m_editor(editor)
+    , m_document(editor->document())
+{
+    QTextCharFormat& keywordFormat = m_formats[PythonLexer::Keyword];
+    keywordFormat.setForeground(QColor(127, 0, 85));
+    keywordFormat.setFontWeight(QFont::Bold);
+
+    QTextCharFormat& builtinFormat = m_formats[PythonLexer::Builtin];
+    builtinFormat.setForeground(QColor(0, 0, 255));
+    builtinFormat.setFontWeight(QFont::Bold);
+
+    m_formats[PythonLexer::String].setForeground(QColor(0, 128, 0));
+    m_formats[PythonLexer::Number].setForeground(QColor(255, 140, 0));
+
+    QTextCharFormat& commentFormat = m_formats[PythonLexer::Comment];
+    commentFormat.setForeground(QColor(128, 128, 128));
+    commentFormat.setFontItalic(true);
+
+    m_applyTimer.setSingleShot(true);
+    m_applyTimer.setInterval(0);
+    connect(&m_applyTimer, &QTimer::timeout, this, &HighlightEngine::applyVisible);
+    connect(m_editor, &QPlainTextEdit::updateRequest, &m_applyTimer, QOverload<>::of(&QTimer::start));
+    connect(m_document, &QTextDocument::contentsChange, this, &HighlightEngine::onContentsChange);
+
+    m_thread = std::thread(&HighlightEngine::workerLoop, this);
+
+    m_blockCount = m_document->blockCount();
+    rehighlight();
+}
+
+HighlightEngine::~HighlightEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void HighlightEngine::rehighlight()
+{
+    ++m_revision;
+    m_validUntil   = 0;
+    m_trustedUntil = 0;
+    m_editedUntil  = -1;
+    schedule();
+}
+
+void HighlightEngine::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (enabled) {
+        m_blockCount = m_document->blockCount();
+        rehighlight();
+        return;
+    }
+
+    // 作废正在后台分析的一批，清除已保存的结果和格式
+    ++m_revision;
+    m_validUntil   = 0;
+    m_trustedUntil = 0;
+    m_editedUntil  = -1;
+    bool formatted = false;
+    for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+        if (block.userData()) {
+            block.layout()->clearFormats();
+            block.setUserData(nullptr);
+            formatted = true;
+        }
+        block.setUserState(-1);
+    }
+    if (formatted) {
+        m_applying = true;
+        m_document->markContentsDirty(0, m_document->characterCount());
+        m_applying = false;
+    }
+}
+
+void HighlightEngine::onContentsChange(int position, int removed, int added)
+{
+    Q_UNUSED(removed);
+    if (m_applying || !m_enabled) {
+        return;
+    }
+
+    QTextBlock firstBlock = m_document->findBlock(position);
+    QTextBlock lastBlock  = m_document->findBlock(position + added);
+    if (!firstBlock.isValid()) {
+        firstBlock = m_document->lastBlock();
+    }
+    if (!lastBlock.isValid()) {
+        lastBlock = m_document->lastBlock();
+    }
+    const int first = firstBlock.blockNumber();
+    const int last  = qMax(first, lastBlock.blockNumber());
+    const int delta = m_document->blockCount() - m_blockCount;
+    m_blockCount    = m_document->blockCount();
+    ++m_revision;
+
+    // 编辑前的块号换算为编辑后的块号，被编辑范围内的块对应编辑的最后一块
+    auto shiftIndex = [first, last, delta](int index) {
+        if (index < first) {
+            return index;
+        }
+        if (index > last - delta) {
+            return index + delta;
+        }
+        return last;
+    };
+    auto shiftEnd = [first, &shiftIndex](int end) { return end <= first ? end : shiftIndex(end - 1) + 1; };
+
+    // 正在向下传播时编辑了已分析过的块：原来的传播前沿之后的块是用旧状态分析的，
+    // 收敛只能发生在重新分析过前沿之后
+    if (first < m_validUntil && m_validUntil < m_trustedUntil) {
+        m_editedUntil = qMax(m_editedUntil, shiftIndex(m_validUntil));
+    }
+    if (m_editedUntil >= 0) {
+        m_editedUntil = shiftIndex(m_editedUntil);
+    }
+    m_editedUntil  = qMax(m_editedUntil, last);
+    m_trustedUntil = shiftEnd(m_trustedUntil);
+    m_validUntil   = qMin(m_validUntil, first);
+
+    // 键入和小范围粘贴：直接分析，状态通常在被编辑的块处收敛
+    if (m_validUntil == first && last - first < kSyncBlocks) {
+        int        state = first > 0 ? firstBlock.previous().userState() : PythonLexer::kInitialState;
+        QTextBlock block = firstBlock;
+        for (int number = first; block.isValid() && number < first + kSyncBlocks; ++number) {
+            state = PythonLexer::lexLine(block.text(), state, &m_tokens);
+            if (storeBlock(block, number, state, m_tokens.constData(), m_tokens.size())) {
+                break;
+            }
+            block = block.next();
+        }
+        finishPass();
+        applyVisible();
+    }
+    schedule();
+}
+
+void HighlightEngine::schedule()
+{
+    if (!m_enabled || m_inFlight || m_validUntil >= m_document->blockCount()) {
+        return;
+    }
+
+    std::unique_ptr<Job> job(new Job);
+    job->revision   = m_revision;
+    job->firstBlock = m_validUntil;
+
+    QTextBlock block = m_document->findBlockByNumber(m_validUntil);
+    job->startState  = m_validUntil > 0 ? block.previous().userState() : PythonLexer::kInitialState;
+    job->lines.reserve(kBatchBlocks);
+    for (int i = 0; i < kBatchBlocks && block.isValid(); ++i) {
+        job->lines.append(block.text());
+        block = block.next();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = std::move(job);
+    }
+    m_inFlight = true;
+    m_wake.notify_one();
+}
+
+void HighlightEngine::applyResult(const Result& result)
+{
+    m_inFlight = false;
+
+    // 分析期间文档又被编辑过，从新的位置重新提交
+    if (result.revision == m_revision && result.firstBlock == m_validUntil) {
+        QTextBlock block = m_document->findBlockByNumber(result.firstBlock);
+        int        begin = 0;
+        for (int i = 0; i < result.states.size() && block.isValid(); ++i) {
+            const int end = result.tokenEnds[i];
+            if (storeBlock(block, result.firstBlock + i, result.states[i], result.tokens.constData() + begin, end - begin)) {
+                break;
+            }
+            begin = end;
+            block = block.next();
+        }
+        finishPass();
+        applyVisible();
+    }
+    schedule();
+}
+
+bool HighlightEngine::storeBlock(QTextBlock& block, int blockNumber, int state, const PythonLexer::Token* tokens, int count)
+{
+    const int previous = block.userState();
+    block.setUserState(state);
+
+    HighlightData* data = static_cast<HighlightData*>(block.userData());
+    if (!data) {
+        data = new HighlightData;
+        block.setUserData(data);
+    }
+    data->tokens.resize(count);
+    std::copy(tokens, tokens + count, data->tokens.begin());
+    data->applied = false;
+
+    m_validUntil = blockNumber + 1;
+
+    // 行尾状态没变：之后保存着有效结果的块输入不变，不必重新分析
+    if (blockNumber >= m_editedUntil && blockNumber + 1 < m_trustedUntil && state == previous) {
+        m_validUntil = m_trustedUntil;
+        return true;
+    }
+    return false;
+}
+
+void HighlightEngine::finishPass()
+{
+    if (m_validUntil > m_editedUntil) {
+        m_editedUntil = -1;
+    }
+    m_trustedUntil = qMax(m_trustedUntil, m_validUntil);
+}
+
+void HighlightEngine::applyVisible()
+{
+    if (!m_enabled) {
+        return;
+    }
+    QTextBlock block = m_editor->cursorForPosition(QPoint(0, 0)).block();
+    if (!block.isValid()) {
+        return;
+    }
+    const int last = m_editor->cursorForPosition(QPoint(0, m_editor->viewport()->height())).block().blockNumber() +
+                     kViewportMargin;
+    for (int i = 0; i < kViewportMargin && block.previous().isValid(); ++i) {
+        block = block.previous();
+    }
+
+    // 同一批中应用过格式的块合并为一个范围通知重新排版
+    int from = -1;
+    int to   = -1;
+    for (int number = block.blockNumber(); block.isValid() && number <= last; ++number, block = block.next()) {
+        HighlightData* data = static_cast<HighlightData*>(block.userData());
+        if (!data || data->applied) {
+            continue;
+        }
+
+        QVector<QTextLayout::FormatRange> ranges;
+        ranges.reserve(data->tokens.size());
+        for (const PythonLexer::Token& token : data->tokens) {
+            QTextLayout::FormatRange range;
+            range.start  = token.start;
+            range.length = token.length;
+            range.format = m_formats[token.kind];
+            ranges.append(range);
+        }
+        block.layout()->setFormats(ranges);
+        data->applied = true;
+
+        if (from < 0) {
+            from = block.position();
+        }
+        to = block.position() + block.length();
+    }
+
+    if (from >= 0) {
+        m_applying = true;
+        m_document->markContentsDirty(from, to - from);
+        m_applying = false;
+    }
+}
+
+void HighlightEngine::workerLoop()
+{
+    QVector<PythonLexer::Token> lineTokens;
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_job || m_stopping; });
+            if (m_stopping) {
+                break;
+            }
+            job = std::move(m_job);
+        }
+
+        auto result        = std::make_shared<Result>();
+        result->revision   = job->revision;
+        result->firstBlock = job->firstBlock;
+        result->states.reserve(job->lines.size());
+        result->tokenEnds.reserve(job->lines.size());
+
+        int state = job->startState;
+        for (const QString& line : job->lines) {
+            state = PythonLexer::lexLine(line, state, &lineTokens);
+            result->states.append(state);
+            result->tokens.append(lineTokens);
+            result->tokenEnds.append(result->tokens.size());
+        }
+
+        QMetaObject::invokeMethod(this, [this, result]() { applyResult(*result); }, Qt::QueuedConnection);
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "PythonLexer.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QTextCharFormat>
+#include <QTimer>
+#include <QVector>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class QPlainTextEdit;
+class QTextBlock;
+class QTextDocument;
+
+/**
+ * @class HighlightEngine
+ * @brief 编辑器的后台增量语法高亮，代替QSyntaxHighlighter
+ *
+ * 每个块的用户状态保存PythonLexer在行尾的状态，块号小于m_validUntil的块都已按当前文本分析过。
+ * 编辑后从被编辑的块重新分析：
+ * - 少量块（键入、粘贴一两行）直接在界面线程中分析，通常分析完被编辑的块状态就不变，不涉及后台线程
+ * - 状态改变（例如打开了一个三引号字符串）时，之后的块按每批kBatchBlocks个交给后台线程分析，
+ *   结果回到界面线程后保存；某个块的新状态与保存的旧状态相同时，之后原本有效的块都不必再分析
+ * - 分析期间文档又被编辑时丢弃过期的结果（按修订号判断），从新的位置继续
+ *
+ * 格式只应用到可见的块（及上下少量余量），同一批的块只通知文档重新排版一次；
+ * 其余块的分析结果保存在块的用户数据中，滚动到可见时再应用，所以分析整个大文件也不会阻塞界面。
+ */
+class HighlightEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数，立即开始分析编辑器中已有的文本
+     * @param editor 编辑器（同时作为父对象）
+     */
+    explicit HighlightEngine(QPlainTextEdit* editor);
+
+    /**
+     * @brief 析构函数（停止后台线程）
+     */
+    ~HighlightEngine() override;
+
+    /**
+     * @brief 重新分析整个文档
+     */
+    void rehighlight();
+
+    /**
+     * @brief 启用或停用高亮（大文件模式下停用）
+     * @param enabled 停用时清除已应用的格式，之后的编辑不再分析；重新启用时重新分析整个文档
+     */
+    void setEnabled(bool enabled);
+
+private:
+    // 一批待分析的块
+    struct Job
+    {
+        quint64     revision   = 0;
+        int         firstBlock = 0;
+        int         startState = PythonLexer::kInitialState;
+        QStringList lines;
+    };
+
+    // 一批的分析结果：第i行的记号为tokens[tokenEnds[i-1], tokenEnds[i])
+    struct Result
+    {
+        quint64                     revision   = 0;
+        int                         firstBlock = 0;
+        QVector<int>                states;
+        QVector<int>                tokenEnds;
+        QVector<PythonLexer::Token> tokens;
+    };
+
+    /**
+     * @brief 文档内容变化：调整有效范围，少量块直接分析，其余交给后台线程
+     */
+    void onContentsChange(int position, int removed, int added);
+
+    /**
+     * @brief 从m_validUntil开始提交下一批（已有一批在后台分析时不提交）
+     */
+    void schedule();
+
+    /**
+     * @brief 保存后台线程的一批结果（界面线程）
+     * @param result 结果
+     */
+    void applyResult(const Result& result);
+
+    /**
+     * @brief 保存一个块的分析结果
+     * @param block 块
+     * @param blockNumber 块号
+     * @param state 行尾状态
+     * @param tokens 记号
+     * @param count 记号数
+     * @return bool 状态已收敛（之后的块不必重新分析）返回true
+     */
+    bool storeBlock(QTextBlock& block, int blockNumber, int state, const PythonLexer::Token* tokens, int count);
+
+    /**
+     * @brief 一次分析结束后整理有效范围
+     */
+    void finishPass();
+
+    /**
+     * @brief 把尚未应用的分析结果应用到可见的块
+     */
+    void applyVisible();
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void workerLoop();
+
+private:
+    QPlainTextEdit* m_editor   = nullptr;
+    QTextDocument*  m_document = nullptr;
+    QTextCharFormat m_formats[PythonLexer::TokenKindCount];
+    QTimer          m_applyTimer;   // 视口变化后应用格式（不在重绘过程中修改排版）
+
+    // 以下只在界面线程中访问
+    quint64                     m_revision     = 0;       // 每次编辑加一
+    int                         m_blockCount   = 0;       // 上一次编辑后的块数
+    int                         m_validUntil   = 0;       // 之前的块都已按当前文本分析
+    int                         m_trustedUntil = 0;       // [m_validUntil, m_trustedUntil)中未编辑的块保存着旧的有效结果
+    int                         m_editedUntil  = -1;      // 待分析区域中需要重新分析的最后一块，收敛只能发生在它之后
+    bool                        m_inFlight     = false;   // 有一批正在后台分析
+    bool                        m_applying     = false;   // 正在应用格式，忽略由此产生的文档通知
+    bool                        m_enabled      = true;
+    QVector<PythonLexer::Token> m_tokens;                 // 界面线程直接分析时复用
+
+    // 后台线程，只保留最新的一批，由m_mutex保护
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    std::unique_ptr<Job>    m_job;
+    bool                    m_stopping = false;
+};
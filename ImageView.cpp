@@ -0,0 +1,109 @@
+#include "ImageView.h"
+#include "FrameChannel.h"
+
+#include <QPainter>
+#include <QTimer>
+
+// 刷新间隔（与编辑器执行行的采样间隔一致）
+static const int kPollIntervalMs = 16;
+
+ImageView::ImageView(QWidget* parent)
+    : QWidget(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(kPollIntervalMs);
+    connect(m_timer, &QTimer::timeout, this, &ImageView::poll);
+}
+
+void ImageView::setChannel(const std::shared_ptr<FrameChannel>& channel)
+{
+    if (channel != m_channel) {
+        // 每个通道保留自己最近取走的一帧，切换回来时仍可显示
+        m_channel = channel;
+        m_fps     = 0.0;
+        update();
+    }
+
+    // 重新等待本次运行的第一帧
+    m_framesInWindow = 0;
+    m_rateClock.start();
+    m_waitingFirst = true;
+
+    if (m_channel) {
+        m_timer->start();
+    }
+    else {
+        m_timer->stop();
+    }
+}
+
+QSize ImageView::sizeHint() const
+{
+    return QSize(640, 480);
+}
+
+void ImageView::poll()
+{
+    // 一秒窗口结束时更新帧率；没有新帧时帧率降为0
+    if (m_rateClock.elapsed() >= 1000) {
+        const double fps = m_framesInWindow * 1000.0 / m_rateClock.restart();
+        m_framesInWindow = 0;
+        if (fps != m_fps) {
+            m_fps = fps;
+            update();
+        }
+    }
+
+    if (!m_channel || !m_channel->acquire()) {
+        return;
+    }
+
+    ++m_framesInWindow;
+    update();
+
+    if (m_waitingFirst) {
+        m_waitingFirst = false;
+        emit firstFrameShown();
+    }
+}
+
+void ImageView::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    const QImage image = m_channel ? m_channel->image() : QImage();
+    if (image.isNull()) {
+        painter.setPen(palette().color(QPalette::Disabled, QPalette::Text));
+        painter.drawText(rect(), Qt::AlignCenter, "在代码中调用cpp_module.show_image(image)后在这里显示图像");
+        return;
+    }
+
+    // 底部一行显示标题和帧数，其余区域按宽高比缩放显示图像
+    const QFontMetrics metrics = fontMetrics();
+    const int          footer  = metrics.height() + 4;
+    const QRect        area    = rect().adjusted(0, 0, 0, -footer);
+
+    QSize size = image.size();
+    size.scale(area.size(), Qt::KeepAspectRatio);
+    const QRect target(area.x() + (area.width() - size.width()) / 2,
+                       area.y() + (area.height() - size.height()) / 2,
+                       size.width(),
+                       size.height());
+
+    // 放大时保持像素清晰，缩小时平滑
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, size.width() < image.width());
+    painter.drawImage(target, image);
+
+    const QString title = m_channel->title();
+    const QString status = QString("%1%2x%3，已提交 %4 帧，显示 %5 fps")
+                               .arg(title.isEmpty() ? QString() : title + "  ")
+                               .arg(image.width())
+                               .arg(image.height())
+                               .arg(m_channel->published())
+                               .arg(m_fps, 0, 'f', 0);
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(rect().adjusted(4, rect().height() - footer, -4, 0),
+                     Qt::AlignVCenter | Qt::AlignLeft,
+                     metrics.elidedText(status, Qt::ElideMiddle, width() - 8));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <memory>
+
+class FrameChannel;
+class QTimer;
+
+/**
+ * @class ImageView
+ * @brief 显示脚本通过cpp_module.show_image()提交的图像
+ *
+ * 按显示刷新率从图像通道取走最新一帧，保持宽高比缩放绘制，像素不复制。
+ * 底部显示标题、脚本提交的帧数和实际显示的帧率；脚本提交得比刷新率快时中间的帧被跳过。
+ */
+class ImageView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit ImageView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 切换要显示的图像通道（标签页切换或开始运行时调用）
+     * @param channel 通道，为空时停止刷新
+     */
+    void setChannel(const std::shared_ptr<FrameChannel>& channel);
+
+    QSize sizeHint() const override;
+
+signals:
+    /**
+     * @brief setChannel()之后显示了第一帧
+     */
+    void firstFrameShown();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    /**
+     * @brief 取走新帧并重绘（刷新定时器调用）
+     */
+    void poll();
+
+    std::shared_ptr<FrameChannel> m_channel;
+    QTimer*                       m_timer        = nullptr;
+    bool                          m_waitingFirst = false;
+
+    // 显示帧率，按一秒窗口统计
+    QElapsedTimer m_rateClock;
+    int           m_framesInWindow = 0;
+    double        m_fps            = 0.0;
+};
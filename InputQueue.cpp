@@ -0,0 +1,123 @@
+#include "InputQueue.h"
+
+// 已读部分超过这个大小且占缓冲区一半以上时移除
+static const int kCompactBytes = 64 * 1024;
+
+void InputQueue::write(const QByteArray& data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_buffer.append(data);
+    m_condition.wakeAll();
+}
+
+void InputQueue::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_closed = true;
+    m_condition.wakeAll();
+}
+
+void InputQueue::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_buffer.clear();
+    m_readPos = 0;
+    m_closed  = false;
+    ++m_generation;
+    m_condition.wakeAll();
+}
+
+void InputQueue::interrupt()
+{
+    QMutexLocker locker(&m_mutex);
+    m_interrupted = true;
+    m_condition.wakeAll();
+}
+
+InputQueue::Status InputQueue::read(QByteArray* data, qint64 size, bool line, bool wait)
+{
+    data->clear();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_interrupted) {
+        return Interrupted;
+    }
+    if (take(data, size, line)) {
+        return Ready;
+    }
+    if (!wait) {
+        return Empty;
+    }
+
+    // clear()之后结束等待，得到空数据
+    const quint64 generation = m_generation;
+    if (m_waitHandler) {
+        m_waitHandler(true);
+    }
+    while (!m_interrupted && generation == m_generation && !take(data, size, line)) {
+        m_condition.wait(&m_mutex);
+    }
+    if (m_waitHandler) {
+        m_waitHandler(false);
+    }
+
+    return m_interrupted && data->isEmpty() ? Interrupted : Ready;
+}
+
+bool InputQueue::take(QByteArray* data, qint64 size, bool line)
+{
+    const int available = m_buffer.size() - m_readPos;
+
+    int count = -1;
+    if (size == 0) {
+        count = 0;
+    }
+    else if (line) {
+        const qint64 limit   = size > 0 ? qMin<qint64>(size, available) : available;
+        const int    newline = m_buffer.indexOf('\n', m_readPos);
+        if (newline >= 0 && newline - m_readPos < limit) {
+            count = newline - m_readPos + 1;
+        }
+        else if (size > 0 && available >= size) {
+            count = static_cast<int>(size);
+        }
+    }
+    else if (size > 0 && available >= size) {
+        count = static_cast<int>(size);
+    }
+
+    if (count < 0) {
+        if (!m_closed) {
+            return false;
+        }
+        count = available;
+    }
+
+    // 截断处落在多字节字符中间时退到该字符之前
+    if (count > 0 && count < available) {
+        int end = m_readPos + count;
+        while (end > m_readPos && (static_cast<uchar>(m_buffer[end]) & 0xC0) == 0x80) {
+            --end;
+        }
+        if (end > m_readPos) {
+            count = end - m_readPos;
+        }
+    }
+
+    *data = m_buffer.mid(m_readPos, count);
+    m_readPos += count;
+
+    if (m_readPos == m_buffer.size()) {
+        m_buffer.clear();
+        m_readPos = 0;
+    }
+    else if (m_readPos > kCompactBytes && m_readPos > m_buffer.size() / 2) {
+        m_buffer.remove(0, m_readPos);
+        m_readPos = 0;
+    }
+    return true;
+}
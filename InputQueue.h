@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtGlobal>
+
+#include <atomic>
+#include <functional>
+
+/**
+ * @class InputQueue
+ * @brief 运行中代码的标准输入
+ *
+ * sys.stdin的原生实现从这里读取。界面输入行提交的内容和批量运行预先写入的数据都追加到队列，
+ * 数据按UTF-8字节保存。已经到达的数据直接取走，读取方不释放GIL、不等待，
+ * 预先写入的大量输入可以全速读完；没有完整的一行时读取方释放GIL，在条件变量上等待。
+ * 每个运行器一个，中止运行时调用interrupt()唤醒等待。
+ */
+class InputQueue
+{
+public:
+    /**
+     * @brief 读取结果
+     */
+    enum Status
+    {
+        Ready,         // 已取得数据；数据为空表示输入已结束
+        Empty,         // 不等待时没有可读的数据
+        Interrupted    // 被interrupt()打断
+    };
+
+    /**
+     * @brief 追加输入数据（可在任意线程调用）
+     * @param data UTF-8数据，可以包含多行
+     */
+    void write(const QByteArray& data);
+
+    /**
+     * @brief 结束输入（可在任意线程调用），读完已写入的数据后读取得到空数据（EOF）
+     */
+    void close();
+
+    /**
+     * @brief 丢弃未读的数据并清除结束标志（运行结束时调用），正在等待的读取得到空数据
+     */
+    void clear();
+
+    /**
+     * @brief 设置中断标志并唤醒等待（可在任意线程调用）
+     */
+    void interrupt();
+
+    /**
+     * @brief 清除中断标志（每次运行开始时调用）
+     */
+    void reset() { m_interrupted = false; }
+
+    /**
+     * @brief 设置开始和结束等待时的通知（在第一次读取前设置）
+     *
+     * 在读取线程中调用，参数为true表示开始等待输入，不持有GIL，不能再访问本队列。
+     * @param handler 通知函数
+     */
+    void setWaitHandler(std::function<void(bool)> handler) { m_waitHandler = std::move(handler); }
+
+    /**
+     * @brief 读取数据（等待时调用前需释放GIL）
+     *
+     * 按行读取时取到换行符为止（含换行符）；按大小读取时取满size字节，size为负数时读到输入结束。
+     * 输入已结束时取走剩余的全部数据。不会把一个多字节字符拆到两次读取中。
+     * @param data 输出的数据
+     * @param size 最多读取的字节数，负数表示不限
+     * @param line 是否按行读取
+     * @param wait 没有足够的数据时是否等待
+     * @return Status 读取结果
+     */
+    Status read(QByteArray* data, qint64 size, bool line, bool wait);
+
+private:
+    /**
+     * @brief 数据足够时取走（调用方持有m_mutex）
+     * @return bool 取得数据或输入已结束返回true
+     */
+    bool take(QByteArray* data, qint64 size, bool line);
+
+    QMutex                    m_mutex;
+    QWaitCondition            m_condition;
+    QByteArray                m_buffer;
+    int                       m_readPos    = 0;       // m_buffer中已读的字节数
+    bool                      m_closed     = false;
+    quint64                   m_generation = 0;       // 每次clear()加一，等待中的读取据此结束
+    std::atomic<bool>         m_interrupted{false};
+    std::function<void(bool)> m_waitHandler;
+};
@@ -0,0 +1,490 @@
+#include "InterpreterPool.h"
+#include "PythonHandles.h"
+#include "PythonInterpreterManager.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QThread>
+
+#ifdef PYBIND11_HAS_SUBINTERPRETER_SUPPORT
+#include <pybind11/subinterpreter.h>
+#endif
+
+#include <chrono>
+
+// 单调时钟（纳秒），用于排队和运行时间统计
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief 工作线程信息
+ */
+struct InterpreterPool::WorkerSlot
+{
+    int      index  = 0;
+    QThread* thread = nullptr;
+
+    // 保护currentJob和threadId。控制线程持有该锁时会等待工作线程所用解释器的GIL，
+    // 因此工作线程只能在释放GIL后获取它
+    QMutex               mutex;
+    std::shared_ptr<Job> currentJob;
+    unsigned long        threadId = 0;   // 工作线程标识，用于PyThreadState_SetAsyncExc
+
+    std::atomic<qint64> busyNs{0};
+
+#ifdef PYBIND11_HAS_SUBINTERPRETER_SUPPORT
+    py::subinterpreter interpreter;   // 只在工作线程中创建和销毁
+#endif
+};
+
+InterpreterPool::InterpreterPool(QObject* parent)
+    : QObject(parent)
+{
+    // 中止操作串行执行
+    m_controlPool.setMaxThreadCount(1);
+}
+
+InterpreterPool::~InterpreterPool()
+{
+    shutdown();
+}
+
+bool InterpreterPool::hasPerInterpreterGil()
+{
+#ifdef PYBIND11_HAS_SUBINTERPRETER_SUPPORT
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool InterpreterPool::start(int workerCount)
+{
+    if (!m_workers.empty()) {
+        return m_readyWorkers > 0;
+    }
+
+    if (!PythonInterpreterManager::instance().isInitialized()) {
+        qWarning() << "Cannot start interpreter pool - Python not initialized";
+        return false;
+    }
+
+    if (workerCount <= 0) {
+        // 共享GIL时多个工作线程无法并行计算，默认只用一个
+        workerCount = hasPerInterpreterGil() ? qMax(1, QThread::idealThreadCount()) : 1;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping       = false;
+        m_readyWorkers   = 0;
+        m_startedWorkers = 0;
+    }
+
+    for (int i = 0; i < workerCount; ++i) {
+        std::unique_ptr<WorkerSlot> slot(new WorkerSlot);
+        slot->index  = i;
+        slot->thread = QThread::create([this, raw = slot.get()]() { workerLoop(raw); });
+        slot->thread->setObjectName(QString("InterpreterPool-%1").arg(i));
+        m_workers.push_back(std::move(slot));
+    }
+
+    for (const std::unique_ptr<WorkerSlot>& slot : m_workers) {
+        slot->thread->start();
+    }
+
+    // 等待所有子解释器创建完成
+    QMutexLocker locker(&m_mutex);
+    while (m_startedWorkers < workerCount) {
+        m_doneCondition.wait(&m_mutex);
+    }
+
+    // 利用率从工作线程就绪时开始统计，不含子解释器的创建时间
+    m_startNs = monotonicNs();
+
+    qDebug() << "Interpreter pool started:" << m_readyWorkers << "workers,"
+             << (hasPerInterpreterGil() ? "per-interpreter GIL" : "shared GIL");
+
+    return m_readyWorkers > 0;
+}
+
+void InterpreterPool::shutdown()
+{
+    if (m_workers.empty()) {
+        return;
+    }
+
+    abortAll();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_queueCondition.wakeAll();
+    }
+
+    for (const std::unique_ptr<WorkerSlot>& slot : m_workers) {
+        slot->thread->wait();
+        delete slot->thread;
+    }
+
+    m_controlPool.waitForDone();
+    m_workers.clear();
+
+    QMutexLocker locker(&m_mutex);
+    m_readyWorkers = 0;
+}
+
+std::shared_ptr<InterpreterPool::Job> InterpreterPool::submit(const QString& code)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_readyWorkers == 0 || m_stopping) {
+        qWarning() << "Interpreter pool is not running";
+        return nullptr;
+    }
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->id          = m_nextJobId++;
+    job->code        = code;
+    job->submittedNs = monotonicNs();
+
+    m_queue.push_back(job);
+    m_activeJobs.insert(job->id, job);
+    m_queueCondition.wakeOne();
+
+    return job;
+}
+
+void InterpreterPool::abort(int jobId)
+{
+    std::shared_ptr<Job> job;
+    {
+        QMutexLocker locker(&m_mutex);
+        job = m_activeJobs.value(jobId);
+    }
+
+    if (!job || job->abortRequested.exchange(true)) {
+        return;
+    }
+
+    // 唤醒可中断的time.sleep；排队中的任务在取出时直接结束
+    job->interruptGate.interrupt();
+
+    if (job->state == Running) {
+        m_controlPool.start([this, job]() { raiseAbortException(job); });
+    }
+}
+
+void InterpreterPool::abortAll()
+{
+    QList<int> ids;
+    {
+        QMutexLocker locker(&m_mutex);
+        ids = m_activeJobs.keys();
+    }
+
+    for (int id : ids) {
+        abort(id);
+    }
+}
+
+bool InterpreterPool::waitForDone(int msecs)
+{
+    QDeadlineTimer deadline(msecs < 0 ? QDeadlineTimer::Forever : msecs);
+    QMutexLocker   locker(&m_mutex);
+
+    while (!m_activeJobs.isEmpty()) {
+        if (!m_doneCondition.wait(&m_mutex, deadline)) {
+            return m_activeJobs.isEmpty();
+        }
+    }
+
+    return true;
+}
+
+InterpreterPool::Metrics InterpreterPool::metrics() const
+{
+    Metrics result;
+    result.perInterpreterGil = hasPerInterpreterGil();
+
+    QMutexLocker locker(&m_mutex);
+    result.workers          = m_readyWorkers;
+    result.queued           = static_cast<int>(m_queue.size());
+    result.running          = m_activeJobs.size() - result.queued;
+    result.completed        = m_completed;
+    result.totalQueueWaitNs = m_totalQueueWaitNs;
+    result.maxQueueWaitNs   = m_maxQueueWaitNs;
+    result.totalRunNs       = m_totalRunNs;
+    result.wallNs           = m_startNs > 0 ? monotonicNs() - m_startNs : 0;
+
+    qint64 busyNs = 0;
+    for (const std::unique_ptr<WorkerSlot>& slot : m_workers) {
+        qint64 workerBusyNs = slot->busyNs.load(std::memory_order_relaxed);
+
+        // 正在运行的任务计入到当前时刻
+        QMutexLocker slotLocker(&slot->mutex);
+        if (slot->currentJob) {
+            workerBusyNs += monotonicNs() - slot->currentJob->startedNs;
+        }
+
+        result.workerBusyNs.append(workerBusyNs);
+        busyNs += workerBusyNs;
+    }
+
+    if (result.workers > 0 && result.wallNs > 0) {
+        result.utilisation = double(busyNs) / (double(result.workers) * double(result.wallNs));
+    }
+
+    return result;
+}
+
+void InterpreterPool::workerLoop(WorkerSlot* slot)
+{
+    PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+
+#ifdef PYBIND11_HAS_SUBINTERPRETER_SUPPORT
+    bool created = false;
+    try {
+        // 隔离的子解释器，拥有独立GIL；嵌入式模块均声明了per_interpreter_gil
+        slot->interpreter = py::subinterpreter::create();
+        created           = true;
+    }
+    catch (const std::exception& e) {
+        qCritical() << "Failed to create sub-interpreter:" << e.what();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_startedWorkers;
+        if (created) {
+            ++m_readyWorkers;
+        }
+        m_doneCondition.wakeAll();
+    }
+
+    if (!created) {
+        return;
+    }
+
+    {
+        py::subinterpreter_scoped_activate activate(slot->interpreter);
+        PythonInterpreterManager::prepareInterpreter();
+
+        // 代码对象属于创建它的解释器，每个子解释器使用自己的内存缓存，磁盘字节码共享
+        CodeCache cache;
+        cache.setDiskDirectory(pyManager.codeCache().diskDirectory());
+
+        serveJobs(slot, cache);
+        cache.clear();
+    }
+
+    // 子解释器必须在创建它的线程中销毁
+    slot->interpreter = py::subinterpreter();
+#else
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_startedWorkers;
+        ++m_readyWorkers;
+        m_doneCondition.wakeAll();
+    }
+
+    // 没有独立GIL：在主解释器中运行，与主运行器共用编译缓存
+    py::gil_scoped_acquire acquire;
+    serveJobs(slot, pyManager.codeCache());
+#endif
+}
+
+void InterpreterPool::serveJobs(WorkerSlot* slot, CodeCache& cache)
+{
+    // 在处理任何任务之前写入，控制线程只在看到currentJob之后读取
+    slot->threadId = PyThread_get_thread_ident();
+
+    std::shared_ptr<Job> job;
+    JobState             state = Finished;
+
+    for (;;) {
+        {
+            // 记录结果和等待新任务期间不持有GIL
+            py::gil_scoped_release release;
+            if (job) {
+                finishJob(slot, job, state);
+            }
+            job = takeJob(slot);
+        }
+
+        // 上一个任务结束后才送达的中止异常不能影响下一个任务
+        PyThreadState_SetAsyncExc(slot->threadId, nullptr);
+
+        if (!job) {
+            break;
+        }
+
+        state = runJob(job.get(), cache);
+    }
+}
+
+std::shared_ptr<InterpreterPool::Job> InterpreterPool::takeJob(WorkerSlot* slot)
+{
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.empty() && !m_stopping) {
+                m_queueCondition.wait(&m_mutex);
+            }
+            if (m_queue.empty()) {
+                return nullptr;
+            }
+
+            job = m_queue.front();
+            m_queue.pop_front();
+
+            job->worker    = slot->index;
+            job->startedNs = monotonicNs();
+
+            const qint64 waitNs = job->startedNs - job->submittedNs;
+            m_totalQueueWaitNs += waitNs;
+            m_maxQueueWaitNs = qMax(m_maxQueueWaitNs, waitNs);
+        }
+
+        // 排队期间已被中止的任务不再运行
+        if (job->abortRequested) {
+            finishJob(slot, job, Aborted);
+            continue;
+        }
+
+        {
+            QMutexLocker locker(&slot->mutex);
+            slot->currentJob = job;
+            job->state       = Running;
+        }
+
+        // 设置Running之后再复查，与abort()并发时不会漏掉中止请求
+        if (job->abortRequested) {
+            m_controlPool.start([this, job]() { raiseAbortException(job); });
+        }
+
+        emit jobStarted(job->id);
+        return job;
+    }
+}
+
+InterpreterPool::JobState InterpreterPool::runJob(Job* job, CodeCache& cache)
+{
+    PythonInterpreterManager::OutputCallback output = [this, job](int stream, const char* data,
+                                                                  int size) {
+        writeJobOutput(job, stream, data, size);
+    };
+    PythonInterpreterManager::bindCurrentThread(&output, &job->interruptGate);
+
+    JobState state = Finished;
+
+    try {
+        // 每个任务使用全新的全局命名空间
+        const PythonHandles& handles = PythonHandles::current();
+        py::dict             globals;
+        if (PyDict_SetItem(globals.ptr(), handles.names.builtins, handles.builtins) < 0 ||
+            PyDict_SetItem(globals.ptr(), handles.names.name, handles.names.main) < 0) {
+            throw py::error_already_set();
+        }
+
+        py::object compiled =
+            cache.compile(job->code.toUtf8(), PythonInterpreterManager::editorFileName());
+
+        py::object result = py::reinterpret_steal<py::object>(
+            PyEval_EvalCode(compiled.ptr(), globals.ptr(), globals.ptr()));
+        if (!result) {
+            throw py::error_already_set();
+        }
+    }
+    catch (const py::error_already_set& e) {
+        if (job->abortRequested) {
+            state = Aborted;
+        }
+        else {
+            state      = Failed;
+            job->error = QString::fromUtf8(e.what());
+        }
+    }
+    catch (const std::exception& e) {
+        state      = job->abortRequested ? Aborted : Failed;
+        job->error = QString::fromUtf8(e.what());
+    }
+
+    PyErr_Clear();
+    PythonInterpreterManager::bindCurrentThread(nullptr, nullptr);
+    return state;
+}
+
+void InterpreterPool::finishJob(WorkerSlot* slot, const std::shared_ptr<Job>& job, JobState state)
+{
+    job->finishedNs = monotonicNs();
+
+    {
+        // 清除当前任务后中止请求不会再投递到本线程
+        QMutexLocker locker(&slot->mutex);
+        if (slot->currentJob == job) {
+            slot->currentJob = nullptr;
+            slot->busyNs.fetch_add(job->finishedNs - job->startedNs, std::memory_order_relaxed);
+        }
+        job->state = state;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_completed;
+        m_totalRunNs += job->finishedNs - job->startedNs;
+        m_activeJobs.remove(job->id);
+        m_doneCondition.wakeAll();
+    }
+
+    emit jobFinished(job->id, state);
+}
+
+void InterpreterPool::writeJobOutput(Job* job, int stream, const char* data, int size)
+{
+    while (size > 0 && !job->abortRequested) {
+        bool wake    = false;
+        int  written = job->output.tryWrite(
+            static_cast<OutputChannel::Stream>(stream), data, size, &wake);
+
+        if (wake) {
+            emit jobOutputReady(job->id);
+        }
+
+        data += written;
+        size -= written;
+
+        // 读取方跟不上时等待其取走数据，等待期间释放GIL
+        if (size > 0) {
+            py::gil_scoped_release release;
+            job->output.waitForSpace(50);
+        }
+    }
+}
+
+void InterpreterPool::raiseAbortException(const std::shared_ptr<Job>& job)
+{
+    if (job->worker < 0 || job->worker >= static_cast<int>(m_workers.size())) {
+        return;
+    }
+
+    WorkerSlot*  slot = m_workers[job->worker].get();
+    QMutexLocker locker(&slot->mutex);
+
+    // 任务已结束（或尚未开始）时不投递，避免打断同一线程上的下一个任务
+    if (slot->currentJob != job) {
+        return;
+    }
+
+    // PyThreadState_SetAsyncExc只查找当前解释器中的线程，必须先切换到任务所在的解释器
+#ifdef PYBIND11_HAS_SUBINTERPRETER_SUPPORT
+    py::subinterpreter_scoped_activate activate(slot->interpreter);
+#else
+    py::gil_scoped_acquire acquire;
+#endif
+    PyThreadState_SetAsyncExc(slot->threadId, PyExc_KeyboardInterrupt);
+}
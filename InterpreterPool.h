@@ -0,0 +1,254 @@
+#pragma once
+
+#include "InterruptGate.h"
+#include "OutputChannel.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class CodeCache;
+
+/**
+ * @class InterpreterPool
+ * @brief 子解释器池，多段脚本并行运行
+ *
+ * 每个工作线程拥有一个子解释器：
+ * - Python 3.12及以上使用独立GIL的隔离子解释器，不同任务真正并行运行在不同核心上
+ * - 更早的版本没有独立GIL，工作线程在主解释器中运行任务，轮流持有同一个GIL，
+ *   适合以等待为主的脚本
+ *
+ * 每个任务有独立的全局命名空间、输出通道、中止标志和可中断等待，
+ * 与主运行器（CodeRunner）以及其他任务互不影响。
+ * 池任务以自由运行模式执行，不挂载追踪钩子，断点和单步仍由CodeRunner提供。
+ *
+ * 池必须在PythonInterpreterManager::cleanup()之前关闭。
+ */
+class InterpreterPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 任务状态
+     */
+    enum JobState
+    {
+        Queued,     // 等待调度
+        Running,    // 正在运行
+        Finished,   // 正常结束
+        Failed,     // 抛出了异常
+        Aborted     // 被中止
+    };
+    Q_ENUM(JobState)
+
+    /**
+     * @brief 一个运行任务
+     *
+     * 提交后由工作线程写入状态和计时字段；error只在任务结束后读取。
+     */
+    struct Job
+    {
+        int                   id = 0;
+        QString               code;
+        OutputChannel         output;          // 任务自己的输出通道
+        InterruptGate         interruptGate;   // 任务自己的可中断等待
+        std::atomic<JobState> state{Queued};
+        std::atomic<bool>     abortRequested{false};
+        QString               error;           // 失败时的错误信息
+        int                   worker      = -1;
+        qint64                submittedNs = 0;   // 提交时刻（单调时钟）
+        qint64                startedNs   = 0;   // 开始运行时刻
+        qint64                finishedNs  = 0;   // 结束时刻
+    };
+
+    /**
+     * @brief 调度和利用率统计
+     */
+    struct Metrics
+    {
+        int             workers           = 0;
+        bool            perInterpreterGil = false;   // 任务是否真正并行
+        int             queued            = 0;       // 等待调度的任务数
+        int             running           = 0;       // 正在运行的任务数
+        quint64         completed         = 0;       // 已结束的任务数（含失败和中止）
+        qint64          totalQueueWaitNs  = 0;       // 所有已开始任务的排队时间之和
+        qint64          maxQueueWaitNs    = 0;       // 最长排队时间
+        qint64          totalRunNs        = 0;       // 所有已结束任务的运行时间之和
+        qint64          wallNs            = 0;       // 自start()以来的墙钟时间
+        QVector<qint64> workerBusyNs;                // 每个工作线程的忙碌时间
+        double          utilisation = 0.0;           // 忙碌时间之和 / (工作线程数 × 墙钟时间)
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit InterpreterPool(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（中止所有任务并关闭池）
+     */
+    ~InterpreterPool();
+
+    /**
+     * @brief 当前构建是否支持独立GIL的子解释器
+     * @return bool Python 3.12及以上返回true
+     */
+    static bool hasPerInterpreterGil();
+
+    /**
+     * @brief 启动工作线程并创建子解释器（阻塞到全部创建完成）
+     * @param workerCount 工作线程数，0表示支持独立GIL时使用CPU核心数，否则为1
+     * @return bool 至少一个工作线程可用时返回true
+     */
+    bool start(int workerCount = 0);
+
+    /**
+     * @brief 中止所有任务，等待工作线程退出并销毁子解释器
+     */
+    void shutdown();
+
+    /**
+     * @brief 可用的工作线程数
+     * @return int 工作线程数，未启动时为0
+     */
+    int workerCount() const { return m_readyWorkers; }
+
+    /**
+     * @brief 提交一段代码（线程安全）
+     * @param code Python代码
+     * @return std::shared_ptr<Job> 任务，池未启动时为空
+     */
+    std::shared_ptr<Job> submit(const QString& code);
+
+    /**
+     * @brief 中止任务（线程安全，不阻塞）
+     *
+     * 排队中的任务不再运行；运行中的任务收到KeyboardInterrupt，可中断的time.sleep立即返回。
+     * @param jobId 任务编号
+     */
+    void abort(int jobId);
+
+    /**
+     * @brief 中止所有排队和运行中的任务
+     */
+    void abortAll();
+
+    /**
+     * @brief 等待所有已提交的任务结束
+     * @param msecs 最长等待毫秒数，-1表示一直等待
+     * @return bool 全部结束返回true，超时返回false
+     */
+    bool waitForDone(int msecs = -1);
+
+    /**
+     * @brief 获取调度和利用率统计（线程安全）
+     * @return Metrics 统计快照
+     */
+    Metrics metrics() const;
+
+signals:
+    /**
+     * @brief 任务开始运行信号（在工作线程中发出）
+     * @param jobId 任务编号
+     */
+    void jobStarted(int jobId);
+
+    /**
+     * @brief 任务输出通道中有新数据的信号（每次取走数据后只发出一次）
+     * @param jobId 任务编号
+     */
+    void jobOutputReady(int jobId);
+
+    /**
+     * @brief 任务结束信号
+     * @param jobId 任务编号
+     * @param state 最终状态（JobState）
+     */
+    void jobFinished(int jobId, int state);
+
+private:
+    struct WorkerSlot;
+
+    /**
+     * @brief 工作线程主函数：创建子解释器并循环处理任务
+     * @param slot 工作线程信息
+     */
+    void workerLoop(WorkerSlot* slot);
+
+    /**
+     * @brief 循环取出并运行任务，直到池关闭（进入时持有所用解释器的GIL）
+     * @param slot 工作线程信息
+     * @param cache 该解释器使用的编译代码缓存
+     */
+    void serveJobs(WorkerSlot* slot, CodeCache& cache);
+
+    /**
+     * @brief 等待下一个任务（调用前需释放GIL）
+     * @param slot 工作线程信息
+     * @return std::shared_ptr<Job> 任务，池关闭时为空
+     */
+    std::shared_ptr<Job> takeJob(WorkerSlot* slot);
+
+    /**
+     * @brief 在当前解释器中运行任务（需持有GIL）
+     * @param job 任务
+     * @param cache 编译代码缓存
+     * @return JobState 最终状态
+     */
+    JobState runJob(Job* job, CodeCache& cache);
+
+    /**
+     * @brief 记录任务结束并发出信号（调用前需释放GIL）
+     * @param slot 工作线程信息
+     * @param job 任务
+     * @param state 最终状态
+     */
+    void finishJob(WorkerSlot* slot, const std::shared_ptr<Job>& job, JobState state);
+
+    /**
+     * @brief 把任务输出写入其输出通道（在工作线程中调用，需持有GIL）
+     * @param job 任务
+     * @param stream 输出流（0为标准输出，1为标准错误）
+     * @param data UTF-8数据
+     * @param size 字节数
+     */
+    void writeJobOutput(Job* job, int stream, const char* data, int size);
+
+    /**
+     * @brief 在任务所在的解释器中抛出中止异常（在控制线程池中运行）
+     * @param job 任务
+     */
+    void raiseAbortException(const std::shared_ptr<Job>& job);
+
+private:
+    mutable QMutex                           m_mutex;            // 保护队列、任务表和统计
+    QWaitCondition                           m_queueCondition;   // 有新任务或池关闭
+    QWaitCondition                           m_doneCondition;    // 任务结束或工作线程就绪
+    std::deque<std::shared_ptr<Job>>         m_queue;
+    QHash<int, std::shared_ptr<Job>>         m_activeJobs;       // 排队和运行中的任务
+    std::vector<std::unique_ptr<WorkerSlot>> m_workers;
+    int                                      m_nextJobId      = 1;
+    int                                      m_readyWorkers   = 0;
+    int                                      m_startedWorkers = 0;   // 已完成初始化（无论成败）的工作线程数
+    bool                                     m_stopping       = false;
+
+    // 统计
+    qint64  m_startNs          = 0;
+    quint64 m_completed        = 0;
+    qint64  m_totalQueueWaitNs = 0;
+    qint64  m_maxQueueWaitNs   = 0;
+    qint64  m_totalRunNs       = 0;
+
+    QThreadPool m_controlPool;   // 执行需要GIL的中止操作，避免阻塞调用线程
+};
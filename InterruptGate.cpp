@@ -0,0 +1,19 @@
+#include "InterruptGate.h"
+
+void InterruptGate::interrupt()
+{
+    QMutexLocker locker(&m_mutex);
+    m_interrupted = true;
+    m_condition.wakeAll();
+}
+
+bool InterruptGate::wait(QDeadlineTimer deadline)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_interrupted && !deadline.hasExpired()) {
+        m_condition.wait(&m_mutex, deadline);
+    }
+
+    return m_interrupted;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QDeadlineTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+ * @class InterruptGate
+ * @brief 可被其他线程打断的等待
+ *
+ * 可中断的time.sleep在这里等待，中止运行时调用interrupt()立即唤醒。
+ * 每个执行上下文（主运行器、子解释器任务）各有一个，互不影响。
+ */
+class InterruptGate
+{
+public:
+    /**
+     * @brief 设置中断标志并唤醒所有等待（可在任意线程调用）
+     */
+    void interrupt();
+
+    /**
+     * @brief 清除中断标志（每次运行开始时调用）
+     */
+    void reset() { m_interrupted = false; }
+
+    /**
+     * @brief 是否已被中断
+     * @return bool 已中断返回true
+     */
+    bool isInterrupted() const { return m_interrupted; }
+
+    /**
+     * @brief 等待到截止时间或直到被中断（调用前需释放GIL）
+     * @param deadline 截止时间，不足一毫秒的等待也按纳秒计时
+     * @return bool 被interrupt()打断时返回true
+     */
+    bool wait(QDeadlineTimer deadline);
+
+private:
+    QMutex            m_mutex;
+    QWaitCondition    m_condition;
+    std::atomic<bool> m_interrupted{false};
+};
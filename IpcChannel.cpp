@@ -0,0 +1,268 @@
+#include "IpcChannel.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QThread>
+
+#include <cstring>
+#include <new>
+
+// 共享内存布局版本，两端不一致时拒绝附加
+static const quint32 kSegmentMagic   = 0x51504943;   // "QPIC"
+static const quint32 kSegmentVersion = 1;
+
+// 段头（64字节），随后是两个环形缓冲区的读写位置，再后面是两块数据区
+struct SegmentHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 capacity;
+    char    padding[52];
+};
+
+/**
+ * @brief 环形缓冲区的读写位置（位于共享内存中）
+ *
+ * 位置单调递增，取模后得到数据区偏移；读写位置分处不同的缓存行。
+ */
+struct IpcChannel::RingHeader
+{
+    alignas(64) std::atomic<quint64> head;   // 接收方已读取到的位置
+    alignas(64) std::atomic<quint64> tail;   // 发送方已写入到的位置
+};
+
+// 消息记录头，按8字节对齐，记录头不会跨越数据区末尾
+struct RecordHeader
+{
+    quint32 size;   // 负载字节数
+    quint16 type;
+    quint16 reserved;
+};
+
+static_assert(sizeof(SegmentHeader) == 64, "segment header must occupy one cache line");
+static_assert(sizeof(RecordHeader) == 8, "record header must be 8 bytes");
+static_assert(std::atomic<quint64>::is_always_lock_free,
+              "shared memory positions require lock-free 64-bit atomics");
+
+static quint32 alignRecord(quint32 size)
+{
+    return (size + 7u) & ~7u;
+}
+
+static quint32 roundUpToPowerOfTwo(quint32 value)
+{
+    quint32 result = 64;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// 从数据区拷出/拷入，处理跨越末尾的情况
+static void copyOut(const char* ring, quint32 capacity, quint64 position, char* out, quint32 size)
+{
+    const quint32 offset = static_cast<quint32>(position & (capacity - 1));
+    const quint32 first  = qMin(size, capacity - offset);
+    memcpy(out, ring + offset, first);
+    memcpy(out + first, ring, size - first);
+}
+
+static void copyIn(char* ring, quint32 capacity, quint64 position, const char* in, quint32 size)
+{
+    const quint32 offset = static_cast<quint32>(position & (capacity - 1));
+    const quint32 first  = qMin(size, capacity - offset);
+    memcpy(ring + offset, in, first);
+    memcpy(ring, in + first, size - first);
+}
+
+IpcChannel::IpcChannel(Role role)
+    : m_role(role)
+{}
+
+IpcChannel::~IpcChannel()
+{
+    close();
+}
+
+bool IpcChannel::create(const QString& key, int capacity)
+{
+    m_capacity = roundUpToPowerOfTwo(static_cast<quint32>(qMax(capacity, 64)));
+
+    const int size =
+        static_cast<int>(sizeof(SegmentHeader) + 2 * sizeof(RingHeader) + 2 * m_capacity);
+
+    m_memory.reset(new QSharedMemory(key));
+    if (!m_memory->create(size)) {
+        // 上次异常退出遗留的同名段：附加后再分离即可释放
+        if (m_memory->error() == QSharedMemory::AlreadyExists && m_memory->attach()) {
+            m_memory->detach();
+        }
+        if (!m_memory->create(size)) {
+            m_errorString = m_memory->errorString();
+            m_memory.reset();
+            return false;
+        }
+    }
+
+    SegmentHeader* header = static_cast<SegmentHeader*>(m_memory->data());
+    memset(header, 0, sizeof(SegmentHeader));
+    header->magic    = kSegmentMagic;
+    header->version  = kSegmentVersion;
+    header->capacity = m_capacity;
+
+    mapRings(true);
+    openSemaphores(key, QSystemSemaphore::Create);
+    m_closed = false;
+    return true;
+}
+
+bool IpcChannel::attach(const QString& key)
+{
+    m_memory.reset(new QSharedMemory(key));
+    if (!m_memory->attach()) {
+        m_errorString = m_memory->errorString();
+        m_memory.reset();
+        return false;
+    }
+
+    const SegmentHeader* header = static_cast<const SegmentHeader*>(m_memory->constData());
+    if (header->magic != kSegmentMagic || header->version != kSegmentVersion) {
+        m_errorString = "Shared memory layout mismatch";
+        m_memory.reset();
+        return false;
+    }
+
+    m_capacity = header->capacity;
+    mapRings(false);
+    openSemaphores(key, QSystemSemaphore::Open);
+    m_closed = false;
+    return true;
+}
+
+void IpcChannel::mapRings(bool initialize)
+{
+    char*       base     = static_cast<char*>(m_memory->data()) + sizeof(SegmentHeader);
+    RingHeader* commands = reinterpret_cast<RingHeader*>(base);
+    RingHeader* events   = commands + 1;
+    char*       data     = reinterpret_cast<char*>(events + 1);
+
+    if (initialize) {
+        new (commands) RingHeader();
+        new (events) RingHeader();
+        commands->head = commands->tail = 0;
+        events->head = events->tail = 0;
+    }
+
+    // 命令方向：主进程 -> 执行进程；事件方向：执行进程 -> 主进程
+    if (m_role == Host) {
+        m_sendRing    = commands;
+        m_sendData    = data;
+        m_receiveRing = events;
+        m_receiveData = data + m_capacity;
+    }
+    else {
+        m_sendRing    = events;
+        m_sendData    = data + m_capacity;
+        m_receiveRing = commands;
+        m_receiveData = data;
+    }
+}
+
+void IpcChannel::openSemaphores(const QString& key, QSystemSemaphore::AccessMode mode)
+{
+    const QString commandKey = key + "-cmd";
+    const QString eventKey   = key + "-evt";
+
+    const QString& sendKey    = m_role == Host ? commandKey : eventKey;
+    const QString& receiveKey = m_role == Host ? eventKey : commandKey;
+
+    m_sendSignal.reset(new QSystemSemaphore(sendKey, 0, mode));
+    m_receiveSignal.reset(new QSystemSemaphore(receiveKey, 0, mode));
+}
+
+bool IpcChannel::send(quint16 type, const QByteArray& payload, int timeoutMs)
+{
+    if (!isValid() || m_closed) {
+        return false;
+    }
+
+    const quint32 payloadSize = static_cast<quint32>(payload.size());
+    const quint32 recordSize  = alignRecord(sizeof(RecordHeader) + payloadSize);
+    if (recordSize > m_capacity) {
+        m_errorString = "Message too large for channel";
+        return false;
+    }
+
+    QMutexLocker locker(&m_sendMutex);
+
+    const quint64  tail = m_sendRing->tail.load(std::memory_order_relaxed);
+    QDeadlineTimer deadline(timeoutMs < 0 ? QDeadlineTimer::Forever : timeoutMs);
+
+    // 缓冲区满：等待接收方取走数据（只在对端跟不上时发生）
+    while (m_capacity - (tail - m_sendRing->head.load(std::memory_order_acquire)) < recordSize) {
+        if (m_closed || deadline.hasExpired()) {
+            return false;
+        }
+        QThread::usleep(200);
+    }
+
+    RecordHeader header = {payloadSize, type, 0};
+    copyIn(m_sendData, m_capacity, tail, reinterpret_cast<const char*>(&header), sizeof(header));
+    copyIn(m_sendData, m_capacity, tail + sizeof(header), payload.constData(), payloadSize);
+
+    m_sendRing->tail.store(tail + recordSize, std::memory_order_seq_cst);
+
+    // 发布后复查：接收方已读完之前的全部数据，说明它可能已经或即将阻塞，需要唤醒
+    if (m_sendRing->head.load(std::memory_order_seq_cst) == tail) {
+        m_sendSignal->release();
+    }
+
+    return true;
+}
+
+bool IpcChannel::receive(quint16* type, QByteArray* payload, bool wait)
+{
+    while (isValid() && !m_closed) {
+        const quint64 head = m_receiveRing->head.load(std::memory_order_relaxed);
+        const quint64 tail = m_receiveRing->tail.load(std::memory_order_seq_cst);
+
+        if (head != tail) {
+            RecordHeader header;
+            copyOut(m_receiveData, m_capacity, head, reinterpret_cast<char*>(&header), sizeof(header));
+            if (header.size > m_capacity - sizeof(header)) {
+                m_errorString = "Corrupted message header";
+                m_closed      = true;
+                return false;
+            }
+
+            payload->resize(static_cast<int>(header.size));
+            copyOut(m_receiveData, m_capacity, head + sizeof(header), payload->data(), header.size);
+            *type = header.type;
+
+            m_receiveRing->head.store(head + alignRecord(sizeof(header) + header.size),
+                                      std::memory_order_seq_cst);
+            return true;
+        }
+
+        if (!wait) {
+            return false;
+        }
+
+        // 多余的唤醒只会让循环多检查一次
+        m_receiveSignal->acquire();
+    }
+
+    return false;
+}
+
+void IpcChannel::close()
+{
+    if (m_closed.exchange(true)) {
+        return;
+    }
+
+    // 唤醒本端阻塞在receive()中的线程
+    if (m_receiveSignal) {
+        m_receiveSignal->release();
+    }
+}
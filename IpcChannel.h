@@ -0,0 +1,127 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QSharedMemory>
+#include <QString>
+#include <QSystemSemaphore>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class IpcChannel
+ * @brief 主进程与执行进程之间基于共享内存的双向消息通道
+ *
+ * 一块共享内存中放两个单生产者单消费者环形缓冲区（每个方向一个），
+ * 消息为 类型 + 字节负载：
+ * - 发送只拷贝数据并更新尾指针，不经过系统调用；只有缓冲区由空变为非空时
+ *   才释放一次系统信号量唤醒接收方，连续的输出消息天然合并为一次唤醒
+ * - 缓冲区满时发送方等待接收方取走数据，形成跨进程的反压
+ * - 一端进程崩溃不会破坏另一端，主进程丢弃旧通道后为新进程创建新通道
+ */
+class IpcChannel
+{
+public:
+    /**
+     * @brief 通道端点
+     */
+    enum Role
+    {
+        Host,     // 主进程：创建共享内存，发送命令，接收事件
+        Worker    // 执行进程：附加共享内存，接收命令，发送事件
+    };
+
+    /**
+     * @brief 构造函数
+     * @param role 端点角色
+     */
+    explicit IpcChannel(Role role);
+
+    /**
+     * @brief 析构函数
+     */
+    ~IpcChannel();
+
+    /**
+     * @brief 创建共享内存和信号量（主进程调用）
+     * @param key 通道标识
+     * @param capacity 每个方向的缓冲区字节数（向上取整为2的幂）
+     * @return bool 成功返回true
+     */
+    bool create(const QString& key, int capacity = 1 << 20);
+
+    /**
+     * @brief 附加到主进程创建的通道（执行进程调用）
+     * @param key 通道标识
+     * @return bool 成功返回true
+     */
+    bool attach(const QString& key);
+
+    /**
+     * @brief 通道是否可用
+     * @return bool 已创建或已附加返回true
+     */
+    bool isValid() const { return m_memory && m_memory->isAttached(); }
+
+    /**
+     * @brief 发送一条消息（线程安全，多个发送线程之间串行）
+     * @param type 消息类型
+     * @param payload 负载
+     * @param timeoutMs 缓冲区满时最长等待毫秒数，-1表示一直等待
+     * @return bool 发送成功返回true，超时、消息过大或通道已关闭时返回false
+     */
+    bool send(quint16 type, const QByteArray& payload = QByteArray(), int timeoutMs = -1);
+
+    /**
+     * @brief 接收一条消息（只允许一个接收线程）
+     * @param type 输出参数，消息类型
+     * @param payload 输出参数，负载
+     * @param wait 没有消息时是否阻塞等待
+     * @return bool 收到消息返回true；不等待且没有消息，或通道已关闭时返回false
+     */
+    bool receive(quint16* type, QByteArray* payload, bool wait);
+
+    /**
+     * @brief 关闭通道并唤醒阻塞在receive()中的接收线程（可在任意线程调用）
+     */
+    void close();
+
+    /**
+     * @brief 获取最近一次错误的描述
+     * @return QString 错误信息
+     */
+    QString errorString() const { return m_errorString; }
+
+private:
+    struct RingHeader;
+
+    /**
+     * @brief 在共享内存中定位两个环形缓冲区
+     * @param initialize 是否初始化读写位置（创建方调用）
+     */
+    void mapRings(bool initialize);
+
+    /**
+     * @brief 打开两个方向的唤醒信号量
+     * @param key 通道标识
+     * @param mode 创建或打开
+     */
+    void openSemaphores(const QString& key, QSystemSemaphore::AccessMode mode);
+
+private:
+    Role                              m_role;
+    quint32                           m_capacity = 0;
+    std::unique_ptr<QSharedMemory>    m_memory;
+    std::unique_ptr<QSystemSemaphore> m_sendSignal;      // 唤醒对端接收线程
+    std::unique_ptr<QSystemSemaphore> m_receiveSignal;   // 本端接收线程在此阻塞
+
+    RingHeader* m_sendRing    = nullptr;
+    char*       m_sendData    = nullptr;
+    RingHeader* m_receiveRing = nullptr;
+    char*       m_receiveData = nullptr;
+
+    QMutex            m_sendMutex;   // 串行化多个发送线程
+    std::atomic<bool> m_closed{false};
+    QString           m_errorString;
+};
@@ -0,0 +1,15 @@
+#include "LineChannel.h"
+
+LineChannel::LineChannel(int lineCount)
+    : m_lineCount(qMax(0, lineCount))
+    , m_hits(new std::atomic<quint32>[qMax(1, lineCount)]())
+{}
+
+quint32 LineChannel::hits(int line) const
+{
+    if (line <= 0 || line > m_lineCount) {
+        return 0;
+    }
+
+    return m_hits[line - 1].load(std::memory_order_relaxed);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class LineChannel
+ * @brief 运行线程与编辑器之间的执行行通道
+ *
+ * 运行线程每个行事件只写入几个原子变量（最新行号、每行命中计数、事件总数），
+ * 不发信号也不分配内存；编辑器按显示刷新率采样，
+ * 代码执行速度不再受界面重绘速度影响。
+ */
+class LineChannel
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param lineCount 代码总行数（决定命中计数数组大小）
+     */
+    explicit LineChannel(int lineCount);
+
+    /**
+     * @brief 记录一次行事件（运行线程调用）
+     * @param line 行号（1-based）
+     */
+    void record(int line) noexcept
+    {
+        m_latestLine.store(line, std::memory_order_relaxed);
+        m_events.fetch_add(1, std::memory_order_relaxed);
+        if (line > 0 && line <= m_lineCount) {
+            m_hits[line - 1].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 获取最近执行的行号
+     * @return int 行号，尚未执行任何行时返回-1
+     */
+    int latestLine() const { return m_latestLine.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 获取某一行的命中次数
+     * @param line 行号（1-based）
+     * @return quint32 命中次数
+     */
+    quint32 hits(int line) const;
+
+    /**
+     * @brief 获取已记录的行事件总数
+     * @return quint64 事件数
+     */
+    quint64 events() const { return m_events.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 获取代码总行数
+     * @return int 行数
+     */
+    int lineCount() const { return m_lineCount; }
+
+private:
+    const int                               m_lineCount;
+    std::unique_ptr<std::atomic<quint32>[]> m_hits;
+    std::atomic<int>                        m_latestLine{-1};
+    std::atomic<quint64>                    m_events{0};
+};
@@ -0,0 +1,70 @@
+#include "LineProfile.h"
+
+#ifdef Q_OS_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+LineProfile::LineProfile(int lineCount)
+    : m_lineCount(qMax(0, lineCount))
+    , m_hits(new std::atomic<quint64>[qMax(1, lineCount)]())
+    , m_wallNs(new std::atomic<qint64>[qMax(1, lineCount)]())
+    , m_cpuNs(new std::atomic<qint64>[qMax(1, lineCount)]())
+{}
+
+quint64 LineProfile::hits(int line) const
+{
+    if (line <= 0 || line > m_lineCount) {
+        return 0;
+    }
+
+    return m_hits[line - 1].load(std::memory_order_relaxed);
+}
+
+qint64 LineProfile::wallNs(int line) const
+{
+    if (line <= 0 || line > m_lineCount) {
+        return 0;
+    }
+
+    return m_wallNs[line - 1].load(std::memory_order_relaxed);
+}
+
+qint64 LineProfile::cpuNs(int line) const
+{
+    if (line <= 0 || line > m_lineCount) {
+        return 0;
+    }
+
+    return m_cpuNs[line - 1].load(std::memory_order_relaxed);
+}
+
+qint64 LineProfile::maxWallNs() const
+{
+    qint64 result = 0;
+    for (int i = 0; i < m_lineCount; ++i) {
+        result = qMax(result, m_wallNs[i].load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+qint64 LineProfile::threadCpuNs()
+{
+#ifdef Q_OS_WINDOWS
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    // FILETIME以100纳秒为单位
+    const quint64 kernelTicks = (quint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const quint64 userTicks   = (quint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return static_cast<qint64>((kernelTicks + userTicks) * 100);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
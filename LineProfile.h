@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class LineProfile
+ * @brief 一次性能分析运行的逐行统计
+ *
+ * 命中次数、墙钟时间和CPU时间分别存放在按行号索引的定长数组中，
+ * 运行线程每个行事件只做几次原子加法，不查表也不分配内存；
+ * 编辑器和热点表格可以在运行过程中随时读取。
+ *
+ * 时间按"从该行开始到同一栈帧的下一个行事件"计算，包含该行调用的函数，
+ * 与常见的逐行分析器一致。
+ */
+class LineProfile
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param lineCount 代码总行数
+     */
+    explicit LineProfile(int lineCount);
+
+    /**
+     * @brief 记录一行的一次执行（运行线程调用）
+     * @param line 行号（1-based）
+     * @param wallNs 墙钟时间
+     * @param cpuNs 运行线程的CPU时间
+     */
+    void record(int line, qint64 wallNs, qint64 cpuNs) noexcept
+    {
+        if (line <= 0 || line > m_lineCount) {
+            return;
+        }
+        m_hits[line - 1].fetch_add(1, std::memory_order_relaxed);
+        m_wallNs[line - 1].fetch_add(wallNs, std::memory_order_relaxed);
+        m_cpuNs[line - 1].fetch_add(cpuNs, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取代码总行数
+     * @return int 行数
+     */
+    int lineCount() const { return m_lineCount; }
+
+    /**
+     * @brief 获取某一行的执行次数
+     * @param line 行号（1-based）
+     * @return quint64 次数
+     */
+    quint64 hits(int line) const;
+
+    /**
+     * @brief 获取某一行累计的墙钟时间
+     * @param line 行号（1-based）
+     * @return qint64 纳秒
+     */
+    qint64 wallNs(int line) const;
+
+    /**
+     * @brief 获取某一行累计的CPU时间
+     * @param line 行号（1-based）
+     * @return qint64 纳秒
+     */
+    qint64 cpuNs(int line) const;
+
+    /**
+     * @brief 获取单行墙钟时间的最大值（热力图按此归一化）
+     * @return qint64 纳秒
+     */
+    qint64 maxWallNs() const;
+
+    /**
+     * @brief 获取当前线程已消耗的CPU时间
+     * @return qint64 纳秒
+     */
+    static qint64 threadCpuNs();
+
+private:
+    const int                               m_lineCount;
+    std::unique_ptr<std::atomic<quint64>[]> m_hits;
+    std::unique_ptr<std::atomic<qint64>[]>  m_wallNs;
+    std::unique_ptr<std::atomic<qint64>[]>  m_cpuNs;
+};
@@ -0,0 +1,393 @@
+#include "MemoryProfiler.h"
+#include "PythonInterpreterManager.h"
+
+#include <pybind11/eval.h>
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+namespace py = pybind11;
+
+// 常驻内存采样间隔
+static const int kRssIntervalMs = 10;
+
+// tracemalloc保留的调用栈层数
+static const int kTracebackFrames = 16;
+
+// Python侧的汇总函数
+//
+// Trace.traceback从最外层排到最内层，倒序查找第一个编辑器帧，库代码中的分配归到调用它的行。
+static const char* const kHelperSource = R"(
+import tracemalloc
+
+
+def summarize(filename, limit):
+    snapshot = tracemalloc.take_snapshot()
+    sites = {}
+    for trace in snapshot.traces:
+        for frame in reversed(trace.traceback):
+            if frame.filename == filename:
+                size, count = sites.get(frame.lineno, (0, 0))
+                sites[frame.lineno] = (size + trace.size, count + 1)
+                break
+    ranked = sorted(sites.items(), key=lambda item: item[1][0], reverse=True)
+    return [(line, size, count) for line, (size, count) in ranked[:limit]]
+)";
+
+// 对象诊断的Python函数
+//
+// take()在运行前回收并记录所有GC跟踪对象的id和按类型的数量；compare()回收后找出运行中创建的对象，
+// 沿__main__可到达的新对象属于运行结果，其余对象再遍历一次堆找出第一个引用它的对象作为持有者。
+// 持有者：1 模块属性，2 其他对象，3 没有Python引用（C++持有）。快照本身和函数的局部容器不计入。
+static const char* const kObjectSource = R"(
+import gc
+import sys
+import tracemalloc
+from collections import Counter
+
+
+def type_name(t):
+    module = getattr(t, '__module__', None)
+    if module in (None, 'builtins'):
+        return t.__qualname__
+    return module + '.' + t.__qualname__
+
+
+def take():
+    gc.collect()
+    objects = gc.get_objects()
+    state = (set(map(id, objects)), Counter(map(type, objects)), len(objects), sys.getallocatedblocks())
+    del objects
+    return state
+
+
+def describe(holder, obj, modules):
+    name = modules.get(id(holder))
+    if name is not None:
+        for key, value in holder.items():
+            if value is obj:
+                return 1, '%s.%s' % (name, key)
+        return 1, name
+    if isinstance(holder, dict):
+        for key, value in holder.items():
+            if value is obj:
+                return 2, 'dict[%s]' % repr(key)[:80]
+    return 2, type_name(type(holder))
+
+
+def allocation_line(obj, filename):
+    if not tracemalloc.is_tracing():
+        return 0
+    traceback = tracemalloc.get_object_traceback(obj)
+    for frame in reversed(traceback or ()):
+        if frame.filename == filename:
+            return frame.lineno
+    return 0
+
+
+def compare(state, filename, limit):
+    before_ids, before_counts, before_total, before_blocks = state
+    gc.collect()
+    objects = gc.get_objects()
+    after_total = len(objects)
+    after_counts = Counter(map(type, objects))
+    ignore = {id(state), id(before_ids), id(before_counts), id(objects), id(sys._getframe())}
+    survivors = {id(o): o for o in objects if id(o) not in before_ids and id(o) not in ignore}
+
+    main = sys.modules.get('__main__')
+    roots = [main, getattr(main, '__dict__', None)]
+    held = {id(root) for root in roots if id(root) in survivors}
+    stack = list(roots)
+    while stack:
+        for ref in gc.get_referents(stack.pop()):
+            key = id(ref)
+            if key in survivors and key not in held:
+                held.add(key)
+                stack.append(ref)
+
+    leaked = {key: obj for key, obj in survivors.items() if key not in held}
+    holders = {}
+    if leaked:
+        for obj in objects:
+            if obj is survivors or obj is leaked:
+                continue
+            for ref in gc.get_referents(obj):
+                key = id(ref)
+                if key in leaked and key not in holders:
+                    holders[key] = obj
+
+    modules = {}
+    for name, module in list(sys.modules.items()):
+        namespace = getattr(module, '__dict__', None)
+        if namespace is not None:
+            modules[id(namespace)] = name
+
+    by_type = Counter(type(obj) for obj in leaked.values())
+    samples = {}
+    for key, obj in leaked.items():
+        samples.setdefault(type(obj), (key, obj))
+    leaks = []
+    for t, count in by_type.most_common(limit):
+        key, obj = samples[t]
+        holder = holders.get(key)
+        kind, detail = describe(holder, obj, modules) if holder is not None else (3, '')
+        leaks.append((type_name(t), count, kind, detail, allocation_line(obj, filename)))
+
+    deltas = [(t, before_counts.get(t, 0), count) for t, count in after_counts.items()
+              if count > before_counts.get(t, 0)]
+    deltas.sort(key=lambda item: item[2] - item[1], reverse=True)
+    types = [(type_name(t), before, after) for t, before, after in deltas[:limit]]
+
+    result = (before_total, after_total, sys.getallocatedblocks() - before_blocks, len(survivors), len(held),
+              len(leaked), sum(1 for key in leaked if key not in holders), types, leaks)
+    del objects, survivors, leaked, holders, samples
+    return result
+
+)";
+
+MemoryProfiler::~MemoryProfiler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (m_helpers || m_objectHelpers || m_objectState) {
+        if (Py_IsInitialized()) {
+            py::gil_scoped_acquire acquire;
+            m_helpers       = py::object();
+            m_objectHelpers = py::object();
+            m_objectState   = py::object();
+        }
+        else {
+            m_helpers.release();
+            m_objectHelpers.release();
+            m_objectState.release();
+        }
+    }
+}
+
+void MemoryProfiler::release()
+{
+    m_helpers       = py::object();
+    m_objectHelpers = py::object();
+    m_objectState   = py::object();
+}
+
+qint64 MemoryProfiler::currentRssBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.WorkingSetSize);
+    }
+    return 0;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t      count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+        == KERN_SUCCESS) {
+        return static_cast<qint64>(info.resident_size);
+    }
+    return 0;
+#else
+    // 第二列是常驻页数
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    FILE*             file     = std::fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+    long long size = 0, resident = 0;
+    const int fields = std::fscanf(file, "%lld %lld", &size, &resident);
+    std::fclose(file);
+    return fields == 2 ? static_cast<qint64>(resident) * pageSize : 0;
+#endif
+}
+
+void MemoryProfiler::start(bool tracing, bool objects)
+{
+    if (isRunning()) {
+        return;
+    }
+
+    // 对象快照在开启tracemalloc之前拍，快照本身的分配不计入；
+    // 诊断函数在快照之前创建，不会被当作运行中创建的对象
+    m_objectState = py::object();
+    if (objects) {
+        try {
+            if (!m_objectHelpers) {
+                py::dict scope;
+                scope["__name__"]     = "qt_object_diagnostics";
+                scope["__builtins__"] = py::module_::import("builtins");
+                py::exec(kObjectSource, scope);
+                m_objectHelpers = scope;
+            }
+            m_objectState = m_objectHelpers["take"]();
+        }
+        catch (py::error_already_set& e) {
+            e.discard_as_unraisable("MemoryProfiler.start");
+        }
+    }
+
+    // 用户代码自己开启的tracemalloc保持原样，不重置、不停止
+    m_tracingRequested = tracing;
+    m_ownsTracing      = false;
+    if (tracing) {
+        py::module_ tracemalloc = py::module_::import("tracemalloc");
+        m_ownsTracing           = !tracemalloc.attr("is_tracing")().cast<bool>();
+        if (m_ownsTracing) {
+            tracemalloc.attr("start")(kTracebackFrames);
+        }
+    }
+
+    m_startRssBytes = currentRssBytes();
+    m_peakRssBytes.store(m_startRssBytes, std::memory_order_relaxed);
+    m_rssSamples.store(0, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+    }
+    m_thread = std::thread(&MemoryProfiler::sampleLoop, this);
+}
+
+void MemoryProfiler::sampleLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        const qint64 rss  = currentRssBytes();
+        qint64       peak = m_peakRssBytes.load(std::memory_order_relaxed);
+        while (rss > peak && !m_peakRssBytes.compare_exchange_weak(peak, rss, std::memory_order_relaxed)) {
+        }
+        m_rssSamples.fetch_add(1, std::memory_order_relaxed);
+
+        m_wake.wait_for(lock, std::chrono::milliseconds(kRssIntervalMs), [this]() { return m_stopping; });
+    }
+}
+
+std::shared_ptr<MemoryReport> MemoryProfiler::stop(int maxSites)
+{
+    if (!isRunning()) {
+        return nullptr;
+    }
+
+    // 采样线程不使用Python，等待时不需要释放GIL
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+
+    std::shared_ptr<MemoryReport> report = std::make_shared<MemoryReport>();
+    report->startRssBytes                = m_startRssBytes;
+    report->endRssBytes                  = currentRssBytes();
+    report->peakRssBytes = std::max(m_peakRssBytes.load(std::memory_order_relaxed), report->endRssBytes);
+    report->rssSamples   = m_rssSamples.load(std::memory_order_relaxed);
+    report->runIndex     = ++m_runCount;
+    if (m_previousEndRss > 0) {
+        report->rssGrowthBytes = report->endRssBytes - m_previousEndRss;
+    }
+    m_previousEndRss = report->endRssBytes;
+    report->tracingRequested = m_tracingRequested;
+
+    // 对象诊断在停止tracemalloc之前进行，样本对象的分配行仍可查询
+    if (m_objectState) {
+        try {
+            collectObjects(report.get(), maxSites);
+        }
+        catch (py::error_already_set& e) {
+            e.discard_as_unraisable("MemoryProfiler.stop");
+        }
+        m_objectState = py::object();
+    }
+
+    if (m_ownsTracing) {
+        try {
+            py::module_ tracemalloc = py::module_::import("tracemalloc");
+            py::tuple   traced      = tracemalloc.attr("get_traced_memory")();
+            report->traced          = true;
+            report->retainedBytes   = traced[0].cast<qint64>();
+            report->peakTracedBytes = traced[1].cast<qint64>();
+            collectSites(report.get(), maxSites);
+            tracemalloc.attr("stop")();
+        }
+        catch (py::error_already_set& e) {
+            // 统计失败不影响运行结果
+            e.discard_as_unraisable("MemoryProfiler.stop");
+        }
+        m_ownsTracing = false;
+    }
+    return report;
+}
+
+void MemoryProfiler::collectSites(MemoryReport* report, int maxSites)
+{
+    if (!m_helpers) {
+        py::dict scope;
+        scope["__name__"]     = "qt_memory_profiler";
+        scope["__builtins__"] = py::module_::import("builtins");
+        py::exec(kHelperSource, scope);
+        m_helpers = scope["summarize"];
+    }
+
+    py::list sites = m_helpers(PythonInterpreterManager::editorFileName(), maxSites);
+    for (py::handle item : sites) {
+        py::tuple          tuple = py::reinterpret_borrow<py::tuple>(item);
+        MemoryReport::Site site;
+        site.line  = tuple[0].cast<int>();
+        site.bytes = tuple[1].cast<qint64>();
+        site.count = tuple[2].cast<qint64>();
+        report->topSites.append(site);
+    }
+}
+
+void MemoryProfiler::collectObjects(MemoryReport* report, int maxTypes)
+{
+    py::tuple result = m_objectHelpers["compare"](
+        m_objectState, PythonInterpreterManager::editorFileName(), maxTypes);
+
+    report->objectsChecked       = true;
+    report->gcObjectsBefore      = result[0].cast<qint64>();
+    report->gcObjectsAfter       = result[1].cast<qint64>();
+    report->allocatedBlocksDelta = result[2].cast<qint64>();
+    report->survivingObjects     = result[3].cast<qint64>();
+    report->namespaceObjects     = result[4].cast<qint64>();
+    report->leakedObjects        = result[5].cast<qint64>();
+    report->hostHeldObjects      = result[6].cast<qint64>();
+    m_leakedTotal += report->leakedObjects;
+    report->leakedTotal = m_leakedTotal;
+
+    for (py::handle item : py::reinterpret_borrow<py::list>(result[7])) {
+        py::tuple               tuple = py::reinterpret_borrow<py::tuple>(item);
+        MemoryReport::TypeCount count;
+        count.type   = QString::fromStdString(tuple[0].cast<std::string>());
+        count.before = tuple[1].cast<qint64>();
+        count.after  = tuple[2].cast<qint64>();
+        report->typeCounts.append(count);
+    }
+    for (py::handle item : py::reinterpret_borrow<py::list>(result[8])) {
+        py::tuple                tuple = py::reinterpret_borrow<py::tuple>(item);
+        MemoryReport::ObjectLeak leak;
+        leak.type   = QString::fromStdString(tuple[0].cast<std::string>());
+        leak.count  = tuple[1].cast<qint64>();
+        leak.holder = tuple[2].cast<int>();
+        leak.detail = QString::fromStdString(tuple[3].cast<std::string>());
+        leak.line   = tuple[4].cast<int>();
+        report->leaks.append(leak);
+    }
+}
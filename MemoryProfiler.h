@@ -0,0 +1,193 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+/**
+ * @struct MemoryReport
+ * @brief 一次运行的内存统计
+ */
+struct MemoryReport
+{
+    /**
+     * @brief 运行结束时仍存活的分配，按编辑器中的行汇总
+     */
+    struct Site
+    {
+        int    line  = 0;   // 编辑器行号（1-based）
+        qint64 bytes = 0;   // 字节数
+        qint64 count = 0;   // 分配次数
+    };
+
+    /**
+     * @brief 运行前后一种类型的GC跟踪对象数
+     */
+    struct TypeCount
+    {
+        QString type;
+        qint64  before = 0;
+        qint64  after  = 0;
+    };
+
+    /**
+     * @brief 泄漏对象的持有者
+     */
+    enum Holder
+    {
+        HeldByModule = 1,   // 模块的属性（detail为"模块.属性"）
+        HeldByContainer,    // 其他Python对象（detail为持有者的类型，字典时附带键）
+        HeldByHost          // 没有Python对象引用，由C++宿主或扩展模块持有
+    };
+
+    /**
+     * @brief 运行结束后仍存活、且不属于本次运行__main__的一种类型的对象
+     */
+    struct ObjectLeak
+    {
+        QString type;
+        qint64  count  = 0;
+        int     holder = HeldByHost;   // 样本对象的持有者（Holder）
+        QString detail;
+        int     line   = 0;            // 样本对象在编辑器中的分配行（需要tracemalloc），0表示未知
+    };
+
+    bool   tracingRequested = true;   // 本次运行是否要求tracemalloc（只做对象诊断时为false）
+    bool   traced          = false;   // tracemalloc是否可用（被用户代码占用时为false）
+    qint64 peakTracedBytes = 0;       // 运行期间Python分配的峰值
+    qint64 retainedBytes   = 0;       // 运行结束时本次运行的分配中仍存活的字节数
+    qint64 startRssBytes   = 0;       // 运行开始时的进程常驻内存
+    qint64 peakRssBytes    = 0;       // 采样得到的常驻内存峰值
+    qint64 endRssBytes     = 0;       // 运行结束时的常驻内存
+    qint64 rssGrowthBytes  = 0;       // 与上一次统计运行结束时相比的增长（第一次统计时为0）
+    int    runIndex        = 0;       // 统计运行的序号，从1开始
+    int    rssSamples      = 0;       // 常驻内存采样次数
+    QVector<Site> topSites;           // 按字节数从大到小
+
+    // 对象诊断：运行前后各做一次完整回收，比较GC跟踪的对象
+    bool   objectsChecked       = false;
+    qint64 gcObjectsBefore      = 0;
+    qint64 gcObjectsAfter       = 0;
+    qint64 allocatedBlocksDelta = 0;   // sys.getallocatedblocks()的变化，包括不被GC跟踪的str、int等
+    qint64 survivingObjects     = 0;   // 运行中创建、结束后仍存活的对象
+    qint64 namespaceObjects     = 0;   // 其中可从本次运行的__main__到达的（非会话模式下一次运行时释放）
+    qint64 leakedObjects        = 0;   // 其余的：被模块、其他对象或C++持有
+    qint64 hostHeldObjects      = 0;   // 其中没有Python对象引用的
+    qint64 leakedTotal          = 0;   // 本运行器各次诊断运行的leakedObjects之和
+    QVector<TypeCount>  typeCounts;    // 对象数增加最多的类型
+    QVector<ObjectLeak> leaks;         // 按数量从多到少
+};
+
+/**
+ * @class MemoryProfiler
+ * @brief 运行期间的内存统计：tracemalloc记录Python分配，独立线程采样进程常驻内存
+ *
+ * - start()开启tracemalloc（保留16层调用栈，库代码中的分配也能归到调用它的编辑器行），
+ *   stop()读取峰值并对结束时仍存活的分配拍快照，按调用栈中最内层的编辑器帧汇总到行
+ * - 采样线程每10毫秒读取一次常驻内存（Linux读/proc/self/statm，Windows和macOS调用系统接口），
+ *   不需要GIL，C扩展和NumPy的分配也能反映出来
+ * - 记录每次统计运行结束时的常驻内存，与上一次比较得到跨运行的增长，
+ *   保留会话命名空间时持续增长通常意味着变量或缓存在会话中累积
+ *
+ * tracemalloc使Python分配明显变慢（通常为2到4倍），只在勾选内存统计时开启；
+ * 用户代码已自行开启tracemalloc时不接管，只采样常驻内存。
+ *
+ * 对象诊断用于查找长时间会话中内存缓慢增长的来源：运行前回收并记录所有GC跟踪对象，
+ * 运行后再次回收，找出运行中创建且仍存活的对象。可从本次运行的__main__到达的对象属于运行结果，
+ * 其余的按类型汇总，并为每种类型找出一个样本的持有者：模块属性、其他对象，或者只被C++持有
+ * （宿主保存的py::object、扩展模块的缓存）。运行前后各遍历一次堆，只在诊断时开启。
+ * start()和stop()都在持有GIL的运行线程中调用。
+ */
+class MemoryProfiler
+{
+public:
+    MemoryProfiler() = default;
+
+    /**
+     * @brief 析构函数（停止采样线程）
+     */
+    ~MemoryProfiler();
+
+    MemoryProfiler(const MemoryProfiler&)            = delete;
+    MemoryProfiler& operator=(const MemoryProfiler&) = delete;
+
+    /**
+     * @brief 开始统计（需持有GIL）
+     * @param tracing 是否开启tracemalloc（只做对象诊断时可以关闭）
+     * @param objects 是否做对象诊断
+     */
+    void start(bool tracing = true, bool objects = false);
+
+    /**
+     * @brief 停止统计并取出结果（需持有GIL）
+     * @param maxSites 最多返回的行数
+     * @return std::shared_ptr<MemoryReport> 统计结果，未开始时为空
+     */
+    std::shared_ptr<MemoryReport> stop(int maxSites = 10);
+
+    /**
+     * @brief 是否正在统计
+     * @return bool 正在统计返回true
+     */
+    bool isRunning() const { return m_thread.joinable(); }
+
+    /**
+     * @brief 释放Python侧的汇总函数（解释器重新初始化前调用，需持有GIL，不能在统计期间调用）
+     */
+    void release();
+
+    /**
+     * @brief 读取当前进程的常驻内存
+     * @return qint64 字节数，不支持的平台返回0
+     */
+    static qint64 currentRssBytes();
+
+private:
+    /**
+     * @brief 采样线程主循环
+     */
+    void sampleLoop();
+
+    /**
+     * @brief 结束时对tracemalloc拍快照并按行汇总（需持有GIL）
+     * @param report 输出结果
+     * @param maxSites 最多返回的行数
+     */
+    void collectSites(MemoryReport* report, int maxSites);
+
+    /**
+     * @brief 与运行前的对象快照比较（需持有GIL）
+     * @param report 输出结果
+     * @param maxTypes 最多返回的类型数
+     */
+    void collectObjects(MemoryReport* report, int maxTypes);
+
+private:
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    bool                    m_stopping = false;   // 由m_mutex保护
+
+    std::atomic<qint64> m_peakRssBytes{0};
+    std::atomic<int>    m_rssSamples{0};
+    qint64              m_startRssBytes   = 0;
+    qint64              m_previousEndRss  = 0;       // 上一次统计运行结束时的常驻内存
+    int                 m_runCount        = 0;
+    bool                m_ownsTracing     = false;   // tracemalloc由本对象开启
+
+    pybind11::object m_helpers;         // Python侧的汇总函数，首次使用时创建
+    pybind11::object m_objectHelpers;   // 对象诊断的Python函数，首次使用时创建
+    pybind11::object m_objectState;     // 运行前的对象快照
+    bool             m_tracingRequested = true;
+    qint64           m_leakedTotal      = 0;
+};
@@ -0,0 +1,260 @@
+#include "ModuleRegistry.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLibrary>
+#include <QRegularExpression>
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+using InitFunction = PyObject* (*)(void);
+
+/**
+ * @brief 注册表中的一个条目
+ */
+struct ModuleRegistry::Entry
+{
+    Module                    info;
+    QByteArray                nameBytes;              // inittab引用的名字，条目存在期间地址不变
+    InitFunction              init       = nullptr;   // 插件在加载后才有
+    PyModuleDef*              definition = nullptr;
+    std::unique_ptr<QLibrary> library;
+};
+
+// 每个槽位一个跳板函数，inittab中的函数指针不能携带参数
+template <int Slot>
+static PyObject* initSlot()
+{
+    return ModuleRegistry::instance().createModule(Slot);
+}
+
+template <int... Slots>
+static std::array<InitFunction, sizeof...(Slots)> makeSlots(std::integer_sequence<int, Slots...>)
+{
+    return {{&initSlot<Slots>...}};
+}
+
+static const std::array<InitFunction, ModuleRegistry::kMaxModules> kSlots =
+    makeSlots(std::make_integer_sequence<int, ModuleRegistry::kMaxModules>());
+
+// 第一次初始化前inittab中的内置模块（含PYBIND11_EMBEDDED_MODULE注册的模块）；
+// 解释器结束时Python把inittab恢复为编译时的表，重新初始化前据此补回
+static std::vector<std::pair<const char*, InitFunction>> s_builtinInittab;
+static bool                                               s_builtinsCaptured = false;
+
+// 在当前inittab中查找模块
+static const struct _inittab* findInittab(const char* name)
+{
+    for (const struct _inittab* entry = PyImport_Inittab; entry && entry->name; ++entry) {
+        if (strcmp(entry->name, name) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+ModuleRegistry& ModuleRegistry::instance()
+{
+    static ModuleRegistry registry;
+    return registry;
+}
+
+ModuleRegistry::ModuleRegistry() = default;
+
+ModuleRegistry::~ModuleRegistry() = default;
+
+QString ModuleRegistry::defaultPluginDirectory()
+{
+    return QCoreApplication::applicationDirPath() + "/plugins";
+}
+
+ModuleRegistry::Entry* ModuleRegistry::addEntry(const QString& name)
+{
+    if (static_cast<int>(m_entries.size()) >= kMaxModules) {
+        qWarning() << "Too many extension modules, ignoring" << name;
+        return nullptr;
+    }
+    for (const std::unique_ptr<Entry>& entry : m_entries) {
+        if (entry->info.name == name) {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->info.name = name;
+    entry->nameBytes = name.toUtf8();
+    m_entries.push_back(std::move(entry));
+    return m_entries.back().get();
+}
+
+bool ModuleRegistry::registerFunction(const QString& name, PyObject* (*init)(void))
+{
+    QMutexLocker locker(&m_mutex);
+    Entry*       entry = addEntry(name);
+    if (!entry) {
+        return false;
+    }
+    entry->init = init;
+    return true;
+}
+
+bool ModuleRegistry::registerDefinition(const QString& name, PyModuleDef* definition)
+{
+    QMutexLocker locker(&m_mutex);
+    Entry*       entry = addEntry(name);
+    if (!entry) {
+        return false;
+    }
+    entry->definition = definition;
+    return true;
+}
+
+int ModuleRegistry::discover(const QStringList& directories)
+{
+    static const QRegularExpression kIdentifier("^[A-Za-z_][A-Za-z0-9_]*$");
+#if defined(Q_OS_WIN)
+    const QStringList filters = {"*.pyd", "*.dll"};
+#elif defined(Q_OS_MACOS)
+    const QStringList filters = {"*.so", "*.dylib"};
+#else
+    const QStringList filters = {"*.so"};
+#endif
+
+    QMutexLocker locker(&m_mutex);
+    int          added = 0;
+    for (const QString& directory : directories) {
+        const QDir dir(directory);
+        if (directory.isEmpty() || !dir.exists()) {
+            continue;
+        }
+
+        // 只读目录项，不打开库文件
+        for (const QFileInfo& file : dir.entryInfoList(filters, QDir::Files | QDir::Readable, QDir::Name)) {
+            const QString name = file.fileName().section('.', 0, 0);
+            if (!kIdentifier.match(name).hasMatch()) {
+                continue;
+            }
+            if (Entry* entry = addEntry(name)) {
+                entry->info.path = file.absoluteFilePath();
+                ++added;
+            }
+        }
+    }
+    return added;
+}
+
+int ModuleRegistry::appendInittab()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!s_builtinsCaptured) {
+        for (const struct _inittab* entry = PyImport_Inittab; entry && entry->name; ++entry) {
+            s_builtinInittab.emplace_back(entry->name, entry->initfunc);
+        }
+        s_builtinsCaptured = true;
+    }
+    else {
+        for (const auto& builtin : s_builtinInittab) {
+            if (!findInittab(builtin.first)) {
+                PyImport_AppendInittab(builtin.first, builtin.second);
+            }
+        }
+    }
+
+    int appended = 0;
+    for (size_t slot = 0; slot < m_entries.size(); ++slot) {
+        Entry* entry = m_entries[slot].get();
+        if (const struct _inittab* existing = findInittab(entry->nameBytes.constData())) {
+            if (existing->initfunc != kSlots[slot]) {
+                qWarning() << "Extension module" << entry->info.name << "conflicts with a built-in module, ignored"
+                           << entry->info.path;
+            }
+            continue;
+        }
+        if (PyImport_AppendInittab(entry->nameBytes.constData(), kSlots[slot]) != 0) {
+            qWarning() << "Cannot register extension module" << entry->info.name;
+            continue;
+        }
+        ++appended;
+    }
+    return appended;
+}
+
+PyObject* ModuleRegistry::createModule(int slot)
+{
+    InitFunction init       = nullptr;
+    PyModuleDef* definition = nullptr;
+    QString      name;
+    QString      path;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (slot < 0 || slot >= static_cast<int>(m_entries.size())) {
+            PyErr_SetString(PyExc_ImportError, "unknown extension module slot");
+            return nullptr;
+        }
+        const Entry* entry = m_entries[slot].get();
+        init               = entry->init;
+        definition         = entry->definition;
+        name               = entry->info.name;
+        path               = entry->info.path;
+    }
+
+    if (definition) {
+        return PyModuleDef_Init(definition);
+    }
+    if (init) {
+        return init();
+    }
+
+    // 第一次导入插件：加载库，取得入口后调用；入口可能导入其他插件，调用时不持有锁
+    QElapsedTimer timer;
+    timer.start();
+
+    std::unique_ptr<QLibrary> library(new QLibrary(path));
+    QString                   error;
+    if (!library->load()) {
+        error = library->errorString();
+    }
+    else {
+        const QByteArray symbol = "PyInit_" + name.toUtf8();
+        init                    = reinterpret_cast<InitFunction>(library->resolve(symbol.constData()));
+        if (!init) {
+            error = QString("%1 not found in %2").arg(QString::fromUtf8(symbol), path);
+        }
+    }
+
+    PyObject* module = init ? init() : nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    Entry*       entry = m_entries[slot].get();
+    if (!init) {
+        entry->info.error = error;
+        PyErr_Format(PyExc_ImportError, "cannot load extension module '%s': %s",
+                     entry->nameBytes.constData(), error.toUtf8().constData());
+        return nullptr;
+    }
+
+    // 已加载的库保留到进程退出
+    if (!entry->init) {
+        entry->init        = init;
+        entry->library     = std::move(library);
+        entry->info.loaded = true;
+        entry->info.loadNs = timer.nsecsElapsed();
+        entry->info.error.clear();
+    }
+    return module;
+}
+
+QVector<ModuleRegistry::Module> ModuleRegistry::modules() const
+{
+    QMutexLocker    locker(&m_mutex);
+    QVector<Module> result;
+    for (const std::unique_ptr<Entry>& entry : m_entries) {
+        result.append(entry->info);
+    }
+    return result;
+}
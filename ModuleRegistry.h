@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+#include <Python.h>
+
+class QLibrary;
+
+/**
+ * @class ModuleRegistry
+ * @brief 解释器初始化前注册到inittab的C++扩展模块，插件库在第一次导入时才加载
+ *
+ * 模块有三种来源：
+ * - 插件目录中的共享库：文件名第一个"."之前的部分为模块名（与setuptools构建的扩展模块命名一致，
+ *   如fastmath.cpython-312-x86_64-linux-gnu.so、fastmath.pyd），入口为标准的PyInit_<模块名>。
+ *   启动时只列出目录，不打开库文件；第一次import时才加载库并调用入口，
+ *   启动时间和内存不随插件数量增长
+ * - registerFunction()：宿主程序提供的初始化函数
+ * - registerDefinition()：宿主程序提供的PyModuleDef（多阶段初始化）
+ *
+ * PyImport_AppendInittab只能在解释器初始化前调用，每个条目需要一个不带参数的函数指针，
+ * 这里用固定数量的模板跳板函数按槽位转发。与编译进程序的内置模块同名的条目被跳过。
+ * 解释器每次初始化前调用appendInittab()（结束时Python恢复原始的inittab）。
+ * 已加载的库在进程退出前不会卸载（扩展模块不支持卸载）。
+ */
+class ModuleRegistry
+{
+public:
+    // 可注册的模块数上限（跳板函数的数量）
+    static const int kMaxModules = 64;
+
+    /**
+     * @brief 一个注册的模块
+     */
+    struct Module
+    {
+        QString name;
+        QString path;              // 插件库路径，宿主程序注册的模块为空
+        bool    loaded = false;    // 插件库已加载
+        qint64  loadNs = 0;        // 加载库和调用入口的耗时
+        QString error;             // 最近一次加载失败的原因
+    };
+
+    /**
+     * @brief 获取单例实例
+     * @return ModuleRegistry& 单例引用
+     */
+    static ModuleRegistry& instance();
+
+    /**
+     * @brief 程序目录下的默认插件目录
+     * @return QString 目录路径
+     */
+    static QString defaultPluginDirectory();
+
+    /**
+     * @brief 注册宿主程序的模块初始化函数
+     * @param name 模块名
+     * @param init 初始化函数（单阶段返回模块，多阶段返回PyModuleDef_Init()的结果）
+     * @return bool 成功返回true；同名模块已注册或超出上限时返回false
+     */
+    bool registerFunction(const QString& name, PyObject* (*init)(void));
+
+    /**
+     * @brief 注册宿主程序的模块定义（多阶段初始化）
+     * @param name 模块名
+     * @param definition 模块定义，需在进程内一直有效
+     * @return bool 成功返回true
+     */
+    bool registerDefinition(const QString& name, PyModuleDef* definition);
+
+    /**
+     * @brief 扫描插件目录，登记新发现的插件库（不打开库文件）
+     * @param directories 目录列表，不存在的目录被忽略
+     * @return int 新登记的插件数
+     */
+    int discover(const QStringList& directories);
+
+    /**
+     * @brief 把所有模块追加到inittab（解释器初始化前调用）
+     * @return int 追加的模块数
+     */
+    int appendInittab();
+
+    /**
+     * @brief 创建模块（由导入机制经跳板函数调用，持有GIL）
+     * @param slot 模块槽位
+     * @return PyObject* 模块或模块定义，失败时设置ImportError并返回nullptr
+     */
+    PyObject* createModule(int slot);
+
+    /**
+     * @brief 已注册的模块
+     * @return QVector<Module> 模块信息快照
+     */
+    QVector<Module> modules() const;
+
+private:
+    struct Entry;
+
+    ModuleRegistry();
+    ~ModuleRegistry();
+
+    /**
+     * @brief 登记一个条目（调用方持有m_mutex）
+     * @return Entry* 新条目，同名已存在或超出上限时为空
+     */
+    Entry* addEntry(const QString& name);
+
+    mutable QMutex                      m_mutex;
+    std::vector<std::unique_ptr<Entry>> m_entries;   // 槽位即下标，条目只增不减（inittab引用其中的名字）
+};
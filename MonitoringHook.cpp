@@ -0,0 +1,230 @@
+#include "MonitoringHook.h"
+
+#include <QDebug>
+
+// sys.monitoring.DEBUGGER_ID
+static const int kDebuggerToolId = 0;
+
+static const char* const kCapsuleName = "QtPythonEmbed.MonitoringHook";
+
+static PyMethodDef s_lineDef   = {"line", nullptr, METH_FASTCALL, nullptr};
+static PyMethodDef s_startDef  = {"py_start", nullptr, METH_FASTCALL, nullptr};
+static PyMethodDef s_returnDef = {"py_return", nullptr, METH_FASTCALL, nullptr};
+
+MonitoringHook::MonitoringHook(LineHandler lineHandler, FrameHandler frameHandler)
+    : m_lineHandler(lineHandler)
+    , m_frameHandler(frameHandler)
+{}
+
+MonitoringHook::~MonitoringHook()
+{
+    if (!Py_IsInitialized()) {
+        // 解释器已销毁，对象随之失效，只能放弃引用
+        for (py::object& code : m_armedCode) {
+            code.release();
+        }
+        m_monitoring.release();
+        m_setEvents.release();
+        m_setLocalEvents.release();
+        m_restartEvents.release();
+        m_disable.release();
+        m_capsule.release();
+        return;
+    }
+
+    release();
+}
+
+bool MonitoringHook::acquire()
+{
+    if (m_acquired) {
+        return true;
+    }
+
+    try {
+        py::module_ sys = py::module_::import("sys");
+        if (!py::hasattr(sys, "monitoring")) {
+            return false;
+        }
+
+        py::object monitoring = sys.attr("monitoring");
+        py::object events     = monitoring.attr("events");
+
+        // 工具编号被其他调试器或覆盖率工具占用时抛出ValueError
+        monitoring.attr("use_tool_id")(kDebuggerToolId, "QtPythonEmbed");
+
+        m_lineEvent      = events.attr("LINE").cast<int>();
+        m_startEvent     = events.attr("PY_START").cast<int>();
+        m_returnEvent    = events.attr("PY_RETURN").cast<int>();
+        m_monitoring     = monitoring;
+        m_setEvents      = monitoring.attr("set_events");
+        m_setLocalEvents = monitoring.attr("set_local_events");
+        m_restartEvents  = monitoring.attr("restart_events");
+        m_disable        = monitoring.attr("DISABLE");
+
+        s_lineDef.ml_meth   = reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(lineTrampoline));
+        s_startDef.ml_meth  = reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(startTrampoline));
+        s_returnDef.ml_meth = reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(returnTrampoline));
+
+        m_capsule = py::reinterpret_steal<py::object>(PyCapsule_New(this, kCapsuleName, nullptr));
+        if (!m_capsule) {
+            throw py::error_already_set();
+        }
+
+        py::object registerCallback = monitoring.attr("register_callback");
+        registerCallback(kDebuggerToolId,
+                         m_lineEvent,
+                         py::reinterpret_steal<py::object>(PyCFunction_New(&s_lineDef, m_capsule.ptr())));
+        registerCallback(kDebuggerToolId,
+                         m_startEvent,
+                         py::reinterpret_steal<py::object>(PyCFunction_New(&s_startDef, m_capsule.ptr())));
+        registerCallback(kDebuggerToolId,
+                         m_returnEvent,
+                         py::reinterpret_steal<py::object>(PyCFunction_New(&s_returnDef, m_capsule.ptr())));
+
+        m_acquired = true;
+        return true;
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "sys.monitoring is not usable, falling back to PyEval_SetTrace:" << e.what();
+        m_monitoring = py::object();
+        return false;
+    }
+}
+
+void MonitoringHook::activate(bool stepping)
+{
+    if (!m_acquired) {
+        return;
+    }
+
+    const int events = stepping ? (m_lineEvent | m_startEvent | m_returnEvent) : m_startEvent;
+    try {
+        m_setEvents(kDebuggerToolId, events);
+        m_active = true;
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "sys.monitoring.set_events failed:" << e.what();
+    }
+}
+
+void MonitoringHook::arm(PyCodeObject* code)
+{
+    PyObject* object = reinterpret_cast<PyObject*>(code);
+    if (!m_acquired || m_armedSet.contains(object)) {
+        return;
+    }
+
+    try {
+        m_setLocalEvents(kDebuggerToolId, py::handle(object), m_lineEvent);
+        m_armedSet.insert(object);
+        m_armedCode.push_back(py::reinterpret_borrow<py::object>(object));
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "sys.monitoring.set_local_events failed:" << e.what();
+    }
+}
+
+void MonitoringHook::restart()
+{
+    if (!m_acquired) {
+        return;
+    }
+
+    try {
+        m_restartEvents();
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "sys.monitoring.restart_events failed:" << e.what();
+    }
+}
+
+void MonitoringHook::deactivate()
+{
+    if (!m_acquired) {
+        return;
+    }
+
+    try {
+        if (m_active) {
+            m_setEvents(kDebuggerToolId, 0);
+            m_active = false;
+        }
+        for (const py::object& code : m_armedCode) {
+            m_setLocalEvents(kDebuggerToolId, code, 0);
+        }
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "Failed to clear sys.monitoring events:" << e.what();
+    }
+
+    m_armedCode.clear();
+    m_armedSet.clear();
+}
+
+void MonitoringHook::release()
+{
+    if (!m_acquired) {
+        return;
+    }
+
+    deactivate();
+
+    try {
+        py::object registerCallback = m_monitoring.attr("register_callback");
+        registerCallback(kDebuggerToolId, m_lineEvent, py::none());
+        registerCallback(kDebuggerToolId, m_startEvent, py::none());
+        registerCallback(kDebuggerToolId, m_returnEvent, py::none());
+        m_monitoring.attr("free_tool_id")(kDebuggerToolId);
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "Failed to release sys.monitoring tool id:" << e.what();
+    }
+
+    m_acquired = false;
+}
+
+PyObject* MonitoringHook::result(Action action) const
+{
+    if (action == Disable) {
+        return Py_NewRef(m_disable.ptr());
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* MonitoringHook::lineTrampoline(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    // 参数：code, line_number
+    MonitoringHook* hook = static_cast<MonitoringHook*>(PyCapsule_GetPointer(self, kCapsuleName));
+    if (!hook || nargs < 2 || !PyCode_Check(args[0])) {
+        PyErr_Clear();
+        Py_RETURN_NONE;
+    }
+
+    const int line = static_cast<int>(PyLong_AsLong(args[1]));
+    return hook->result(hook->m_lineHandler(reinterpret_cast<PyCodeObject*>(args[0]), line));
+}
+
+PyObject* MonitoringHook::startTrampoline(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    // 参数：code, instruction_offset
+    MonitoringHook* hook = static_cast<MonitoringHook*>(PyCapsule_GetPointer(self, kCapsuleName));
+    if (!hook || nargs < 1 || !PyCode_Check(args[0])) {
+        PyErr_Clear();
+        Py_RETURN_NONE;
+    }
+
+    return hook->result(hook->m_frameHandler(reinterpret_cast<PyCodeObject*>(args[0]), true));
+}
+
+PyObject* MonitoringHook::returnTrampoline(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+{
+    // 参数：code, instruction_offset, retval
+    MonitoringHook* hook = static_cast<MonitoringHook*>(PyCapsule_GetPointer(self, kCapsuleName));
+    if (!hook || nargs < 1 || !PyCode_Check(args[0])) {
+        PyErr_Clear();
+        Py_RETURN_NONE;
+    }
+
+    return hook->result(hook->m_frameHandler(reinterpret_cast<PyCodeObject*>(args[0]), false));
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <QSet>
+
+#include <vector>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/**
+ * @class MonitoringHook
+ * @brief 基于sys.monitoring（PEP 669）的调试事件钩子
+ *
+ * 与PyEval_SetTrace每个事件都回调不同，sys.monitoring按代码位置开关事件：
+ * - 回调返回DISABLE后该位置不再产生事件，直到restart()
+ * - 行事件只在arm()过的代码对象上开启，库代码不会插桩
+ * - 未激活时不开启任何事件，代码以原速运行
+ *
+ * 通过Python层接口调用，编译时不依赖3.12的头文件，运行时Python 3.12及以上可用。
+ * 所有接口都需要持有GIL。
+ */
+class MonitoringHook
+{
+public:
+    /**
+     * @brief 回调处理结果
+     */
+    enum Action
+    {
+        Continue,   // 保留该位置的事件
+        Disable     // 关闭该位置的事件（返回sys.monitoring.DISABLE）
+    };
+
+    /**
+     * @brief 行事件处理函数
+     * @param code 代码对象
+     * @param line 行号
+     */
+    using LineHandler = Action (*)(PyCodeObject* code, int line);
+
+    /**
+     * @brief 函数进入/返回事件处理函数
+     * @param code 代码对象
+     * @param entering 进入为true，返回为false
+     */
+    using FrameHandler = Action (*)(PyCodeObject* code, bool entering);
+
+    /**
+     * @brief 构造函数
+     * @param lineHandler 行事件处理函数
+     * @param frameHandler 函数进入/返回事件处理函数
+     */
+    MonitoringHook(LineHandler lineHandler, FrameHandler frameHandler);
+
+    /**
+     * @brief 析构函数（需持有GIL，解释器已销毁时不访问Python对象）
+     */
+    ~MonitoringHook();
+
+    MonitoringHook(const MonitoringHook&)            = delete;
+    MonitoringHook& operator=(const MonitoringHook&) = delete;
+
+    /**
+     * @brief 申请调试器工具编号并注册回调
+     * @return bool 成功返回true；sys.monitoring不可用或工具编号已被占用时返回false
+     */
+    bool acquire();
+
+    /**
+     * @brief 是否已申请工具编号
+     * @return bool 已申请返回true
+     */
+    bool isAcquired() const { return m_acquired; }
+
+    /**
+     * @brief 设置全局事件
+     * @param stepping true时开启全部行事件和函数返回事件（暂停、单步），
+     *                 false时只开启函数进入事件，用于发现需要插桩的用户代码
+     */
+    void activate(bool stepping);
+
+    /**
+     * @brief 在代码对象上开启行事件（每个代码对象只开启一次）
+     * @param code 代码对象
+     */
+    void arm(PyCodeObject* code);
+
+    /**
+     * @brief 重新开启所有返回过DISABLE的位置（断点或调试状态变化后调用）
+     */
+    void restart();
+
+    /**
+     * @brief 关闭全局事件和所有代码对象上的行事件
+     */
+    void deactivate();
+
+private:
+    /**
+     * @brief 注销回调并释放工具编号
+     */
+    void release();
+
+    static PyObject* lineTrampoline(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+    static PyObject* startTrampoline(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+    static PyObject* returnTrampoline(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+
+    /**
+     * @brief 把处理结果转换为回调返回值
+     * @param action 处理结果
+     * @return PyObject* 新引用
+     */
+    PyObject* result(Action action) const;
+
+private:
+    LineHandler  m_lineHandler;
+    FrameHandler m_frameHandler;
+    bool         m_acquired = false;
+    bool         m_active   = false;
+
+    int m_lineEvent   = 0;
+    int m_startEvent  = 0;
+    int m_returnEvent = 0;
+
+    // sys.monitoring中常用的对象，申请成功后缓存
+    py::object m_monitoring;
+    py::object m_setEvents;
+    py::object m_setLocalEvents;
+    py::object m_restartEvents;
+    py::object m_disable;
+    py::object m_capsule;   // 回调的self参数，指向本对象
+
+    // 已开启行事件的代码对象（持有引用，直到deactivate()）
+    std::vector<py::object> m_armedCode;
+    QSet<PyObject*>         m_armedSet;
+};
@@ -0,0 +1,210 @@
+#include "NativeCall.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+
+NativeThreadPool& NativeThreadPool::instance()
+{
+    static NativeThreadPool instance;
+    return instance;
+}
+
+NativeThreadPool::~NativeThreadPool()
+{
+    shutdown();
+}
+
+void NativeThreadPool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_threads.empty()) {
+            int count = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+            for (int i = 0; i < count; ++i) {
+                m_threads.emplace_back(&NativeThreadPool::workerLoop, this);
+            }
+        }
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void NativeThreadPool::workerLoop()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        // submit()包装的任务自行捕获异常，这里只防止其他任务的异常结束线程
+        try {
+            task();
+        }
+        catch (...) {
+        }
+    }
+}
+
+void NativeThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    const size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1) {
+        body(0, count);
+        return;
+    }
+
+    // 状态由调用线程和池线程共享，池线程可能在调用返回后才取到任务，所以用shared_ptr保持
+    struct State
+    {
+        std::atomic<size_t>     next{0};
+        size_t                  remaining = 0;
+        std::exception_ptr      error;
+        std::mutex              mutex;
+        std::condition_variable done;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->remaining             = chunks;
+
+    // 逐块领取直到领完；出错后领到的块不再运行，只计数
+    auto drain = [state, count, grain, chunks, &body]() {
+        size_t finished = 0;
+        for (size_t chunk = state->next++; chunk < chunks; chunk = state->next++) {
+            bool failed;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                failed = static_cast<bool>(state->error);
+            }
+            if (!failed) {
+                try {
+                    size_t begin = chunk * grain;
+                    body(begin, std::min(begin + grain, count));
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                }
+            }
+            ++finished;
+        }
+
+        if (finished > 0) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->remaining -= finished;
+            if (state->remaining == 0) {
+                state->done.notify_all();
+            }
+        }
+    };
+
+    // 池线程的任务只在块未领完时使用body，调用线程等到所有块完成才返回，body引用始终有效
+    size_t helpers = std::min<size_t>(chunks - 1, static_cast<size_t>(std::max(threadCount(), 2)));
+    for (size_t i = 0; i < helpers; ++i) {
+        post(drain);
+    }
+    drain();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->remaining == 0; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+int NativeThreadPool::threadCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_threads.size());
+}
+
+void NativeThreadPool::shutdown()
+{
+    std::deque<std::function<void()>> pending;
+    std::vector<std::thread>          threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        pending.swap(m_tasks);
+        threads.swap(m_threads);
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+    }
+
+    // 未开始的任务在锁外销毁：其中持有的Future释放时需要获取GIL
+    pending.clear();
+}
+
+namespace NativeCall {
+namespace detail {
+
+GilSafeObject::~GilSafeObject()
+{
+    if (!Py_IsInitialized()) {
+        return;
+    }
+    py::gil_scoped_acquire acquire;
+    Py_XDECREF(m_object);
+}
+
+std::shared_ptr<GilSafeObject> createFuture()
+{
+    // 池线程通过PyGILState获取GIL，只对应主解释器
+    if (PyInterpreterState_Get() != PyInterpreterState_Main()) {
+        throw std::runtime_error("asynchronous native calls are only available in the main interpreter");
+    }
+
+    py::object future = py::module_::import("concurrent.futures").attr("Future")();
+    future.attr("set_running_or_notify_cancel")();
+    return std::make_shared<GilSafeObject>(future);
+}
+
+void failFuture(const std::shared_ptr<GilSafeObject>& future)
+{
+    // 与同步调用相同，经pybind11的异常转换得到Python异常（std::invalid_argument为ValueError等）
+    py::object exception;
+    try {
+        py::detail::try_translate_exceptions();
+        py::error_already_set error;
+        exception = error.value();
+    }
+    catch (py::error_already_set& e) {
+        exception = e.value();
+    }
+    catch (...) {
+        exception = py::reinterpret_borrow<py::object>(PyExc_RuntimeError)("unknown C++ exception");
+    }
+
+    try {
+        future->get().attr("set_exception")(exception);
+    }
+    catch (py::error_already_set& e) {
+        // Future已被结束时只丢弃异常，不能让异常离开池线程
+        e.discard_as_unraisable("NativeCall.failFuture");
+    }
+}
+
+}   // namespace detail
+}   // namespace NativeCall
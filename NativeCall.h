@@ -0,0 +1,273 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+/**
+ * @class NativeThreadPool
+ * @brief 嵌入式C++函数共用的线程池
+ *
+ * 线程在第一次提交任务时启动，数量为CPU核心数。任务中不持有GIL，
+ * 需要访问Python对象时自行获取。所有接口线程安全。
+ */
+class NativeThreadPool
+{
+public:
+    /**
+     * @brief 获取单例实例
+     * @return NativeThreadPool& 单例引用
+     */
+    static NativeThreadPool& instance();
+
+    /**
+     * @brief 提交任务
+     * @param task 任务
+     */
+    void post(std::function<void()> task);
+
+    /**
+     * @brief 把[0, count)分块并行处理，返回前所有块都已完成
+     *
+     * 调用线程也参与处理，在池线程中嵌套调用不会死锁。
+     * 某个块抛出异常时其余未开始的块不再运行，异常在调用线程中重新抛出。
+     * @param count 元素个数
+     * @param grain 每块的元素个数
+     * @param body 处理[begin, end)
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    /**
+     * @brief 线程数
+     * @return int 线程数
+     */
+    int threadCount() const;
+
+    /**
+     * @brief 丢弃未开始的任务并等待运行中的任务结束（解释器销毁前调用，调用前释放GIL）
+     *
+     * 之后再提交任务时重新启动线程。
+     */
+    void shutdown();
+
+private:
+    NativeThreadPool() = default;
+    ~NativeThreadPool();
+
+    void workerLoop();
+
+private:
+    mutable std::mutex                m_mutex;
+    std::condition_variable           m_wake;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::thread>          m_threads;
+    bool                              m_stopping = false;
+};
+
+/**
+ * @brief 嵌入式C++函数的注册辅助
+ *
+ * 注册时声明函数与GIL和线程的关系，而不是在每个函数里手写gil_scoped_release：
+ * - HoldsGil：需要访问Python对象，运行期间持有GIL（pybind11的默认行为）
+ * - ReleasesGil：参数转换为C++类型后释放GIL运行，同一函数的调用互斥执行
+ * - ThreadSafe：释放GIL运行，允许多个Python线程同时调用
+ *
+ * 释放GIL的函数在编译期检查参数中没有Python对象。
+ * defAsync()注册的函数把工作交给NativeThreadPool，立即返回concurrent.futures.Future，
+ * 可以用asyncio.wrap_future()在协程中等待；池线程只能回到主解释器，子解释器中调用时抛出异常。
+ */
+namespace NativeCall {
+
+/**
+ * @brief 函数与GIL和线程的关系
+ */
+enum Threading
+{
+    HoldsGil,
+    ReleasesGil,
+    ThreadSafe
+};
+
+namespace detail {
+
+template <typename Arg>
+constexpr bool isPythonType()
+{
+    return std::is_base_of<py::handle, typename std::decay<Arg>::type>::value;
+}
+
+// 从函数对象或函数指针取出参数和返回类型
+template <typename Func>
+struct Signature : Signature<decltype(&Func::operator())>
+{};
+
+template <typename Result, typename... Args>
+struct Signature<Result (*)(Args...)>
+{
+    using Return = Result;
+
+    static constexpr bool hasPythonArgument() { return (false || ... || isPythonType<Args>()); }
+
+    // 按调用互斥
+    template <typename Func>
+    static auto serialized(Func func)
+    {
+        std::shared_ptr<std::mutex> mutex = std::make_shared<std::mutex>();
+        return [func, mutex](Args... args) -> Result {
+            std::lock_guard<std::mutex> lock(*mutex);
+            return func(std::forward<Args>(args)...);
+        };
+    }
+
+    // 在调用线程中转换参数，复制后交给线程池
+    template <typename Func>
+    static auto deferred(Func func);
+};
+
+template <typename Class, typename Result, typename... Args>
+struct Signature<Result (Class::*)(Args...) const> : Signature<Result (*)(Args...)>
+{};
+
+template <typename Class, typename Result, typename... Args>
+struct Signature<Result (Class::*)(Args...)> : Signature<Result (*)(Args...)>
+{};
+
+/**
+ * @brief 持有Python对象，在任意线程销毁时先获取GIL
+ */
+class GilSafeObject
+{
+public:
+    explicit GilSafeObject(py::object object)
+        : m_object(object.release().ptr())
+    {}
+    ~GilSafeObject();
+
+    GilSafeObject(const GilSafeObject&)            = delete;
+    GilSafeObject& operator=(const GilSafeObject&) = delete;
+
+    py::handle get() const { return m_object; }
+
+private:
+    PyObject* m_object;
+};
+
+/**
+ * @brief 新建一个处于运行状态的concurrent.futures.Future（需持有GIL，只能在主解释器中调用）
+ * @return std::shared_ptr<GilSafeObject> Future对象
+ */
+std::shared_ptr<GilSafeObject> createFuture();
+
+/**
+ * @brief 以当前Python异常或C++异常结束Future（在catch块中调用，需持有GIL）
+ * @param future Future对象
+ */
+void failFuture(const std::shared_ptr<GilSafeObject>& future);
+
+}   // namespace detail
+
+/**
+ * @brief 在线程池中运行工作，返回concurrent.futures.Future（需持有GIL）
+ *
+ * 工作在不持有GIL的池线程中运行，结束后获取GIL把结果转换为Python对象。
+ * 返回的Future已处于运行状态，不能取消。
+ * @param work 工作，返回值需能转换为Python对象
+ * @return py::object Future对象
+ */
+template <typename Work>
+py::object submit(Work work)
+{
+    using Result = decltype(work());
+
+    std::shared_ptr<detail::GilSafeObject> future = detail::createFuture();
+    NativeThreadPool::instance().post([future, work]() mutable {
+        try {
+            if constexpr (std::is_void<Result>::value) {
+                work();
+                py::gil_scoped_acquire acquire;
+                future->get().attr("set_result")(py::none());
+            }
+            else {
+                Result                 value = work();
+                py::gil_scoped_acquire acquire;
+                future->get().attr("set_result")(py::cast(std::move(value)));
+            }
+        }
+        catch (...) {
+            py::gil_scoped_acquire acquire;
+            detail::failFuture(future);
+        }
+    });
+
+    return py::reinterpret_borrow<py::object>(future->get());
+}
+
+template <typename Result, typename... Args>
+template <typename Func>
+auto detail::Signature<Result (*)(Args...)>::deferred(Func func)
+{
+    return [func](Args... args) -> py::object {
+        // 参数按值捕获，调用返回后仍然有效
+        return submit([func, args...]() mutable -> Result { return func(args...); });
+    };
+}
+
+/**
+ * @brief 注册函数
+ * @tparam threading 与GIL和线程的关系
+ * @param m 模块对象
+ * @param name 函数名
+ * @param func 函数对象或函数指针
+ * @param extra 传给pybind11的参数说明、文档字符串等
+ */
+template <Threading threading, typename Func, typename... Extra>
+void def(py::module_& m, const char* name, Func func, const Extra&... extra)
+{
+    using Traits = detail::Signature<typename std::decay<Func>::type>;
+
+    if constexpr (threading == HoldsGil) {
+        m.def(name, func, extra...);
+    }
+    else {
+        static_assert(!Traits::hasPythonArgument(), "functions that release the GIL cannot take Python objects");
+
+        if constexpr (threading == ThreadSafe) {
+            m.def(name, func, py::call_guard<py::gil_scoped_release>(), extra...);
+        }
+        else {
+            // 先释放GIL再等待互斥锁，等待期间其他Python线程照常运行
+            m.def(name, Traits::serialized(func), py::call_guard<py::gil_scoped_release>(), extra...);
+        }
+    }
+}
+
+/**
+ * @brief 注册在线程池中运行的函数：参数在调用线程中转换，立即返回Future
+ * @param m 模块对象
+ * @param name 函数名
+ * @param func 函数对象或函数指针（不能接受Python对象，可以与其他调用同时运行）
+ * @param extra 传给pybind11的参数说明、文档字符串等
+ */
+template <typename Func, typename... Extra>
+void defAsync(py::module_& m, const char* name, Func func, const Extra&... extra)
+{
+    using Traits = detail::Signature<typename std::decay<Func>::type>;
+    static_assert(!Traits::hasPythonArgument(), "functions run on the thread pool cannot take Python objects");
+
+    m.def(name, Traits::deferred(func), extra...);
+}
+
+}   // namespace NativeCall
@@ -0,0 +1,169 @@
+#include "OutlineIndex.h"
+
+namespace {
+
+bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+// 从pos起匹配关键字，后面至少跟一个空白
+bool acceptKeyword(const QString& line, int* pos, QLatin1String keyword)
+{
+    const int end = *pos + keyword.size();
+    if (end >= line.size() || line.midRef(*pos, keyword.size()) != keyword || !line[end].isSpace()) {
+        return false;
+    }
+    *pos = end;
+    while (*pos < line.size() && line[*pos].isSpace()) {
+        ++*pos;
+    }
+    return true;
+}
+
+}   // namespace
+
+OutlineIndex::OutlineIndex()
+    : m_lines(1)
+{
+}
+
+bool OutlineIndex::parseLine(const QString& line, Symbol* symbol)
+{
+    int pos    = 0;
+    int indent = 0;
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+        indent = line[pos] == '\t' ? (indent / 8 + 1) * 8 : indent + 1;
+        ++pos;
+    }
+
+    // 绝大多数行的第一个字符就能排除
+    if (pos >= line.size() || (line[pos] != 'd' && line[pos] != 'c' && line[pos] != 'a')) {
+        return false;
+    }
+    if (line[pos] == 'a' && !acceptKeyword(line, &pos, QLatin1String("async"))) {
+        return false;
+    }
+
+    Kind kind = None;
+    if (acceptKeyword(line, &pos, QLatin1String("def"))) {
+        kind = Function;
+    }
+    else if (acceptKeyword(line, &pos, QLatin1String("class"))) {
+        kind = Class;
+    }
+    else {
+        return false;
+    }
+
+    const int start = pos;
+    if (start >= line.size() || line[start].isDigit()) {
+        return false;
+    }
+    while (pos < line.size() && isIdentifierChar(line[pos])) {
+        ++pos;
+    }
+    if (pos == start) {
+        return false;
+    }
+
+    symbol->column = start;
+    symbol->indent = indent;
+    symbol->kind   = kind;
+    symbol->name   = line.mid(start, pos - start);
+    return true;
+}
+
+void OutlineIndex::reset(const QStringList& lines)
+{
+    m_lines.clear();
+    m_lines.resize(qMax(1, lines.size()));
+    m_symbolCount = 0;
+    for (int i = 0; i < lines.size(); ++i) {
+        if (parseLine(lines[i], &m_lines[i])) {
+            ++m_symbolCount;
+        }
+    }
+}
+
+bool OutlineIndex::update(int firstLine, int removedLines, const QStringList& lines)
+{
+    QVector<Symbol> entries(lines.size());
+    for (int i = 0; i < lines.size(); ++i) {
+        parseLine(lines[i], &entries[i]);
+    }
+
+    // 原位置上的行逐个比较，多出或减少的行只看是否为定义
+    bool      changed = false;
+    const int common  = qMin(removedLines, entries.size());
+    for (int i = 0; i < common; ++i) {
+        Symbol&       old   = m_lines[firstLine + i];
+        const Symbol& entry = entries[i];
+        if (old.kind != entry.kind || old.indent != entry.indent || old.name != entry.name) {
+            changed = true;
+            m_symbolCount += (entry.kind != None) - (old.kind != None);
+        }
+        old = entry;
+    }
+    for (int i = common; i < removedLines; ++i) {
+        if (m_lines[firstLine + i].kind != None) {
+            changed = true;
+            --m_symbolCount;
+        }
+    }
+    for (int i = common; i < entries.size(); ++i) {
+        if (entries[i].kind != None) {
+            changed = true;
+            ++m_symbolCount;
+        }
+    }
+
+    if (removedLines > common) {
+        m_lines.remove(firstLine + common, removedLines - common);
+    }
+    else if (entries.size() > common) {
+        m_lines.insert(firstLine + common, entries.size() - common, Symbol());
+        for (int i = common; i < entries.size(); ++i) {
+            m_lines[firstLine + i] = entries[i];
+        }
+    }
+
+    // 行数变化时之后的定义行号都变了
+    if (removedLines != entries.size() && m_symbolCount > 0) {
+        changed = true;
+    }
+    return changed;
+}
+
+QVector<OutlineIndex::Symbol> OutlineIndex::symbols() const
+{
+    QVector<Symbol> result;
+    result.reserve(m_symbolCount);
+    for (int i = 0; i < m_lines.size(); ++i) {
+        if (m_lines[i].kind != None) {
+            result.append(m_lines[i]);
+            result.last().line = i + 1;
+        }
+    }
+    return result;
+}
+
+bool OutlineIndex::findDefinition(const QString& name, int line, Symbol* symbol) const
+{
+    // 当前行及之前最近的定义，没有时取之后的第一个
+    for (int i = qMin(line, m_lines.size()) - 1; i >= 0; --i) {
+        if (m_lines[i].kind != None && m_lines[i].name == name) {
+            *symbol      = m_lines[i];
+            symbol->line = i + 1;
+            return true;
+        }
+    }
+    for (int i = qMax(0, line); i < m_lines.size(); ++i) {
+        if (m_lines[i].kind != None && m_lines[i].name == name) {
+            *symbol      = m_lines[i];
+            symbol->line = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class OutlineIndex
+ * @brief 编辑缓冲区的大纲：每行是否定义了类或函数
+ *
+ * 按行保存分析结果，编辑时只重新分析被修改的行（由QTextDocument::contentsChange给出），
+ * 插入或删除行时其后的行只移动位置，不重新分析，几千行的脚本中编辑和跳转都不需要扫描整个缓冲区。
+ *
+ * 只识别以def、async def或class开头的行，不跟踪多行字符串，三引号字符串中这样开头的行也会被列出。
+ * 不涉及Python，只在界面线程中使用。
+ */
+class OutlineIndex
+{
+public:
+    enum Kind
+    {
+        None = 0,
+        Class,
+        Function
+    };
+
+    /**
+     * @brief 一个定义
+     */
+    struct Symbol
+    {
+        int     line   = 0;      // 行号，1-based
+        int     column = 0;      // 名字在行中的位置
+        int     indent = 0;      // 缩进宽度（制表符按Python的规则对齐到8的倍数）
+        Kind    kind   = None;
+        QString name;
+    };
+
+    /**
+     * @brief 构造函数（与空文档一样有一个空行）
+     */
+    OutlineIndex();
+
+    /**
+     * @brief 分析一行
+     * @param line 行文本
+     * @param symbol 是定义时输出（不设置行号）
+     * @return bool 是类或函数定义返回true
+     */
+    static bool parseLine(const QString& line, Symbol* symbol);
+
+    /**
+     * @brief 按全部行重建
+     * @param lines 缓冲区的行
+     */
+    void reset(const QStringList& lines);
+
+    /**
+     * @brief 用新的行替换从firstLine起的removedLines行
+     * @param firstLine 第一个被修改的行（0-based）
+     * @param removedLines 被替换的原有行数
+     * @param lines 替换后的行
+     * @return bool 大纲有变化（定义增删改或行号移动）返回true
+     */
+    bool update(int firstLine, int removedLines, const QStringList& lines);
+
+    /**
+     * @brief 已分析的行数
+     */
+    int lineCount() const { return m_lines.size(); }
+
+    /**
+     * @brief 获取所有定义
+     * @return QVector<Symbol> 按行号排列的定义
+     */
+    QVector<Symbol> symbols() const;
+
+    /**
+     * @brief 查找名字的定义，优先取第line行及之前最近的一个
+     * @param name 名字
+     * @param line 当前行号（1-based）
+     * @param symbol 找到时输出定义
+     * @return bool 找到返回true
+     */
+    bool findDefinition(const QString& name, int line, Symbol* symbol) const;
+
+private:
+    QVector<Symbol> m_lines;             // 每行一项，kind为None表示不是定义，line不使用
+    int             m_symbolCount = 0;   // 定义的个数
+};
@@ -0,0 +1,88 @@
+#include "OutlineView.h"
+
+#include <QFont>
+#include <QHeaderView>
+#include <QVector>
+
+namespace {
+
+enum Column
+{
+    NameColumn = 0,
+    LineColumn
+};
+
+const int kPathRole = Qt::UserRole;
+const int kLineRole = Qt::UserRole + 1;
+
+}   // namespace
+
+OutlineView::OutlineView(QWidget* parent)
+    : QTreeWidget(parent)
+{
+    setColumnCount(2);
+    setHeaderLabels({"名称", "行"});
+    setUniformRowHeights(true);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    header()->setStretchLastSection(false);
+    header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    header()->setSectionResizeMode(LineColumn, QHeaderView::ResizeToContents);
+
+    connect(this, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem* item, int) {
+        emit lineActivated(item->data(NameColumn, kLineRole).toInt());
+    });
+    connect(this, &QTreeWidget::itemCollapsed, this, [this](QTreeWidgetItem* item) {
+        m_collapsed.insert(item->data(NameColumn, kPathRole).toString());
+    });
+    connect(this, &QTreeWidget::itemExpanded, this, [this](QTreeWidgetItem* item) {
+        m_collapsed.remove(item->data(NameColumn, kPathRole).toString());
+    });
+}
+
+void OutlineView::setSymbols(const QVector<OutlineIndex::Symbol>& symbols)
+{
+    // 重建期间不重绘，也不记录展开状态的变化
+    setUpdatesEnabled(false);
+    const bool blocked = blockSignals(true);
+    clear();
+
+    // 缩进更深的定义挂在之前最近的缩进更浅的定义下
+    struct Level
+    {
+        int              indent;
+        QTreeWidgetItem* item;
+    };
+    QVector<Level>            stack;
+    QVector<QTreeWidgetItem*> parents;   // 有子节点的定义
+    for (const OutlineIndex::Symbol& symbol : symbols) {
+        while (!stack.isEmpty() && stack.last().indent >= symbol.indent) {
+            stack.removeLast();
+        }
+
+        QTreeWidgetItem* parent = stack.isEmpty() ? invisibleRootItem() : stack.last().item;
+        QTreeWidgetItem* item   = new QTreeWidgetItem(parent);
+        const QString    path   = stack.isEmpty() ? symbol.name
+                                                  : parent->data(NameColumn, kPathRole).toString() + '/' + symbol.name;
+        item->setText(NameColumn, symbol.kind == OutlineIndex::Class ? symbol.name : symbol.name + "()");
+        item->setText(LineColumn, QString::number(symbol.line));
+        item->setTextAlignment(LineColumn, Qt::AlignRight | Qt::AlignVCenter);
+        item->setData(NameColumn, kPathRole, path);
+        item->setData(NameColumn, kLineRole, symbol.line);
+        if (symbol.kind == OutlineIndex::Class) {
+            QFont font = item->font(NameColumn);
+            font.setBold(true);
+            item->setFont(NameColumn, font);
+        }
+        if (!stack.isEmpty() && parent->childCount() == 1) {
+            parents.append(parent);
+        }
+        stack.append(Level{symbol.indent, item});
+    }
+
+    for (QTreeWidgetItem* parent : parents) {
+        parent->setExpanded(!m_collapsed.contains(parent->data(NameColumn, kPathRole).toString()));
+    }
+
+    blockSignals(blocked);
+    setUpdatesEnabled(true);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "OutlineIndex.h"
+
+#include <QSet>
+#include <QTreeWidget>
+
+/**
+ * @class OutlineView
+ * @brief 大纲面板：缓冲区中的类和函数，按缩进嵌套
+ *
+ * 每次大纲变化时整棵树重建，折叠过的节点按路径（外层名字/名字）记住，重建后保持折叠。
+ * 双击或回车跳转到定义所在的行。
+ */
+class OutlineView : public QTreeWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit OutlineView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 显示大纲
+     * @param symbols 按行号排列的定义
+     */
+    void setSymbols(const QVector<OutlineIndex::Symbol>& symbols);
+
+signals:
+    /**
+     * @brief 用户选择某个定义的信号
+     * @param lineNumber 定义所在的行号（1-based）
+     */
+    void lineActivated(int lineNumber);
+
+private:
+    QSet<QString> m_collapsed;   // 折叠的节点路径
+};
@@ -0,0 +1,217 @@
+#include "OutputChannel.h"
+
+#include <QMutexLocker>
+
+#include <cstring>
+
+// 记录格式：长度（4字节）+ 流类型（4字节）+ 数据
+struct RecordHeader
+{
+    quint32 size;
+    quint32 stream;
+};
+
+static int roundUpToPowerOfTwo(int value)
+{
+    int result = 1024;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+OutputChannel::OutputChannel(int capacity)
+    : m_capacity(roundUpToPowerOfTwo(capacity))
+    , m_buffer(new char[m_capacity])
+{}
+
+int OutputChannel::tryWrite(Stream stream, const char* data, int size, bool* wake)
+{
+    const quint64 head    = m_head.load(std::memory_order_relaxed);
+    const quint64 tail    = m_tail.load(std::memory_order_acquire);
+    const int     maxData = m_capacity / 2;
+    int           free    = m_capacity - static_cast<int>(head - tail);
+    int           written = 0;
+    quint64       position = head;
+
+    while (written < size) {
+        int available = free - static_cast<int>(sizeof(RecordHeader));
+        if (available <= 0) {
+            break;
+        }
+
+        int length = qMin(size - written, qMin(available, maxData));
+
+        // 拆分时尽量不截断UTF-8多字节字符；sys.stdout.buffer写入的可能不是UTF-8，
+        // 最多回退3个续字节，连续的非法续字节照常拆分，消费者解码时显示为替换字符
+        if (length < size - written) {
+            int back = 0;
+            while (back < 3 && length - back > 0 &&
+                   (static_cast<uchar>(data[written + length - back]) & 0xC0) == 0x80) {
+                ++back;
+            }
+            if ((static_cast<uchar>(data[written + length - back]) & 0xC0) != 0x80) {
+                length -= back;
+            }
+            if (length == 0) {
+                break;
+            }
+        }
+
+        RecordHeader header{static_cast<quint32>(length), static_cast<quint32>(stream)};
+        copyIn(position, &header, sizeof(header));
+        copyIn(position + sizeof(header), data + written, length);
+
+        position += sizeof(header) + length;
+        free -= static_cast<int>(sizeof(header)) + length;
+        written += length;
+    }
+
+    if (position != head) {
+        m_head.store(position, std::memory_order_release);
+    }
+
+    // 上次取走之后的第一次写入负责通知消费者
+    *wake = written > 0 && !m_wakePending.exchange(true, std::memory_order_acq_rel);
+    return written;
+}
+
+bool OutputChannel::tryWriteAll(Stream stream, const char* data, int size, bool* wake)
+{
+    *wake = false;
+    if (size <= 0 || size > m_capacity / 2) {
+        return false;
+    }
+
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    const quint64 tail = m_tail.load(std::memory_order_acquire);
+    const int     free = m_capacity - static_cast<int>(head - tail);
+    if (free < static_cast<int>(sizeof(RecordHeader)) + size) {
+        return false;
+    }
+
+    // 空间足够时tryWrite写成一条记录
+    return tryWrite(stream, data, size, wake) == size;
+}
+
+void OutputChannel::waitForSpace(int timeoutMs)
+{
+    QMutexLocker locker(&m_spaceMutex);
+    m_producerWaiting.store(true);
+
+    // 设置等待标志后复查，避免与消费者释放空间的时机错过
+    const quint64 used = m_head.load(std::memory_order_relaxed) - m_tail.load();
+    if (static_cast<int>(used) > m_capacity / 2) {
+        m_spaceCondition.wait(&m_spaceMutex, timeoutMs);
+    }
+
+    m_producerWaiting.store(false);
+}
+
+QList<OutputChannel::Chunk> OutputChannel::takeAll()
+{
+    // 先清除通知标志再读取，之后的写入会重新通知
+    m_wakePending.store(false, std::memory_order_release);
+
+    QList<Chunk>  chunks;
+    QByteArray    pending;
+    Stream        pendingStream = StdOut;
+    quint64       tail          = m_tail.load(std::memory_order_relaxed);
+    const quint64 head          = m_head.load(std::memory_order_acquire);
+
+    while (tail != head) {
+        RecordHeader header;
+        copyOut(tail, &header, sizeof(header));
+
+        Stream stream = static_cast<Stream>(header.stream);
+        if (!pending.isEmpty() && stream != pendingStream) {
+            appendDecoded(&chunks, pendingStream, &pending);
+        }
+
+        int offset = pending.size();
+        pending.resize(offset + static_cast<int>(header.size));
+        copyOut(tail + sizeof(header), pending.data() + offset, static_cast<int>(header.size));
+
+        pendingStream = stream;
+        tail += sizeof(header) + header.size;
+    }
+
+    if (!pending.isEmpty()) {
+        appendDecoded(&chunks, pendingStream, &pending);
+    }
+
+    m_tail.store(tail);
+    wakeProducer();
+
+    return chunks;
+}
+
+void OutputChannel::appendDecoded(QList<Chunk>* chunks, Stream stream, QByteArray* bytes)
+{
+    QByteArray& partial = m_partial[stream];
+    if (!partial.isEmpty()) {
+        bytes->prepend(partial);
+        partial.clear();
+    }
+
+    // 末尾不完整的UTF-8字符（写入方分几次写出同一个字符）留到该流的下一批再解码
+    const int limit = qMax(0, bytes->size() - 4);
+    int       lead  = bytes->size() - 1;
+    while (lead > limit && (static_cast<uchar>(bytes->at(lead)) & 0xC0) == 0x80) {
+        --lead;
+    }
+    if (lead >= 0) {
+        const uchar c        = static_cast<uchar>(bytes->at(lead));
+        const int   expected = (c & 0xF8) == 0xF0 ? 4 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xE0) == 0xC0 ? 2 : 1;
+        if (expected > bytes->size() - lead) {
+            partial = bytes->mid(lead);
+            bytes->truncate(lead);
+        }
+    }
+
+    if (!bytes->isEmpty()) {
+        chunks->append({stream, QString::fromUtf8(*bytes)});
+    }
+    bytes->clear();
+}
+
+int OutputChannel::pendingBytes() const
+{
+    return static_cast<int>(m_head.load(std::memory_order_acquire) -
+                            m_tail.load(std::memory_order_acquire));
+}
+
+void OutputChannel::clear()
+{
+    m_wakePending.store(false, std::memory_order_release);
+    for (QByteArray& partial : m_partial) {
+        partial.clear();
+    }
+    m_tail.store(m_head.load(std::memory_order_acquire));
+    wakeProducer();
+}
+
+void OutputChannel::copyIn(quint64 position, const void* data, int size)
+{
+    const int offset = static_cast<int>(position & (m_capacity - 1));
+    const int first  = qMin(size, m_capacity - offset);
+    std::memcpy(m_buffer.get() + offset, data, first);
+    std::memcpy(m_buffer.get(), static_cast<const char*>(data) + first, size - first);
+}
+
+void OutputChannel::copyOut(quint64 position, void* data, int size) const
+{
+    const int offset = static_cast<int>(position & (m_capacity - 1));
+    const int first  = qMin(size, m_capacity - offset);
+    std::memcpy(data, m_buffer.get() + offset, first);
+    std::memcpy(static_cast<char*>(data) + first, m_buffer.get(), size - first);
+}
+
+void OutputChannel::wakeProducer()
+{
+    // 与waitForSpace中的标志设置配对（顺序一致），保证不会丢失唤醒
+    if (m_producerWaiting.load()) {
+        QMutexLocker locker(&m_spaceMutex);
+        m_spaceCondition.wakeAll();
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class OutputChannel
+ * @brief Python输出的单生产者单消费者环形缓冲区
+ *
+ * 运行线程（生产者）把sys.stdout/sys.stderr的写入按记录拷贝进固定大小的环形缓冲区，
+ * 界面线程（消费者）按帧整批取出，一次插入到输出窗口：
+ * - 写入路径无锁、不分配内存，只在缓冲区满时才等待
+ * - 每次取走数据后第一次写入才需要通知消费者，通知天然合并
+ * - 缓冲区满时生产者阻塞等待，消费者跟不上时反压到Python代码
+ * - 缓冲区中保存原始字节（sys.stdout.buffer可以写入任意字节），只在取出时按UTF-8解码；
+ *   跨批次的不完整字符留到下一批再解码
+ */
+class OutputChannel
+{
+public:
+    /**
+     * @brief 输出流类型
+     */
+    enum Stream
+    {
+        StdOut = 0,   // 标准输出
+        StdErr = 1,   // 标准错误
+        Log    = 2    // 日志点输出
+    };
+
+    /**
+     * @brief 一段连续的同类输出
+     */
+    struct Chunk
+    {
+        Stream  stream;
+        QString text;
+    };
+
+    /**
+     * @brief 构造函数
+     * @param capacity 缓冲区字节数（向上取整为2的幂）
+     */
+    explicit OutputChannel(int capacity = 1 << 20);
+
+    /**
+     * @brief 尽量写入数据（生产者调用，不阻塞）
+     *
+     * 单次写入超过缓冲区一半时会在UTF-8字符边界处拆分成多条记录。
+     * @param stream 输出流
+     * @param data 数据（通常为UTF-8）
+     * @param size 字节数
+     * @param wake 输出参数，需要通知消费者时置为true
+     * @return int 实际写入的字节数，缓冲区满时可能小于size
+     */
+    int tryWrite(Stream stream, const char* data, int size, bool* wake);
+
+    /**
+     * @brief 整条写入或不写入（生产者调用，不阻塞）
+     *
+     * 用于允许丢弃的输出（日志点），缓冲区放不下整条记录时直接返回false，不拆分也不等待。
+     * @param stream 输出流
+     * @param data UTF-8数据
+     * @param size 字节数，不超过缓冲区的一半
+     * @param wake 输出参数，需要通知消费者时置为true
+     * @return bool 写入返回true
+     */
+    bool tryWriteAll(Stream stream, const char* data, int size, bool* wake);
+
+    /**
+     * @brief 等待缓冲区出现空闲空间（生产者调用）
+     * @param timeoutMs 最长等待毫秒数
+     */
+    void waitForSpace(int timeoutMs);
+
+    /**
+     * @brief 取出全部已写入的数据（消费者调用）
+     *
+     * 相邻的同类记录合并为一段，调用方每批只需插入一次。
+     * @return QList<Chunk> 输出段列表
+     */
+    QList<Chunk> takeAll();
+
+    /**
+     * @brief 获取尚未取走的字节数
+     * @return int 字节数
+     */
+    int pendingBytes() const;
+
+    /**
+     * @brief 是否超过高水位（此时消费者应立即取走数据，而不是等到下一帧）
+     * @return bool 超过缓冲区四分之一时返回true
+     */
+    bool isAboveHighWatermark() const { return pendingBytes() >= m_capacity / 4; }
+
+    /**
+     * @brief 丢弃全部未取走的数据并唤醒等待的生产者
+     */
+    void clear();
+
+private:
+    /**
+     * @brief 拷贝数据到缓冲区（处理回绕）
+     * @param position 逻辑写入位置
+     * @param data 数据
+     * @param size 字节数
+     */
+    void copyIn(quint64 position, const void* data, int size);
+
+    /**
+     * @brief 从缓冲区拷贝数据（处理回绕）
+     * @param position 逻辑读取位置
+     * @param data 目标地址
+     * @param size 字节数
+     */
+    void copyOut(quint64 position, void* data, int size) const;
+
+    /**
+     * @brief 解码一段同类输出并加入结果，末尾不完整的UTF-8字符留到下一批（消费者调用）
+     * @param chunks 结果列表
+     * @param stream 输出流
+     * @param bytes 原始字节，调用后清空
+     */
+    void appendDecoded(QList<Chunk>* chunks, Stream stream, QByteArray* bytes);
+
+    /**
+     * @brief 通知等待空间的生产者
+     */
+    void wakeProducer();
+
+private:
+    const int               m_capacity;   // 2的幂
+    std::unique_ptr<char[]> m_buffer;
+
+    // 逻辑位置单调递增，取模得到实际偏移
+    std::atomic<quint64> m_head{0};   // 写入位置，只有生产者修改
+    std::atomic<quint64> m_tail{0};   // 读取位置，只有消费者修改
+
+    std::atomic<bool> m_wakePending{false};      // 已通知消费者但尚未取走
+    std::atomic<bool> m_producerWaiting{false};  // 生产者正在等待空间
+
+    // 每个流尚未解码的不完整字符，只在消费者中使用
+    QByteArray m_partial[Log + 1];
+
+    // 只在缓冲区满时使用
+    QMutex         m_spaceMutex;
+    QWaitCondition m_spaceCondition;
+};
@@ -0,0 +1,499 @@
+#include "OutputConsole.h"
+#include "OutputLog.h"
+
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include <algorithm>
+
+// 单个块的容量，达到任一上限后新行写入新块
+static const int kChunkChars = 16 * 1024;
+static const int kChunkLines = 1024;
+
+// 文本左侧留白
+static const int kMargin = 4;
+
+OutputConsole::OutputConsole(QWidget* parent)
+    : QAbstractScrollArea(parent)
+{
+    QFont font("Consolas");
+    font.setStyleHint(QFont::Monospace);
+    font.setFixedPitch(true);
+    setFont(font);
+
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    QFontMetrics metrics(this->font());
+    m_lineHeight = qMax(1, metrics.lineSpacing());
+    m_charWidth  = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+
+    updateScrollBars();
+}
+
+void OutputConsole::appendText(const QString& text, LineStyle style)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+
+    QScrollBar* vbar     = verticalScrollBar();
+    bool        atBottom = vbar->value() >= vbar->maximum();
+
+    const QChar* data  = text.constData();
+    const int    size  = text.size();
+    int          start = 0;
+
+    while (start < size) {
+        int newline = text.indexOf(QLatin1Char('\n'), start);
+        int end     = newline < 0 ? size : newline;
+        int length  = end - start;
+        if (newline >= 0 && length > 0 && data[end - 1] == QLatin1Char('\r')) {
+            --length;
+        }
+
+        // 最后一行未结束且样式相同时接着写，否则另起一行
+        bool continueLine = m_lineOpen && !m_chunks.empty() &&
+                            m_chunks.back().lines.last().style == style;
+
+        if (newline < 0) {
+            appendSegment(data + start, length, style, !continueLine);
+            m_lineOpen = true;
+            break;
+        }
+
+        appendSegment(data + start, length, style, !continueLine);
+        m_lineOpen = false;
+        start      = newline + 1;
+    }
+
+    trimToMaxLines();
+    updateScrollBars();
+
+    if (atBottom) {
+        vbar->setValue(vbar->maximum());
+    }
+    viewport()->update();
+}
+
+void OutputConsole::appendLine(const QString& text, LineStyle style)
+{
+    // 结束未完成的行，保证整行从行首开始
+    m_lineOpen = false;
+    appendText(text + QLatin1Char('\n'), style);
+}
+
+void OutputConsole::clear()
+{
+    m_chunks.clear();
+    m_lineCount       = 0;
+    m_maxLineLength   = 0;
+    m_lineOpen        = false;
+    m_selectionAnchor = -1;
+    m_selectionEnd    = -1;
+    m_matches.clear();
+    m_currentMatch = -1;
+
+    // 行号从0重新开始，换一个溢出文件；旧文件在仍在使用它的快照释放后删除
+    m_spill.reset();
+
+    updateScrollBars();
+    viewport()->update();
+}
+
+void OutputConsole::setMaxLines(int lines)
+{
+    m_maxLines = qMax(kChunkLines, lines);
+    trimToMaxLines();
+    updateScrollBars();
+    viewport()->update();
+}
+
+QString OutputConsole::lineText(int line) const
+{
+    int          index = 0;
+    const Chunk* chunk = chunkForLine(line, &index);
+    if (!chunk) {
+        return QString();
+    }
+
+    const LineRecord& record = chunk->lines.at(index);
+    return chunk->text.mid(record.offset, record.length);
+}
+
+void OutputConsole::setPlaceholderText(const QString& text)
+{
+    m_placeholderText = text;
+    viewport()->update();
+}
+
+void OutputConsole::setSpillEnabled(bool enabled)
+{
+    m_spillEnabled = enabled;
+}
+
+OutputLog OutputConsole::snapshot() const
+{
+    OutputLog log;
+    if (m_spill) {
+        m_spill->flush();
+        log.m_spill       = m_spill;
+        log.m_spillBlocks = m_spill->blocks();
+        log.m_spillBytes  = m_spill->size();
+        log.m_spillLines  = m_spill->lineCount();
+    }
+    log.m_chunks    = m_chunks;
+    log.m_firstLine = firstLineNumber();
+    return log;
+}
+
+void OutputConsole::setSearchText(const QString& text, Qt::CaseSensitivity sensitivity)
+{
+    m_searchText        = text;
+    m_searchSensitivity = sensitivity;
+    m_matches.clear();
+    m_currentMatch = -1;
+    viewport()->update();
+}
+
+void OutputConsole::addMatches(const QVector<int>& lines)
+{
+    m_matches += lines;
+    viewport()->update();
+}
+
+bool OutputConsole::showMatch(int index)
+{
+    if (index < 0 || index >= m_matches.size()) {
+        return false;
+    }
+    m_currentMatch = index;
+
+    const int line = m_matches.at(index) - firstLineNumber();
+    if (line < 0 || line >= m_lineCount) {
+        viewport()->update();
+        return false;
+    }
+
+    // 结果行不在可见范围内时滚动到视图的三分之一处
+    QScrollBar* vbar        = verticalScrollBar();
+    const int   visibleRows = qMax(1, viewport()->height() / m_lineHeight);
+    if (line < vbar->value() || line >= vbar->value() + visibleRows) {
+        vbar->setValue(line - visibleRows / 3);
+    }
+
+    // 匹配文字在水平方向上不可见时滚动过去
+    const int column = lineText(line).indexOf(m_searchText, 0, m_searchSensitivity);
+    if (column >= 0) {
+        QScrollBar* hbar  = horizontalScrollBar();
+        const int   left  = column * m_charWidth;
+        const int   right = (column + m_searchText.size()) * m_charWidth + 2 * kMargin;
+        if (left < hbar->value() || right > hbar->value() + viewport()->width()) {
+            hbar->setValue(left - viewport()->width() / 3);
+        }
+    }
+    viewport()->update();
+    return true;
+}
+
+void OutputConsole::copy()
+{
+    int first = 0;
+    int last  = m_lineCount - 1;
+    if (m_selectionAnchor >= 0) {
+        first = qMax(first, qMin(m_selectionAnchor, m_selectionEnd) - firstLineNumber());
+        last  = qMin(last, qMax(m_selectionAnchor, m_selectionEnd) - firstLineNumber());
+    }
+
+    QStringList lines;
+    for (int line = first; line <= last; ++line) {
+        lines.append(lineText(line));
+    }
+
+    QGuiApplication::clipboard()->setText(lines.join(QLatin1Char('\n')));
+}
+
+void OutputConsole::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), QColor("#f8f8f8"));
+    painter.setFont(font());
+
+    if (m_lineCount == 0) {
+        painter.setPen(Qt::gray);
+        painter.drawText(viewport()->rect().adjusted(kMargin, kMargin, -kMargin, -kMargin),
+                         Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap,
+                         m_placeholderText);
+        return;
+    }
+
+    const int firstRow     = verticalScrollBar()->value();
+    const int rowCount     = viewport()->height() / m_lineHeight + 2;
+    const int xOffset      = horizontalScrollBar()->value();
+    const int firstChar    = xOffset / m_charWidth;
+    const int visibleChars = viewport()->width() / m_charWidth + 2;
+    const int textX        = kMargin - xOffset % m_charWidth;
+    const int ascent       = fontMetrics().ascent();
+
+    int selectionFirst = -1;
+    int selectionLast  = -1;
+    if (m_selectionAnchor >= 0) {
+        selectionFirst = qMin(m_selectionAnchor, m_selectionEnd) - firstLineNumber();
+        selectionLast  = qMax(m_selectionAnchor, m_selectionEnd) - firstLineNumber();
+    }
+
+    const QColor selectionColor = palette().color(QPalette::Highlight).lighter(170);
+    const int    currentLine    = m_currentMatch >= 0 ? m_matches.at(m_currentMatch) - firstLineNumber() : -1;
+
+    // 只绘制可见行，每行只截取可见范围内的字符
+    for (int row = 0; row < rowCount && firstRow + row < m_lineCount; ++row) {
+        const int    line  = firstRow + row;
+        int          index = 0;
+        const Chunk* chunk = chunkForLine(line, &index);
+        if (!chunk) {
+            break;
+        }
+
+        const LineRecord& record = chunk->lines.at(index);
+        const int         y      = row * m_lineHeight;
+
+        if (line >= selectionFirst && line <= selectionLast) {
+            painter.fillRect(0, y, viewport()->width(), m_lineHeight, selectionColor);
+        }
+        else if (line == currentLine) {
+            painter.fillRect(0, y, viewport()->width(), m_lineHeight, QColor("#fff3c4"));
+        }
+        if (!m_searchText.isEmpty()) {
+            paintSearchText(painter, chunk->text.constData() + record.offset, record.length, firstChar, visibleChars, y);
+        }
+
+        if (record.length > firstChar) {
+            QString visible = QString::fromRawData(chunk->text.constData() + record.offset + firstChar,
+                                                   qMin(record.length - firstChar, visibleChars));
+            painter.setPen(colorForStyle(record.style));
+            painter.drawText(textX, y + ascent, visible);
+        }
+    }
+}
+
+void OutputConsole::paintSearchText(
+    QPainter& painter, const QChar* text, int length, int firstChar, int visibleChars, int y) const
+{
+    // 只在可见字符前后一个搜索文字长度的范围内查找，很长的行也只处理可见的部分
+    const int patternLength = m_searchText.size();
+    const int from          = qMax(0, firstChar - patternLength + 1);
+    const int to            = qMin(length, firstChar + visibleChars + patternLength);
+    if (from >= to) {
+        return;
+    }
+
+    const QString window  = QString::fromRawData(text + from, to - from);
+    const int     xOffset = horizontalScrollBar()->value();
+    const QColor  color("#ffd54f");
+
+    int column = window.indexOf(m_searchText, 0, m_searchSensitivity);
+    while (column >= 0) {
+        const int x = kMargin + (from + column) * m_charWidth - xOffset;
+        painter.fillRect(x, y, patternLength * m_charWidth, m_lineHeight, color);
+        column = window.indexOf(m_searchText, column + patternLength, m_searchSensitivity);
+    }
+}
+
+void OutputConsole::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void OutputConsole::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton || m_lineCount == 0) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+
+    int line = lineAt(event->pos().y()) + firstLineNumber();
+    if (!(event->modifiers() & Qt::ShiftModifier) || m_selectionAnchor < 0) {
+        m_selectionAnchor = line;
+    }
+    m_selectionEnd = line;
+    viewport()->update();
+}
+
+void OutputConsole::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || m_selectionAnchor < 0) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+
+    m_selectionEnd = lineAt(event->pos().y()) + firstLineNumber();
+    viewport()->update();
+}
+
+void OutputConsole::keyPressEvent(QKeyEvent* event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        copy();
+        return;
+    }
+
+    if (event->matches(QKeySequence::SelectAll)) {
+        if (m_lineCount > 0) {
+            m_selectionAnchor = firstLineNumber();
+            m_selectionEnd    = firstLineNumber() + m_lineCount - 1;
+            viewport()->update();
+        }
+        return;
+    }
+
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void OutputConsole::changeEvent(QEvent* event)
+{
+    QAbstractScrollArea::changeEvent(event);
+
+    if (event->type() == QEvent::FontChange) {
+        QFontMetrics metrics(font());
+        m_lineHeight = qMax(1, metrics.lineSpacing());
+        m_charWidth  = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+void OutputConsole::appendSegment(const QChar* text, int length, LineStyle style, bool newLine)
+{
+    if (newLine) {
+        if (m_chunks.empty() || m_chunks.back().text.size() >= kChunkChars ||
+            m_chunks.back().lines.size() >= kChunkLines) {
+            Chunk chunk;
+            chunk.firstLine =
+                m_chunks.empty() ? 0 : m_chunks.back().firstLine + m_chunks.back().lines.size();
+            chunk.text.reserve(kChunkChars);
+            chunk.lines.reserve(kChunkLines);
+            m_chunks.push_back(std::move(chunk));
+        }
+
+        Chunk& chunk = m_chunks.back();
+        chunk.lines.append({chunk.text.size(), 0, style});
+        ++m_lineCount;
+    }
+
+    Chunk&      chunk  = m_chunks.back();
+    LineRecord& record = chunk.lines.last();
+    chunk.text.append(text, length);
+    record.length += length;
+    m_maxLineLength = qMax(m_maxLineLength, record.length);
+}
+
+void OutputConsole::trimToMaxLines()
+{
+    int removed = 0;
+
+    // 整块丢弃，最后一块始终保留
+    while (m_chunks.size() > 1 && m_lineCount - m_chunks.front().lines.size() >= m_maxLines) {
+        if (m_spillEnabled) {
+            spillChunk(m_chunks.front());
+        }
+        removed += m_chunks.front().lines.size();
+        m_lineCount -= m_chunks.front().lines.size();
+        m_chunks.pop_front();
+    }
+
+    if (removed == 0) {
+        return;
+    }
+
+    // 重新统计最长行（丢弃块的频率很低）
+    m_maxLineLength = 0;
+    for (const Chunk& chunk : m_chunks) {
+        for (const LineRecord& record : chunk.lines) {
+            m_maxLineLength = qMax(m_maxLineLength, record.length);
+        }
+    }
+
+    // 保持视图停留在同一段内容上
+    QScrollBar* vbar = verticalScrollBar();
+    vbar->setValue(qMax(0, vbar->value() - removed));
+}
+
+void OutputConsole::spillChunk(const Chunk& chunk)
+{
+    if (!m_spill) {
+        m_spill = std::make_shared<OutputSpill>();
+    }
+
+    // 每行以换行符结束，导出时可以原样复制
+    QByteArray data;
+    data.reserve(chunk.text.size() + chunk.lines.size());
+    for (const LineRecord& record : chunk.lines) {
+        data.append(QStringView(chunk.text).mid(record.offset, record.length).toUtf8());
+        data.append('\n');
+    }
+    m_spill->append(chunk.firstLine, chunk.lines.size(), data);
+}
+
+void OutputConsole::updateScrollBars()
+{
+    const int visibleRows = qMax(1, viewport()->height() / m_lineHeight);
+
+    QScrollBar* vbar = verticalScrollBar();
+    vbar->setRange(0, qMax(0, m_lineCount - visibleRows));
+    vbar->setPageStep(visibleRows);
+    vbar->setSingleStep(1);
+
+    const int contentWidth = m_maxLineLength * m_charWidth + 2 * kMargin;
+
+    QScrollBar* hbar = horizontalScrollBar();
+    hbar->setRange(0, qMax(0, contentWidth - viewport()->width()));
+    hbar->setPageStep(viewport()->width());
+    hbar->setSingleStep(m_charWidth);
+}
+
+const OutputConsole::Chunk* OutputConsole::chunkForLine(int line, int* indexInChunk) const
+{
+    if (line < 0 || line >= m_lineCount) {
+        return nullptr;
+    }
+
+    const int absolute = firstLineNumber() + line;
+
+    // 块按第一行序号递增排列，二分查找所在块
+    auto it = std::upper_bound(m_chunks.begin(),
+                               m_chunks.end(),
+                               absolute,
+                               [](int value, const Chunk& chunk) { return value < chunk.firstLine; });
+    --it;
+
+    *indexInChunk = absolute - it->firstLine;
+    return &*it;
+}
+
+QColor OutputConsole::colorForStyle(LineStyle style) const
+{
+    switch (style) {
+    case StdErr:
+        return QColor("#b22222");
+    case Error:
+        return Qt::red;
+    case Log:
+        return QColor("#1e6fb8");
+    case Normal:
+    default:
+        return Qt::black;
+    }
+}
+
+int OutputConsole::lineAt(int y) const
+{
+    int line = verticalScrollBar()->value() + y / m_lineHeight;
+    return qBound(0, line, qMax(0, m_lineCount - 1));
+}
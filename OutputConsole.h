@@ -0,0 +1,265 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include <QString>
+#include <QVector>
+
+#include <deque>
+#include <memory>
+
+class OutputLog;
+class OutputSpill;
+class QPainter;
+
+/**
+ * @class OutputConsole
+ * @brief 虚拟化的输出窗口
+ *
+ * 替代QTextEdit显示Python输出：
+ * - 文本按行存放在分块缓冲区中，每行只记录偏移、长度和样式
+ * - 行数超过上限时整块丢弃最旧的输出，内存占用有界
+ * - 所有行等高，绘制时只处理可见行，与总行数无关
+ * - 样式（标准输出、标准错误、错误提示）按行保存，不依赖富文本格式
+ * - 开启溢出到磁盘后丢弃的块写入临时文件，导出和搜索仍能覆盖全部输出（见OutputLog）
+ * - 搜索结果按绝对行号分批加入，可见行中匹配的文字高亮，当前结果所在行另外标出
+ */
+class OutputConsole : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 行样式
+     */
+    enum LineStyle : quint8
+    {
+        Normal = 0,   // 标准输出
+        StdErr = 1,   // 标准错误
+        Error  = 2,   // 运行器报告的错误
+        Log    = 3    // 日志点输出
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit OutputConsole(QWidget* parent = nullptr);
+
+    /**
+     * @brief 追加文本（按换行符拆分，最后一行未结束时后续文本继续追加到该行）
+     * @param text 文本
+     * @param style 行样式
+     */
+    void appendText(const QString& text, LineStyle style = Normal);
+
+    /**
+     * @brief 追加完整的一行
+     * @param text 文本
+     * @param style 行样式
+     */
+    void appendLine(const QString& text, LineStyle style = Normal);
+
+    /**
+     * @brief 清空全部输出
+     */
+    void clear();
+
+    /**
+     * @brief 设置最多保留的行数
+     * @param lines 行数上限
+     */
+    void setMaxLines(int lines);
+
+    /**
+     * @brief 获取当前保留的行数
+     * @return int 行数
+     */
+    int lineCount() const { return m_lineCount; }
+
+    /**
+     * @brief 获取指定行的文本
+     * @param line 行索引（0-based）
+     * @return QString 文本
+     */
+    QString lineText(int line) const;
+
+    /**
+     * @brief 设置无输出时显示的提示文本
+     * @param text 提示文本
+     */
+    void setPlaceholderText(const QString& text);
+
+    /**
+     * @brief 设置超过行数上限的输出是否写入临时文件（清空后生效）
+     * @param enabled 开启为true
+     */
+    void setSpillEnabled(bool enabled);
+
+    /**
+     * @brief 取得全部输出的快照（溢出文件和内存中的行），供后台线程导出和搜索
+     * @return OutputLog 快照，不复制文本
+     */
+    OutputLog snapshot() const;
+
+    /**
+     * @brief 第一条保留行的绝对行号（清空以来的序号，从0开始）
+     * @return int 绝对行号
+     */
+    int firstLineNumber() const { return m_chunks.empty() ? 0 : m_chunks.front().firstLine; }
+
+    /**
+     * @brief 设置高亮的搜索文字并清除已有的搜索结果
+     * @param text 搜索文字，为空时不高亮
+     * @param sensitivity 是否区分大小写
+     */
+    void setSearchText(const QString& text, Qt::CaseSensitivity sensitivity);
+
+    /**
+     * @brief 追加一批搜索结果
+     * @param lines 匹配行的绝对行号，按递增顺序
+     */
+    void addMatches(const QVector<int>& lines);
+
+    /**
+     * @brief 搜索结果数
+     * @return int 数量
+     */
+    int matchCount() const { return m_matches.size(); }
+
+    /**
+     * @brief 搜索结果所在的行
+     * @param index 结果序号
+     * @return int 绝对行号
+     */
+    int matchLine(int index) const { return m_matches.at(index); }
+
+    /**
+     * @brief 标出当前搜索结果，所在行仍在窗口中时滚动过去
+     * @param index 结果序号
+     * @return bool 所在行仍在窗口中返回true，已移出时返回false
+     */
+    bool showMatch(int index);
+
+public slots:
+    /**
+     * @brief 复制选中的行（未选中时复制全部）到剪贴板
+     */
+    void copy();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void changeEvent(QEvent* event) override;
+
+private:
+    friend class OutputLog;
+
+    /**
+     * @brief 行记录
+     */
+    struct LineRecord
+    {
+        int       offset;   // 在所属块文本中的起始位置
+        int       length;   // 字符数
+        LineStyle style;
+    };
+
+    /**
+     * @brief 文本块，块内各行的文本连续存放
+     */
+    struct Chunk
+    {
+        int                 firstLine = 0;   // 第一行的绝对序号（自清空以来单调递增）
+        QString             text;
+        QVector<LineRecord> lines;
+    };
+
+    /**
+     * @brief 追加一段不含换行符的文本
+     * @param text 文本起始地址
+     * @param length 字符数
+     * @param style 行样式
+     * @param newLine true表示开始新行，false表示接到最后一行末尾
+     */
+    void appendSegment(const QChar* text, int length, LineStyle style, bool newLine);
+
+    /**
+     * @brief 行数超过上限时丢弃最旧的块
+     */
+    void trimToMaxLines();
+
+    /**
+     * @brief 根据行数和最长行更新滚动条范围
+     */
+    void updateScrollBars();
+
+    /**
+     * @brief 查找行所在的块
+     * @param line 行索引（0-based，相对于当前保留的第一行）
+     * @param indexInChunk 输出参数，行在块内的索引
+     * @return const Chunk* 所在块，越界时为nullptr
+     */
+    const Chunk* chunkForLine(int line, int* indexInChunk) const;
+
+    /**
+     * @brief 获取行的样式对应的颜色
+     * @param style 行样式
+     * @return QColor 文本颜色
+     */
+    QColor colorForStyle(LineStyle style) const;
+
+    /**
+     * @brief 视口坐标对应的行索引
+     * @param y 视口纵坐标
+     * @return int 行索引（已限制在有效范围内）
+     */
+    int lineAt(int y) const;
+
+    /**
+     * @brief 把要丢弃的块写入溢出文件
+     * @param chunk 块
+     */
+    void spillChunk(const Chunk& chunk);
+
+    /**
+     * @brief 在可见行中高亮搜索文字
+     * @param painter 画笔
+     * @param text 行文本
+     * @param length 行的字符数
+     * @param firstChar 第一个可见字符
+     * @param visibleChars 可见字符数
+     * @param y 行的纵坐标
+     */
+    void
+    paintSearchText(QPainter& painter, const QChar* text, int length, int firstChar, int visibleChars, int y) const;
+
+private:
+    std::deque<Chunk> m_chunks;
+    int               m_lineCount     = 0;
+    int               m_maxLines      = 100000;
+    int               m_maxLineLength = 0;   // 最长行的字符数，用于水平滚动范围
+    bool              m_lineOpen      = false;   // 最后一行是否还未遇到换行符
+
+    int m_lineHeight = 1;
+    int m_charWidth  = 1;
+
+    // 行选择（按整行，绝对序号），-1表示无选择
+    int m_selectionAnchor = -1;
+    int m_selectionEnd    = -1;
+
+    QString m_placeholderText;
+
+    // 溢出到磁盘
+    bool                         m_spillEnabled = false;
+    std::shared_ptr<OutputSpill> m_spill;   // 清空时替换，快照持有旧文件直到用完
+
+    // 搜索
+    QString             m_searchText;
+    Qt::CaseSensitivity m_searchSensitivity = Qt::CaseInsensitive;
+    QVector<int>        m_matches;            // 匹配行的绝对行号，递增
+    int                 m_currentMatch = -1;
+};
@@ -0,0 +1,312 @@
+#include "OutputLog.h"
+
+#include <QDir>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+
+// 读取溢出文件和写出导出文件的块大小，gzip每块压缩为一个成员
+static const qint64 kBlockBytes = 1024 * 1024;
+
+// 每写出这么多行报告一次进度
+static const qint64 kProgressLines = 64 * 1024;
+
+// gzip成员头部：标识、deflate、无标志、无时间、无额外标志、未知系统
+static const char kGzipHeader[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff'};
+
+// gzip尾部使用的CRC-32（多项式0xEDB88320）
+static quint32 crc32(const QByteArray& data)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> values{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[i] = c;
+        }
+        return values;
+    }();
+
+    quint32 c = 0xFFFFFFFFu;
+    for (const char byte : data) {
+        c = table[(c ^ static_cast<uchar>(byte)) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+// 把一块数据压缩为一个gzip成员：qCompress()的结果是4字节长度、2字节zlib头、deflate数据和4字节Adler-32，
+// 取出其中的deflate数据，加上gzip的头部和尾部；多个成员首尾相接仍是合法的gzip文件
+static QByteArray gzipMember(const QByteArray& data)
+{
+    const QByteArray zlib = qCompress(data, 6);
+    if (zlib.size() < 10) {
+        return QByteArray();
+    }
+
+    QByteArray member;
+    member.reserve(zlib.size() + 12);
+    member.append(kGzipHeader, sizeof(kGzipHeader));
+    member.append(zlib.constData() + 6, zlib.size() - 10);
+
+    uchar trailer[8];
+    qToLittleEndian<quint32>(crc32(data), trailer);
+    qToLittleEndian<quint32>(static_cast<quint32>(data.size()), trailer + 4);
+    member.append(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+    return member;
+}
+
+OutputSpill::OutputSpill()
+    : m_file(QDir::temp().filePath("qtpythonembed-output-XXXXXX.log"))
+{
+    m_valid = m_file.open();
+}
+
+bool OutputSpill::append(int firstLine, int lineCount, const QByteArray& data)
+{
+    if (!m_valid) {
+        return false;
+    }
+    if (m_file.write(data) != data.size()) {
+        m_valid = false;
+        return false;
+    }
+
+    m_blocks.append({firstLine, m_size});
+    m_size += data.size();
+    m_lineCount += lineCount;
+    return true;
+}
+
+void OutputSpill::flush()
+{
+    if (m_valid) {
+        m_file.flush();
+    }
+}
+
+int OutputLog::firstLine() const
+{
+    return m_spillBlocks.isEmpty() ? m_firstLine : m_spillBlocks.first().firstLine;
+}
+
+qint64 OutputLog::lineCount() const
+{
+    qint64 count = m_spillLines;
+    for (const OutputConsole::Chunk& chunk : m_chunks) {
+        count += chunk.lines.size();
+    }
+    return count;
+}
+
+int OutputLog::droppedLines() const
+{
+    return m_firstLine - m_spillLines;
+}
+
+bool OutputLog::openSpill(QFile* file, QString* error) const
+{
+    file->setFileName(m_spill->fileName());
+    if (!file->open(QIODevice::ReadOnly)) {
+        *error = QString("无法读取输出溢出文件%1：%2").arg(file->fileName(), file->errorString());
+        return false;
+    }
+    return true;
+}
+
+bool OutputLog::forEachLine(const LineVisitor& visitor, QString* error) const
+{
+    // 溢出文件：每次读1MB，跨越读取边界的行留到下一次拼接
+    if (m_spillBytes > 0) {
+        QFile file;
+        if (!openSpill(&file, error)) {
+            return false;
+        }
+
+        int        blockIndex = 0;
+        int        line       = 0;
+        qint64     position   = 0;
+        QByteArray pending;
+        while (position < m_spillBytes) {
+            QByteArray data = file.read(qMin(kBlockBytes, m_spillBytes - position));
+            if (data.isEmpty()) {
+                *error = QString("无法读取输出溢出文件%1：%2").arg(file.fileName(), file.errorString());
+                return false;
+            }
+
+            int start = 0;
+            while (true) {
+                const int newline = data.indexOf('\n', start);
+                if (newline < 0) {
+                    pending.append(data.constData() + start, data.size() - start);
+                    break;
+                }
+
+                // 每块从行首开始，读到块的起点时行号取索引中的值
+                const qint64 lineOffset = position - pending.size() + start;
+                while (blockIndex < m_spillBlocks.size() && m_spillBlocks[blockIndex].offset <= lineOffset) {
+                    line = m_spillBlocks[blockIndex].firstLine;
+                    ++blockIndex;
+                }
+
+                QString text;
+                if (pending.isEmpty()) {
+                    text = QString::fromUtf8(data.constData() + start, newline - start);
+                }
+                else {
+                    pending.append(data.constData() + start, newline - start);
+                    text = QString::fromUtf8(pending);
+                    pending.clear();
+                }
+                if (!visitor(line++, text)) {
+                    return true;
+                }
+                start = newline + 1;
+            }
+            position += data.size();
+        }
+    }
+
+    // 内存中的行
+    for (const OutputConsole::Chunk& chunk : m_chunks) {
+        for (int i = 0; i < chunk.lines.size(); ++i) {
+            const OutputConsole::LineRecord& record = chunk.lines.at(i);
+            if (!visitor(chunk.firstLine + i, chunk.text.mid(record.offset, record.length))) {
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+QString OutputLog::lineText(int line) const
+{
+    if (line >= m_firstLine) {
+        auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), line,
+                                   [](int value, const OutputConsole::Chunk& chunk) { return value < chunk.firstLine; });
+        if (it == m_chunks.begin()) {
+            return QString();
+        }
+        --it;
+        const int index = line - it->firstLine;
+        if (index >= it->lines.size()) {
+            return QString();
+        }
+        const OutputConsole::LineRecord& record = it->lines.at(index);
+        return it->text.mid(record.offset, record.length);
+    }
+
+    // 溢出文件：找到所在块，只读这一块
+    auto block = std::upper_bound(m_spillBlocks.begin(), m_spillBlocks.end(), line,
+                                  [](int value, const OutputSpill::Block& entry) { return value < entry.firstLine; });
+    if (block == m_spillBlocks.begin()) {
+        return QString();
+    }
+    --block;
+    const qint64 end = block + 1 == m_spillBlocks.end() ? m_spillBytes : (block + 1)->offset;
+
+    QFile   file;
+    QString error;
+    if (!openSpill(&file, &error) || !file.seek(block->offset)) {
+        return QString();
+    }
+    const QByteArray data = file.read(end - block->offset);
+
+    int start = 0;
+    for (int index = line - block->firstLine; index > 0; --index) {
+        start = data.indexOf('\n', start);
+        if (start < 0) {
+            return QString();
+        }
+        ++start;
+    }
+    const int newline = data.indexOf('\n', start);
+    if (newline < 0) {
+        return QString();
+    }
+    return QString::fromUtf8(data.constData() + start, newline - start);
+}
+
+bool OutputLog::save(const QString& path, bool compress, const Progress& progress, const std::atomic<bool>* cancelled,
+                     QString* error) const
+{
+    QSaveFile target(path);
+    if (!target.open(QIODevice::WriteOnly)) {
+        *error = QString("无法写入%1：%2").arg(path, target.errorString());
+        return false;
+    }
+
+    // 攒够一块再写出（压缩时每块一个gzip成员）
+    QByteArray buffer;
+    buffer.reserve(static_cast<int>(kBlockBytes));
+    auto flush = [&]() {
+        if (buffer.isEmpty()) {
+            return true;
+        }
+        const QByteArray data = compress ? gzipMember(buffer) : buffer;
+        buffer.clear();
+        return target.write(data) == data.size();
+    };
+    auto isCancelled = [cancelled]() { return cancelled && cancelled->load(std::memory_order_relaxed); };
+
+    qint64 written = 0;
+    bool   failed  = false;
+
+    // 溢出文件已经是每行一个换行的UTF-8，按块原样复制
+    if (m_spillBytes > 0) {
+        QFile file;
+        if (!openSpill(&file, error)) {
+            target.cancelWriting();
+            return false;
+        }
+        qint64 position = 0;
+        while (position < m_spillBytes && !failed && !isCancelled()) {
+            const QByteArray data = file.read(qMin(kBlockBytes, m_spillBytes - position));
+            if (data.isEmpty()) {
+                *error = QString("无法读取输出溢出文件%1：%2").arg(file.fileName(), file.errorString());
+                target.cancelWriting();
+                return false;
+            }
+            buffer.append(data);
+            position += data.size();
+            written  += data.count('\n');
+            failed    = !flush();
+            if (progress) {
+                progress(written);
+            }
+        }
+    }
+
+    // 内存中的行逐行编码
+    for (auto chunk = m_chunks.begin(); chunk != m_chunks.end() && !failed && !isCancelled(); ++chunk) {
+        for (const OutputConsole::LineRecord& record : chunk->lines) {
+            buffer.append(QStringView(chunk->text).mid(record.offset, record.length).toUtf8());
+            buffer.append('\n');
+            if (++written % kProgressLines == 0 && progress) {
+                progress(written);
+            }
+        }
+        if (buffer.size() >= kBlockBytes) {
+            failed = !flush();
+        }
+    }
+    failed = failed || !flush();
+
+    if (isCancelled()) {
+        target.cancelWriting();
+        *error = "导出已取消";
+        return false;
+    }
+    if (failed || !target.commit()) {
+        *error = QString("无法写入%1：%2").arg(path, target.errorString());
+        target.cancelWriting();
+        return false;
+    }
+    if (progress) {
+        progress(written);
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "OutputConsole.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+#include <QtGlobal>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+/**
+ * @class OutputSpill
+ * @brief 输出窗口丢弃的旧输出写入的临时文件
+ *
+ * 输出窗口按块丢弃最旧的行，开启溢出到磁盘后这些块先以UTF-8追加到临时文件，
+ * 每块记录第一行的序号和在文件中的偏移，作为行偏移索引：按行号读取时只需从所在块的偏移开始读。
+ * 文件只追加，后台线程用自己的文件句柄读取快照时刻之前写入的部分，与继续追加互不干扰。
+ * 最后一个持有者释放时删除文件。写入失败后不再追加，之后丢弃的行计入丢弃的行数。
+ *
+ * append()只在界面线程中调用；快照中的索引是副本，可在任意线程读取。
+ */
+class OutputSpill
+{
+public:
+    /**
+     * @brief 索引项：一块的第一行和在文件中的偏移
+     */
+    struct Block
+    {
+        int    firstLine = 0;   // 绝对行号
+        qint64 offset    = 0;
+    };
+
+    /**
+     * @brief 构造函数（在临时目录中创建文件）
+     */
+    OutputSpill();
+
+    OutputSpill(const OutputSpill&)            = delete;
+    OutputSpill& operator=(const OutputSpill&) = delete;
+
+    /**
+     * @brief 追加一块
+     * @param firstLine 第一行的绝对行号
+     * @param lineCount 行数
+     * @param data 各行的UTF-8文本，每行以换行符结束
+     * @return bool 写入成功返回true
+     */
+    bool append(int firstLine, int lineCount, const QByteArray& data);
+
+    /**
+     * @brief 把已写入的数据交给操作系统，之后其他句柄能读到
+     */
+    void flush();
+
+    bool                  isValid() const { return m_valid; }
+    QString               fileName() const { return m_file.fileName(); }
+    qint64                size() const { return m_size; }
+    int                   lineCount() const { return m_lineCount; }
+    const QVector<Block>& blocks() const { return m_blocks; }
+
+private:
+    QTemporaryFile m_file;
+    bool           m_valid     = false;
+    qint64         m_size      = 0;
+    int            m_lineCount = 0;
+    QVector<Block> m_blocks;
+};
+
+/**
+ * @class OutputLog
+ * @brief 输出窗口全部输出的快照，供后台线程导出和搜索
+ *
+ * 由OutputConsole::snapshot()在界面线程中取得：内存中的块是隐式共享的副本，不复制文本；
+ * 溢出文件只记下当时的长度和索引。之后到达的输出不在快照中，快照可以移交给任意一个线程使用。
+ * 行号都是输出窗口清空以来的绝对行号（从0开始），与OutputConsole的搜索结果一致。
+ *
+ * 读取溢出文件时每次读1MB，整个日志不需要装入内存；日志比内存大时也可以导出和搜索。
+ */
+class OutputLog
+{
+public:
+    /**
+     * @brief 一行的处理函数
+     * @param line 绝对行号
+     * @param text 文本
+     * @return bool 返回false时停止遍历
+     */
+    using LineVisitor = std::function<bool(int line, const QString& text)>;
+
+    /**
+     * @brief 导出进度回调
+     * @param done 已写出的行数
+     */
+    using Progress = std::function<void(qint64 done)>;
+
+    OutputLog() = default;
+
+    /**
+     * @brief 快照中的第一行
+     * @return int 绝对行号
+     */
+    int firstLine() const;
+
+    /**
+     * @brief 快照中的行数（溢出文件和内存中的行）
+     * @return qint64 行数
+     */
+    qint64 lineCount() const;
+
+    /**
+     * @brief 超过行数上限后没有写入溢出文件、已经丢弃的行数
+     * @return int 行数
+     */
+    int droppedLines() const;
+
+    /**
+     * @brief 按顺序遍历每一行
+     * @param visitor 处理函数
+     * @param error 读取溢出文件失败时写入原因
+     * @return bool 读完或被处理函数停止返回true，读取失败返回false
+     */
+    bool forEachLine(const LineVisitor& visitor, QString* error) const;
+
+    /**
+     * @brief 读取一行（溢出文件中的行从所在块的偏移开始读）
+     * @param line 绝对行号
+     * @return QString 文本，不在快照中时为空
+     */
+    QString lineText(int line) const;
+
+    /**
+     * @brief 把全部输出写入文件（在调用线程中完成）
+     *
+     * 溢出文件中的数据按原样复制，内存中的行编码为UTF-8；compress为true时写成gzip，
+     * 每1MB压缩为一个gzip成员，不需要一次压缩整个日志。先写临时文件，完整写完后才替换目标文件。
+     * @param path 文件路径
+     * @param compress 是否写成gzip
+     * @param progress 进度回调，可以为空
+     * @param cancelled 置为true时停止并放弃已写的部分，可以为nullptr
+     * @param error 失败时写入原因
+     * @return bool 成功返回true
+     */
+    bool save(const QString& path, bool compress, const Progress& progress, const std::atomic<bool>* cancelled,
+              QString* error) const;
+
+private:
+    friend class OutputConsole;
+
+    /**
+     * @brief 打开溢出文件供读取
+     * @param file 文件
+     * @param error 失败时写入原因
+     * @return bool 成功返回true
+     */
+    bool openSpill(QFile* file, QString* error) const;
+
+    std::shared_ptr<OutputSpill>     m_spill;            // 保证读取期间文件不被删除
+    QVector<OutputSpill::Block>      m_spillBlocks;
+    qint64                           m_spillBytes = 0;
+    int                              m_spillLines = 0;
+    std::deque<OutputConsole::Chunk> m_chunks;           // 内存中的行（隐式共享）
+    int                              m_firstLine = 0;    // 内存中第一行的绝对行号
+};
@@ -0,0 +1,111 @@
+#include "OutputSearch.h"
+
+#include <QElapsedTimer>
+
+// 每攒够这么多结果或经过这么长时间发出一批
+static const int    kBatchMatches = 4096;
+static const qint64 kBatchMs      = 50;
+
+// 结果数上限，超过后停止搜索
+static const int kMaxMatches = 1000000;
+
+OutputSearch::OutputSearch(QObject* parent)
+    : QObject(parent)
+{
+}
+
+OutputSearch::~OutputSearch()
+{
+    stopThread();
+}
+
+void OutputSearch::start(const OutputLog& log, const QString& text, Qt::CaseSensitivity sensitivity)
+{
+    stopThread();
+
+    const quint64 generation = m_generation.load();
+    m_running                = true;
+    m_thread                 = std::thread(&OutputSearch::run, this, generation, log, text, sensitivity);
+}
+
+void OutputSearch::cancel()
+{
+    stopThread();
+    m_running = false;
+}
+
+void OutputSearch::stopThread()
+{
+    // 代号变化后后台线程在下一行停止，已经排队的结果也随之作废
+    ++m_generation;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void OutputSearch::run(quint64 generation, OutputLog log, QString text, Qt::CaseSensitivity sensitivity)
+{
+    // 结果在界面线程中按代号过滤后发出
+    auto deliver = [this, generation](const QVector<int>& lines) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, generation, lines]() {
+                if (m_generation.load() == generation) {
+                    emit matchesFound(lines);
+                }
+            },
+            Qt::QueuedConnection);
+    };
+
+    QVector<int>  batch;
+    int           matches   = 0;
+    qint64        scanned   = 0;
+    bool          truncated = false;
+    QElapsedTimer timer;
+    timer.start();
+
+    QString    error;
+    const bool ok = log.forEachLine(
+        [&](int line, const QString& lineText) {
+            if (m_generation.load(std::memory_order_relaxed) != generation) {
+                return false;
+            }
+            ++scanned;
+            if (lineText.contains(text, sensitivity)) {
+                batch.append(line);
+                if (++matches >= kMaxMatches) {
+                    truncated = true;
+                    return false;
+                }
+            }
+
+            // 计时每1024行检查一次，结果稀疏时也能及时发出已找到的部分
+            if (batch.size() >= kBatchMatches ||
+                (!batch.isEmpty() && (scanned & 1023) == 0 && timer.elapsed() >= kBatchMs)) {
+                deliver(batch);
+                batch.clear();
+                timer.restart();
+            }
+            return true;
+        },
+        &error);
+
+    if (m_generation.load() != generation) {
+        return;
+    }
+    if (!batch.isEmpty()) {
+        deliver(batch);
+    }
+    if (ok) {
+        error.clear();
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, matches, scanned, truncated, error]() {
+            if (m_generation.load() == generation) {
+                m_running = false;
+                emit finished(matches, scanned, truncated, error);
+            }
+        },
+        Qt::QueuedConnection);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "OutputLog.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @class OutputSearch
+ * @brief 在后台线程中搜索输出快照
+ *
+ * 输入搜索文字后在输出窗口的快照（OutputLog）上逐行查找，匹配行的绝对行号每攒够一批
+ * 或每隔一小段时间发出一次，界面可以在搜索进行中就高亮和跳转到已找到的结果。
+ * 溢出文件按块读取，日志比内存大时也不需要一次读入。结果数达到上限后停止，报告为截断。
+ *
+ * 开始新的搜索或取消时，正在进行的搜索在下一行停止；之前排队的结果按搜索代号丢弃，
+ * 界面不会收到旧搜索的结果。除后台线程外只在界面线程中调用。
+ */
+class OutputSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OutputSearch(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（停止并等待后台线程）
+     */
+    ~OutputSearch() override;
+
+    /**
+     * @brief 开始搜索，取消正在进行的搜索
+     * @param log 输出快照
+     * @param text 搜索文字（不为空）
+     * @param sensitivity 是否区分大小写
+     */
+    void start(const OutputLog& log, const QString& text, Qt::CaseSensitivity sensitivity);
+
+    /**
+     * @brief 取消正在进行的搜索
+     */
+    void cancel();
+
+    /**
+     * @brief 是否正在搜索
+     * @return bool 正在搜索返回true
+     */
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief 找到一批结果
+     * @param lines 匹配行的绝对行号，递增
+     */
+    void matchesFound(const QVector<int>& lines);
+
+    /**
+     * @brief 搜索结束（取消时不发出）
+     * @param matches 结果数
+     * @param lines 搜索过的行数
+     * @param truncated 结果达到上限后停止
+     * @param error 读取溢出文件失败时的原因
+     */
+    void finished(int matches, qint64 lines, bool truncated, const QString& error);
+
+private:
+    /**
+     * @brief 后台线程中的搜索
+     */
+    void run(quint64 generation, OutputLog log, QString text, Qt::CaseSensitivity sensitivity);
+
+    /**
+     * @brief 停止并等待后台线程
+     */
+    void stopThread();
+
+private:
+    std::thread          m_thread;
+    std::atomic<quint64> m_generation{0};   // 每次开始或取消加一，旧搜索据此停止
+    bool                 m_running = false;
+};
@@ -0,0 +1,236 @@
+#include "ProcessPool.h"
+#include "RemoteCodeRunner.h"
+
+#include <QDeadlineTimer>
+#include <QEventLoop>
+#include <QThread>
+#include <QTimer>
+
+#include <chrono>
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+ProcessPool::ProcessPool(QObject* parent)
+    : QObject(parent)
+{}
+
+ProcessPool::~ProcessPool()
+{
+    shutdown();
+}
+
+bool ProcessPool::start(int workerCount, int timeoutMs)
+{
+    if (!m_workers.isEmpty()) {
+        return true;
+    }
+
+    if (workerCount <= 0) {
+        workerCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    m_workers.resize(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        RemoteCodeRunner* runner = new RemoteCodeRunner(this);
+        m_workers[i].runner      = runner;
+        runner->setBudgets(m_budgets);
+
+        connect(runner, &CodeRunner::outputReady, this, [this, i]() { collectOutput(i); });
+        connect(runner, &CodeRunner::errorOccurred, this, [this, i](const QString& error) {
+            if (m_workers[i].job) {
+                m_workers[i].job->error += error;
+            }
+        });
+        connect(runner, &CodeRunner::runSummary, this, [this, i](const CodeRunner::RunSummary& summary) {
+            if (m_workers[i].job) {
+                m_workers[i].job->summary = summary;
+            }
+        });
+        connect(runner, &CodeRunner::executionFinished, this, [this, i]() { finishJob(i); });
+        // 执行进程重启后可能已有排队任务在等待
+        connect(runner, &RemoteCodeRunner::workerReady, this, &ProcessPool::dispatch);
+    }
+
+    // 执行进程并行初始化解释器，统一等待
+    QDeadlineTimer deadline(timeoutMs);
+    bool           ready = false;
+    while (!ready && !deadline.hasExpired()) {
+        ready = true;
+        for (const Worker& worker : m_workers) {
+            ready = ready && worker.runner->isWorkerReady();
+        }
+        if (!ready) {
+            QEventLoop loop;
+            QTimer::singleShot(5, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+    }
+
+    m_startNs = monotonicNs();
+    return ready;
+}
+
+void ProcessPool::shutdown()
+{
+    abortAll();
+
+    for (Worker& worker : m_workers) {
+        worker.runner->disconnect(this);
+        delete worker.runner;
+    }
+    m_workers.clear();
+    m_running = 0;
+}
+
+void ProcessPool::setBudgets(const RunWatchdog::Budgets& budgets)
+{
+    m_budgets = budgets;
+    for (Worker& worker : m_workers) {
+        worker.runner->setBudgets(budgets);
+    }
+}
+
+std::shared_ptr<ProcessPool::Job> ProcessPool::submit(const QString& code, const QByteArray& input)
+{
+    if (m_workers.isEmpty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->id    = m_nextJobId++;
+    job->code  = code;
+    job->input = input;
+    m_queue.push_back(job);
+
+    dispatch();
+    return job;
+}
+
+void ProcessPool::abortAll()
+{
+    for (const std::shared_ptr<Job>& job : m_queue) {
+        job->error    = "任务已取消";
+        job->finished = true;
+        ++m_completed;
+        emit jobFinished(job->id, true);
+    }
+    m_queue.clear();
+
+    for (Worker& worker : m_workers) {
+        if (worker.job) {
+            worker.runner->abortExecution();
+        }
+    }
+}
+
+bool ProcessPool::waitForDone(int msecs)
+{
+    QDeadlineTimer deadline(msecs < 0 ? QDeadlineTimer::Forever : msecs);
+
+    while (m_running > 0 || !m_queue.empty()) {
+        if (deadline.hasExpired()) {
+            return false;
+        }
+
+        QEventLoop loop;
+        connect(this, &ProcessPool::allDone, &loop, &QEventLoop::quit);
+        if (!deadline.isForever()) {
+            QTimer::singleShot(static_cast<int>(qMax<qint64>(1, deadline.remainingTime())),
+                               &loop,
+                               &QEventLoop::quit);
+        }
+        loop.exec();
+    }
+
+    return true;
+}
+
+ProcessPool::Metrics ProcessPool::metrics() const
+{
+    Metrics metrics;
+    metrics.workers   = m_workers.size();
+    metrics.queued    = static_cast<int>(m_queue.size());
+    metrics.running   = m_running;
+    metrics.completed = m_completed;
+
+    const qint64 now = monotonicNs();
+    metrics.busyNs   = m_busyNs;
+    for (const Worker& worker : m_workers) {
+        metrics.restarts += worker.runner->restartCount();
+        if (worker.job) {
+            metrics.busyNs += now - worker.jobStartNs;
+        }
+    }
+
+    metrics.wallNs = m_startNs > 0 ? now - m_startNs : 0;
+    if (metrics.workers > 0 && metrics.wallNs > 0) {
+        metrics.utilisation =
+            static_cast<double>(metrics.busyNs) / (static_cast<double>(metrics.wallNs) * metrics.workers);
+    }
+
+    return metrics;
+}
+
+void ProcessPool::dispatch()
+{
+    for (int i = 0; i < m_workers.size() && !m_queue.empty(); ++i) {
+        Worker& worker = m_workers[i];
+        if (worker.job || !worker.runner->isWorkerReady()) {
+            continue;
+        }
+
+        worker.job = m_queue.front();
+        m_queue.pop_front();
+        worker.job->worker = i;
+        worker.jobStartNs  = monotonicNs();
+        ++m_running;
+
+        emit jobStarted(worker.job->id);
+        // 输入先于代码到达执行进程；无人应答的任务读到输入末尾即得到EOF
+        worker.runner->writeInput(worker.job->input);
+        worker.runner->closeInput();
+        worker.runner->runCode(worker.job->code);
+    }
+}
+
+void ProcessPool::collectOutput(int index)
+{
+    Worker&                           worker = m_workers[index];
+    const QList<OutputChannel::Chunk> chunks = worker.runner->outputChannel()->takeAll();
+
+    if (!worker.job) {
+        return;
+    }
+    for (const OutputChannel::Chunk& chunk : chunks) {
+        worker.job->output += chunk.text;
+    }
+}
+
+void ProcessPool::finishJob(int index)
+{
+    Worker& worker = m_workers[index];
+    if (!worker.job) {
+        return;
+    }
+
+    collectOutput(index);
+
+    std::shared_ptr<Job> job = std::move(worker.job);
+    worker.job.reset();
+    job->finished = true;
+    m_busyNs += monotonicNs() - worker.jobStartNs;
+    --m_running;
+    ++m_completed;
+
+    emit jobFinished(job->id, !job->error.isEmpty() || job->summary.aborted);
+
+    dispatch();
+    if (m_running == 0 && m_queue.empty()) {
+        emit allDone();
+    }
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "CodeRunner.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <deque>
+#include <memory>
+
+class RemoteCodeRunner;
+
+/**
+ * @class ProcessPool
+ * @brief 执行进程池，批量脚本在多个进程中并行运行
+ *
+ * 每个工作者是一个RemoteCodeRunner（一个执行进程、一个独立的解释器和GIL），
+ * 任何Python版本都能用满所有核心；某个任务让执行进程崩溃时只影响该任务，
+ * 进程重启后继续处理队列中的后续任务。
+ *
+ * 池在所属线程的事件循环中调度，所有接口都应在该线程中调用。
+ */
+class ProcessPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 一个运行任务（结束后所有字段不再变化）
+     */
+    struct Job
+    {
+        int                    id = 0;
+        QString                code;
+        QByteArray             input;    // 标准输入，读完后得到EOF
+        QString                output;   // 标准输出和标准错误按到达顺序合并
+        QString                error;    // 错误信息，成功时为空
+        CodeRunner::RunSummary summary;
+        bool                   finished = false;
+        int                    worker   = -1;
+    };
+
+    /**
+     * @brief 调度和利用率统计
+     */
+    struct Metrics
+    {
+        int     workers     = 0;
+        int     queued      = 0;     // 等待调度的任务数
+        int     running     = 0;     // 正在运行的任务数
+        quint64 completed   = 0;     // 已结束的任务数（含失败）
+        int     restarts    = 0;     // 执行进程重启次数之和
+        qint64  wallNs      = 0;     // 自全部执行进程就绪以来的墙钟时间
+        qint64  busyNs      = 0;     // 所有执行进程运行任务的时间之和
+        double  utilisation = 0.0;   // busyNs / (执行进程数 × wallNs)
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit ProcessPool(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（关闭所有执行进程）
+     */
+    ~ProcessPool() override;
+
+    /**
+     * @brief 启动执行进程并等待它们完成解释器初始化
+     * @param workerCount 执行进程数，0表示CPU核心数
+     * @param timeoutMs 等待就绪的最长毫秒数
+     * @return bool 全部就绪返回true
+     */
+    bool start(int workerCount = 0, int timeoutMs = 30000);
+
+    /**
+     * @brief 中止所有任务并关闭执行进程
+     */
+    void shutdown();
+
+    /**
+     * @brief 执行进程数
+     * @return int 数量，未启动时为0
+     */
+    int workerCount() const { return m_workers.size(); }
+
+    /**
+     * @brief 设置之后开始的任务的时间和内存预算（每个执行进程各自监视）
+     * @param budgets 预算，各项为0表示不限制
+     */
+    void setBudgets(const RunWatchdog::Budgets& budgets);
+
+    /**
+     * @brief 提交一段代码
+     * @param code Python代码
+     * @param input 标准输入（UTF-8），读完后input()抛出EOFError，不会等待
+     * @return std::shared_ptr<Job> 任务，池未启动时为空
+     */
+    std::shared_ptr<Job> submit(const QString& code, const QByteArray& input = QByteArray());
+
+    /**
+     * @brief 丢弃排队的任务并中止运行中的任务
+     */
+    void abortAll();
+
+    /**
+     * @brief 处理事件直到所有已提交的任务结束
+     * @param msecs 最长等待毫秒数，-1表示一直等待
+     * @return bool 全部结束返回true，超时返回false
+     */
+    bool waitForDone(int msecs = -1);
+
+    /**
+     * @brief 获取调度和利用率统计
+     * @return Metrics 统计快照
+     */
+    Metrics metrics() const;
+
+signals:
+    /**
+     * @brief 任务开始运行信号
+     * @param jobId 任务编号
+     */
+    void jobStarted(int jobId);
+
+    /**
+     * @brief 任务结束信号
+     * @param jobId 任务编号
+     * @param failed 是否失败（出错、被中止或执行进程崩溃）
+     */
+    void jobFinished(int jobId, bool failed);
+
+    /**
+     * @brief 所有任务结束信号
+     */
+    void allDone();
+
+private:
+    struct Worker
+    {
+        RemoteCodeRunner*    runner = nullptr;
+        std::shared_ptr<Job> job;
+        qint64               jobStartNs = 0;
+    };
+
+    /**
+     * @brief 把排队任务分配给空闲的执行进程
+     */
+    void dispatch();
+
+    /**
+     * @brief 取走执行进程输出到任务中
+     * @param index 执行进程序号
+     */
+    void collectOutput(int index);
+
+    /**
+     * @brief 任务结束处理
+     * @param index 执行进程序号
+     */
+    void finishJob(int index);
+
+private:
+    QVector<Worker>                  m_workers;
+    std::deque<std::shared_ptr<Job>> m_queue;
+    int                              m_nextJobId = 1;
+    int                              m_running   = 0;
+    quint64                          m_completed = 0;
+    qint64                           m_busyNs    = 0;
+    qint64                           m_startNs   = 0;
+    RunWatchdog::Budgets             m_budgets;
+};
@@ -0,0 +1,94 @@
+#include "ProfileView.h"
+#include "LineProfile.h"
+
+#include <QHeaderView>
+
+namespace {
+
+enum Column
+{
+    LineColumn = 0,
+    HitsColumn,
+    WallColumn,
+    CpuColumn,
+    ShareColumn,
+    CodeColumn,
+    ColumnCount
+};
+
+// 数值列用DisplayRole保存数值，排序按数值而不是字符串
+QTableWidgetItem* numberItem(const QVariant& value)
+{
+    QTableWidgetItem* item = new QTableWidgetItem;
+    item->setData(Qt::DisplayRole, value);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+double roundedMs(qint64 ns)
+{
+    return qRound64(ns / 1000.0) / 1000.0;
+}
+
+}   // namespace
+
+ProfileView::ProfileView(QWidget* parent)
+    : QTableWidget(parent)
+{
+    setColumnCount(ColumnCount);
+    setHorizontalHeaderLabels({"行", "命中次数", "墙钟时间(ms)", "CPU时间(ms)", "相对耗时(%)", "代码"});
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionBehavior(QAbstractItemView::SelectRows);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setWordWrap(false);
+    verticalHeader()->setVisible(false);
+    horizontalHeader()->setStretchLastSection(true);
+    horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    horizontalHeader()->setSectionResizeMode(CodeColumn, QHeaderView::Stretch);
+
+    connect(this, &QTableWidget::cellDoubleClicked, this, [this](int row, int) {
+        QTableWidgetItem* lineItem = item(row, LineColumn);
+        if (lineItem) {
+            emit lineActivated(lineItem->data(Qt::DisplayRole).toInt());
+        }
+    });
+}
+
+void ProfileView::setProfile(const std::shared_ptr<LineProfile>& profile,
+                             const QStringList& sourceLines)
+{
+    // 填充期间关闭排序，否则每插入一项都会重新排序
+    setSortingEnabled(false);
+    clearContents();
+    setRowCount(0);
+
+    if (!profile) {
+        return;
+    }
+
+    const qint64 maxWallNs = profile->maxWallNs();
+    for (int line = 1; line <= profile->lineCount(); ++line) {
+        const quint64 hits = profile->hits(line);
+        if (hits == 0) {
+            continue;
+        }
+
+        const qint64 wallNs = profile->wallNs(line);
+        const double share  = maxWallNs > 0 ? 100.0 * wallNs / maxWallNs : 0.0;
+
+        const int row = rowCount();
+        insertRow(row);
+        setItem(row, LineColumn, numberItem(line));
+        setItem(row, HitsColumn, numberItem(hits));
+        setItem(row, WallColumn, numberItem(roundedMs(wallNs)));
+        setItem(row, CpuColumn, numberItem(roundedMs(profile->cpuNs(line))));
+        setItem(row, ShareColumn, numberItem(qRound(share * 10) / 10.0));
+        setItem(row,
+                CodeColumn,
+                new QTableWidgetItem(line <= sourceLines.size() ? sourceLines[line - 1].trimmed()
+                                                                : QString()));
+    }
+
+    setSortingEnabled(true);
+    sortItems(WallColumn, Qt::DescendingOrder);
+}
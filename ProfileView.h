@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QStringList>
+#include <QTableWidget>
+
+#include <memory>
+
+class LineProfile;
+
+/**
+ * @class ProfileView
+ * @brief 性能分析热点表格
+ *
+ * 每个执行过的行一行，列出命中次数、墙钟时间、CPU时间和相对耗时，
+ * 各列按数值排序，默认按墙钟时间从高到低；双击跳转到编辑器中的对应行。
+ */
+class ProfileView : public QTableWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit ProfileView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 显示一次分析运行的结果
+     * @param profile 逐行统计，为空时清空表格
+     * @param sourceLines 运行的代码（按行拆分），用于显示每行的代码
+     */
+    void setProfile(const std::shared_ptr<LineProfile>& profile, const QStringList& sourceLines);
+
+signals:
+    /**
+     * @brief 用户双击某一行的信号
+     * @param lineNumber 代码行号（1-based）
+     */
+    void lineActivated(int lineNumber);
+};
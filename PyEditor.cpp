@@ -1,189 +1,42 @@
 #include "PyEditor.h"
 #include "CodeRunner.h"
+#include "CompletionEngine.h"
 #include "ConfigManager.h"
-
+#include "DiagnosticsService.h"
+#include "FileLoader.h"
+#include "HighlightEngine.h"
+#include "LineProfile.h"
+#include "PythonLexer.h"
+#include "SaveService.h"
+
+#include <QAbstractItemView>
 #include <QApplication>
 #include <QColor>
 #include <QDebug>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QFont>
+#include <QFormLayout>
+#include <QHelpEvent>
 #include <QKeyEvent>
+#include <QLineEdit>
+#include <QMenu>
+#include <QMessageBox>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPlainTextEdit>
+#include <QScrollBar>
 #include <QSettings>
 #include <QTextBlock>
+#include <QTextDocument>
 #include <QTextStream>
 #include <QTimer>
+#include <QToolTip>
 
-// Python语法高亮器类
-class PythonHighlighter : public QSyntaxHighlighter
-{
-public:
-    explicit PythonHighlighter(QTextDocument* parent = nullptr)
-        : QSyntaxHighlighter(parent)
-    {
-        setupHighlightingRules();
-    }
-
-protected:
-    void highlightBlock(const QString& text) override
-    {
-        // 应用所有高亮规则
-        for (const HighlightingRule& rule : m_highlightingRules) {
-            QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-            while (matchIterator.hasNext()) {
-                QRegularExpressionMatch match = matchIterator.next();
-                setFormat(match.capturedStart(), match.capturedLength(), rule.format);
-            }
-        }
-
-        // 处理多行字符串
-        setCurrentBlockState(0);
-        processMultiLineStrings(text);
-
-        // 处理单行注释
-        processSingleLineComments(text);
-    }
-
-private:
-    // 高亮规则结构体
-    struct HighlightingRule
-    {
-        QRegularExpression pattern;
-        QTextCharFormat    format;
-    };
-
-    // 设置高亮规则
-    void setupHighlightingRules()
-    {
-        // 关键字
-        QStringList keywordPatterns = {
-            QStringLiteral("def"),    QStringLiteral("class"),   QStringLiteral("import"),
-            QStringLiteral("from"),   QStringLiteral("if"),      QStringLiteral("elif"),
-            QStringLiteral("else"),   QStringLiteral("while"),   QStringLiteral("for"),
-            QStringLiteral("return"), QStringLiteral("break"),   QStringLiteral("continue"),
-            QStringLiteral("pass"),   QStringLiteral("raise"),   QStringLiteral("try"),
-            QStringLiteral("except"), QStringLiteral("finally"), QStringLiteral("with"),
-            QStringLiteral("as"),     QStringLiteral("global"),  QStringLiteral("nonlocal"),
-            QStringLiteral("True"),   QStringLiteral("False"),   QStringLiteral("None"),
-            QStringLiteral("and"),    QStringLiteral("or"),      QStringLiteral("not"),
-            QStringLiteral("in"),     QStringLiteral("is"),      QStringLiteral("lambda")};
-
-        QTextCharFormat keywordFormat;
-        keywordFormat.setForeground(QColor(127, 0, 85));
-        keywordFormat.setFontWeight(QFont::Bold);
-
-        for (const QString& pattern : keywordPatterns) {
-            HighlightingRule rule;
-            rule.pattern = QRegularExpression(QStringLiteral("\\b%1\\b").arg(pattern));
-            rule.format  = keywordFormat;
-            m_highlightingRules.append(rule);
-        }
-
-        // 内置函数
-        QStringList builtinFunctions = {
-            QStringLiteral("print"),    QStringLiteral("input"),  QStringLiteral("len"),
-            QStringLiteral("type"),     QStringLiteral("int"),    QStringLiteral("float"),
-            QStringLiteral("str"),      QStringLiteral("list"),   QStringLiteral("tuple"),
-            QStringLiteral("dict"),     QStringLiteral("set"),    QStringLiteral("range"),
-            QStringLiteral("abs"),      QStringLiteral("max"),    QStringLiteral("min"),
-            QStringLiteral("sum"),      QStringLiteral("sorted"), QStringLiteral("enumerate"),
-            QStringLiteral("zip"),      QStringLiteral("map"),    QStringLiteral("filter"),
-            QStringLiteral("reversed"), QStringLiteral("any"),    QStringLiteral("all"),
-            QStringLiteral("open"),     QStringLiteral("os"),     QStringLiteral("math")};
-
-        QTextCharFormat builtinFunctionFormat;
-        builtinFunctionFormat.setForeground(QColor(0, 0, 255));
-        builtinFunctionFormat.setFontWeight(QFont::Bold);
-
-        for (const QString& pattern : builtinFunctions) {
-            HighlightingRule rule;
-            rule.pattern = QRegularExpression(QStringLiteral("\\b%1\\b").arg(pattern));
-            rule.format  = builtinFunctionFormat;
-            m_highlightingRules.append(rule);
-        }
-
-        // 字符串
-        QTextCharFormat stringFormat;
-        stringFormat.setForeground(QColor(0, 128, 0));
-
-        // 匹配单引号和双引号字符串
-        HighlightingRule stringRule1;
-        stringRule1.pattern = QRegularExpression(QStringLiteral("'[^\\']*'"));
-        stringRule1.format  = stringFormat;
-        m_highlightingRules.append(stringRule1);
-
-        HighlightingRule stringRule2;
-        stringRule2.pattern = QRegularExpression(QStringLiteral("\"[^\\\"]*\""));
-        stringRule2.format  = stringFormat;
-        m_highlightingRules.append(stringRule2);
-
-        // 数字
-        QTextCharFormat numberFormat;
-        numberFormat.setForeground(QColor(255, 140, 0));
-
-        HighlightingRule numberRule;
-        numberRule.pattern = QRegularExpression(QStringLiteral("\\b\\d+\\.?\\d*\\b"));
-        numberRule.format  = numberFormat;
-        m_highlightingRules.append(numberRule);
-    }
-
-    // 处理多行字符串
-    void processMultiLineStrings(const QString& text)
-    {
-        QTextCharFormat stringFormat;
-        stringFormat.setForeground(QColor(0, 128, 0));
-
-        int startIndex = 0;
-        if (previousBlockState() != 1) startIndex = text.indexOf("\"\"\"");
-
-        while (startIndex >= 0) {
-            int endIndex   = text.indexOf("\"\"\"", startIndex + 3);
-            int blockState = 0;
-
-            if (endIndex == -1) {
-                setCurrentBlockState(1);
-                blockState = 1;
-            }
-
-            int commentLength =
-                (endIndex == -1) ? text.length() - startIndex : endIndex - startIndex + 3;
-            setFormat(startIndex, commentLength, stringFormat);
-            startIndex = text.indexOf("\"\"\"", startIndex + commentLength);
-        }
-    }
-
-    // 处理单行注释
-    void processSingleLineComments(const QString& text)
-    {
-        QTextCharFormat commentFormat;
-        commentFormat.setForeground(QColor(128, 128, 128));
-        commentFormat.setFontItalic(true);
-
-        // 查找#号
-        int hashIndex = text.indexOf("#");
-        if (hashIndex >= 0) {
-            // 检查是否在字符串内部
-            bool inString = false;
-            for (int i = 0; i < hashIndex; ++i) {
-                if (text[i] == '"' || text[i] == '\'') {
-                    // 检查是否是转义的引号
-                    if (i > 0 && text[i - 1] == '\\') continue;
-                    inString = !inString;
-                }
-            }
-
-            if (!inString) {
-                setFormat(hashIndex, text.length() - hashIndex, commentFormat);
-            }
-        }
-    }
-
-    QVector<HighlightingRule> m_highlightingRules;
-};
+#include <cmath>
 
 PyEditor::PyEditor(QWidget* parent)
     : QPlainTextEdit(parent)
@@ -202,6 +55,29 @@ PyEditor::PyEditor(QWidget* parent)
     setupEditor();
     setupLineNumberArea();
     setupAutoSave();
+    setupCompletion();
+    setupOutline();
+    setupDiagnostics();
+
+    // 执行行采样定时器，约60Hz
+    lineSampleTimer = new QTimer(this);
+    lineSampleTimer->setInterval(16);
+    lineSampleTimer->setTimerType(Qt::PreciseTimer);
+    connect(lineSampleTimer, &QTimer::timeout, this, &PyEditor::sampleExecutionLine);
+
+    // 输入停顿后重新划分单元格，连续输入时不逐键扫描整个缓冲区
+    cellTimer = new QTimer(this);
+    cellTimer->setSingleShot(true);
+    cellTimer->setInterval(150);
+    connect(cellTimer, &QTimer::timeout, this, &PyEditor::refreshCells);
+    connect(&cellDependencies, &CellDependencies::analyzed, this, &PyEditor::updateAffectedCells);
+    connect(this, &PyEditor::textChanged, this, [this]() {
+        cellsDirty = true;
+        cellTimer->start();
+
+        // 行号可能已经变化，执行行的块在下次用到时按行号重新查找
+        executionBlock = QTextBlock();
+    });
 
     // 连接配置变更信号
     connect(configManager,
@@ -237,7 +113,20 @@ void PyEditor::setCodeRunner(CodeRunner* runner)
         // 连接新的信号
         if (codeRunner) {
             connect(codeRunner, &CodeRunner::lineExecuted, this, &PyEditor::setCurrentLine);
-            connect(this, &PyEditor::breakpointsChanged, codeRunner, &CodeRunner::setBreakpoints);
+            connect(codeRunner,
+                    &CodeRunner::executionStarted,
+                    this,
+                    &PyEditor::startLineSampling);
+            connect(codeRunner,
+                    &CodeRunner::executionFinished,
+                    this,
+                    &PyEditor::stopLineSampling);
+            // 直接连接：执行期间运行线程的事件循环被阻塞，断点需要立即生效
+            connect(this,
+                    &PyEditor::breakpointsChanged,
+                    codeRunner,
+                    QOverload<const QVector<Breakpoint>&>::of(&CodeRunner::setBreakpoints),
+                    Qt::DirectConnection);
         }
     }
 }
@@ -250,16 +139,416 @@ int PyEditor::currentLineNumber() const
 void PyEditor::setCurrentLine(int line)
 {
     if (line != currentLine && line >= 0) {
+        const QTextBlock previous = executionLineBlock();
+
+        // 逐行执行时新行通常与上一行相邻，直接取相邻的块
+        if (previous.isValid() && line == currentLine + 1) {
+            executionBlock = previous.next();
+        }
+        else if (previous.isValid() && line == currentLine - 1) {
+            executionBlock = previous.previous();
+        }
+        else {
+            executionBlock = line > 0 ? document()->findBlockByNumber(line - 1) : QTextBlock();
+        }
         currentLine = line;
-        highlightCurrentLine();
+
+        // 只重绘新旧两行
+        updateLineRect(previous);
+        updateLineRect(executionBlock);
         emit currentLineChanged(line);
     }
 }
 
+QTextBlock PyEditor::executionLineBlock()
+{
+    if (!executionBlock.isValid() && currentLine > 0) {
+        executionBlock = document()->findBlockByNumber(currentLine - 1);
+    }
+    return executionBlock;
+}
+
+QRect PyEditor::visibleLineRect(const QTextBlock& block) const
+{
+    // 先按块号排除不可见的行，不为远处的块计算位置
+    const int first   = firstVisibleBlock().blockNumber();
+    const int visible = viewport()->height() / fontMetrics().height() + 1;
+    if (!block.isValid() || !block.isVisible() || block.blockNumber() < first ||
+        block.blockNumber() > first + visible) {
+        return QRect();
+    }
+
+    const QRectF geometry = blockBoundingGeometry(block).translated(contentOffset());
+    return QRect(0, static_cast<int>(geometry.top()), viewport()->width(), static_cast<int>(geometry.height()));
+}
+
+void PyEditor::updateLineRect(const QTextBlock& block)
+{
+    const QRect rect = visibleLineRect(block);
+    if (rect.isNull()) {
+        return;
+    }
+    viewport()->update(rect);
+    lineNumberArea->update(0, rect.top(), lineNumberArea->width(), rect.height());
+}
+
+void PyEditor::paintEvent(QPaintEvent* event)
+{
+    // 执行行画在文字下面
+    const QRect rect = visibleLineRect(executionLineBlock());
+    if (rect.intersects(event->rect())) {
+        QPainter painter(viewport());
+        painter.fillRect(rect, QColor(0, 255, 255, 50));
+    }
+    QPlainTextEdit::paintEvent(event);
+}
+
+void PyEditor::showReplayLine(int line)
+{
+    setCurrentLine(line);
+
+    // 行不在可见范围内时滚动到中间
+    const int first   = firstVisibleBlock().blockNumber();
+    const int visible = qMax(1, viewport()->height() / fontMetrics().height());
+    if (line - 1 < first || line - 1 >= first + visible) {
+        verticalScrollBar()->setValue(qMax(0, line - 1 - visible / 2));
+    }
+}
+
+void PyEditor::startLineSampling()
+{
+    lineSampleTimer->start();
+}
+
+void PyEditor::stopLineSampling()
+{
+    lineSampleTimer->stop();
+
+    // 最后采样一次，显示结束前执行到的行
+    sampleExecutionLine();
+}
+
+void PyEditor::sampleExecutionLine()
+{
+    if (!codeRunner) {
+        return;
+    }
+
+    std::shared_ptr<LineChannel> channel = codeRunner->lineChannel();
+    if (channel) {
+        setCurrentLine(channel->latestLine());
+    }
+
+    // 分析运行中热力图随采样刷新
+    std::shared_ptr<LineProfile> profile = codeRunner->lineProfile();
+    if (profile || lineProfile) {
+        lineProfile = std::move(profile);
+        ++gutterMarks.revision;
+        lineNumberArea->update();
+    }
+}
+
+void PyEditor::clearLineProfile()
+{
+    if (lineProfile) {
+        lineProfile.reset();
+        ++gutterMarks.revision;
+        lineNumberArea->update();
+    }
+}
+
+int PyEditor::currentCell()
+{
+    refreshCells();
+    return cellIndex.cellAt(currentLineNumber());
+}
+
+QVector<int> PyEditor::allCells()
+{
+    refreshCells();
+    QVector<int> cells;
+    for (int i = 0; i < cellIndex.cells().size(); ++i) {
+        cells.append(i);
+    }
+    return cells;
+}
+
+QVector<int> PyEditor::changedCells()
+{
+    refreshCells();
+    updateCellDependencies();
+    return cellDependencies.affected(cellIndex, cellIndex.staleCells());
+}
+
+QString PyEditor::cellCode(const QVector<int>& cells)
+{
+    refreshCells();
+    return cellIndex.code(toPlainText(), cells);
+}
+
+QVector<uint> PyEditor::cellHashes(const QVector<int>& cells)
+{
+    refreshCells();
+    return cellIndex.hashes(cells);
+}
+
+void PyEditor::markCellsExecuted(const QVector<uint>& hashes)
+{
+    cellIndex.markExecuted(hashes);
+    updateCellDependencies();
+}
+
+void PyEditor::invalidateCells()
+{
+    cellIndex.invalidate();
+    updateCellDependencies();
+}
+
+void PyEditor::refreshCells()
+{
+    if (!cellsDirty) {
+        return;
+    }
+    cellTimer->stop();
+    cellsDirty = false;
+    // 大文件不划分单元格
+    cellIndex.update(largeFile ? QString() : toPlainText());
+    updateCellDependencies();
+}
+
+void PyEditor::updateCellDependencies()
+{
+    // 只提交新内容，通常只有刚编辑的单元格；结果送回后再更新标记
+    if (!largeFile) {
+        cellDependencies.update(toPlainText(), cellIndex);
+    }
+    updateAffectedCells();
+}
+
+void PyEditor::updateAffectedCells()
+{
+    affectedCells.clear();
+    const QVector<int> stale = cellIndex.staleCells();
+    if (!stale.isEmpty()) {
+        for (int cell : cellDependencies.affected(cellIndex, stale)) {
+            if (!cellIndex.isStale(cell)) {
+                affectedCells.insert(cell);
+            }
+        }
+    }
+    ++gutterMarks.revision;
+    lineNumberArea->update();
+}
+
+// 行号中每个数字占用的宽度：普通和粗体两种样式中最宽的数字，执行行换成粗体时行号不会超出
+static int gutterDigitWidth(const QFont& font)
+{
+    QFont boldFont(font);
+    boldFont.setBold(true);
+    const QFontMetrics normalMetrics(font);
+    const QFontMetrics boldMetrics(boldFont);
+
+    int width = 0;
+    for (char digit = '0'; digit <= '9'; ++digit) {
+        width = qMax(width,
+                     qMax(normalMetrics.horizontalAdvance(QLatin1Char(digit)),
+                          boldMetrics.horizontalAdvance(QLatin1Char(digit))));
+    }
+    return width;
+}
+
+void PyEditor::updateGutterDigits()
+{
+    const qreal ratio = lineNumberArea->devicePixelRatioF();
+    if (gutterDigits.ratio == ratio && gutterDigits.font == font()) {
+        return;
+    }
+    gutterDigits.font  = font();
+    gutterDigits.ratio = ratio;
+
+    QFont boldFont(font());
+    boldFont.setBold(true);
+    const QFont  fonts[2]  = {font(), boldFont};
+    const QColor colors[2] = {QColor(Qt::black), QColor(Qt::blue)};
+
+    gutterDigits.width  = gutterDigitWidth(font());
+    gutterDigits.height = QFontMetrics(font()).height();
+
+    for (int style = 0; style < 2; ++style) {
+        QPixmap strip(QSize(gutterDigits.width * 10, gutterDigits.height) * ratio);
+        strip.setDevicePixelRatio(ratio);
+        strip.fill(Qt::transparent);
+
+        QPainter painter(&strip);
+        painter.setFont(fonts[style]);
+        painter.setPen(colors[style]);
+        for (int digit = 0; digit < 10; ++digit) {
+            painter.drawText(QRect(digit * gutterDigits.width, 0, gutterDigits.width, gutterDigits.height),
+                             Qt::AlignRight,
+                             QString(QLatin1Char('0' + digit)));
+        }
+        gutterDigits.strips[style] = strip;
+    }
+}
+
+void PyEditor::updateGutterMarks()
+{
+    const QSize size = lineNumberArea->size();
+    if (size.isEmpty()) {
+        return;
+    }
+
+    const qreal      ratio      = lineNumberArea->devicePixelRatioF();
+    const int        lineHeight = fontMetrics().height();
+    const QTextBlock first      = firstVisibleBlock();
+    const int        firstTop   = static_cast<int>(blockBoundingGeometry(first).translated(contentOffset()).top());
+    const bool       moved      = first.blockNumber() != gutterMarks.firstBlock || firstTop != gutterMarks.top;
+    const int        scrolled   = gutterMarks.scrolled;
+
+    gutterMarks.scrolled = 0;
+
+    QRect dirty;
+    if (gutterMarks.pixmap.size() != size * ratio || gutterMarks.pixmap.devicePixelRatio() != ratio ||
+        gutterMarks.drawnRevision != gutterMarks.revision || gutterMarks.textRevision != textRevision ||
+        gutterMarks.lineHeight != lineHeight) {
+        gutterMarks.pixmap = QPixmap(size * ratio);
+        gutterMarks.pixmap.setDevicePixelRatio(ratio);
+        dirty = QRect(QPoint(0, 0), size);
+    }
+    else if (moved) {
+        // 滚动距离不足一屏且能按整像素移动时只补画新露出的行，否则全部重画
+        const qreal shift = scrolled * ratio;
+        if (scrolled != 0 && qAbs(scrolled) < size.height() && shift == std::floor(shift)) {
+            gutterMarks.pixmap.scroll(0, static_cast<int>(shift), gutterMarks.pixmap.rect());
+            dirty = scrolled > 0 ? QRect(0, 0, size.width(), scrolled)
+                                 : QRect(0, size.height() + scrolled, size.width(), -scrolled);
+        }
+        else {
+            dirty = QRect(QPoint(0, 0), size);
+        }
+    }
+
+    gutterMarks.drawnRevision = gutterMarks.revision;
+    gutterMarks.textRevision  = textRevision;
+    gutterMarks.lineHeight    = lineHeight;
+    gutterMarks.firstBlock    = first.blockNumber();
+    gutterMarks.top           = firstTop;
+    if (dirty.isEmpty()) {
+        return;
+    }
+
+    QPainter painter(&gutterMarks.pixmap);
+    painter.setClipRect(dirty);
+    painter.fillRect(dirty, QColor(245, 245, 245));
+
+    // 热力图按最耗时的行归一化，开平方让耗时较少的行也能看出差别
+    const qint64 maxWallNs = lineProfile ? lineProfile->maxWallNs() : 0;
+
+    // 有诊断的行（块号）及最严重的程度
+    QHash<int, int> diagnosticLines;
+    for (const DiagnosticMark& mark : diagnosticMarks) {
+        const int line     = mark.cursor.block().blockNumber();
+        auto      existing = diagnosticLines.find(line);
+        if (existing == diagnosticLines.end()) {
+            diagnosticLines.insert(line, mark.diagnostic.severity);
+        }
+        else {
+            existing.value() = qMin(existing.value(), static_cast<int>(mark.diagnostic.severity));
+        }
+    }
+
+    QTextBlock block       = first;
+    int        blockNumber = block.blockNumber();
+    int        top         = firstTop;
+    int        bottom      = top + static_cast<int>(blockBoundingRect(block).height());
+
+    while (block.isValid() && top <= dirty.bottom()) {
+        if (block.isVisible() && bottom >= dirty.top()) {
+            const int currentLineNumber = blockNumber + 1;
+
+            // 绘制性能热力图
+            if (maxWallNs > 0) {
+                const qint64 wallNs = lineProfile->wallNs(currentLineNumber);
+                if (wallNs > 0) {
+                    const double heat = std::sqrt(static_cast<double>(wallNs) / maxWallNs);
+                    painter.fillRect(0,
+                                     top,
+                                     size.width(),
+                                     bottom - top,
+                                     QColor(255, 80, 0, 30 + static_cast<int>(heat * 170)));
+                }
+            }
+
+            // 单元格状态条：已修改为橙色，依赖已修改单元格的为黄色，已运行为绿色；标记行上方画分隔线
+            const int cell = cellIndex.cellAt(currentLineNumber);
+            if (cell >= 0) {
+                const CellIndex::Cell& info = cellIndex.cells()[cell];
+                if (!info.isEmpty && currentLineNumber >= info.firstLine
+                    && currentLineNumber <= info.lastLine) {
+                    QColor color(80, 180, 80);
+                    if (cellIndex.isStale(cell)) {
+                        color = QColor(255, 160, 0);
+                    }
+                    else if (affectedCells.contains(cell)) {
+                        color = QColor(240, 210, 60);
+                    }
+                    painter.fillRect(0, top, 3, bottom - top, color);
+                }
+                if (info.hasMarker && info.firstLine == currentLineNumber) {
+                    painter.setPen(QColor(160, 160, 160));
+                    painter.drawLine(0, top, size.width(), top);
+                }
+            }
+
+            // 绘制断点：条件断点为橙色并带白色横线，日志点为菱形
+            auto breakpoint = breakpoints.constFind(currentLineNumber);
+            if (breakpoint != breakpoints.constEnd()) {
+                const bool   conditional = breakpoint->isConditional();
+                const QColor color       = conditional ? QColor(255, 140, 0) : QColor(Qt::red);
+                painter.setPen(color);
+                painter.setBrush(color);
+                int x = 5;
+                int y = top + lineHeight / 2 - 4;
+                if (breakpoint->isLogpoint()) {
+                    const QPoint diamond[] = {
+                        QPoint(x + 4, y), QPoint(x + 8, y + 4), QPoint(x + 4, y + 8), QPoint(x, y + 4)};
+                    painter.drawPolygon(diamond, 4);
+                }
+                else {
+                    painter.drawEllipse(x, y, 8, 8);
+                }
+                if (conditional) {
+                    painter.fillRect(x + 2, y + 3, 4, 2, QColor(Qt::white));
+                }
+            }
+
+            // 诊断：行号区域右边缘的竖条，错误为红色，警告为橙色
+            auto diagnostic = diagnosticLines.constFind(blockNumber);
+            if (diagnostic != diagnosticLines.constEnd()) {
+                const QColor color = diagnostic.value() == SyntaxCheck::Error ? QColor(220, 0, 0) : QColor(255, 140, 0);
+                painter.fillRect(size.width() - 2, top, 2, bottom - top, color);
+            }
+        }
+
+        block  = block.next();
+        top    = bottom;
+        bottom = top + static_cast<int>(blockBoundingRect(block).height());
+        ++blockNumber;
+    }
+}
+
 void PyEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
 {
+    updateGutterDigits();
+    updateGutterMarks();
+
+    // 标记层整块贴上（只复制重绘区域内的部分），行号画在上面
     QPainter painter(lineNumberArea);
-    painter.fillRect(event->rect(), QColor(245, 245, 245));
+    painter.drawPixmap(0, 0, gutterMarks.pixmap);
+
+    const int   digitWidth  = gutterDigits.width;
+    const qreal digitPixels = gutterDigits.width * gutterDigits.ratio;
+    const qreal stripHeight = gutterDigits.height * gutterDigits.ratio;
 
     QTextBlock block       = firstVisibleBlock();
     int        blockNumber = block.blockNumber();
@@ -268,36 +557,17 @@ void PyEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
 
     while (block.isValid() && top <= event->rect().bottom()) {
         if (block.isVisible() && bottom >= event->rect().top()) {
-            int     currentLineNumber = blockNumber + 1;
-            QString number            = QString::number(currentLineNumber);
-
-            // 绘制断点
-            if (breakpoints.contains(currentLineNumber)) {
-                painter.setPen(QColor(Qt::red));
-                painter.setBrush(QColor(Qt::red));
-                int x = 5;
-                int y = top + fontMetrics().height() / 2 - 4;
-                painter.drawEllipse(x, y, 8, 8);
-            }
-
-            // 设置当前执行行颜色
-            if (currentLineNumber == currentLine) {
-                painter.setPen(QColor(Qt::blue));
-                painter.setFont(
-                    QFont(painter.font().family(), painter.font().pointSize(), QFont::Bold));
-            }
-            else {
-                painter.setPen(Qt::black);
-                painter.setFont(
-                    QFont(painter.font().family(), painter.font().pointSize(), QFont::Normal));
+            const int currentLineNumber = blockNumber + 1;
+
+            // 行号由预渲染的数字从右向左拼成，执行行为蓝色粗体
+            const QPixmap& strip = gutterDigits.strips[currentLineNumber == currentLine ? 1 : 0];
+            int            x     = lineNumberArea->width();
+            for (int value = currentLineNumber; value > 0; value /= 10) {
+                x -= digitWidth;
+                painter.drawPixmap(QRectF(x, top, digitWidth, gutterDigits.height),
+                                   strip,
+                                   QRectF((value % 10) * digitPixels, 0, digitPixels, stripHeight));
             }
-
-            painter.drawText(15,
-                             top,
-                             lineNumberArea->width() - 15,
-                             fontMetrics().height(),
-                             Qt::AlignRight,
-                             number);
         }
 
         block  = block.next();
@@ -318,6 +588,36 @@ void PyEditor::lineNumberAreaMousePressEvent(const QPoint& pos)
     toggleBreakpoint(lineNumber);
 }
 
+void PyEditor::lineNumberAreaContextMenuEvent(const QPoint& pos, const QPoint& globalPos)
+{
+    const int lineNumber = cursorForPosition(pos).blockNumber() + 1;
+
+    QMenu menu(this);
+    if (breakpoints.contains(lineNumber)) {
+        menu.addAction("编辑断点...", this, [this, lineNumber]() { editBreakpoint(lineNumber); });
+        menu.addAction("删除断点", this, [this, lineNumber]() { removeBreakpoint(lineNumber); });
+    }
+    else {
+        menu.addAction("添加断点", this, [this, lineNumber]() { toggleBreakpoint(lineNumber); });
+        menu.addAction("添加条件断点...", this, [this, lineNumber]() { editBreakpoint(lineNumber); });
+        menu.addAction("添加日志点...", this, [this, lineNumber]() { editBreakpoint(lineNumber, true); });
+    }
+    menu.exec(globalPos);
+}
+
+
+QString PyEditor::lineNumberAreaToolTip(const QPoint& pos) const
+{
+    // 行号区域与视口顶端对齐，只需纵坐标
+    const int   blockNumber = cursorForPosition(QPoint(0, pos.y())).blockNumber();
+    QStringList messages;
+    for (const DiagnosticMark& mark : diagnosticMarks) {
+        if (mark.cursor.block().blockNumber() == blockNumber) {
+            messages.append(mark.diagnostic.message);
+        }
+    }
+    return messages.join('\n');
+}
 
 int PyEditor::lineNumberAreaWidth() const
 {
@@ -328,87 +628,200 @@ int PyEditor::lineNumberAreaWidth() const
         ++digits;
     }
 
-    // 增加断点符号占用的空间（15像素）
-    int space = 15 + 3 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
+    // 增加断点符号占用的空间（15像素）；数字宽度与预渲染的行号相同
+    int space = 15 + 3 + gutterDigitWidth(font()) * digits;
     return space;
 }
 
 bool PyEditor::loadFromFile(const QString& filePath)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "Cannot open file for reading:" << filePath;
+    if (!fileLoader) {
+        fileLoader = new FileLoader(this);
+        connect(fileLoader, &FileLoader::chunksAvailable, this, &PyEditor::appendLoadedChunk);
+    }
+    if (!fileLoader->start(filePath)) {
+        qWarning() << "Cannot open file for reading:" << filePath << fileLoader->errorString();
         return false;
     }
 
-    QTextStream in(&file);
-    in.setCodec("UTF-8");
-    setPlainText(in.readAll());
-    file.close();
+    // 加载完成前不自动保存，避免把不完整的内容写回文件
+    currentFilePath.clear();
+    loadingFilePath = filePath;
 
-    currentFilePath = filePath;
-    emit codeChanged();
+    const qint64 threshold = qint64(configManager->getLargeFileThreshold()) << 20;
+    setLargeFileMode(fileLoader->totalBytes() > threshold);
+
+    // 加载期间只读，追加的文本不进入撤销栈
+    setReadOnly(true);
+    document()->setUndoRedoEnabled(false);
+    clear();
+    emit loadProgress(0, fileLoader->totalBytes());
     return true;
 }
 
+bool PyEditor::isLoading() const
+{
+    return fileLoader && fileLoader->isLoading();
+}
+
+void PyEditor::appendLoadedChunk()
+{
+    // 每次只追加一块，块之间回到事件循环处理绘制和输入
+    QString chunk;
+    qint64  loadedBytes = 0;
+    if (fileLoader->takeChunk(&chunk, &loadedBytes)) {
+        QTextCursor cursor(document());
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(chunk);
+        emit loadProgress(loadedBytes, fileLoader->totalBytes());
+        QTimer::singleShot(0, this, &PyEditor::appendLoadedChunk);
+        return;
+    }
+    if (loadingFilePath.isEmpty() || !fileLoader->isFinished()) {
+        return;
+    }
+
+    currentFilePath = loadingFilePath;
+    loadingFilePath.clear();
+    fileLoader->cancel();
+    if (changeTimer) {
+        changeTimer->stop();
+    }
+    markSaved(currentFilePath);
+    document()->setUndoRedoEnabled(!largeFile);
+    setReadOnly(largeFile);
+    moveCursor(QTextCursor::Start);
+
+    emit loadFinished();
+    emit codeChanged();
+}
+
+void PyEditor::setLargeFileMode(bool enabled)
+{
+    if (largeFile == enabled) {
+        return;
+    }
+    largeFile = enabled;
+    syntaxHighlighter->setEnabled(!enabled);
+    rebuildOutline();
+    if (enabled) {
+        diagnosticMarks.clear();
+        ++gutterMarks.revision;
+        updateExtraSelections();
+    }
+    else {
+        diagnosticsTimer->start();
+    }
+    setReadOnly(enabled);
+    document()->setUndoRedoEnabled(!enabled);
+    cellsDirty = true;
+    cellTimer->start();
+}
+
 bool PyEditor::saveToFile(const QString& filePath) const
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "Cannot open file for writing:" << filePath;
+    QString error;
+    if (!SaveService::writeFile(filePath, toPlainText(), &error)) {
+        qWarning() << "Cannot write file:" << filePath << error;
         return false;
     }
+    return true;
+}
 
-    QTextStream out(&file);
-    out.setCodec("UTF-8");
-    out << toPlainText();
-    file.close();
-
+bool PyEditor::saveToFileAsync(const QString& filePath)
+{
+    if (saveService->isSaved(filePath, textRevision)) {
+        return false;
+    }
+    saveService->save(filePath, textRevision, toPlainText());
     return true;
 }
 
+void PyEditor::markSaved(const QString& filePath)
+{
+    saveService->markSaved(filePath, textRevision);
+}
+
 void PyEditor::formatCode()
 {
-    // 简单的代码格式化：移除多余空行和统一缩进
-    QString     text  = toPlainText();
-    QStringList lines = text.split('\n');
-    QStringList formattedLines;
-
-    for (const QString& line : lines) {
-        QString trimmedLine = line.trimmed();
-        if (!trimmedLine.isEmpty()) {
-            // 计算缩进
-            int indentLevel = 0;
-            for (int i = 0; i < line.length(); ++i) {
-                if (line[i] == ' ') {
-                    indentLevel++;
-                }
-                else if (line[i] == '\t') {
-                    indentLevel += 4;
-                }
-                else {
-                    break;
-                }
+    if (isReadOnly()) {
+        return;
+    }
+    if (!formatter) {
+        formatter = new CodeFormatter(this);
+        connect(formatter, &CodeFormatter::finished, this, &PyEditor::applyFormatting);
+        connect(formatter, &CodeFormatter::failed, this, [this](quint64 revision, const QString& error) {
+            if (revision == textRevision) {
+                emit formatFailed(error);
             }
+        });
+    }
+    formatter->format(toPlainText(), textRevision);
+}
 
-            // 统一缩进到4个空格
-            QString indentedLine = QString(indentLevel / 4, ' ');
-            if (indentLevel % 4 != 0) {
-                indentedLine += QString(indentLevel % 4, ' ');
-            }
-            indentedLine += trimmedLine;
-            formattedLines.append(indentedLine);
+// 把第line行起的removed行替换为lines（行号从0开始）
+static void replaceLines(QTextCursor& cursor, int line, int removed, const QStringList& lines)
+{
+    QTextDocument* document = cursor.document();
+    if (removed == 0) {
+        const QTextBlock block = document->findBlockByNumber(line);
+        if (block.isValid()) {
+            cursor.setPosition(block.position());
+            cursor.insertText(lines.join('\n') + '\n');
         }
-        else if (!formattedLines.isEmpty()) {
-            // 保持最多一个空行
-            if (!formattedLines.last().isEmpty()) {
-                formattedLines.append("");
-            }
+        else {
+            cursor.movePosition(QTextCursor::End);
+            cursor.insertText('\n' + lines.join('\n'));
         }
+        return;
     }
 
-    setPlainText(formattedLines.join('\n'));
-    emit codeChanged();
+    const QTextBlock first = document->findBlockByNumber(line);
+    const QTextBlock last  = document->findBlockByNumber(line + removed - 1);
+    int              start = first.position();
+    int              end   = last.position() + last.length() - 1;
+    if (lines.isEmpty()) {
+        // 整行删除：连同后面的换行，删到末尾时连同前面的换行
+        if (last.next().isValid()) {
+            ++end;
+        }
+        else if (start > 0) {
+            --start;
+        }
+    }
+    cursor.setPosition(start);
+    cursor.setPosition(end, QTextCursor::KeepAnchor);
+    if (lines.isEmpty()) {
+        cursor.removeSelectedText();
+    }
+    else {
+        cursor.insertText(lines.join('\n'));
+    }
+}
+
+void PyEditor::applyFormatting(quint64 revision,
+                               const QVector<CodeFormatter::LineEdit>& edits,
+                               const QString& formatterName)
+{
+    // 格式化期间代码又被修改，行号已不对应
+    if (revision != textRevision || isReadOnly()) {
+        return;
+    }
+
+    int changedLines = 0;
+    if (!edits.isEmpty()) {
+        // 从后往前应用，前面的行号不受影响；整个格式化作为一步撤销
+        QTextCursor cursor(document());
+        cursor.beginEditBlock();
+        for (int i = edits.size() - 1; i >= 0; --i) {
+            const CodeFormatter::LineEdit& edit = edits[i];
+            replaceLines(cursor, edit.line, edit.removed, edit.lines);
+            changedLines += qMax(edit.removed, edit.lines.size());
+        }
+        cursor.endEditBlock();
+        emit codeChanged();
+    }
+    emit formatFinished(formatterName, changedLines);
 }
 
 void PyEditor::resizeEvent(QResizeEvent* event)
@@ -421,6 +834,35 @@ void PyEditor::resizeEvent(QResizeEvent* event)
 
 void PyEditor::keyPressEvent(QKeyEvent* event)
 {
+    // 补全列表显示时，确认和取消键交给补全列表处理
+    if (completer->popup()->isVisible()) {
+        switch (event->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Escape:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            event->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    // Ctrl+Space手动补全
+    if (event->key() == Qt::Key_Space && (event->modifiers() & Qt::ControlModifier)) {
+        requestCompletion(true);
+        event->accept();
+        return;
+    }
+
+    // F12跳转到定义
+    if (event->key() == Qt::Key_F12) {
+        goToDefinition();
+        event->accept();
+        return;
+    }
+
     // Tab键自动插入4个空格
     if (event->key() == Qt::Key_Tab) {
         insertPlainText("    ");
@@ -460,6 +902,23 @@ void PyEditor::keyPressEvent(QKeyEvent* event)
     }
 
     QPlainTextEdit::keyPressEvent(event);
+
+    // 输入名字或“.”后停顿时补全；列表已显示时按光标前的名字立即过滤
+    const QString typed = event->text();
+    const bool    word  = typed.size() == 1 && (typed[0].isLetterOrNumber() || typed[0] == '_');
+    if (word || typed == ".") {
+        completionTimer->start();
+    }
+    if (completer->popup()->isVisible()) {
+        const QString prefix = wordBeforeCursor();
+        if ((word || event->key() == Qt::Key_Backspace) && !prefix.isEmpty()) {
+            completer->setCompletionPrefix(prefix);
+            completer->popup()->setCurrentIndex(completer->completionModel()->index(0, 0));
+        }
+        else if (!typed.isEmpty() || event->key() == Qt::Key_Backspace) {
+            completer->popup()->hide();
+        }
+    }
 }
 
 void PyEditor::updateLineNumberAreaWidth()
@@ -470,6 +929,7 @@ void PyEditor::updateLineNumberAreaWidth()
 void PyEditor::updateLineNumberArea(const QRect& rect, int dy)
 {
     if (dy != 0) {
+        gutterMarks.scrolled += dy;
         lineNumberArea->scroll(0, dy);
     }
     else {
@@ -525,18 +985,18 @@ void PyEditor::updateExtraSelections()
         extraSelections.append(currentLineSelection);
     }
 
-    // 当前执行行高亮
-    if (currentLine > 0 && currentLine <= blockCount()) {
-        QTextEdit::ExtraSelection executionLineSelection;
-        executionLineSelection.format.setBackground(QColor(0, 255, 255, 50));
-        executionLineSelection.format.setProperty(QTextFormat::FullWidthSelection, true);
-
-        QTextCursor cursor(document()->findBlockByLineNumber(currentLine - 1));
-        executionLineSelection.cursor = cursor;
-        executionLineSelection.cursor.clearSelection();
-        extraSelections.append(executionLineSelection);
+    // 诊断：错误为红色波浪线，警告为橙色波浪线
+    for (const DiagnosticMark& mark : diagnosticMarks) {
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = mark.cursor;
+        selection.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        selection.format.setUnderlineColor(mark.diagnostic.severity == SyntaxCheck::Error ? QColor(220, 0, 0)
+                                                                                          : QColor(255, 140, 0));
+        extraSelections.append(selection);
     }
 
+    // 当前执行行在paintEvent()中绘制，不放在额外选区中
+
     setExtraSelections(extraSelections);
 }
 
@@ -555,39 +1015,401 @@ void PyEditor::setupAutoSave()
     int interval = configManager->getAutoSaveInterval() * 1000;
     changeTimer->setInterval(interval);
 
+    // 文件在后台线程中写入，界面线程只取文本快照
+    saveService = new SaveService(this);
+    connect(saveService, &SaveService::saved, this, &PyEditor::fileSaved);
+    connect(saveService, &SaveService::saveFailed, this, [this](const QString& filePath, const QString& error) {
+        qWarning() << "Cannot write file:" << filePath << error;
+        emit fileSaveFailed(filePath, error);
+    });
+
     connect(this, &PyEditor::textChanged, [this]() {
+        ++textRevision;
+
+        // 行号可能已经变化，热力图不再对应当前代码
+        clearLineProfile();
+
         if (changeTimer) {
             changeTimer->start();
         }
     });
 
     connect(changeTimer, &QTimer::timeout, [this]() {
-        // 自动保存逻辑（如果设置了自动保存路径）
-        if (!currentFilePath.isEmpty()) {
-            saveToFile(currentFilePath);
-            qDebug() << "Auto-saved to" << currentFilePath;
+        // 自动保存逻辑（如果设置了自动保存路径），未修改时不写入
+        if (!currentFilePath.isEmpty() && saveToFileAsync(currentFilePath)) {
+            qDebug() << "Auto-saving to" << currentFilePath;
         }
     });
 }
 
 void PyEditor::setupSyntaxHighlighting()
 {
-    // 创建语法高亮器实例
-    syntaxHighlighter = new PythonHighlighter(document());
+    // 后台增量语法高亮，优先处理可见区域
+    syntaxHighlighter = new HighlightEngine(this);
+}
+
+void PyEditor::setupCompletion()
+{
+    completionModel = new QStringListModel(this);
+    completer       = new QCompleter(completionModel, this);
+    completer->setWidget(this);
+    completer->setCompletionMode(QCompleter::PopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setMaxVisibleItems(10);
+    connect(completer, QOverload<const QString&>::of(&QCompleter::activated), this, &PyEditor::insertCompletion);
+
+    completionTimer = new QTimer(this);
+    completionTimer->setSingleShot(true);
+    completionTimer->setInterval(150);
+    connect(completionTimer, &QTimer::timeout, this, [this]() { requestCompletion(false); });
+}
+
+QString PyEditor::wordBeforeCursor() const
+{
+    const QTextCursor cursor = textCursor();
+    const QString     text   = cursor.block().text();
+    int               start  = cursor.positionInBlock();
+    while (start > 0 && (text[start - 1].isLetterOrNumber() || text[start - 1] == '_')) {
+        --start;
+    }
+    return text.mid(start, cursor.positionInBlock() - start);
+}
+
+void PyEditor::requestCompletion(bool forced)
+{
+    completionTimer->stop();
+    if (isReadOnly() || largeFile || isLoading()) {
+        return;
+    }
+    if (!completionEngine) {
+        completionEngine = new CompletionEngine(this);
+        connect(completionEngine, &CompletionEngine::completed, this, &PyEditor::showCompletions);
+    }
+
+    // 只有最新的请求会被计算，之前的结果到达时按编号丢弃
+    completionRevision = textRevision;
+    completionPosition = textCursor().position();
+    completionEngine->complete(++completionId, toPlainText(), completionPosition, forced);
+}
+
+void PyEditor::showCompletions(quint64 id, const QString& prefix, const QStringList& candidates)
+{
+    // 请求之后又有输入或光标已移动
+    if (id != completionId || completionRevision != textRevision || textCursor().position() != completionPosition) {
+        return;
+    }
+    if (candidates.isEmpty()) {
+        completer->popup()->hide();
+        return;
+    }
+
+    completionModel->setStringList(candidates);
+    completer->setCompletionPrefix(prefix);
+    QAbstractItemView* popup = completer->popup();
+    popup->setCurrentIndex(completer->completionModel()->index(0, 0));
+
+    QRect rect = cursorRect();
+    rect.translate(viewportMargins().left(), 0);
+    rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+    completer->complete(rect);
+}
+
+void PyEditor::setupOutline()
+{
+    // 大纲按行增量更新，编辑停顿后再通知面板重建
+    outlineTimer = new QTimer(this);
+    outlineTimer->setSingleShot(true);
+    outlineTimer->setInterval(200);
+    connect(outlineTimer, &QTimer::timeout, this, &PyEditor::outlineChanged);
+    connect(document(), &QTextDocument::contentsChange, this, &PyEditor::updateOutline);
+}
+
+void PyEditor::rebuildOutline()
+{
+    QStringList lines;
+    if (!largeFile) {
+        lines.reserve(blockCount());
+        for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+            lines.append(block.text());
+        }
+    }
+    outlineIndex.reset(lines);
+    outlineTimer->start();
+}
+
+void PyEditor::updateOutline(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (largeFile) {
+        return;
+    }
+
+    // 只分析被修改的块；setPlainText()报告的范围可能超出文档末尾
+    const QTextBlock first = document()->findBlock(position);
+    QTextBlock       last  = document()->findBlock(position + charsAdded);
+    if (!last.isValid()) {
+        last = document()->lastBlock();
+    }
+    if (!first.isValid()) {
+        rebuildOutline();
+        return;
+    }
+
+    QStringList lines;
+    for (QTextBlock block = first; block.isValid() && block.blockNumber() <= last.blockNumber(); block = block.next()) {
+        lines.append(block.text());
+    }
+    const int firstLine = first.blockNumber();
+    const int removed   = lines.size() - (blockCount() - outlineIndex.lineCount());
+    if (removed < 0 || firstLine + removed > outlineIndex.lineCount()) {
+        rebuildOutline();
+        return;
+    }
+    if (outlineIndex.update(firstLine, removed, lines)) {
+        outlineTimer->start();
+    }
+}
+
+void PyEditor::goToDefinition()
+{
+    // 光标处的整个名字
+    const QTextCursor cursor = textCursor();
+    const QString     text   = cursor.block().text();
+    int               start  = cursor.positionInBlock();
+    int               end    = start;
+    auto              isName = [](QChar c) { return c.isLetterOrNumber() || c == '_'; };
+    while (start > 0 && isName(text[start - 1])) {
+        --start;
+    }
+    while (end < text.size() && isName(text[end])) {
+        ++end;
+    }
+    const QString name = text.mid(start, end - start);
+    if (name.isEmpty() || name[0].isDigit()) {
+        return;
+    }
+
+    const int            line = cursor.blockNumber() + 1;
+    OutlineIndex::Symbol symbol;
+    if (outlineIndex.findDefinition(name, line, &symbol)) {
+        jumpToDefinition(symbol.line, symbol.column);
+        return;
+    }
+
+    // 不是类或函数：向上查找赋值、导入、for和as绑定的名字（不跨行跟踪字符串和括号）
+    for (QTextBlock block = cursor.block(); block.isValid(); block = block.previous()) {
+        const CompletionEngine::LineSymbols symbols =
+            CompletionEngine::scanLine(block.text(), PythonLexer::kInitialState);
+        bool found = symbols.names.contains(name);
+        for (const auto& import : symbols.imports) {
+            found = found || import.first == name;
+        }
+        if (found) {
+            const int column = block.text().indexOf(QRegularExpression("\\b" + name + "\\b"));
+            jumpToDefinition(block.blockNumber() + 1, qMax(0, column));
+            return;
+        }
+    }
+    emit definitionNotFound(name);
+}
+
+void PyEditor::jumpToDefinition(int lineNumber, int column)
+{
+    const QTextBlock block = document()->findBlockByNumber(lineNumber - 1);
+    if (!block.isValid()) {
+        return;
+    }
+    QTextCursor cursor(block);
+    cursor.setPosition(block.position() + qMin(column, block.length() - 1));
+    setTextCursor(cursor);
+    centerCursor();
+}
+
+void PyEditor::setupDiagnostics()
+{
+    // 编辑停顿后在诊断进程中检查，连续输入时不逐键检查
+    diagnosticsTimer = new QTimer(this);
+    diagnosticsTimer->setSingleShot(true);
+    diagnosticsTimer->setInterval(500);
+    connect(diagnosticsTimer, &QTimer::timeout, this, &PyEditor::requestDiagnostics);
+    connect(this, &PyEditor::textChanged, diagnosticsTimer, QOverload<>::of(&QTimer::start));
+}
+
+void PyEditor::requestDiagnostics()
+{
+    if (largeFile || isLoading()) {
+        return;
+    }
+    if (!diagnosticsService) {
+        diagnosticsService = new DiagnosticsService(this);
+        connect(diagnosticsService, &DiagnosticsService::diagnosticsReady, this, &PyEditor::showDiagnostics);
+    }
+    diagnosticsService->check(textRevision, toPlainText());
+}
+
+void PyEditor::showDiagnostics(quint64 revision, const QVector<SyntaxCheck::Diagnostic>& diagnostics)
+{
+    // 检查期间代码又被修改：等待下一次检查的结果
+    if (revision != textRevision) {
+        return;
+    }
+
+    diagnosticMarks.clear();
+    for (const SyntaxCheck::Diagnostic& diagnostic : diagnostics) {
+        const QTextBlock block = document()->findBlockByNumber(diagnostic.line - 1);
+        if (!block.isValid()) {
+            continue;
+        }
+
+        // 没有结束列时标到行尾；范围为空（如行尾的错误）时标出前一个字符
+        const int length = block.length() - 1;
+        const int column = qMin(diagnostic.column, length);
+        const int end    = diagnostic.endColumn < 0 ? length : qBound(column, diagnostic.endColumn, length);
+        DiagnosticMark mark;
+        mark.diagnostic = diagnostic;
+        mark.cursor     = QTextCursor(block);
+        mark.cursor.setPosition(block.position() + (end > column ? column : qMax(0, column - 1)));
+        mark.cursor.setPosition(block.position() + qMax(end, qMin(column + 1, length)), QTextCursor::KeepAnchor);
+        diagnosticMarks.append(mark);
+    }
+    updateExtraSelections();
+    ++gutterMarks.revision;
+    lineNumberArea->update();
+}
+
+QVector<SyntaxCheck::Diagnostic> PyEditor::diagnostics() const
+{
+    QVector<SyntaxCheck::Diagnostic> result;
+    for (const DiagnosticMark& mark : diagnosticMarks) {
+        result.append(mark.diagnostic);
+        result.last().line = mark.cursor.block().blockNumber() + 1;
+    }
+    return result;
+}
+
+bool PyEditor::viewportEvent(QEvent* event)
+{
+    // 鼠标停在诊断范围上时显示信息
+    if (event->type() == QEvent::ToolTip && !diagnosticMarks.isEmpty()) {
+        QHelpEvent* helpEvent = static_cast<QHelpEvent*>(event);
+        const int   position  = cursorForPosition(helpEvent->pos()).position();
+        QStringList messages;
+        for (const DiagnosticMark& mark : diagnosticMarks) {
+            if (position >= mark.cursor.selectionStart() && position <= mark.cursor.selectionEnd()) {
+                messages.append(mark.diagnostic.message);
+            }
+        }
+        if (!messages.isEmpty()) {
+            QToolTip::showText(helpEvent->globalPos(), messages.join('\n'), viewport());
+            return true;
+        }
+    }
+    return QPlainTextEdit::viewportEvent(event);
+}
+
+void PyEditor::insertCompletion(const QString& completion)
+{
+    if (completer->widget() != this) {
+        return;
+    }
+
+    // 替换光标前已输入的部分
+    QTextCursor cursor = textCursor();
+    cursor.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor, wordBeforeCursor().size());
+    cursor.insertText(completion);
+    setTextCursor(cursor);
 }
 
 void PyEditor::toggleBreakpoint(int lineNumber)
 {
     if (breakpoints.contains(lineNumber)) {
-        breakpoints.remove(lineNumber);
-        emit breakpointChanged(lineNumber, false);
+        removeBreakpoint(lineNumber);
+        return;
     }
-    else {
-        breakpoints.insert(lineNumber);
+
+    Breakpoint breakpoint;
+    breakpoint.line = lineNumber;
+    breakpoints.insert(lineNumber, breakpoint);
+    emit breakpointChanged(lineNumber, true);
+    publishBreakpoints();
+}
+
+void PyEditor::editBreakpoint(int lineNumber, bool logpoint)
+{
+    Breakpoint breakpoint = breakpoints.value(lineNumber);
+    breakpoint.line       = lineNumber;
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("第%1行的断点").arg(lineNumber));
+
+    QLineEdit* conditionEdit = new QLineEdit(breakpoint.condition, &dialog);
+    conditionEdit->setPlaceholderText("Python表达式，为真时暂停；留空表示无条件");
+    QLineEdit* hitEdit = new QLineEdit(breakpoint.hitCondition, &dialog);
+    hitEdit->setPlaceholderText("5：第5次  >=5：第5次起  >5：第5次后  %5：每5次");
+    QLineEdit* logEdit = new QLineEdit(breakpoint.logMessage, &dialog);
+    logEdit->setPlaceholderText("如 i = {i}；填写后只输出消息，不暂停");
+
+    QDialogButtonBox* buttons =
+        new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, [&]() {
+        // 设置时检查格式和语法，错误不会等到运行到断点才发现
+        if (!BreakpointTable::isValidHitCondition(hitEdit->text())) {
+            QMessageBox::warning(&dialog, "断点", "命中次数的格式不正确");
+            return;
+        }
+        const QString error = BreakpointTable::checkCondition(conditionEdit->text());
+        if (!error.isEmpty()) {
+            QMessageBox::warning(&dialog, "断点", "条件表达式有误：" + error);
+            return;
+        }
+        const QString logError = BreakpointTable::checkLogMessage(logEdit->text());
+        if (!logError.isEmpty()) {
+            QMessageBox::warning(&dialog, "断点", "日志消息有误：" + logError);
+            return;
+        }
+        dialog.accept();
+    });
+
+    QFormLayout* layout = new QFormLayout(&dialog);
+    layout->addRow("条件:", conditionEdit);
+    layout->addRow("命中次数:", hitEdit);
+    layout->addRow("日志消息:", logEdit);
+    layout->addRow(buttons);
+
+    if (logpoint) {
+        logEdit->setFocus();
+    }
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    const bool added        = !breakpoints.contains(lineNumber);
+    breakpoint.condition    = conditionEdit->text().trimmed();
+    breakpoint.hitCondition = hitEdit->text().trimmed();
+    breakpoint.logMessage   = logEdit->text();
+    breakpoints.insert(lineNumber, breakpoint);
+    if (added) {
         emit breakpointChanged(lineNumber, true);
     }
-    emit breakpointsChanged(breakpoints);
+    publishBreakpoints();
+}
+
+void PyEditor::removeBreakpoint(int lineNumber)
+{
+    if (breakpoints.remove(lineNumber) == 0) {
+        return;
+    }
+    emit breakpointChanged(lineNumber, false);
+    publishBreakpoints();
+}
+
+void PyEditor::publishBreakpoints()
+{
+    emit breakpointsChanged(breakpoints.values().toVector());
     // 更新行号区域
+    ++gutterMarks.revision;
     update();
     updateLineNumberAreaWidth();
 }
@@ -602,4 +1424,9 @@ int PyEditor::lineNumberAtPosition(const QPoint& pos) const
 void PyEditor::mousePressEvent(QMouseEvent* event)
 {
     QPlainTextEdit::mousePressEvent(event);
+
+    // Ctrl+单击跳转到定义（光标已移到单击处）
+    if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier)) {
+        goToDefinition();
+    }
 }
@@ -1,24 +1,45 @@
 #pragma once
 
+#include <QCompleter>
 #include <QDebug>
 #include <QFile>
+#include <QFont>
+#include <QHelpEvent>
+#include <QMap>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QPaintEvent>
+#include <QPixmap>
 #include <QPlainTextEdit>
 #include <QRegularExpression>
 #include <QResizeEvent>
 #include <QSettings>
-#include <QSyntaxHighlighter>
+#include <QStringListModel>
+#include <QTextBlock>
 #include <QTextStream>
 #include <QThread>
+#include <QToolTip>
 #include <QTimer>
 #include <QWidget>
 
+#include <memory>
+
+#include "BreakpointTable.h"
+#include "CellDependencies.h"
+#include "CellIndex.h"
+#include "CodeFormatter.h"
+#include "OutlineIndex.h"
+#include "SyntaxCheck.h"
+
 class CodeRunner;
+class CompletionEngine;
 class ConfigManager;
+class DiagnosticsService;
+class FileLoader;
+class HighlightEngine;
 class LineNumberArea;
-class PythonHighlighter;
+class LineProfile;
+class SaveService;
 
 class PyEditor : public QPlainTextEdit
 {
@@ -46,6 +67,12 @@ public:
      */
     void setCurrentLine(int line);
 
+    /**
+     * @brief 显示回放中的当前行：高亮并滚动到可见，不移动光标
+     * @param line 行号（1-based）
+     */
+    void showReplayLine(int line);
+
     /**
      * @brief 行号区域绘制事件
      */
@@ -56,6 +83,20 @@ public:
      */
     void lineNumberAreaMousePressEvent(const QPoint& pos);
 
+    /**
+     * @brief 行号区域右键菜单事件（添加、编辑或删除条件断点）
+     * @param pos 编辑器坐标
+     * @param globalPos 屏幕坐标
+     */
+    void lineNumberAreaContextMenuEvent(const QPoint& pos, const QPoint& globalPos);
+
+    /**
+     * @brief 行号区域的提示：该行的诊断信息
+     * @param pos 行号区域坐标
+     * @return QString 提示文字，没有诊断时为空
+     */
+    QString lineNumberAreaToolTip(const QPoint& pos) const;
+
     /**
      * @brief 计算行号区域宽度
      * @return int 行号区域像素宽度
@@ -64,29 +105,158 @@ public:
 
     /**
      * @brief 加载代码文件
+     *
+     * 后台线程分块解码（见FileLoader），每次事件循环追加一块，加载期间编辑器只读，
+     * 进度通过loadProgress()报告，结束时发出loadFinished()。
+     * 超过大文件阈值的文件以大文件模式打开（见setLargeFileMode()）。
      * @param filePath 文件路径
-     * @return bool 加载成功返回true
+     * @return bool 文件无法打开时返回false，否则开始加载并返回true
      */
     bool loadFromFile(const QString& filePath);
 
     /**
-     * @brief 保存代码到文件
+     * @brief 是否正在加载文件
+     * @return bool 正在加载返回true
+     */
+    bool isLoading() const;
+
+    /**
+     * @brief 设置大文件模式：只读、不做语法高亮、不划分单元格、不建立大纲
+     * @param enabled 是否启用
+     */
+    void setLargeFileMode(bool enabled);
+
+    /**
+     * @brief 是否处于大文件模式
+     * @return bool 大文件模式返回true
+     */
+    bool isLargeFile() const { return largeFile; }
+
+    /**
+     * @brief 保存代码到文件（同步，原子替换）
      * @param filePath 文件路径
      * @return bool 保存成功返回true
      */
     bool saveToFile(const QString& filePath) const;
 
     /**
-     * @brief 格式化代码（缩进对齐）
+     * @brief 在后台线程中保存代码到文件（原子替换），结果通过fileSaved()/fileSaveFailed()报告
+     *
+     * 自上次保存到该文件后文本没有修改时不取快照也不写入。
+     * @param filePath 文件路径
+     * @return bool 提交了保存返回true，文本未修改返回false
+     */
+    bool saveToFileAsync(const QString& filePath);
+
+    /**
+     * @brief 把当前文本记为与文件内容一致（刚从文件读入时调用），之后未修改时不再保存
+     * @param filePath 文件路径
+     */
+    void markSaved(const QString& filePath);
+
+    /**
+     * @brief 格式化代码
+     *
+     * 在后台线程中格式化（见CodeFormatter），完成后只把有变化的行在一个编辑块中替换，
+     * 可以一次撤销；格式化期间代码又被修改时放弃结果。结果通过formatFinished()/formatFailed()报告。
      */
     void formatCode();
 
+    /**
+     * @brief 请求代码补全
+     *
+     * 补全在后台线程中计算（见CompletionEngine），结果到达时光标已移动或代码已修改则丢弃。
+     * 输入名字或“.”后停顿时自动请求，Ctrl+Space手动请求。
+     * @param forced 是否为手动请求（光标前没有输入名字时也列出候选）
+     */
+    void requestCompletion(bool forced = false);
+
+    /**
+     * @brief 获取大纲中的类和函数定义
+     * @return QVector<OutlineIndex::Symbol> 按行号排列的定义
+     */
+    QVector<OutlineIndex::Symbol> outlineSymbols() const { return outlineIndex.symbols(); }
+
+    /**
+     * @brief 跳转到光标处名字的定义（F12或Ctrl+单击）
+     *
+     * 先在大纲中查找类和函数，再向上查找赋值、导入等绑定；找不到时发出definitionNotFound()。
+     */
+    void goToDefinition();
+
+    /**
+     * @brief 当前的诊断（行号按编辑后的位置）
+     * @return QVector<SyntaxCheck::Diagnostic> 诊断
+     */
+    QVector<SyntaxCheck::Diagnostic> diagnostics() const;
+
+    /**
+     * @brief 清除行号区域的性能热力图
+     */
+    void clearLineProfile();
+
+    /**
+     * @brief 获取光标所在的单元格
+     * @return int 单元格下标，缓冲区没有代码时为-1
+     */
+    int currentCell();
+
+    /**
+     * @brief 获取所有单元格
+     * @return QVector<int> 单元格下标
+     */
+    QVector<int> allCells();
+
+    /**
+     * @brief 获取需要重新运行的单元格
+     *
+     * 自上次运行后修改过的单元格，加上读取其写入的全局变量、因而结果已失效的单元格（见CellDependencies）。
+     * @return QVector<int> 单元格下标，按行号排列
+     */
+    QVector<int> changedCells();
+
+    /**
+     * @brief 生成只包含指定单元格的代码（其他行替换为空行，行号不变）
+     * @param cells 单元格下标
+     * @return QString 代码
+     */
+    QString cellCode(const QVector<int>& cells);
+
+    /**
+     * @brief 获取单元格当前内容的哈希，运行成功后交给markCellsExecuted()
+     * @param cells 单元格下标
+     * @return QVector<uint> 哈希
+     */
+    QVector<uint> cellHashes(const QVector<int>& cells);
+
+    /**
+     * @brief 把单元格内容记为已运行，行号区域不再标记为已修改
+     * @param hashes cellHashes()的返回值
+     */
+    void markCellsExecuted(const QVector<uint>& hashes);
+
+    /**
+     * @brief 所有单元格重新标记为已修改（会话命名空间重置后调用）
+     */
+    void invalidateCells();
+
 signals:
     /**
      * @brief 代码改变信号
      */
     void codeChanged();
 
+    /**
+     * @brief 大纲变化（编辑停顿后发出）
+     */
+    void outlineChanged();
+
+    /**
+     * @brief 没有找到定义
+     * @param name 光标处的名字
+     */
+    void definitionNotFound(const QString& name);
+
     /**
      * @brief 行号改变信号
      */
@@ -100,17 +270,70 @@ signals:
     /**
      * @brief 断点列表变化信号
      */
-    void breakpointsChanged(const QSet<int>& breakpoints);
+    void breakpointsChanged(const QVector<Breakpoint>& breakpoints);
+
+    /**
+     * @brief 文件加载进度信号
+     * @param loadedBytes 已追加的字节数
+     * @param totalBytes 文件总字节数
+     */
+    void loadProgress(qint64 loadedBytes, qint64 totalBytes);
+
+    /**
+     * @brief 文件加载结束信号（被新的加载取消时不发出）
+     */
+    void loadFinished();
+
+    /**
+     * @brief 后台保存完成信号
+     * @param filePath 文件路径
+     */
+    void fileSaved(const QString& filePath);
+
+    /**
+     * @brief 后台保存失败信号
+     * @param filePath 文件路径
+     * @param error 失败原因
+     */
+    void fileSaveFailed(const QString& filePath, const QString& error);
+
+    /**
+     * @brief 格式化完成信号
+     * @param formatterName 使用的格式化工具
+     * @param changedLines 替换的行数，0表示代码已符合格式
+     */
+    void formatFinished(const QString& formatterName, int changedLines);
+
+    /**
+     * @brief 格式化失败信号
+     * @param error 失败原因
+     */
+    void formatFailed(const QString& error);
 
 protected:
     void resizeEvent(QResizeEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+    bool viewportEvent(QEvent* event) override;
 
 private slots:
+    void startLineSampling();
+    void stopLineSampling();
+    void sampleExecutionLine();
     void updateLineNumberAreaWidth();
     void updateLineNumberArea(const QRect& rect, int dy);
     void highlightCurrentLine();
     void onCodeChanged();
+    void refreshCells();
+    void updateCellDependencies();
+    void updateAffectedCells();
+    void appendLoadedChunk();
+    void applyFormatting(quint64 revision, const QVector<CodeFormatter::LineEdit>& edits, const QString& formatterName);
+    void showCompletions(quint64 id, const QString& prefix, const QStringList& candidates);
+    void insertCompletion(const QString& completion);
+    void updateOutline(int position, int charsRemoved, int charsAdded);
+    void requestDiagnostics();
+    void showDiagnostics(quint64 revision, const QVector<SyntaxCheck::Diagnostic>& diagnostics);
 
 private:
     void setupEditor();
@@ -118,21 +341,95 @@ private:
     void setupLineNumberArea();
     void setupAutoSave();
     void setupSyntaxHighlighting();
+    void setupCompletion();
+    void setupOutline();
+    void rebuildOutline();
+    void setupDiagnostics();
     void toggleBreakpoint(int lineNumber);
+    void editBreakpoint(int lineNumber, bool logpoint = false);
+    void removeBreakpoint(int lineNumber);
+    void publishBreakpoints();
     int  lineNumberAtPosition(const QPoint& pos) const;
+    QTextBlock executionLineBlock();
+    QRect      visibleLineRect(const QTextBlock& block) const;
+    void       updateLineRect(const QTextBlock& block);
+    void       updateGutterDigits();
+    void       updateGutterMarks();
+    QString    wordBeforeCursor() const;
+    void       jumpToDefinition(int lineNumber, int column);
 
 protected:
     void mousePressEvent(QMouseEvent* event) override;
 
 private:
+    // 一条诊断及其在文档中的范围，光标随编辑移动，下次检查前标记仍在原来的代码上
+    struct DiagnosticMark
+    {
+        QTextCursor             cursor;
+        SyntaxCheck::Diagnostic diagnostic;
+    };
+
+    // 行号数字的预渲染图像：0到9排成一条，普通行和执行行（蓝色粗体）各一条，
+    // 字体或设备像素比变化时重新生成
+    struct GutterDigits
+    {
+        QFont   font;
+        qreal   ratio  = 0;
+        int     width  = 0;   // 每个数字的宽度（两种样式中最宽的数字）
+        int     height = 0;
+        QPixmap strips[2];
+    };
+
+    // 行号区域标记层（背景、热力图、单元格状态条、断点和诊断）的缓存图像：标记、文本或大小变化时重画，
+    // 滚动时移动已画好的部分、只补画新露出的行；执行行移动等其余重绘直接贴图，再在上面拼行号
+    struct GutterMarks
+    {
+        QPixmap pixmap;
+        quint64 revision      = 0;    // 标记每次变化加一
+        quint64 drawnRevision = 0;    // 画图时的标记版本
+        quint64 textRevision  = 0;    // 画图时的文本版本
+        int     lineHeight    = 0;
+        int     firstBlock    = -1;   // 画图时第一个可见块及其顶端位置
+        int     top           = 0;
+        int     scrolled      = 0;    // 上次画图后累计的滚动距离
+    };
+
     LineNumberArea*    lineNumberArea    = nullptr;
     CodeRunner*        codeRunner        = nullptr;
     ConfigManager*     configManager     = nullptr;
-    PythonHighlighter* syntaxHighlighter = nullptr;
+    HighlightEngine*   syntaxHighlighter = nullptr;
     int                currentLine       = -1;
+    QTextBlock         executionBlock;              // currentLine对应的块，编辑后清空，用到时重新查找
+    GutterDigits       gutterDigits;
+    GutterMarks        gutterMarks;
     QTimer*            changeTimer       = nullptr;
+    QTimer*            lineSampleTimer   = nullptr;   // 按刷新率采样执行行
     QString            currentFilePath;
-    QSet<int>          breakpoints;   // 断点行号集合
+    SaveService*       saveService  = nullptr;      // 后台保存
+    CodeFormatter*     formatter    = nullptr;      // 后台格式化，第一次格式化时创建
+    CompletionEngine*  completionEngine   = nullptr;   // 后台补全，第一次补全时创建
+    QCompleter*        completer          = nullptr;
+    QStringListModel*  completionModel    = nullptr;
+    QTimer*            completionTimer    = nullptr;   // 输入停顿后请求补全
+    quint64            completionId       = 0;         // 最近一次补全请求的编号
+    quint64            completionRevision = 0;         // 请求时的文本版本
+    int                completionPosition = -1;        // 请求时的光标位置
+    OutlineIndex       outlineIndex;                   // 按行维护的类和函数定义
+    QTimer*            outlineTimer = nullptr;         // 编辑停顿后通知大纲变化
+    DiagnosticsService*     diagnosticsService = nullptr;   // 诊断进程，第一次检查时启动
+    QTimer*                 diagnosticsTimer   = nullptr;   // 编辑停顿后检查
+    QVector<DiagnosticMark> diagnosticMarks;
+    quint64            textRevision = 0;            // 文本每次修改加一
+    QString            loadingFilePath;             // 加载完成后成为currentFilePath
+    FileLoader*        fileLoader = nullptr;
+    bool               largeFile  = false;          // 大文件模式
+    QMap<int, Breakpoint> breakpoints;   // 断点，按行号排序
+    std::shared_ptr<LineProfile> lineProfile;   // 行号区域热力图的数据，编辑代码后清除
+    CellIndex          cellIndex;                // "# %%"单元格及其运行状态
+    QTimer*            cellTimer  = nullptr;     // 编辑停顿后重新划分单元格
+    bool               cellsDirty = true;        // 文本变化后尚未重新划分
+    CellDependencies   cellDependencies;         // 单元格之间的全局变量依赖，后台线程分析
+    QSet<int>          affectedCells;            // 未修改但依赖已修改单元格的单元格
 };
 
 class LineNumberArea : public QWidget
@@ -150,12 +447,37 @@ protected:
 
     void mousePressEvent(QMouseEvent* event) override
     {
-        // 捕获鼠标点击事件，转发给PyEditor
+        // 捕获左键点击事件，转发给PyEditor（右键由上下文菜单处理）
+        if (event->button() != Qt::LeftButton) {
+            return;
+        }
         QPoint localPos  = event->pos();
         QPoint editorPos = mapToParent(localPos);
         codeEditor->lineNumberAreaMousePressEvent(editorPos);
     }
 
+    void contextMenuEvent(QContextMenuEvent* event) override
+    {
+        codeEditor->lineNumberAreaContextMenuEvent(mapToParent(event->pos()), event->globalPos());
+    }
+
+    bool event(QEvent* event) override
+    {
+        if (event->type() == QEvent::ToolTip) {
+            QHelpEvent*   helpEvent = static_cast<QHelpEvent*>(event);
+            const QString text      = codeEditor->lineNumberAreaToolTip(helpEvent->pos());
+            if (text.isEmpty()) {
+                QToolTip::hideText();
+                event->ignore();
+            }
+            else {
+                QToolTip::showText(helpEvent->globalPos(), text, this);
+            }
+            return true;
+        }
+        return QWidget::event(event);
+    }
+
 private:
     PyEditor* codeEditor;
 };
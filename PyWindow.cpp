@@ -1,28 +1,51 @@
 #include "PyWindow.h"
 #include "CodeRunner.h"
+#include "ExecutionRecording.h"
+#include "ExecutionServer.h"
+#include "ConfigManager.h"
+#include "FlameGraph.h"
+#include "FlameGraphView.h"
+#include "ImageView.h"
+#include "OutlineView.h"
+#include "OutputConsole.h"
+#include "OutputLog.h"
+#include "OutputSearch.h"
+#include "ProfileView.h"
 #include "PyEditor.h"
 #include "PythonInterpreterManager.h"
+#include "RemoteCodeRunner.h"
+#include "ReplayView.h"
+#include "RunMetricsView.h"
+#include "VariablesView.h"
+#include "WatchesView.h"
 
 #include <QApplication>
 #include <QCloseEvent>
 #include <QDir>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QHBoxLayout>
 #include <QInputDialog>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QScrollArea>
+#include <QShortcut>
 #include <QSplitter>
+#include <QTabBar>
 #include <QStandardPaths>
 #include <QStatusBar>
+#include <QTextBlock>
 #include <QTextStream>
 #include <QThread>
 #include <QTimer>
 #include <QToolBar>
 #include <QVBoxLayout>
 
+#include <algorithm>
+
 PyWindow::PyWindow(QWidget* parent)
     : QMainWindow(parent)
-    , m_settings("QtPythonEmbedTest2", "Settings")
 {
     // 设置窗口属性
     setWindowTitle("Python Code Editor & Runner - 重构版");
@@ -31,8 +54,8 @@ PyWindow::PyWindow(QWidget* parent)
 
     // 初始化组件
     initializeUI();
-    initializePython();
     connectSignals();
+    initializePython();
 
     // 加载设置和示例代码
     loadWindowSettings();
@@ -49,17 +72,23 @@ PyWindow::~PyWindow()
 {
     // 保存设置
     saveWindowSettings();
-    saveCurrentCode();
+    saveAllTabs();
 
     // 清理资源
-    if (m_runnerThread) {
-        m_runnerThread->quit();
-        m_runnerThread->wait();
-        delete m_runnerThread;
+    delete m_executionServer;
+    m_executionServer = nullptr;
+    for (EditorTab* tab : m_tabs) {
+        destroyTab(tab);
     }
-
-    if (m_runner) {
-        delete m_runner;
+    m_tabs.clear();
+    m_currentTab = nullptr;
+
+    // 导出中途退出时放弃写了一半的文件
+    if (m_exportThread) {
+        m_exportCancelled = true;
+        m_exportThread->wait();
+        delete m_exportThread;
+        m_exportThread = nullptr;
     }
 
     // Python解释器清理由管理器负责
@@ -85,22 +114,99 @@ void PyWindow::initializeUI()
     m_runButton->setShortcut(QKeySequence::Refresh);
     m_runButton->setToolTip("运行当前Python代码");
 
+    m_profileButton = new QPushButton("性能分析 (Ctrl+F5)");
+    m_profileButton->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_F5));
+    m_profileButton->setToolTip("运行当前代码并统计每行的执行次数和耗时\n"
+                                "分析期间每行都经过追踪函数，运行速度明显变慢");
+
+    m_sampleButton = new QPushButton("采样分析");
+    m_sampleButton->setToolTip("运行当前代码，按固定频率采样调用栈并生成火焰图\n"
+                               "不使用追踪函数，对运行速度影响很小");
+
+    m_recordButton = new QPushButton("录制运行");
+    m_recordButton->setToolTip("运行当前代码并录制执行过的每一行（和局部变量的变化），\n"
+                               "结束后在\"回放\"页中前后拖动查看，不需要重新运行");
+
+    m_runCellButton = new QPushButton("运行单元格 (Ctrl+Enter)");
+    m_runCellButton->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_Return));
+    m_runCellButton->setToolTip("在会话命名空间中运行光标所在的单元格\n"
+                                "单元格以顶格的\"# %%\"注释行分隔");
+
+    m_runChangedButton = new QPushButton("运行已修改单元格 (Ctrl+Shift+Enter)");
+    m_runChangedButton->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_Return));
+    m_runChangedButton->setToolTip("在会话命名空间中按顺序运行修改过的单元格和依赖其结果的单元格\n"
+                                   "行号区域左侧橙色为已修改，黄色为依赖已修改的单元格，绿色为已运行");
+
     m_clearButton = new QPushButton("清除输出");
     m_clearButton->setToolTip("清除输出窗口中的所有文本");
 
     m_saveButton = new QPushButton("保存代码");
-    m_saveButton->setToolTip("保存当前代码到文件");
+    m_saveButton->setToolTip("保存当前标签页的代码到文件");
+
+    m_newTabButton = new QPushButton("新建标签页 (Ctrl+T)");
+    m_newTabButton->setShortcut(QKeySequence::AddTab);
+    m_newTabButton->setToolTip("新建空白标签页；每个标签页有自己的断点、输出和会话变量，\n"
+                               "在后台标签页中运行的代码在编辑其他标签页时继续运行");
+
+    m_formatButton = new QPushButton("格式化代码");
+    m_formatButton->setToolTip("在后台格式化当前代码（已安装black时使用black），只替换有变化的行，可以撤销");
+
+    m_openButton = new QPushButton("打开文件");
+    m_openButton->setToolTip("在新标签页中打开脚本或数据文件，后台分块加载\n"
+                             "超过大文件阈值的文件以只读方式打开，不做语法高亮");
+
+    m_sessionCheck = new QCheckBox("保留会话变量");
+    m_sessionCheck->setToolTip("勾选后多次运行共用同一个命名空间；\n"
+                               "不勾选时每次运行使用全新的命名空间，已导入的模块仍然保留");
+    m_sessionCheck->setChecked(ConfigManager::instance().getPersistentNamespace());
+
+    m_checkpointCheck = new QCheckBox("退出时保存会话");
+    m_checkpointCheck->setToolTip("退出时把草稿标签页的会话变量中可序列化的部分保存为检查点，\n"
+                                  "下次启动后第一次运行时直接恢复，不需要重新运行产生它们的代码；\n"
+                                  "模块重新导入，在代码中定义的函数和类需要重新运行定义它们的代码");
+    m_checkpointCheck->setChecked(ConfigManager::instance().getSessionCheckpoint());
+
+    m_memoryCheck = new QCheckBox("内存统计");
+    m_memoryCheck->setToolTip("运行期间开启tracemalloc并采样进程常驻内存，\n"
+                              "结束后报告内存峰值、占用最多的代码行和与上一次运行相比的增长；\n"
+                              "开启后Python分配会明显变慢");
+    m_memoryCheck->setChecked(ConfigManager::instance().getMemoryTracking());
+
+    m_objectsCheck = new QCheckBox("对象诊断");
+    m_objectsCheck->setToolTip("运行前后各做一次完整的垃圾回收并比较存活的对象，\n"
+                               "报告按类型的对象数变化，以及运行结束后不属于本次命名空间、\n"
+                               "被模块、其他对象或C++宿主持有的对象；对象多时每次运行增加明显的停顿");
+    m_objectsCheck->setChecked(ConfigManager::instance().getObjectDiagnostics());
 
     m_settingsButton = new QPushButton("设置");
     m_settingsButton->setToolTip("打开Python环境设置");
 
+    m_restartButton = new QPushButton("重启解释器");
+    m_restartButton->setToolTip("销毁并重新初始化Python解释器，用于解释器状态损坏时恢复；\n"
+                                "编辑器内容和断点保留，会话变量丢失");
+
     // 添加按钮到工具栏
     toolbar->addWidget(m_runButton);
+    toolbar->addWidget(m_profileButton);
+    toolbar->addWidget(m_sampleButton);
+    toolbar->addWidget(m_recordButton);
+    toolbar->addSeparator();
+    toolbar->addWidget(m_runCellButton);
+    toolbar->addWidget(m_runChangedButton);
     toolbar->addSeparator();
     toolbar->addWidget(m_clearButton);
+    toolbar->addWidget(m_newTabButton);
+    toolbar->addWidget(m_openButton);
     toolbar->addWidget(m_saveButton);
+    toolbar->addWidget(m_formatButton);
+    toolbar->addSeparator();
+    toolbar->addWidget(m_sessionCheck);
+    toolbar->addWidget(m_checkpointCheck);
+    toolbar->addWidget(m_memoryCheck);
+    toolbar->addWidget(m_objectsCheck);
     toolbar->addSeparator();
     toolbar->addWidget(m_settingsButton);
+    toolbar->addWidget(m_restartButton);
 
     // 创建调试工具栏
     QToolBar* debugToolbar = addToolBar("Debug");
@@ -108,6 +214,10 @@ void PyWindow::initializeUI()
     debugToolbar->setMovable(false);
 
     // 创建调试按钮
+    m_pauseButton = new QPushButton("暂停");
+    m_pauseButton->setToolTip("在下一行代码处暂停执行");
+    m_pauseButton->setEnabled(false);
+
     m_continueButton = new QPushButton("继续");
     m_continueButton->setToolTip("继续执行代码");
     m_continueButton->setEnabled(false);
@@ -124,210 +234,1347 @@ void PyWindow::initializeUI()
     m_stepOutButton->setToolTip("执行完当前函数，返回调用者");
     m_stepOutButton->setEnabled(false);
 
+    m_threadCombo = new QComboBox;
+    m_threadCombo->setToolTip("断点、暂停和单步作用的线程；\n"
+                              "运行中用threading启动的线程会出现在这里，其余线程不受调试影响、以原速运行");
+    m_threadCombo->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_threadCombo->setEnabled(false);
+
     // 添加调试按钮到调试工具栏
+    debugToolbar->addWidget(m_pauseButton);
     debugToolbar->addWidget(m_continueButton);
     debugToolbar->addWidget(m_stepIntoButton);
     debugToolbar->addWidget(m_stepOverButton);
     debugToolbar->addWidget(m_stepOutButton);
-
-    // 创建代码编辑器和输出窗口
-    m_codeEditor = new PyEditor;
-    m_logOutput  = new QTextEdit;
-
-    // 设置输出窗口属性
-    m_logOutput->setReadOnly(true);
-    m_logOutput->setStyleSheet(
-        "background-color: #f8f8f8; font-family: 'Consolas', 'Courier New', monospace;");
-    m_logOutput->setPlaceholderText("Python代码输出将显示在这里...\n"
-                                    "错误信息将以红色显示。");
+    debugToolbar->addSeparator();
+    debugToolbar->addWidget(m_threadCombo);
+
+    // 编辑器标签页，每页的编辑器和输出窗口在createTab()中创建
+    m_editorTabs = new QTabWidget;
+    m_editorTabs->setTabsClosable(true);
+    m_editorTabs->setMovable(false);
+    m_editorTabs->setDocumentMode(true);
+    m_outputStack = new QStackedWidget;
+
+    // 输出窗口下方是标准输入行，代码调用input()时在这里输入
+    m_inputEdit = new QLineEdit;
+    m_inputEdit->setPlaceholderText("程序输入（回车发送一行，Ctrl+D结束输入）");
+    m_inputFileButton = new QPushButton("文件输入...");
+    m_inputFileButton->setToolTip("把文件的全部内容作为标准输入");
+
+    QHBoxLayout* inputLayout = new QHBoxLayout;
+    inputLayout->setContentsMargins(0, 0, 0, 0);
+    inputLayout->addWidget(m_inputEdit);
+    inputLayout->addWidget(m_inputFileButton);
+
+    // 输出窗口上方是搜索行：在后台搜索全部输出（包括溢出到磁盘的部分），结果边找边高亮
+    m_searchEdit = new QLineEdit;
+    m_searchEdit->setPlaceholderText("在输出中查找（Ctrl+Shift+F，回车下一个，Shift+回车上一个）");
+    m_searchEdit->setClearButtonEnabled(true);
+    m_searchCaseCheck = new QCheckBox("区分大小写");
+    m_searchStatus    = new QLabel;
+    m_exportButton    = new QPushButton("导出输出...");
+    m_exportButton->setToolTip("在后台把当前标签页的全部输出写入文件，包括已溢出到磁盘的部分；\n"
+                               "文件名以.gz结尾时写成gzip压缩文件");
+
+    QHBoxLayout* searchLayout = new QHBoxLayout;
+    searchLayout->setContentsMargins(0, 0, 0, 0);
+    searchLayout->addWidget(m_searchEdit);
+    searchLayout->addWidget(m_searchCaseCheck);
+    searchLayout->addWidget(m_searchStatus);
+    searchLayout->addWidget(m_exportButton);
+
+    m_outputSearch = new OutputSearch(this);
+    m_searchTimer  = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(250);
+
+    m_outputPage              = new QWidget;
+    QVBoxLayout* outputLayout = new QVBoxLayout(m_outputPage);
+    outputLayout->setContentsMargins(0, 0, 0, 0);
+    outputLayout->setSpacing(2);
+    outputLayout->addLayout(searchLayout);
+    outputLayout->addWidget(m_outputStack);
+    outputLayout->addLayout(inputLayout);
+
+    // 输出和性能分析结果分页显示，输出页显示当前标签页的输出窗口
+    m_profileView = new ProfileView;
+    m_outputTabs  = new QTabWidget;
+    m_outputTabs->addTab(m_outputPage, "输出");
+    m_outputTabs->addTab(m_profileView, "性能分析");
+
+    // 火焰图高度随调用栈深度增长，放在滚动区域中
+    m_flameGraphView         = new FlameGraphView;
+    QScrollArea* flameScroll = new QScrollArea;
+    flameScroll->setWidget(m_flameGraphView);
+    flameScroll->setWidgetResizable(true);
+    m_flameGraphTab = flameScroll;
+    m_outputTabs->addTab(m_flameGraphTab, "火焰图");
+
+    m_metricsView = new RunMetricsView;
+    m_outputTabs->addTab(m_metricsView, "运行指标");
+
+    m_variablesView = new VariablesView;
+    m_outputTabs->addTab(m_variablesView, "变量");
+
+    m_watchesView = new WatchesView;
+    m_outputTabs->addTab(m_watchesView, "监视");
+
+    m_replayView = new ReplayView;
+    m_replayView->setStepInterval(ConfigManager::instance().getReplayStepInterval());
+    m_outputTabs->addTab(m_replayView, "回放");
+
+    m_outlineView = new OutlineView;
+    m_outputTabs->addTab(m_outlineView, "大纲");
+
+    m_imageView = new ImageView;
+    m_outputTabs->addTab(m_imageView, "图像");
 
     // 创建分割器
     QSplitter* splitter = new QSplitter(Qt::Vertical);
-    splitter->addWidget(m_codeEditor);
-    splitter->addWidget(m_logOutput);
+    splitter->addWidget(m_editorTabs);
+    splitter->addWidget(m_outputTabs);
     splitter->setSizes({400, 200});
     splitter->setChildrenCollapsible(false);
 
     mainLayout->addWidget(splitter);
 
     // 创建状态栏
+    m_loadProgress = new QProgressBar;
+    m_loadProgress->setMaximumWidth(200);
+    m_loadProgress->setRange(0, 1000);
+    m_loadProgress->hide();
+    statusBar()->addPermanentWidget(m_loadProgress);
     statusBar()->showMessage("就绪");
 }
 
-void PyWindow::initializePython()
+// 上次代码的保存位置，目录不存在时创建
+static QString lastCodeFilePath()
 {
-    m_pythonManager = &PythonInterpreterManager::instance();
+    const QString appDataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir          dir(appDataDir);
+    if (!dir.exists()) {
+        dir.mkpath(appDataDir);
+    }
+    return dir.filePath("last_code.py");
+}
+
+// 草稿标签页会话检查点的保存位置，与上次代码在同一目录
+static QString sessionCheckpointPath()
+{
+    return QFileInfo(lastCodeFilePath()).dir().filePath("session.ckpt");
+}
 
-    // 初始化Python解释器
-    bool success = m_pythonManager->initialize();
+void PyWindow::initializePython()
+{
+    // 信号在初始化线程中发出，先连接再启动
+    // 运行中的错误由各标签页的运行器报告（errorOccurred），这里不再重复显示
+    connect(m_pythonManager, &PythonInterpreterManager::pythonOutput, this, &PyWindow::appendOutput);
+    connect(m_pythonManager,
+            &PythonInterpreterManager::startupProgress,
+            this,
+            &PyWindow::onPythonStartupProgress);
+    connect(m_pythonManager,
+            &PythonInterpreterManager::initialized,
+            this,
+            &PyWindow::onPythonInitialized);
+    connect(m_pythonManager,
+            &PythonInterpreterManager::initializationFailed,
+            this,
+            &PyWindow::onPythonInitializationFailed);
+    connect(m_pythonManager, &PythonInterpreterManager::warmUpFinished, this, [this]() {
+        reportWarmUp(m_pythonManager->warmUpModules());
+    });
+    connect(m_pythonManager, &PythonInterpreterManager::sessionRestored, this, &PyWindow::reportSessionRestored);
+
+    // 上次退出时保存的会话检查点：现在只映射文件，草稿标签页第一次以会话模式运行时恢复
+    if (m_checkpointCheck->isEnabled() && m_checkpointCheck->isChecked() &&
+        ConfigManager::instance().getPersistentNamespace() && QFileInfo::exists(sessionCheckpointPath())) {
+        QString   error;
+        const int count = m_pythonManager->loadSession(sessionCheckpointPath(), &error);
+        if (count < 0) {
+            m_tabs.first()->output->appendLine("无法读取会话检查点：" + error, OutputConsole::Error);
+        }
+        else if (count > 0) {
+            m_tabs.first()->output->appendLine(
+                QString("会话检查点中有 %1 个变量，将在第一次运行时恢复").arg(count), OutputConsole::Log);
+        }
+    }
 
-    if (!success) {
-        QMessageBox::critical(this,
-                              "初始化错误",
-                              "Python解释器初始化失败！\n"
-                              "请检查Python安装和环境配置。");
+    // 在后台线程中初始化Python解释器，编辑器立即可用，运行请求排队到初始化完成
+    m_pythonManager->setPersistentNamespace(ConfigManager::instance().getPersistentNamespace());
+    m_pythonManager->initializeAsync();
+    statusBar()->showMessage("正在启动Python解释器...");
+
+    // 本地执行服务：外部工具提交的代码在服务自己的运行器中运行，同样排队到初始化完成
+    const QString serverName = ConfigManager::instance().getServerName();
+    if (!serverName.isEmpty()) {
+        m_executionServer = new ExecutionServer(this);
+        if (!m_executionServer->listen(serverName)) {
+            qWarning() << "Execution server cannot listen on" << serverName << ":" << m_executionServer->errorString();
+            delete m_executionServer;
+            m_executionServer = nullptr;
+        }
     }
 }
 
+
 void PyWindow::connectSignals()
 {
+    m_pythonManager = &PythonInterpreterManager::instance();
+
     // 按钮连接
     connect(m_runButton, &QPushButton::clicked, this, &PyWindow::runPythonCode);
+    connect(m_profileButton, &QPushButton::clicked, this, &PyWindow::profilePythonCode);
+    connect(m_sampleButton, &QPushButton::clicked, this, &PyWindow::samplePythonCode);
+    connect(m_recordButton, &QPushButton::clicked, this, &PyWindow::recordPythonCode);
+    connect(m_runCellButton, &QPushButton::clicked, this, &PyWindow::runCurrentCell);
+    connect(m_runChangedButton, &QPushButton::clicked, this, &PyWindow::runChangedCells);
+
+    // 结果页的行号属于产生结果的标签页，跳转前先切换过去
+    auto jumpToResultLine = [this](int lineNumber) {
+        if (m_resultsTab) {
+            m_editorTabs->setCurrentWidget(m_resultsTab->editor);
+            jumpToLine(lineNumber);
+        }
+    };
+    connect(m_profileView, &ProfileView::lineActivated, this, jumpToResultLine);
+    connect(m_flameGraphView, &FlameGraphView::frameActivated, this, jumpToResultLine);
+    connect(m_outlineView, &OutlineView::lineActivated, this, &PyWindow::jumpToLine);
+    connect(m_imageView, &ImageView::firstFrameShown, this, [this]() {
+        m_outputTabs->setCurrentWidget(m_imageView);
+    });
     connect(m_clearButton, &QPushButton::clicked, this, &PyWindow::clearOutput);
+    connect(m_inputEdit, &QLineEdit::returnPressed, this, &PyWindow::submitInput);
+    connect(m_inputFileButton, &QPushButton::clicked, this, &PyWindow::submitInputFile);
+    QShortcut* endInput = new QShortcut(QKeySequence("Ctrl+D"), m_inputEdit);
+    endInput->setContext(Qt::WidgetShortcut);
+    connect(endInput, &QShortcut::activated, this, &PyWindow::closeInput);
+    connect(m_searchEdit, &QLineEdit::textChanged, m_searchTimer, qOverload<>(&QTimer::start));
+    connect(m_searchTimer, &QTimer::timeout, this, &PyWindow::startOutputSearch);
+    connect(m_searchCaseCheck, &QCheckBox::toggled, this, &PyWindow::startOutputSearch);
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, &PyWindow::showNextMatch);
+    QShortcut* previousMatch = new QShortcut(QKeySequence("Shift+Return"), m_searchEdit);
+    previousMatch->setContext(Qt::WidgetShortcut);
+    connect(previousMatch, &QShortcut::activated, this, &PyWindow::showPreviousMatch);
+    QShortcut* findInOutput = new QShortcut(QKeySequence("Ctrl+Shift+F"), this);
+    connect(findInOutput, &QShortcut::activated, this, [this]() {
+        m_outputTabs->setCurrentWidget(m_outputPage);
+        m_searchEdit->setFocus();
+        m_searchEdit->selectAll();
+    });
+    connect(m_outputSearch, &OutputSearch::matchesFound, this, [this](const QVector<int>& lines) {
+        if (!m_searchTab) {
+            return;
+        }
+        m_searchTab->output->addMatches(lines);
+        // 第一批结果到达时就跳到第一个，不等搜索结束
+        if (m_searchIndex < 0) {
+            showSearchMatch(0);
+        }
+        updateSearchStatus();
+    });
+    connect(m_outputSearch,
+            &OutputSearch::finished,
+            this,
+            [this](int matches, qint64 lines, bool truncated, const QString& error) {
+                Q_UNUSED(matches);
+                m_searchTruncated = truncated;
+                updateSearchStatus();
+                if (!error.isEmpty()) {
+                    statusBar()->showMessage("搜索输出失败：" + error, 5000);
+                }
+                else {
+                    statusBar()->showMessage(QString("已搜索%1行输出").arg(lines), 3000);
+                }
+            });
+    connect(m_exportButton, &QPushButton::clicked, this, &PyWindow::exportOutput);
     connect(m_saveButton, &QPushButton::clicked, this, &PyWindow::saveCurrentCode);
+    connect(m_newTabButton, &QPushButton::clicked, this, &PyWindow::newTab);
+    connect(m_openButton, &QPushButton::clicked, this, &PyWindow::openFile);
+    connect(m_formatButton, &QPushButton::clicked, this, [this]() { m_currentTab->editor->formatCode(); });
+    connect(m_editorTabs, &QTabWidget::currentChanged, this, &PyWindow::onCurrentTabChanged);
+    connect(m_editorTabs, &QTabWidget::tabCloseRequested, this, &PyWindow::closeTab);
     connect(m_settingsButton, &QPushButton::clicked, this, &PyWindow::showSettings);
+    connect(m_restartButton, &QPushButton::clicked, this, [this]() { restartInterpreter(); });
+    connect(m_sessionCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        ConfigManager::instance().setPersistentNamespace(checked);
+        m_pythonManager->setPersistentNamespace(checked);
+        for (EditorTab* tab : m_tabs) {
+            if (RemoteCodeRunner* remote = qobject_cast<RemoteCodeRunner*>(tab->runner)) {
+                remote->setPersistentNamespace(checked);
+            }
+            // 取消勾选会清空会话命名空间
+            if (!checked) {
+                tab->editor->invalidateCells();
+            }
+        }
+    });
+
+    connect(m_checkpointCheck, &QCheckBox::toggled, this, [](bool checked) {
+        ConfigManager::instance().setSessionCheckpoint(checked);
+    });
+    connect(m_memoryCheck, &QCheckBox::toggled, this, [](bool checked) {
+        ConfigManager::instance().setMemoryTracking(checked);
+    });
+    connect(m_objectsCheck, &QCheckBox::toggled, this, [](bool checked) {
+        ConfigManager::instance().setObjectDiagnostics(checked);
+    });
+
+    if (ConfigManager::instance().getExecutionBackend() == "process") {
+        // 逐行统计在执行进程中，目前不传回主进程
+        m_profileButton->setEnabled(false);
+        m_profileButton->setToolTip("进程执行后端暂不支持性能分析");
+        m_sampleButton->setEnabled(false);
+        m_sampleButton->setToolTip("进程执行后端暂不支持性能分析");
+        m_recordButton->setEnabled(false);
+        m_recordButton->setToolTip("进程执行后端暂不支持录制运行");
+        m_memoryCheck->setEnabled(false);
+        m_memoryCheck->setToolTip("进程执行后端暂不支持内存统计");
+        m_objectsCheck->setEnabled(false);
+        m_objectsCheck->setToolTip("进程执行后端暂不支持对象诊断");
+        m_checkpointCheck->setEnabled(false);
+        m_checkpointCheck->setToolTip("进程执行后端暂不支持保存会话");
+    }
 
-    // CodeRunner连接
-    m_runner       = new CodeRunner;
-    m_runnerThread = new QThread;
-    m_runner->moveToThread(m_runnerThread);
-    m_runnerThread->start();
-
-    connect(m_runner, &CodeRunner::executionStarted, this, &PyWindow::onExecutionStart);
-    connect(m_runner, &CodeRunner::executionFinished, this, &PyWindow::onExecutionFinish);
-    connect(m_runner, &CodeRunner::outputReceived, this, &PyWindow::appendOutput);
-    connect(m_runner, &CodeRunner::errorOccurred, this, &PyWindow::appendError);
-    connect(m_runner, &CodeRunner::debugStateChanged, this, &PyWindow::onDebugStateChanged);
-
-    // 调试按钮连接
-    Qt::ConnectionType ct = Qt::DirectConnection;
-    connect(m_continueButton, &QPushButton::clicked, m_runner, &CodeRunner::continueExecution, ct);
-    connect(m_stepIntoButton, &QPushButton::clicked, m_runner, &CodeRunner::stepInto, ct);
-    connect(m_stepOverButton, &QPushButton::clicked, m_runner, &CodeRunner::stepOver, ct);
-    connect(m_stepOutButton, &QPushButton::clicked, m_runner, &CodeRunner::stepOut, ct);
-
-    // PyEditor连接
-    m_codeEditor->setCodeRunner(m_runner);
-
-    // Python管理器连接
-    if (m_pythonManager) {
-        connect(m_pythonManager,
-                &PythonInterpreterManager::pythonOutput,
-                this,
-                &PyWindow::appendOutput);
-        connect(
-            m_pythonManager, &PythonInterpreterManager::pythonError, this, &PyWindow::appendError);
+    // 调试按钮作用于当前标签页的运行器（直接调用：执行期间运行线程的事件循环被阻塞）
+    connect(m_pauseButton, &QPushButton::clicked, this, [this]() { m_currentTab->runner->pauseExecution(); });
+    connect(m_continueButton, &QPushButton::clicked, this, [this]() { m_currentTab->runner->continueExecution(); });
+    connect(m_stepIntoButton, &QPushButton::clicked, this, [this]() { m_currentTab->runner->stepInto(); });
+    connect(m_stepOverButton, &QPushButton::clicked, this, [this]() { m_currentTab->runner->stepOver(); });
+    connect(m_stepOutButton, &QPushButton::clicked, this, [this]() { m_currentTab->runner->stepOut(); });
+    connect(m_threadCombo, QOverload<int>::of(&QComboBox::activated), this, [this](int index) {
+        m_currentTab->debugThread = m_threadCombo->itemData(index).value<qulonglong>();
+        m_currentTab->runner->selectDebugThread(m_currentTab->debugThread);
+    });
+
+    // 变量面板按页请求当前标签页的变量，结果在运行线程中取好后发回
+    connect(m_variablesView, &VariablesView::variablesRequested, this, [this](quint64 handle, int start, int count) {
+        m_currentTab->runner->requestVariables(handle, start, count);
+    });
+
+    // 监视表达式对所有标签页生效，每次暂停一起求值
+    connect(m_watchesView, &WatchesView::watchExpressionsChanged, this, [this](const QStringList& expressions) {
+        m_watchExpressions = expressions;
+        for (EditorTab* tab : m_tabs) {
+            tab->runner->setWatchExpressions(expressions);
+        }
+    });
+
+    // 回放时产生录制的标签页的编辑器跟随当前步高亮对应的行；播放间隔保存到配置
+    connect(m_replayView, &ReplayView::lineSelected, this, [this](int line) {
+        if (m_resultsTab) {
+            m_resultsTab->editor->showReplayLine(line);
+        }
+    });
+    connect(m_replayView, &ReplayView::stepIntervalChanged, this, [](int intervalMs) {
+        ConfigManager::instance().setReplayStepInterval(intervalMs);
+    });
+
+    // 第一个标签页是草稿，内容保存在应用数据目录中
+    createTab("草稿");
+}
+
+PyWindow::EditorTab* PyWindow::createTab(const QString& title)
+{
+    EditorTab* tab = new EditorTab;
+    tab->title     = title;
+    tab->editor    = new PyEditor;
+    tab->output    = new OutputConsole;
+
+    // 第一个标签页使用解释器初始的__main__，之后的标签页各用一个会话命名空间
+    if (m_tabCounter > 0) {
+        tab->context = QString("tab%1").arg(m_tabCounter);
+    }
+    ++m_tabCounter;
+
+    // 设置输出窗口属性
+    tab->output->setMaxLines(ConfigManager::instance().getOutputMaxLines());
+    tab->output->setSpillEnabled(ConfigManager::instance().getOutputSpillToDisk());
+    tab->output->setPlaceholderText("Python代码输出将显示在这里...\n"
+                                    "错误信息将以红色显示。");
+
+    // 输出按帧刷新；定时器和下面的连接以输出窗口为上下文，标签页关闭后不再触发
+    tab->flushTimer = new QTimer(tab->output);
+    tab->flushTimer->setSingleShot(true);
+    tab->flushTimer->setInterval(16);
+    connect(tab->flushTimer, &QTimer::timeout, tab->output, [this, tab]() { drainOutput(tab); });
+
+    // 运行器
+    if (ConfigManager::instance().getExecutionBackend() == "process") {
+        // 代码在执行进程中运行，运行器本身留在界面线程；每个标签页有自己的执行进程
+        RemoteCodeRunner* remote = new RemoteCodeRunner;
+        remote->setPersistentNamespace(ConfigManager::instance().getPersistentNamespace());
+        remote->setWarmUpModules(ConfigManager::instance().getWarmUpModules());
+        remote->setSpareWorker(ConfigManager::instance().getSpareWorker());
+        connect(remote, &RemoteCodeRunner::warmUpFinished, this, &PyWindow::reportWarmUp);
+        tab->runner = remote;
+
+        // 手动重启的执行进程就绪后报告耗时
+        connect(remote, &RemoteCodeRunner::workerReady, tab->output, [this, tab]() {
+            if (m_restartTimer.isValid()) {
+                tab->output->appendLine(
+                    QString("执行进程已重启，耗时 %1 ms").arg(m_restartTimer.nsecsElapsed() / 1e6, 0, 'f', 1));
+                statusBar()->showMessage("执行进程已重启", 3000);
+                m_restartTimer.invalidate();
+            }
+        });
+
+        // 执行进程重启后会话命名空间随之丢失
+        connect(remote, &RemoteCodeRunner::workerRestarted, tab->editor, &PyEditor::invalidateCells);
+    }
+    else {
+        tab->runner       = new CodeRunner;
+        tab->runnerThread = new QThread;
+        tab->runner->setNamespaceContext(tab->context);
+        tab->runner->moveToThread(tab->runnerThread);
+        tab->runnerThread->start();
+
+        // 重启解释器前，运行器在运行线程中释放属于旧解释器的对象
         connect(m_pythonManager,
-                &PythonInterpreterManager::initialized,
-                this,
-                &PyWindow::onPythonInitialized);
+                &PythonInterpreterManager::aboutToRestart,
+                tab->runner,
+                &CodeRunner::releasePythonState,
+                Qt::BlockingQueuedConnection);
+    }
+    tab->runner->setWatchExpressions(m_watchExpressions);
+
+    CodeRunner* runner = tab->runner;
+    connect(runner, &CodeRunner::executionStarted, tab->output, [this, tab]() { onExecutionStart(tab); });
+    connect(runner, &CodeRunner::executionFinished, tab->output, [this, tab]() { onExecutionFinish(tab); });
+    connect(runner, &CodeRunner::runSummary, tab->output, [this, tab](const CodeRunner::RunSummary& summary) {
+        onRunSummary(tab, summary);
+    });
+    connect(runner, &CodeRunner::outputReady, tab->output, [this, tab]() { onOutputReady(tab); });
+    connect(runner, &CodeRunner::inputWaitChanged, tab->output, [this, tab](bool waiting) {
+        onInputWaitChanged(tab, waiting);
+    });
+    connect(runner, &CodeRunner::errorOccurred, tab->output, [this, tab](const QString& error) {
+        tab->runFailed = true;
+        appendError(tab, error);
+    });
+    connect(runner, &CodeRunner::debugStateChanged, tab->output, [this, tab](int state) {
+        onDebugStateChanged(tab, state);
+    });
+    connect(runner, &CodeRunner::variablesReady, tab->output, [this, tab](const VariableInspector::Page& page) {
+        if (tab == m_currentTab) {
+            m_variablesView->addPage(page);
+        }
+    });
+    connect(runner, &CodeRunner::watchesReady, tab->output, [this, tab](const QVector<WatchList::Value>& values) {
+        if (tab == m_currentTab) {
+            m_watchesView->setValues(values);
+        }
+    });
+    connect(runner,
+            &CodeRunner::debugThreadsChanged,
+            tab->output,
+            [this, tab](const QVector<CodeRunner::DebugThread>& threads) {
+                // 选中的线程结束后运行器回到运行线程
+                tab->threads = threads;
+                const bool found =
+                    std::any_of(threads.begin(), threads.end(), [tab](const CodeRunner::DebugThread& thread) {
+                        return !thread.main && thread.id == tab->debugThread;
+                    });
+                if (!found) {
+                    tab->debugThread = 0;
+                }
+                if (tab == m_currentTab) {
+                    updateThreadCombo();
+                }
+            });
+
+    // 编辑器连接
+    PyEditor* editor = tab->editor;
+    connect(editor, &PyEditor::outlineChanged, this, [this, tab]() {
+        if (tab == m_currentTab) {
+            m_outlineView->setSymbols(tab->editor->outlineSymbols());
+        }
+    });
+    connect(editor, &PyEditor::definitionNotFound, this, [this](const QString& name) {
+        statusBar()->showMessage(QString("未找到%1的定义").arg(name), 3000);
+    });
+    connect(editor, &PyEditor::formatFinished, this, [this](const QString& formatterName, int changedLines) {
+        statusBar()->showMessage(changedLines > 0
+                                     ? QString("已格式化（%1），修改了%2行").arg(formatterName).arg(changedLines)
+                                     : QString("代码已符合格式（%1）").arg(formatterName),
+                                 3000);
+    });
+    connect(editor, &PyEditor::formatFailed, this, [this](const QString& error) {
+        statusBar()->showMessage("格式化失败：" + error.section('\n', 0, 0), 5000);
+    });
+    connect(editor, &PyEditor::fileSaved, this, [this, tab](const QString& filePath) {
+        if (filePath == lastCodeFilePath() || (tab->filePath == filePath && m_saveRequested.remove(tab))) {
+            statusBar()->showMessage("代码已保存", 2000);
+        }
+    });
+    connect(editor, &PyEditor::fileSaveFailed, this, [this, tab](const QString& filePath, const QString& error) {
+        // 打开的文件自动保存失败只在状态栏提示，下次自动保存会重试
+        if (filePath != lastCodeFilePath() && !m_saveRequested.remove(tab)) {
+            statusBar()->showMessage("自动保存失败：" + error, 5000);
+            return;
+        }
+        QMessageBox::warning(this, "保存失败", "无法保存代码文件！\n" + error);
+    });
+    connect(editor, &PyEditor::loadProgress, this, [this](qint64 loadedBytes, qint64 totalBytes) {
+        m_loadProgress->setValue(totalBytes > 0 ? int(loadedBytes * 1000 / totalBytes) : 1000);
+    });
+    connect(editor, &PyEditor::loadFinished, this, [this, tab]() {
+        m_loadProgress->hide();
+        m_openButton->setEnabled(true);
+        statusBar()->showMessage(tab->editor->isLargeFile() ? "文件已打开（大文件，只读，不做语法高亮）" : "文件已打开",
+                                 3000);
+    });
+    editor->setCodeRunner(runner);
+
+    // 先加入列表再加入标签栏：第一个标签页加入时就会发出currentChanged
+    m_tabs.append(tab);
+    m_outputStack->addWidget(tab->output);
+    const int index = m_editorTabs->addTab(tab->editor, title);
+    if (index == 0) {
+        // 草稿标签页不能关闭
+        m_editorTabs->tabBar()->setTabButton(0, QTabBar::RightSide, nullptr);
+        m_editorTabs->tabBar()->setTabButton(0, QTabBar::LeftSide, nullptr);
     }
+    return tab;
+}
+
+void PyWindow::destroyTab(EditorTab* tab)
+{
+    if (m_searchTab == tab) {
+        resetOutputSearch();
+    }
+    if (m_resultsTab == tab) {
+        m_resultsTab = nullptr;
+        m_profileView->setProfile(nullptr, QStringList());
+        m_flameGraphView->setFlameGraph(nullptr);
+        m_replayView->setRecording(nullptr);
+    }
+    m_saveRequested.remove(tab);
+
+    // 中止运行中的代码，运行器在运行线程中释放持有的Python对象后再停止线程
+    tab->runner->abortExecution();
+    if (tab->runnerThread) {
+        if (m_pythonManager->isInitialized() && !m_pythonManager->isInitializing()) {
+            QMetaObject::invokeMethod(tab->runner, &CodeRunner::releasePythonState, Qt::BlockingQueuedConnection);
+        }
+        tab->runnerThread->quit();
+        tab->runnerThread->wait();
+        delete tab->runnerThread;
+    }
+    delete tab->runner;
+
+    // 标签页的会话变量随之释放
+    if (!tab->context.isEmpty() && m_pythonManager->isInitialized() && !m_pythonManager->isInitializing()) {
+        py::gil_scoped_acquire acquire;
+        m_pythonManager->releaseNamespace(tab->context);
+    }
+
+    delete tab->editor;
+    delete tab->output;
+    delete tab;
+}
+
+bool PyWindow::isAnyTabBusy() const
+{
+    for (const EditorTab* tab : m_tabs) {
+        if (tab->isExecuting || tab->runPending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PyWindow::newTab()
+{
+    EditorTab* tab = createTab(QString("未命名%1").arg(m_tabCounter));
+    m_editorTabs->setCurrentWidget(tab->editor);
+    tab->editor->setFocus();
+}
+
+void PyWindow::closeTab(int index)
+{
+    if (index <= 0 || index >= m_tabs.size()) {
+        return;
+    }
+
+    EditorTab* tab = m_tabs[index];
+    if (tab->isExecuting) {
+        QMessageBox::StandardButton reply =
+            QMessageBox::question(this,
+                                  "关闭标签页",
+                                  QString("%1中的代码正在执行，确定要停止并关闭吗？").arg(tab->title),
+                                  QMessageBox::Yes | QMessageBox::No);
+        if (reply != QMessageBox::Yes) {
+            return;
+        }
+    }
+
+    // 打开的文件关闭前保存，新建的标签页没有文件，内容随之丢弃
+    saveTab(tab, false);
+
+    // 先移出列表再移出标签栏：移除时发出的currentChanged按新的序号查找
+    m_tabs.remove(index);
+    m_editorTabs->removeTab(index);
+    m_outputStack->removeWidget(tab->output);
+    destroyTab(tab);
+    updateExecutionButtons();
+}
+
+void PyWindow::onCurrentTabChanged(int index)
+{
+    if (index < 0 || index >= m_tabs.size()) {
+        return;
+    }
+
+    // 编辑器和输出窗口都是各标签页自己的部件，切换时不重新加载或高亮
+    m_currentTab = m_tabs[index];
+    m_outputStack->setCurrentWidget(m_currentTab->output);
+
+    // 搜索结果属于原来的标签页，在新标签页中重新搜索
+    if (m_searchTab && m_searchTab != m_currentTab) {
+        startOutputSearch();
+    }
+    m_outlineView->setSymbols(m_currentTab->editor->outlineSymbols());
+    m_imageView->setChannel(m_currentTab->runner->frameChannel());
+
+    // 在后台结束的运行切换过来时才显示结果
+    if (m_currentTab->resultsPending) {
+        showRunResults(m_currentTab);
+    }
+
+    // 变量和监视属于暂停中的标签页
+    if (m_currentTab->isExecuting && m_currentTab->debugState == CodeRunner::Paused) {
+        m_variablesView->refresh();
+    }
+    else {
+        m_variablesView->clearVariables();
+        m_watchesView->markStale();
+    }
+
+    updateExecutionButtons();
+    updateDebugButtons();
+    updateThreadCombo();
 }
 
 void PyWindow::runPythonCode()
 {
-    if (m_isExecuting) {
+    startRun(NormalRun);
+}
+
+void PyWindow::profilePythonCode()
+{
+    startRun(LineProfileRun);
+}
+
+void PyWindow::samplePythonCode()
+{
+    startRun(SamplingRun);
+}
+
+void PyWindow::recordPythonCode()
+{
+    startRun(RecordRun);
+}
+
+void PyWindow::runCurrentCell()
+{
+    startCellRun(false);
+}
+
+void PyWindow::runChangedCells()
+{
+    startCellRun(true);
+}
+
+void PyWindow::jumpToLine(int lineNumber)
+{
+    PyEditor*  editor = m_currentTab->editor;
+    QTextBlock block  = editor->document()->findBlockByNumber(lineNumber - 1);
+    if (block.isValid()) {
+        editor->setTextCursor(QTextCursor(block));
+        editor->centerCursor();
+        editor->setFocus();
+    }
+}
+
+void PyWindow::startRun(RunMode mode)
+{
+    EditorTab* tab = m_currentTab;
+    if (tab->isExecuting) {
         // 如果正在执行，则停止执行
-        m_runner->abortExecution();
+        tab->runner->abortExecution();
         return;
     }
 
-    QString code = m_codeEditor->toPlainText().trimmed();
+    if (tab->runPending) {
+        // 再次点击取消排队的运行
+        tab->runPending = false;
+        updateExecutionButtons();
+        statusBar()->showMessage("已取消等待运行，Python解释器仍在启动...");
+        return;
+    }
+
+    if (tab->editor->isLoading()) {
+        statusBar()->showMessage("文件仍在加载，请稍候", 2000);
+        return;
+    }
+
+    QString code = tab->editor->toPlainText().trimmed();
 
     if (code.isEmpty()) {
         QMessageBox::warning(this, "警告", "请输入要执行的Python代码！");
         return;
     }
 
-    // 清空输出窗口
-    clearOutput();
+    // 整个缓冲区运行成功后，所有单元格都记为已运行
+    queueRun(mode, code, tab->editor->cellHashes(tab->editor->allCells()));
+}
+
+void PyWindow::startCellRun(bool changedOnly)
+{
+    // 运行中或等待解释器时只能通过运行按钮中止或取消
+    EditorTab* tab = m_currentTab;
+    if (tab->isExecuting || tab->runPending || tab->editor->isLoading()) {
+        return;
+    }
+
+    QVector<int> cells;
+    if (changedOnly) {
+        cells = tab->editor->changedCells();
+    }
+    else if (tab->editor->currentCell() >= 0) {
+        cells.append(tab->editor->currentCell());
+    }
+
+    const QString code = tab->editor->cellCode(cells);
+    if (code.trimmed().isEmpty()) {
+        statusBar()->showMessage(changedOnly ? "没有需要重新运行的单元格" : "当前单元格没有代码");
+        return;
+    }
+
+    if (!m_sessionCheck->isChecked()) {
+        m_sessionCheck->setChecked(true);
+        tab->output->appendLine("已勾选\"保留会话变量\"：单元格在会话命名空间中运行");
+    }
+
+    queueRun(NormalRun, code, tab->editor->cellHashes(cells));
+}
+
+void PyWindow::queueRun(RunMode mode, const QString& code, const QVector<uint>& cells)
+{
+    EditorTab* tab = m_currentTab;
+
+    // 本进程中的解释器尚未就绪（或正在重启）时记下代码，初始化完成后再运行（执行进程后端自带解释器）
+    if (!qobject_cast<RemoteCodeRunner*>(tab->runner) &&
+        (!m_pythonManager->isInitialized() || m_pythonManager->isInitializing())) {
+        if (!m_pythonManager->isInitializing()) {
+            QMessageBox::critical(this, "初始化错误", "Python解释器未能初始化，无法运行代码。");
+            return;
+        }
+
+        tab->runPending   = true;
+        tab->pendingMode  = mode;
+        tab->pendingCode  = code;
+        tab->pendingCells = cells;
+        updateExecutionButtons();
+        statusBar()->showMessage("Python解释器启动后将自动运行...");
+        return;
+    }
 
-    // 启动执行
-    QMetaObject::invokeMethod(m_runner, "runCode", Qt::QueuedConnection, Q_ARG(QString, code));
+    dispatchRun(tab, mode, code, cells);
+}
+
+void PyWindow::dispatchRun(EditorTab* tab, RunMode mode, const QString& code, const QVector<uint>& cells)
+{
+    // 清空输出窗口
+    tab->runner->outputChannel()->clear();
+    tab->output->clear();
+    if (tab == m_currentTab) {
+        m_outputTabs->setCurrentWidget(m_outputPage);
+    }
+    tab->lastRunCode   = code;
+    tab->runCells      = cells;
+    tab->runPersistent = m_sessionCheck->isChecked();
+    tab->runFailed     = false;
+    tab->runRecorded   = mode == RecordRun;
+
+    // 提交到运行器的调度队列；同一编辑器的重复提交合并为最新的一版
+    RunScheduler::Request request;
+    request.code      = code;
+    request.key       = QStringLiteral("editor");
+    request.priority  = RunScheduler::Interactive;
+    request.profiling = mode == LineProfileRun;
+    request.sampling  = mode == SamplingRun;
+    request.recording = mode == RecordRun;
+    request.memory    = m_memoryCheck->isEnabled() && m_memoryCheck->isChecked();
+    request.objects   = m_objectsCheck->isEnabled() && m_objectsCheck->isChecked();
+    request.recordLocals     = ConfigManager::instance().getRecordLocals();
+    request.budgets.wallMs   = ConfigManager::instance().getWallTimeLimit() * 1000LL;
+    request.budgets.cpuMs    = ConfigManager::instance().getCpuTimeLimit() * 1000LL;
+    request.budgets.memoryMB = ConfigManager::instance().getMemoryLimit();
+    tab->runner->setSamplingRate(ConfigManager::instance().getSamplingRate());
+    tab->runner->submitRun(request);
 }
 
 void PyWindow::appendOutput(const QString& text)
 {
-    m_logOutput->setTextColor(Qt::black);
-    m_logOutput->append(text);
+    m_currentTab->output->appendLine(text);
 }
 
-void PyWindow::appendError(const QString& text)
+void PyWindow::onOutputReady(EditorTab* tab)
 {
-    m_logOutput->setTextColor(Qt::red);
-    m_logOutput->append("错误: " + text);
+    if (tab->runner->outputChannel()->isAboveHighWatermark()) {
+        tab->flushTimer->stop();
+        drainOutput(tab);
+    }
+    else if (!tab->flushTimer->isActive()) {
+        tab->flushTimer->start();
+    }
 }
 
-void PyWindow::onExecutionStart()
+void PyWindow::drainOutput(EditorTab* tab)
 {
-    m_isExecuting = true;
-    updateExecutionButtons();
-    statusBar()->showMessage("正在执行Python代码...");
+    // 每批只有少数几段（相邻同类输出已合并）
+    const QList<OutputChannel::Chunk> chunks = tab->runner->outputChannel()->takeAll();
+    for (const OutputChannel::Chunk& chunk : chunks) {
+        OutputConsole::LineStyle style = OutputConsole::Normal;
+        if (chunk.stream == OutputChannel::StdErr) {
+            style = OutputConsole::StdErr;
+        }
+        else if (chunk.stream == OutputChannel::Log) {
+            style = OutputConsole::Log;
+        }
+        tab->output->appendText(chunk.text, style);
+    }
+}
 
-    // 禁用编辑器
-    m_codeEditor->setEnabled(false);
-    m_saveButton->setEnabled(false);
+// 显示字节数，不足1MB时以KB显示
+static QString formatBytes(qint64 bytes)
+{
+    if (qAbs(bytes) < 1024 * 1024) {
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
 }
 
-void PyWindow::onExecutionFinish()
+void PyWindow::onInputWaitChanged(EditorTab* tab, bool waiting)
 {
-    m_isExecuting = false;
-    updateExecutionButtons();
-    statusBar()->showMessage("执行完成");
+    if (!waiting) {
+        if (tab == m_currentTab && tab->isExecuting) {
+            statusBar()->showMessage("正在执行Python代码...");
+        }
+        return;
+    }
+
+    // 提示文字可能还在输出通道中，先取出再等用户输入
+    tab->flushTimer->stop();
+    drainOutput(tab);
+    if (tab == m_currentTab) {
+        m_outputTabs->setCurrentWidget(m_outputPage);
+        m_inputEdit->setFocus();
+        statusBar()->showMessage("程序正在等待输入");
+    }
+}
+
+void PyWindow::submitInput()
+{
+    const QString text = m_inputEdit->text();
+    m_inputEdit->clear();
+
+    // 回显在已经到达的输出（通常是input()的提示）之后
+    drainOutput(m_currentTab);
+    m_currentTab->output->appendText(text + "\n", OutputConsole::Normal);
+    m_currentTab->runner->writeInput((text + "\n").toUtf8());
+}
+
+void PyWindow::submitInputFile()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "选择输入文件");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        statusBar()->showMessage("无法读取输入文件：" + file.errorString(), 5000);
+        return;
+    }
+    const QByteArray data = file.readAll();
+    m_currentTab->runner->writeInput(data);
+    statusBar()->showMessage(QString("已发送%1的输入").arg(formatBytes(data.size())), 3000);
+}
+
+void PyWindow::closeInput()
+{
+    m_currentTab->runner->closeInput();
+    statusBar()->showMessage("已结束输入", 2000);
+}
+
+void PyWindow::appendError(EditorTab* tab, const QString& text)
+{
+    tab->output->appendLine("错误: " + text, OutputConsole::Error);
+}
+
+void PyWindow::onExecutionStart(EditorTab* tab)
+{
+    tab->isExecuting = true;
+    tab->editor->setEnabled(false);
+    m_editorTabs->setTabText(m_tabs.indexOf(tab), tab->title + "（运行中）");
+
+    if (tab == m_currentTab) {
+        // 执行进程重启后图像通道随之更换，开始运行时重新取得
+        m_imageView->setChannel(tab->runner->frameChannel());
+        updateExecutionButtons();
+        updateDebugButtons();
+        statusBar()->showMessage("正在执行Python代码...");
+    }
+}
+
+void PyWindow::onExecutionFinish(EditorTab* tab)
+{
+    // 取走剩余的输出
+    tab->flushTimer->stop();
+    drainOutput(tab);
+
+    tab->isExecuting = false;
+    tab->editor->setEnabled(true);
+    m_editorTabs->setTabText(m_tabs.indexOf(tab), tab->title);
+
+    // 在会话命名空间中成功运行的单元格不再标记为已修改；
+    // 出错或中止时无法确定运行到了哪个单元格，保持原状态
+    if (tab->runPersistent && !tab->runFailed) {
+        tab->editor->markCellsExecuted(tab->runCells);
+    }
+    tab->runCells.clear();
+
+    // 采样统计、内存和录制的概要写到标签页自己的输出窗口
+    if (std::shared_ptr<FlameGraph> graph = tab->runner->flameGraph()) {
+        const double seconds  = graph->durationNs() / 1e9;
+        const double rate     = seconds > 0 ? graph->totalSamples() / seconds : 0.0;
+        const double overhead = seconds > 0 ? 100.0 * graph->overheadNs() / graph->durationNs() : 0.0;
+        tab->output->appendLine(QString("采样 %1 次，实际频率 %2 Hz（设定 %3 Hz），采样占用 %4%")
+                                    .arg(graph->totalSamples())
+                                    .arg(rate, 0, 'f', 0)
+                                    .arg(graph->rateHz())
+                                    .arg(overhead, 0, 'f', 2));
+    }
+
+    if (std::shared_ptr<MemoryReport> memory = tab->runner->memoryReport()) {
+        showMemoryReport(tab->output, *memory);
+    }
+
+    if (tab->runRecorded) {
+        if (std::shared_ptr<ExecutionRecording> recording = tab->runner->recording()) {
+            tab->output->appendLine(QString("录制 %1 步，文件 %2%3")
+                                        .arg(recording->stepCount())
+                                        .arg(formatBytes(recording->fileBytes()))
+                                        .arg(recording->isTruncated() ? "（已达到上限，之后的部分没有录制）" : ""));
+        }
+    }
+
+    // 结果页只显示当前标签页的结果，后台标签页切换过去时再显示
+    tab->resultsPending   = true;
+    tab->recordingPending = tab->recordingPending || tab->runRecorded;
+    tab->runRecorded      = false;
+    if (tab == m_currentTab) {
+        updateExecutionButtons();
+        updateDebugButtons();
+        m_variablesView->clearVariables();
+        m_watchesView->markStale();
+        showRunResults(tab);
+    }
+}
+
+void PyWindow::showRunResults(EditorTab* tab)
+{
+    tab->resultsPending = false;
+    m_resultsTab        = tab;
+
+    // 分析运行结束后显示热点表格
+    std::shared_ptr<LineProfile> profile = tab->runner->lineProfile();
+    m_profileView->setProfile(profile, tab->lastRunCode.split('\n'));
+    if (profile) {
+        m_outputTabs->setCurrentWidget(m_profileView);
+    }
+
+    // 采样运行结束后显示火焰图
+    std::shared_ptr<FlameGraph> graph = tab->runner->flameGraph();
+    m_flameGraphView->setFlameGraph(graph);
+    if (graph) {
+        m_outputTabs->setCurrentWidget(m_flameGraphTab);
+    }
+
+    // 录制运行结束后打开回放；普通运行不覆盖上一次的录制
+    if (tab->recordingPending) {
+        tab->recordingPending = false;
+        std::shared_ptr<ExecutionRecording> recording = tab->runner->recording();
+        m_replayView->setRecording(recording);
+        if (recording) {
+            m_outputTabs->setCurrentWidget(m_replayView);
+        }
+    }
+}
+
+void PyWindow::showMemoryReport(OutputConsole* output, const MemoryReport& report)
+{
+    QString summary = QString("内存：常驻内存峰值 %1（开始 %2，结束 %3）")
+                          .arg(formatBytes(report.peakRssBytes))
+                          .arg(formatBytes(report.startRssBytes))
+                          .arg(formatBytes(report.endRssBytes));
+    if (report.runIndex > 1) {
+        summary += QString("，较上次统计运行 %1%2")
+                       .arg(report.rssGrowthBytes >= 0 ? "+" : "")
+                       .arg(formatBytes(report.rssGrowthBytes));
+    }
+    output->appendLine(summary);
+
+    if (report.tracingRequested && !report.traced) {
+        output->appendLine("tracemalloc已被运行的代码占用，只统计常驻内存");
+    }
+    else if (report.traced) {
+        output->appendLine(QString("Python分配峰值 %1，运行结束后仍保留 %2")
+                               .arg(formatBytes(report.peakTracedBytes))
+                               .arg(formatBytes(report.retainedBytes)));
+
+        // 结束时仍存活的分配按行汇总，保留会话变量时持续增长的行通常就是泄漏来源
+        for (const MemoryReport::Site& site : report.topSites) {
+            output->appendLine(QString("  第%1行：%2，%3 个对象")
+                                   .arg(site.line)
+                                   .arg(formatBytes(site.bytes))
+                                   .arg(site.count));
+        }
+    }
+
+    if (!report.objectsChecked) {
+        return;
+    }
+
+    output->appendLine(QString("对象：GC跟踪对象 %1 → %2，内存块 %3%4")
+                           .arg(report.gcObjectsBefore)
+                           .arg(report.gcObjectsAfter)
+                           .arg(report.allocatedBlocksDelta >= 0 ? "+" : "")
+                           .arg(report.allocatedBlocksDelta));
+    output->appendLine(QString("运行中创建且仍存活 %1 个，其中命名空间中 %2 个，命名空间之外 %3 个（无Python引用 %4 个），"
+                               "累计 %5 个")
+                           .arg(report.survivingObjects)
+                           .arg(report.namespaceObjects)
+                           .arg(report.leakedObjects)
+                           .arg(report.hostHeldObjects)
+                           .arg(report.leakedTotal),
+                       report.leakedObjects > 0 ? OutputConsole::StdErr : OutputConsole::Normal);
+
+    for (const MemoryReport::TypeCount& count : report.typeCounts) {
+        output->appendLine(QString("  %1：%2 → %3（+%4）")
+                               .arg(count.type)
+                               .arg(count.before)
+                               .arg(count.after)
+                               .arg(count.after - count.before));
+    }
+
+    // 命名空间之外的对象在下一次运行后仍然存活，长时间会话中内存持续增长的来源
+    for (const MemoryReport::ObjectLeak& leak : report.leaks) {
+        QString holder;
+        switch (leak.holder) {
+        case MemoryReport::HeldByModule:
+            holder = QString("模块属性 %1").arg(leak.detail);
+            break;
+        case MemoryReport::HeldByContainer:
+            holder = QString("被 %1 引用").arg(leak.detail);
+            break;
+        default:
+            holder = "没有Python引用（C++宿主或扩展模块持有）";
+            break;
+        }
+        output->appendLine(QString("  残留 %1 × %2：%3%4")
+                               .arg(leak.type)
+                               .arg(leak.count)
+                               .arg(holder)
+                               .arg(leak.line > 0 ? QString("，创建于第%1行").arg(leak.line) : QString()));
+    }
+}
+
+void PyWindow::onRunSummary(EditorTab* tab, const CodeRunner::RunSummary& summary)
+{
+    // 先取走剩余输出，保证汇总显示在最后
+    drainOutput(tab);
+
+    QString message = QString("执行完成，耗时 %1 ms").arg(summary.elapsedNs / 1e6, 0, 'f', 1);
+    if (summary.aborted) {
+        tab->runFailed = true;
+        message = QString("%1，耗时 %2 ms，中止响应 %3 ms")
+                      .arg(summary.hardStopped ? "已强制停止" : "已中止")
+                      .arg(summary.elapsedNs / 1e6, 0, 'f', 1)
+                      .arg(summary.abortLatencyNs / 1e6, 0, 'f', 1);
+        tab->output->appendLine(message, OutputConsole::Error);
+    }
 
-    // 启用编辑器
-    m_codeEditor->setEnabled(true);
-    m_saveButton->setEnabled(true);
+    statusBar()->showMessage(tab == m_currentTab ? message : QString("%1：%2").arg(tab->title, message));
+
+    if (summary.logpointsDropped > 0) {
+        tab->output->appendLine(QString("日志点输出过快，丢弃了 %1 条").arg(summary.logpointsDropped),
+                                OutputConsole::StdErr);
+    }
+
+    // 运行指标：表格显示最近的运行，同时追加到日志文件
+    QString status = "ok";
+    QString label  = "完成";
+    if (summary.budgetExceeded != RunWatchdog::NoBudget) {
+        status = "budget";
+        label  = "超出限制";
+    }
+    else if (summary.aborted) {
+        status = summary.hardStopped ? "stopped" : "aborted";
+        label  = summary.hardStopped ? "已强制停止" : "已中止";
+    }
+    else if (tab->runFailed) {
+        status = "error";
+        label  = "出错";
+    }
+    m_metricsView->addRun(summary, label);
+
+    const QString backend = qobject_cast<RemoteCodeRunner*>(tab->runner) ? "process" : "thread";
+    m_metricsLog.setPath(ConfigManager::instance().getMetricsLogFile());
+    m_metricsLog.append(RunMetricsLog::toJson(summary, status, backend));
+}
+
+void PyWindow::onPythonStartupProgress(const QString& phase, int step, int total)
+{
+    statusBar()->showMessage(QString("正在启动Python解释器（%1/%2）：%3...").arg(step).arg(total).arg(phase));
 }
 
 void PyWindow::onPythonInitialized()
 {
+    // 各阶段耗时，便于定位大型环境中启动慢的原因
+    qint64      totalNs = 0;
+    QStringList phases;
+    for (const PythonInterpreterManager::StartupPhase& phase : m_pythonManager->startupPhases()) {
+        totalNs += phase.elapsedNs;
+        phases << QString("%1 %2 ms").arg(phase.name).arg(phase.elapsedNs / 1e6, 0, 'f', 1);
+    }
+    OutputConsole* output  = m_currentTab->output;
+    const bool     process = qobject_cast<RemoteCodeRunner*>(m_currentTab->runner) != nullptr;
+    output->appendLine(QString("Python解释器启动耗时 %1 ms（%2）")
+                           .arg(totalNs / 1e6, 0, 'f', 1)
+                           .arg(phases.join("，")));
+    if (m_restartTimer.isValid() && !process) {
+        output->appendLine(
+            QString("Python解释器已重启，耗时 %1 ms").arg(m_restartTimer.nsecsElapsed() / 1e6, 0, 'f', 1));
+        m_restartTimer.invalidate();
+    }
+
     statusBar()->showMessage("Python解释器已初始化: " + m_pythonManager->getPythonVersion());
+
+    // 线程后端在本进程的解释器中预导入，进程后端由执行进程预导入
+    if (!process) {
+        m_pythonManager->warmUp(ConfigManager::instance().getWarmUpModules());
+    }
+
+    // 各标签页排队的运行
+    for (EditorTab* tab : m_tabs) {
+        if (tab->runPending) {
+            tab->runPending = false;
+            dispatchRun(tab, tab->pendingMode, tab->pendingCode, tab->pendingCells);
+            tab->pendingCode.clear();
+            tab->pendingCells.clear();
+        }
+    }
+    updateExecutionButtons();
+}
+
+void PyWindow::reportSessionRestored(int restored, const QStringList& skipped, qint64 elapsedNs)
+{
+    OutputConsole* output = m_tabs.first()->output;
+    output->appendLine(QString("已从会话检查点恢复 %1 个变量，耗时 %2 ms").arg(restored).arg(elapsedNs / 1e6, 0, 'f', 1),
+                       OutputConsole::Log);
+    if (!skipped.isEmpty()) {
+        output->appendLine(QString("未能恢复：%1").arg(skipped.join("、")), OutputConsole::Log);
+    }
+}
+
+void PyWindow::reportWarmUp(const QVector<PythonInterpreterManager::WarmUpModule>& modules)
+{
+    if (modules.isEmpty()) {
+        return;
+    }
+
+    qint64      totalNs = 0;
+    QStringList parts;
+    for (const PythonInterpreterManager::WarmUpModule& module : modules) {
+        totalNs += module.elapsedNs;
+        if (module.imported) {
+            parts << QString("%1 %2 ms").arg(module.name).arg(module.elapsedNs / 1e6, 0, 'f', 1);
+        }
+        else {
+            parts << QString("%1 导入失败").arg(module.name);
+            qWarning() << "Warm-up import failed:" << module.name << module.error;
+        }
+    }
+    m_currentTab->output->appendLine(QString("预导入耗时 %1 ms（%2），不计入运行时间")
+                                         .arg(totalNs / 1e6, 0, 'f', 1)
+                                         .arg(parts.join("，")));
+}
+
+void PyWindow::onPythonInitializationFailed(const QString& error)
+{
+    bool hadPendingRun = false;
+    for (EditorTab* tab : m_tabs) {
+        hadPendingRun = hadPendingRun || tab->runPending;
+        tab->runPending = false;
+        tab->pendingCode.clear();
+        tab->pendingCells.clear();
+    }
+    m_restartTimer.invalidate();
+    updateExecutionButtons();
+
+    statusBar()->showMessage("Python解释器初始化失败");
+    QMessageBox::critical(this,
+                          "初始化错误",
+                          QString("Python解释器初始化失败！\n"
+                                  "请检查Python安装和环境配置。\n\n%1%2")
+                              .arg(error)
+                              .arg(hadPendingRun ? "\n\n等待中的运行已取消。" : ""));
 }
 
-void PyWindow::onDebugStateChanged(int state)
+void PyWindow::onDebugStateChanged(EditorTab* tab, int state)
 {
-    CodeRunner::DebugState dbgState = (CodeRunner::DebugState)state;
-    // 根据调试状态更新按钮状态
-    switch (dbgState) {
+    // 暂停时可以编辑，运行和单步执行期间禁用编辑器
+    tab->debugState = state;
+    tab->editor->setEnabled(state == CodeRunner::Paused || !tab->isExecuting);
+    if (tab != m_currentTab) {
+        return;
+    }
+
+    updateDebugButtons();
+    if (state == CodeRunner::Paused) {
+        m_variablesView->refresh();
+    }
+    else {
+        m_variablesView->clearVariables();
+        m_watchesView->markStale();
+    }
+}
+
+void PyWindow::updateDebugButtons()
+{
+    // 根据当前标签页的调试状态更新按钮状态
+    const EditorTab* tab = m_currentTab;
+    switch ((CodeRunner::DebugState)tab->debugState) {
     case CodeRunner::Running:
-        // 运行中，禁用所有调试按钮和编辑器
+        // 运行中，只允许暂停，禁用其他调试按钮
+        m_pauseButton->setEnabled(tab->isExecuting);
         m_continueButton->setEnabled(false);
         m_stepIntoButton->setEnabled(false);
         m_stepOverButton->setEnabled(false);
         m_stepOutButton->setEnabled(false);
-        m_codeEditor->setEnabled(false);
         break;
     case CodeRunner::Paused:
-        // 暂停，启用所有调试按钮和编辑器
+        // 暂停，启用所有调试按钮
+        m_pauseButton->setEnabled(false);
         m_continueButton->setEnabled(true);
         m_stepIntoButton->setEnabled(true);
         m_stepOverButton->setEnabled(true);
         m_stepOutButton->setEnabled(true);
-        m_codeEditor->setEnabled(true);
         break;
     case CodeRunner::StepInto:
     case CodeRunner::StepOver:
     case CodeRunner::StepOut:
-        // 单步执行中，禁用所有调试按钮和编辑器
+        // 单步执行中，禁用所有调试按钮
+        m_pauseButton->setEnabled(false);
         m_continueButton->setEnabled(false);
         m_stepIntoButton->setEnabled(false);
         m_stepOverButton->setEnabled(false);
         m_stepOutButton->setEnabled(false);
-        m_codeEditor->setEnabled(false);
         break;
     }
 }
 
+void PyWindow::updateThreadCombo()
+{
+    // 只有一个线程时没有可选的
+    const EditorTab* tab = m_currentTab;
+    m_threadCombo->clear();
+    for (const CodeRunner::DebugThread& thread : tab->threads) {
+        m_threadCombo->addItem(thread.main ? thread.name : QString("%1（%2）").arg(thread.name).arg(thread.id),
+                               QVariant::fromValue<qulonglong>(thread.main ? 0 : thread.id));
+    }
+    const int index = m_threadCombo->findData(QVariant::fromValue<qulonglong>(tab->debugThread));
+    m_threadCombo->setCurrentIndex(qMax(0, index));
+    m_threadCombo->setEnabled(tab->threads.size() > 1);
+}
+
 void PyWindow::showSettings()
 {
+    // 当前解释器的信息取自快照，代码正在运行并持有GIL时对话框也能立即打开
+    QString label = "请输入Python安装路径:";
+    if (std::shared_ptr<const PythonInterpreterManager::InterpreterInfo> info = m_pythonManager->interpreterInfo()) {
+        label = QString("当前解释器：Python %1\nsys.path %2 项，已加载 %3 个模块，常驻内存 %4\n\n%5")
+                    .arg(info->version.section(' ', 0, 0))
+                    .arg(info->paths.size())
+                    .arg(info->modules.size())
+                    .arg(formatBytes(info->rssBytes))
+                    .arg(label);
+    }
+
+    bool    accepted   = false;
     QString pythonHome = QInputDialog::getText(this,
                                                "Python设置",
-                                               "请输入Python安装路径:",
+                                               label,
                                                QLineEdit::Normal,
-                                               m_pythonManager->getPythonVersion());
+                                               ConfigManager::instance().getPythonHome(),
+                                               &accepted);
 
-    if (!pythonHome.isEmpty()) {
-        m_pythonManager->setPythonHome(pythonHome);
-        m_settings.setValue("Python/pythonHome", pythonHome);
-        QMessageBox::information(this, "设置", "Python路径已更新！请重启应用以应用新设置。");
+    if (!accepted || pythonHome.isEmpty() || pythonHome == ConfigManager::instance().getPythonHome()) {
+        return;
+    }
+    if (!QDir(pythonHome).exists()) {
+        QMessageBox::warning(this, "设置", "目录不存在：" + pythonHome);
+        return;
+    }
+
+    m_pythonManager->setPythonHome(pythonHome);
+    ConfigManager::instance().setPythonHome(pythonHome);
+    if (isAnyTabBusy()) {
+        QMessageBox::information(this, "设置", "Python路径已更新，将在下次重启解释器时生效。");
+        return;
+    }
+    restartInterpreter(true);
+}
+
+void PyWindow::restartInterpreter(bool environmentChanged)
+{
+    if (isAnyTabBusy()) {
+        statusBar()->showMessage("代码运行期间不能重启解释器，请先停止所有标签页的运行", 3000);
+        return;
+    }
+
+    // 会话命名空间随解释器一起丢失
+    for (EditorTab* tab : m_tabs) {
+        tab->editor->invalidateCells();
+    }
+    m_restartTimer.start();
+
+    const bool process = qobject_cast<RemoteCodeRunner*>(m_currentTab->runner) != nullptr;
+    if (process) {
+        // 新的执行进程启动时读取配置文件
+        ConfigManager::instance().sync();
+        for (EditorTab* tab : m_tabs) {
+            static_cast<RemoteCodeRunner*>(tab->runner)->restartWorker(environmentChanged);
+        }
+        statusBar()->showMessage("正在重启执行进程...");
+    }
+
+    // 进程后端的界面进程解释器只用于补全和单元格分析，环境变化时才需要重启
+    if (!process || environmentChanged) {
+        m_pythonManager->restartAsync();
+        statusBar()->showMessage("正在重启Python解释器...");
     }
 }
 
 void PyWindow::applySettings()
 {
     // 应用保存的设置
-    QString pythonHome = m_settings.value("Python/pythonHome", "").toString();
+    QString pythonHome = ConfigManager::instance().getPythonHome();
     if (!pythonHome.isEmpty() && m_pythonManager) {
         m_pythonManager->setPythonHome(pythonHome);
     }
@@ -368,102 +1615,390 @@ void PyWindow::loadExampleCode()
         "if __name__ == \"__main__\":\n"
         "    main()";
 
-    m_codeEditor->setPlainText(m_exampleCode);
+    PyEditor* editor = m_tabs.first()->editor;
+    editor->setLargeFileMode(false);
+    editor->setPlainText(m_exampleCode);
 }
 
 void PyWindow::saveCurrentCode()
 {
-    QString code    = m_codeEditor->toPlainText();
-    m_lastSavedCode = code;
+    saveTab(m_currentTab, true);
+}
 
-    QString appDataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir    dir(appDataDir);
-    if (!dir.exists()) {
-        dir.mkpath(appDataDir);
+void PyWindow::saveTab(EditorTab* tab, bool interactive)
+{
+    // 打开的大文件不是用户编写的代码，加载到一半时内容也不完整
+    if (tab->editor->isLargeFile() || tab->editor->isLoading()) {
+        return;
     }
 
-    QString filePath = dir.filePath("last_code.py");
-    QFile   file(filePath);
+    // 草稿保存到应用数据目录；新建的标签页第一次保存时选择文件
+    QString filePath = tab->filePath;
+    if (filePath.isEmpty() && tab == m_tabs.first()) {
+        filePath = lastCodeFilePath();
+    }
+    else if (filePath.isEmpty()) {
+        if (!interactive) {
+            return;
+        }
+        filePath = QFileDialog::getSaveFileName(this, "保存文件", QString(), "Python文件 (*.py);;所有文件 (*)");
+        if (filePath.isEmpty()) {
+            return;
+        }
+        tab->filePath = filePath;
+        tab->title    = QFileInfo(filePath).fileName();
+        m_editorTabs->setTabText(m_tabs.indexOf(tab), tab->title);
+    }
 
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << code;
-        file.close();
-        statusBar()->showMessage("代码已保存", 2000);
+    // 在后台线程中写入，结果见fileSaved/fileSaveFailed；未修改时不写入
+    if (!tab->editor->saveToFileAsync(filePath)) {
+        if (interactive) {
+            statusBar()->showMessage("代码已保存", 2000);
+        }
     }
-    else {
-        QMessageBox::warning(this, "保存失败", "无法保存代码文件！");
+    else if (interactive) {
+        m_saveRequested.insert(tab);
+    }
+}
+
+void PyWindow::saveAllTabs()
+{
+    for (EditorTab* tab : m_tabs) {
+        saveTab(tab, false);
     }
 }
 
 void PyWindow::loadSavedCode()
 {
-    QString appDataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QString filePath   = QDir(appDataDir).filePath("last_code.py");
-    QFile   file(filePath);
+    const QString filePath = lastCodeFilePath();
+    QFile         file(filePath);
+    PyEditor*     editor = m_tabs.first()->editor;
 
     if (file.exists() && file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QTextStream in(&file);
-        QString     code = in.readAll();
+        in.setCodec("UTF-8");
+        QString code = in.readAll();
         file.close();
 
         if (!code.isEmpty()) {
-            m_codeEditor->setPlainText(code);
-            m_lastSavedCode = code;
+            editor->setPlainText(code);
+            editor->markSaved(filePath);
         }
     }
 }
 
+void PyWindow::openFile()
+{
+    const QString filePath =
+        QFileDialog::getOpenFileName(this, "打开文件", QString(), "Python文件 (*.py);;所有文件 (*)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    // 已经打开的文件直接切换过去
+    for (EditorTab* tab : m_tabs) {
+        if (tab->filePath == filePath) {
+            m_editorTabs->setCurrentWidget(tab->editor);
+            return;
+        }
+    }
+
+    EditorTab* tab = createTab(QFileInfo(filePath).fileName());
+    if (!tab->editor->loadFromFile(filePath)) {
+        m_tabs.removeOne(tab);
+        m_editorTabs->removeTab(m_editorTabs->indexOf(tab->editor));
+        m_outputStack->removeWidget(tab->output);
+        destroyTab(tab);
+        QMessageBox::warning(this, "打开失败", "无法打开文件：" + filePath);
+        return;
+    }
+    tab->filePath = filePath;
+    m_editorTabs->setCurrentWidget(tab->editor);
+    m_openButton->setEnabled(false);
+    m_loadProgress->setValue(0);
+    m_loadProgress->show();
+    statusBar()->showMessage("正在加载 " + QFileInfo(filePath).fileName() + "...");
+}
+
 void PyWindow::loadWindowSettings()
 {
     // 恢复窗口大小和位置
-    restoreGeometry(m_settings.value("geometry").toByteArray());
-    restoreState(m_settings.value("windowState").toByteArray());
+    restoreGeometry(ConfigManager::instance().getWindowGeometry());
+    restoreState(ConfigManager::instance().getWindowState());
 }
 
 void PyWindow::saveWindowSettings()
 {
     // 保存窗口大小和位置
-    m_settings.setValue("geometry", saveGeometry());
-    m_settings.setValue("windowState", saveState());
+    ConfigManager::instance().setWindowGeometry(saveGeometry());
+    ConfigManager::instance().setWindowState(saveState());
+    ConfigManager::instance().save();
 }
 
 void PyWindow::updateExecutionButtons()
 {
-    if (m_isExecuting) {
+    // 按钮作用于当前标签页；重启解释器影响所有标签页
+    const EditorTab* tab     = m_currentTab;
+    const bool       process = qobject_cast<RemoteCodeRunner*>(tab->runner) != nullptr;
+    if (tab->isExecuting) {
         m_runButton->setText("停止执行");
         m_runButton->setStyleSheet("background-color: #ff4444; color: white;");
         m_runButton->setToolTip("停止当前正在执行的代码");
+        m_profileButton->setEnabled(false);
+        m_sampleButton->setEnabled(false);
+        m_recordButton->setEnabled(false);
+        m_runCellButton->setEnabled(false);
+        m_runChangedButton->setEnabled(false);
+    }
+    else if (tab->runPending) {
+        m_runButton->setText("等待解释器...");
+        m_runButton->setStyleSheet("");
+        m_runButton->setToolTip("Python解释器启动后自动运行，再次点击取消");
+        m_profileButton->setEnabled(false);
+        m_sampleButton->setEnabled(false);
+        m_recordButton->setEnabled(false);
+        m_runCellButton->setEnabled(false);
+        m_runChangedButton->setEnabled(false);
     }
     else {
         m_runButton->setText("运行代码 (F5)");
         m_runButton->setStyleSheet("");
         m_runButton->setToolTip("运行当前Python代码");
+        m_profileButton->setEnabled(!process);
+        m_sampleButton->setEnabled(!process);
+        m_recordButton->setEnabled(!process);
+        m_runCellButton->setEnabled(true);
+        m_runChangedButton->setEnabled(true);
     }
+    m_saveButton->setEnabled(!tab->isExecuting);
+    m_formatButton->setEnabled(!tab->isExecuting);
+    m_restartButton->setEnabled(!isAnyTabBusy());
 }
 
 void PyWindow::clearOutput()
 {
-    m_logOutput->clear();
+    if (m_searchTab == m_currentTab) {
+        resetOutputSearch();
+    }
+    m_currentTab->runner->outputChannel()->clear();
+    m_currentTab->output->clear();
+}
+
+void PyWindow::startOutputSearch()
+{
+    m_searchTimer->stop();
+    resetOutputSearch();
+
+    const QString text = m_searchEdit->text();
+    if (text.isEmpty() || !m_currentTab) {
+        return;
+    }
+
+    // 在快照上搜索，搜索期间到达的输出不在结果中
+    const Qt::CaseSensitivity sensitivity = m_searchCaseCheck->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    m_searchTab                           = m_currentTab;
+    m_searchLog                           = std::make_shared<OutputLog>(m_searchTab->output->snapshot());
+    m_searchTab->output->setSearchText(text, sensitivity);
+    m_outputSearch->start(*m_searchLog, text, sensitivity);
+    updateSearchStatus();
+}
+
+void PyWindow::resetOutputSearch()
+{
+    m_outputSearch->cancel();
+    if (m_searchTab) {
+        m_searchTab->output->setSearchText(QString(), Qt::CaseInsensitive);
+    }
+    m_searchTab       = nullptr;
+    m_searchLog.reset();
+    m_searchIndex     = -1;
+    m_searchTruncated = false;
+    updateSearchStatus();
+}
+
+void PyWindow::showNextMatch()
+{
+    // 输入后还没到开始搜索的时间，先开始搜索，第一批结果到达时跳过去
+    if (m_searchTimer->isActive() || !m_searchTab) {
+        startOutputSearch();
+        return;
+    }
+    showSearchMatch(m_searchIndex + 1);
+}
+
+void PyWindow::showPreviousMatch()
+{
+    if (m_searchTimer->isActive() || !m_searchTab) {
+        startOutputSearch();
+        return;
+    }
+    showSearchMatch(m_searchIndex - 1);
+}
+
+void PyWindow::showSearchMatch(int index)
+{
+    const int count = m_searchTab ? m_searchTab->output->matchCount() : 0;
+    if (count == 0) {
+        return;
+    }
+    m_searchIndex = (index % count + count) % count;
+
+    // 结果所在行已移出输出窗口：溢出到磁盘时从快照中读出这一行
+    if (!m_searchTab->output->showMatch(m_searchIndex)) {
+        const int     line = m_searchTab->output->matchLine(m_searchIndex);
+        const QString text = m_searchLog ? m_searchLog->lineText(line) : QString();
+        if (text.isEmpty()) {
+            statusBar()->showMessage(QString("第%1行已丢弃，不在输出窗口中").arg(line + 1), 5000);
+        }
+        else {
+            statusBar()->showMessage(QString("第%1行（已移出输出窗口）：%2").arg(line + 1).arg(text.left(200)), 8000);
+        }
+    }
+    updateSearchStatus();
+}
+
+void PyWindow::updateSearchStatus()
+{
+    if (!m_searchTab) {
+        m_searchStatus->clear();
+        return;
+    }
+
+    const int count = m_searchTab->output->matchCount();
+    if (m_outputSearch->isRunning()) {
+        m_searchStatus->setText(QString("已找到%1行，搜索中...").arg(count));
+    }
+    else if (count == 0) {
+        m_searchStatus->setText("未找到");
+    }
+    else {
+        m_searchStatus->setText(QString("%1/%2%3").arg(m_searchIndex + 1).arg(count).arg(m_searchTruncated ? "+" : ""));
+    }
+}
+
+void PyWindow::exportOutput()
+{
+    if (m_exportThread) {
+        statusBar()->showMessage("上一次导出还没有完成", 3000);
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(this,
+                                                      "导出输出",
+                                                      QDir::home().filePath("output.txt"),
+                                                      "文本文件 (*.txt *.log);;gzip压缩文件 (*.gz);;所有文件 (*)");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    // 快照不复制文本，导出在后台线程中逐块写出，期间界面和运行都不受影响
+    auto         log      = std::make_shared<OutputLog>(m_currentTab->output->snapshot());
+    const bool   compress = path.endsWith(".gz", Qt::CaseInsensitive);
+    const qint64 total    = log->lineCount();
+    auto         error    = std::make_shared<QString>();
+    auto         ok       = std::make_shared<bool>(false);
+
+    m_exportCancelled = false;
+    m_exportThread    = QThread::create([this, log, path, compress, total, error, ok]() {
+        QElapsedTimer timer;
+        timer.start();
+        auto progress = [this, total, &timer](qint64 done) {
+            if (timer.elapsed() < 200) {
+                return;
+            }
+            timer.restart();
+            QMetaObject::invokeMethod(
+                this,
+                [this, done, total]() {
+                    statusBar()->showMessage(QString("正在导出输出：%1/%2行").arg(done).arg(total));
+                },
+                Qt::QueuedConnection);
+        };
+        *ok = log->save(path, compress, progress, &m_exportCancelled, error.get());
+    });
+    connect(m_exportThread, &QThread::finished, this, [this, log, path, total, error, ok]() {
+        m_exportThread->deleteLater();
+        m_exportThread = nullptr;
+        if (!*ok) {
+            statusBar()->showMessage("导出输出失败：" + *error, 5000);
+            return;
+        }
+
+        QString message =
+            QString("已导出%1行输出到%2（%3）").arg(total).arg(path, formatBytes(QFileInfo(path).size()));
+        if (log->droppedLines() > 0) {
+            message += QString("，较早的%1行已丢弃").arg(log->droppedLines());
+        }
+        statusBar()->showMessage(message, 8000);
+    });
+    statusBar()->showMessage("正在导出输出...");
+    m_exportThread->start();
 }
 
 void PyWindow::closeEvent(QCloseEvent* event)
 {
-    if (m_isExecuting) {
-        QMessageBox::StandardButton reply = QMessageBox::question(
-            this, "确认退出", "代码正在执行中，确定要退出吗？", QMessageBox::Yes | QMessageBox::No);
+    QStringList running;
+    for (const EditorTab* tab : m_tabs) {
+        if (tab->isExecuting) {
+            running << tab->title;
+        }
+    }
+
+    if (!running.isEmpty()) {
+        QMessageBox::StandardButton reply =
+            QMessageBox::question(this,
+                                  "确认退出",
+                                  QString("代码正在执行中（%1），确定要退出吗？").arg(running.join("、")),
+                                  QMessageBox::Yes | QMessageBox::No);
 
         if (reply == QMessageBox::Yes) {
-            m_runner->abortExecution();
+            for (EditorTab* tab : m_tabs) {
+                tab->runner->abortExecution();
+            }
             event->accept();
         }
         else {
             event->ignore();
         }
     }
+    else if (saveSessionInBackground()) {
+        event->ignore();
+    }
     else {
         saveWindowSettings();
-        saveCurrentCode();
+        saveAllTabs();
         event->accept();
     }
 }
+
+bool PyWindow::saveSessionInBackground()
+{
+    if (m_sessionSaveThread) {
+        return true;
+    }
+    if (m_sessionSaved || !m_checkpointCheck->isEnabled() || !m_checkpointCheck->isChecked() ||
+        !m_sessionCheck->isChecked() || !m_pythonManager->isInitialized() || m_pythonManager->isInitializing()) {
+        return false;
+    }
+
+    // 序列化大量数据可能需要几秒，期间界面保持响应，但不再接受新的运行
+    setEnabled(false);
+    statusBar()->showMessage("正在保存会话变量...");
+
+    auto summary        = std::make_shared<SessionCheckpoint::Summary>();
+    m_sessionSaveThread = QThread::create([this, summary]() {
+        py::gil_scoped_acquire acquire;
+        *summary = m_pythonManager->saveSession(sessionCheckpointPath());
+    });
+    connect(m_sessionSaveThread, &QThread::finished, this, [this, summary]() {
+        if (!summary->error.isEmpty()) {
+            qWarning() << "Session checkpoint not saved:" << summary->error;
+        }
+        m_sessionSaveThread->deleteLater();
+        m_sessionSaveThread = nullptr;
+        m_sessionSaved      = true;
+        close();
+    });
+    m_sessionSaveThread->start();
+    return true;
+}
@@ -1,16 +1,40 @@
 #pragma once
 
 #include "CodeRunner.h"
+#include "PythonInterpreterManager.h"
+#include "RunMetricsLog.h"
 
 #include <QMainWindow>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QLineEdit>
+#include <QProgressBar>
 #include <QPushButton>
-#include <QSettings>
+#include <QSet>
+#include <QStackedWidget>
+#include <QTabWidget>
 #include <QTimer>
 
+#include <atomic>
+#include <memory>
+
+class FlameGraphView;
+class ImageView;
+class OutlineView;
+class OutputConsole;
+class OutputLog;
+class OutputSearch;
+class ProfileView;
 class PyEditor;
-class QTextEdit;
 class CodeRunner;
+class ExecutionServer;
 class PythonInterpreterManager;
+class ReplayView;
+class RunMetricsView;
+class VariablesView;
+class WatchesView;
 
 /**
  * @class PyWindow
@@ -21,6 +45,7 @@ class PythonInterpreterManager;
  * - 更好的异常处理和用户反馈
  * - 可配置的Python环境设置
  * - 改进的UI响应性
+ * - 多个编辑器标签页，各自有断点、输出和会话命名空间，后台标签页的代码可以继续运行
  */
 class PyWindow : public QMainWindow
 {
@@ -50,6 +75,31 @@ private slots:
      */
     void runPythonCode();
 
+    /**
+     * @brief 以性能分析模式运行Python代码
+     */
+    void profilePythonCode();
+
+    /**
+     * @brief 以采样分析模式运行Python代码
+     */
+    void samplePythonCode();
+
+    /**
+     * @brief 录制运行当前代码，结束后在回放页中查看
+     */
+    void recordPythonCode();
+
+    /**
+     * @brief 运行光标所在的单元格
+     */
+    void runCurrentCell();
+
+    /**
+     * @brief 运行自上次运行后修改过的单元格
+     */
+    void runChangedCells();
+
     /**
      * @brief 追加输出文本
      * @param text 输出文本
@@ -57,31 +107,54 @@ private slots:
     void appendOutput(const QString& text);
 
     /**
-     * @brief 追加错误文本
-     * @param text 错误文本
+     * @brief 新建空白标签页
      */
-    void appendError(const QString& text);
+    void newTab();
 
     /**
-     * @brief 执行开始处理
+     * @brief 关闭标签页（运行中的标签页先询问是否停止，第一个标签页不能关闭）
+     * @param index 标签页序号
      */
-    void onExecutionStart();
+    void closeTab(int index);
 
     /**
-     * @brief 执行完成处理
+     * @brief 切换当前标签页：只切换显示的编辑器和输出窗口，文档不重新加载或高亮
+     * @param index 标签页序号
      */
-    void onExecutionFinish();
+    void onCurrentTabChanged(int index);
 
     /**
-     * @brief Python解释器状态变化处理
+     * @brief Python解释器启动进度处理
+     * @param phase 即将开始的阶段名称
+     * @param step 阶段序号（1-based）
+     * @param total 阶段总数
+     */
+    void onPythonStartupProgress(const QString& phase, int step, int total);
+
+    /**
+     * @brief Python解释器初始化完成处理（显示各阶段耗时并运行排队的代码）
      */
     void onPythonInitialized();
 
     /**
-     * @brief 调试状态变化处理
-     * @param state 新的调试状态
+     * @brief Python解释器初始化失败处理
+     * @param error 错误信息
      */
-    void onDebugStateChanged(int state);
+    void onPythonInitializationFailed(const QString& error);
+
+    /**
+     * @brief 显示预导入各模块的耗时（不计入运行时间）
+     * @param modules 各模块的导入结果
+     */
+    void reportWarmUp(const QVector<PythonInterpreterManager::WarmUpModule>& modules);
+
+    /**
+     * @brief 显示会话检查点的恢复结果
+     * @param restored 恢复的变量数
+     * @param skipped 未能恢复的变量名
+     * @param elapsedNs 恢复耗时
+     */
+    void reportSessionRestored(int restored, const QStringList& skipped, qint64 elapsedNs);
 
     /**
      * @brief 显示设置对话框
@@ -93,6 +166,12 @@ private slots:
      */
     void applySettings();
 
+    /**
+     * @brief 重启Python解释器（运行期间不允许），编辑器内容和断点保留，会话变量丢失
+     * @param environmentChanged Python环境设置已修改（进程后端的界面进程解释器也随之重启）
+     */
+    void restartInterpreter(bool environmentChanged = false);
+
     /**
      * @about 加载示例代码
      */
@@ -108,14 +187,247 @@ private slots:
      */
     void loadSavedCode();
 
+    /**
+     * @brief 选择文件并在新标签页中打开（分块加载，状态栏显示进度）
+     */
+    void openFile();
+
+    /**
+     * @brief 把输入行的内容作为一行标准输入发给当前标签页的运行器，并回显到输出窗口
+     */
+    void submitInput();
+
+    /**
+     * @brief 选择文件并把全部内容作为当前标签页的标准输入
+     */
+    void submitInputFile();
+
+    /**
+     * @brief 结束当前标签页的标准输入（Ctrl+D），之后input()抛出EOFError
+     */
+    void closeInput();
+
+    /**
+     * @brief 在当前标签页的全部输出中开始搜索（输入停顿后或切换大小写时调用）
+     */
+    void startOutputSearch();
+
+    /**
+     * @brief 跳到下一个搜索结果
+     */
+    void showNextMatch();
+
+    /**
+     * @brief 跳到上一个搜索结果
+     */
+    void showPreviousMatch();
+
+    /**
+     * @brief 选择文件并在后台导出当前标签页的全部输出（.gz结尾时压缩）
+     */
+    void exportOutput();
+
 private:
+    /**
+     * @brief 运行方式
+     */
+    enum RunMode
+    {
+        NormalRun,        // 普通运行
+        LineProfileRun,   // 逐行性能分析
+        SamplingRun,      // 采样分析
+        RecordRun         // 录制运行
+    };
+
+    /**
+     * @brief 编辑器标签页：文档、断点和运行上下文
+     *
+     * 每个标签页有自己的编辑器、运行器（线程后端还有运行线程）和输出窗口。
+     * 线程后端的运行器都在本进程的解释器中运行，各用一个会话命名空间上下文；
+     * 进程后端的运行器各有一个执行进程。后台标签页的代码在编辑其他标签页时继续运行。
+     */
+    struct EditorTab
+    {
+        PyEditor*      editor       = nullptr;
+        CodeRunner*    runner       = nullptr;
+        QThread*       runnerThread = nullptr;   // 线程后端的运行线程
+        OutputConsole* output       = nullptr;   // 本标签页的运行输出
+        QTimer*        flushTimer   = nullptr;   // 输出按帧刷新
+        QString        context;                  // 会话命名空间上下文，第一个标签页为空
+        QString        filePath;                 // 打开的文件，空表示草稿
+        QString        title;
+        int            debugState = CodeRunner::Running;
+        QVector<CodeRunner::DebugThread> threads;   // 运行中的线程，调试器线程选择框的内容
+        unsigned long  debugThread = 0;           // 选中的调试线程，0表示运行线程
+
+        // 运行状态
+        bool          isExecuting = false;
+        QString       lastRunCode;               // 最近一次运行的代码，热点表格按行号显示
+        bool          runPending  = false;       // 解释器启动期间排队的运行
+        RunMode       pendingMode = NormalRun;
+        QString       pendingCode;
+        QVector<uint> pendingCells;
+        QVector<uint> runCells;                  // 正在运行的单元格内容哈希
+        bool          runPersistent  = false;    // 正在运行的代码是否使用会话命名空间
+        bool          runFailed      = false;    // 正在运行的代码出错或被中止
+        bool          runRecorded    = false;    // 正在运行的是录制运行
+        bool          resultsPending   = false;  // 在后台结束的分析结果，切换到该标签页时显示
+        bool          recordingPending = false;  // 尚未显示的录制
+    };
+
+    /**
+     * @brief 创建标签页（编辑器、运行器和输出窗口）并连接信号
+     * @param title 标签页标题
+     * @return EditorTab* 新标签页，已加入标签栏
+     */
+    EditorTab* createTab(const QString& title);
+
+    /**
+     * @brief 停止并释放标签页的运行器、运行线程和部件
+     * @param tab 标签页
+     */
+    void destroyTab(EditorTab* tab);
+
+    /**
+     * @brief 是否有标签页正在运行或等待解释器
+     */
+    bool isAnyTabBusy() const;
+
+    /**
+     * @brief 保存标签页的代码：草稿保存到应用数据目录，打开的文件保存到原文件
+     * @param tab 标签页
+     * @param interactive 新建的标签页是否弹出对话框选择文件（否则跳过），并在状态栏报告结果
+     */
+    void saveTab(EditorTab* tab, bool interactive);
+
+    /**
+     * @brief 保存草稿和打开的文件（退出时调用）
+     */
+    void saveAllTabs();
+
+    /**
+     * @brief 收到输出通知后安排刷新
+     *
+     * 积压较少时等到下一帧再整批取出，超过高水位时立即取出。
+     * @param tab 产生输出的标签页
+     */
+    void onOutputReady(EditorTab* tab);
+
+    /**
+     * @brief 从输出通道整批取出数据并一次插入标签页的输出窗口
+     * @param tab 标签页
+     */
+    void drainOutput(EditorTab* tab);
+
+    /**
+     * @brief 代码开始或结束等待标准输入：先显示提示文字，再把焦点交给输入行
+     * @param tab 标签页
+     * @param waiting 是否正在等待
+     */
+    void onInputWaitChanged(EditorTab* tab, bool waiting);
+
+    /**
+     * @brief 追加错误文本
+     * @param tab 标签页
+     * @param text 错误文本
+     */
+    void appendError(EditorTab* tab, const QString& text);
+
+    /**
+     * @brief 执行开始处理
+     * @param tab 开始运行的标签页
+     */
+    void onExecutionStart(EditorTab* tab);
+
+    /**
+     * @brief 执行完成处理
+     * @param tab 结束运行的标签页
+     */
+    void onExecutionFinish(EditorTab* tab);
+
+    /**
+     * @brief 在结果页中显示标签页最近一次运行的性能分析、火焰图和录制
+     * @param tab 标签页
+     */
+    void showRunResults(EditorTab* tab);
+
+    /**
+     * @brief 显示运行汇总（耗时、中止响应时间）
+     * @param tab 标签页
+     * @param summary 汇总信息
+     */
+    void onRunSummary(EditorTab* tab, const CodeRunner::RunSummary& summary);
+
+    /**
+     * @brief 调试状态变化处理
+     * @param tab 标签页
+     * @param state 新的调试状态
+     */
+    void onDebugStateChanged(EditorTab* tab, int state);
+
+    /**
+     * @brief 按当前标签页的调试状态更新调试按钮
+     */
+    void updateDebugButtons();
+
+    /**
+     * @brief 按当前标签页运行中的线程更新调试线程选择框
+     */
+    void updateThreadCombo();
+
+    /**
+     * @brief 开始运行编辑器中的代码，正在运行时中止
+     *
+     * 解释器尚在启动时记下代码，初始化完成后再运行。
+     * @param mode 运行方式
+     */
+    void startRun(RunMode mode);
+
+    /**
+     * @brief 在会话命名空间中运行部分单元格
+     *
+     * 未勾选"保留会话变量"时自动勾选：单元格依赖之前运行的结果。
+     * @param changedOnly true运行所有修改过的单元格，false运行光标所在的单元格
+     */
+    void startCellRun(bool changedOnly);
+
+    /**
+     * @brief 运行代码，解释器尚在启动时排队
+     * @param mode 运行方式
+     * @param code Python代码
+     * @param cells 代码包含的单元格内容哈希，运行成功后记为已运行
+     */
+    void queueRun(RunMode mode, const QString& code, const QVector<uint>& cells);
+
+    /**
+     * @brief 把代码交给运行器执行
+     * @param tab 标签页
+     * @param mode 运行方式
+     * @param code Python代码
+     * @param cells 代码包含的单元格内容哈希
+     */
+    void dispatchRun(EditorTab* tab, RunMode mode, const QString& code, const QVector<uint>& cells);
+
+    /**
+     * @brief 在输出窗口中显示内存统计
+     * @param output 输出窗口
+     * @param report 统计结果
+     */
+    void showMemoryReport(OutputConsole* output, const MemoryReport& report);
+
+    /**
+     * @brief 把当前标签页的编辑器光标移到指定行
+     * @param lineNumber 行号（1-based）
+     */
+    void jumpToLine(int lineNumber);
+
     /**
      * @brief 初始化UI界面
      */
     void initializeUI();
 
     /**
-     * @brief 初始化Python解释器
+     * @brief 在后台线程中启动Python解释器
      */
     void initializePython();
 
@@ -140,7 +452,7 @@ private:
     void updateExecutionButtons();
 
     /**
-     * @brief 清除输出
+     * @brief 清除当前标签页的输出
      */
     void clearOutput();
 
@@ -149,31 +461,103 @@ private:
      */
     void closeEvent(QCloseEvent* event);
 
+    /**
+     * @brief 退出前在后台线程中保存会话检查点，完成后再次关闭窗口
+     * @return bool 已开始或正在保存返回true，不需要保存返回false
+     */
+    bool saveSessionInBackground();
+
+    /**
+     * @brief 取消搜索并清除结果和高亮
+     */
+    void resetOutputSearch();
+
+    /**
+     * @brief 标出一个搜索结果，所在行已移出输出窗口时在状态栏显示该行
+     * @param index 结果序号，超出范围时循环
+     */
+    void showSearchMatch(int index);
+
+    /**
+     * @brief 刷新搜索行旁的结果计数
+     */
+    void updateSearchStatus();
+
 private:
     // UI组件
-    PyEditor*    m_codeEditor     = nullptr;
-    QTextEdit*   m_logOutput      = nullptr;
+    QTabWidget*     m_editorTabs  = nullptr;   // 编辑器标签页
+    QStackedWidget* m_outputStack = nullptr;   // 各标签页的输出窗口，随当前标签页切换
+    QWidget*        m_outputPage  = nullptr;   // 输出页：输出窗口和下方的标准输入行
+    QLineEdit*      m_inputEdit   = nullptr;   // 标准输入行，回车发送一行
+    QPushButton*    m_inputFileButton = nullptr;
+    QLineEdit*      m_searchEdit      = nullptr;   // 输出搜索行
+    QCheckBox*      m_searchCaseCheck = nullptr;
+    QLabel*         m_searchStatus    = nullptr;   // 结果计数
+    QPushButton*    m_exportButton    = nullptr;
     QPushButton* m_runButton      = nullptr;
+    QPushButton* m_profileButton  = nullptr;
+    QPushButton* m_sampleButton   = nullptr;
+    QPushButton* m_recordButton   = nullptr;
+    QPushButton* m_runCellButton    = nullptr;   // 运行光标所在的单元格
+    QPushButton* m_runChangedButton = nullptr;   // 运行修改过的单元格
     QPushButton* m_clearButton    = nullptr;
     QPushButton* m_settingsButton = nullptr;
+    QPushButton* m_restartButton  = nullptr;   // 重启Python解释器
     QPushButton* m_saveButton     = nullptr;
+    QPushButton* m_openButton     = nullptr;
+    QPushButton* m_newTabButton   = nullptr;
+    QPushButton* m_formatButton   = nullptr;
+    QProgressBar* m_loadProgress  = nullptr;   // 文件加载进度（状态栏）
+    QCheckBox*   m_sessionCheck   = nullptr;   // 多次运行之间保留会话命名空间
+    QCheckBox*   m_checkpointCheck = nullptr;  // 退出时保存会话检查点
+    QCheckBox*   m_memoryCheck    = nullptr;   // 运行期间统计内存
+    QCheckBox*   m_objectsCheck   = nullptr;   // 运行前后做对象存活诊断
+    QTabWidget*  m_outputTabs     = nullptr;   // 输出和性能分析结果
+    ProfileView* m_profileView    = nullptr;
+    FlameGraphView* m_flameGraphView = nullptr;
+    QWidget*        m_flameGraphTab  = nullptr;   // 火焰图所在的滚动区域
+    RunMetricsView* m_metricsView    = nullptr;   // 每次运行的指标
+    RunMetricsLog   m_metricsLog;                 // 运行指标的JSON Lines日志
+    VariablesView*  m_variablesView  = nullptr;   // 暂停时的变量
+    WatchesView*    m_watchesView    = nullptr;   // 监视表达式
+    ReplayView*     m_replayView     = nullptr;   // 录制运行的回放
+    OutlineView*    m_outlineView    = nullptr;   // 缓冲区的类和函数
+    ImageView*      m_imageView      = nullptr;   // show_image()提交的图像
 
     // 调试按钮
+    QPushButton* m_pauseButton    = nullptr;
     QPushButton* m_continueButton = nullptr;
     QPushButton* m_stepIntoButton = nullptr;
     QPushButton* m_stepOverButton = nullptr;
     QPushButton* m_stepOutButton  = nullptr;
+    QComboBox*   m_threadCombo    = nullptr;   // 调试的线程
+
+    // 标签页，顺序与m_editorTabs一致
+    QVector<EditorTab*> m_tabs;
+    EditorTab*          m_currentTab = nullptr;
+    EditorTab*          m_resultsTab = nullptr;   // 结果页（性能分析、火焰图、回放）显示的标签页
+    int                 m_tabCounter = 0;         // 已创建的标签页数，用于编号
+    QSet<EditorTab*>    m_saveRequested;          // 手动保存、等待结果的标签页
+    QStringList         m_watchExpressions;       // 监视表达式，所有标签页共用
 
     // 核心组件
-    CodeRunner*               m_runner        = nullptr;
-    QThread*                  m_runnerThread  = nullptr;
-    PythonInterpreterManager* m_pythonManager = nullptr;
+    PythonInterpreterManager* m_pythonManager   = nullptr;
+    ExecutionServer*          m_executionServer = nullptr;   // 本地执行服务，未配置Server/name时为空
 
     // 状态管理
-    bool      m_isExecuting = false;
-    QSettings m_settings;
-    QString   m_lastSavedCode;
-    QString   m_settingsFile;
+    QElapsedTimer m_restartTimer;            // 重启解释器开始计时，就绪后报告耗时
+    QThread*      m_sessionSaveThread = nullptr;   // 退出时在后台保存会话检查点的线程
+    bool          m_sessionSaved      = false;     // 会话检查点已保存，可以关闭窗口
+
+    // 输出搜索和导出
+    OutputSearch*              m_outputSearch    = nullptr;
+    QTimer*                    m_searchTimer     = nullptr;   // 输入停顿后开始搜索
+    EditorTab*                 m_searchTab       = nullptr;   // 搜索结果所属的标签页
+    std::shared_ptr<OutputLog> m_searchLog;                  // 搜索的快照，读取已移出输出窗口的结果行
+    int                        m_searchIndex     = -1;        // 当前结果
+    bool                       m_searchTruncated = false;
+    QThread*                   m_exportThread    = nullptr;   // 后台导出输出的线程
+    std::atomic<bool>          m_exportCancelled{false};
 
     // 示例代码
     QString m_exampleCode;
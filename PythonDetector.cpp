@@ -0,0 +1,289 @@
+#include "PythonDetector.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <vector>
+
+// 缓存格式变化时递增，旧缓存随之失效
+static const int kCacheVersion = 1;
+
+// 验证一个候选解释器的最长等待时间
+static const int kProbeTimeoutMs = 2000;
+
+// 并行验证的线程数上限（主要是等待进程和文件系统，与CPU数关系不大）
+static const int kMaxProbeThreads = 8;
+
+namespace {
+
+struct Candidate
+{
+    QString executable;
+    bool    conda = false;   // Conda解释器只检查文件是否存在，与原有行为一致
+};
+
+struct Probe
+{
+    bool    exists = false;
+    bool    valid  = false;
+    qint64  mtime  = 0;
+    QString version;
+};
+
+QStringList condaRoots()
+{
+#ifdef Q_OS_WINDOWS
+    return {QDir::homePath() + "/miniconda3",
+            QDir::homePath() + "/anaconda3",
+            "C:/miniconda3",
+            "C:/anaconda3"};
+#else
+    return {QDir::homePath() + "/miniconda3", QDir::homePath() + "/anaconda3"};
+#endif
+}
+
+// 按优先级排列的候选解释器：先Conda，再按PATH顺序
+std::vector<Candidate> candidates()
+{
+    std::vector<Candidate> result;
+
+    for (const QString& root : condaRoots()) {
+#ifdef Q_OS_WINDOWS
+        result.push_back({root + "/python.exe", true});
+#else
+        result.push_back({root + "/bin/python", true});
+#endif
+    }
+
+    QStringList executables;
+#ifdef Q_OS_WINDOWS
+    executables << "python.exe" << "python3.exe";
+#else
+    executables << "python3" << "python";
+#endif
+
+    const QStringList pathDirs = qEnvironmentVariable("PATH").split(QDir::listSeparator(), Qt::SkipEmptyParts);
+    for (const QString& dir : pathDirs) {
+        for (const QString& executable : executables) {
+            result.push_back({QDir(dir).filePath(executable), false});
+        }
+    }
+
+    return result;
+}
+
+Probe probe(const Candidate& candidate)
+{
+    Probe     result;
+    QFileInfo info(candidate.executable);
+    if (!info.exists()) {
+        return result;
+    }
+
+    result.exists = true;
+    result.mtime  = info.lastModified().toMSecsSinceEpoch();
+
+    if (candidate.conda) {
+        result.valid = true;
+        return result;
+    }
+
+    // 验证是否是有效的Python解释器（Python 2把版本输出到标准错误）
+    QProcess pythonCheck;
+    pythonCheck.setProcessChannelMode(QProcess::MergedChannels);
+    pythonCheck.start(candidate.executable, QStringList() << "--version");
+    if (pythonCheck.waitForFinished(kProbeTimeoutMs)) {
+        const QString version = QString::fromLocal8Bit(pythonCheck.readAll()).trimmed();
+        if (version.contains("Python")) {
+            result.valid   = true;
+            result.version = version;
+        }
+    }
+    else {
+        pythonCheck.kill();
+        pythonCheck.waitForFinished();
+    }
+
+    return result;
+}
+
+}   // namespace
+
+PythonDetector::PythonDetector(QSettings* settings, QObject* parent)
+    : QObject(parent)
+    , m_settings(settings)
+{}
+
+PythonDetector::~PythonDetector()
+{
+    if (m_refreshThread) {
+        m_refreshThread->wait();
+        delete m_refreshThread;
+    }
+}
+
+bool PythonDetector::cachedResult(Result* result) const
+{
+    if (!m_settings) {
+        return false;
+    }
+
+    m_settings->beginGroup("PythonDetection");
+    bool valid = m_settings->value("version").toInt() == kCacheVersion &&
+                 m_settings->value("key").toString() == environmentKey();
+
+    if (valid) {
+        result->home       = m_settings->value("home").toString();
+        result->executable = m_settings->value("executable").toString();
+        result->version    = m_settings->value("pythonVersion").toString();
+
+        // 已发现的解释器被升级、删除或替换时修改时间会变化
+        const int count = m_settings->beginReadArray("files");
+        for (int i = 0; i < count && valid; ++i) {
+            m_settings->setArrayIndex(i);
+            QFileInfo info(m_settings->value("path").toString());
+            valid = info.exists() &&
+                    info.lastModified().toMSecsSinceEpoch() == m_settings->value("mtime").toLongLong();
+        }
+        m_settings->endArray();
+    }
+
+    m_settings->endGroup();
+    return valid;
+}
+
+PythonDetector::Result PythonDetector::detectNow()
+{
+    QVector<QPair<QString, qint64>> files;
+    Result                          result = detect(&files);
+    storeCache(result, files);
+    return result;
+}
+
+void PythonDetector::refreshInBackground()
+{
+    if (m_refreshThread) {
+        return;
+    }
+
+    Result previous;
+    if (!cachedResult(&previous)) {
+        previous = Result();
+    }
+
+    m_refreshThread = QThread::create([this, previous]() {
+        QVector<QPair<QString, qint64>> files;
+        Result                          current = detect(&files);
+
+        // 缓存在所属线程中写入
+        QMetaObject::invokeMethod(
+            this,
+            [this, previous, current, files]() {
+                m_refreshThread->wait();
+                delete m_refreshThread;
+                m_refreshThread = nullptr;
+
+                storeCache(current, files);
+                if (current != previous) {
+                    qDebug() << "Python detection changed from" << previous.home << "to" << current.home;
+                    emit refreshed(previous, current);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+    m_refreshThread->setObjectName("PythonDetector");
+    m_refreshThread->start();
+}
+
+PythonDetector::Result PythonDetector::detect(QVector<QPair<QString, qint64>>* files)
+{
+    const std::vector<Candidate> list = candidates();
+    std::vector<Probe>           probes(list.size());
+
+    // 每个线程依次领取候选；排在已找到的结果之后的候选不再验证
+    std::atomic<int> next{0};
+    std::atomic<int> best{INT_MAX};
+    auto             worker = [&]() {
+        for (int index = next.fetch_add(1); index < static_cast<int>(list.size());
+             index     = next.fetch_add(1)) {
+            if (index > best.load()) {
+                continue;
+            }
+
+            probes[index] = probe(list[index]);
+            if (probes[index].valid) {
+                int current = best.load();
+                while (index < current && !best.compare_exchange_weak(current, index)) {
+                }
+            }
+        }
+    };
+
+    const int threadCount = std::min<int>(kMaxProbeThreads, static_cast<int>(list.size()));
+    std::vector<QThread*> threads;
+    for (int i = 1; i < threadCount; ++i) {
+        threads.push_back(QThread::create(worker));
+        threads.back()->start();
+    }
+    worker();
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    Result result;
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (probes[i].exists && files) {
+            files->append(qMakePair(list[i].executable, probes[i].mtime));
+        }
+        if (probes[i].valid && result.home.isEmpty()) {
+            result.executable = list[i].executable;
+            result.home       = QFileInfo(list[i].executable).canonicalPath();
+            result.version    = probes[i].version;
+        }
+    }
+
+    return result;
+}
+
+QString PythonDetector::environmentKey()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(qEnvironmentVariable("PATH").toUtf8());
+    for (const QString& root : condaRoots()) {
+        hash.addData("\n");
+        hash.addData(root.toUtf8());
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+void PythonDetector::storeCache(const Result& result, const QVector<QPair<QString, qint64>>& files)
+{
+    if (!m_settings) {
+        return;
+    }
+
+    m_settings->beginGroup("PythonDetection");
+    m_settings->setValue("version", kCacheVersion);
+    m_settings->setValue("key", environmentKey());
+    m_settings->setValue("home", result.home);
+    m_settings->setValue("executable", result.executable);
+    m_settings->setValue("pythonVersion", result.version);
+
+    m_settings->beginWriteArray("files", files.size());
+    for (int i = 0; i < files.size(); ++i) {
+        m_settings->setArrayIndex(i);
+        m_settings->setValue("path", files[i].first);
+        m_settings->setValue("mtime", files[i].second);
+    }
+    m_settings->endArray();
+    m_settings->endGroup();
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QObject>
+#include <QSettings>
+#include <QString>
+#include <QVector>
+
+class QThread;
+
+/**
+ * @class PythonDetector
+ * @brief Python安装检测，结果持久化缓存
+ *
+ * 完整检测需要查看Conda目录和PATH中的每个目录，并对每个候选解释器运行
+ * `python --version`；PATH较长或含网络驱动器时需要数秒。检测结果连同
+ * PATH内容的指纹和所有已发现解释器的修改时间一起保存在配置文件中：
+ * - PATH未变且这些解释器文件未变时直接使用缓存，只需几次stat
+ * - 命中缓存后在后台重新检测一次，发现新安装的环境时发出refreshed()
+ * - 缓存失效时并行验证各候选解释器，按原有优先级（Conda优先，PATH顺序）取第一个
+ *
+ * 除detect()外的接口都应在所属线程中调用。
+ */
+class PythonDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 检测结果
+     */
+    struct Result
+    {
+        QString home;         // 解释器所在目录，未检测到时为空
+        QString executable;   // 解释器路径
+        QString version;      // `--version`的输出，Conda解释器不运行时为空
+
+        bool operator==(const Result& other) const
+        {
+            return home == other.home && executable == other.executable;
+        }
+        bool operator!=(const Result& other) const { return !(*this == other); }
+    };
+
+    /**
+     * @brief 构造函数
+     * @param settings 保存缓存的配置（由调用方持有）
+     * @param parent 父对象
+     */
+    explicit PythonDetector(QSettings* settings, QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（等待后台检测结束）
+     */
+    ~PythonDetector() override;
+
+    /**
+     * @brief 读取并验证缓存
+     * @param result 输出缓存的结果
+     * @return bool 缓存存在且仍然有效返回true
+     */
+    bool cachedResult(Result* result) const;
+
+    /**
+     * @brief 立即进行完整检测并更新缓存
+     * @return Result 检测结果
+     */
+    Result detectNow();
+
+    /**
+     * @brief 在后台线程中进行完整检测（已有检测在进行时忽略）
+     *
+     * 结束后更新缓存，结果与检测前的缓存不同时发出refreshed()。
+     */
+    void refreshInBackground();
+
+    /**
+     * @brief 完整检测（不读写缓存，可在任意线程调用）
+     * @param files 输出检测过程中发现的解释器文件及其修改时间
+     * @return Result 检测结果
+     */
+    static Result detect(QVector<QPair<QString, qint64>>* files = nullptr);
+
+signals:
+    /**
+     * @brief 后台检测发现结果变化信号
+     * @param previous 检测前缓存的结果
+     * @param current 新的结果
+     */
+    void refreshed(const PythonDetector::Result& previous, const PythonDetector::Result& current);
+
+private:
+    /**
+     * @brief 当前环境的指纹（PATH内容和Conda候选目录）
+     * @return QString 十六进制摘要
+     */
+    static QString environmentKey();
+
+    /**
+     * @brief 保存检测结果和验证所需的文件修改时间
+     * @param result 检测结果
+     * @param files 发现的解释器文件及其修改时间
+     */
+    void storeCache(const Result& result, const QVector<QPair<QString, qint64>>& files);
+
+private:
+    QSettings* m_settings      = nullptr;
+    QThread*   m_refreshThread = nullptr;
+};
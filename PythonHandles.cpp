@@ -0,0 +1,125 @@
+#include "PythonHandles.h"
+
+#include <atomic>
+#include <cstdint>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+// 解释器状态字典中的键，同时作为胶囊名
+static const char* const kHandlesKey = "qtpythonembed.handles";
+
+// 每释放一份句柄加一；解释器销毁后新解释器可能位于同一地址，线程缓存据此失效
+static std::atomic<uint64_t> s_epoch{0};
+
+// 当前线程最近一次使用的解释器及其句柄
+static thread_local PyInterpreterState*  t_interpreter = nullptr;
+static thread_local uint64_t             t_epoch       = 0;
+static thread_local const PythonHandles* t_handles     = nullptr;
+
+const PythonHandles& PythonHandles::current()
+{
+    PyInterpreterState* interpreter = PyInterpreterState_Get();
+    const uint64_t      epoch       = s_epoch.load(std::memory_order_acquire);
+    if (t_handles && t_interpreter == interpreter && t_epoch == epoch) {
+        return *t_handles;
+    }
+
+    const PythonHandles& handles = lookup(interpreter);
+    t_interpreter                = interpreter;
+    t_epoch                      = epoch;
+    t_handles                    = &handles;
+    return handles;
+}
+
+const PythonHandles& PythonHandles::lookup(PyInterpreterState* interpreter)
+{
+    PyObject* state = PyInterpreterState_GetDict(interpreter);
+    if (!state) {
+        PyErr_SetString(PyExc_RuntimeError, "interpreter state dict is unavailable");
+        throw py::error_already_set();
+    }
+
+    if (PyObject* capsule = PyDict_GetItemString(state, kHandlesKey)) {
+        return *static_cast<const PythonHandles*>(PyCapsule_GetPointer(capsule, kHandlesKey));
+    }
+
+    PythonHandles* handles = new PythonHandles;
+    handles->sys           = PyImport_ImportModule("sys");
+    handles->builtins      = PyImport_ImportModule("builtins");
+
+    Names& names      = handles->names;
+    names.main        = PyUnicode_InternFromString("__main__");
+    names.builtins    = PyUnicode_InternFromString("__builtins__");
+    names.name        = PyUnicode_InternFromString("__name__");
+    names.modules     = PyUnicode_InternFromString("modules");
+    names.path        = PyUnicode_InternFromString("path");
+    names.version     = PyUnicode_InternFromString("version");
+    names.hexVersion  = PyUnicode_InternFromString("hexversion");
+    names.standardIn  = PyUnicode_InternFromString("stdin");
+    names.standardOut = PyUnicode_InternFromString("stdout");
+    names.standardErr = PyUnicode_InternFromString("stderr");
+    names.traceLines  = PyUnicode_InternFromString("f_trace_lines");
+    names.qualName    = PyUnicode_InternFromString("co_qualname");
+    names.codeName    = PyUnicode_InternFromString("co_name");
+    names.fileName    = PyUnicode_InternFromString("co_filename");
+    names.firstLineNo = PyUnicode_InternFromString("co_firstlineno");
+    names.codeLines   = PyUnicode_InternFromString("co_lines");
+
+    PyObject* const required[] = {handles->sys,     handles->builtins, names.main,        names.builtins,
+                                  names.name,       names.modules,     names.path,        names.version,
+                                  names.hexVersion, names.standardIn,  names.standardOut, names.standardErr,
+                                  names.traceLines, names.qualName,    names.codeName,    names.fileName,
+                                  names.firstLineNo, names.codeLines};
+    for (PyObject* object : required) {
+        if (!object) {
+            delete handles;
+            throw py::error_already_set();
+        }
+    }
+    handles->sysDict = PyModule_GetDict(handles->sys);
+
+    // 胶囊归状态字典所有，解释器销毁时由destroy()释放句柄
+    PyObject* capsule = PyCapsule_New(handles, kHandlesKey, &PythonHandles::destroy);
+    if (!capsule) {
+        delete handles;
+        throw py::error_already_set();
+    }
+    const int stored = PyDict_SetItemString(state, kHandlesKey, capsule);
+    Py_DECREF(capsule);
+    if (stored < 0) {
+        throw py::error_already_set();
+    }
+    return *handles;
+}
+
+void PythonHandles::destroy(PyObject* capsule)
+{
+    s_epoch.fetch_add(1, std::memory_order_acq_rel);
+    delete static_cast<PythonHandles*>(PyCapsule_GetPointer(capsule, kHandlesKey));
+}
+
+PythonHandles::~PythonHandles()
+{
+    Py_XDECREF(sys);
+    Py_XDECREF(builtins);
+    Py_XDECREF(names.main);
+    Py_XDECREF(names.builtins);
+    Py_XDECREF(names.name);
+    Py_XDECREF(names.modules);
+    Py_XDECREF(names.path);
+    Py_XDECREF(names.version);
+    Py_XDECREF(names.hexVersion);
+    Py_XDECREF(names.standardIn);
+    Py_XDECREF(names.standardOut);
+    Py_XDECREF(names.standardErr);
+    Py_XDECREF(names.traceLines);
+    Py_XDECREF(names.qualName);
+    Py_XDECREF(names.codeName);
+    Py_XDECREF(names.fileName);
+    Py_XDECREF(names.firstLineNo);
+    Py_XDECREF(names.codeLines);
+}
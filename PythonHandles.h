@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Python.h>
+
+/**
+ * @class PythonHandles
+ * @brief 宿主代码常用的Python对象和属性名，每个解释器一份
+ *
+ * 宿主每次运行都要访问sys、builtins和一组固定的名字（__main__、__builtins__、path等）。
+ * 经py::module_::import()和字符串参数的C API取得时，每次都要查模块表、新建字符串并计算哈希；
+ * 这里在解释器中第一次使用时取得一次并持有强引用，之后直接返回同一组对象。
+ * 名字都是驻留字符串，作为字典键查找时比较指针即可命中。
+ *
+ * 句柄保存在解释器的状态字典（PyInterpreterState_GetDict）中，随解释器一起释放：
+ * 主解释器和每个子解释器各有一份，重新初始化后在新解释器中重新创建，调用方不需要清理。
+ * 每个线程缓存最近一次使用的解释器的句柄，命中时不查字典。所有访问都需持有GIL。
+ */
+class PythonHandles
+{
+public:
+    /**
+     * @brief 获取当前解释器的句柄（需持有GIL），第一次调用时创建
+     * @return const PythonHandles& 句柄，在当前解释器销毁前有效
+     * @throws py::error_already_set 创建失败
+     */
+    static const PythonHandles& current();
+
+    /**
+     * @brief 读取sys模块的属性（不调用描述符，不设置异常）
+     * @param name 属性名，通常是names中的驻留字符串
+     * @return PyObject* 借用引用，不存在时为nullptr
+     */
+    PyObject* sysAttribute(PyObject* name) const { return PyDict_GetItem(sysDict, name); }
+
+    // 模块（强引用）
+    PyObject* sys      = nullptr;
+    PyObject* builtins = nullptr;
+    PyObject* sysDict  = nullptr;   // sys.__dict__，借用自sys
+
+    /**
+     * @brief 驻留的名字（强引用）
+     */
+    struct Names
+    {
+        PyObject* main         = nullptr;   // "__main__"
+        PyObject* builtins     = nullptr;   // "__builtins__"
+        PyObject* name         = nullptr;   // "__name__"
+        PyObject* modules      = nullptr;   // "modules"
+        PyObject* path         = nullptr;   // "path"
+        PyObject* version      = nullptr;   // "version"
+        PyObject* hexVersion   = nullptr;   // "hexversion"
+        PyObject* standardIn   = nullptr;   // "stdin"
+        PyObject* standardOut  = nullptr;   // "stdout"
+        PyObject* standardErr  = nullptr;   // "stderr"
+        PyObject* traceLines   = nullptr;   // "f_trace_lines"
+        PyObject* qualName     = nullptr;   // "co_qualname"
+        PyObject* codeName     = nullptr;   // "co_name"
+        PyObject* fileName     = nullptr;   // "co_filename"
+        PyObject* firstLineNo  = nullptr;   // "co_firstlineno"
+        PyObject* codeLines    = nullptr;   // "co_lines"
+    } names;
+
+private:
+    PythonHandles() = default;
+    ~PythonHandles();
+
+    PythonHandles(const PythonHandles&) = delete;
+    PythonHandles& operator=(const PythonHandles&) = delete;
+
+    /**
+     * @brief 在解释器状态字典中查找或创建句柄（线程缓存未命中时调用）
+     */
+    static const PythonHandles& lookup(PyInterpreterState* interpreter);
+
+    /**
+     * @brief 解释器状态字典释放时的胶囊析构函数
+     */
+    static void destroy(PyObject* capsule);
+};
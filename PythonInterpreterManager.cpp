@@ -1,18 +1,50 @@
 #include "PythonInterpreterManager.h"
+#include "BatchKernels.h"
+#include "BufferBridge.h"
 #include "CodeRunner.h"
+#include "ConfigManager.h"
+#include "FrameChannel.h"
+#include "InputQueue.h"
+#include "MemoryProfiler.h"
+#include "ModuleRegistry.h"
+#include "NativeCall.h"
+#include "PythonHandles.h"
 
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
-#include <QSettings>
-#include <QStandardPaths>
-
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 namespace py = pybind11;
 
+// 当前线程绑定的输出回调、中断门和标准输入（运行线程和子解释器工作线程使用），为空时使用全局设置
+static thread_local const PythonInterpreterManager::OutputCallback* t_threadOutput = nullptr;
+static thread_local InterruptGate*                                  t_threadGate   = nullptr;
+static thread_local InputQueue*                                     t_threadInput  = nullptr;
+
+// 用户代码创建的线程继承的中断门（只影响time.sleep）
+static thread_local std::shared_ptr<InterruptGate> t_inheritedGate;
+
+// initialize()中的启动阶段数
+static const int kStartupPhaseCount = 5;
+
+// 解释器信息快照的最短刷新间隔
+static const qint64 kInfoRefreshIntervalMs = 100;
+
 // C++测试函数，用于嵌入式模块
 int testCppFunction(const std::string& input, std::string* output)
 {
@@ -21,19 +53,286 @@ int testCppFunction(const std::string& input, std::string* output)
     return static_cast<int>(input.size());
 }
 
-// Pybind11嵌入式模块定义
-PYBIND11_EMBEDDED_MODULE(cpp_module, m)
+// 并行统计小于limit的素数个数，示范释放GIL的长时间计算
+int64_t countPrimes(int64_t limit)
 {
-    m.def(
+    std::atomic<int64_t> total{0};
+    NativeThreadPool::instance().parallelFor(
+        limit > 2 ? static_cast<size_t>(limit) : 0, 1 << 16, [&total](size_t begin, size_t end) {
+            int64_t found = 0;
+            for (size_t n = std::max<size_t>(begin, 2); n < end; ++n) {
+                bool prime = true;
+                for (size_t d = 2; d * d <= n; ++d) {
+                    if (n % d == 0) {
+                        prime = false;
+                        break;
+                    }
+                }
+                found += prime ? 1 : 0;
+            }
+            total += found;
+        });
+    return total;
+}
+
+// Pybind11嵌入式模块定义（不保存解释器相关的全局状态，可在独立GIL的子解释器中导入）
+PYBIND11_EMBEDDED_MODULE(cpp_module, m, py::multiple_interpreters::per_interpreter_gil())
+{
+    // 参数转换后释放GIL运行；写std::cout，调用互斥执行
+    NativeCall::def<NativeCall::ReleasesGil>(
+        m,
         "test",
         [](const std::string& input) {
             std::string output;
             int         result = testCppFunction(input, &output);
-            return py::make_tuple(result, output);
+            return std::make_pair(result, output);
         },
         py::arg("input"));
 
+    NativeCall::def<NativeCall::ThreadSafe>(
+        m, "count_primes", countPrimes, py::arg("limit"), "Count primes below limit without holding the GIL");
+    NativeCall::defAsync(m,
+                         "count_primes_async",
+                         countPrimes,
+                         py::arg("limit"),
+                         "Count primes below limit on the native thread pool, returning a concurrent.futures.Future");
+
     m.def("get_version", []() { return "1.0.0"; });
+
+    // 插件目录中登记的扩展模块及其加载状态
+    m.def("extension_modules", []() {
+        py::list result;
+        for (const ModuleRegistry::Module& module : ModuleRegistry::instance().modules()) {
+            py::dict info;
+            info["name"]    = module.name.toStdString();
+            info["path"]    = module.path.toStdString();
+            info["loaded"]  = module.loaded;
+            info["load_ms"] = module.loadNs / 1e6;
+            info["error"]   = module.error.toStdString();
+            result.append(info);
+        }
+        return result;
+    });
+
+    // 与宿主程序共享内存的NumPy数组接口和批量计算内核
+    BufferBridge::bind(m);
+    BatchKernels::bind(m);
+
+    // 图像直接写入结果页的帧缓冲区
+    FrameChannel::bind(m);
+}
+
+/**
+ * @brief sys.stdout/sys.stderr的原生实现
+ *
+ * 解释器初始化时创建一次，标准输出和标准错误各一个对象，写入时带着各自的流编号，
+ * 输出窗口据此区分显示。write()把UTF-8数据直接交给PythonInterpreterManager的当前回调，
+ * 文本取自字符串对象内部缓存的UTF-8表示，不经过std::string或QString。
+ * 每个子解释器各自导入一份模块并安装自己的输出对象。
+ */
+struct OutputSink
+{
+    int        stream;   // 0为标准输出，1为标准错误
+    py::object buffer;   // 同一流的BinarySink
+};
+
+/**
+ * @brief sys.stdout.buffer/sys.stderr.buffer的原生实现
+ *
+ * 接受任何支持缓冲区协议的连续字节对象（bytes、bytearray、memoryview），
+ * 直接从对象的内存交给输出回调，不做解码；UTF-8只在界面取出输出时解码，非法字节显示为替换字符。
+ */
+struct BinarySink
+{
+    int stream;
+};
+
+// 把一个连续字节对象写入输出，返回字节数
+static Py_ssize_t writeBytes(int stream, py::handle data)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(data.ptr(), &view, PyBUF_SIMPLE) != 0) {
+        throw py::error_already_set();
+    }
+
+    // 输出回调按int长度写入，超长的数据分段交出
+    const char* bytes     = static_cast<const char*>(view.buf);
+    Py_ssize_t  remaining = view.len;
+    while (remaining > 0) {
+        const int size = static_cast<int>(qMin<Py_ssize_t>(remaining, 1 << 30));
+        PythonInterpreterManager::instance().writeOutput(stream, bytes, size);
+        bytes += size;
+        remaining -= size;
+    }
+
+    const Py_ssize_t length = view.len;
+    PyBuffer_Release(&view);
+    return length;
+}
+
+/**
+ * @brief sys.stdin的原生实现
+ *
+ * 从当前线程的输入队列读取（见PythonInterpreterManager::currentInput()），没有队列时立即得到EOF。
+ * 已到达的数据直接取走；需要等待时释放GIL，中止运行时抛出KeyboardInterrupt。
+ * 没有fileno()，input()因此不走终端路径，而是写出提示后调用readline()。
+ * size按UTF-8字节计，不会拆开多字节字符。
+ */
+struct InputSource
+{
+};
+
+// 读取一行（line为true）或指定字节数，返回解码后的文本
+static py::str readInput(qint64 size, bool line)
+{
+    InputQueue* queue = PythonInterpreterManager::instance().currentInput();
+    QByteArray  data;
+
+    InputQueue::Status status = queue ? queue->read(&data, size, line, false) : InputQueue::Ready;
+    if (status == InputQueue::Empty) {
+        py::gil_scoped_release release;
+        status = queue->read(&data, size, line, true);
+    }
+    if (status == InputQueue::Interrupted) {
+        PyErr_SetString(PyExc_KeyboardInterrupt, "Execution aborted");
+        throw py::error_already_set();
+    }
+
+    PyObject* text = PyUnicode_DecodeUTF8(data.constData(), data.size(), "replace");
+    if (!text) {
+        throw py::error_already_set();
+    }
+    return py::reinterpret_steal<py::str>(text);
+}
+
+PYBIND11_EMBEDDED_MODULE(embed_io, m, py::multiple_interpreters::per_interpreter_gil())
+{
+    py::class_<InputSource>(m, "InputSource")
+        .def(py::init<>())
+        .def("readline", [](const InputSource&, qint64 size) { return readInput(size, true); }, py::arg("size") = -1)
+        .def("read", [](const InputSource&, qint64 size) { return readInput(size, false); }, py::arg("size") = -1)
+        .def("readlines",
+             [](const InputSource&, qint64 hint) {
+                 py::list lines;
+                 qint64   total = 0;
+                 for (;;) {
+                     py::str line = readInput(-1, true);
+                     if (PyUnicode_GET_LENGTH(line.ptr()) == 0) {
+                         break;
+                     }
+                     total += PyUnicode_GET_LENGTH(line.ptr());
+                     lines.append(line);
+                     if (hint > 0 && total >= hint) {
+                         break;
+                     }
+                 }
+                 return lines;
+             },
+             py::arg("hint") = -1)
+        .def("__iter__", [](py::object self) { return self; })
+        .def("__next__",
+             [](const InputSource&) {
+                 py::str line = readInput(-1, true);
+                 if (PyUnicode_GET_LENGTH(line.ptr()) == 0) {
+                     throw py::stop_iteration();
+                 }
+                 return line;
+             })
+        .def("close", [](const InputSource&) {})
+        .def("isatty", [](const InputSource&) { return false; })
+        .def("writable", [](const InputSource&) { return false; })
+        .def("readable", [](const InputSource&) { return true; })
+        .def("seekable", [](const InputSource&) { return false; })
+        .def_property_readonly("name", [](const InputSource&) { return "<stdin>"; })
+        .def_property_readonly("mode", [](const InputSource&) { return "r"; })
+        .def_property_readonly("encoding", [](const InputSource&) { return "utf-8"; })
+        .def_property_readonly("errors", [](const InputSource&) { return "replace"; })
+        .def_property_readonly("closed", [](const InputSource&) { return false; });
+
+    py::class_<BinarySink>(m, "BinarySink")
+        .def(py::init<int>(), py::arg("stream"))
+        .def("write", [](const BinarySink& sink, py::handle data) { return writeBytes(sink.stream, data); })
+        .def("writelines",
+             [](const BinarySink& sink, py::iterable lines) {
+                 for (py::handle line : lines) {
+                     writeBytes(sink.stream, line);
+                 }
+             })
+        .def("flush", [](const BinarySink&) {})
+        .def("isatty", [](const BinarySink&) { return false; })
+        .def("writable", [](const BinarySink&) { return true; })
+        .def("readable", [](const BinarySink&) { return false; })
+        .def("seekable", [](const BinarySink&) { return false; })
+        .def_property_readonly("mode", [](const BinarySink&) { return "wb"; })
+        .def_property_readonly("closed", [](const BinarySink&) { return false; });
+
+    py::class_<OutputSink>(m, "OutputSink")
+        .def(py::init([](int stream) {
+                 OutputSink sink;
+                 sink.stream = stream;
+                 sink.buffer = py::cast(BinarySink{stream});
+                 return sink;
+             }),
+             py::arg("stream"))
+        .def("write",
+             [](const OutputSink& sink, py::handle text) {
+                 if (!PyUnicode_Check(text.ptr())) {
+                     throw py::type_error(std::string("write() argument must be str, not ") +
+                                          Py_TYPE(text.ptr())->tp_name);
+                 }
+                 Py_ssize_t  size = 0;
+                 const char* data = PyUnicode_AsUTF8AndSize(text.ptr(), &size);
+                 if (!data) {
+                     throw py::error_already_set();
+                 }
+                 if (size > 0) {
+                     PythonInterpreterManager::instance().writeOutput(
+                         sink.stream, data, static_cast<int>(size));
+                 }
+                 return PyUnicode_GET_LENGTH(text.ptr());
+             })
+        .def("flush", [](const OutputSink&) {})
+        .def("isatty", [](const OutputSink&) { return false; })
+        .def("writable", [](const OutputSink&) { return true; })
+        .def("readable", [](const OutputSink&) { return false; })
+        .def("seekable", [](const OutputSink&) { return false; })
+        .def_readonly("buffer", &OutputSink::buffer)
+        .def_property_readonly("mode", [](const OutputSink&) { return "w"; })
+        .def_property_readonly("encoding", [](const OutputSink&) { return "utf-8"; })
+        .def_property_readonly("errors", [](const OutputSink&) { return "strict"; })
+        .def_property_readonly("closed", [](const OutputSink&) { return false; });
+
+    // 可中断的time.sleep：等待期间释放GIL，中止运行时立即返回并抛出KeyboardInterrupt。
+    // 时长按纳秒向上取整，不足一毫秒的等待也不会提前返回；非数、负数和超出范围的时长与time.sleep一样抛出异常
+    m.def(
+        "sleep",
+        [](double seconds) {
+            if (std::isnan(seconds)) {
+                throw py::value_error("Invalid value NaN (not a number)");
+            }
+            if (seconds < 0) {
+                throw py::value_error("sleep length must be non-negative");
+            }
+            const double nanoseconds = std::ceil(seconds * 1e9);
+            if (nanoseconds >= static_cast<double>(std::numeric_limits<qint64>::max())) {
+                PyErr_SetString(PyExc_OverflowError, "sleep length is too large");
+                throw py::error_already_set();
+            }
+            const QDeadlineTimer deadline(std::chrono::nanoseconds(static_cast<qint64>(nanoseconds)),
+                                          Qt::PreciseTimer);
+
+            bool interrupted = false;
+            {
+                py::gil_scoped_release release;
+                interrupted = PythonInterpreterManager::waitInterruptible(deadline);
+            }
+
+            if (interrupted) {
+                PyErr_SetString(PyExc_KeyboardInterrupt, "Execution aborted");
+                throw py::error_already_set();
+            }
+        },
+        py::arg("seconds"));
 }
 
 PythonInterpreterManager& PythonInterpreterManager::instance()
@@ -48,59 +347,274 @@ PythonInterpreterManager::PythonInterpreterManager(QObject* parent)
 
 PythonInterpreterManager::~PythonInterpreterManager()
 {
-    if (m_initialized) {
+    if (m_initialized || m_ownerThread) {
         cleanup();
     }
 }
 
-bool PythonInterpreterManager::initialize(const QString& configFile)
+bool PythonInterpreterManager::initialize()
 {
     if (m_initialized) {
         qWarning() << "Python interpreter is already initialized";
         return true;
     }
 
+    m_initializing = true;
+    m_startupPhases.clear();
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
     try {
         // 设置程序名称
         Py_SetProgramName(L"QtPythonEmbedTest2");
 
         // 加载配置
-        m_configFile = configFile;
-        loadConfiguration(configFile);
+        runStartupPhase("读取配置", 1, [&]() { loadConfiguration(); });
 
         // 设置环境
-        setupEnvironment();
+        runStartupPhase("设置环境", 2, [&]() { setupEnvironment(); });
+
+        // 初始化Python解释器（包括导入site和扫描site-packages，大型环境中最耗时）
+        runStartupPhase("启动解释器", 3, [&]() {
+            py::initialize_interpreter();
+
+            // 以运行时版本为准，调试后端等功能据此选择；同时创建主解释器的常用对象句柄
+            const PythonHandles& handles    = PythonHandles::current();
+            PyObject*            hexVersion = handles.sysAttribute(handles.names.hexVersion);
+            m_pythonVersionHex = hexVersion ? static_cast<quint32>(PyLong_AsUnsignedLong(hexVersion)) : 0;
 
-        // 初始化Python解释器
-        py::initialize_interpreter();
+            // 配置的额外路径
+            setupPythonPaths();
+        });
+
+        // 安装原生输出对象，之后每次运行只需切换回调目标
+        runStartupPhase("安装输出和中断", 4, [&]() { prepareInterpreter(); });
+        runStartupPhase("构建命名空间模板", 5, [&]() { setupNamespaceTemplate(); });
+        refreshInterpreterInfo(true);
 
         // 保存主线程状态
         m_mainThreadState = PyEval_SaveThread();
 
-        m_initialized = true;
+        ++m_generation;
+        m_initialized  = true;
+        m_initializing = false;
         emit initialized();
 
-        qDebug() << "Python interpreter initialized successfully";
+        qDebug() << "Python interpreter initialized successfully in" << totalTimer.elapsed() << "ms";
         qDebug() << "Python version:" << getPythonVersion();
 
         return true;
     }
     catch (const std::exception& e) {
         qCritical() << "Failed to initialize Python interpreter:" << e.what();
+        m_initializing = false;
+        emit initializationFailed(QString::fromUtf8(e.what()));
         return false;
     }
     catch (...) {
         qCritical() << "Failed to initialize Python interpreter: Unknown error";
+        m_initializing = false;
+        emit initializationFailed("未知错误");
         return false;
     }
 }
 
+void PythonInterpreterManager::initializeAsync()
+{
+    if (m_initialized || m_ownerThread) {
+        qWarning() << "Python interpreter is already initialized or initializing";
+        return;
+    }
+
+    // 在线程启动前置位，调用方随后立即查询也能看到初始化进行中
+    m_initializing  = true;
+    m_ownerShutdown = false;
+    m_ownerRestart  = false;
+    m_ownerThread   = QThread::create([this]() { ownerThreadMain(); });
+    m_ownerThread->start();
+}
+
+void PythonInterpreterManager::ownerThreadMain()
+{
+    for (;;) {
+        initialize();
+
+        // 调用Py_Initialize的线程是Python的主线程，保持存活直到cleanup()；重新初始化也在这个线程中进行
+        bool restart = false;
+        {
+            std::unique_lock<std::mutex> lock(m_ownerMutex);
+            m_ownerWake.wait(lock, [this]() { return m_ownerShutdown || m_ownerRestart; });
+            restart        = !m_ownerShutdown;
+            m_ownerRestart = false;
+        }
+        if (!restart) {
+            break;
+        }
+
+        emit aboutToRestart();
+        cleanup();
+    }
+
+    cleanup();
+}
+
+void PythonInterpreterManager::restartAsync()
+{
+    m_initializing = true;
+
+    // 同步初始化的解释器属于调用线程，在这里销毁后改为后台初始化
+    if (!m_ownerThread) {
+        emit aboutToRestart();
+        cleanup();
+        initializeAsync();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_ownerMutex);
+        m_ownerRestart = true;
+    }
+    m_ownerWake.notify_all();
+}
+
+void PythonInterpreterManager::warmUp(const QStringList& modules)
+{
+    if (!m_initialized || modules.isEmpty()) {
+        return;
+    }
+    if (m_warmUpThread) {
+        if (m_warmUpThread->isRunning()) {
+            return;
+        }
+        delete m_warmUpThread;
+    }
+
+    // 低优先级运行，不与界面和运行线程争抢CPU
+    m_warmUpStopping = false;
+    m_warmUpThread   = QThread::create([this, modules]() { warmUpMain(modules); });
+    m_warmUpThread->start(QThread::LowPriority);
+}
+
+void PythonInterpreterManager::warmUpMain(const QStringList& modules)
+{
+    QVector<WarmUpModule> results;
+    for (const QString& name : modules) {
+        if (m_warmUpStopping) {
+            break;
+        }
+
+        WarmUpModule module;
+        module.name = name;
+        QElapsedTimer timer;
+        timer.start();
+        {
+            // 每个模块单独获取GIL，模块之间运行线程可以取得GIL
+            py::gil_scoped_acquire acquire;
+            try {
+                const QByteArray moduleName = name.toUtf8();
+                if (PyDict_GetItemString(PyImport_GetModuleDict(), moduleName.constData())) {
+                    continue;
+                }
+                py::module_::import(moduleName.constData());
+                module.imported = true;
+            }
+            catch (py::error_already_set& e) {
+                module.error = QString::fromUtf8(e.what());
+            }
+        }
+        module.elapsedNs = timer.nsecsElapsed();
+        results.append(module);
+        QThread::yieldCurrentThread();
+    }
+
+    // 预导入改变了已加载的模块
+    if (!m_warmUpStopping) {
+        py::gil_scoped_acquire acquire;
+        refreshInterpreterInfo(true);
+    }
+
+    m_warmUpModules = results;
+    emit warmUpFinished();
+}
+
+void PythonInterpreterManager::stopWarmUp()
+{
+    if (!m_warmUpThread) {
+        return;
+    }
+    m_warmUpStopping = true;
+    m_warmUpThread->wait();
+    delete m_warmUpThread;
+    m_warmUpThread = nullptr;
+}
+
+QByteArray PythonInterpreterManager::encodeWarmUp(const QVector<WarmUpModule>& modules)
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << static_cast<qint32>(modules.size());
+    for (const WarmUpModule& module : modules) {
+        stream << module.name << module.elapsedNs << static_cast<quint8>(module.imported) << module.error;
+    }
+    return payload;
+}
+
+bool PythonInterpreterManager::decodeWarmUp(const QByteArray& payload, QVector<WarmUpModule>* modules)
+{
+    QDataStream stream(payload);
+    qint32      count = 0;
+    stream >> count;
+
+    modules->clear();
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        WarmUpModule module;
+        quint8       imported = 0;
+        stream >> module.name >> module.elapsedNs >> imported >> module.error;
+        module.imported = imported != 0;
+        modules->append(module);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+void PythonInterpreterManager::runStartupPhase(const QString&               name,
+                                               int                          step,
+                                               const std::function<void()>& body)
+{
+    emit startupProgress(name, step, kStartupPhaseCount);
+
+    QElapsedTimer timer;
+    timer.start();
+    body();
+
+    StartupPhase phase;
+    phase.name      = name;
+    phase.elapsedNs = timer.nsecsElapsed();
+    m_startupPhases.append(phase);
+}
+
 void PythonInterpreterManager::cleanup()
 {
+    // 解释器属于后台线程时，通知该线程销毁解释器并等待它结束
+    if (m_ownerThread && QThread::currentThread() != m_ownerThread) {
+        {
+            std::lock_guard<std::mutex> lock(m_ownerMutex);
+            m_ownerShutdown = true;
+        }
+        m_ownerWake.notify_all();
+        m_ownerThread->wait();
+        delete m_ownerThread;
+        m_ownerThread = nullptr;
+        return;
+    }
+
     if (!m_initialized) {
         return;
     }
 
+    // 预导入线程需要GIL，在恢复主线程状态之前结束
+    stopWarmUp();
+
     try {
         // 恢复线程状态
         if (m_mainThreadState) {
@@ -108,6 +622,19 @@ void PythonInterpreterManager::cleanup()
             m_mainThreadState = nullptr;
         }
 
+        // 缓存中的代码对象和命名空间必须在解释器销毁前释放
+        m_codeCache.clear();
+        BufferRegistry::instance().clear();
+
+        // 等待池中的任务结束，它们结束时需要获取GIL
+        {
+            py::gil_scoped_release release;
+            NativeThreadPool::instance().shutdown();
+        }
+        m_namespaceTemplate = py::object();
+        m_sessionModule     = py::object();
+        m_contextModules.clear();
+
         // 清理嵌入式模块
         // Py_Finalize() 会自动清理模块
 
@@ -115,6 +642,8 @@ void PythonInterpreterManager::cleanup()
         py::finalize_interpreter();
 
         m_initialized = false;
+        m_pythonVersionHex = 0;
+        std::atomic_store(&m_info, std::shared_ptr<const InterpreterInfo>());
         emit cleaned();
 
         qDebug() << "Python interpreter cleaned up successfully";
@@ -133,26 +662,80 @@ QString PythonInterpreterManager::getPythonVersion() const
         return QString("Not initialized");
     }
 
-    try {
-        py::gil_scoped_acquire acquire;
-        PyObject*              version = PySys_GetObject("version");
-        if (version && PyUnicode_Check(version)) {
-            return QString::fromUtf8(PyUnicode_AsUTF8(version));
+    std::shared_ptr<const InterpreterInfo> info = interpreterInfo();
+    return info ? info->version : QString("Unknown");
+}
+
+std::shared_ptr<const PythonInterpreterManager::InterpreterInfo> PythonInterpreterManager::interpreterInfo() const
+{
+    return std::atomic_load(&m_info);
+}
+
+void PythonInterpreterManager::refreshInterpreterInfo(bool force)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!force) {
+        std::shared_ptr<const InterpreterInfo> previous = interpreterInfo();
+        if (previous && now - previous->refreshedMs < kInfoRefreshIntervalMs) {
+            return;
         }
     }
-    catch (...) {
-        // 忽略异常
+
+    // 运行结束时可能仍有未处理的异常，先保存；只读取sys的属性，不执行用户代码
+    PyObject *errType, *errValue, *errTraceback;
+    PyErr_Fetch(&errType, &errValue, &errTraceback);
+
+    std::shared_ptr<InterpreterInfo> info = std::make_shared<InterpreterInfo>();
+    info->versionHex                      = m_pythonVersionHex;
+    info->refreshedMs                     = now;
+    info->rssBytes                        = MemoryProfiler::currentRssBytes();
+
+    const PythonHandles& handles = PythonHandles::current();
+    PyObject*            version = handles.sysAttribute(handles.names.version);
+    if (version && PyUnicode_Check(version)) {
+        info->version = QString::fromUtf8(PyUnicode_AsUTF8(version));
     }
 
-    return QString("Unknown");
+    PyObject* sysPath = handles.sysAttribute(handles.names.path);
+    if (sysPath && PyList_Check(sysPath)) {
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(sysPath); ++i) {
+            PyObject* item = PyList_GET_ITEM(sysPath, i);
+            if (PyUnicode_Check(item)) {
+                info->paths.append(QString::fromUtf8(PyUnicode_AsUTF8(item)));
+            }
+        }
+    }
+
+    PyObject* modules = handles.sysAttribute(handles.names.modules);
+    if (modules && PyDict_Check(modules)) {
+        info->modules.reserve(static_cast<int>(PyDict_GET_SIZE(modules)));
+        PyObject*  key      = nullptr;
+        PyObject*  value    = nullptr;
+        Py_ssize_t position = 0;
+        while (PyDict_Next(modules, &position, &key, &value)) {
+            if (PyUnicode_Check(key)) {
+                info->modules.append(QString::fromUtf8(PyUnicode_AsUTF8(key)));
+            }
+        }
+        info->modules.sort();
+    }
+
+    if (PyObject* getAllocatedBlocks = PySys_GetObject("getallocatedblocks")) {
+        if (PyObject* blocks = PyObject_CallNoArgs(getAllocatedBlocks)) {
+            info->allocatedBlocks = PyLong_AsLongLong(blocks);
+            Py_DECREF(blocks);
+        }
+    }
+    PyErr_Clear();
+    PyErr_Restore(errType, errValue, errTraceback);
+
+    std::atomic_store(&m_info, std::shared_ptr<const InterpreterInfo>(std::move(info)));
 }
 
 void PythonInterpreterManager::setPythonHome(const QString& path)
 {
+    // 运行中的解释器不会再读取主目录，新设置由restartAsync()应用
     m_pythonHome = path;
-    if (m_initialized) {
-        Py_SetPythonHome(path.toStdWString().c_str());
-    }
 }
 
 void PythonInterpreterManager::addPythonPath(const QString& path)
@@ -164,65 +747,32 @@ void PythonInterpreterManager::addPythonPath(const QString& path)
 
 QStringList PythonInterpreterManager::getPythonPaths() const
 {
-    if (!m_initialized) {
-        return m_pythonPaths;
-    }
-
-    try {
-        py::gil_scoped_acquire acquire;
-        PyObject*              sysPath = PySys_GetObject("path");
-        if (sysPath && PyList_Check(sysPath)) {
-            QStringList paths;
-            for (Py_ssize_t i = 0; i < PyList_Size(sysPath); ++i) {
-                PyObject* item = PyList_GetItem(sysPath, i);
-                if (item && PyUnicode_Check(item)) {
-                    paths.append(QString::fromUtf8(PyUnicode_AsUTF8(item)));
-                }
-            }
-            return paths;
-        }
-    }
-    catch (...) {
-        // 忽略异常
-    }
-
-    return m_pythonPaths;
+    std::shared_ptr<const InterpreterInfo> info = m_initialized ? interpreterInfo() : nullptr;
+    return info ? info->paths : m_pythonPaths;
 }
 
 void PythonInterpreterManager::registerEmbeddedModule(const char* moduleName,
                                                       PyObject* (*initFunc)(void))
 {
-    if (!m_initialized) {
-        qWarning() << "Cannot register module" << moduleName << "- Python not initialized";
+    // inittab只能在解释器初始化前修改，已初始化时在下一次初始化时加入
+    if (!ModuleRegistry::instance().registerFunction(QString::fromUtf8(moduleName), initFunc)) {
+        qWarning() << "Cannot register module" << moduleName << "- name already registered";
         return;
     }
-
-    try {
-        py::gil_scoped_acquire acquire;
-        PyImport_AppendInittab(moduleName, initFunc);
-    }
-    catch (const std::exception& e) {
-        qCritical() << "Failed to register module" << moduleName << ":" << e.what();
+    if (m_initialized) {
+        qWarning() << "Module" << moduleName << "will be available after the interpreter restarts";
     }
 }
 
 void PythonInterpreterManager::registerEmbeddedModule(const char*  moduleName,
                                                       PyModuleDef* moduleDef)
 {
-    Q_UNUSED(moduleDef);
-
-    if (!m_initialized) {
-        qWarning() << "Cannot register module" << moduleName << "- Python not initialized";
+    if (!ModuleRegistry::instance().registerDefinition(QString::fromUtf8(moduleName), moduleDef)) {
+        qWarning() << "Cannot register module" << moduleName << "- name already registered";
         return;
     }
-
-    try {
-        py::gil_scoped_acquire acquire;
-        // 嵌入式模块已经通过PYBIND11_EMBEDDED_MODULE自动注册，不需要手动添加到init tab
-        // 或者可以使用PyModule_Create来创建模块，但需要正确的初始化函数
-    }
-    catch (const std::exception& e) {
-        qCritical() << "Failed to register module" << moduleName << ":" << e.what();
+    if (m_initialized) {
+        qWarning() << "Module" << moduleName << "will be available after the interpreter restarts";
     }
 }
 
@@ -236,24 +786,41 @@ py::object PythonInterpreterManager::executeCode(const QString& code, py::object
     try {
         py::gil_scoped_acquire acquire;
 
-        if (globalDict && localDict) {
-            py::exec(code.toStdString().c_str(), *globalDict, *localDict);
-        }
-        else if (globalDict) {
-            py::exec(code.toStdString().c_str(), *globalDict);
-        }
-        else if (localDict) {
-            py::exec(code.toStdString().c_str(), py::globals(), *localDict);
+        py::object globals = globalDict ? *globalDict : py::object(runNamespace());
+        py::object locals  = localDict ? *localDict : globals;
+
+        const PythonHandles& handles = PythonHandles::current();
+        if (PyDict_Check(globals.ptr()) && !PyDict_GetItem(globals.ptr(), handles.names.builtins) &&
+            PyDict_SetItem(globals.ptr(), handles.names.builtins, handles.builtins) < 0) {
+            throw py::error_already_set();
         }
-        else {
-            py::exec(code.toStdString().c_str());
+
+        // 使用固定文件名编译，追踪函数据此识别编辑器中的代码；
+        // 内容未变时直接复用缓存中的代码对象
+        // 编译失败（语法错误）时耗时记为0，不保留上一次运行的值
+        QElapsedTimer compileTimer;
+        compileTimer.start();
+        m_lastCompileNs.store(0, std::memory_order_relaxed);
+        py::object compiled =
+            m_codeCache.compile(code.toUtf8(), editorFileName(), PyCF_ALLOW_TOP_LEVEL_AWAIT);
+        m_lastCompileNs.store(compileTimer.nsecsElapsed(), std::memory_order_relaxed);
+
+        py::object result = py::reinterpret_steal<py::object>(
+            PyEval_EvalCode(compiled.ptr(), globals.ptr(), locals.ptr()));
+        if (!result) {
+            throw py::error_already_set();
         }
 
-        return py::none();
+        // 顶层await的代码对象执行后得到协程，尚未运行其中的语句
+        return PyCoro_CheckExact(result.ptr()) ? result : py::none();
     }
     catch (const py::error_already_set& e) {
         QString errorMsg = QString("Python execution error: %1").arg(QString::fromUtf8(e.what()));
-        emit    pythonError(errorMsg);
+
+        // 用户中止不是代码错误，由运行器在运行汇总中报告
+        if (!e.matches(PyExc_KeyboardInterrupt)) {
+            emit pythonError(errorMsg);
+        }
         throw std::runtime_error(errorMsg.toStdString());
     }
     catch (const std::exception& e) {
@@ -263,51 +830,178 @@ py::object PythonInterpreterManager::executeCode(const QString& code, py::object
     }
 }
 
-void PythonInterpreterManager::redirectPythonOutput(
-    const std::function<void(const QString&)>& callback)
+void PythonInterpreterManager::setPersistentNamespace(bool persistent)
+{
+    if (m_persistentNamespace.exchange(persistent) && !persistent) {
+        m_sessionResetPending = true;
+    }
+}
+
+py::dict PythonInterpreterManager::runNamespace(const QString& context)
+{
+    PyObject* modules = PyImport_GetModuleDict();
+
+    // 关闭会话模式时不能在调用线程释放会话（需要GIL），推迟到这里
+    if (m_sessionResetPending.exchange(false) || !m_sessionModule) {
+        m_sessionModule = createMainModule();
+        m_contextModules.clear();
+    }
+
+    py::object module;
+    if (!m_persistentNamespace) {
+        module = createMainModule();
+    }
+    else if (context.isEmpty()) {
+        module = m_sessionModule;
+    }
+    else {
+        py::object& session = m_contextModules[context];
+        if (!session) {
+            session = createMainModule();
+        }
+        module = session;
+    }
+    if (PyDict_SetItem(modules, PythonHandles::current().names.main, module.ptr()) < 0) {
+        throw py::error_already_set();
+    }
+
+    // 上次退出时保存的会话变量在第一次使用会话命名空间时恢复
+    if (module.is(m_sessionModule)) {
+        const std::shared_ptr<SessionCheckpoint> checkpoint =
+            std::atomic_exchange(&m_pendingSession, std::shared_ptr<SessionCheckpoint>());
+        if (checkpoint) {
+            const SessionCheckpoint::Summary summary = checkpoint->restore(PyModule_GetDict(module.ptr()));
+            emit sessionRestored(summary.count, summary.skipped, summary.elapsedNs);
+        }
+    }
+
+    return py::reinterpret_borrow<py::dict>(PyModule_GetDict(module.ptr()));
+}
+
+void PythonInterpreterManager::releaseNamespace(const QString& context)
+{
+    m_contextModules.remove(context);
+}
+
+SessionCheckpoint::Summary PythonInterpreterManager::saveSession(const QString& path)
+{
+    if (const std::shared_ptr<SessionCheckpoint> pending = std::atomic_load(&m_pendingSession)) {
+        SessionCheckpoint::Summary summary;
+        summary.count = pending->count();
+        return summary;
+    }
+    if (!m_sessionModule) {
+        SessionCheckpoint::Summary summary;
+        summary.error = "会话命名空间不存在";
+        return summary;
+    }
+
+    // 后台保存期间模块本身不会被释放
+    const py::object module = m_sessionModule;
+    return SessionCheckpoint::save(PyModule_GetDict(module.ptr()), path);
+}
+
+int PythonInterpreterManager::loadSession(const QString& path, QString* error)
+{
+    const std::shared_ptr<SessionCheckpoint> checkpoint = SessionCheckpoint::open(path, error);
+    if (!checkpoint) {
+        return -1;
+    }
+    std::atomic_store(&m_pendingSession, checkpoint);
+    return checkpoint->count();
+}
+
+py::object PythonInterpreterManager::createMainModule() const
+{
+    const PythonHandles& handles = PythonHandles::current();
+    py::object           module  = py::reinterpret_steal<py::object>(PyModule_NewObject(handles.names.main));
+    if (!module) {
+        throw py::error_already_set();
+    }
+
+    // 浅复制模板，代价与模板条目数成正比，与上一次运行留下的状态无关
+    if (m_namespaceTemplate &&
+        PyDict_Update(PyModule_GetDict(module.ptr()), m_namespaceTemplate.ptr()) < 0) {
+        throw py::error_already_set();
+    }
+
+    return module;
+}
+
+void PythonInterpreterManager::setupNamespaceTemplate()
+{
+    try {
+        const PythonHandles& handles = PythonHandles::current();
+        py::dict             initial;
+        if (PyDict_SetItem(initial.ptr(), handles.names.builtins, handles.builtins) < 0) {
+            throw py::error_already_set();
+        }
+        m_namespaceTemplate = initial;
+
+        // 初始的__main__作为会话命名空间，会话模式下的行为与之前一致
+        m_sessionModule = py::reinterpret_steal<py::object>(PyImport_GetModule(handles.names.main));
+    }
+    catch (const std::exception& e) {
+        qCritical() << "Failed to set up run namespace template:" << e.what();
+    }
+}
+
+void PythonInterpreterManager::redirectPythonOutput(const OutputCallback& callback)
 {
+    // 输出对象在初始化时已安装，这里只切换回调目标
     m_outputCallback = callback;
+}
 
-    if (!m_initialized) {
-        qWarning() << "Cannot redirect output - Python not initialized";
+void PythonInterpreterManager::prepareInterpreter()
+{
+    installOutputSinks();
+    installInputSource();
+    installInterruptibleSleep();
+}
+
+void PythonInterpreterManager::bindCurrentThread(const OutputCallback* output, InterruptGate* gate, InputQueue* input)
+{
+    t_threadOutput = output;
+    t_threadGate   = gate;
+    t_threadInput  = input;
+}
+
+void PythonInterpreterManager::redirectPythonInput(InputQueue* input)
+{
+    m_input = input;
+}
+
+InputQueue* PythonInterpreterManager::currentInput() const
+{
+    return t_threadGate ? t_threadInput : m_input;
+}
+
+void PythonInterpreterManager::writeOutput(int stream, const char* data, int size)
+{
+    if (t_threadOutput && *t_threadOutput) {
+        (*t_threadOutput)(stream, data, size);
         return;
     }
 
-    try {
-        py::gil_scoped_acquire acquire;
+    if (m_outputCallback) {
+        m_outputCallback(stream, data, size);
+        return;
+    }
 
-        // 导入sys模块
-        py::module_ sys = py::module_::import("sys");
-
-        // 创建一个简单的重定向类
-        py::exec(R"(
-class OutputRedirector:
-    def __init__(self, callback):
-        self.callback = callback
-    
-    def write(self, text):
-        self.callback(text)
-    
-    def flush(self):
-        pass
-)");
-
-        // 获取OutputRedirector类
-        py::object redirectorClass = py::module_::import("__main__").attr("OutputRedirector");
-
-        // 创建一个可调用对象，包装我们的C++回调
-        py::object pyCallback = py::cpp_function([this](const std::string& text) {
-            if (m_outputCallback) {
-                m_outputCallback(QString::fromStdString(text));
-            }
-        });
+    // 没有运行器接管输出时写到进程的标准输出/标准错误
+    FILE* file = stream == 1 ? stderr : stdout;
+    fwrite(data, 1, static_cast<size_t>(size), file);
+}
 
-        // 创建一个OutputRedirector实例
-        py::object redirector = redirectorClass(pyCallback);
+void PythonInterpreterManager::installOutputSinks()
+{
+    try {
+        const PythonHandles& handles = PythonHandles::current();
+        py::object           sys     = py::reinterpret_borrow<py::object>(handles.sys);
+        py::module_          io      = py::module_::import("embed_io");
 
-        // 设置sys.stdout和sys.stderr
-        sys.attr("stdout") = redirector;
-        sys.attr("stderr") = redirector;
+        sys.attr(handles.names.standardOut) = io.attr("OutputSink")(0);
+        sys.attr(handles.names.standardErr) = io.attr("OutputSink")(1);
 
         qDebug() << "Python output redirection configured successfully";
     }
@@ -316,20 +1010,53 @@ class OutputRedirector:
     }
 }
 
-void PythonInterpreterManager::loadConfiguration(const QString& configFile)
+void PythonInterpreterManager::installInputSource()
 {
-    QString configPath = configFile;
-    if (configPath.isEmpty()) {
-        // 使用默认配置文件位置
-        QString appDataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-        configPath         = QDir(appDataDir).filePath("python_config.ini");
+    try {
+        const PythonHandles& handles = PythonHandles::current();
+        py::handle(handles.sys).attr(handles.names.standardIn) = py::module_::import("embed_io").attr("InputSource")();
+    }
+    catch (const std::exception& e) {
+        qCritical() << "Failed to install Python input source:" << e.what();
     }
+}
 
-    QSettings settings(configPath, QSettings::IniFormat);
+void PythonInterpreterManager::installInterruptibleSleep()
+{
+    try {
+        // 替换模块属性，之后的from time import sleep也会得到新实现
+        py::module_::import("time").attr("sleep") = py::module_::import("embed_io").attr("sleep");
+    }
+    catch (const std::exception& e) {
+        qCritical() << "Failed to install interruptible sleep:" << e.what();
+    }
+}
+
+void PythonInterpreterManager::bindCurrentThreadGate(std::shared_ptr<InterruptGate> gate)
+{
+    t_inheritedGate = std::move(gate);
+}
+
+bool PythonInterpreterManager::waitInterruptible(QDeadlineTimer deadline)
+{
+    if (InterruptGate* gate = t_threadGate ? t_threadGate : t_inheritedGate.get()) {
+        return gate->wait(deadline);
+    }
+
+    // 不属于任何运行的线程：只等待，不会被打断
+    InterruptGate gate;
+    return gate.wait(deadline);
+}
+
+void PythonInterpreterManager::loadConfiguration()
+{
+    // 配置文件已由ConfigManager在界面线程中读入内存，这里不再读文件
+    const ConfigManager& config = ConfigManager::instance();
 
     // 加载Python路径配置
-    m_pythonHome  = settings.value("Python/pythonHome", "").toString();
-    m_pythonPaths = settings.value("Python/pythonPaths", "").toStringList();
+    m_pythonHome  = config.getPythonHome();
+    m_pythonPaths = config.getPythonPaths();
+    m_pluginPaths = config.getPluginPaths();
 
     // 如果没有配置，尝试自动检测
     if (m_pythonHome.isEmpty()) {
@@ -340,6 +1067,13 @@ void PythonInterpreterManager::loadConfiguration(const QString& configFile)
         }
     }
 
+    // 编译代码缓存配置
+    m_codeCache.setMaxMemoryEntries(config.getCodeCacheMemoryEntries());
+    m_codeCache.setMaxDiskEntries(config.getCodeCacheDiskEntries());
+    if (!config.getCodeCacheDirectory().isEmpty()) {
+        m_codeCache.setDiskDirectory(config.getCodeCacheDirectory());
+    }
+
     qDebug() << "Loaded Python configuration:";
     qDebug() << "  Python Home:" << m_pythonHome;
     qDebug() << "  Python Paths:" << m_pythonPaths;
@@ -347,10 +1081,12 @@ void PythonInterpreterManager::loadConfiguration(const QString& configFile)
 
 void PythonInterpreterManager::setupEnvironment()
 {
-    // 设置Python Home
+    // 设置Python Home，字符串保存在成员中；重新初始化时为空表示清除上一次的设置
+    m_pythonHomeW = m_pythonHome.toStdWString();
+    if (!m_pythonHome.isEmpty() || m_generation > 0) {
+        Py_SetPythonHome(m_pythonHomeW.c_str());
+    }
     if (!m_pythonHome.isEmpty()) {
-        Py_SetPythonHome(m_pythonHome.toStdWString().c_str());
-
         // 更新PATH环境变量
         QByteArray path = qgetenv("PATH");
         if (!path.contains(m_pythonHome.toUtf8())) {
@@ -361,18 +1097,27 @@ void PythonInterpreterManager::setupEnvironment()
             qputenv("PATH", path);
         }
     }
+
+    // 扩展模块插件只列出目录，第一次导入时才加载；inittab只能在此时（解释器启动前）修改
+    ModuleRegistry& registry = ModuleRegistry::instance();
+    registry.discover(QStringList{ModuleRegistry::defaultPluginDirectory()} + m_pluginPaths);
+    registry.appendInittab();
 }
 
 void PythonInterpreterManager::setupPythonPaths()
 {
-    if (!m_initialized || m_pythonPaths.isEmpty()) {
+    // 在初始化过程中调用，此时解释器已启动但尚未标记为已初始化
+    if (!Py_IsInitialized() || m_pythonPaths.isEmpty()) {
         return;
     }
 
     try {
         py::gil_scoped_acquire acquire;
-        py::module_            sys  = py::module_::import("sys");
-        py::object             path = sys.attr("path");
+        const PythonHandles&   handles = PythonHandles::current();
+        py::object             path    = py::reinterpret_borrow<py::object>(handles.sysAttribute(handles.names.path));
+        if (!path) {
+            return;
+        }
 
         for (const QString& pythonPath : m_pythonPaths) {
             if (QDir(pythonPath).exists()) {
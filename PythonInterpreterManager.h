@@ -1,8 +1,21 @@
 #pragma once
 
+#include "CodeCache.h"
+#include "InterruptGate.h"
+#include "SessionCheckpoint.h"
+
+#include <QByteArray>
+#include <QHash>
 #include <QObject>
 #include <QString>
-#include <QSettings>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
 
 #define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
 
@@ -21,11 +34,59 @@ namespace py = pybind11;
  * - 嵌入式模块注册
  * - 全局Python设置管理
  */
+class InputQueue;
+class QThread;
+
 class PythonInterpreterManager : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * @brief 启动阶段耗时
+     */
+    struct StartupPhase
+    {
+        QString name;
+        qint64  elapsedNs = 0;
+    };
+
+    /**
+     * @brief 预导入一个模块的结果
+     */
+    struct WarmUpModule
+    {
+        QString name;
+        qint64  elapsedNs = 0;
+        bool    imported  = false;   // 导入失败（如未安装）时为false
+        QString error;
+    };
+
+    /**
+     * @brief 解释器信息快照
+     *
+     * 在持有GIL的安全点（初始化完成、预导入结束、每次运行结束）刷新，读取时不需要GIL，
+     * 运行中的代码长时间持有GIL时界面线程也不会等待。
+     */
+    struct InterpreterInfo
+    {
+        QString     version;                 // sys.version
+        quint32     versionHex      = 0;     // sys.hexversion
+        QStringList paths;                   // sys.path
+        QStringList modules;                 // sys.modules中的模块名，按名字排序
+        qint64      allocatedBlocks = 0;     // sys.getallocatedblocks()
+        qint64      rssBytes        = 0;     // 进程常驻内存
+        qint64      refreshedMs     = 0;     // 刷新时刻（自纪元起的毫秒数）
+    };
+
+    /**
+     * @brief 输出回调类型
+     *
+     * 参数依次为流类型（0为标准输出，1为标准错误）、UTF-8数据和字节数，
+     * 数据只在回调期间有效。
+     */
+    using OutputCallback = std::function<void(int, const char*, int)>;
+
     /**
      * @brief 获取单例实例
      * @return PythonInterpreterManager& 单例引用
@@ -34,16 +95,47 @@ public:
 
     /**
      * @brief 初始化Python解释器
-     * @param configFile 配置文件路径（可选）
+     *
+     * Python路径和代码缓存的设置取自ConfigManager（未初始化时使用默认值）。
      * @return bool 初始化是否成功
      */
-    bool initialize(const QString& configFile = QString());
+    bool initialize();
+
+    /**
+     * @brief 在后台线程中初始化Python解释器，立即返回
+     *
+     * 解释器归属于一个专用线程：该线程执行初始化，之后一直等待到cleanup()，
+     * 并在同一线程中销毁解释器。进度通过startupProgress()报告，
+     * 结束时发出initialized()或initializationFailed()。
+     */
+    void initializeAsync();
 
     /**
      * @brief 清理Python解释器资源
+     *
+     * 解释器由initializeAsync()启动时，在其所属线程中销毁并等待该线程结束。
      */
     void cleanup();
 
+    /**
+     * @brief 销毁解释器并按ConfigManager中的当前设置重新初始化，立即返回
+     *
+     * 重新读取Python主目录、路径和代码缓存设置，应用切换环境或从损坏的解释器状态恢复时使用。
+     * 由initializeAsync()启动时在同一个所属线程中完成：先发出aboutToRestart()，再销毁解释器，
+     * 之后与首次初始化一样报告进度并发出initialized()或initializationFailed()。
+     * 调用后isInitializing()立即为true，在此之前提交的运行应已结束。
+     * 不支持重复初始化的C扩展模块（如部分科学计算库）在新解释器中可能无法再次导入，这时应使用进程执行后端。
+     */
+    void restartAsync();
+
+    /**
+     * @brief 解释器代数，每次初始化成功加一
+     *
+     * 缓存Python对象的组件记下创建时的代数，代数变化说明对象属于已销毁的解释器，只能丢弃不能再减引用。
+     * @return quint64 代数，未初始化过时为0
+     */
+    quint64 generation() const { return m_generation; }
+
     /**
      * @brief 检查Python解释器是否已初始化
      * @return bool 是否已初始化
@@ -51,13 +143,79 @@ public:
     bool isInitialized() const { return m_initialized; }
 
     /**
-     * @brief 获取Python版本信息
+     * @brief 是否正在初始化
+     * @return bool 初始化进行中返回true
+     */
+    bool isInitializing() const { return m_initializing; }
+
+    /**
+     * @brief 获取最近一次初始化各阶段的耗时
+     * @return QVector<StartupPhase> 按执行顺序排列（在initialized()之后读取）
+     */
+    QVector<StartupPhase> startupPhases() const { return m_startupPhases; }
+
+    /**
+     * @brief 在低优先级的后台线程中依次导入模块，让之后的运行不再付出导入时间
+     *
+     * 每个模块导入期间持有GIL，模块之间释放，运行可以在两个模块之间开始（同一模块由导入锁串行化）。
+     * 已在sys.modules中的模块跳过。耗时单独报告（warmUpFinished()），不计入运行时间。
+     * 解释器未初始化、列表为空或上一次预导入还在进行时忽略。cleanup()会等待当前模块导入完成。
+     * @param modules 模块名
+     */
+    void warmUp(const QStringList& modules);
+
+    /**
+     * @brief 获取最近一次预导入的结果
+     * @return QVector<WarmUpModule> 按导入顺序排列（在warmUpFinished()之后读取）
+     */
+    QVector<WarmUpModule> warmUpModules() const { return m_warmUpModules; }
+
+    /**
+     * @brief 把预导入结果编码为负载（执行进程报告给主进程）
+     */
+    static QByteArray encodeWarmUp(const QVector<WarmUpModule>& modules);
+
+    /**
+     * @brief 解码预导入结果
+     * @return bool 负载完整返回true
+     */
+    static bool decodeWarmUp(const QByteArray& payload, QVector<WarmUpModule>* modules);
+
+    /**
+     * @brief 获取Python版本信息（取自信息快照，不需要GIL）
      * @return QString Python版本字符串
      */
     QString getPythonVersion() const;
 
     /**
-     * @brief 设置Python主目录
+     * @brief 获取最近一次刷新的解释器信息快照（线程安全，不需要GIL）
+     * @return std::shared_ptr<const InterpreterInfo> 快照，解释器未初始化时为空
+     */
+    std::shared_ptr<const InterpreterInfo> interpreterInfo() const;
+
+    /**
+     * @brief 刷新解释器信息快照（需持有GIL）
+     *
+     * 运行器在每次运行结束时调用；距上一次刷新不足100毫秒时跳过，
+     * 连续的短运行不会反复复制模块列表。
+     * @param force 不论间隔都刷新
+     */
+    void refreshInterpreterInfo(bool force = false);
+
+    /**
+     * @brief 获取运行时的Python版本号（sys.hexversion）
+     * @return quint32 版本号，例如3.12.1为0x030C01F0，未初始化时为0
+     */
+    quint32 pythonVersionHex() const { return m_pythonVersionHex; }
+
+    /**
+     * @brief 运行时是否提供sys.monitoring（PEP 669，Python 3.12及以上）
+     * @return bool 提供返回true
+     */
+    bool hasSysMonitoring() const { return m_pythonVersionHex >= 0x030C0000; }
+
+    /**
+     * @brief 设置Python主目录（下一次初始化时生效，初始化时以ConfigManager中的设置为准）
      * @param path Python安装路径
      */
     void setPythonHome(const QString& path);
@@ -69,41 +227,182 @@ public:
     void addPythonPath(const QString& path);
 
     /**
-     * @brief 获取当前Python路径列表
-     * @return QStringList Python路径列表
+     * @brief 获取当前Python路径列表（取自信息快照，不需要GIL）
+     * @return QStringList Python路径列表，未初始化时为配置的额外路径
      */
     QStringList getPythonPaths() const;
 
     /**
      * @brief 注册嵌入式C++模块
+     *
+     * 模块在解释器初始化前加入inittab（见ModuleRegistry），解释器已初始化时在下一次初始化（重启）后可用。
      * @param moduleName 模块名称
      * @param initFunc 初始化函数
      */
     void registerEmbeddedModule(const char* moduleName, PyObject* (*initFunc)(void));
-    
+
     /**
-     * @brief 注册嵌入式C++模块（重载版本，接受PyModuleDef*）
+     * @brief 注册嵌入式C++模块（重载版本，接受PyModuleDef*，多阶段初始化）
      * @param moduleName 模块名称
-     * @param moduleDef 模块定义
+     * @param moduleDef 模块定义，需在进程内一直有效
      */
     void registerEmbeddedModule(const char* moduleName, PyModuleDef* moduleDef);
 
+    /**
+     * @brief 编辑器代码编译时使用的文件名
+     *
+     * 追踪函数根据代码对象的co_filename区分用户代码和库代码。
+     * @return const char* 文件名
+     */
+    static const char* editorFileName() { return "<editor>"; }
+
+    /**
+     * @brief 获取编译代码缓存（访问时需持有GIL）
+     * @return CodeCache& 缓存引用
+     */
+    CodeCache& codeCache() { return m_codeCache; }
+
+    /**
+     * @brief 获取最近一次executeCode()编译代码的耗时（线程安全）
+     *
+     * 命中内存缓存时只有查表的时间，命中磁盘字节码时包含读取和反序列化。
+     * @return qint64 纳秒
+     */
+    qint64 lastCompileNs() const { return m_lastCompileNs.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 设置是否在多次运行之间保留同一个会话命名空间（可在任意线程调用）
+     *
+     * 关闭后会话中的变量在下一次运行开始时释放。
+     * @param persistent true表示保留会话，false表示每次运行使用全新的命名空间
+     */
+    void setPersistentNamespace(bool persistent);
+
+    /**
+     * @brief 是否保留会话命名空间
+     * @return bool 保留返回true
+     */
+    bool isPersistentNamespace() const { return m_persistentNamespace; }
+
+    /**
+     * @brief 获取本次运行使用的__main__命名空间（需持有GIL）
+     *
+     * 非会话模式下每次调用都新建一个__main__模块，字典从预先构建的模板复制，
+     * 并替换sys.modules["__main__"]，上一次运行的变量随旧模块一起释放；
+     * sys.modules中已导入的其他模块保持不变，再次import时直接命中。
+     * 每个运行上下文有自己的会话模块，多个编辑器标签页的变量互不影响；
+     * 空上下文使用解释器初始的__main__。
+     * @param context 运行上下文的名字
+     * @return py::dict 全局字典
+     */
+    py::dict runNamespace(const QString& context = QString());
+
+    /**
+     * @brief 释放运行上下文的会话模块（需持有GIL），用于关闭编辑器标签页
+     * @param context 运行上下文的名字，不能为空
+     */
+    void releaseNamespace(const QString& context);
+
+    /**
+     * @brief 把会话命名空间（空上下文）中可序列化的变量写入检查点文件（需持有GIL，可在任意线程调用）
+     *
+     * 上一次的检查点尚未恢复时保留原文件，不会用空的命名空间覆盖它。
+     * @param path 文件路径
+     * @return SessionCheckpoint::Summary 保存结果
+     */
+    SessionCheckpoint::Summary saveSession(const QString& path);
+
+    /**
+     * @brief 打开检查点文件，会话命名空间下一次被运行使用时恢复其中的变量（线程安全，不需要GIL）
+     *
+     * 这里只映射文件并读取索引，启动时不反序列化任何变量；恢复后发出sessionRestored()。
+     * @param path 文件路径
+     * @param error 失败时写入原因
+     * @return int 检查点中的变量数，文件无效时为-1
+     */
+    int loadSession(const QString& path, QString* error);
+
     /**
      * @brief 执行Python代码
+     *
+     * 编译结果按源码内容缓存，重复运行同一段代码时跳过编译。
+     * 代码可以在顶层使用await，此时执行得到的协程对象交给调用方在事件循环中运行。
      * @param code Python代码字符串
-     * @param globalDict 全局字典（可选）
+     * @param globalDict 全局字典（可选，为空时使用runNamespace()）
      * @param localDict 局部字典（可选）
-     * @return py::object 执行结果
+     * @return py::object 代码使用了顶层await时为协程对象，否则为None
      */
     py::object executeCode(const QString& code, 
                           py::object* globalDict = nullptr, 
                           py::object* localDict = nullptr);
 
     /**
-     * @brief 重定向Python输出到C++回调
-     * @param callback 输出回调函数
+     * @brief 把Python输出切换到指定回调（需持有GIL）
+     *
+     * sys.stdout/sys.stderr在初始化时已替换为原生输出对象，这里只替换回调，开销很小。
+     * @param callback 输出回调，为空时输出到进程的标准输出/标准错误
      */
-    void redirectPythonOutput(const std::function<void(const QString&)>& callback);
+    void redirectPythonOutput(const OutputCallback& callback);
+
+    /**
+     * @brief 设置未绑定输入的线程读取的标准输入（需持有GIL）
+     *
+     * 运行器在运行开始时设为自己的输入队列，用户代码启动的线程中的input()也从这里读取。
+     * @param input 输入队列，为空时sys.stdin立即返回EOF
+     */
+    void redirectPythonInput(InputQueue* input);
+
+    /**
+     * @brief 当前线程的sys.stdin读取的输入队列（需持有GIL）
+     *
+     * 当前线程绑定了输出和中断门时使用绑定的输入（子解释器任务没有输入，立即返回EOF），否则使用全局设置。
+     * @return InputQueue* 输入队列，可能为空
+     */
+    InputQueue* currentInput() const;
+
+    /**
+     * @brief 把数据交给当前输出回调（由原生输出对象调用，持有GIL）
+     * @param stream 流类型（0为标准输出，1为标准错误）
+     * @param data UTF-8数据
+     * @param size 字节数
+     */
+    void writeOutput(int stream, const char* data, int size);
+
+    /**
+     * @brief 在当前解释器中安装原生输出对象、标准输入和可中断的time.sleep（需持有该解释器的GIL）
+     *
+     * 主解释器在initialize()中自动安装，子解释器创建后调用一次。
+     */
+    static void prepareInterpreter();
+
+    /**
+     * @brief 把当前线程的输出、可中断等待和标准输入绑定到独立目标
+     *
+     * 运行线程和子解释器工作线程各自绑定输出回调和中断门，不经过全局的回调和中断状态；
+     * 传入nullptr恢复为全局设置。指针在解除绑定前必须保持有效。
+     * @param output 输出回调
+     * @param gate 中断门
+     * @param input 标准输入，为空时该线程的sys.stdin立即返回EOF
+     */
+    static void bindCurrentThread(const OutputCallback* output, InterruptGate* gate, InputQueue* input = nullptr);
+
+    /**
+     * @brief 只把当前线程的可中断等待绑定到中断门，输出和标准输入仍按全局设置
+     *
+     * 用户代码创建的线程继承启动它的运行器的中断门，只有该运行器中止时其中的time.sleep才被打断。
+     * 线程持有中断门的引用，运行器先于线程销毁时也不会失效。传入空指针解除绑定。
+     * @param gate 中断门
+     */
+    static void bindCurrentThreadGate(std::shared_ptr<InterruptGate> gate);
+
+    /**
+     * @brief 可中断的等待（调用前需释放GIL）
+     *
+     * 在当前线程绑定的中断门上等待；没有绑定中断门的线程（嵌入程序自己的线程等）不会被打断。
+     * @param deadline 截止时间
+     * @return bool 被绑定的中断门打断时返回true
+     */
+    static bool waitInterruptible(QDeadlineTimer deadline);
 
 signals:
     /**
@@ -118,11 +417,45 @@ signals:
      */
     void pythonError(const QString& error);
 
+    /**
+     * @brief 初始化进度信号（在初始化线程中发出）
+     * @param phase 即将开始的阶段名称
+     * @param step 阶段序号（1-based）
+     * @param total 阶段总数
+     */
+    void startupProgress(const QString& phase, int step, int total);
+
     /**
      * @brief 初始化完成信号
      */
     void initialized();
 
+    /**
+     * @brief 初始化失败信号
+     * @param error 错误信息
+     */
+    void initializationFailed(const QString& error);
+
+    /**
+     * @brief 即将销毁解释器并重新初始化（在解释器所属线程中发出，此时不持有GIL）
+     *
+     * 持有Python对象的组件应以阻塞连接在自己的线程中释放这些对象。
+     */
+    void aboutToRestart();
+
+    /**
+     * @brief 会话检查点已恢复到会话命名空间（在运行线程中发出）
+     * @param restored 恢复的变量数
+     * @param skipped 未能恢复的变量名
+     * @param elapsedNs 恢复耗时
+     */
+    void sessionRestored(int restored, const QStringList& skipped, qint64 elapsedNs);
+
+    /**
+     * @brief 预导入结束信号（在预导入线程中发出），结果见warmUpModules()
+     */
+    void warmUpFinished();
+
     /**
      * @brief 清理完成信号
      */
@@ -137,10 +470,9 @@ private:
     PythonInterpreterManager& operator=(const PythonInterpreterManager&) = delete;
 
     /**
-     * @brief 从配置文件加载设置
-     * @param configFile 配置文件路径
+     * @brief 从ConfigManager读取Python路径和代码缓存的设置
      */
-    void loadConfiguration(const QString& configFile);
+    void loadConfiguration();
 
     /**
      * @brief 设置环境变量
@@ -157,19 +489,99 @@ private:
      */
     void initializeEmbeddedModules();
 
+    /**
+     * @brief 用原生输出对象替换sys.stdout和sys.stderr（每个解释器初始化时调用一次）
+     */
+    static void installOutputSinks();
+
+    /**
+     * @brief 用从输入队列读取的原生对象替换sys.stdin（每个解释器初始化时调用一次）
+     */
+    static void installInputSource();
+
+    /**
+     * @brief 用可中断的实现替换time.sleep（每个解释器初始化时调用一次）
+     */
+    static void installInterruptibleSleep();
+
+    /**
+     * @brief 构建命名空间模板并记录初始的__main__模块（初始化时调用，持有GIL）
+     */
+    void setupNamespaceTemplate();
+
+    /**
+     * @brief 新建一个以模板初始化的__main__模块（需持有GIL）
+     * @return py::object 模块对象
+     */
+    py::object createMainModule() const;
+
     /**
      * @brief 安装Python追踪钩子
      * @param traceFunc 追踪函数
      */
     void installTraceHook(Py_tracefunc traceFunc);
 
+    /**
+     * @brief 执行一个启动阶段，报告进度并记录耗时
+     * @param name 阶段名称
+     * @param step 阶段序号（1-based）
+     * @param body 阶段内容
+     */
+    void runStartupPhase(const QString& name, int step, const std::function<void()>& body);
+
+    /**
+     * @brief 解释器所属线程的主体：初始化后等待cleanup()，再在本线程中销毁解释器
+     */
+    void ownerThreadMain();
+
+    /**
+     * @brief 预导入线程的主体
+     * @param modules 模块名
+     */
+    void warmUpMain(const QStringList& modules);
+
+    /**
+     * @brief 停止预导入并等待线程结束（当前模块导入完成后停止）
+     */
+    void stopWarmUp();
+
 private:
-    bool m_initialized = false;
+    std::atomic<bool> m_initialized{false};
+    std::atomic<bool> m_initializing{false};
+    QVector<StartupPhase> m_startupPhases;   // 初始化线程写入，initialized()之后只读
+    QVector<WarmUpModule> m_warmUpModules;   // 预导入线程写入，warmUpFinished()之后只读
+    QThread*              m_warmUpThread = nullptr;
+    std::atomic<bool>     m_warmUpStopping{false};
+    quint32 m_pythonVersionHex = 0;
+    std::shared_ptr<const InterpreterInfo> m_info;   // 解释器信息快照，原子读写
     QString m_pythonHome;
+    std::wstring m_pythonHomeW;   // 传给Py_SetPythonHome()的字符串，须在解释器存续期间有效
     QStringList m_pythonPaths;
-    QString m_configFile;
-    std::function<void(const QString&)> m_outputCallback;
+    QStringList m_pluginPaths;   // 额外的扩展模块插件目录
+    std::atomic<quint64> m_generation{0};
+    OutputCallback m_outputCallback;
+    InputQueue*    m_input = nullptr;   // 未绑定输入的线程使用的标准输入（仅在持有GIL时访问）
+    CodeCache m_codeCache;   // 编译代码缓存（内存LRU + 磁盘字节码）
+    std::atomic<qint64> m_lastCompileNs{0};
+
+    // 运行命名空间（仅在持有GIL时访问py::object成员）
+    std::atomic<bool> m_persistentNamespace{false};
+    std::atomic<bool> m_sessionResetPending{false};   // 关闭会话模式后，下次运行前释放会话变量
+    py::object        m_namespaceTemplate;            // 每次运行复制的初始内容（字典）
+    py::object        m_sessionModule;                // 会话模式下复用的__main__模块
+    QHash<QString, py::object> m_contextModules;      // 其他运行上下文（编辑器标签页）各自的会话模块
+    std::shared_ptr<SessionCheckpoint> m_pendingSession;   // 尚未恢复的会话检查点（原子访问）
 
     // Python线程状态管理
     PyThreadState* m_mainThreadState = nullptr;
-};
\ No newline at end of file
+
+    // 后台初始化时解释器所属的线程
+    QThread*                m_ownerThread = nullptr;
+    std::mutex              m_ownerMutex;
+    std::condition_variable m_ownerWake;
+    bool                    m_ownerShutdown = false;
+    bool                    m_ownerRestart  = false;   // restartAsync()请求重新初始化
+};
+
+Q_DECLARE_METATYPE(PythonInterpreterManager::WarmUpModule)
+Q_DECLARE_METATYPE(QVector<PythonInterpreterManager::WarmUpModule>)
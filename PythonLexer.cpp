@@ -0,0 +1,385 @@
+#include "PythonLexer.h"
+
+#include <cstring>
+
+namespace {
+
+// 关键字和内置名，按ASCII排序（编译期检查），扫描出的标识符在其中二分查找
+struct Word
+{
+    const char*            text;
+    PythonLexer::TokenKind kind;
+};
+
+constexpr Word kWords[] = {
+    {"False", PythonLexer::Keyword},     {"None", PythonLexer::Keyword},
+    {"True", PythonLexer::Keyword},      {"abs", PythonLexer::Builtin},
+    {"all", PythonLexer::Builtin},       {"and", PythonLexer::Keyword},
+    {"any", PythonLexer::Builtin},       {"as", PythonLexer::Keyword},
+    {"assert", PythonLexer::Keyword},    {"async", PythonLexer::Keyword},
+    {"await", PythonLexer::Keyword},     {"break", PythonLexer::Keyword},
+    {"class", PythonLexer::Keyword},     {"continue", PythonLexer::Keyword},
+    {"def", PythonLexer::Keyword},       {"del", PythonLexer::Keyword},
+    {"dict", PythonLexer::Builtin},      {"elif", PythonLexer::Keyword},
+    {"else", PythonLexer::Keyword},      {"enumerate", PythonLexer::Builtin},
+    {"except", PythonLexer::Keyword},    {"filter", PythonLexer::Builtin},
+    {"finally", PythonLexer::Keyword},   {"float", PythonLexer::Builtin},
+    {"for", PythonLexer::Keyword},       {"from", PythonLexer::Keyword},
+    {"global", PythonLexer::Keyword},    {"if", PythonLexer::Keyword},
+    {"import", PythonLexer::Keyword},    {"in", PythonLexer::Keyword},
+    {"input", PythonLexer::Builtin},     {"int", PythonLexer::Builtin},
+    {"is", PythonLexer::Keyword},        {"lambda", PythonLexer::Keyword},
+    {"len", PythonLexer::Builtin},       {"list", PythonLexer::Builtin},
+    {"map", PythonLexer::Builtin},       {"math", PythonLexer::Builtin},
+    {"max", PythonLexer::Builtin},       {"min", PythonLexer::Builtin},
+    {"nonlocal", PythonLexer::Keyword},  {"not", PythonLexer::Keyword},
+    {"open", PythonLexer::Builtin},      {"or", PythonLexer::Keyword},
+    {"os", PythonLexer::Builtin},        {"pass", PythonLexer::Keyword},
+    {"print", PythonLexer::Builtin},     {"raise", PythonLexer::Keyword},
+    {"range", PythonLexer::Builtin},     {"return", PythonLexer::Keyword},
+    {"reversed", PythonLexer::Builtin},  {"set", PythonLexer::Builtin},
+    {"sorted", PythonLexer::Builtin},    {"str", PythonLexer::Builtin},
+    {"sum", PythonLexer::Builtin},       {"try", PythonLexer::Keyword},
+    {"tuple", PythonLexer::Builtin},     {"type", PythonLexer::Builtin},
+    {"while", PythonLexer::Keyword},     {"with", PythonLexer::Keyword},
+    {"yield", PythonLexer::Keyword},     {"zip", PythonLexer::Builtin},
+};
+
+const int kWordCount = static_cast<int>(sizeof(kWords) / sizeof(kWords[0]));
+
+// 最长的关键字/内置名的长度，更长的标识符不查表
+const int kMaxWordLength = 9;
+
+constexpr bool wordLess(const char* a, const char* b)
+{
+    while (*a && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return static_cast<unsigned char>(*a) < static_cast<unsigned char>(*b);
+}
+
+constexpr bool wordsSorted()
+{
+    for (int i = 1; i < static_cast<int>(sizeof(kWords) / sizeof(kWords[0])); ++i) {
+        if (!wordLess(kWords[i - 1].text, kWords[i].text)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(wordsSorted(), "kWords must be sorted for binary search");
+
+inline bool isAsciiLetter(ushort c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool isDigit(ushort c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isIdentifierStart(QChar c)
+{
+    const ushort u = c.unicode();
+    if (u < 0x80) {
+        return isAsciiLetter(u) || u == '_';
+    }
+    return c.isLetter();
+}
+
+inline bool isIdentifierChar(QChar c)
+{
+    const ushort u = c.unicode();
+    if (u < 0x80) {
+        return isAsciiLetter(u) || isDigit(u) || u == '_';
+    }
+    return c.isLetterOrNumber() || c.isMark();
+}
+
+/**
+ * @brief 在关键字表中查找标识符
+ * @return int 表中下标，没有时为-1
+ */
+int findWord(const QChar* text, int length)
+{
+    if (length > kMaxWordLength) {
+        return -1;
+    }
+    char word[kMaxWordLength + 1];
+    for (int i = 0; i < length; ++i) {
+        const ushort c = text[i].unicode();
+        if (c >= 0x80) {
+            return -1;
+        }
+        word[i] = static_cast<char>(c);
+    }
+    word[length] = '\0';
+
+    int low  = 0;
+    int high = kWordCount - 1;
+    while (low <= high) {
+        const int middle = (low + high) / 2;
+        const int order  = std::strcmp(word, kWords[middle].text);
+        if (order == 0) {
+            return middle;
+        }
+        if (order < 0) {
+            high = middle - 1;
+        }
+        else {
+            low = middle + 1;
+        }
+    }
+    return -1;
+}
+
+// 字符串前缀：r、b、u、f及其两字母组合（rb、br、fr、rf），不区分大小写
+bool isStringPrefix(const QChar* text, int length)
+{
+    if (length < 1 || length > 2) {
+        return false;
+    }
+    const ushort first = text[0].toLower().unicode();
+    if (length == 1) {
+        return first == 'r' || first == 'b' || first == 'u' || first == 'f';
+    }
+    const ushort second = text[1].toLower().unicode();
+    return (first == 'r' && (second == 'b' || second == 'f')) ||
+           ((first == 'b' || first == 'f') && second == 'r');
+}
+
+bool isOperatorChar(ushort c)
+{
+    return c != 0 && c < 0x80 && std::strchr("+-*/%&|^<>@!", c) != nullptr;
+}
+
+/**
+ * @brief 语句开头的match、case后面是否像模式匹配语句，而不是同名变量的赋值或属性访问
+ * @param text 行文本
+ * @param length 字符数
+ * @param i 标识符之后的位置
+ */
+bool looksLikeSoftKeyword(const QChar* text, int length, int i)
+{
+    while (i < length && (text[i] == ' ' || text[i] == '\t')) {
+        ++i;
+    }
+    if (i >= length) {
+        return false;
+    }
+    const ushort c = text[i].unicode();
+    if (c != 0 && c < 0x80 && std::strchr("=.,:;)]}#", c) != nullptr) {
+        return false;
+    }
+    // 增量赋值和比较（+=、**=、==、<=等）说明是变量
+    if (isOperatorChar(c)) {
+        for (int j = i + 1; j < length && j <= i + 2; ++j) {
+            const ushort next = text[j].unicode();
+            if (next == '=') {
+                return false;
+            }
+            if (!isOperatorChar(next)) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 扫描字符串的内容直到结束引号
+ * @param text 行文本
+ * @param length 字符数
+ * @param i 引号之后的位置
+ * @param kind 字符串类型（PythonLexer的StringState），行尾未结束时写入open
+ * @param triple 是否为三引号字符串
+ * @param quote 引号字符
+ * @param open 输出：行尾仍未结束时为kind，否则为0
+ * @return int 字符串之后的位置
+ */
+int scanString(const QChar* text, int length, int i, int kind, bool triple, ushort quote, int* open)
+{
+    while (i < length) {
+        const ushort c = text[i].unicode();
+        if (c == '\\') {
+            // 行尾的反斜杠：字符串延续到下一行
+            if (i + 1 >= length) {
+                *open = kind;
+                return length;
+            }
+            i += 2;
+            continue;
+        }
+        if (c == quote) {
+            if (!triple) {
+                *open = 0;
+                return i + 1;
+            }
+            if (i + 2 < length && text[i + 1].unicode() == quote && text[i + 2].unicode() == quote) {
+                *open = 0;
+                return i + 3;
+            }
+        }
+        ++i;
+    }
+    // 单引号字符串没有续行时到行尾结束（语法错误，不影响下一行）
+    *open = triple ? kind : 0;
+    return length;
+}
+
+int scanNumber(const QChar* text, int length, int start)
+{
+    // 十六进制数中的e是数字，后面的+、-是运算符
+    const bool hex = start + 1 < length && text[start].unicode() == '0' &&
+                     (text[start + 1].unicode() == 'x' || text[start + 1].unicode() == 'X');
+    int i = start + 1;
+    while (i < length) {
+        const ushort c = text[i].unicode();
+        if (!hex && (c == 'e' || c == 'E') && i + 1 < length &&
+            (text[i + 1].unicode() == '+' || text[i + 1].unicode() == '-')) {
+            i += 2;
+            continue;
+        }
+        if (isDigit(c) || isAsciiLetter(c) || c == '_' || c == '.') {
+            ++i;
+            continue;
+        }
+        break;
+    }
+    return i;
+}
+
+inline void addToken(QVector<PythonLexer::Token>* tokens, int start, int end, PythonLexer::TokenKind kind)
+{
+    PythonLexer::Token token;
+    token.start  = start;
+    token.length = end - start;
+    token.kind   = kind;
+    tokens->append(token);
+}
+
+}   // namespace
+
+int PythonLexer::lexLine(const QChar* text, int length, int state, QVector<Token>* tokens)
+{
+    tokens->clear();
+    if (state < 0) {
+        state = kInitialState;
+    }
+
+    int  depth          = bracketDepth(state);
+    bool statementStart = depth == 0 && !(state & kContinuationFlag);
+    bool continuation   = false;
+    int  open           = NoString;
+    bool afterDot       = false;   // 上一个记号是"."，属性名不按内置名着色
+    int  i              = 0;
+
+    // 上一行未结束的字符串
+    const int previous = state & kStringMask;
+    if (previous != NoString) {
+        const bool   triple = previous >= TripleSingleQuote;
+        const ushort quote  = (previous == SingleQuote || previous == TripleSingleQuote) ? '\'' : '"';
+        i = scanString(text, length, 0, previous, triple, quote, &open);
+        addToken(tokens, 0, i, String);
+        statementStart = false;
+    }
+
+    while (i < length && open == NoString) {
+        const QChar  ch = text[i];
+        const ushort c  = ch.unicode();
+
+        if (c == ' ' || c == '\t' || c == '\f') {
+            ++i;
+            continue;
+        }
+
+        if (c == '#') {
+            addToken(tokens, i, length, Comment);
+            break;
+        }
+
+        if (c == '\\' && i + 1 == length) {
+            continuation = true;
+            break;
+        }
+
+        // 字符串（可能带前缀）
+        int stringStart = -1;
+        int quoteAt     = -1;
+        if (c == '\'' || c == '"') {
+            stringStart = i;
+            quoteAt     = i;
+        }
+        else if (isIdentifierStart(ch)) {
+            const int start = i;
+            while (i < length && isIdentifierChar(text[i])) {
+                ++i;
+            }
+            if (i < length && (text[i] == '\'' || text[i] == '"') && isStringPrefix(text + start, i - start)) {
+                stringStart = start;
+                quoteAt     = i;
+            }
+            else {
+                const int word = findWord(text + start, i - start);
+                if (word >= 0 && !(afterDot && kWords[word].kind == Builtin)) {
+                    addToken(tokens, start, i, kWords[word].kind);
+                }
+                else if (statementStart && !afterDot && (i - start == 5 || i - start == 4)) {
+                    const QString name = QString::fromRawData(text + start, i - start);
+                    if ((name == QLatin1String("match") || name == QLatin1String("case")) &&
+                        looksLikeSoftKeyword(text, length, i)) {
+                        addToken(tokens, start, i, Keyword);
+                    }
+                }
+                statementStart = false;
+                afterDot       = false;
+                continue;
+            }
+        }
+
+        if (quoteAt >= 0) {
+            const ushort quote  = text[quoteAt].unicode();
+            const bool   triple = quoteAt + 2 < length && text[quoteAt + 1].unicode() == quote &&
+                                text[quoteAt + 2].unicode() == quote;
+            const int kind = triple ? (quote == '\'' ? TripleSingleQuote : TripleDoubleQuote)
+                                    : (quote == '\'' ? SingleQuote : DoubleQuote);
+            i = scanString(text, length, quoteAt + (triple ? 3 : 1), kind, triple, quote, &open);
+            addToken(tokens, stringStart, i, String);
+            statementStart = false;
+            afterDot       = false;
+            continue;
+        }
+
+        if (isDigit(c) || (c == '.' && i + 1 < length && isDigit(text[i + 1].unicode()))) {
+            const int start = i;
+            i = scanNumber(text, length, start);
+            addToken(tokens, start, i, Number);
+            statementStart = false;
+            afterDot       = false;
+            continue;
+        }
+
+        switch (c) {
+        case '(':
+        case '[':
+        case '{':
+            depth = qMin(depth + 1, kMaxDepth);
+            break;
+        case ')':
+        case ']':
+        case '}':
+            depth = qMax(depth - 1, 0);
+            break;
+        default:
+            break;
+        }
+        // 分号之后是新的语句
+        statementStart = c == ';' && depth == 0;
+        afterDot       = c == '.';
+        ++i;
+    }
+
+    return open | (continuation ? kContinuationFlag : 0) | (depth << kDepthShift);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QChar>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @class PythonLexer
+ * @brief 逐行的Python词法分析器，供语法高亮使用
+ *
+ * 手写的状态机，每一行只从左到右扫描一遍，耗时与字符数成正比，与关键字数量无关：
+ * 标识符扫描完后在编译期排好序的关键字/内置名表中二分查找（只有ASCII标识符才查表）。
+ *
+ * 行与行之间的状态打包成一个int（即文本块的用户状态）：
+ * - 未结束的字符串：三引号字符串，或行尾以反斜杠续行的单引号字符串
+ * - 行尾的反斜杠续行
+ * - 未闭合的括号层数（上限255）
+ * 状态只依赖上一行的状态和本行文本，某一行的输出状态不变时之后的行都不必重新分析。
+ *
+ * 括号层数和续行用于判断一行是否为语句开头，软关键字match、case只在语句开头识别为关键字。
+ *
+ * 不涉及界面和Python，可以在任意线程中使用。
+ */
+class PythonLexer
+{
+public:
+    // 行首的初始状态
+    static const int kInitialState = 0;
+
+    /**
+     * @brief 记号类型（只输出需要着色的记号）
+     */
+    enum TokenKind : quint8
+    {
+        Keyword,
+        Builtin,
+        String,
+        Number,
+        Comment,
+        TokenKindCount
+    };
+
+    /**
+     * @brief 一个记号
+     */
+    struct Token
+    {
+        int       start  = 0;
+        int       length = 0;
+        TokenKind kind   = Keyword;
+    };
+
+    /**
+     * @brief 分析一行
+     * @param text 行文本（不含换行符）
+     * @param length 字符数
+     * @param state 上一行结束时的状态，第一行或未知时传kInitialState（负数按初始状态处理）
+     * @param tokens 输出的记号，按位置排列（先清空）
+     * @return int 本行结束时的状态
+     */
+    static int lexLine(const QChar* text, int length, int state, QVector<Token>* tokens);
+
+    /**
+     * @brief 分析一行
+     * @param line 行文本（不含换行符）
+     * @param state 上一行结束时的状态
+     * @param tokens 输出的记号
+     * @return int 本行结束时的状态
+     */
+    static int lexLine(const QString& line, int state, QVector<Token>* tokens)
+    {
+        return lexLine(line.constData(), line.size(), state, tokens);
+    }
+
+    /**
+     * @brief 状态是否处于未结束的字符串中
+     * @param state 行结束时的状态
+     * @return bool 在字符串中返回true
+     */
+    static bool isInString(int state) { return (state & kStringMask) != 0; }
+
+    /**
+     * @brief 状态中未闭合的括号层数
+     * @param state 行结束时的状态
+     * @return int 层数
+     */
+    static int bracketDepth(int state) { return (state >> kDepthShift) & kMaxDepth; }
+
+private:
+    // 状态的打包方式：低3位为字符串类型，第3位为反斜杠续行，第4位起为括号层数
+    enum StringState
+    {
+        NoString = 0,
+        SingleQuote,         // '...\ 续行
+        DoubleQuote,         // "...\ 续行
+        TripleSingleQuote,   // '''
+        TripleDoubleQuote    // """
+    };
+    static const int kStringMask       = 0x7;
+    static const int kContinuationFlag = 0x8;
+    static const int kDepthShift       = 4;
+    static const int kMaxDepth         = 0xff;
+};
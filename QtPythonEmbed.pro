@@ -1,25 +1,139 @@
-QT += core gui widgets
+QT += core gui widgets network
+CONFIG += c++17
 
 
 HEADERS += \
+    AsyncioLoop.h \
+    BatchKernels.h \
+    BatchRunner.h \
+    BreakpointTable.h \
+    BufferBridge.h \
+    CellDependencies.h \
+    CellIndex.h \
+    CodeCache.h \
+    CodeFormatter.h \
     CodeRunner.h \
+    CompletionEngine.h \
+    DiagnosticsService.h \
+    ExecutionRecorder.h \
+    ExecutionRecording.h \
+    ExecutionServer.h \
+    ExecutionWorker.h \
+    FileLoader.h \
+    FlameGraph.h \
+    FlameGraphView.h \
+    FrameChannel.h \
+    GilWaitMeter.h \
+    HighlightEngine.h \
+    ImageView.h \
+    InputQueue.h \
+    InterpreterPool.h \
+    InterruptGate.h \
+    IpcChannel.h \
     ConfigManager.h \
+    LineChannel.h \
+    LineProfile.h \
+    MemoryProfiler.h \
+    ModuleRegistry.h \
+    MonitoringHook.h \
+    NativeCall.h \
+    OutlineIndex.h \
+    OutlineView.h \
+    OutputChannel.h \
+    OutputConsole.h \
+    OutputLog.h \
+    OutputSearch.h \
+    ProcessPool.h \
+    ProfileView.h \
     PyEditor.h \
     PyWindow.h \
-    PythonInterpreterManager.h
+    PythonDetector.h \
+    PythonHandles.h \
+    PythonInterpreterManager.h \
+    PythonLexer.h \
+    RemoteCodeRunner.h \
+    ReplayView.h \
+    RunMetricsLog.h \
+    RunMetricsView.h \
+    RunScheduler.h \
+    RunWatchdog.h \
+    SamplingProfiler.h \
+    SaveService.h \
+    ServerProtocol.h \
+    SessionCheckpoint.h \
+    SyntaxCheck.h \
+    VariableInspector.h \
+    VariablesView.h \
+    WatchList.h \
+    WatchesView.h \
+    WorkerProtocol.h
 
 SOURCES += \
+    AsyncioLoop.cpp \
+    BatchKernels.cpp \
+    BatchRunner.cpp \
+    BreakpointTable.cpp \
+    BufferBridge.cpp \
+    CellDependencies.cpp \
+    CellIndex.cpp \
+    CodeCache.cpp \
+    CodeFormatter.cpp \
     CodeRunner.cpp \
+    CompletionEngine.cpp \
+    DiagnosticsService.cpp \
+    ExecutionRecorder.cpp \
+    ExecutionRecording.cpp \
+    ExecutionServer.cpp \
+    ExecutionWorker.cpp \
+    FileLoader.cpp \
+    FlameGraph.cpp \
+    FlameGraphView.cpp \
+    FrameChannel.cpp \
+    GilWaitMeter.cpp \
+    HighlightEngine.cpp \
+    ImageView.cpp \
+    InputQueue.cpp \
+    InterpreterPool.cpp \
+    InterruptGate.cpp \
+    IpcChannel.cpp \
     ConfigManager.cpp \
+    LineChannel.cpp \
+    LineProfile.cpp \
+    MemoryProfiler.cpp \
+    ModuleRegistry.cpp \
+    MonitoringHook.cpp \
+    NativeCall.cpp \
+    OutlineIndex.cpp \
+    OutlineView.cpp \
+    OutputChannel.cpp \
+    OutputConsole.cpp \
+    OutputLog.cpp \
+    OutputSearch.cpp \
+    ProcessPool.cpp \
+    ProfileView.cpp \
     PyEditor.cpp \
     PyWindow.cpp \
+    PythonDetector.cpp \
+    PythonHandles.cpp \
     PythonInterpreterManager.cpp \
+    PythonLexer.cpp \
+    RemoteCodeRunner.cpp \
+    ReplayView.cpp \
+    RunMetricsLog.cpp \
+    RunMetricsView.cpp \
+    RunScheduler.cpp \
+    RunWatchdog.cpp \
+    SamplingProfiler.cpp \
+    SaveService.cpp \
+    SessionCheckpoint.cpp \
+    SyntaxCheck.cpp \
+    VariableInspector.cpp \
+    VariablesView.cpp \
+    WatchList.cpp \
+    WatchesView.cpp \
     main.cpp
 
-PYTHON_ROOT=C:/Users/w/.conda/pkgs/python-3.10.19-h981015d_0
+# 常驻内存采样（GetProcessMemoryInfo）
+win32: LIBS += -lpsapi
 
-INCLUDEPATH += $$PWD/3rd/include
-INCLUDEPATH += $$PYTHON_ROOT/include
-
-win32:CONFIG(release, debug|release): LIBS += -L$$PYTHON_ROOT/libs/ -lpython310
-else:win32:CONFIG(debug, debug|release): LIBS += -L$$PYTHON_ROOT/libs/ -lpython310_d
+include(python.pri)
@@ -0,0 +1,610 @@
+#include "RemoteCodeRunner.h"
+#include "GilWaitMeter.h"
+#include "WorkerProtocol.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QThread>
+#include <QTimer>
+
+#include <chrono>
+
+// 命令在通道满时的最长等待时间（执行进程正常时通道几乎总是空的）
+static const int kCommandTimeoutMs = 1000;
+
+// 中止请求发出后执行进程仍未结束运行，强制结束进程的期限
+static const int kAbortKillMs = 5000;
+
+// 退出时等待执行进程自行结束的时间
+static const int kShutdownWaitMs = 3000;
+
+// 标准输入切片发送，单条消息远小于通道缓冲区
+static const int kInputSliceBytes = 64 * 1024;
+
+// 同一进程中的多个RemoteCodeRunner使用不同的通道标识
+static std::atomic<int> s_nextChannelId{0};
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+RemoteCodeRunner::RemoteCodeRunner(QObject* parent)
+    : CodeRunner(parent)
+{
+    qRegisterMetaType<QVector<PythonInterpreterManager::WarmUpModule>>();
+    spawnWorker();
+}
+
+RemoteCodeRunner::~RemoteCodeRunner()
+{
+    m_shuttingDown = true;
+    stopSpare();
+
+    if (m_process) {
+        disconnect(m_process, nullptr, this, nullptr);
+        sendCommand(WorkerProtocol::Shutdown);
+        if (!m_process->waitForFinished(kShutdownWaitMs)) {
+            m_process->kill();
+            m_process->waitForFinished();
+        }
+    }
+
+    stopReader();
+}
+
+void RemoteCodeRunner::setPersistentNamespace(bool persistent)
+{
+    m_persistentNamespace = persistent;
+    sendCommand(WorkerProtocol::SetPersistentNamespace,
+                WorkerProtocol::encode<quint8>(persistent ? 1 : 0));
+}
+
+void RemoteCodeRunner::setWarmUpModules(const QStringList& modules)
+{
+    m_warmUpModules = modules;
+    if (!m_warmUpModules.isEmpty()) {
+        sendCommand(WorkerProtocol::WarmUp, encodeWarmUpModules());
+    }
+}
+
+void RemoteCodeRunner::setSpareWorker(bool enabled)
+{
+    m_spareEnabled = enabled;
+    if (!enabled) {
+        stopSpare();
+    }
+    else if (m_ready) {
+        spawnSpare();
+    }
+}
+
+bool RemoteCodeRunner::restartWorker(bool environmentChanged)
+{
+    if (m_running) {
+        return false;
+    }
+
+    // 备用进程按启动时的配置初始化，环境变化后不能再用
+    if (environmentChanged) {
+        stopSpare();
+    }
+
+    if (m_process) {
+        QProcess* process = m_process;
+        m_process         = nullptr;
+        disconnect(process, nullptr, this, nullptr);
+        sendCommand(WorkerProtocol::Shutdown);
+        retireProcess(process);
+    }
+    stopReader();
+
+    spawnWorker();
+    return true;
+}
+
+std::shared_ptr<LineChannel> RemoteCodeRunner::lineChannel() const
+{
+    return std::atomic_load(&m_remoteLineChannel);
+}
+
+std::shared_ptr<FrameChannel> RemoteCodeRunner::frameChannel() const
+{
+    return std::atomic_load(&m_remoteFrameChannel);
+}
+
+void RemoteCodeRunner::beginRun(const RunScheduler::Request& request)
+{
+    const QString& code = request.code;
+
+    m_running = true;
+    ++m_runSerial;
+    m_abortRequested = false;
+    m_runStartNs     = monotonicNs();
+
+    const GilWaitMeter::Totals gil = GilWaitMeter::totals();
+    m_runStartGilWaitNs            = gil.waitNs;
+    m_runStartGilWaits             = gil.waits;
+
+    std::atomic_store(&m_remoteLineChannel, std::make_shared<LineChannel>(code.count('\n') + 1));
+
+    // 预算随每次运行发送，执行进程中的运行器在自己的进程里监视
+    WorkerProtocol::BudgetPayload budgets = {};
+    budgets.wallMs                        = request.budgets.wallMs;
+    budgets.cpuMs                         = request.budgets.cpuMs;
+    budgets.memoryMB                      = request.budgets.memoryMB;
+
+    // 执行进程尚未就绪时命令留在通道中，附加后按顺序处理
+    if (!m_channel ||
+        !m_channel->send(WorkerProtocol::SetBudgets, WorkerProtocol::encode(budgets), kCommandTimeoutMs) ||
+        !m_channel->send(WorkerProtocol::RunCode, code.toUtf8(), kCommandTimeoutMs)) {
+        m_running = false;
+        emit errorOccurred(m_channel ? m_channel->errorString() : QString("执行进程不可用"));
+        finishRun();
+    }
+}
+
+void RemoteCodeRunner::abortExecution()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_abortRequested = true;
+    sendCommand(WorkerProtocol::Abort);
+
+    // 执行进程中的强制停止也无法结束运行时（例如卡在C扩展中），直接结束进程
+    const int serial = m_runSerial;
+    QTimer::singleShot(kAbortKillMs, this, [this, serial]() {
+        if (m_running && serial == m_runSerial && m_process) {
+            qWarning() << "Execution worker did not stop in time, killing it";
+            m_process->kill();
+        }
+    });
+}
+
+void RemoteCodeRunner::pauseExecution()
+{
+    sendCommand(WorkerProtocol::Pause);
+}
+
+void RemoteCodeRunner::continueExecution()
+{
+    sendCommand(WorkerProtocol::Continue);
+}
+
+void RemoteCodeRunner::stepInto()
+{
+    sendCommand(WorkerProtocol::StepInto);
+}
+
+void RemoteCodeRunner::stepOver()
+{
+    sendCommand(WorkerProtocol::StepOver);
+}
+
+void RemoteCodeRunner::stepOut()
+{
+    sendCommand(WorkerProtocol::StepOut);
+}
+
+void RemoteCodeRunner::writeInput(const QByteArray& data)
+{
+    // 执行进程的命令线程直接追加到输入队列，通道很快腾空
+    for (int start = 0; start < data.size(); start += kInputSliceBytes) {
+        sendCommand(WorkerProtocol::WriteInput, data.mid(start, kInputSliceBytes));
+    }
+}
+
+void RemoteCodeRunner::closeInput()
+{
+    sendCommand(WorkerProtocol::CloseInput);
+}
+
+void RemoteCodeRunner::setBreakpoints(const QVector<Breakpoint>& breakpoints)
+{
+    m_breakpoints = breakpoints;
+    sendCommand(WorkerProtocol::SetBreakpoints, encodeBreakpoints());
+}
+
+void RemoteCodeRunner::requestVariables(quint64 handle, int start, int count)
+{
+    WorkerProtocol::VariableRequestPayload request = {handle, start, count};
+    sendCommand(WorkerProtocol::RequestVariables, WorkerProtocol::encode(request));
+}
+
+void RemoteCodeRunner::setWatchExpressions(const QStringList& expressions)
+{
+    m_watchExpressions = expressions;
+    sendCommand(WorkerProtocol::SetWatches, encodeWatchExpressions());
+}
+
+std::unique_ptr<IpcChannel> RemoteCodeRunner::createChannel(QString* key) const
+{
+    *key = QString("QtPythonEmbed-%1-%2")
+               .arg(QCoreApplication::applicationPid())
+               .arg(s_nextChannelId.fetch_add(1));
+
+    std::unique_ptr<IpcChannel> channel(new IpcChannel(IpcChannel::Host));
+    if (!channel->create(*key)) {
+        qCritical() << "Cannot create execution channel" << *key << ":" << channel->errorString();
+        return nullptr;
+    }
+    return channel;
+}
+
+void RemoteCodeRunner::spawnWorker()
+{
+    m_ready = false;
+
+    // 有备用进程时直接换上，它的就绪事件还在通道中，由新的读取线程照常处理
+    QString   key;
+    QProcess* spare = m_spareProcess;
+    if (spare) {
+        disconnect(spare, nullptr, this, nullptr);
+        m_channel      = std::move(m_spareChannel);
+        m_spareProcess = nullptr;
+    }
+    else {
+        m_channel = createChannel(&key);
+        if (!m_channel) {
+            return;
+        }
+    }
+
+    m_readerStopping    = false;
+    IpcChannel* channel = m_channel.get();
+    m_readerThread      = QThread::create([this, channel]() { readerLoop(channel); });
+    m_readerThread->start();
+
+    // 恢复上一代执行进程的设置
+    if (!m_breakpoints.isEmpty()) {
+        sendCommand(WorkerProtocol::SetBreakpoints, encodeBreakpoints());
+    }
+    if (!m_watchExpressions.isEmpty()) {
+        sendCommand(WorkerProtocol::SetWatches, encodeWatchExpressions());
+    }
+    if (m_persistentNamespace) {
+        sendCommand(WorkerProtocol::SetPersistentNamespace, WorkerProtocol::encode<quint8>(1));
+    }
+    if (!m_warmUpModules.isEmpty()) {
+        sendCommand(WorkerProtocol::WarmUp, encodeWarmUpModules());
+    }
+
+    // 标准输入保持为管道：主进程退出时执行进程读到EOF后自行退出
+    if (spare) {
+        m_process = spare;
+    }
+    else {
+        m_process = new QProcess(this);
+        m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+    }
+    connect(m_process,
+            QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this,
+            &RemoteCodeRunner::onWorkerFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            emit errorOccurred("无法启动执行进程: " + m_process->errorString());
+        }
+    });
+
+    if (!spare) {
+        m_process->start(QCoreApplication::applicationFilePath(),
+                         {WorkerProtocol::kWorkerArgument, key});
+    }
+}
+
+void RemoteCodeRunner::spawnSpare()
+{
+    if (!m_spareEnabled || m_spareProcess || m_shuttingDown) {
+        return;
+    }
+
+    QString key;
+    m_spareChannel = createChannel(&key);
+    if (!m_spareChannel) {
+        return;
+    }
+
+    // 备用进程启动失败或自行退出（如环境有问题）时丢弃，当前执行进程下次就绪时再启动
+    QProcess* process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, process]() {
+        if (process == m_spareProcess) {
+            m_spareProcess = nullptr;
+            m_spareChannel.reset();
+        }
+        process->deleteLater();
+    });
+    m_spareProcess = process;
+    process->start(QCoreApplication::applicationFilePath(), {WorkerProtocol::kWorkerArgument, key});
+}
+
+void RemoteCodeRunner::stopSpare()
+{
+    if (!m_spareProcess) {
+        return;
+    }
+
+    QProcess* process = m_spareProcess;
+    m_spareProcess    = nullptr;
+    disconnect(process, nullptr, this, nullptr);
+    m_spareChannel->send(WorkerProtocol::Shutdown, QByteArray(), kCommandTimeoutMs);
+    retireProcess(process);
+    m_spareChannel.reset();
+}
+
+void RemoteCodeRunner::retireProcess(QProcess* process)
+{
+    // 退出命令已在通道中；关闭标准输入后，尚未附加到通道的进程也会自行退出。
+    // 析构时同步等待，其他时候不阻塞界面，进程退出后删除
+    if (m_shuttingDown) {
+        process->closeWriteChannel();
+        if (!process->waitForFinished(kShutdownWaitMs)) {
+            process->kill();
+            process->waitForFinished();
+        }
+        delete process;
+        return;
+    }
+
+    if (process->state() == QProcess::NotRunning) {
+        process->deleteLater();
+        return;
+    }
+    process->closeWriteChannel();
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process, &QObject::deleteLater);
+    QTimer::singleShot(kShutdownWaitMs, process, [process]() { process->kill(); });
+}
+
+void RemoteCodeRunner::stopReader()
+{
+    if (!m_readerThread) {
+        return;
+    }
+
+    m_readerStopping = true;
+    m_channel->close();
+    m_readerThread->wait();
+    delete m_readerThread;
+    m_readerThread = nullptr;
+    m_channel.reset();
+}
+
+void RemoteCodeRunner::readerLoop(IpcChannel* channel)
+{
+    quint16    type = 0;
+    QByteArray payload;
+
+    while (channel->receive(&type, &payload, true)) {
+        handleEvent(type, payload);
+    }
+}
+
+void RemoteCodeRunner::handleEvent(quint16 type, const QByteArray& payload)
+{
+    // 信号在读取线程中发出，由Qt排队到界面线程，顺序与执行进程发出的顺序一致
+    qint32 value = 0;
+
+    switch (type) {
+    case WorkerProtocol::Ready:
+        std::atomic_store(&m_remoteFrameChannel,
+                          payload.isEmpty() ? std::shared_ptr<FrameChannel>()
+                                            : FrameChannel::attachShared(QString::fromUtf8(payload)));
+        m_ready = true;
+        emit workerReady();
+        // 当前执行进程就绪后再启动备用进程，不与它争抢启动时间
+        QMetaObject::invokeMethod(this, [this]() { spawnSpare(); }, Qt::QueuedConnection);
+        break;
+    case WorkerProtocol::Started:
+        emit executionStarted();
+        break;
+    case WorkerProtocol::StdOut:
+        writeOutput(OutputChannel::StdOut, payload);
+        break;
+    case WorkerProtocol::StdErr:
+        writeOutput(OutputChannel::StdErr, payload);
+        break;
+    case WorkerProtocol::LogOutput:
+        writeOutput(OutputChannel::Log, payload);
+        break;
+    case WorkerProtocol::Variables: {
+        VariableInspector::Page page;
+        if (VariableInspector::decode(payload, &page)) {
+            emit variablesReady(page);
+        }
+        break;
+    }
+    case WorkerProtocol::WarmedUp: {
+        QVector<PythonInterpreterManager::WarmUpModule> modules;
+        if (PythonInterpreterManager::decodeWarmUp(payload, &modules)) {
+            emit warmUpFinished(modules);
+        }
+        break;
+    }
+    case WorkerProtocol::Watches: {
+        QVector<WatchList::Value> values;
+        if (WatchList::decode(payload, &values)) {
+            emit watchesReady(values);
+        }
+        break;
+    }
+    case WorkerProtocol::Line:
+    case WorkerProtocol::LineExecuted:
+        if (WorkerProtocol::decode(payload, &value)) {
+            std::shared_ptr<LineChannel> channel = std::atomic_load(&m_remoteLineChannel);
+            if (channel) {
+                channel->record(value);
+            }
+            if (type == WorkerProtocol::LineExecuted) {
+                emit lineExecuted(value);
+            }
+        }
+        break;
+    case WorkerProtocol::InputWaiting: {
+        quint8 waiting = 0;
+        if (WorkerProtocol::decode(payload, &waiting)) {
+            emit inputWaitChanged(waiting != 0);
+        }
+        break;
+    }
+    case WorkerProtocol::DebugState:
+        if (WorkerProtocol::decode(payload, &value)) {
+            emit debugStateChanged(value);
+        }
+        break;
+    case WorkerProtocol::Error:
+        emit errorOccurred(QString::fromUtf8(payload));
+        break;
+    case WorkerProtocol::Summary: {
+        WorkerProtocol::SummaryPayload data;
+        if (WorkerProtocol::decode(payload, &data)) {
+            RunSummary summary;
+            summary.elapsedNs        = data.elapsedNs;
+            summary.abortLatencyNs   = data.abortLatencyNs;
+            summary.aborted          = data.aborted != 0;
+            summary.hardStopped      = data.hardStopped != 0;
+            summary.budgetExceeded   = data.budgetExceeded;
+            summary.compileNs        = data.compileNs;
+            summary.cpuNs            = data.cpuNs;
+            summary.traceEvents      = data.traceEvents;
+            summary.traceNs          = data.traceNs;
+            summary.outputBytes      = data.outputBytes;
+            summary.outputLines      = data.outputLines;
+            summary.logpointHits     = data.logpointHits;
+            summary.logpointsDropped = data.logpointsDropped;
+            addLocalMetrics(&summary);
+            emit runSummary(summary);
+        }
+        break;
+    }
+    case WorkerProtocol::Finished:
+        m_running = false;
+        emit executionFinished();
+        finishRun();
+        break;
+    default:
+        qWarning() << "Unknown message from execution worker:" << type;
+        break;
+    }
+}
+
+void RemoteCodeRunner::addLocalMetrics(RunSummary* summary) const
+{
+    const GilWaitMeter::Totals gil = GilWaitMeter::totals();
+    summary->uiGilWaitNs           = gil.waitNs - m_runStartGilWaitNs;
+    summary->uiGilWaits            = gil.waits - m_runStartGilWaits;
+}
+
+void RemoteCodeRunner::writeOutput(OutputChannel::Stream stream, const QByteArray& text)
+{
+    const char* data = text.constData();
+    int         size = text.size();
+
+    while (size > 0 && !m_readerStopping) {
+        bool wake    = false;
+        int  written = outputChannel()->tryWrite(stream, data, size, &wake);
+        if (wake) {
+            emit outputReady();
+        }
+
+        data += written;
+        size -= written;
+
+        // 界面线程跟不上时停止读取，反压经共享内存通道传回执行进程
+        if (size > 0) {
+            outputChannel()->waitForSpace(50);
+        }
+    }
+}
+
+void RemoteCodeRunner::onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    stopReader();
+
+    m_process->deleteLater();
+    m_process = nullptr;
+
+    const bool wasReady   = m_ready.exchange(false);
+    const bool wasRunning = m_running.exchange(false);
+
+    if (wasRunning) {
+        const bool aborted = m_abortRequested;
+
+        RunSummary summary;
+        summary.elapsedNs   = monotonicNs() - m_runStartNs;
+        summary.aborted     = aborted;
+        summary.hardStopped = aborted;
+        addLocalMetrics(&summary);
+
+        const QString message =
+            aborted ? QString("执行进程未响应中止请求，已强制结束并重新启动")
+                    : QString("执行进程异常退出（退出码 %1），已重新启动").arg(exitCode);
+
+        // 排在读取线程已经投递的信号之后，界面先看到执行进程最后发出的事件
+        QMetaObject::invokeMethod(
+            this,
+            [this, message, summary]() {
+                emit errorOccurred(message);
+                emit runSummary(summary);
+                emit executionFinished();
+                finishRun();
+            },
+            Qt::QueuedConnection);
+    }
+
+    if (m_shuttingDown) {
+        return;
+    }
+
+    // 启动阶段就退出说明环境有问题，重启只会反复失败
+    if (!wasReady) {
+        qCritical() << "Execution worker exited during startup, status" << exitStatus << "code"
+                    << exitCode;
+        emit errorOccurred("执行进程启动失败，请检查Python环境");
+        return;
+    }
+
+    ++m_restartCount;
+    spawnWorker();
+    emit workerRestarted(exitCode);
+}
+
+void RemoteCodeRunner::sendCommand(quint16 type, const QByteArray& payload)
+{
+    if (!m_channel || !m_channel->send(type, payload, kCommandTimeoutMs)) {
+        qWarning() << "Cannot send command" << type << "to execution worker";
+    }
+}
+
+QByteArray RemoteCodeRunner::encodeBreakpoints() const
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << static_cast<qint32>(m_breakpoints.size());
+    for (const Breakpoint& breakpoint : m_breakpoints) {
+        stream << static_cast<qint32>(breakpoint.line) << breakpoint.condition << breakpoint.hitCondition
+               << breakpoint.logMessage;
+    }
+    return payload;
+}
+
+QByteArray RemoteCodeRunner::encodeWatchExpressions() const
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << m_watchExpressions;
+    return payload;
+}
+
+QByteArray RemoteCodeRunner::encodeWarmUpModules() const
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << m_warmUpModules;
+    return payload;
+}
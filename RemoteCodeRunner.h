@@ -0,0 +1,269 @@
+#pragma once
+
+#include "CodeRunner.h"
+#include "IpcChannel.h"
+#include "PythonInterpreterManager.h"
+
+#include <QProcess>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+class QThread;
+
+/**
+ * @class RemoteCodeRunner
+ * @brief 在独立执行进程中运行代码的CodeRunner
+ *
+ * 接口和信号与CodeRunner完全一致，界面和编辑器无需区分两种后端：
+ * - 代码、中止和调试命令写入共享内存通道，由执行进程中的CodeRunner处理
+ * - 读取线程接收输出和事件，输出写入本地输出通道，事件以原有信号发出
+ * - 执行行按执行进程的采样结果记录，命中计数是采样次数而非精确行事件数
+ * - 执行进程崩溃或被强制结束时报告错误并立即重新启动，断点和执行速度自动恢复
+ * - restartWorker()按配置文件中的当前设置换上新的执行进程（切换Python环境或从损坏的状态恢复）；
+ *   启用备用进程时预先启动一个已完成初始化的执行进程，重启时直接换上
+ *
+ * 对象应位于界面线程中，不需要移动到独立线程。
+ */
+class RemoteCodeRunner : public CodeRunner
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数（立即启动执行进程）
+     * @param parent 父对象
+     */
+    explicit RemoteCodeRunner(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（通知执行进程退出并等待其结束）
+     */
+    ~RemoteCodeRunner() override;
+
+    /**
+     * @brief 执行进程是否已完成解释器初始化
+     * @return bool 已就绪返回true
+     */
+    bool isWorkerReady() const { return m_ready; }
+
+    /**
+     * @brief 是否正在运行代码
+     * @return bool 运行中返回true
+     */
+    bool isBusy() const { return m_running; }
+
+    /**
+     * @brief 获取执行进程重新启动的次数
+     * @return int 次数
+     */
+    int restartCount() const { return m_restartCount; }
+
+    /**
+     * @brief 设置执行进程是否在多次运行之间保留会话命名空间
+     *
+     * 执行进程重启后会话变量丢失，该设置本身会自动恢复。
+     * @param persistent 是否保留
+     */
+    void setPersistentNamespace(bool persistent);
+
+    /**
+     * @brief 让执行进程在后台预导入模块（见PythonInterpreterManager::warmUp()）
+     *
+     * 执行进程重启后自动重新预导入，结果通过warmUpFinished()报告。
+     * @param modules 模块名
+     */
+    void setWarmUpModules(const QStringList& modules);
+
+    /**
+     * @brief 设置是否预先启动一个备用执行进程
+     *
+     * 备用进程在当前执行进程就绪后启动，完成解释器初始化后等待；restartWorker()或执行进程崩溃时直接换上，
+     * 不必等待新进程初始化。关闭时结束已启动的备用进程。
+     * @param enabled 是否启用
+     */
+    void setSpareWorker(bool enabled);
+
+    /**
+     * @brief 结束当前执行进程并换上新的执行进程
+     *
+     * 不等待旧进程退出。断点、监视表达式、会话设置和预导入在新进程中恢复，会话变量丢失。
+     * 新进程启动时读取配置文件，修改设置后应先调用ConfigManager::sync()。
+     * @param environmentChanged Python环境设置已修改：丢弃按旧设置启动的备用进程，重新启动
+     * @return bool 正在运行代码时返回false，不重启
+     */
+    bool restartWorker(bool environmentChanged);
+
+    std::shared_ptr<LineChannel> lineChannel() const override;
+
+    /**
+     * @brief 当前执行进程的图像通道（附加其共享内存）
+     * @return std::shared_ptr<FrameChannel> 通道，执行进程尚未就绪或没有创建时为空
+     */
+    std::shared_ptr<FrameChannel> frameChannel() const override;
+
+signals:
+    /**
+     * @brief 执行进程就绪信号
+     */
+    void workerReady();
+
+    /**
+     * @brief 执行进程异常退出并已重新启动的信号
+     * @param exitCode 退出码
+     */
+    void workerRestarted(int exitCode);
+
+    /**
+     * @brief 执行进程预导入结束信号
+     * @param modules 各模块的导入结果
+     */
+    void warmUpFinished(const QVector<PythonInterpreterManager::WarmUpModule>& modules);
+
+public slots:
+    void abortExecution() override;
+    void pauseExecution() override;
+    void continueExecution() override;
+    void stepInto() override;
+    void stepOver() override;
+    void stepOut() override;
+    void writeInput(const QByteArray& data) override;
+    void closeInput() override;
+    void setBreakpoints(const QVector<Breakpoint>& breakpoints) override;
+    void requestVariables(quint64 handle, int start, int count) override;
+    void setWatchExpressions(const QStringList& expressions) override;
+    using CodeRunner::setBreakpoints;
+
+protected:
+    /**
+     * @brief 把请求发送到执行进程（不等待运行结束，执行进程报告结束后调用finishRun()）
+     * @param request 请求
+     */
+    void beginRun(const RunScheduler::Request& request) override;
+
+private:
+    /**
+     * @brief 创建新通道并启动执行进程（有备用进程时换上备用进程）
+     */
+    void spawnWorker();
+
+    /**
+     * @brief 创建主进程端的通道
+     * @param key 输出通道标识，作为执行进程的参数
+     * @return std::unique_ptr<IpcChannel> 通道，创建失败时为空
+     */
+    std::unique_ptr<IpcChannel> createChannel(QString* key) const;
+
+    /**
+     * @brief 启动备用执行进程（未启用或已有备用进程时忽略）
+     */
+    void spawnSpare();
+
+    /**
+     * @brief 结束备用执行进程
+     */
+    void stopSpare();
+
+    /**
+     * @brief 通知不再使用的执行进程退出，逾期强制结束，退出后删除对象
+     * @param process 进程（已断开与本对象的连接，退出命令已发出）
+     */
+    void retireProcess(QProcess* process);
+
+    /**
+     * @brief 关闭通道并等待读取线程结束
+     */
+    void stopReader();
+
+    /**
+     * @brief 读取线程主函数
+     * @param channel 本代执行进程的通道
+     */
+    void readerLoop(IpcChannel* channel);
+
+    /**
+     * @brief 处理一条执行进程事件（在读取线程中调用）
+     * @param type 消息类型
+     * @param payload 负载
+     */
+    void handleEvent(quint16 type, const QByteArray& payload);
+
+    /**
+     * @brief 把执行进程的输出写入本地输出通道（在读取线程中调用）
+     * @param stream 输出流
+     * @param text UTF-8文本
+     */
+    void writeOutput(OutputChannel::Stream stream, const QByteArray& text);
+
+    /**
+     * @brief 执行进程退出处理
+     * @param exitCode 退出码
+     * @param exitStatus 退出状态
+     */
+    void onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+    /**
+     * @brief 发送命令到当前执行进程
+     * @param type 消息类型
+     * @param payload 负载
+     */
+    void sendCommand(quint16 type, const QByteArray& payload = QByteArray());
+
+    /**
+     * @brief 编码断点列表
+     * @return QByteArray QDataStream序列化的负载
+     */
+    QByteArray encodeBreakpoints() const;
+
+    /**
+     * @brief 编码监视表达式列表
+     * @return QByteArray QDataStream序列化的负载
+     */
+    QByteArray encodeWatchExpressions() const;
+
+    /**
+     * @brief 编码预导入的模块列表
+     * @return QByteArray QDataStream序列化的负载
+     */
+    QByteArray encodeWarmUpModules() const;
+
+    /**
+     * @brief 填入主进程中统计的运行指标（界面线程的GIL等待）
+     * @param summary 执行进程发回的汇总
+     */
+    void addLocalMetrics(RunSummary* summary) const;
+
+private:
+    QProcess*                   m_process      = nullptr;
+    std::unique_ptr<IpcChannel> m_channel;
+    QThread*                    m_readerThread = nullptr;
+    int                         m_runSerial    = 0;   // 运行序号，防止过期的强制结束误伤下一次运行
+    int                         m_restartCount = 0;
+    bool                        m_shuttingDown = false;
+
+    // 备用执行进程：没有读取线程，就绪事件留在通道中，换上后由新的读取线程处理
+    QProcess*                   m_spareProcess = nullptr;
+    std::unique_ptr<IpcChannel> m_spareChannel;
+    bool                        m_spareEnabled = false;
+
+    std::atomic<bool>   m_ready{false};
+    std::atomic<bool>   m_running{false};
+    std::atomic<bool>   m_readerStopping{false};
+    std::atomic<bool>   m_abortRequested{false};
+    std::atomic<qint64> m_runStartNs{0};
+    std::atomic<qint64> m_runStartGilWaitNs{0};   // 运行开始时界面线程的累计GIL等待（本进程）
+    std::atomic<qint64> m_runStartGilWaits{0};
+
+    // 执行进程重启后需要恢复的状态（仅在界面线程中访问）
+    QVector<Breakpoint> m_breakpoints;
+    QStringList         m_watchExpressions;
+    QStringList         m_warmUpModules;
+    bool                m_persistentNamespace = false;
+
+    // 本地执行行通道，由读取线程按采样结果写入
+    std::shared_ptr<LineChannel> m_remoteLineChannel;
+
+    // 当前执行进程的图像通道，由读取线程在进程就绪时替换
+    std::shared_ptr<FrameChannel> m_remoteFrameChannel;
+};
@@ -0,0 +1,242 @@
+#include "ReplayView.h"
+#include "ExecutionRecording.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QSpinBox>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <climits>
+
+// 播放定时器的间隔（约60帧每秒）
+static const int kPlayFrameMs = 16;
+
+ReplayView::ReplayView(QWidget* parent)
+    : QWidget(parent)
+{
+    m_previousHitButton = new QPushButton("◀◀ 本行上次");
+    m_previousHitButton->setToolTip("跳到当前行的上一次执行");
+    m_backButton = new QPushButton("◀ 上一步");
+    m_forwardButton = new QPushButton("下一步 ▶");
+    m_nextHitButton = new QPushButton("本行下次 ▶▶");
+    m_nextHitButton->setToolTip("跳到当前行的下一次执行");
+
+    m_slider = new QSlider(Qt::Horizontal);
+
+    m_playButton = new QPushButton("播放");
+    m_playButton->setToolTip("从当前步开始按设定的间隔自动前进");
+    m_intervalSpin = new QSpinBox;
+    m_intervalSpin->setRange(1, 5000);
+    m_intervalSpin->setValue(100);
+    m_intervalSpin->setSuffix(" ms/步");
+    m_intervalSpin->setToolTip("播放时每一步的间隔，只影响回放，不影响代码的运行速度");
+
+    m_playTimer.setInterval(kPlayFrameMs);
+    m_playTimer.setTimerType(Qt::PreciseTimer);
+
+    m_positionLabel = new QLabel;
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget(m_previousHitButton);
+    controls->addWidget(m_backButton);
+    controls->addWidget(m_slider, 1);
+    controls->addWidget(m_forwardButton);
+    controls->addWidget(m_nextHitButton);
+    controls->addWidget(m_playButton);
+    controls->addWidget(m_intervalSpin);
+
+    m_localsTree = new QTreeWidget;
+    m_localsTree->setColumnCount(2);
+    m_localsTree->setHeaderLabels({"名称", "值"});
+    m_localsTree->setRootIsDecorated(false);
+    m_localsTree->setUniformRowHeights(true);
+    m_localsTree->header()->setStretchLastSection(true);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(controls);
+    layout->addWidget(m_positionLabel);
+    layout->addWidget(m_localsTree);
+
+    connect(m_slider, &QSlider::valueChanged, this, &ReplayView::showStep);
+    connect(m_backButton, &QPushButton::clicked, this, &ReplayView::stepBackward);
+    connect(m_forwardButton, &QPushButton::clicked, this, &ReplayView::stepForward);
+    connect(m_previousHitButton, &QPushButton::clicked, this, &ReplayView::previousHit);
+    connect(m_nextHitButton, &QPushButton::clicked, this, &ReplayView::nextHit);
+    connect(m_playButton, &QPushButton::clicked, this, &ReplayView::togglePlayback);
+    connect(&m_playTimer, &QTimer::timeout, this, &ReplayView::advancePlayback);
+    connect(m_intervalSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &ReplayView::stepIntervalChanged);
+
+    setRecording(nullptr);
+}
+
+void ReplayView::setStepInterval(int intervalMs)
+{
+    QSignalBlocker blocker(m_intervalSpin);
+    m_intervalSpin->setValue(intervalMs);
+}
+
+void ReplayView::setRecording(std::shared_ptr<ExecutionRecording> recording)
+{
+    stopPlayback();
+    m_recording = std::move(recording);
+    m_line      = 0;
+
+    const bool enabled = m_recording && m_recording->stepCount() > 0;
+    for (QWidget* widget :
+         {static_cast<QWidget*>(m_slider), static_cast<QWidget*>(m_previousHitButton),
+          static_cast<QWidget*>(m_backButton), static_cast<QWidget*>(m_forwardButton),
+          static_cast<QWidget*>(m_nextHitButton), static_cast<QWidget*>(m_playButton)}) {
+        widget->setEnabled(enabled);
+    }
+    m_localsTree->clear();
+
+    if (!enabled) {
+        QSignalBlocker blocker(m_slider);
+        m_slider->setRange(0, 0);
+        m_positionLabel->setText(m_recording ? "录制中没有执行任何行"
+                                             : "使用\"录制运行\"运行代码后，可以在这里前后回放每一步");
+        return;
+    }
+
+    // 滑块的范围是int，超过的部分无法到达（录制文件上限1GB，通常远小于此）
+    const int last = static_cast<int>(qMin<qint64>(m_recording->stepCount() - 1, INT_MAX));
+    m_localsTree->setVisible(m_recording->hasLocals());
+    {
+        QSignalBlocker blocker(m_slider);
+        m_slider->setRange(0, last);
+        m_slider->setPageStep(qMax(1, last / 100));
+        m_slider->setValue(0);
+    }
+    showStep(0);
+}
+
+void ReplayView::showStep(int index)
+{
+    if (!m_recording) {
+        return;
+    }
+
+    const ExecutionRecording::Step step = m_recording->step(index);
+    if (step.index < 0) {
+        return;
+    }
+
+    QString position = QString("第 %1 / %2 步    第 %3 行    %4 ms    调用深度 %5")
+                           .arg(step.index + 1)
+                           .arg(m_recording->stepCount())
+                           .arg(step.line)
+                           .arg(step.ns / 1e6, 0, 'f', 3)
+                           .arg(step.depth);
+    if (m_recording->isTruncated()) {
+        position += "    （录制文件达到上限，之后的执行没有记录）";
+    }
+    m_positionLabel->setText(position);
+
+    if (m_recording->hasLocals()) {
+        m_localsTree->clear();
+        QList<QTreeWidgetItem*> items;
+        items.reserve(step.locals.size());
+        for (const ExecutionRecording::Local& local : step.locals) {
+            QTreeWidgetItem* item = new QTreeWidgetItem(QStringList{local.name, local.value});
+            item->setToolTip(1, local.value);
+            if (local.changed) {
+                QFont font = item->font(0);
+                font.setBold(true);
+                item->setFont(0, font);
+                item->setFont(1, font);
+            }
+            items.append(item);
+        }
+        m_localsTree->addTopLevelItems(items);
+    }
+
+    m_backButton->setEnabled(index > 0);
+    m_forwardButton->setEnabled(index < m_slider->maximum());
+
+    m_line = step.line;
+    emit lineSelected(step.line);
+}
+
+void ReplayView::stepBackward()
+{
+    stopPlayback();
+    m_slider->setValue(m_slider->value() - 1);
+}
+
+void ReplayView::stepForward()
+{
+    stopPlayback();
+    m_slider->setValue(m_slider->value() + 1);
+}
+
+void ReplayView::previousHit()
+{
+    stopPlayback();
+    jumpToHit(false);
+}
+
+void ReplayView::nextHit()
+{
+    stopPlayback();
+    jumpToHit(true);
+}
+
+void ReplayView::togglePlayback()
+{
+    if (m_playTimer.isActive()) {
+        stopPlayback();
+        return;
+    }
+    if (!m_recording) {
+        return;
+    }
+
+    // 已在最后一步时从头播放
+    if (m_slider->value() >= m_slider->maximum()) {
+        m_slider->setValue(0);
+    }
+    m_playCarryNs = 0;
+    m_playClock.start();
+    m_playTimer.start();
+    m_playButton->setText("暂停");
+}
+
+void ReplayView::advancePlayback()
+{
+    // 按实际经过的时间计算前进的步数，定时器延迟或间隔小于一帧时一次前进多步
+    const qint64 stepNs = m_intervalSpin->value() * 1000000LL;
+    m_playCarryNs += m_playClock.restart() * 1000000LL;
+    const qint64 steps = m_playCarryNs / stepNs;
+    if (steps == 0) {
+        return;
+    }
+    m_playCarryNs -= steps * stepNs;
+
+    const qint64 target = qMin<qint64>(m_slider->value() + steps, m_slider->maximum());
+    m_slider->setValue(static_cast<int>(target));
+    if (target >= m_slider->maximum()) {
+        stopPlayback();
+    }
+}
+
+void ReplayView::stopPlayback()
+{
+    m_playTimer.stop();
+    m_playButton->setText("播放");
+}
+
+void ReplayView::jumpToHit(bool forward)
+{
+    if (!m_recording || m_line <= 0) {
+        return;
+    }
+    const qint64 index = m_recording->findLine(m_slider->value(), m_line, forward);
+    if (index >= 0 && index <= m_slider->maximum()) {
+        m_slider->setValue(static_cast<int>(index));
+    }
+}
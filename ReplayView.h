@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QWidget>
+
+#include <memory>
+
+class ExecutionRecording;
+class QLabel;
+class QPushButton;
+class QSlider;
+class QSpinBox;
+class QTreeWidget;
+
+/**
+ * @class ReplayView
+ * @brief 录制运行的回放面板
+ *
+ * 滑块对应录制中的每一步，拖动、单步前后移动或跳到当前行的上一次/下一次执行时，
+ * 从录制文件中解码这一步并发出lineSelected()，编辑器高亮对应的行；
+ * 录制了局部变量时同时列出当前栈帧的变量，这一步刚变化的变量加粗显示。
+ * 回放只读取录制文件，不重新运行代码。
+ *
+ * 播放按设定的每步间隔自动前进：代码在录制时全速运行，慢速观察执行过程只发生在回放中。
+ * 播放定时器按界面刷新率触发，每次按实际经过的时间前进若干步，间隔小于一帧时不会拖慢回放。
+ */
+class ReplayView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit ReplayView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 设置要回放的录制
+     * @param recording 录制结果，为空时清空面板
+     */
+    void setRecording(std::shared_ptr<ExecutionRecording> recording);
+
+    /**
+     * @brief 是否有可回放的录制
+     * @return bool 有返回true
+     */
+    bool hasRecording() const { return m_recording != nullptr; }
+
+    /**
+     * @brief 设置播放时每一步的间隔
+     * @param intervalMs 间隔毫秒数
+     */
+    void setStepInterval(int intervalMs);
+
+signals:
+    /**
+     * @brief 当前步所在的行变化
+     * @param line 行号（1-based）
+     */
+    void lineSelected(int line);
+
+    /**
+     * @brief 用户修改了每一步的间隔
+     * @param intervalMs 间隔毫秒数
+     */
+    void stepIntervalChanged(int intervalMs);
+
+private slots:
+    void showStep(int index);
+    void stepBackward();
+    void stepForward();
+    void previousHit();
+    void nextHit();
+    void togglePlayback();
+    void advancePlayback();
+
+private:
+    /**
+     * @brief 跳到当前行的上一次或下一次执行
+     * @param forward 向后查找
+     */
+    void jumpToHit(bool forward);
+
+    /**
+     * @brief 停止播放
+     */
+    void stopPlayback();
+
+private:
+    std::shared_ptr<ExecutionRecording> m_recording;
+    int                                 m_line = 0;   // 当前步所在的行
+
+    QTimer        m_playTimer;        // 按界面刷新率触发
+    QElapsedTimer m_playClock;        // 上一次前进以来经过的时间
+    qint64        m_playCarryNs = 0;  // 不足一步的剩余时间
+
+    QSlider*     m_slider            = nullptr;
+    QLabel*      m_positionLabel     = nullptr;
+    QPushButton* m_previousHitButton = nullptr;
+    QPushButton* m_backButton        = nullptr;
+    QPushButton* m_forwardButton     = nullptr;
+    QPushButton* m_nextHitButton     = nullptr;
+    QPushButton* m_playButton        = nullptr;
+    QSpinBox*    m_intervalSpin      = nullptr;
+    QTreeWidget* m_localsTree        = nullptr;
+};
@@ -0,0 +1,66 @@
+#include "RunMetricsLog.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+RunMetricsLog::RunMetricsLog(const QString& path)
+    : m_path(path)
+{
+}
+
+QJsonObject RunMetricsLog::toJson(const CodeRunner::RunSummary& summary,
+                                  const QString&                status,
+                                  const QString&                backend)
+{
+    QJsonObject record;
+    record["time"]              = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    record["status"]            = status;
+    record["backend"]           = backend;
+    record["elapsed_ns"]        = summary.elapsedNs;
+    record["cpu_ns"]            = summary.cpuNs;
+    record["compile_ns"]        = summary.compileNs;
+    record["trace_events"]      = summary.traceEvents;
+    record["trace_ns"]          = summary.traceNs;
+    record["ui_gil_wait_ns"]    = summary.uiGilWaitNs;
+    record["ui_gil_waits"]      = summary.uiGilWaits;
+    record["output_bytes"]      = summary.outputBytes;
+    record["output_lines"]      = summary.outputLines;
+    record["logpoint_hits"]     = summary.logpointHits;
+    record["logpoints_dropped"] = summary.logpointsDropped;
+    if (summary.abortLatencyNs >= 0) {
+        record["abort_latency_ns"] = summary.abortLatencyNs;
+    }
+
+    static const char* const budgetNames[] = {"", "wall_time", "cpu_time", "memory"};
+    if (summary.budgetExceeded > RunWatchdog::NoBudget && summary.budgetExceeded <= RunWatchdog::MemoryBudget) {
+        record["budget"] = budgetNames[summary.budgetExceeded];
+    }
+    return record;
+}
+
+bool RunMetricsLog::append(const QJsonObject& record)
+{
+    if (m_path.isEmpty()) {
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        if (!m_warned) {
+            qWarning() << "Cannot write run metrics to" << m_path << ":" << file.errorString();
+            m_warned = true;
+        }
+        return false;
+    }
+
+    // 整行一次写入，其他进程按行读取时不会看到半行
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    return file.write(line) == line.size();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CodeRunner.h"
+
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * @class RunMetricsLog
+ * @brief 把每次运行的指标按JSON Lines格式追加到文件
+ *
+ * 每次运行一行紧凑的JSON对象，字段与CodeRunner::RunSummary对应（时间为纳秒），
+ * 另外记录结束时刻、运行结果和执行后端，便于长期跟踪宿主程序和用户脚本的性能变化。
+ * 文件只追加不改写，每次写入时打开，外部工具可以随时读取或轮转。只在界面线程中使用。
+ */
+class RunMetricsLog
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param path 日志文件路径，为空时不写入
+     */
+    explicit RunMetricsLog(const QString& path = QString());
+
+    /**
+     * @brief 设置日志文件路径
+     * @param path 日志文件路径，为空时不写入
+     */
+    void setPath(const QString& path) { m_path = path; }
+
+    /**
+     * @brief 获取日志文件路径
+     * @return QString 文件路径
+     */
+    QString path() const { return m_path; }
+
+    /**
+     * @brief 把一次运行的指标转为JSON对象
+     * @param summary 运行汇总
+     * @param status 运行结果（ok、error、aborted、stopped、budget）
+     * @param backend 执行后端（thread、process）
+     * @return QJsonObject 一行日志的内容
+     */
+    static QJsonObject toJson(const CodeRunner::RunSummary& summary,
+                              const QString&                status,
+                              const QString&                backend);
+
+    /**
+     * @brief 追加一行日志
+     * @param record toJson()得到的对象
+     * @return bool 写入成功返回true，未设置路径时返回false
+     */
+    bool append(const QJsonObject& record);
+
+private:
+    QString m_path;
+    bool    m_warned = false;   // 写入失败只警告一次
+};
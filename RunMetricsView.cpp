@@ -0,0 +1,80 @@
+#include "RunMetricsView.h"
+
+#include <QDateTime>
+#include <QHeaderView>
+
+namespace {
+
+enum Column
+{
+    TimeColumn = 0,
+    StatusColumn,
+    WallColumn,
+    CpuColumn,
+    CompileColumn,
+    TraceEventsColumn,
+    TraceColumn,
+    GilWaitColumn,
+    OutputBytesColumn,
+    OutputLinesColumn,
+    ColumnCount
+};
+
+// 保留的运行次数
+const int kMaxRows = 200;
+
+QTableWidgetItem* numberItem(const QVariant& value)
+{
+    QTableWidgetItem* item = new QTableWidgetItem;
+    item->setData(Qt::DisplayRole, value);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+double roundedMs(qint64 ns)
+{
+    return qRound64(ns / 1000.0) / 1000.0;
+}
+
+}   // namespace
+
+RunMetricsView::RunMetricsView(QWidget* parent)
+    : QTableWidget(parent)
+{
+    setColumnCount(ColumnCount);
+    setHorizontalHeaderLabels({"时间",
+                               "结果",
+                               "墙钟时间(ms)",
+                               "CPU时间(ms)",
+                               "编译(ms)",
+                               "追踪事件",
+                               "追踪耗时(ms)",
+                               "界面GIL等待(ms)",
+                               "输出字节",
+                               "输出行数"});
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionBehavior(QAbstractItemView::SelectRows);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setWordWrap(false);
+    verticalHeader()->setVisible(false);
+    horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+}
+
+void RunMetricsView::addRun(const CodeRunner::RunSummary& summary, const QString& status)
+{
+    insertRow(0);
+    setItem(0, TimeColumn, new QTableWidgetItem(QTime::currentTime().toString("HH:mm:ss.zzz")));
+    setItem(0, StatusColumn, new QTableWidgetItem(status));
+    setItem(0, WallColumn, numberItem(roundedMs(summary.elapsedNs)));
+    setItem(0, CpuColumn, numberItem(roundedMs(summary.cpuNs)));
+    setItem(0, CompileColumn, numberItem(roundedMs(summary.compileNs)));
+    setItem(0, TraceEventsColumn, numberItem(summary.traceEvents));
+    setItem(0, TraceColumn, numberItem(roundedMs(summary.traceNs)));
+    setItem(0, GilWaitColumn, numberItem(roundedMs(summary.uiGilWaitNs)));
+    setItem(0, OutputBytesColumn, numberItem(summary.outputBytes));
+    setItem(0, OutputLinesColumn, numberItem(summary.outputLines));
+
+    if (rowCount() > kMaxRows) {
+        setRowCount(kMaxRows);
+    }
+}
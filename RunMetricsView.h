@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CodeRunner.h"
+
+#include <QTableWidget>
+
+/**
+ * @class RunMetricsView
+ * @brief 运行指标表格
+ *
+ * 每次运行一行，最新的运行在最上面：编译、墙钟和CPU时间，调试钩子处理的事件数和耗时，
+ * 界面线程等待GIL的时间，输出字节数和行数。最多保留最近200次运行。
+ */
+class RunMetricsView : public QTableWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit RunMetricsView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 添加一次运行的指标
+     * @param summary 运行汇总
+     * @param status 运行结果的显示文字
+     */
+    void addRun(const CodeRunner::RunSummary& summary, const QString& status);
+};
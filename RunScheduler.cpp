@@ -0,0 +1,172 @@
+#include "RunScheduler.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <chrono>
+
+// 单调时钟（纳秒），用于统计排队时间
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::shared_ptr<RunScheduler::Ticket> RunScheduler::submit(const Request& request)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_submitted;
+
+    // 同key的请求还在排队：合并为最新的一版
+    if (!request.key.isEmpty()) {
+        std::shared_ptr<Ticket> queued = m_queuedByKey.value(request.key);
+        if (queued) {
+            const Priority priority = std::max(queued->priority, request.priority);
+            if (priority != queued->priority) {
+                unlinkLocked(queued);
+                queued->priority = priority;
+                m_queues[priority].push_back(queued);
+            }
+            queued->request          = request;
+            queued->request.priority = priority;
+            ++queued->coalesced;
+            ++m_coalesced;
+            return queued;
+        }
+    }
+
+    std::shared_ptr<Ticket> ticket = std::make_shared<Ticket>();
+    ticket->id          = m_nextId++;
+    ticket->submittedNs = monotonicNs();
+    ticket->request     = request;
+    ticket->priority    = request.priority;
+
+    m_queues[request.priority].push_back(ticket);
+    m_queuedById.insert(ticket->id, ticket);
+    if (!request.key.isEmpty()) {
+        m_queuedByKey.insert(request.key, ticket);
+    }
+    return ticket;
+}
+
+RunScheduler::TicketState RunScheduler::cancel(int ticketId)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_active && m_active->id == ticketId) {
+        m_active->cancelRequested.store(true, std::memory_order_release);
+        return Running;
+    }
+
+    std::shared_ptr<Ticket> ticket = m_queuedById.value(ticketId);
+    if (!ticket) {
+        return Finished;
+    }
+    cancelLocked(ticket);
+    return Queued;
+}
+
+int RunScheduler::cancelQueued()
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QList<std::shared_ptr<Ticket>> tickets = m_queuedById.values();
+    for (const std::shared_ptr<Ticket>& ticket : tickets) {
+        cancelLocked(ticket);
+    }
+    return tickets.size();
+}
+
+std::shared_ptr<RunScheduler::Ticket> RunScheduler::begin(Request* request)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_active) {
+        return nullptr;
+    }
+
+    for (int priority = kPriorityCount - 1; priority >= 0; --priority) {
+        if (m_queues[priority].empty()) {
+            continue;
+        }
+
+        std::shared_ptr<Ticket> ticket = m_queues[priority].front();
+        m_queues[priority].pop_front();
+        m_queuedById.remove(ticket->id);
+        if (!ticket->request.key.isEmpty()) {
+            m_queuedByKey.remove(ticket->request.key);
+        }
+
+        ticket->startedNs = monotonicNs();
+        ticket->state     = Running;
+        m_active          = ticket;
+
+        const qint64 waitNs = ticket->startedNs - ticket->submittedNs;
+        ++m_started;
+        m_totalWaitNs += waitNs;
+        m_maxWaitNs  = std::max(m_maxWaitNs, waitNs);
+        m_lastWaitNs = waitNs;
+
+        *request = ticket->request;
+        return ticket;
+    }
+    return nullptr;
+}
+
+void RunScheduler::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_active) {
+        m_active->state = Finished;
+        m_active.reset();
+    }
+}
+
+int RunScheduler::depth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queuedById.size();
+}
+
+RunScheduler::Metrics RunScheduler::metrics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    Metrics metrics;
+    metrics.depth       = m_queuedById.size();
+    metrics.running     = m_active != nullptr;
+    metrics.submitted   = m_submitted;
+    metrics.started     = m_started;
+    metrics.coalesced   = m_coalesced;
+    metrics.cancelled   = m_cancelled;
+    metrics.totalWaitNs = m_totalWaitNs;
+    metrics.maxWaitNs   = m_maxWaitNs;
+    metrics.lastWaitNs  = m_lastWaitNs;
+
+    if (!m_queuedById.isEmpty()) {
+        const qint64 nowNs = monotonicNs();
+        for (const std::shared_ptr<Ticket>& ticket : m_queuedById) {
+            metrics.oldestQueuedNs = std::max(metrics.oldestQueuedNs, nowNs - ticket->submittedNs);
+        }
+    }
+    return metrics;
+}
+
+void RunScheduler::unlinkLocked(const std::shared_ptr<Ticket>& ticket)
+{
+    std::deque<std::shared_ptr<Ticket>>& queue = m_queues[ticket->priority];
+    queue.erase(std::remove(queue.begin(), queue.end(), ticket), queue.end());
+}
+
+void RunScheduler::cancelLocked(const std::shared_ptr<Ticket>& ticket)
+{
+    unlinkLocked(ticket);
+    m_queuedById.remove(ticket->id);
+    if (!ticket->request.key.isEmpty()) {
+        m_queuedByKey.remove(ticket->request.key);
+    }
+
+    ticket->cancelRequested.store(true, std::memory_order_release);
+    ticket->state = Cancelled;
+    ++m_cancelled;
+}
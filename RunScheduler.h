@@ -0,0 +1,186 @@
+#pragma once
+
+#include "RunWatchdog.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+/**
+ * @class RunScheduler
+ * @brief CodeRunner的运行请求队列
+ *
+ * 同一时刻只有一个请求处于运行状态，其余按优先级排队，同一优先级内先到先运行：
+ * - 带key的请求与队列中同key的请求合并：代码和选项换成最新的，保留原来的排队位置，
+ *   新请求优先级更高时移到该优先级的队尾；同一编辑缓冲区连续提交只运行最后一版
+ * - 每个请求返回一个票据，票据同时是取消令牌，排队中的请求取消后不再运行
+ * - 统计队列深度和排队时间
+ *
+ * 所有接口线程安全，不涉及Python，不需要持有GIL。
+ */
+class RunScheduler
+{
+public:
+    /**
+     * @brief 优先级（数值越大越先运行）
+     */
+    enum Priority
+    {
+        Background,    // 后台任务
+        Batch,         // 批量运行已保存的脚本
+        Interactive    // 用户在编辑器中发起的运行
+    };
+
+    /**
+     * @brief 票据状态
+     */
+    enum TicketState
+    {
+        Queued,      // 排队中
+        Running,     // 正在运行
+        Finished,    // 已运行结束
+        Cancelled    // 未运行即被取消
+    };
+
+    /**
+     * @brief 一次运行请求的内容
+     */
+    struct Request
+    {
+        QString              code;
+        QString              key;                   // 合并用的标识（如编辑缓冲区），为空时不合并
+        Priority             priority  = Interactive;
+        bool                 profiling = false;     // 逐行性能分析
+        bool                 sampling  = false;     // 采样分析
+        bool                 memory    = false;     // 内存统计
+        bool                 objects   = false;     // 对象存活诊断
+        bool                 recording = false;     // 录制行事件供回放
+        bool                 recordLocals = false;  // 录制时同时记录局部变量的变化
+        RunWatchdog::Budgets budgets;               // 时间和内存预算（默认不限制）
+    };
+
+    /**
+     * @brief 请求的票据和取消令牌
+     *
+     * request在排队期间可能被合并的新请求替换，只通过RunScheduler读取；开始运行后不再变化。
+     */
+    struct Ticket
+    {
+        int                      id = 0;
+        std::atomic<TicketState> state{Queued};
+        std::atomic<int>         coalesced{0};      // 合并进来的后续请求数
+        qint64                   submittedNs = 0;   // 首次提交时刻（单调时钟）
+        qint64                   startedNs   = 0;   // 开始运行时刻，未开始时为0
+
+        /**
+         * @brief 是否已取消或取消请求已经发出
+         * @return bool 已取消返回true
+         */
+        bool isCancelled() const { return cancelRequested.load(std::memory_order_acquire); }
+
+    private:
+        friend class RunScheduler;
+        Request           request;
+        Priority          priority = Interactive;   // 当前所在的队列
+        std::atomic<bool> cancelRequested{false};
+    };
+
+    /**
+     * @brief 队列统计
+     */
+    struct Metrics
+    {
+        int     depth          = 0;       // 排队中的请求数
+        bool    running        = false;   // 是否有请求正在运行
+        quint64 submitted      = 0;       // 提交次数（含被合并的）
+        quint64 started        = 0;       // 开始运行的请求数
+        quint64 coalesced      = 0;       // 被合并的提交次数
+        quint64 cancelled      = 0;       // 排队中被取消的请求数
+        qint64  totalWaitNs    = 0;       // 已开始请求的排队时间之和
+        qint64  maxWaitNs      = 0;       // 最长排队时间
+        qint64  lastWaitNs     = 0;       // 最近一个开始运行的请求的排队时间
+        qint64  oldestQueuedNs = 0;       // 队列中等待最久的请求已等待的时间
+    };
+
+    /**
+     * @brief 提交请求
+     * @param request 请求
+     * @return std::shared_ptr<Ticket> 票据；与排队中的请求合并时返回该请求的票据
+     */
+    std::shared_ptr<Ticket> submit(const Request& request);
+
+    /**
+     * @brief 取消请求
+     *
+     * 排队中的请求移出队列；正在运行的请求只标记取消请求，由调用方决定是否中止。
+     * @param ticketId 票据编号
+     * @return TicketState 取消时的状态，找不到票据时为Finished
+     */
+    TicketState cancel(int ticketId);
+
+    /**
+     * @brief 取消所有排队中的请求（正在运行的请求不受影响）
+     * @return int 取消的请求数
+     */
+    int cancelQueued();
+
+    /**
+     * @brief 没有请求正在运行时取出下一个请求并标记为运行状态
+     * @param request 输出请求内容
+     * @return std::shared_ptr<Ticket> 票据，队列为空或已有请求在运行时为空
+     */
+    std::shared_ptr<Ticket> begin(Request* request);
+
+    /**
+     * @brief 标记当前运行的请求已结束
+     */
+    void finish();
+
+    /**
+     * @brief 排队中的请求数
+     * @return int 请求数
+     */
+    int depth() const;
+
+    /**
+     * @brief 获取队列统计
+     * @return Metrics 统计快照
+     */
+    Metrics metrics() const;
+
+private:
+    /**
+     * @brief 把请求移出所在的队列（需持有m_mutex）
+     * @param ticket 票据
+     */
+    void unlinkLocked(const std::shared_ptr<Ticket>& ticket);
+
+    /**
+     * @brief 把排队中的请求标记为取消并移出队列（需持有m_mutex）
+     * @param ticket 票据
+     */
+    void cancelLocked(const std::shared_ptr<Ticket>& ticket);
+
+private:
+    static const int kPriorityCount = Interactive + 1;
+
+    mutable QMutex                          m_mutex;
+    std::deque<std::shared_ptr<Ticket>>     m_queues[kPriorityCount];   // 按优先级分开的队列
+    QHash<QString, std::shared_ptr<Ticket>> m_queuedByKey;              // 排队中带key的请求
+    QHash<int, std::shared_ptr<Ticket>>     m_queuedById;               // 所有排队中的请求
+    std::shared_ptr<Ticket>                 m_active;                   // 正在运行的请求
+    int                                     m_nextId = 1;
+
+    // 统计
+    quint64 m_submitted   = 0;
+    quint64 m_started     = 0;
+    quint64 m_coalesced   = 0;
+    quint64 m_cancelled   = 0;
+    qint64  m_totalWaitNs = 0;
+    qint64  m_maxWaitNs   = 0;
+    qint64  m_lastWaitNs  = 0;
+};
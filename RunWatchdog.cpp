@@ -0,0 +1,172 @@
+#include "RunWatchdog.h"
+#include "MemoryProfiler.h"
+
+#include <chrono>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <pthread.h>
+#else
+#include <pthread.h>
+#endif
+
+// 检查间隔
+static const int kCheckIntervalMs = 10;
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+RunWatchdog::~RunWatchdog()
+{
+    stop();
+}
+
+void RunWatchdog::start(const Budgets& budgets, PausedProbe paused, ExceededCallback onExceeded)
+{
+    stop();
+    m_exceeded.store(NoBudget, std::memory_order_release);
+    if (budgets.isEmpty()) {
+        return;
+    }
+
+    m_budgets    = budgets;
+    m_paused     = std::move(paused);
+    m_onExceeded = std::move(onExceeded);
+
+    // 其他线程读取运行线程的CPU时间需要该线程的句柄或时钟
+#if defined(Q_OS_WIN)
+    DuplicateHandle(GetCurrentProcess(),
+                    GetCurrentThread(),
+                    GetCurrentProcess(),
+                    &m_threadHandle,
+                    THREAD_QUERY_LIMITED_INFORMATION,
+                    FALSE,
+                    0);
+#elif defined(Q_OS_MACOS)
+    m_machThread = pthread_mach_thread_np(pthread_self());
+#else
+    m_hasCpuClock = pthread_getcpuclockid(pthread_self(), &m_cpuClock) == 0;
+#endif
+    m_startCpuNs    = runnerCpuNs();   // 无法读取时为-1，不检查CPU时间
+    m_startRssBytes = budgets.memoryMB > 0 ? MemoryProfiler::currentRssBytes() : 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+    }
+    m_thread = std::thread(&RunWatchdog::watchLoop, this);
+}
+
+void RunWatchdog::stop()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+
+#if defined(Q_OS_WIN)
+    if (m_threadHandle) {
+        CloseHandle(m_threadHandle);
+        m_threadHandle = nullptr;
+    }
+#endif
+}
+
+qint64 RunWatchdog::runnerCpuNs() const
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!m_threadHandle || !GetThreadTimes(m_threadHandle, &creation, &exit, &kernel, &user)) {
+        return -1;
+    }
+    // FILETIME以100纳秒为单位
+    const quint64 kernelTicks = (quint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const quint64 userTicks   = (quint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return static_cast<qint64>((kernelTicks + userTicks) * 100);
+#elif defined(Q_OS_MACOS)
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t   count = THREAD_BASIC_INFO_COUNT;
+    if (thread_info(m_machThread, THREAD_BASIC_INFO, reinterpret_cast<thread_info_t>(&info), &count)
+        != KERN_SUCCESS) {
+        return -1;
+    }
+    return (static_cast<qint64>(info.user_time.seconds) + info.system_time.seconds) * 1000000000 +
+           (static_cast<qint64>(info.user_time.microseconds) + info.system_time.microseconds) * 1000;
+#else
+    timespec ts;
+    if (!m_hasCpuClock || clock_gettime(m_cpuClock, &ts) != 0) {
+        return -1;
+    }
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void RunWatchdog::watchLoop()
+{
+    const qint64 wallLimitNs = m_budgets.wallMs * 1000000;
+    const qint64 cpuLimitNs  = m_budgets.cpuMs * 1000000;
+    const qint64 memoryLimit = m_budgets.memoryMB * 1024 * 1024;
+
+    qint64 activeNs = 0;   // 不含暂停的墙钟时间
+    qint64 lastNs   = monotonicNs();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(kCheckIntervalMs), [this]() { return m_stopping; });
+        if (m_stopping) {
+            break;
+        }
+
+        const qint64 nowNs = monotonicNs();
+        if (!m_paused || !m_paused()) {
+            activeNs += nowNs - lastNs;
+        }
+        lastNs = nowNs;
+
+        Budget budget = NoBudget;
+        if (wallLimitNs > 0 && activeNs > wallLimitNs) {
+            budget = WallTimeBudget;
+        }
+        else if (cpuLimitNs > 0 && m_startCpuNs >= 0 && runnerCpuNs() - m_startCpuNs > cpuLimitNs) {
+            budget = CpuTimeBudget;
+        }
+        else if (memoryLimit > 0 && MemoryProfiler::currentRssBytes() - m_startRssBytes > memoryLimit) {
+            budget = MemoryBudget;
+        }
+
+        if (budget != NoBudget) {
+            m_exceeded.store(budget, std::memory_order_release);
+            // 回调在锁外调用，其中可以安全地请求中止
+            lock.unlock();
+            m_onExceeded(budget);
+            return;
+        }
+    }
+}
+
+QString RunWatchdog::describe(Budget budget, const Budgets& budgets)
+{
+    switch (budget) {
+    case WallTimeBudget:
+        return QString("运行时间超出限制（%1 秒），已停止").arg(budgets.wallMs / 1000.0);
+    case CpuTimeBudget:
+        return QString("CPU时间超出限制（%1 秒），已停止").arg(budgets.cpuMs / 1000.0);
+    case MemoryBudget:
+        return QString("内存增长超出限制（%1 MB），已停止").arg(budgets.memoryMB);
+    case NoBudget:
+        break;
+    }
+    return QString();
+}
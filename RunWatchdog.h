@@ -0,0 +1,135 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MACOS)
+#include <time.h>
+#endif
+
+/**
+ * @class RunWatchdog
+ * @brief 单次运行的墙钟时间、CPU时间和内存预算监视
+ *
+ * start()在运行线程中调用，记录运行线程的CPU时钟和当前常驻内存，之后由独立线程每10毫秒检查一次：
+ * - 墙钟时间：暂停等待调试命令的时间不计入（停在断点上不会被判定超时）
+ * - CPU时间：运行线程自身消耗的CPU时间，time.sleep和等待I/O不计入
+ * - 内存：进程常驻内存相对运行开始时的增长
+ *
+ * 超出任一预算时调用一次回调（在监视线程中），之后不再检查；回调负责中止运行。
+ * 检查不需要GIL，也不需要追踪钩子；预算全部为0时不启动监视线程。
+ */
+class RunWatchdog
+{
+public:
+    /**
+     * @brief 超出的预算
+     */
+    enum Budget
+    {
+        NoBudget = 0,
+        WallTimeBudget,
+        CpuTimeBudget,
+        MemoryBudget
+    };
+
+    /**
+     * @brief 一次运行的预算，0表示不限制
+     */
+    struct Budgets
+    {
+        qint64 wallMs   = 0;   // 墙钟时间（毫秒）
+        qint64 cpuMs    = 0;   // 运行线程的CPU时间（毫秒）
+        qint64 memoryMB = 0;   // 常驻内存增长（MB）
+
+        bool isEmpty() const { return wallMs <= 0 && cpuMs <= 0 && memoryMB <= 0; }
+    };
+
+    /**
+     * @brief 超出预算时的回调（在监视线程中调用）
+     */
+    using ExceededCallback = std::function<void(Budget)>;
+
+    /**
+     * @brief 查询运行是否处于暂停状态（在监视线程中调用，需线程安全）
+     */
+    using PausedProbe = std::function<bool()>;
+
+    RunWatchdog() = default;
+
+    /**
+     * @brief 析构函数（停止监视线程）
+     */
+    ~RunWatchdog();
+
+    RunWatchdog(const RunWatchdog&)            = delete;
+    RunWatchdog& operator=(const RunWatchdog&) = delete;
+
+    /**
+     * @brief 开始监视（在运行线程中调用）
+     * @param budgets 预算，全部为0时不监视
+     * @param paused 暂停状态查询
+     * @param onExceeded 超出预算时的回调
+     */
+    void start(const Budgets& budgets, PausedProbe paused, ExceededCallback onExceeded);
+
+    /**
+     * @brief 停止监视，返回后不会再调用回调
+     */
+    void stop();
+
+    /**
+     * @brief 本次运行超出的预算（线程安全）
+     * @return Budget 未超出时为NoBudget
+     */
+    Budget exceeded() const { return m_exceeded.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 生成超出预算的错误信息
+     * @param budget 超出的预算
+     * @param budgets 本次运行的预算
+     * @return QString 错误信息
+     */
+    static QString describe(Budget budget, const Budgets& budgets);
+
+private:
+    /**
+     * @brief 监视线程主循环
+     */
+    void watchLoop();
+
+    /**
+     * @brief 读取运行线程已消耗的CPU时间（可在任意线程调用）
+     * @return qint64 纳秒，不支持时返回-1
+     */
+    qint64 runnerCpuNs() const;
+
+private:
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    bool                    m_stopping = false;   // 由m_mutex保护
+
+    Budgets             m_budgets;
+    PausedProbe         m_paused;
+    ExceededCallback    m_onExceeded;
+    std::atomic<Budget> m_exceeded{NoBudget};
+    qint64              m_startCpuNs    = 0;
+    qint64              m_startRssBytes = 0;
+
+    // 运行线程的CPU时钟句柄（平台相关，start()中获取）
+#if defined(Q_OS_WIN)
+    void* m_threadHandle = nullptr;
+#elif defined(Q_OS_MACOS)
+    unsigned int m_machThread = 0;   // mach_port_t
+#else
+    clockid_t m_cpuClock{};
+    bool      m_hasCpuClock = false;
+#endif
+};
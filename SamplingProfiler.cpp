@@ -0,0 +1,212 @@
+#include "SamplingProfiler.h"
+#include "PythonHandles.h"
+#include "PythonInterpreterManager.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+
+namespace py = pybind11;
+
+// 调用栈超过该深度时只保留最内层部分（例如失控的递归）
+static const int kMaxStackDepth = 512;
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+    if (isRunning()) {
+        stop();
+    }
+}
+
+void SamplingProfiler::start(PyThreadState* target, int rateHz)
+{
+    if (isRunning() || !target) {
+        return;
+    }
+
+    m_target     = target;
+    m_rateHz     = qBound(1, rateHz, 10000);
+    m_graph      = std::make_shared<FlameGraph>();
+    m_overheadNs = 0;
+    m_stopping   = false;
+    m_frameIds.clear();
+    m_truncatedFrame = -1;
+
+    // 运行线程在切换间隔到期后才响应GIL请求，间隔缩短到一个采样周期
+    try {
+        py::handle sys           = PythonHandles::current().sys;
+        m_previousSwitchInterval = sys.attr("getswitchinterval")();
+        const double period      = 1.0 / m_rateHz;
+        if (m_previousSwitchInterval.cast<double>() > period) {
+            sys.attr("setswitchinterval")(period);
+        }
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "Cannot adjust the GIL switch interval:" << e.what();
+        m_previousSwitchInterval = py::object();
+    }
+
+    m_startNs = monotonicNs();
+    m_thread  = std::thread(&SamplingProfiler::run, this, PyThreadState_GetInterpreter(target));
+}
+
+std::shared_ptr<FlameGraph> SamplingProfiler::stop()
+{
+    if (!isRunning()) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+
+    // 采样线程可能正在等待GIL
+    Py_BEGIN_ALLOW_THREADS
+    m_thread.join();
+    Py_END_ALLOW_THREADS
+
+    if (m_previousSwitchInterval) {
+        // 运行以异常结束时错误信息仍待调用者读取，先保存起来
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        try {
+            py::handle(PythonHandles::current().sys).attr("setswitchinterval")(m_previousSwitchInterval);
+        }
+        catch (py::error_already_set& e) {
+            qWarning() << "Cannot restore the GIL switch interval:" << e.what();
+        }
+        m_previousSwitchInterval = py::object();
+        PyErr_Restore(type, value, traceback);
+    }
+
+    for (PyObject* code : m_codeRefs) {
+        Py_DECREF(code);
+    }
+    m_codeRefs.clear();
+    m_frameIds.clear();
+    m_target = nullptr;
+
+    std::shared_ptr<FlameGraph> graph = std::move(m_graph);
+    graph->setTiming(m_rateHz, monotonicNs() - m_startNs, m_overheadNs);
+    return graph;
+}
+
+void SamplingProfiler::run(PyInterpreterState* interpreter)
+{
+    // 线程状态只创建一次，每次采样切换进出，避免PyGILState_Ensure反复创建和销毁
+    PyThreadState* threadState = PyThreadState_New(interpreter);
+
+    const auto period = std::chrono::nanoseconds(1000000000LL / m_rateHz);
+    auto       next   = std::chrono::steady_clock::now() + period;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wake.wait_until(lock, next, [this]() { return m_stopping; })) {
+        lock.unlock();
+
+        PyEval_RestoreThread(threadState);
+        const qint64 acquiredNs = monotonicNs();
+        sample();
+        m_overheadNs += monotonicNs() - acquiredNs;
+        PyEval_SaveThread();
+
+        // 等待GIL超过一个周期时不补采，按当前时间重新对齐
+        next += period;
+        const auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now + period;
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    PyEval_RestoreThread(threadState);
+    PyThreadState_Clear(threadState);
+    PyThreadState_DeleteCurrent();
+}
+
+void SamplingProfiler::sample()
+{
+    // 运行线程此时停在GIL切换点或正在等待（I/O、sleep），调用栈稳定
+    PyFrameObject* frame = PyThreadState_GetFrame(m_target);
+    if (!frame) {
+        return;
+    }
+
+    m_stack.clear();
+    while (frame) {
+        if (static_cast<int>(m_stack.size()) == kMaxStackDepth) {
+            if (m_truncatedFrame < 0) {
+                FlameGraph::Frame truncated;
+                truncated.name   = "[调用栈过深，已截断]";
+                m_truncatedFrame = m_graph->addFrame(truncated);
+            }
+            m_stack.push_back(m_truncatedFrame);
+            Py_DECREF(frame);
+            break;
+        }
+
+        PyCodeObject* code = PyFrame_GetCode(frame);
+        m_stack.push_back(frameId(code));
+        Py_DECREF(code);
+
+        PyFrameObject* back = PyFrame_GetBack(frame);
+        Py_DECREF(frame);
+        frame = back;
+    }
+
+    // 采集顺序是从内到外，采样树从最外层开始
+    std::reverse(m_stack.begin(), m_stack.end());
+    m_graph->addSample(m_stack.data(), static_cast<int>(m_stack.size()));
+}
+
+int SamplingProfiler::frameId(PyCodeObject* code)
+{
+    auto it = m_frameIds.constFind(code);
+    if (it != m_frameIds.constEnd()) {
+        return it.value();
+    }
+
+    PyObject* object = reinterpret_cast<PyObject*>(code);
+
+    // co_qualname从3.11开始提供，更早的版本使用co_name
+    const PythonHandles::Names& names = PythonHandles::current().names;
+    FlameGraph::Frame           info;
+    PyObject*                   name = PyObject_GetAttr(object, names.qualName);
+    if (!name) {
+        PyErr_Clear();
+        name = PyObject_GetAttr(object, names.codeName);
+    }
+    PyObject* file      = PyObject_GetAttr(object, names.fileName);
+    PyObject* firstLine = PyObject_GetAttr(object, names.firstLineNo);
+    if (name && PyUnicode_Check(name)) {
+        info.name = QString::fromUtf8(PyUnicode_AsUTF8(name));
+    }
+    if (file && PyUnicode_Check(file)) {
+        info.file = QString::fromUtf8(PyUnicode_AsUTF8(file));
+    }
+    if (firstLine && PyLong_Check(firstLine)) {
+        info.firstLine = static_cast<int>(PyLong_AsLong(firstLine));
+    }
+    info.userCode = info.file == QLatin1String(PythonInterpreterManager::editorFileName());
+    Py_XDECREF(name);
+    Py_XDECREF(file);
+    Py_XDECREF(firstLine);
+    PyErr_Clear();
+
+    const int id = m_graph->addFrame(info);
+    Py_INCREF(object);
+    m_codeRefs.push_back(object);
+    m_frameIds.insert(code, id);
+    return id;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "FlameGraph.h"
+
+#include <QHash>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+/**
+ * @class SamplingProfiler
+ * @brief 采样分析器：独立线程按固定频率抓取运行线程的Python调用栈
+ *
+ * 不安装追踪函数，运行线程执行的代码不受影响：
+ * - 采样线程有自己的线程状态，每次采样获取GIL，用PyThreadState_GetFrame读取目标线程的调用栈
+ *   （与sys._current_frames相同的做法），合并到FlameGraph后立即释放GIL
+ * - 运行线程只在GIL切换点让出执行，停顿时间就是采样线程持有GIL的时间，一般每次几微秒
+ * - 采样期间把sys.setswitchinterval缩短到一个采样周期，否则采样线程等待GIL的时间（默认5毫秒）
+ *   会把实际频率限制在200Hz左右；结束后恢复原值
+ *
+ * start()和stop()都在持有GIL的线程中调用。
+ */
+class SamplingProfiler
+{
+public:
+    SamplingProfiler() = default;
+
+    /**
+     * @brief 析构函数（仍在采样时停止采样，需持有GIL）
+     */
+    ~SamplingProfiler();
+
+    SamplingProfiler(const SamplingProfiler&)            = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    /**
+     * @brief 开始采样（需持有GIL）
+     * @param target 被采样的线程状态，停止采样前必须保持有效
+     * @param rateHz 每秒采样次数
+     */
+    void start(PyThreadState* target, int rateHz);
+
+    /**
+     * @brief 停止采样并取出结果（需持有GIL，等待采样线程结束期间临时释放）
+     * @return std::shared_ptr<FlameGraph> 采样结果，未开始采样时为空
+     */
+    std::shared_ptr<FlameGraph> stop();
+
+    /**
+     * @brief 是否正在采样
+     * @return bool 正在采样返回true
+     */
+    bool isRunning() const { return m_thread.joinable(); }
+
+private:
+    /**
+     * @brief 采样线程主循环
+     * @param interpreter 目标线程所属的解释器
+     */
+    void run(PyInterpreterState* interpreter);
+
+    /**
+     * @brief 抓取一次调用栈（采样线程中调用，需持有GIL）
+     */
+    void sample();
+
+    /**
+     * @brief 获取代码对象对应的函数编号，第一次见到时登记
+     * @param code 代码对象
+     * @return int 函数编号
+     */
+    int frameId(PyCodeObject* code);
+
+private:
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    bool                    m_stopping = false;   // 由m_mutex保护
+
+    PyThreadState*              m_target = nullptr;
+    int                         m_rateHz = 0;
+    std::shared_ptr<FlameGraph> m_graph;
+    qint64                      m_startNs    = 0;
+    qint64                      m_overheadNs = 0;   // 采样线程持有GIL的时间之和
+
+    // 代码对象到函数编号的映射；持有代码对象的引用，避免地址被复用
+    QHash<PyCodeObject*, int> m_frameIds;
+    std::vector<PyObject*>    m_codeRefs;
+    std::vector<int>          m_stack;   // 复用的调用栈缓冲区
+    int                       m_truncatedFrame = -1;
+
+    pybind11::object m_previousSwitchInterval;
+};
@@ -0,0 +1,105 @@
+#include "SaveService.h"
+
+#include <QSaveFile>
+
+SaveService::SaveService(QObject* parent)
+    : QObject(parent)
+{
+    m_thread = std::thread(&SaveService::workerLoop, this);
+}
+
+SaveService::~SaveService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool SaveService::isSaved(const QString& path, quint64 revision) const
+{
+    auto it = m_revisions.constFind(path);
+    return it != m_revisions.constEnd() && it.value() == revision;
+}
+
+void SaveService::markSaved(const QString& path, quint64 revision)
+{
+    m_revisions.insert(path, revision);
+}
+
+void SaveService::save(const QString& path, quint64 revision, const QString& text)
+{
+    m_revisions.insert(path, revision);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Job& job : m_jobs) {
+            if (job.path == path) {
+                job.revision = revision;
+                job.text     = text;
+                return;
+            }
+        }
+        m_jobs.push_back(Job{path, revision, text});
+    }
+    m_wake.notify_one();
+}
+
+bool SaveService::writeFile(const QString& path, const QString& text, QString* error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    const QByteArray data = text.toUtf8();
+    if (file.write(data) != data.size() || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+void SaveService::workerLoop()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return !m_jobs.empty() || m_stopping; });
+            // 停止时仍写完排队的文件
+            if (m_jobs.empty()) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        QString    error;
+        const bool ok = writeFile(job.path, job.text, &error);
+        QMetaObject::invokeMethod(
+            this,
+            [this, path = job.path, revision = job.revision, ok, error]() { onWritten(path, revision, ok, error); },
+            Qt::QueuedConnection);
+    }
+}
+
+void SaveService::onWritten(const QString& path, quint64 revision, bool ok, const QString& error)
+{
+    if (ok) {
+        emit saved(path);
+        return;
+    }
+
+    // 之后没有再提交新版本时清除记录，下次保存重试
+    if (isSaved(path, revision)) {
+        m_revisions.remove(path);
+    }
+    emit saveFailed(path, error);
+}
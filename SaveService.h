@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QtGlobal>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class SaveService
+ * @brief 在后台线程中保存文本文件
+ *
+ * 调用方为每个文件提供文本的版本号（编辑器每次修改加一），save()记下已提交的版本，
+ * isSaved()为true时调用方不必再取文本快照。写入在后台线程中通过QSaveFile完成：
+ * 先写临时文件再原子替换，写到一半失败或进程退出时原文件保持完整，界面线程不做文件I/O。
+ * 同一文件还在排队时再次保存只替换排队的文本，不会写两次。
+ *
+ * 写入失败时清除记下的版本（下次保存会重试）并发出saveFailed()。
+ * 析构时写完所有排队的文件再停止后台线程。除writeFile()外只在界面线程中调用。
+ */
+class SaveService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SaveService(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构函数（写完排队的文件后停止后台线程）
+     */
+    ~SaveService() override;
+
+    /**
+     * @brief 文件是否已保存（或已提交保存）为指定版本
+     * @param path 文件路径
+     * @param revision 文本版本
+     * @return bool 已保存返回true
+     */
+    bool isSaved(const QString& path, quint64 revision) const;
+
+    /**
+     * @brief 把文件记为已保存为指定版本（刚从该文件加载文本时调用）
+     * @param path 文件路径
+     * @param revision 文本版本
+     */
+    void markSaved(const QString& path, quint64 revision);
+
+    /**
+     * @brief 提交保存
+     * @param path 文件路径
+     * @param revision 文本版本
+     * @param text 文本快照
+     */
+    void save(const QString& path, quint64 revision, const QString& text);
+
+    /**
+     * @brief 以UTF-8原子地写入文件（在调用线程中完成）
+     * @param path 文件路径
+     * @param text 文本
+     * @param error 失败时输出原因，可以为nullptr
+     * @return bool 成功返回true
+     */
+    static bool writeFile(const QString& path, const QString& text, QString* error);
+
+signals:
+    /**
+     * @brief 文件已写入
+     * @param path 文件路径
+     */
+    void saved(const QString& path);
+
+    /**
+     * @brief 文件写入失败
+     * @param path 文件路径
+     * @param error 失败原因
+     */
+    void saveFailed(const QString& path, const QString& error);
+
+private:
+    // 一次排队的保存
+    struct Job
+    {
+        QString path;
+        quint64 revision = 0;
+        QString text;
+    };
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void workerLoop();
+
+    /**
+     * @brief 处理一次写入的结果（界面线程）
+     */
+    void onWritten(const QString& path, quint64 revision, bool ok, const QString& error);
+
+private:
+    QHash<QString, quint64> m_revisions;   // 每个文件已提交的版本，只在界面线程中访问
+
+    // 以下由m_mutex保护
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Job>         m_jobs;
+    bool                    m_stopping = false;
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtEndian>
+#include <QtGlobal>
+
+#include <cstring>
+
+/**
+ * @brief 执行服务与外部客户端之间的消息定义
+ *
+ * 客户端可能是任意语言编写的工具，所有整数一律按小端序编码，文本为UTF-8。每条消息一帧：
+ *
+ *     uint32 长度（其后的字节数，即 6 + 负载长度）
+ *     uint16 类型
+ *     uint32 标记（客户端为每条命令自选，服务端的回复和该次运行的事件原样带回）
+ *     负载
+ *
+ * 客户端可以不等回复连续发送多条命令（流水线），每条命令恰好有一条回复（Accepted、Ack、Pong或Rejected），
+ * 回复按命令的顺序发出；运行开始后的事件穿插在回复之间，用标记区分属于哪次运行。
+ */
+namespace ServerProtocol
+{
+
+// 帧头字节数（长度 + 类型 + 标记）
+static const int kHeaderSize = 10;
+
+// 单帧负载的上限，超出时断开连接
+static const int kMaxPayload = 64 * 1024 * 1024;
+
+/**
+ * @brief 消息类型
+ */
+enum Message : quint16
+{
+    // 客户端 -> 服务端
+    Run = 1,          // 负载：UTF-8代码；回复Accepted
+    Abort,            // 负载：int32 运行编号；中止运行或取消排队，回复Ack
+    SetBreakpoints,   // 负载：uint32 个数，每个断点为 int32 行号 + 三段文本（条件、命中次数、日志消息），
+                      //      每段文本为 uint32 字节数 + UTF-8；回复Ack
+    Continue,         // 暂停时继续运行；回复Ack
+    StepInto,
+    StepOver,
+    StepOut,
+    Ping,             // 负载任意，原样放在Pong中返回，用于测量往返延迟
+
+    // 服务端 -> 客户端
+    Accepted = 100,   // 负载：int32 运行编号（用于Abort）
+    Ack,              // 负载为空
+    Pong,             // 负载：Ping的负载
+    Rejected,         // 负载：UTF-8错误信息（未知命令或负载格式错误）
+    Started,          // 运行开始；负载：int64 排队纳秒数
+    Output,           // 负载：uint8 流（0标准输出、1标准错误、2日志）+ UTF-8文本
+    Line,             // 负载：int32 当前执行行（按刷新率采样）
+    Paused,           // 在断点或单步处暂停；负载：int32 行号
+    Error,            // 负载：UTF-8错误信息（Python异常或超出预算）
+    Finished          // 运行结束（之后不再有该标记的事件）；负载：FinishedPayload
+};
+
+/**
+ * @brief 运行结束的状态
+ */
+enum Status : quint8
+{
+    Succeeded = 0,
+    Failed,       // Python异常或超出预算
+    Aborted,      // 运行中被中止
+    Cancelled     // 排队中被取消，没有运行
+};
+
+/**
+ * @brief Finished的负载（小端序，共17字节）
+ */
+struct FinishedPayload
+{
+    quint8 status    = Succeeded;
+    qint64 queueNs   = 0;   // 从提交到开始运行的时间
+    qint64 elapsedNs = 0;   // 运行耗时
+};
+
+/**
+ * @brief 编码一帧
+ * @param type 消息类型
+ * @param tag 标记
+ * @param payload 负载
+ * @return QByteArray 完整的帧
+ */
+inline QByteArray encodeFrame(quint16 type, quint32 tag, const QByteArray& payload = QByteArray())
+{
+    QByteArray frame(kHeaderSize + payload.size(), Qt::Uninitialized);
+    uchar*     data = reinterpret_cast<uchar*>(frame.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(6 + payload.size()), data);
+    qToLittleEndian<quint16>(type, data + 4);
+    qToLittleEndian<quint32>(tag, data + 6);
+    memcpy(data + kHeaderSize, payload.constData(), static_cast<size_t>(payload.size()));
+    return frame;
+}
+
+/**
+ * @brief 从缓冲区开头取出一帧
+ * @param buffer 已收到的字节，取出的帧从中移除
+ * @param type 输出消息类型
+ * @param tag 输出标记
+ * @param payload 输出负载
+ * @return int 取出一帧返回1，数据不完整返回0，帧长度非法返回-1
+ */
+inline int takeFrame(QByteArray* buffer, quint16* type, quint32* tag, QByteArray* payload)
+{
+    if (buffer->size() < kHeaderSize) {
+        return 0;
+    }
+    const uchar*  data   = reinterpret_cast<const uchar*>(buffer->constData());
+    const quint32 length = qFromLittleEndian<quint32>(data);
+    if (length < 6 || length - 6 > static_cast<quint32>(kMaxPayload)) {
+        return -1;
+    }
+    if (static_cast<quint32>(buffer->size()) < 4 + length) {
+        return 0;
+    }
+    *type    = qFromLittleEndian<quint16>(data + 4);
+    *tag     = qFromLittleEndian<quint32>(data + 6);
+    *payload = buffer->mid(kHeaderSize, static_cast<int>(length) - 6);
+    buffer->remove(0, static_cast<int>(4 + length));
+    return 1;
+}
+
+/**
+ * @brief 编码小端序整数
+ * @param value 整数
+ * @return QByteArray 负载
+ */
+template <typename T>
+inline QByteArray encodeInteger(T value)
+{
+    QByteArray bytes(static_cast<int>(sizeof(T)), Qt::Uninitialized);
+    qToLittleEndian<T>(value, reinterpret_cast<uchar*>(bytes.data()));
+    return bytes;
+}
+
+/**
+ * @brief 编码Finished的负载
+ * @param finished 运行结果
+ * @return QByteArray 负载
+ */
+inline QByteArray encodeFinished(const FinishedPayload& finished)
+{
+    return encodeInteger<quint8>(finished.status) + encodeInteger<qint64>(finished.queueNs) +
+           encodeInteger<qint64>(finished.elapsedNs);
+}
+
+/**
+ * @brief 按顺序读取负载中的小端序整数和文本
+ */
+class PayloadReader
+{
+public:
+    explicit PayloadReader(const QByteArray& payload)
+        : m_payload(payload)
+    {}
+
+    /**
+     * @brief 读取一个整数
+     * @param value 输出参数
+     * @return bool 剩余字节足够返回true
+     */
+    template <typename T>
+    bool read(T* value)
+    {
+        if (m_payload.size() - m_offset < static_cast<int>(sizeof(T))) {
+            return false;
+        }
+        *value = qFromLittleEndian<T>(reinterpret_cast<const uchar*>(m_payload.constData()) + m_offset);
+        m_offset += static_cast<int>(sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief 读取一段 uint32 字节数 + UTF-8 的文本
+     * @param text 输出参数
+     * @return bool 剩余字节足够返回true
+     */
+    bool readText(QString* text)
+    {
+        quint32 size = 0;
+        if (!read(&size) || static_cast<quint32>(m_payload.size() - m_offset) < size) {
+            return false;
+        }
+        *text = QString::fromUtf8(m_payload.constData() + m_offset, static_cast<int>(size));
+        m_offset += static_cast<int>(size);
+        return true;
+    }
+
+    /**
+     * @brief 是否已读完全部负载
+     */
+    bool atEnd() const { return m_offset == m_payload.size(); }
+
+private:
+    const QByteArray& m_payload;
+    int               m_offset = 0;
+};
+
+}   // namespace ServerProtocol
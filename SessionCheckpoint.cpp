@@ -0,0 +1,289 @@
+#include "SessionCheckpoint.h"
+
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+// 头部：8字节标识、版本号、变量数、索引偏移（小端）
+static const char    kMagic[8]   = {'Q', 'P', 'Y', 'S', 'E', 'S', 'S', '\0'};
+static const quint32 kVersion    = 1;
+static const qint64  kHeaderSize = 24;
+
+// 索引项的定长部分：类型、名字长度、偏移、长度
+static const qint64 kEntryFixedSize = 1 + 4 + 8 + 8;
+
+// pickle写出的数据块达到这个大小时，写文件期间释放GIL
+static const qint64 kReleaseBytes = 64 * 1024;
+
+// 函数、类和它们的实例属于__main__时只能按引用序列化，恢复时找不到定义
+static bool definedInMain(PyObject* value)
+{
+    PyObject* owner  = PyFunction_Check(value) || PyType_Check(value) ? value : reinterpret_cast<PyObject*>(Py_TYPE(value));
+    PyObject* module = PyObject_GetAttrString(owner, "__module__");
+    if (!module) {
+        PyErr_Clear();
+        return false;
+    }
+    const bool result = PyUnicode_Check(module) && PyUnicode_CompareWithASCIIString(module, "__main__") == 0;
+    Py_DECREF(module);
+    return result;
+}
+
+SessionCheckpoint::~SessionCheckpoint()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+}
+
+SessionCheckpoint::Summary SessionCheckpoint::save(PyObject* globals, const QString& path)
+{
+    Summary       summary;
+    QElapsedTimer timer;
+    timer.start();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QByteArray(kHeaderSize, '\0')) != kHeaderSize) {
+        summary.error = QString("无法写入会话检查点%1：%2").arg(path, file.errorString());
+        return summary;
+    }
+
+    // pickle直接写入文件，大块数据（NumPy数组的缓冲区等）不复制
+    bool                   writeFailed = false;
+    const py::cpp_function write([&file, &writeFailed](py::handle data) -> Py_ssize_t {
+        Py_buffer view;
+        if (PyObject_GetBuffer(data.ptr(), &view, PyBUF_SIMPLE) < 0) {
+            throw py::error_already_set();
+        }
+        qint64 written = 0;
+        if (view.len >= kReleaseBytes) {
+            py::gil_scoped_release release;
+            written = file.write(static_cast<const char*>(view.buf), view.len);
+        }
+        else {
+            written = file.write(static_cast<const char*>(view.buf), view.len);
+        }
+        const Py_ssize_t length = view.len;
+        PyBuffer_Release(&view);
+
+        if (written != length) {
+            writeFailed = true;
+            PyErr_SetString(PyExc_OSError, "cannot write session checkpoint");
+            throw py::error_already_set();
+        }
+        return length;
+    });
+    const py::object writer  = py::module_::import("types").attr("SimpleNamespace")(py::arg("write") = write);
+    const py::object pickler = py::module_::import("pickle").attr("Pickler");
+
+    // 先取快照，释放GIL期间命名空间可能变化
+    const py::list items = py::reinterpret_steal<py::list>(PyDict_Items(globals));
+    QVector<Entry> entries;
+    for (const py::handle item : items) {
+        PyObject* key   = PyTuple_GET_ITEM(item.ptr(), 0);
+        PyObject* value = PyTuple_GET_ITEM(item.ptr(), 1);
+        if (!PyUnicode_Check(key)) {
+            continue;
+        }
+        const char* utf8 = PyUnicode_AsUTF8(key);
+        if (!utf8) {
+            PyErr_Clear();
+            continue;
+        }
+        Entry entry;
+        entry.name = QString::fromUtf8(utf8);
+        if (entry.name.startsWith("__") && entry.name.endsWith("__")) {
+            continue;
+        }
+        entry.offset = file.pos();
+
+        if (PyModule_Check(value)) {
+            const char* moduleName = PyModule_GetName(value);
+            if (!moduleName) {
+                PyErr_Clear();
+                summary.skipped << entry.name;
+                continue;
+            }
+            entry.kind = Module;
+            file.write(moduleName, static_cast<qint64>(strlen(moduleName)));
+        }
+        else if (definedInMain(value)) {
+            summary.skipped << entry.name;
+            continue;
+        }
+        else {
+            try {
+                pickler(writer, 5).attr("dump")(py::handle(value));
+            }
+            catch (const py::error_already_set&) {
+                if (writeFailed) {
+                    break;
+                }
+                // 丢弃写了一半的数据
+                file.seek(entry.offset);
+                summary.skipped << entry.name;
+                continue;
+            }
+        }
+        entry.size = file.pos() - entry.offset;
+        entries.append(entry);
+
+        // 变量之间让出GIL
+        {
+            py::gil_scoped_release release;
+        }
+    }
+
+    if (writeFailed) {
+        summary.error = QString("无法写入会话检查点%1：%2").arg(path, file.errorString());
+        file.cancelWriting();
+        return summary;
+    }
+
+    // 索引写在数据之后，头部最后写入
+    const qint64 indexOffset = file.pos();
+    QByteArray   index;
+    for (const Entry& entry : entries) {
+        const QByteArray name = entry.name.toUtf8();
+        uchar            fixed[kEntryFixedSize];
+        fixed[0] = entry.kind;
+        qToLittleEndian<quint32>(static_cast<quint32>(name.size()), fixed + 1);
+        qToLittleEndian<quint64>(static_cast<quint64>(entry.offset), fixed + 5);
+        qToLittleEndian<quint64>(static_cast<quint64>(entry.size), fixed + 13);
+        index.append(reinterpret_cast<const char*>(fixed), kEntryFixedSize);
+        index.append(name);
+    }
+
+    uchar header[kHeaderSize];
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian<quint32>(kVersion, header + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(entries.size()), header + 12);
+    qToLittleEndian<quint64>(static_cast<quint64>(indexOffset), header + 16);
+
+    if (file.write(index) != index.size() || !file.seek(0) ||
+        file.write(reinterpret_cast<const char*>(header), kHeaderSize) != kHeaderSize || !file.commit()) {
+        summary.error = QString("无法写入会话检查点%1：%2").arg(path, file.errorString());
+        return summary;
+    }
+
+    summary.count     = entries.size();
+    summary.bytes     = indexOffset + index.size();
+    summary.elapsedNs = timer.nsecsElapsed();
+    return summary;
+}
+
+std::shared_ptr<SessionCheckpoint> SessionCheckpoint::open(const QString& path, QString* error)
+{
+    std::shared_ptr<SessionCheckpoint> checkpoint(new SessionCheckpoint);
+    checkpoint->m_file.setFileName(path);
+    if (!checkpoint->m_file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开会话检查点%1：%2").arg(path, checkpoint->m_file.errorString());
+        return nullptr;
+    }
+
+    checkpoint->m_size = checkpoint->m_file.size();
+    if (checkpoint->m_size < kHeaderSize) {
+        *error = QString("会话检查点%1不完整").arg(path);
+        return nullptr;
+    }
+    checkpoint->m_data = checkpoint->m_file.map(0, checkpoint->m_size);
+    if (!checkpoint->m_data) {
+        *error = QString("无法映射会话检查点%1：%2").arg(path, checkpoint->m_file.errorString());
+        return nullptr;
+    }
+
+    const uchar* data = checkpoint->m_data;
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || qFromLittleEndian<quint32>(data + 8) != kVersion) {
+        *error = QString("%1不是会话检查点或版本不受支持").arg(path);
+        return nullptr;
+    }
+    const quint32 count       = qFromLittleEndian<quint32>(data + 12);
+    const quint64 indexOffset = qFromLittleEndian<quint64>(data + 16);
+
+    // 只读取索引，变量数据在恢复时才访问
+    qint64 offset = static_cast<qint64>(indexOffset);
+    if (indexOffset < static_cast<quint64>(kHeaderSize) || offset > checkpoint->m_size) {
+        *error = QString("会话检查点%1已损坏").arg(path);
+        return nullptr;
+    }
+    checkpoint->m_entries.reserve(static_cast<int>(qMin<quint64>(count, 65536)));
+    for (quint32 i = 0; i < count; ++i) {
+        if (checkpoint->m_size - offset < kEntryFixedSize) {
+            *error = QString("会话检查点%1已损坏").arg(path);
+            return nullptr;
+        }
+        Entry entry;
+        entry.kind                = data[offset] == Module ? Module : Pickled;
+        const quint32 nameLength  = qFromLittleEndian<quint32>(data + offset + 1);
+        entry.offset              = static_cast<qint64>(qFromLittleEndian<quint64>(data + offset + 5));
+        entry.size                = static_cast<qint64>(qFromLittleEndian<quint64>(data + offset + 13));
+        offset                   += kEntryFixedSize;
+
+        if (checkpoint->m_size - offset < nameLength || entry.offset < kHeaderSize || entry.size < 0 ||
+            entry.offset > static_cast<qint64>(indexOffset) - entry.size) {
+            *error = QString("会话检查点%1已损坏").arg(path);
+            return nullptr;
+        }
+        entry.name = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), static_cast<int>(nameLength));
+        offset += nameLength;
+        checkpoint->m_entries.append(entry);
+    }
+    return checkpoint;
+}
+
+SessionCheckpoint::Summary SessionCheckpoint::restore(PyObject* globals) const
+{
+    Summary       summary;
+    QElapsedTimer timer;
+    timer.start();
+
+    const py::object loads        = py::module_::import("pickle").attr("loads");
+    const py::object importModule = py::module_::import("importlib").attr("import_module");
+
+    for (const Entry& entry : m_entries) {
+        char* data = reinterpret_cast<char*>(const_cast<uchar*>(m_data)) + entry.offset;
+        try {
+            py::object value;
+            if (entry.kind == Module) {
+                value = importModule(py::str(data, static_cast<size_t>(entry.size)));
+            }
+            else {
+                // 直接从映射的内存反序列化；视图在文件解除映射前释放
+                py::object view = py::reinterpret_steal<py::object>(
+                    PyMemoryView_FromMemory(data, static_cast<Py_ssize_t>(entry.size), PyBUF_READ));
+                if (!view) {
+                    throw py::error_already_set();
+                }
+                try {
+                    value = loads(view);
+                }
+                catch (...) {
+                    view.attr("release")();
+                    throw;
+                }
+                view.attr("release")();
+            }
+
+            const py::str name(entry.name.toStdString());
+            if (PyDict_SetItem(globals, name.ptr(), value.ptr()) < 0) {
+                throw py::error_already_set();
+            }
+            ++summary.count;
+            summary.bytes += entry.size;
+        }
+        catch (const py::error_already_set&) {
+            summary.skipped << entry.name;
+        }
+    }
+
+    summary.elapsedNs = timer.nsecsElapsed();
+    return summary;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Python.h>
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+#include <memory>
+
+/**
+ * @class SessionCheckpoint
+ * @brief 会话命名空间的检查点：保存可序列化的变量，下次启动时从映射的文件恢复
+ *
+ * 保存时逐个变量用pickle（协议5）直接写入文件，大块数据（NumPy数组、bytes）不经过中间缓冲区，
+ * 写文件期间释放GIL；变量之间也释放GIL，在后台线程保存时界面线程不会长时间等待。
+ * 模块只记录名字，恢复时重新导入；`__main__`中定义的函数和类无法按引用恢复，不保存；
+ * 不能序列化的变量跳过并报告名字。每个变量单独序列化，多个变量共享的对象恢复后各有一份。
+ * 文件先写到临时文件，完整写完后才替换旧的检查点。
+ *
+ * 恢复时只读映射文件，每个变量直接从映射的内存反序列化，不需要重新运行产生它们的代码。
+ * 单个变量恢复失败（如依赖已删除的模块）时跳过，其余变量照常恢复。
+ */
+class SessionCheckpoint
+{
+public:
+    /**
+     * @brief 保存或恢复的结果
+     */
+    struct Summary
+    {
+        int         count = 0;    // 保存或恢复的变量数
+        QStringList skipped;      // 跳过的变量名
+        qint64      bytes     = 0;
+        qint64      elapsedNs = 0;
+        QString     error;        // 文件错误，为空表示成功
+    };
+
+    ~SessionCheckpoint();
+
+    SessionCheckpoint(const SessionCheckpoint&)            = delete;
+    SessionCheckpoint& operator=(const SessionCheckpoint&) = delete;
+
+    /**
+     * @brief 把命名空间中的变量写入检查点文件（需持有GIL，期间会暂时释放）
+     * @param globals 命名空间字典
+     * @param path 文件路径
+     * @return Summary 保存结果
+     */
+    static Summary save(PyObject* globals, const QString& path);
+
+    /**
+     * @brief 打开并映射检查点文件，只读取索引（不需要GIL）
+     * @param path 文件路径
+     * @param error 失败时写入原因
+     * @return std::shared_ptr<SessionCheckpoint> 文件不存在或格式不对时为空
+     */
+    static std::shared_ptr<SessionCheckpoint> open(const QString& path, QString* error);
+
+    /**
+     * @brief 把检查点中的变量恢复到命名空间（需持有GIL）
+     * @param globals 命名空间字典，已有的同名变量被覆盖
+     * @return Summary 恢复结果
+     */
+    Summary restore(PyObject* globals) const;
+
+    /**
+     * @brief 检查点中的变量数
+     * @return int 数量
+     */
+    int count() const { return m_entries.size(); }
+
+private:
+    SessionCheckpoint() = default;
+
+    // 变量的保存方式
+    enum Kind : quint8
+    {
+        Pickled = 0,   // pickle数据
+        Module  = 1    // 模块名（UTF-8）
+    };
+
+    // 索引中的一项
+    struct Entry
+    {
+        QString name;
+        Kind    kind   = Pickled;
+        qint64  offset = 0;
+        qint64  size   = 0;
+    };
+
+    QFile          m_file;
+    const uchar*   m_data = nullptr;
+    qint64         m_size = 0;
+    QVector<Entry> m_entries;
+};
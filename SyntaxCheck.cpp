@@ -0,0 +1,151 @@
+#include "SyntaxCheck.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+#include <pybind11/eval.h>
+
+namespace py = pybind11;
+
+// Python侧的检查函数
+//
+// 返回(行, 起始列, 结束列, 严重程度, 信息)的列表，结束列为-1表示到行尾，严重程度0为错误、1为警告。
+static const char* const kCheckerSource = R"(
+import ast
+import warnings
+
+
+def check(source):
+    results = []
+    tree = None
+    with warnings.catch_warnings(record=True) as caught:
+        warnings.simplefilter('always')
+        try:
+            tree = compile(source, '<editor>', 'exec', ast.PyCF_ONLY_AST)
+            compile(tree, '<editor>', 'exec')
+        except SyntaxError as error:
+            line = error.lineno or 1
+            column = max((error.offset or 1) - 1, 0)
+            end = getattr(error, 'end_offset', None)
+            same_line = getattr(error, 'end_lineno', None) == line
+            end_column = end - 1 if end and same_line and end - 1 > column else -1
+            results.append((line, column, end_column, 0, error.msg))
+            tree = None
+        except (ValueError, OverflowError) as error:
+            results.append((1, 0, -1, 0, str(error)))
+            tree = None
+    for warning in caught:
+        if issubclass(warning.category, (SyntaxWarning, DeprecationWarning)):
+            results.append((warning.lineno or 1, 0, -1, 1, str(warning.message)))
+
+    if tree is not None:
+        try:
+            from pyflakes import checker
+        except ImportError:
+            checker = None
+        if checker is not None:
+            for message in checker.Checker(tree, filename='<editor>').messages:
+                results.append((message.lineno, message.col, -1, 1,
+                                message.message % message.message_args))
+    return results
+)";
+
+SyntaxCheck::~SyntaxCheck()
+{
+    if (!m_checker) {
+        return;
+    }
+    if (!Py_IsInitialized()) {
+        m_checker.release();
+        return;
+    }
+    py::gil_scoped_acquire acquire;
+    m_checker = py::object();
+}
+
+QVector<SyntaxCheck::Diagnostic> SyntaxCheck::check(const QString& code)
+{
+    QVector<Diagnostic> diagnostics;
+    try {
+        if (!m_checker) {
+            py::dict scope;
+            scope["__name__"]     = "qt_syntax_check";
+            scope["__builtins__"] = py::module_::import("builtins");
+            py::exec(kCheckerSource, scope);
+            m_checker = scope["check"];
+        }
+
+        py::list results = m_checker(code.toStdString());
+        for (py::handle item : results) {
+            py::tuple  tuple = py::reinterpret_borrow<py::tuple>(item);
+            Diagnostic diagnostic;
+            diagnostic.line      = qMax(1, tuple[0].cast<int>());
+            diagnostic.column    = qMax(0, tuple[1].cast<int>());
+            diagnostic.endColumn = tuple[2].cast<int>();
+            diagnostic.severity  = tuple[3].cast<int>() == 0 ? Error : Warning;
+            diagnostic.message   = QString::fromStdString(tuple[4].cast<std::string>());
+            diagnostics.append(diagnostic);
+        }
+    }
+    catch (py::error_already_set& e) {
+        // 检查器自身出错（如pyflakes版本不兼容）时不报告诊断
+        qWarning() << "Syntax check failed:" << e.what();
+        diagnostics.clear();
+    }
+    catch (py::cast_error& e) {
+        qWarning() << "Syntax check failed:" << e.what();
+        diagnostics.clear();
+    }
+    return diagnostics;
+}
+
+QByteArray SyntaxCheck::encodeRequest(quint64 id, const QString& code)
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << id << code;
+    return payload;
+}
+
+bool SyntaxCheck::decodeRequest(const QByteArray& payload, quint64* id, QString* code)
+{
+    QDataStream stream(payload);
+    stream >> *id >> *code;
+    return stream.status() == QDataStream::Ok;
+}
+
+QByteArray SyntaxCheck::encode(quint64 id, const QVector<Diagnostic>& diagnostics)
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << id << static_cast<qint32>(diagnostics.size());
+    for (const Diagnostic& diagnostic : diagnostics) {
+        stream << static_cast<qint32>(diagnostic.line) << static_cast<qint32>(diagnostic.column)
+               << static_cast<qint32>(diagnostic.endColumn) << static_cast<quint8>(diagnostic.severity)
+               << diagnostic.message;
+    }
+    return payload;
+}
+
+bool SyntaxCheck::decode(const QByteArray& payload, quint64* id, QVector<Diagnostic>* diagnostics)
+{
+    QDataStream stream(payload);
+    qint32      count = 0;
+    stream >> *id >> count;
+
+    diagnostics->clear();
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        qint32     line      = 0;
+        qint32     column    = 0;
+        qint32     endColumn = 0;
+        quint8     severity  = 0;
+        Diagnostic diagnostic;
+        stream >> line >> column >> endColumn >> severity >> diagnostic.message;
+        diagnostic.line      = line;
+        diagnostic.column    = column;
+        diagnostic.endColumn = endColumn;
+        diagnostic.severity  = severity == Error ? Error : Warning;
+        diagnostics->append(diagnostic);
+    }
+    return stream.status() == QDataStream::Ok;
+}
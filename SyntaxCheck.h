@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+/**
+ * @class SyntaxCheck
+ * @brief 编译检查代码，给出语法错误和警告
+ *
+ * 代码先解析为AST再编译，报告SyntaxError（含行列范围）和编译期间的SyntaxWarning、
+ * DeprecationWarning（如无效的转义序列、字面量用is比较）；安装了pyflakes时
+ * 再对AST做静态检查（未定义的名字、未使用的导入等），作为警告报告。代码不会被执行。
+ *
+ * 检查在诊断进程（见DiagnosticsService）中运行，不与运行用户代码的解释器争抢GIL。
+ * check()在持有GIL的线程中调用。
+ */
+class SyntaxCheck
+{
+public:
+    /**
+     * @brief 严重程度
+     */
+    enum Severity : quint8
+    {
+        Error = 0,
+        Warning
+    };
+
+    /**
+     * @brief 一条诊断
+     */
+    struct Diagnostic
+    {
+        int      line      = 1;       // 行号，1-based
+        int      column    = 0;       // 起始列
+        int      endColumn = -1;      // 结束列（不含），-1表示到行尾
+        Severity severity  = Error;
+        QString  message;
+    };
+
+    SyntaxCheck() = default;
+
+    /**
+     * @brief 析构函数（释放Python侧对象，需要时获取GIL）
+     */
+    ~SyntaxCheck();
+
+    SyntaxCheck(const SyntaxCheck&)            = delete;
+    SyntaxCheck& operator=(const SyntaxCheck&) = delete;
+
+    /**
+     * @brief 检查代码
+     * @param code 代码
+     * @return QVector<Diagnostic> 诊断，按报告顺序排列
+     */
+    QVector<Diagnostic> check(const QString& code);
+
+    /**
+     * @brief 编码检查请求（主进程发给诊断进程）
+     * @param id 请求编号
+     * @param code 代码
+     * @return QByteArray 负载
+     */
+    static QByteArray encodeRequest(quint64 id, const QString& code);
+
+    /**
+     * @brief 解码检查请求
+     * @param payload 负载
+     * @param id 输出请求编号
+     * @param code 输出代码
+     * @return bool 格式正确返回true
+     */
+    static bool decodeRequest(const QByteArray& payload, quint64* id, QString* code);
+
+    /**
+     * @brief 编码检查结果（诊断进程发回主进程）
+     * @param id 请求编号
+     * @param diagnostics 诊断
+     * @return QByteArray QDataStream序列化的负载
+     */
+    static QByteArray encode(quint64 id, const QVector<Diagnostic>& diagnostics);
+
+    /**
+     * @brief 解码检查结果
+     * @param payload 负载
+     * @param id 输出请求编号
+     * @param diagnostics 输出诊断
+     * @return bool 格式正确返回true
+     */
+    static bool decode(const QByteArray& payload, quint64* id, QVector<Diagnostic>* diagnostics);
+
+private:
+    pybind11::object m_checker;   // 第一次检查时创建
+};
+
+Q_DECLARE_METATYPE(SyntaxCheck::Diagnostic)
+Q_DECLARE_METATYPE(QVector<SyntaxCheck::Diagnostic>)
@@ -0,0 +1,266 @@
+#include "VariableInspector.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+#include <pybind11/eval.h>
+
+#include <frameobject.h>
+
+namespace py = pybind11;
+
+// Python侧的查看器
+//
+// objects[0]是栈帧的局部变量，其余是已分配句柄的对象；取一页时只对这一页的值求repr和长度。
+// 顶层和对象属性已经是名字，字典的键显示为repr。
+static const char* const kInspectorSource = R"(
+import itertools
+import reprlib
+from collections import abc
+
+
+class Inspector:
+    def __init__(self, max_length):
+        self.max_length = max_length
+        self.repr = reprlib.Repr()
+        self.repr.maxstring = max_length
+        self.repr.maxother = max_length
+        self.objects = [None]
+
+    def attach(self, scope):
+        self.objects = [scope]
+
+    def detach(self):
+        self.objects = [None]
+
+    def text(self, value):
+        try:
+            text = self.repr.repr(value)
+        except Exception as error:
+            text = '<repr() failed: %s>' % type(error).__name__
+        if len(text) > self.max_length:
+            text = text[:self.max_length - 3] + '...'
+        return text
+
+    def type_name(self, value):
+        name = type(value).__name__
+        shape = getattr(value, 'shape', None) if self.is_library(value) else None
+        if isinstance(shape, tuple):
+            name += ' ' + 'x'.join(str(n) for n in shape)
+        return name
+
+    @staticmethod
+    def is_library(value):
+        module = type(value).__module__ or ''
+        return module.startswith('numpy') or module.startswith('pandas')
+
+    def kind(self, value):
+        if isinstance(value, (str, bytes, bytearray, int, float, complex, type(None))):
+            return None
+        if self.is_library(value):
+            if hasattr(value, 'columns'):
+                return 'columns'
+            if hasattr(value, 'iloc'):
+                return 'series'
+            if getattr(value, 'ndim', 0) > 0:
+                return 'sequence'
+            return None
+        if isinstance(value, abc.Mapping):
+            return 'mapping'
+        if isinstance(value, (abc.Sequence, range)):
+            return 'sequence'
+        if isinstance(value, (abc.Set, abc.KeysView, abc.ValuesView)):
+            return 'iterable'
+        if isinstance(getattr(value, '__dict__', None), dict) and not isinstance(value, type):
+            return 'attributes'
+        return None
+
+    def count(self, value, kind):
+        try:
+            if kind == 'columns':
+                return len(value.columns)
+            if kind == 'attributes':
+                return len(value.__dict__)
+            return len(value)
+        except Exception:
+            return 0
+
+    def children(self, value, kind, start, count):
+        stop = start + count
+        if kind == 'scope':
+            names = [name for name in value.keys()
+                     if not (name.startswith('__') and name.endswith('__'))]
+            return len(names), [(name, value[name]) for name in names[start:stop]]
+        if kind == 'mapping':
+            items = itertools.islice(value.items(), start, stop)
+            return len(value), [(self.text(key), item) for key, item in items]
+        if kind == 'sequence':
+            total = len(value)
+            return total, [('[%d]' % i, value[i]) for i in range(start, min(stop, total))]
+        if kind == 'iterable':
+            items = itertools.islice(iter(value), start, stop)
+            return len(value), [('[%d]' % (start + i), item) for i, item in enumerate(items)]
+        if kind == 'columns':
+            columns = list(value.columns[start:stop])
+            return len(value.columns), [(str(column), value[column]) for column in columns]
+        if kind == 'series':
+            total = len(value)
+            labels = value.index[start:stop]
+            return total, [(str(label), value.iloc[start + i]) for i, label in enumerate(labels)]
+        if kind == 'attributes':
+            names = sorted(value.__dict__)
+            return len(names), [(name, value.__dict__[name]) for name in names[start:stop]]
+        return 0, []
+
+    def fetch(self, handle, start, count):
+        if handle >= len(self.objects) or self.objects[handle] is None:
+            return 0, []
+        value = self.objects[handle]
+        kind = 'scope' if handle == 0 else self.kind(value)
+        total, items = self.children(value, kind, start, count)
+
+        result = []
+        for name, item in items:
+            item_kind = self.kind(item)
+            children = self.count(item, item_kind) if item_kind else 0
+            child_handle = 0
+            if children > 0:
+                child_handle = len(self.objects)
+                self.objects.append(item)
+            result.append((name, self.type_name(item), self.text(item), children, child_handle))
+        return total, result
+)";
+
+VariableInspector::~VariableInspector()
+{
+    if (!m_inspector) {
+        return;
+    }
+    if (!Py_IsInitialized()) {
+        m_inspector.release();
+        return;
+    }
+    py::gil_scoped_acquire acquire;
+    m_inspector = py::object();
+}
+
+void VariableInspector::release()
+{
+    detach();
+    m_inspector = py::object();
+}
+
+void VariableInspector::attach(PyFrameObject* frame)
+{
+    if (!frame) {
+        return;
+    }
+
+    try {
+        if (!m_inspector) {
+            py::dict scope;
+            scope["__name__"]     = "qt_variable_inspector";
+            scope["__builtins__"] = py::module_::import("builtins");
+            py::exec(kInspectorSource, scope);
+            m_inspector = scope["Inspector"](kMaxValueLength);
+        }
+
+#if PY_VERSION_HEX >= 0x030B0000
+        PyObject* locals = PyFrame_GetLocals(frame);
+        if (!locals) {
+            throw py::error_already_set();
+        }
+        m_inspector.attr("attach")(py::reinterpret_steal<py::object>(locals));
+#else
+        if (PyFrame_FastToLocalsWithError(frame) < 0) {
+            throw py::error_already_set();
+        }
+        m_inspector.attr("attach")(py::reinterpret_borrow<py::object>(frame->f_locals));
+#endif
+        m_attached = true;
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "Cannot inspect paused frame:" << e.what();
+    }
+}
+
+void VariableInspector::detach()
+{
+    if (!m_attached) {
+        return;
+    }
+    m_attached = false;
+
+    try {
+        m_inspector.attr("detach")();
+    }
+    catch (py::error_already_set& e) {
+        qWarning() << "Cannot release inspected variables:" << e.what();
+    }
+}
+
+VariableInspector::Page VariableInspector::fetch(quint64 handle, int start, int count)
+{
+    Page page;
+    page.handle = handle;
+    page.start  = start;
+    if (!m_attached || start < 0 || count <= 0) {
+        return page;
+    }
+
+    try {
+        py::tuple result = m_inspector.attr("fetch")(handle, start, count);
+        page.total       = result[0].cast<qint64>();
+        for (py::handle item : result[1]) {
+            py::tuple tuple = py::reinterpret_borrow<py::tuple>(item);
+            Variable  variable;
+            variable.name       = QString::fromStdString(tuple[0].cast<std::string>());
+            variable.type       = QString::fromStdString(tuple[1].cast<std::string>());
+            variable.value      = QString::fromStdString(tuple[2].cast<std::string>());
+            variable.childCount = tuple[3].cast<qint64>();
+            variable.handle     = tuple[4].cast<quint64>();
+            page.variables.append(variable);
+        }
+    }
+    catch (py::error_already_set& e) {
+        // 属性或长度在取值时抛出异常（例如惰性对象），只影响这一页
+        qWarning() << "Cannot fetch variables:" << e.what();
+        page.variables.clear();
+    }
+    catch (py::cast_error& e) {
+        qWarning() << "Cannot fetch variables:" << e.what();
+        page.variables.clear();
+    }
+    return page;
+}
+
+QByteArray VariableInspector::encode(const Page& page)
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << page.handle << static_cast<qint32>(page.start) << page.total
+           << static_cast<qint32>(page.variables.size());
+    for (const Variable& variable : page.variables) {
+        stream << variable.name << variable.type << variable.value << variable.childCount
+               << variable.handle;
+    }
+    return payload;
+}
+
+bool VariableInspector::decode(const QByteArray& payload, Page* page)
+{
+    QDataStream stream(payload);
+    qint32      start = 0;
+    qint32      count = 0;
+    stream >> page->handle >> start >> page->total >> count;
+    page->start = start;
+
+    page->variables.clear();
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Variable variable;
+        stream >> variable.name >> variable.type >> variable.value >> variable.childCount >>
+            variable.handle;
+        page->variables.append(variable);
+    }
+    return stream.status() == QDataStream::Ok;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#define PYBIND11_NO_ASSERT_GIL_HELD_INCREF_DECREF 1
+
+#include <pybind11/pybind11.h>
+
+/**
+ * @class VariableInspector
+ * @brief 暂停时查看栈帧变量，按需分页取值
+ *
+ * 暂停期间界面每次只请求一页：顶层（句柄0）是暂停所在栈帧的局部变量，
+ * 可展开的值（容器、数组、带__dict__的对象）分配一个句柄，展开时再按页请求其子项。
+ * 值的文字用reprlib生成并截断到kMaxValueLength个字符，大列表、字典等只显示开头几项；
+ * NumPy数组和pandas对象使用其自身的摘要repr，并按第一维或列展开。
+ *
+ * 所有取值都在运行线程中持有GIL完成，界面线程只收到整理好的文字，不会因此等待GIL。
+ * 句柄只在本次暂停内有效，继续运行前detach()释放对这些对象的引用。
+ * attach()、fetch()和detach()都在持有GIL的运行线程中调用。
+ */
+class VariableInspector
+{
+public:
+    // 值文字的最大长度
+    static const int kMaxValueLength = 200;
+
+    /**
+     * @brief 一个变量或子项
+     */
+    struct Variable
+    {
+        QString name;               // 变量名、下标或键
+        QString type;               // 类型名（数组附带形状）
+        QString value;              // 截断后的repr
+        qint64  childCount = 0;     // 子项数，0表示不可展开
+        quint64 handle     = 0;     // 展开时请求的句柄，不可展开时为0
+    };
+
+    /**
+     * @brief 一页变量
+     */
+    struct Page
+    {
+        quint64           handle = 0;   // 所属的句柄，0为栈帧顶层
+        int               start  = 0;   // 第一项的序号
+        qint64            total  = 0;   // 子项总数
+        QVector<Variable> variables;
+    };
+
+    VariableInspector() = default;
+
+    /**
+     * @brief 析构函数（释放Python侧对象，需要时获取GIL）
+     */
+    ~VariableInspector();
+
+    VariableInspector(const VariableInspector&)            = delete;
+    VariableInspector& operator=(const VariableInspector&) = delete;
+
+    /**
+     * @brief 以栈帧的局部变量作为顶层
+     * @param frame 暂停所在的栈帧
+     */
+    void attach(PyFrameObject* frame);
+
+    /**
+     * @brief 释放本次暂停中的所有句柄
+     */
+    void detach();
+
+    /**
+     * @brief 释放Python侧的查看器（解释器重新初始化前调用，需持有GIL），下次attach()时重新创建
+     */
+    void release();
+
+    /**
+     * @brief 取一页子项
+     * @param handle 句柄，0为栈帧顶层
+     * @param start 第一项的序号
+     * @param count 最多取的项数
+     * @return Page 句柄无效或取值出错时为空页
+     */
+    Page fetch(quint64 handle, int start, int count);
+
+    /**
+     * @brief 编码一页变量（执行进程发回主进程）
+     * @param page 一页变量
+     * @return QByteArray QDataStream序列化的负载
+     */
+    static QByteArray encode(const Page& page);
+
+    /**
+     * @brief 解码一页变量
+     * @param payload 负载
+     * @param page 输出参数
+     * @return bool 格式正确返回true
+     */
+    static bool decode(const QByteArray& payload, Page* page);
+
+private:
+    pybind11::object m_inspector;   // Python侧的查看器，首次使用时创建
+    bool             m_attached = false;
+};
+
+Q_DECLARE_METATYPE(VariableInspector::Page)
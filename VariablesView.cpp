@@ -0,0 +1,130 @@
+#include "VariablesView.h"
+
+#include <QHeaderView>
+
+namespace {
+
+enum Column
+{
+    NameColumn = 0,
+    TypeColumn,
+    ValueColumn
+};
+
+// 项数据
+const int kHandleRole   = Qt::UserRole;       // 可展开项的句柄
+const int kNextPageRole = Qt::UserRole + 1;   // "加载更多"项：下一页的起始序号
+
+}   // namespace
+
+VariablesView::VariablesView(QWidget* parent)
+    : QTreeWidget(parent)
+{
+    setColumnCount(3);
+    setHeaderLabels({"名称", "类型", "值"});
+    setUniformRowHeights(true);
+    setWordWrap(false);
+    header()->setSectionResizeMode(NameColumn, QHeaderView::Interactive);
+    header()->setSectionResizeMode(TypeColumn, QHeaderView::ResizeToContents);
+    header()->setStretchLastSection(true);
+
+    connect(this, &QTreeWidget::itemExpanded, this, &VariablesView::onItemExpanded);
+    connect(this, &QTreeWidget::itemDoubleClicked, this, &VariablesView::onItemDoubleClicked);
+}
+
+void VariablesView::refresh()
+{
+    clearVariables();
+    m_items.insert(0, nullptr);
+    requestPage(0, 0);
+}
+
+void VariablesView::clearVariables()
+{
+    clear();
+    m_items.clear();
+    m_pending.clear();
+    m_loaded.clear();
+}
+
+void VariablesView::addPage(const VariableInspector::Page& page)
+{
+    if (!m_pending.remove(page.handle)) {
+        return;
+    }
+    QTreeWidgetItem* parent = m_items.value(page.handle);
+
+    // 上一页末尾的"加载更多"由这一页代替
+    const int existing = parent ? parent->childCount() : topLevelItemCount();
+    if (existing > 0) {
+        QTreeWidgetItem* last = parent ? parent->child(existing - 1) : topLevelItem(existing - 1);
+        if (last->data(NameColumn, kNextPageRole).isValid()) {
+            delete last;
+        }
+    }
+
+    QList<QTreeWidgetItem*> items;
+    items.reserve(page.variables.size() + 1);
+    for (const VariableInspector::Variable& variable : page.variables) {
+        QTreeWidgetItem* item = new QTreeWidgetItem({variable.name, variable.type, variable.value});
+        item->setToolTip(ValueColumn, variable.value);
+        if (variable.handle != 0) {
+            item->setData(NameColumn, kHandleRole, variable.handle);
+            item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+            m_items.insert(variable.handle, item);
+        }
+        items.append(item);
+    }
+
+    const qint64 next = page.start + page.variables.size();
+    if (!page.variables.isEmpty() && next < page.total) {
+        QTreeWidgetItem* more =
+            new QTreeWidgetItem(QStringList(QString("加载更多（还有 %1 项）...").arg(page.total - next)));
+        more->setData(NameColumn, kNextPageRole, next);
+        more->setForeground(NameColumn, palette().color(QPalette::Disabled, QPalette::Text));
+        items.append(more);
+    }
+
+    if (parent) {
+        parent->addChildren(items);
+        if (parent->childCount() == 0) {
+            parent->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicator);
+        }
+    }
+    else {
+        addTopLevelItems(items);
+    }
+}
+
+void VariablesView::onItemExpanded(QTreeWidgetItem* item)
+{
+    const QVariant handle = item->data(NameColumn, kHandleRole);
+    if (!handle.isValid() || m_loaded.contains(handle.toULongLong())) {
+        return;
+    }
+    requestPage(handle.toULongLong(), 0);
+}
+
+void VariablesView::onItemDoubleClicked(QTreeWidgetItem* item, int column)
+{
+    Q_UNUSED(column);
+
+    const QVariant next = item->data(NameColumn, kNextPageRole);
+    if (!next.isValid()) {
+        return;
+    }
+    QTreeWidgetItem* parent = item->parent();
+    const quint64    handle = parent ? parent->data(NameColumn, kHandleRole).toULongLong() : 0;
+    if (m_pending.contains(handle)) {
+        return;
+    }
+    item->setText(NameColumn, "加载中...");
+    requestPage(handle, next.toInt());
+}
+
+void VariablesView::requestPage(quint64 handle, int start)
+{
+    m_pending.insert(handle);
+    m_loaded.insert(handle);
+    emit variablesRequested(handle, start, kPageSize);
+}
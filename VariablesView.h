@@ -0,0 +1,73 @@
+#pragma once
+
+#include "VariableInspector.h"
+
+#include <QHash>
+#include <QSet>
+#include <QTreeWidget>
+
+/**
+ * @class VariablesView
+ * @brief 暂停时的变量面板
+ *
+ * 暂停时先请求栈帧顶层的第一页，展开可展开的项时才请求其子项，每次一页；
+ * 一页之后还有剩余时在末尾显示"加载更多"，双击后请求下一页。
+ * 运行继续后句柄失效，面板清空；只接受自己请求过的页，过期的结果直接丢弃。
+ */
+class VariablesView : public QTreeWidget
+{
+    Q_OBJECT
+
+public:
+    // 每次请求的项数
+    static const int kPageSize = 100;
+
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit VariablesView(QWidget* parent = nullptr);
+
+public slots:
+    /**
+     * @brief 运行已暂停，请求顶层变量
+     */
+    void refresh();
+
+    /**
+     * @brief 运行继续或结束，清空面板
+     */
+    void clearVariables();
+
+    /**
+     * @brief 收到一页变量
+     * @param page 一页变量
+     */
+    void addPage(const VariableInspector::Page& page);
+
+signals:
+    /**
+     * @brief 请求一页变量
+     * @param handle 句柄，0为栈帧顶层
+     * @param start 第一项的序号
+     * @param count 最多取的项数
+     */
+    void variablesRequested(quint64 handle, int start, int count);
+
+private slots:
+    void onItemExpanded(QTreeWidgetItem* item);
+    void onItemDoubleClicked(QTreeWidgetItem* item, int column);
+
+private:
+    /**
+     * @brief 请求某个句柄的一页子项
+     * @param handle 句柄
+     * @param start 第一项的序号
+     */
+    void requestPage(quint64 handle, int start);
+
+private:
+    QHash<quint64, QTreeWidgetItem*> m_items;     // 可展开的项（顶层为nullptr）
+    QSet<quint64>                    m_pending;   // 已请求、尚未收到的句柄
+    QSet<quint64>                    m_loaded;    // 已请求过第一页的句柄
+};
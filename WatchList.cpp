@@ -0,0 +1,143 @@
+#include "WatchList.h"
+#include "BreakpointTable.h"
+#include "VariableInspector.h"
+
+#include <QDataStream>
+
+#include <frameobject.h>
+
+// 监视表达式编译时使用的文件名，出现在错误信息中
+static const char* const kWatchFileName = "<watch>";
+
+WatchList::~WatchList()
+{
+    // 解释器已经关闭时代码对象随之失效，不能再减引用
+    if (m_entries.empty() || !Py_IsInitialized()) {
+        return;
+    }
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    clear();
+    PyGILState_Release(gstate);
+}
+
+void WatchList::setExpressions(const QStringList& expressions)
+{
+    clear();
+    m_entries.reserve(expressions.size());
+    for (const QString& expression : expressions) {
+        const QString trimmed = expression.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+        Entry entry;
+        entry.expression = trimmed;
+        entry.source     = trimmed.toUtf8();
+        m_entries.push_back(entry);
+    }
+}
+
+QVector<WatchList::Value> WatchList::evaluate(PyFrameObject* frame)
+{
+    QVector<Value> values;
+    values.reserve(static_cast<int>(m_entries.size()));
+    if (m_entries.empty() || !frame) {
+        return values;
+    }
+
+    // 栈帧变量只取一次，所有表达式共用
+#if PY_VERSION_HEX >= 0x030B0000
+    PyObject* globals = PyFrame_GetGlobals(frame);
+    PyObject* locals  = PyFrame_GetLocals(frame);
+#else
+    PyObject* globals = nullptr;
+    PyObject* locals  = nullptr;
+    if (PyFrame_FastToLocalsWithError(frame) == 0) {
+        globals = frame->f_globals;
+        locals  = frame->f_locals;
+        Py_XINCREF(globals);
+        Py_XINCREF(locals);
+    }
+#endif
+    QString frameError;
+    if (!globals) {
+        frameError = BreakpointTable::takeErrorMessage();
+    }
+
+    for (Entry& entry : m_entries) {
+        Value value;
+        value.expression = entry.expression;
+        value.error      = true;
+
+        if (!entry.code && !entry.compileFailed) {
+            entry.code = Py_CompileString(entry.source.constData(), kWatchFileName, Py_eval_input);
+            if (!entry.code) {
+                entry.compileFailed = true;
+                entry.compileError  = BreakpointTable::takeErrorMessage();
+            }
+        }
+
+        if (entry.compileFailed) {
+            value.value = entry.compileError;
+        }
+        else if (!globals) {
+            value.value = frameError;
+        }
+        else {
+            PyObject* result = PyEval_EvalCode(entry.code, globals, locals ? locals : globals);
+            PyObject* text   = result ? PyObject_Repr(result) : nullptr;
+            const char* utf8 = text ? PyUnicode_AsUTF8(text) : nullptr;
+            if (utf8) {
+                value.value = QString::fromUtf8(utf8);
+                value.error = false;
+                if (value.value.size() > VariableInspector::kMaxValueLength) {
+                    value.value = value.value.left(VariableInspector::kMaxValueLength - 3) + "...";
+                }
+            }
+            else {
+                value.value = BreakpointTable::takeErrorMessage();
+            }
+            Py_XDECREF(text);
+            Py_XDECREF(result);
+        }
+        values.append(value);
+    }
+
+    Py_XDECREF(globals);
+    Py_XDECREF(locals);
+    return values;
+}
+
+QByteArray WatchList::encode(const QVector<Value>& values)
+{
+    QByteArray  payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << static_cast<qint32>(values.size());
+    for (const Value& value : values) {
+        stream << value.expression << value.value << value.error;
+    }
+    return payload;
+}
+
+bool WatchList::decode(const QByteArray& payload, QVector<Value>* values)
+{
+    QDataStream stream(payload);
+    qint32      count = 0;
+    stream >> count;
+
+    values->clear();
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Value value;
+        stream >> value.expression >> value.value >> value.error;
+        values->append(value);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+void WatchList::clear()
+{
+    for (const Entry& entry : m_entries) {
+        Py_XDECREF(entry.code);
+    }
+    m_entries.clear();
+}
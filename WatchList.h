@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <Python.h>
+
+#include <vector>
+
+/**
+ * @class WatchList
+ * @brief 监视表达式列表，每次暂停时一起求值
+ *
+ * 表达式在第一次求值时编译为代码对象，列表不变时之后的暂停直接复用；
+ * 求值时栈帧的全局和局部变量只取一次，所有表达式在同一次持有GIL期间求值，
+ * 结果作为一个列表返回，界面一次更新。
+ * setExpressions()和evaluate()都在持有GIL的运行线程中调用。
+ */
+class WatchList
+{
+public:
+    /**
+     * @brief 一个表达式的求值结果
+     */
+    struct Value
+    {
+        QString expression;
+        QString value;           // 截断后的repr或错误信息
+        bool    error = false;   // 编译或求值出错
+    };
+
+    WatchList() = default;
+
+    /**
+     * @brief 析构函数（释放代码对象，需要时获取GIL）
+     */
+    ~WatchList();
+
+    WatchList(const WatchList&)            = delete;
+    WatchList& operator=(const WatchList&) = delete;
+
+    /**
+     * @brief 替换表达式列表（旧的代码对象随之释放）
+     * @param expressions 表达式，空白的会被忽略
+     */
+    void setExpressions(const QStringList& expressions);
+
+    /**
+     * @brief 是否没有表达式
+     * @return bool 没有表达式返回true
+     */
+    bool isEmpty() const { return m_entries.empty(); }
+
+    /**
+     * @brief 在栈帧上求值所有表达式
+     * @param frame 暂停所在的栈帧
+     * @return QVector<Value> 与表达式一一对应的结果
+     */
+    QVector<Value> evaluate(PyFrameObject* frame);
+
+    /**
+     * @brief 编码求值结果（执行进程发回主进程）
+     * @param values 求值结果
+     * @return QByteArray QDataStream序列化的负载
+     */
+    static QByteArray encode(const QVector<Value>& values);
+
+    /**
+     * @brief 解码求值结果
+     * @param payload 负载
+     * @param values 输出参数
+     * @return bool 格式正确返回true
+     */
+    static bool decode(const QByteArray& payload, QVector<Value>* values);
+
+private:
+    struct Entry
+    {
+        QString    expression;
+        QByteArray source;
+        PyObject*  code          = nullptr;   // 第一次求值时编译
+        bool       compileFailed = false;
+        QString    compileError;
+    };
+
+    void clear();
+
+private:
+    std::vector<Entry> m_entries;
+};
+
+Q_DECLARE_METATYPE(WatchList::Value)
+Q_DECLARE_METATYPE(QVector<WatchList::Value>)
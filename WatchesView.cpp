@@ -0,0 +1,135 @@
+#include "WatchesView.h"
+
+#include <QHeaderView>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column
+{
+    ExpressionColumn = 0,
+    ValueColumn
+};
+
+}   // namespace
+
+WatchesView::WatchesView(QWidget* parent)
+    : QWidget(parent)
+{
+    m_tree = new QTreeWidget;
+    m_tree->setColumnCount(2);
+    m_tree->setHeaderLabels({"表达式", "值"});
+    m_tree->setRootIsDecorated(false);
+    m_tree->setUniformRowHeights(true);
+    m_tree->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tree->header()->setStretchLastSection(true);
+    m_tree->installEventFilter(this);
+
+    m_input = new QLineEdit;
+    m_input->setPlaceholderText("添加监视表达式...");
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_tree);
+    layout->addWidget(m_input);
+
+    connect(m_input, &QLineEdit::returnPressed, this, &WatchesView::addExpression);
+    connect(m_tree, &QTreeWidget::itemChanged, this, &WatchesView::onItemChanged);
+    // 只有表达式列可以编辑
+    connect(m_tree, &QTreeWidget::itemDoubleClicked, this, [this](QTreeWidgetItem* item, int column) {
+        if (column == ExpressionColumn) {
+            m_tree->editItem(item, ExpressionColumn);
+        }
+    });
+}
+
+QStringList WatchesView::expressions() const
+{
+    QStringList result;
+    for (int i = 0; i < m_tree->topLevelItemCount(); ++i) {
+        result.append(m_tree->topLevelItem(i)->text(ExpressionColumn));
+    }
+    return result;
+}
+
+void WatchesView::setValues(const QVector<WatchList::Value>& values)
+{
+    // 结果与提交时的列表对应；期间列表又变化时按表达式匹配，对不上的保持原样
+    QSignalBlocker blocker(m_tree);
+    int            next = 0;
+    for (int i = 0; i < m_tree->topLevelItemCount(); ++i) {
+        QTreeWidgetItem* item       = m_tree->topLevelItem(i);
+        const QString    expression = item->text(ExpressionColumn).trimmed();
+        if (next >= values.size() || values.at(next).expression != expression) {
+            continue;
+        }
+        const WatchList::Value& value = values.at(next++);
+        item->setText(ValueColumn, value.value);
+        item->setToolTip(ValueColumn, value.value);
+        item->setForeground(ValueColumn,
+                            value.error ? QBrush(QColor(Qt::red)) : palette().brush(QPalette::Text));
+    }
+}
+
+void WatchesView::markStale()
+{
+    QSignalBlocker blocker(m_tree);
+    const QBrush   stale = palette().brush(QPalette::Disabled, QPalette::Text);
+    for (int i = 0; i < m_tree->topLevelItemCount(); ++i) {
+        m_tree->topLevelItem(i)->setForeground(ValueColumn, stale);
+    }
+}
+
+bool WatchesView::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_tree && event->type() == QEvent::KeyPress &&
+        static_cast<QKeyEvent*>(event)->key() == Qt::Key_Delete) {
+        QTreeWidgetItem* item = m_tree->currentItem();
+        if (item) {
+            delete item;
+            emit watchExpressionsChanged(expressions());
+        }
+        return true;
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+void WatchesView::addExpression()
+{
+    const QString expression = m_input->text().trimmed();
+    if (expression.isEmpty()) {
+        return;
+    }
+
+    QSignalBlocker   blocker(m_tree);
+    QTreeWidgetItem* item = new QTreeWidgetItem(m_tree, QStringList(expression));
+    item->setFlags(item->flags() | Qt::ItemIsEditable);
+    m_input->clear();
+    emit watchExpressionsChanged(expressions());
+}
+
+void WatchesView::onItemChanged(QTreeWidgetItem* item, int column)
+{
+    if (column != ExpressionColumn) {
+        return;
+    }
+    // 清空表达式等于删除；编辑器提交期间不能删除项，推迟到事件循环
+    if (item->text(ExpressionColumn).trimmed().isEmpty()) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, item]() {
+                if (m_tree->indexOfTopLevelItem(item) >= 0) {
+                    delete item;
+                    emit watchExpressionsChanged(expressions());
+                }
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+    QSignalBlocker blocker(m_tree);
+    item->setText(ValueColumn, QString());
+    emit watchExpressionsChanged(expressions());
+}
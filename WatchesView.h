@@ -0,0 +1,64 @@
+#pragma once
+
+#include "WatchList.h"
+
+#include <QWidget>
+
+class QLineEdit;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+/**
+ * @class WatchesView
+ * @brief 监视表达式面板
+ *
+ * 底部输入框添加表达式，双击表达式修改，Delete键删除；列表变化时发出watchExpressionsChanged()。
+ * 每次暂停收到一条包含所有结果的消息，一次更新整张表；继续运行后旧值以灰色显示，直到下次暂停。
+ */
+class WatchesView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口
+     */
+    explicit WatchesView(QWidget* parent = nullptr);
+
+    /**
+     * @brief 当前的表达式列表
+     * @return QStringList 表达式
+     */
+    QStringList expressions() const;
+
+public slots:
+    /**
+     * @brief 显示一次暂停的求值结果
+     * @param values 与表达式一一对应的结果
+     */
+    void setValues(const QVector<WatchList::Value>& values);
+
+    /**
+     * @brief 运行继续或结束，旧值标记为过期
+     */
+    void markStale();
+
+signals:
+    /**
+     * @brief 表达式列表变化
+     * @param expressions 新的表达式列表
+     */
+    void watchExpressionsChanged(const QStringList& expressions);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+    void addExpression();
+    void onItemChanged(QTreeWidgetItem* item, int column);
+
+private:
+    QTreeWidget* m_tree  = nullptr;
+    QLineEdit*   m_input = nullptr;
+};
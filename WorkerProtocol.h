@@ -0,0 +1,133 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <cstring>
+
+/**
+ * @brief 主进程与执行进程之间的消息定义
+ *
+ * 消息通过IpcChannel传递，两端运行同一个可执行文件，
+ * 负载直接使用本机字节序的定长结构或UTF-8文本。
+ */
+namespace WorkerProtocol
+{
+
+// 以执行进程模式启动时的命令行参数，后面紧跟通道标识
+static const char* const kWorkerArgument = "--execution-worker";
+
+/**
+ * @brief 消息类型
+ */
+enum Message : quint16
+{
+    // 主进程 -> 执行进程
+    RunCode = 1,         // 负载：UTF-8代码
+    Abort,               // 中止当前运行
+    Pause,
+    Continue,
+    StepInto,
+    StepOver,
+    StepOut,
+    SetBreakpoints,      // 负载：QDataStream序列化的断点（行号、条件、命中次数）
+    Shutdown,            // 退出执行进程
+    SetPersistentNamespace,   // 负载：quint8，是否保留会话变量
+    SetBudgets,          // 负载：BudgetPayload，下一次运行的预算
+    RequestVariables,    // 负载：VariableRequestPayload，暂停时请求一页变量
+    SetWatches,          // 负载：QDataStream序列化的QStringList，监视表达式
+    CheckSyntax,         // 负载：SyntaxCheck::encodeRequest()的编号和代码，只发给诊断进程
+    WarmUp,              // 负载：QDataStream序列化的QStringList，在后台预导入的模块
+    WriteInput,          // 负载：UTF-8文本，追加到标准输入
+    CloseInput,          // 结束标准输入
+
+    // 执行进程 -> 主进程
+    Ready = 100,         // 解释器初始化完成；负载：UTF-8图像通道的共享内存标识，为空表示没有
+    Started,             // 开始运行
+    StdOut,              // 负载：UTF-8文本
+    StdErr,              // 负载：UTF-8文本
+    Line,                // 负载：qint32，采样到的最新执行行
+    LineExecuted,        // 负载：qint32，暂停所在行
+    DebugState,          // 负载：qint32，CodeRunner::DebugState
+    Error,               // 负载：UTF-8错误信息
+    Summary,             // 负载：SummaryPayload
+    Finished,            // 运行结束
+    LogOutput,           // 负载：UTF-8文本，日志点输出
+    Variables,           // 负载：VariableInspector::encode()的一页变量
+    Watches,             // 负载：WatchList::encode()的监视表达式结果
+    Diagnostics,         // 负载：SyntaxCheck::encode()的检查结果
+    WarmedUp,            // 负载：PythonInterpreterManager::encodeWarmUp()的预导入结果
+    InputWaiting         // 负载：quint8，是否正在等待标准输入
+};
+
+/**
+ * @brief 运行汇总负载（与CodeRunner::RunSummary对应）
+ *
+ * 界面线程的GIL等待属于主进程，由RemoteCodeRunner在本地统计，不在负载中。
+ */
+struct SummaryPayload
+{
+    qint64 elapsedNs;
+    qint64 abortLatencyNs;
+    quint8 aborted;
+    quint8 hardStopped;
+    quint8 budgetExceeded;   // RunWatchdog::Budget
+    quint8 reserved[5];
+    qint64 compileNs;
+    qint64 cpuNs;
+    qint64 traceEvents;
+    qint64 traceNs;
+    qint64 outputBytes;
+    qint64 outputLines;
+    qint64 logpointHits;
+    qint64 logpointsDropped;
+};
+
+/**
+ * @brief 运行预算负载（与RunWatchdog::Budgets对应）
+ */
+struct BudgetPayload
+{
+    qint64 wallMs;
+    qint64 cpuMs;
+    qint64 memoryMB;
+};
+
+/**
+ * @brief 变量请求负载（与CodeRunner::requestVariables()的参数对应）
+ */
+struct VariableRequestPayload
+{
+    quint64 handle;
+    qint32  start;
+    qint32  count;
+};
+
+/**
+ * @brief 把定长结构编码为负载
+ * @param value 结构或整数
+ * @return QByteArray 负载
+ */
+template <typename T>
+inline QByteArray encode(const T& value)
+{
+    return QByteArray(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief 从负载解码定长结构
+ * @param payload 负载
+ * @param value 输出参数
+ * @return bool 长度匹配返回true
+ */
+template <typename T>
+inline bool decode(const QByteArray& payload, T* value)
+{
+    if (payload.size() != static_cast<int>(sizeof(T))) {
+        return false;
+    }
+    memcpy(value, payload.constData(), sizeof(T));
+    return true;
+}
+
+}   // namespace WorkerProtocol
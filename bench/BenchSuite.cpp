@@ -0,0 +1,230 @@
+#include "BenchSuite.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct Stats
+{
+    double min    = 0.0;
+    double max    = 0.0;
+    double median = 0.0;
+    double mean   = 0.0;
+    double stddev = 0.0;
+};
+
+Stats computeStats(QVector<double> samples)
+{
+    Stats stats;
+    if (samples.isEmpty()) {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const int count = samples.size();
+    stats.min       = samples.first();
+    stats.max       = samples.last();
+    stats.median    = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+
+    double sum = 0.0;
+    for (double value : samples) {
+        sum += value;
+    }
+    stats.mean = sum / count;
+
+    double squares = 0.0;
+    for (double value : samples) {
+        squares += (value - stats.mean) * (value - stats.mean);
+    }
+    stats.stddev = count > 1 ? std::sqrt(squares / (count - 1)) : 0.0;
+    return stats;
+}
+
+}   // namespace
+
+void BenchSuite::Recorder::record(const QString& metric, double value, const QString& unit)
+{
+    m_values.append({metric, value, unit});
+}
+
+void BenchSuite::Recorder::fail(const QString& reason)
+{
+    m_error = reason;
+}
+
+void BenchSuite::add(const QString& name, Case body, int repeat, int warmup)
+{
+    m_entries.append({name, std::move(body), qMax(1, repeat), qMax(0, warmup)});
+}
+
+int BenchSuite::run(const QStringList& arguments, const QMap<QString, QString>& environment)
+{
+    QTextStream out(stdout);
+
+    QRegularExpression filter;
+    QString            jsonPath;
+    int                repeatOverride = -1;
+    int                warmupOverride = -1;
+    bool               listOnly       = false;
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString& arg     = arguments[i];
+        const bool     hasNext = i + 1 < arguments.size();
+        if (arg == "--list") {
+            listOnly = true;
+        }
+        else if (arg == "--filter" && hasNext) {
+            filter.setPattern(arguments[++i]);
+        }
+        else if (arg == "--json" && hasNext) {
+            jsonPath = arguments[++i];
+        }
+        else if (arg == "--repeat" && hasNext) {
+            repeatOverride = qMax(1, arguments[++i].toInt());
+        }
+        else if (arg == "--warmup" && hasNext) {
+            warmupOverride = qMax(0, arguments[++i].toInt());
+        }
+        else {
+            out << "unknown argument: " << arg << Qt::endl;
+            out << "usage: embed_bench [--list] [--filter REGEX] [--repeat N] [--warmup N] [--json FILE]"
+                << Qt::endl;
+            return 2;
+        }
+    }
+
+    if (!filter.isValid()) {
+        out << "invalid filter: " << filter.errorString() << Qt::endl;
+        return 2;
+    }
+
+    QVector<Result>        results;
+    QMap<QString, QString> failures;
+
+    for (const Entry& entry : m_entries) {
+        if (!filter.pattern().isEmpty() && !filter.match(entry.name).hasMatch()) {
+            continue;
+        }
+        if (listOnly) {
+            out << entry.name << Qt::endl;
+            continue;
+        }
+
+        const int repeat = repeatOverride > 0 ? repeatOverride : entry.repeat;
+        const int warmup = warmupOverride >= 0 ? warmupOverride : entry.warmup;
+
+        // 指标按第一次出现的顺序输出
+        QVector<Result> caseResults;
+        QString         error;
+
+        for (int round = 0; round < warmup + repeat && error.isEmpty(); ++round) {
+            Recorder recorder;
+            try {
+                entry.body(recorder);
+            }
+            catch (const std::exception& e) {
+                recorder.fail(QString::fromUtf8(e.what()));
+            }
+            if (!recorder.m_error.isEmpty()) {
+                error = recorder.m_error;
+                break;
+            }
+            if (round < warmup) {
+                continue;
+            }
+
+            for (const Recorder::Value& value : recorder.m_values) {
+                const QString name = entry.name + '/' + value.metric;
+                auto          found =
+                    std::find_if(caseResults.begin(), caseResults.end(), [&name](const Result& r) {
+                        return r.name == name;
+                    });
+                if (found == caseResults.end()) {
+                    caseResults.append({name, value.unit, {}});
+                    found = caseResults.end() - 1;
+                }
+                found->samples.append(value.value);
+            }
+        }
+
+        if (!error.isEmpty()) {
+            failures.insert(entry.name, error);
+            out << entry.name << " FAILED: " << error << Qt::endl;
+            continue;
+        }
+
+        for (const Result& result : caseResults) {
+            const Stats stats = computeStats(result.samples);
+            out << result.name.leftJustified(44) << ' ' << QString::number(stats.median, 'g', 6) << ' ' << result.unit << "  (min "
+                << QString::number(stats.min, 'g', 6) << ", max " << QString::number(stats.max, 'g', 6)
+                << ", n=" << result.samples.size() << ")" << Qt::endl;
+        }
+        results += caseResults;
+    }
+
+    if (!listOnly && !jsonPath.isEmpty() && !writeJson(jsonPath, results, failures, environment)) {
+        out << "cannot write " << jsonPath << Qt::endl;
+        return 1;
+    }
+
+    return failures.isEmpty() ? 0 : 1;
+}
+
+bool BenchSuite::writeJson(const QString&                path,
+                           const QVector<Result>&        results,
+                           const QMap<QString, QString>& failures,
+                           const QMap<QString, QString>& environment)
+{
+    QJsonObject env;
+    for (auto it = environment.constBegin(); it != environment.constEnd(); ++it) {
+        env.insert(it.key(), it.value());
+    }
+
+    QJsonArray entries;
+    for (const Result& result : results) {
+        const Stats stats = computeStats(result.samples);
+
+        QJsonArray samples;
+        for (double value : result.samples) {
+            samples.append(value);
+        }
+
+        QJsonObject entry;
+        entry.insert("name", result.name);
+        entry.insert("unit", result.unit);
+        entry.insert("median", stats.median);
+        entry.insert("mean", stats.mean);
+        entry.insert("min", stats.min);
+        entry.insert("max", stats.max);
+        entry.insert("stddev", stats.stddev);
+        entry.insert("samples", samples);
+        entries.append(entry);
+    }
+
+    QJsonObject failed;
+    for (auto it = failures.constBegin(); it != failures.constEnd(); ++it) {
+        failed.insert(it.key(), it.value());
+    }
+
+    QJsonObject root;
+    root.insert("schema", 1);
+    root.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert("environment", env);
+    root.insert("results", entries);
+    root.insert("failures", failed);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QJsonDocument(root).toJson()) > 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+/**
+ * @class BenchSuite
+ * @brief 基准用例的注册、重复运行和结果输出
+ *
+ * 每个用例每次运行可以记录多个指标，同一用例中的指标在同一轮里测得（例如先自由运行再挂钩子，
+ * 配对比较）。每个用例先预热再重复运行，结果按中位数汇总，同时保留全部样本：
+ * - 文本结果输出到标准输出，便于人工对比
+ * - `--json 文件` 写出机器可读的结果（含运行环境），供每日性能任务比较回归
+ *
+ * 命令行参数：
+ * - `--list`：列出用例
+ * - `--filter 正则`：只运行名称匹配的用例
+ * - `--repeat N`：覆盖所有用例的重复次数
+ * - `--warmup N`：覆盖所有用例的预热次数
+ * - `--json 文件`：写出JSON结果
+ *
+ * 用例抛出的异常按失败处理，不影响后续用例。
+ */
+class BenchSuite
+{
+public:
+    /**
+     * @brief 一轮运行中记录指标的接口
+     */
+    class Recorder
+    {
+    public:
+        /**
+         * @brief 记录一个指标值
+         * @param metric 指标名
+         * @param value 数值
+         * @param unit 单位，例如 ms、ns、MB/s
+         */
+        void record(const QString& metric, double value, const QString& unit);
+
+        /**
+         * @brief 标记本轮失败（用例整体计为失败，程序以非零状态退出）
+         * @param reason 失败原因
+         */
+        void fail(const QString& reason);
+
+    private:
+        friend class BenchSuite;
+
+        struct Value
+        {
+            QString metric;
+            double  value;
+            QString unit;
+        };
+        QVector<Value> m_values;   // 按记录顺序
+        QString        m_error;
+    };
+
+    using Case = std::function<void(Recorder&)>;
+
+    /**
+     * @brief 注册一个用例
+     * @param name 用例名，使用"分组/名称"形式
+     * @param body 一轮运行
+     * @param repeat 默认重复次数
+     * @param warmup 默认预热次数
+     */
+    void add(const QString& name, Case body, int repeat = 5, int warmup = 1);
+
+    /**
+     * @brief 按命令行参数运行用例并输出结果
+     * @param arguments 命令行参数（不含程序名）
+     * @param environment 运行环境信息，写入JSON结果
+     * @return int 进程退出码，所有用例成功时为0
+     */
+    int run(const QStringList& arguments, const QMap<QString, QString>& environment);
+
+private:
+    struct Entry
+    {
+        QString name;
+        Case    body;
+        int     repeat;
+        int     warmup;
+    };
+
+    struct Result
+    {
+        QString         name;     // 用例名/指标名
+        QString         unit;
+        QVector<double> samples;
+    };
+
+    /**
+     * @brief 把结果写成JSON文件
+     * @param path 文件路径
+     * @param results 所有指标
+     * @param failures 失败的用例及原因
+     * @param environment 运行环境信息
+     * @return bool 写入成功返回true
+     */
+    static bool writeJson(const QString&                path,
+                          const QVector<Result>&        results,
+                          const QMap<QString, QString>& failures,
+                          const QMap<QString, QString>& environment);
+
+private:
+    QVector<Entry> m_entries;
+};
@@ -0,0 +1,114 @@
+# 输出吞吐量基准把数据写入OutputConsole，需要widgets（运行时使用offscreen平台）
+QT += core gui widgets network
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = embed_bench
+
+INCLUDEPATH += $$PWD/..
+
+HEADERS += \
+    BenchSuite.h \
+    ../AsyncioLoop.h \
+    ../BatchKernels.h \
+    ../BreakpointTable.h \
+    ../BufferBridge.h \
+    ../CellDependencies.h \
+    ../CellIndex.h \
+    ../CodeCache.h \
+    ../CodeFormatter.h \
+    ../CodeRunner.h \
+    ../CompletionEngine.h \
+    ../ConfigManager.h \
+    ../ExecutionRecorder.h \
+    ../ExecutionRecording.h \
+    ../ExecutionServer.h \
+    ../ExecutionWorker.h \
+    ../FileLoader.h \
+    ../FlameGraph.h \
+    ../FrameChannel.h \
+    ../GilWaitMeter.h \
+    ../InterpreterPool.h \
+    ../InputQueue.h \
+    ../InterruptGate.h \
+    ../IpcChannel.h \
+    ../LineChannel.h \
+    ../LineProfile.h \
+    ../MemoryProfiler.h \
+    ../ModuleRegistry.h \
+    ../MonitoringHook.h \
+    ../NativeCall.h \
+    ../OutlineIndex.h \
+    ../OutputChannel.h \
+    ../OutputConsole.h \
+    ../OutputLog.h \
+    ../ProcessPool.h \
+    ../PythonDetector.h \
+    ../PythonHandles.h \
+    ../PythonInterpreterManager.h \
+    ../PythonLexer.h \
+    ../RemoteCodeRunner.h \
+    ../RunScheduler.h \
+    ../RunWatchdog.h \
+    ../SamplingProfiler.h \
+    ../ServerProtocol.h \
+    ../SessionCheckpoint.h \
+    ../SyntaxCheck.h \
+    ../VariableInspector.h \
+    ../WatchList.h \
+    ../WorkerProtocol.h
+
+SOURCES += \
+    BenchSuite.cpp \
+    ../AsyncioLoop.cpp \
+    ../BatchKernels.cpp \
+    ../BreakpointTable.cpp \
+    ../BufferBridge.cpp \
+    ../CellDependencies.cpp \
+    ../CellIndex.cpp \
+    ../CodeCache.cpp \
+    ../CodeFormatter.cpp \
+    ../CodeRunner.cpp \
+    ../CompletionEngine.cpp \
+    ../ConfigManager.cpp \
+    ../ExecutionRecorder.cpp \
+    ../ExecutionRecording.cpp \
+    ../ExecutionServer.cpp \
+    ../ExecutionWorker.cpp \
+    ../FileLoader.cpp \
+    ../FlameGraph.cpp \
+    ../FrameChannel.cpp \
+    ../GilWaitMeter.cpp \
+    ../InterpreterPool.cpp \
+    ../InputQueue.cpp \
+    ../InterruptGate.cpp \
+    ../IpcChannel.cpp \
+    ../LineChannel.cpp \
+    ../LineProfile.cpp \
+    ../MemoryProfiler.cpp \
+    ../ModuleRegistry.cpp \
+    ../MonitoringHook.cpp \
+    ../NativeCall.cpp \
+    ../OutlineIndex.cpp \
+    ../OutputChannel.cpp \
+    ../OutputConsole.cpp \
+    ../OutputLog.cpp \
+    ../ProcessPool.cpp \
+    ../PythonDetector.cpp \
+    ../PythonHandles.cpp \
+    ../PythonInterpreterManager.cpp \
+    ../PythonLexer.cpp \
+    ../RemoteCodeRunner.cpp \
+    ../RunScheduler.cpp \
+    ../RunWatchdog.cpp \
+    ../SamplingProfiler.cpp \
+    ../SessionCheckpoint.cpp \
+    ../SyntaxCheck.cpp \
+    ../VariableInspector.cpp \
+    ../WatchList.cpp \
+    embed_bench.cpp
+
+# 常驻内存采样（GetProcessMemoryInfo）
+win32: LIBS += -lpsapi
+
+include(../python.pri)
@@ -0,0 +1,1789 @@
+#include "BenchSuite.h"
+#include "BufferBridge.h"
+#include "CellDependencies.h"
+#include "CellIndex.h"
+#include "CodeFormatter.h"
+#include "CodeRunner.h"
+#include "CompletionEngine.h"
+#include "ConfigManager.h"
+#include "ExecutionRecording.h"
+#include "ExecutionServer.h"
+#include "ExecutionWorker.h"
+#include "FileLoader.h"
+#include "FrameChannel.h"
+#include "InterpreterPool.h"
+#include "OutlineIndex.h"
+#include "OutputConsole.h"
+#include "ProcessPool.h"
+#include "PythonInterpreterManager.h"
+#include "PythonLexer.h"
+#include "RemoteCodeRunner.h"
+#include "RunScheduler.h"
+#include "ServerProtocol.h"
+#include "SyntaxCheck.h"
+#include "WorkerProtocol.h"
+
+#include <QApplication>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QSet>
+#include <QSettings>
+#include <QSysInfo>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <cstring>
+#include <iostream>
+
+// 嵌入层性能基准
+//
+// 每个用例测量一条热路径，预热后重复运行，按中位数汇总：
+// - startup：解释器初始化、同一进程中的重新初始化，以及预导入前后第一次运行的耗时（每轮在新进程中进行，与本进程的状态无关）
+// - trace：同一段循环在各调试模式下的耗时、每个行事件的开销和运行指标中的钩子耗时占比，
+//   以及条件断点每次命中的开销、每次暂停求值监视表达式的开销和录制运行每个行事件的开销与字节数
+// - sampling：递归代码不采样和1kHz采样的耗时
+// - output：print输出经重定向、输出通道到输出窗口的吞吐量，文本与字节写入的对比，以及日志点与print的对比
+// - execute：executeCode对小段和大段代码、缓存命中和未命中时的延迟
+// - cpp_module：从Python调用嵌入模块函数的开销
+// - buffer：C++与NumPy之间共享大数组的开销（未安装NumPy时不注册）
+// - kernels：批量内核各指令集实现的吞吐量，以及与逐个调用的对比（未安装NumPy时不注册）
+// - native：长时间的C++调用期间其他Python线程能否继续运行，以及线程池上的异步调用
+// - queue：调度队列逐个运行小段代码的开销和同key提交的合并
+// - asyncio：运行线程的事件循环在后台和顶层await中每轮调度的开销
+// - memory：内存统计对分配密集代码的减速，以及保留会话变量时跨运行增长的检出
+// - cells：划分单元格和分析依赖的开销，以及只运行修改过的单元格与重新运行整个缓冲区的对比
+// - editor：语法高亮的词法分析对大文件每个字符的开销，分块加载大文件的吞吐量和格式化的逐行差分
+// - watchdog：超出时间预算到运行停止的延迟
+// - abort、namespace、pool、process：中止响应、新建命名空间、子解释器池和执行进程池
+// - server：本地执行服务逐个和流水线发送命令的往返延迟
+//
+// 用法见BenchSuite；--json写出的结果供每日性能任务比较。
+
+// 启动基准的子进程参数
+static const char* const kStartupProbeArgument = "--startup-probe";
+
+// 重新初始化基准的子进程参数
+static const char* const kRestartProbeArgument = "--restart-probe";
+
+// 预导入基准的子进程参数，后面跟cold或warm
+static const char* const kWarmUpProbeArgument = "--warm-up-probe";
+
+// 预导入基准导入的模块（标准库中导入较慢的几个包）
+static const char* const kWarmUpModules[] = {"email.mime.multipart", "xml.dom.minidom", "decimal", "json"};
+
+// 启动阶段在结果中的名称，与PythonInterpreterManager::initialize()中的阶段顺序一致
+static const char* const kStartupPhaseKeys[] = {"config", "environment", "interpreter", "sinks", "namespace"};
+
+static const int kIterations = 1000000;
+
+// 采样分析基准中递归斐波那契的参数
+static const int kFibDepth = 27;
+
+// 输出吞吐量基准打印的行数（每行80字节）
+static const int kOutputLines = 200000;
+
+// 共享数组基准的元素个数（256MB）
+static const size_t kBufferElements = 32 * 1024 * 1024;
+
+static qint64 runOnce(CodeRunner* runner, const QString& code, CodeRunner::RunSummary* summary = nullptr)
+{
+    QEventLoop loop;
+    if (summary) {
+        QObject::connect(runner,
+                         &CodeRunner::runSummary,
+                         &loop,
+                         [summary](const CodeRunner::RunSummary& s) { *summary = s; });
+    }
+    QObject::connect(runner, &CodeRunner::executionFinished, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    QMetaObject::invokeMethod(runner, "runCode", Qt::QueuedConnection, Q_ARG(QString, code));
+    loop.exec();
+    return timer.nsecsElapsed();
+}
+
+static CodeRunner::RunSummary runAndAbort(CodeRunner* runner, const QString& code, int delayMs)
+{
+    QEventLoop             loop;
+    CodeRunner::RunSummary summary;
+    QObject::connect(runner,
+                     &CodeRunner::runSummary,
+                     &loop,
+                     [&summary](const CodeRunner::RunSummary& s) { summary = s; });
+    QObject::connect(runner, &CodeRunner::executionFinished, &loop, &QEventLoop::quit);
+
+    QTimer::singleShot(delayMs, &loop, [runner]() { runner->abortExecution(); });
+    QMetaObject::invokeMethod(runner, "runCode", Qt::QueuedConnection, Q_ARG(QString, code));
+    loop.exec();
+    return summary;
+}
+
+// 用指定数量的工作线程运行一批任务，返回总耗时
+static qint64 runPoolBatch(int                       workers,
+                           int                       jobs,
+                           const QString&            code,
+                           InterpreterPool::Metrics* metrics)
+{
+    InterpreterPool pool;
+    if (!pool.start(workers)) {
+        return -1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < jobs; ++i) {
+        pool.submit(code);
+    }
+    pool.waitForDone();
+    qint64 elapsedNs = timer.nsecsElapsed();
+
+    *metrics = pool.metrics();
+    pool.shutdown();
+    return elapsedNs;
+}
+
+static qint64 runProcessBatch(int                   workers,
+                              int                   jobs,
+                              const QString&        code,
+                              ProcessPool::Metrics* metrics)
+{
+    ProcessPool pool;
+    if (!pool.start(workers)) {
+        return -1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < jobs; ++i) {
+        pool.submit(code);
+    }
+    pool.waitForDone();
+    qint64 elapsedNs = timer.nsecsElapsed();
+
+    *metrics = pool.metrics();
+    pool.shutdown();
+    return elapsedNs;
+}
+
+static qint64 measureRespawn()
+{
+    RemoteCodeRunner runner;
+
+    QEventLoop loop;
+    QObject::connect(&runner, &RemoteCodeRunner::workerReady, &loop, &QEventLoop::quit);
+    QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+    loop.exec();
+    if (!runner.isWorkerReady()) {
+        return -1;
+    }
+
+    // 执行进程直接退出，计时到新进程就绪
+    QElapsedTimer timer;
+    timer.start();
+    runner.runCode("import os\nos._exit(3)\n");
+    loop.exec();
+    return runner.isWorkerReady() && runner.restartCount() == 1 ? timer.nsecsElapsed() : -1;
+}
+
+// 手动重启执行进程到新进程就绪的时间；spare时先等备用进程完成初始化
+static qint64 measureWorkerRestart(bool spare)
+{
+    RemoteCodeRunner runner;
+    runner.setSpareWorker(spare);
+
+    QEventLoop    loop;
+    QElapsedTimer startup;
+    startup.start();
+    QObject::connect(&runner, &RemoteCodeRunner::workerReady, &loop, &QEventLoop::quit);
+    QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+    loop.exec();
+    if (!runner.isWorkerReady()) {
+        return -1;
+    }
+
+    // 备用进程就绪没有通知，按首次启动时间的两倍等待
+    if (spare) {
+        QTimer::singleShot(2 * startup.elapsed() + 100, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!runner.restartWorker(false)) {
+        return -1;
+    }
+    loop.exec();
+    return runner.isWorkerReady() ? timer.nsecsElapsed() : -1;
+}
+
+// 从本地执行服务读取帧，直到收到count个指定类型的帧
+static bool readServerFrames(QLocalSocket* socket, QByteArray* buffer, quint16 type, int count)
+{
+    QDeadlineTimer deadline(30000);
+    int            seen = 0;
+    while (seen < count) {
+        quint16    frameType = 0;
+        quint32    tag       = 0;
+        QByteArray payload;
+        const int  status = ServerProtocol::takeFrame(buffer, &frameType, &tag, &payload);
+        if (status < 0) {
+            return false;
+        }
+        if (status > 0) {
+            seen += frameType == type ? 1 : 0;
+            continue;
+        }
+        if (deadline.hasExpired()) {
+            return false;
+        }
+
+        // 服务在同一个线程中，等待时必须处理事件
+        QEventLoop loop;
+        QObject::connect(socket, &QLocalSocket::readyRead, &loop, &QEventLoop::quit);
+        QTimer::singleShot(static_cast<int>(qMax<qint64>(1, deadline.remainingTime())), &loop, &QEventLoop::quit);
+        loop.exec();
+        buffer->append(socket->readAll());
+    }
+    return true;
+}
+
+// 启动基准的子进程：只初始化解释器，把耗时（纳秒）写到标准输出
+static int runStartupProbe(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QElapsedTimer timer;
+    timer.start();
+    PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+    const bool                ok        = pyManager.initialize();
+    const qint64              elapsedNs = timer.nsecsElapsed();
+    pyManager.cleanup();
+
+    if (!ok) {
+        return 1;
+    }
+
+    // 每行一个阶段耗时，最后一行是总耗时
+    QTextStream out(stdout);
+    for (const PythonInterpreterManager::StartupPhase& phase : pyManager.startupPhases()) {
+        out << phase.elapsedNs << Qt::endl;
+    }
+    out << elapsedNs << Qt::endl;
+    return 0;
+}
+
+// 重新初始化基准的子进程：初始化后运行一段代码，再销毁并重新初始化，输出重新初始化的耗时（纳秒）
+static int runRestartProbe(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+    if (!pyManager.initialize()) {
+        return 1;
+    }
+    pyManager.executeCode("import json\nvalue = json.dumps({'a': 1})\n");
+
+    QElapsedTimer timer;
+    timer.start();
+    pyManager.cleanup();
+    const bool   ok        = pyManager.initialize();
+    const qint64 elapsedNs = timer.nsecsElapsed();
+
+    // 新解释器中同样的代码能正常运行
+    bool works = ok && pyManager.generation() == 2;
+    try {
+        if (works) {
+            pyManager.executeCode("import json\nvalue = json.dumps({'a': 1})\n");
+        }
+    }
+    catch (const std::exception&) {
+        works = false;
+    }
+    pyManager.cleanup();
+    if (!works) {
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << elapsedNs << Qt::endl;
+    return 0;
+}
+
+// 预导入基准的子进程：warm时先预导入并等待结束，再运行导入这些模块的代码，
+// 输出预导入耗时和运行耗时（纳秒）
+static int runWarmUpProbe(int argc, char* argv[], bool warm)
+{
+    QCoreApplication app(argc, argv);
+
+    PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+    if (!pyManager.initialize()) {
+        return 1;
+    }
+
+    QStringList modules;
+    for (const char* module : kWarmUpModules) {
+        modules << module;
+    }
+
+    qint64 warmUpNs = 0;
+    if (warm) {
+        QEventLoop loop;
+        QObject::connect(&pyManager, &PythonInterpreterManager::warmUpFinished, &loop, &QEventLoop::quit);
+        pyManager.warmUp(modules);
+        loop.exec();
+        for (const PythonInterpreterManager::WarmUpModule& module : pyManager.warmUpModules()) {
+            warmUpNs += module.elapsedNs;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    pyManager.executeCode("import " + modules.join(", "));
+    const qint64 runNs = timer.nsecsElapsed();
+    pyManager.cleanup();
+
+    QTextStream out(stdout);
+    out << warmUpNs << Qt::endl << runNs << Qt::endl;
+    return 0;
+}
+
+// 在调用方提供的命名空间中执行代码，返回耗时
+static qint64 timeExecute(PythonInterpreterManager& pyManager, const QString& code, py::object* globals)
+{
+    QElapsedTimer timer;
+    timer.start();
+    pyManager.executeCode(code, globals);
+    return timer.nsecsElapsed();
+}
+
+int main(int argc, char* argv[])
+{
+    // 执行进程池启动的子进程
+    if (argc >= 3 && strcmp(argv[1], WorkerProtocol::kWorkerArgument) == 0) {
+        QCoreApplication app(argc, argv);
+        return ExecutionWorker::run(QString::fromLocal8Bit(argv[2]));
+    }
+    if (argc >= 2 && strcmp(argv[1], kStartupProbeArgument) == 0) {
+        return runStartupProbe(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], kRestartProbeArgument) == 0) {
+        return runRestartProbe(argc, argv);
+    }
+    if (argc >= 3 && strcmp(argv[1], kWarmUpProbeArgument) == 0) {
+        return runWarmUpProbe(argc, argv, strcmp(argv[2], "warm") == 0);
+    }
+
+    // 输出窗口基准需要QApplication，每日任务没有显示器
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QTextStream  out(stdout);
+
+    PythonInterpreterManager& pyManager = PythonInterpreterManager::instance();
+    if (!pyManager.initialize()) {
+        out << "error: Python interpreter initialization failed" << Qt::endl;
+        return 1;
+    }
+
+    CodeRunner* runner       = new CodeRunner;
+    QThread*    runnerThread = new QThread;
+    runner->moveToThread(runnerThread);
+    runnerThread->start();
+
+    const QString loopCode = QString("total = 0\n"
+                                     "for i in range(%1):\n"
+                                     "    total += i\n")
+                                 .arg(kIterations);
+
+    BenchSuite suite;
+
+    // 解释器初始化：每轮启动一个只做初始化的子进程
+    suite.add(
+        "startup/initialize",
+        [](BenchSuite::Recorder& r) {
+            QProcess      probe;
+            QElapsedTimer timer;
+            timer.start();
+            probe.start(QCoreApplication::applicationFilePath(), {kStartupProbeArgument});
+            if (!probe.waitForFinished(60000) || probe.exitCode() != 0) {
+                r.fail("startup probe failed: " + probe.errorString());
+                return;
+            }
+            const qint64 processNs = timer.nsecsElapsed();
+
+            const QList<QByteArray> lines = probe.readAllStandardOutput().trimmed().split('\n');
+            r.record("initialize_ms", lines.last().trimmed().toLongLong() / 1e6, "ms");
+            const int phaseCount = static_cast<int>(sizeof(kStartupPhaseKeys) / sizeof(kStartupPhaseKeys[0]));
+            for (int i = 0; i + 1 < lines.size() && i < phaseCount; ++i) {
+                r.record(QString("%1_ms").arg(kStartupPhaseKeys[i]), lines[i].trimmed().toLongLong() / 1e6, "ms");
+            }
+            r.record("process_ms", processNs / 1e6, "ms");
+        },
+        5,
+        1);
+
+    // 预导入：同样导入几个包的第一次运行，不预导入与预导入后的运行耗时
+    suite.add(
+        "startup/warm_up",
+        [](BenchSuite::Recorder& r) {
+            qint64      runNs[2] = {0, 0};
+            qint64      warmUpNs = 0;
+            const char* modes[]  = {"cold", "warm"};
+            for (int i = 0; i < 2; ++i) {
+                QProcess probe;
+                probe.start(QCoreApplication::applicationFilePath(), {kWarmUpProbeArgument, modes[i]});
+                if (!probe.waitForFinished(60000) || probe.exitCode() != 0) {
+                    r.fail(QString("%1 probe failed: %2").arg(modes[i], probe.errorString()));
+                    return;
+                }
+                const QList<QByteArray> lines = probe.readAllStandardOutput().trimmed().split('\n');
+                if (lines.size() < 2) {
+                    r.fail(QString("%1 probe printed no timings").arg(modes[i]));
+                    return;
+                }
+                if (i == 1) {
+                    warmUpNs = lines[lines.size() - 2].trimmed().toLongLong();
+                }
+                runNs[i] = lines.last().trimmed().toLongLong();
+            }
+            r.record("cold_run_ms", runNs[0] / 1e6, "ms");
+            r.record("warm_run_ms", runNs[1] / 1e6, "ms");
+            r.record("warm_up_ms", warmUpNs / 1e6, "ms");
+        },
+        5,
+        1);
+
+    // 重新初始化：在同一进程中销毁解释器再初始化（切换环境或恢复时不重启应用）
+    suite.add(
+        "startup/restart",
+        [](BenchSuite::Recorder& r) {
+            QProcess probe;
+            probe.start(QCoreApplication::applicationFilePath(), {kRestartProbeArgument});
+            if (!probe.waitForFinished(60000) || probe.exitCode() != 0) {
+                r.fail("restart probe failed: " + probe.errorString());
+                return;
+            }
+            r.record("restart_ms", probe.readAllStandardOutput().trimmed().toLongLong() / 1e6, "ms");
+        },
+        5,
+        1);
+
+    // 各调试模式下同一段循环的耗时；同一轮内先自由运行，每个行事件的开销按配对差值计算
+    suite.add("trace/loop", [&](BenchSuite::Recorder& r) {
+        runner->setBreakpoints(QSet<int>());
+        const qint64 freeNs = runOnce(runner, loopCode);
+        r.record("free_run_ms", freeNs / 1e6, "ms");
+
+        // 断点设在不存在的行上：钩子常驻，每个行事件都走快速路径
+        runner->setPreferredDebugBackend(CodeRunner::TraceBackend);
+        runner->setBreakpoints(QSet<int>{1000000});
+        CodeRunner::RunSummary traced;
+        const qint64           tracedNs = runOnce(runner, loopCode, &traced);
+        const double           events   = static_cast<double>(runner->lineChannel()->events());
+        r.record("settrace_ms", tracedNs / 1e6, "ms");
+        r.record("line_events", events, "events");
+        if (events > 0) {
+            r.record("settrace_ns_per_line", (tracedNs - freeNs) / events, "ns");
+        }
+
+        // 运行指标中的钩子计数包含行事件以外的调用和返回事件，耗时是钩子内部的部分
+        if (traced.traceEvents < events) {
+            r.fail("run metrics counted fewer trace events than line events");
+        }
+        r.record("settrace_hook_pct", 100.0 * traced.traceNs / qMax<qint64>(1, traced.elapsedNs), "%");
+
+        // 一万个不在循环中的断点：查表是位测试，耗时应与一个断点相同
+        QSet<int> manyBreakpoints;
+        for (int line = 100; line < 10100; ++line) {
+            manyBreakpoints.insert(line);
+        }
+        runner->setBreakpoints(manyBreakpoints);
+        const qint64 manyNs = runOnce(runner, loopCode);
+        r.record("settrace_10k_breakpoints_ms", manyNs / 1e6, "ms");
+        runner->setBreakpoints(QSet<int>{1000000});
+
+        // 同样的断点用sys.monitoring后端：未命中断点的行第一次执行后即关闭事件
+        runner->setPreferredDebugBackend(CodeRunner::MonitoringBackend);
+        const qint64 monitoredNs = runOnce(runner, loopCode);
+        if (runner->activeDebugBackend() == CodeRunner::MonitoringBackend) {
+            r.record("monitoring_ms", monitoredNs / 1e6, "ms");
+            if (events > 0) {
+                r.record("monitoring_ns_per_line", (monitoredNs - freeNs) / events, "ns");
+            }
+        }
+
+        // 逐行性能分析：无断点，每个行事件都计时
+        runner->setBreakpoints(QSet<int>());
+        runner->setProfiling(true);
+        const qint64 profiledNs = runOnce(runner, loopCode);
+        runner->setProfiling(false);
+        r.record("line_profile_ms", profiledNs / 1e6, "ms");
+        if (events > 0) {
+            r.record("line_profile_ns_per_line", (profiledNs - freeNs) / events, "ns");
+        }
+    });
+
+    // 条件断点：命中次数在C++中判断，条件只编译一次，之后每次命中在栈帧变量上求值
+    suite.add("trace/conditional", [&](BenchSuite::Recorder& r) {
+        auto loopBreakpoint = [](const QString& condition, const QString& hitCondition) {
+            Breakpoint breakpoint;
+            breakpoint.line         = 3;
+            breakpoint.condition    = condition;
+            breakpoint.hitCondition = hitCondition;
+            return QVector<Breakpoint>{breakpoint};
+        };
+
+        // 暂停时立即继续，记录暂停次数
+        QObject context;
+        int     pauses = 0;
+        QObject::connect(runner, &CodeRunner::lineExecuted, &context, [&pauses, runner](int) {
+            ++pauses;
+            runner->continueExecution();
+        });
+
+        // 基准：钩子常驻但循环体所在行没有断点
+        runner->setPreferredDebugBackend(CodeRunner::TraceBackend);
+        runner->setBreakpoints(QSet<int>{1000000});
+        const qint64 tracedNs = runOnce(runner, loopCode);
+
+        runner->setBreakpoints(loopBreakpoint(QString(), ">1000000000"));
+        const qint64 hitCountNs = runOnce(runner, loopCode);
+        r.record("hit_count_ns_per_hit", (hitCountNs - tracedNs) / static_cast<double>(kIterations), "ns");
+
+        runner->setBreakpoints(loopBreakpoint("i < 0", QString()));
+        const qint64 conditionNs = runOnce(runner, loopCode);
+        r.record("condition_ns_per_hit", (conditionNs - tracedNs) / static_cast<double>(kIterations), "ns");
+
+        // 条件只满足一次时只暂停一次
+        pauses = 0;
+        runner->setBreakpoints(loopBreakpoint("i == 500", QString()));
+        runOnce(runner, loopCode);
+        runner->setBreakpoints(QSet<int>());
+        if (pauses != 1) {
+            r.fail(QString("conditional breakpoint paused %1 times, expected 1").arg(pauses));
+        }
+    });
+
+    // 监视表达式：每次暂停一起求值的开销，每次暂停只发出一次结果
+    suite.add("trace/watches", [&](BenchSuite::Recorder& r) {
+        static const int kWatches = 20;
+
+        Breakpoint breakpoint;
+        breakpoint.line         = 3;
+        breakpoint.hitCondition = "%10000";
+
+        QObject context;
+        int     pauses  = 0;
+        int     results = 0;
+        QObject::connect(runner, &CodeRunner::lineExecuted, &context, [&pauses, runner](int) {
+            ++pauses;
+            runner->continueExecution();
+        });
+        QObject::connect(runner,
+                         &CodeRunner::watchesReady,
+                         &context,
+                         [&results](const QVector<WatchList::Value>&) { ++results; });
+
+        runner->setPreferredDebugBackend(CodeRunner::TraceBackend);
+        runner->setBreakpoints(QVector<Breakpoint>{breakpoint});
+        runner->setWatchExpressions(QStringList());
+        const qint64 plainNs     = runOnce(runner, loopCode);
+        const int    plainPauses = pauses;
+
+        QStringList expressions;
+        for (int i = 0; i < kWatches; ++i) {
+            expressions.append(QString("total + i * %1").arg(i));
+        }
+        runner->setWatchExpressions(expressions);
+        pauses               = 0;
+        const qint64 watchNs = runOnce(runner, loopCode);
+        runner->setWatchExpressions(QStringList());
+        runner->setBreakpoints(QSet<int>());
+
+        if (pauses == 0 || pauses != plainPauses) {
+            r.fail(QString("paused %1 times with watches, %2 without").arg(pauses).arg(plainPauses));
+            return;
+        }
+        r.record("watches_us_per_pause", (watchNs - plainNs) / 1000.0 / pauses, "us");
+        if (results != pauses) {
+            r.fail(QString("%1 watch results for %2 pauses, expected one per pause").arg(results).arg(pauses));
+        }
+    });
+
+    // 录制运行：相对普通追踪每个行事件增加的开销、每步占用的字节数，以及回放时随机取一步的耗时
+    suite.add("trace/record", [&](BenchSuite::Recorder& r) {
+        auto runRecorded = [runner](const QString& code, bool recordLocals) {
+            QEventLoop loop;
+            QObject::connect(runner, &CodeRunner::executionFinished, &loop, &QEventLoop::quit);
+
+            RunScheduler::Request request;
+            request.code         = code;
+            request.recording    = true;
+            request.recordLocals = recordLocals;
+
+            QElapsedTimer timer;
+            timer.start();
+            runner->submitRun(request);
+            loop.exec();
+            return timer.nsecsElapsed();
+        };
+
+        runner->setPreferredDebugBackend(CodeRunner::TraceBackend);
+        runner->setBreakpoints(QSet<int>{1000000});
+        const qint64 tracedNs = runOnce(runner, loopCode);
+        runner->setBreakpoints(QSet<int>());
+
+        const qint64                        recordNs  = runRecorded(loopCode, false);
+        std::shared_ptr<ExecutionRecording> recording = runner->recording();
+        if (!recording || recording->stepCount() == 0) {
+            r.fail("recorded run produced no recording");
+            return;
+        }
+        const double steps = static_cast<double>(recording->stepCount());
+        r.record("record_ms", recordNs / 1e6, "ms");
+        r.record("record_ns_per_line", (recordNs - tracedNs) / steps, "ns");
+        r.record("record_bytes_per_line", recording->fileBytes() / steps, "B");
+
+        // 第1行执行一次，第3行从第3步开始每隔一步执行一次
+        if (recording->findLine(-1, 3, true) != 2 || recording->findLine(recording->stepCount(), 1, false) != 0) {
+            r.fail("findLine returned unexpected steps");
+        }
+
+        // 随机位置取一步：从最近的检查点解码
+        QElapsedTimer timer;
+        timer.start();
+        static const int kSeeks = 1000;
+        quint64          state  = 0x9E3779B97F4A7C15ull;
+        for (int i = 0; i < kSeeks; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            if (recording->step(static_cast<qint64>((state >> 33) % recording->stepCount())).index < 0) {
+                r.fail("step() failed on a recorded index");
+                return;
+            }
+        }
+        r.record("step_us", timer.nsecsElapsed() / 1000.0 / kSeeks, "us");
+
+        const qint64 localsNs = runRecorded(loopCode, true);
+        recording             = runner->recording();
+        if (!recording || !recording->hasLocals()) {
+            r.fail("recorded run with locals produced no locals");
+            return;
+        }
+        r.record("record_locals_ns_per_line", (localsNs - tracedNs) / steps, "ns");
+        r.record("record_locals_bytes_per_line", recording->fileBytes() / steps, "B");
+    });
+
+    // 采样分析：递归代码最容易被追踪函数扭曲，对比不采样和1kHz采样的耗时
+    suite.add("sampling/fib", [&](BenchSuite::Recorder& r) {
+        const QString recursive = QString("def fib(n):\n"
+                                          "    return n if n < 2 else fib(n - 1) + fib(n - 2)\n"
+                                          "fib(%1)\n")
+                                      .arg(kFibDepth);
+        const qint64 plainNs = runOnce(runner, recursive);
+        runner->setSampling(true);
+        runner->setSamplingRate(1000);
+        const qint64 sampledNs = runOnce(runner, recursive);
+        runner->setSampling(false);
+
+        r.record("plain_ms", plainNs / 1e6, "ms");
+        r.record("sampled_ms", sampledNs / 1e6, "ms");
+        std::shared_ptr<FlameGraph> graph = runner->flameGraph();
+        if (!graph) {
+            r.fail("no flame graph produced");
+            return;
+        }
+        r.record("samples", graph->totalSamples(), "samples");
+        r.record("overhead_pct", 100.0 * graph->overheadNs() / qMax<qint64>(1, graph->durationNs()), "%");
+    });
+
+    // 输出吞吐量：与主窗口相同的取数方式，数据最终写入输出窗口
+    suite.add("output/print", [&](BenchSuite::Recorder& r) {
+        OutputConsole console;
+        QTimer        flushTimer;
+        flushTimer.setSingleShot(true);
+        flushTimer.setInterval(16);
+
+        auto drain = [&]() {
+            const QList<OutputChannel::Chunk> chunks = runner->outputChannel()->takeAll();
+            for (const OutputChannel::Chunk& chunk : chunks) {
+                console.appendText(chunk.text);
+            }
+        };
+        QObject::connect(&flushTimer, &QTimer::timeout, &console, drain);
+        QObject::connect(runner, &CodeRunner::outputReady, &console, [&]() {
+            if (runner->outputChannel()->isAboveHighWatermark()) {
+                flushTimer.stop();
+                drain();
+            }
+            else if (!flushTimer.isActive()) {
+                flushTimer.start();
+            }
+        });
+
+        const QString code = QString("line = 'x' * 79\n"
+                                     "for i in range(%1):\n"
+                                     "    print(line)\n")
+                                 .arg(kOutputLines);
+
+        QElapsedTimer timer;
+        timer.start();
+        runOnce(runner, code);
+        flushTimer.stop();
+        drain();
+        const double seconds = timer.nsecsElapsed() / 1e9;
+
+        r.record("throughput_mb_s", kOutputLines * 80.0 / (1024.0 * 1024.0) / seconds, "MB/s");
+        r.record("lines_per_s", kOutputLines / seconds, "lines/s");
+    });
+
+    // sys.stdout.write与sys.stdout.buffer.write：同样的字节数，字节写入不经过字符串；同时检查标准错误单独成段
+    suite.add("output/streams", [&](BenchSuite::Recorder& r) {
+        qint64 stdoutBytes = 0;
+        qint64 stderrBytes = 0;
+        auto   drain       = [&]() {
+            const QList<OutputChannel::Chunk> chunks = runner->outputChannel()->takeAll();
+            for (const OutputChannel::Chunk& chunk : chunks) {
+                (chunk.stream == OutputChannel::StdErr ? stderrBytes : stdoutBytes) += chunk.text.size();
+            }
+        };
+        QObject connection;
+        QObject::connect(runner, &CodeRunner::outputReady, &connection, drain);
+
+        const QString textCode = QString("import sys\n"
+                                         "line = 'x' * 79 + '\\n'\n"
+                                         "write = sys.stdout.write\n"
+                                         "for i in range(%1):\n"
+                                         "    write(line)\n"
+                                         "sys.stderr.write('e' * 80)\n")
+                                     .arg(kOutputLines);
+        const QString bytesCode = QString("import sys\n"
+                                          "line = b'x' * 79 + b'\\n'\n"
+                                          "write = sys.stdout.buffer.write\n"
+                                          "for i in range(%1):\n"
+                                          "    write(line)\n"
+                                          "sys.stderr.buffer.write(b'e' * 80)\n")
+                                      .arg(kOutputLines);
+
+        const qint64 textNs = runOnce(runner, textCode);
+        drain();
+        const qint64 bytesNs = runOnce(runner, bytesCode);
+        drain();
+
+        if (stderrBytes != 160 || stdoutBytes != 2LL * kOutputLines * 80) {
+            r.fail(QString("unexpected output: %1 stdout, %2 stderr characters").arg(stdoutBytes).arg(stderrBytes));
+            return;
+        }
+        r.record("text_ns_per_write", textNs / static_cast<double>(kOutputLines), "ns");
+        r.record("bytes_ns_per_write", bytesNs / static_cast<double>(kOutputLines), "ns");
+    });
+
+    // 图像通道：脚本连续提交640x480的RGB帧，不需要NumPy（memoryview按形状转换）
+    suite.add("output/frames", [&](BenchSuite::Recorder& r) {
+        static const int kFrames = 500;
+
+        std::shared_ptr<FrameChannel> channel = runner->frameChannel();
+        if (!channel) {
+            r.fail("cannot allocate frame channel");
+            return;
+        }
+        const quint64 before = channel->published();
+
+        const QString code = QString("import cpp_module\n"
+                                     "frame = memoryview(bytearray(640 * 480 * 3)).cast('B', (480, 640, 3))\n"
+                                     "show = cpp_module.show_image\n"
+                                     "for i in range(%1):\n"
+                                     "    show(frame, 'bench')\n")
+                                 .arg(kFrames);
+        const qint64 elapsedNs = runOnce(runner, code);
+
+        if (channel->published() - before != static_cast<quint64>(kFrames) || !channel->acquire() ||
+            channel->image().size() != QSize(640, 480) || channel->title() != "bench") {
+            r.fail(QString("unexpected frames: %1 published").arg(channel->published() - before));
+            return;
+        }
+        const double frameNs = elapsedNs / static_cast<double>(kFrames);
+        r.record("ns_per_frame", frameNs, "ns");
+        r.record("frames_per_second", 1e9 / frameNs, "fps");
+        r.record("throughput", 640.0 * 480 * 3 * 1e3 / frameNs, "MB/s");
+    });
+
+    // 日志点与print：同样次数的输出，日志点不经过sys.stdout，通道满时丢弃而不阻塞
+    suite.add("output/logpoint", [&](BenchSuite::Recorder& r) {
+        OutputConsole console;
+        auto          drain = [&]() {
+            const QList<OutputChannel::Chunk> chunks = runner->outputChannel()->takeAll();
+            for (const OutputChannel::Chunk& chunk : chunks) {
+                console.appendText(chunk.text);
+            }
+        };
+        QObject::connect(runner, &CodeRunner::outputReady, &console, drain);
+
+        const QString logCode = QString("total = 0\n"
+                                        "for i in range(%1):\n"
+                                        "    total += i\n")
+                                    .arg(kOutputLines);
+        const QString printCode = QString("total = 0\n"
+                                          "for i in range(%1):\n"
+                                          "    total += i\n"
+                                          "    print('i =', i)\n")
+                                      .arg(kOutputLines);
+
+        runner->setPreferredDebugBackend(CodeRunner::TraceBackend);
+        Breakpoint logpoint;
+        logpoint.line       = 3;
+        logpoint.logMessage = "i = {i}";
+        runner->setBreakpoints(QVector<Breakpoint>{logpoint});
+        CodeRunner::RunSummary logged;
+        const qint64           loggedNs = runOnce(runner, logCode, &logged);
+        drain();
+
+        runner->setBreakpoints(QSet<int>());
+        const qint64 printNs = runOnce(runner, printCode);
+        drain();
+
+        if (logged.logpointHits != kOutputLines) {
+            r.fail(QString("logpoint hit %1 times, expected %2").arg(logged.logpointHits).arg(kOutputLines));
+        }
+        r.record("logpoint_ns_per_line", loggedNs / static_cast<double>(kOutputLines), "ns");
+        r.record("print_ns_per_line", printNs / static_cast<double>(kOutputLines), "ns");
+        r.record("logpoint_dropped_pct", 100.0 * logged.logpointsDropped / qMax<qint64>(1, logged.logpointHits), "%");
+    });
+
+    // executeCode延迟：缓存命中时只有执行和命名空间开销，未命中时还包括编译
+    {
+        QString largeCode;
+        for (int i = 0; i < 5000; ++i) {
+            largeCode += QString("v%1 = %1 * 2\n").arg(i);
+        }
+
+        auto measure = [&pyManager](BenchSuite::Recorder& r,
+                                    const QString&        metric,
+                                    const QString&        code,
+                                    int                   calls,
+                                    bool                  cached) {
+            // 未命中时每次的代码都不同，并暂时关闭磁盘缓存，避免测到文件写入
+            QString diskDirectory;
+            if (!cached) {
+                py::gil_scoped_acquire acquire;
+                diskDirectory = pyManager.codeCache().diskDirectory();
+                pyManager.codeCache().setDiskDirectory(QString());
+            }
+
+            static quint64 s_serial = 0;
+            qint64         totalNs  = 0;
+            for (int i = 0; i < calls; ++i) {
+                const QString source = cached ? code : QString("# %1\n").arg(++s_serial) + code;
+                totalNs += timeExecute(pyManager, source, nullptr);
+            }
+
+            if (!cached) {
+                py::gil_scoped_acquire acquire;
+                pyManager.codeCache().setDiskDirectory(diskDirectory);
+            }
+            r.record(metric, totalNs / 1e3 / calls, "us");
+        };
+
+        suite.add("execute/small", [measure](BenchSuite::Recorder& r) {
+            measure(r, "cached_us", "x = 1\n", 2000, true);
+            measure(r, "uncached_us", "x = 1\n", 2000, false);
+        });
+        suite.add("execute/large", [measure, largeCode](BenchSuite::Recorder& r) {
+            r.record("source_kb", largeCode.toUtf8().size() / 1024.0, "KB");
+            measure(r, "cached_us", largeCode, 50, true);
+            measure(r, "uncached_us", largeCode, 20, false);
+        });
+    }
+
+    // 嵌入模块调用开销：循环调用的耗时减去空循环，再除以调用次数
+    suite.add("cpp_module/call", [&pyManager](BenchSuite::Recorder& r) {
+        const int kCalls = 200000;
+
+        py::object globals;
+        {
+            py::gil_scoped_acquire acquire;
+            globals = py::dict();
+        }
+        pyManager.executeCode("import cpp_module\n"
+                              "get_version = cpp_module.get_version\n"
+                              "test = cpp_module.test\n"
+                              "def py_function():\n"
+                              "    return '1.0.0'\n",
+                              &globals);
+
+        auto loop = [kCalls](const QString& body) {
+            return QString("for _ in range(%1):\n    %2\n").arg(kCalls).arg(body);
+        };
+
+        const qint64 baselineNs = timeExecute(pyManager, loop("pass"), &globals);
+        const qint64 pythonNs   = timeExecute(pyManager, loop("py_function()"), &globals);
+        const qint64 versionNs  = timeExecute(pyManager, loop("get_version()"), &globals);
+
+        // test()每次都写std::cout，测量期间丢弃输出，只统计调用和字符串转换的开销
+        std::streambuf* stdoutBuffer = std::cout.rdbuf(nullptr);
+        const qint64    testNs       = timeExecute(pyManager, loop("test('abc')"), &globals);
+        std::cout.rdbuf(stdoutBuffer);
+
+        r.record("python_function_ns", double(pythonNs - baselineNs) / kCalls, "ns");
+        r.record("get_version_ns", double(versionNs - baselineNs) / kCalls, "ns");
+        r.record("test_ns", double(testNs - baselineNs) / kCalls, "ns");
+
+        py::gil_scoped_acquire acquire;
+        globals = py::object();
+    });
+
+    // C++与NumPy之间传递大数组：共享内存的开销与数组大小无关，复制作对比
+    bool hasNumpy = false;
+    {
+        py::gil_scoped_acquire acquire;
+        try {
+            py::module_::import("numpy");
+            hasNumpy = true;
+        }
+        catch (py::error_already_set&) {
+        }
+    }
+    if (hasNumpy) {
+        suite.add("buffer/numpy", [&pyManager](BenchSuite::Recorder& r) {
+            const int kCalls = 10000;
+
+            std::shared_ptr<SampleBuffer> buffer = SampleBuffer::allocate(kBufferElements);
+            BufferRegistry::instance().publish("bench", buffer);
+
+            py::object globals;
+            {
+                py::gil_scoped_acquire acquire;
+                globals = py::dict();
+            }
+            pyManager.executeCode("import numpy, cpp_module\n"
+                                  "a = cpp_module.buffer('bench')\n",
+                                  &globals);
+
+            const QString viewCode =
+                QString("for _ in range(%1):\n    cpp_module.buffer('bench')\n").arg(kCalls);
+            const QString publishCode =
+                QString("for _ in range(%1):\n    cpp_module.publish('back', a)\n").arg(kCalls);
+
+            const qint64 viewNs    = timeExecute(pyManager, viewCode, &globals);
+            const qint64 publishNs = timeExecute(pyManager, publishCode, &globals);
+            const qint64 copyNs    = timeExecute(pyManager, "b = a.copy()\n", &globals);
+            const qint64 sumNs     = timeExecute(pyManager, "cpp_module.sum(a)\n", &globals);
+
+            const double bytes = double(kBufferElements) * sizeof(double);
+            r.record("view_ns", double(viewNs) / kCalls, "ns");
+            r.record("publish_ns", double(publishNs) / kCalls, "ns");
+            r.record("copy_ms", copyNs / 1e6, "ms");
+            r.record("sum_gb_per_s", sumNs > 0 ? bytes / sumNs : 0.0, "GB/s");
+
+            {
+                py::gil_scoped_acquire acquire;
+                globals = py::object();
+            }
+            BufferRegistry::instance().clear();
+        });
+
+        // 批量内核：同一数组依次用标量和最快的指令集实现；字符串长度与逐个调用test()对比
+        suite.add("kernels/batch", [&pyManager](BenchSuite::Recorder& r) {
+            const int kStrings = 1000000;
+
+            py::object globals;
+            {
+                py::gil_scoped_acquire acquire;
+                globals = py::dict();
+            }
+            pyManager.executeCode(QString("import numpy, cpp_module\n"
+                                          "a = numpy.ones(%1)\n"
+                                          "b = numpy.ones(%1)\n"
+                                          "words = [f'sample-{i}' for i in range(%2)]\n"
+                                          "fixed = numpy.array(words, dtype='S')\n"
+                                          "best = cpp_module.kernel_isa()\n")
+                                      .arg(kBufferElements)
+                                      .arg(kStrings),
+                                  &globals);
+
+            const double bytes = double(kBufferElements) * sizeof(double);
+            for (const QString& isa : {QString("scalar"), QString("best")}) {
+                pyManager.executeCode(isa == "best" ? "cpp_module.set_kernel_isa(best)\n"
+                                                    : "cpp_module.set_kernel_isa('scalar')\n",
+                                      &globals);
+
+                const qint64 sumNs  = timeExecute(pyManager, "cpp_module.sum(a)\n", &globals);
+                const qint64 dotNs  = timeExecute(pyManager, "cpp_module.dot(a, b)\n", &globals);
+                const qint64 axpyNs = timeExecute(pyManager, "cpp_module.axpy(0.5, a, b)\n", &globals);
+                r.record(QString("%1_sum_gb_per_s").arg(isa), bytes / sumNs, "GB/s");
+                r.record(QString("%1_dot_gb_per_s").arg(isa), 2 * bytes / dotNs, "GB/s");
+                r.record(QString("%1_axpy_gb_per_s").arg(isa), 3 * bytes / axpyNs, "GB/s");
+            }
+
+            // test()每次都写std::cout，测量期间丢弃输出
+            std::streambuf* stdoutBuffer = std::cout.rdbuf(nullptr);
+            const qint64    perCallNs =
+                timeExecute(pyManager, "lengths = [cpp_module.test(w)[0] for w in words]\n", &globals);
+            std::cout.rdbuf(stdoutBuffer);
+            const qint64 listNs  = timeExecute(pyManager, "lengths = cpp_module.str_lengths(words)\n", &globals);
+            const qint64 fixedNs = timeExecute(pyManager, "lengths = cpp_module.str_lengths(fixed)\n", &globals);
+
+            r.record("test_per_call_ns", double(perCallNs) / kStrings, "ns");
+            r.record("str_lengths_list_ns", double(listNs) / kStrings, "ns");
+            r.record("str_lengths_fixed_ns", double(fixedNs) / kStrings, "ns");
+
+            py::gil_scoped_acquire acquire;
+            globals = py::object();
+        });
+    }
+
+    // 长时间的C++调用期间另一个Python线程的进度，以及线程池并行统计素数的耗时
+    suite.add("native/gil", [&pyManager](BenchSuite::Recorder& r) {
+        py::object globals;
+        {
+            py::gil_scoped_acquire acquire;
+            globals = py::dict();
+        }
+        pyManager.executeCode("import cpp_module, threading, time\n"
+                              "def spin():\n"
+                              "    global ticks, stop\n"
+                              "    ticks, stop = 0, False\n"
+                              "    def loop():\n"
+                              "        global ticks\n"
+                              "        while not stop:\n"
+                              "            ticks += 1\n"
+                              "    thread = threading.Thread(target=loop)\n"
+                              "    thread.start()\n"
+                              "    start = time.perf_counter()\n"
+                              "    yield\n"
+                              "    elapsed = time.perf_counter() - start\n"
+                              "    stop = True\n"
+                              "    thread.join()\n"
+                              "    yield ticks / elapsed / 1000\n"
+                              "def measure(call):\n"
+                              "    probe = spin()\n"
+                              "    next(probe)\n"
+                              "    call()\n"
+                              "    return next(probe)\n"
+                              "idle = measure(lambda: time.sleep(0.5))\n"
+                              "start = time.perf_counter()\n"
+                              "busy = measure(lambda: cpp_module.count_primes(20000000))\n"
+                              "primes_ms = (time.perf_counter() - start) * 1000\n"
+                              "start = time.perf_counter()\n"
+                              "futures = [cpp_module.count_primes_async(5000000) for _ in range(4)]\n"
+                              "[f.result() for f in futures]\n"
+                              "async_ms = (time.perf_counter() - start) * 1000\n",
+                              &globals);
+
+        py::gil_scoped_acquire acquire;
+        const double idle = globals["idle"].cast<double>();
+        const double busy = globals["busy"].cast<double>();
+        r.record("idle_ticks_per_ms", idle, "ticks/ms");
+        r.record("busy_ticks_per_ms", busy, "ticks/ms");
+        r.record("busy_progress_ratio", idle > 0 ? busy / idle : 0.0, "x");
+        r.record("count_primes_ms", globals["primes_ms"].cast<double>(), "ms");
+        r.record("async_4x_ms", globals["async_ms"].cast<double>(), "ms");
+        globals = py::object();
+    });
+
+    // 中止响应时间（追踪钩子未挂载）
+    suite.add(
+        "abort/latency",
+        [&](BenchSuite::Recorder& r) {
+            runner->setBreakpoints(QSet<int>());
+            const CodeRunner::RunSummary loopAbort = runAndAbort(runner, "while True:\n    pass\n", 100);
+            const CodeRunner::RunSummary sleepAbort =
+                runAndAbort(runner, "import time\ntime.sleep(60)\n", 100);
+            const CodeRunner::RunSummary caughtAbort = runAndAbort(
+                runner,
+                "while True:\n    try:\n        pass\n    except BaseException:\n        pass\n",
+                100);
+
+            r.record("loop_ms", loopAbort.abortLatencyNs / 1e6, "ms");
+            r.record("sleep_ms", sleepAbort.abortLatencyNs / 1e6, "ms");
+            r.record("caught_ms", caughtAbort.abortLatencyNs / 1e6, "ms");
+            r.record("caught_hard_stop", caughtAbort.hardStopped ? 1 : 0, "bool");
+        },
+        3);
+
+    // 运行预算：监视线程发现超出预算到运行结束的时间，以及sleep不计入CPU时间
+    suite.add(
+        "watchdog/budget",
+        [&](BenchSuite::Recorder& r) {
+            runner->setBreakpoints(QSet<int>());
+            const qint64 kBudgetMs = 200;
+
+            RunWatchdog::Budgets wall;
+            wall.wallMs = kBudgetMs;
+            runner->setBudgets(wall);
+            CodeRunner::RunSummary wallRun;
+            runOnce(runner, "while True:\n    pass\n", &wallRun);
+
+            // 睡眠不消耗CPU时间，不应触发；之后的死循环触发
+            RunWatchdog::Budgets cpu;
+            cpu.cpuMs = kBudgetMs;
+            runner->setBudgets(cpu);
+            CodeRunner::RunSummary sleepRun;
+            runOnce(runner, "import time\ntime.sleep(0.5)\n", &sleepRun);
+            CodeRunner::RunSummary cpuRun;
+            runOnce(runner, "while True:\n    pass\n", &cpuRun);
+            runner->setBudgets(RunWatchdog::Budgets());
+
+            if (wallRun.budgetExceeded != RunWatchdog::WallTimeBudget) {
+                r.fail("wall time budget did not stop the loop");
+            }
+            if (sleepRun.budgetExceeded != RunWatchdog::NoBudget) {
+                r.fail("cpu time budget triggered on time.sleep");
+            }
+            if (cpuRun.budgetExceeded != RunWatchdog::CpuTimeBudget) {
+                r.fail("cpu time budget did not stop the loop");
+            }
+            r.record("wall_overshoot_ms", wallRun.elapsedNs / 1e6 - kBudgetMs, "ms");
+            r.record("cpu_overshoot_ms", cpuRun.elapsedNs / 1e6 - kBudgetMs, "ms");
+        },
+        3);
+
+    // 调度队列：连续提交的小段代码逐个运行的开销，以及运行期间同key重复提交的合并
+    suite.add("queue/dispatch", [&](BenchSuite::Recorder& r) {
+        const int kRuns = 1000;
+
+        runner->setBreakpoints(QSet<int>());
+        int                     finished = 0;
+        QEventLoop              loop;
+        QMetaObject::Connection connection =
+            QObject::connect(runner, &CodeRunner::executionFinished, &loop, [&finished, &loop]() {
+                ++finished;
+                loop.quit();
+            });
+        // 队列为空且每个已开始的请求都已发出完成信号
+        auto waitForIdle = [&]() {
+            for (;;) {
+                const RunScheduler::Metrics metrics = runner->scheduler()->metrics();
+                if (metrics.depth == 0 && quint64(finished) >= metrics.started) {
+                    return;
+                }
+                loop.exec();
+            }
+        };
+
+        const RunScheduler::Metrics before = runner->scheduler()->metrics();
+        finished                           = static_cast<int>(before.started);
+
+        QElapsedTimer timer;
+        timer.start();
+        RunScheduler::Request request;
+        request.priority = RunScheduler::Batch;
+        for (int i = 0; i < kRuns; ++i) {
+            request.code = QString("x = %1\n").arg(i);
+            runner->submitRun(request);
+        }
+        waitForIdle();
+        const qint64                batchNs = timer.nsecsElapsed();
+        const RunScheduler::Metrics after   = runner->scheduler()->metrics();
+
+        // 第一次提交开始运行后再提交的同key请求合并为一个
+        request.key  = "editor";
+        request.code = "import time\ntime.sleep(0.2)\n";
+        runner->submitRun(request);
+        while (!runner->scheduler()->metrics().running) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+        }
+        for (int i = 0; i < kRuns; ++i) {
+            request.code = QString("y = %1\n").arg(i);
+            runner->submitRun(request);
+        }
+        waitForIdle();
+        const RunScheduler::Metrics coalesced = runner->scheduler()->metrics();
+        QObject::disconnect(connection);
+
+        r.record("per_run_us", batchNs / 1e3 / kRuns, "us");
+        r.record("mean_wait_ms",
+                 double(after.totalWaitNs - before.totalWaitNs) / (after.started - before.started) / 1e6,
+                 "ms");
+        r.record("coalesced_runs", double(coalesced.started - after.started), "runs");
+    });
+
+    // asyncio：同一协程在运行线程的Qt事件循环中后台运行与在顶层await中运行的每轮开销
+    suite.add("asyncio/loop", [&](BenchSuite::Recorder& r) {
+        const int     kYields = 20000;
+        const QString spin    = QString("import asyncio, sys, time\n"
+                                        "async def spin():\n"
+                                        "    start = time.perf_counter()\n"
+                                        "    for _ in range(%1):\n"
+                                        "        await asyncio.sleep(0)\n"
+                                        "    sys.qt_asyncio_bench = time.perf_counter() - start\n"
+                                        "sys.qt_asyncio_bench = None\n")
+                                    .arg(kYields);
+
+        runner->setBreakpoints(QSet<int>());
+        runOnce(runner, spin + "asyncio.get_event_loop().create_task(spin())\n");
+
+        // 后台任务由运行线程自己驱动，这里只等待结果
+        double backgroundSeconds = 0.0;
+        for (int i = 0; i < 6000 && backgroundSeconds <= 0.0; ++i) {
+            QThread::msleep(5);
+            py::gil_scoped_acquire acquire;
+            py::object             result = py::module_::import("sys").attr("qt_asyncio_bench");
+            if (!result.is_none()) {
+                backgroundSeconds = result.cast<double>();
+            }
+        }
+        if (backgroundSeconds <= 0.0) {
+            r.fail("background task did not finish");
+            return;
+        }
+
+        runOnce(runner, spin + "await spin()\n");
+        double awaitSeconds = 0.0;
+        {
+            py::gil_scoped_acquire acquire;
+            awaitSeconds = py::module_::import("sys").attr("qt_asyncio_bench").cast<double>();
+        }
+
+        r.record("background_yield_us", backgroundSeconds * 1e6 / kYields, "us");
+        r.record("await_yield_us", awaitSeconds * 1e6 / kYields, "us");
+    });
+
+    // 内存统计：tracemalloc对分配密集代码的减速；会话中每次运行累积10MB时报告的增长和分配位置
+    suite.add("memory/tracking", [&](BenchSuite::Recorder& r) {
+        const QString allocate = "objects = [str(i) for i in range(300000)]\n"
+                                 "del objects\n";
+
+        runner->setBreakpoints(QSet<int>());
+        runner->setMemoryTracking(false);
+        const qint64 plainNs = runOnce(runner, allocate);
+        runner->setMemoryTracking(true);
+        const qint64 trackedNs = runOnce(runner, allocate);
+
+        const bool wasPersistent = pyManager.isPersistentNamespace();
+        pyManager.setPersistentNamespace(true);
+        const QString leak = "cache = globals().setdefault('bench_cache', [])\n"
+                             "cache.append(bytearray(10 * 1024 * 1024))\n";
+        runOnce(runner, leak);
+        runOnce(runner, leak);
+        std::shared_ptr<MemoryReport> report = runner->memoryReport();
+        runOnce(runner, "del bench_cache, cache\n");
+        runner->setMemoryTracking(false);
+        pyManager.setPersistentNamespace(wasPersistent);
+
+        if (!report || !report->traced || report->topSites.isEmpty()) {
+            r.fail("no memory report");
+            return;
+        }
+
+        r.record("plain_ms", plainNs / 1e6, "ms");
+        r.record("tracked_ms", trackedNs / 1e6, "ms");
+        r.record("slowdown", double(trackedNs) / plainNs, "x");
+        r.record("rss_growth_mb", report->rssGrowthBytes / (1024.0 * 1024.0), "MB");
+        r.record("top_site_line", report->topSites.first().line, "line");
+        r.record("top_site_mb", report->topSites.first().bytes / (1024.0 * 1024.0), "MB");
+    });
+
+    // 单元格：开头的单元格加载数据，只修改最后一个单元格后重新运行
+    suite.add("cells/rerun", [&](BenchSuite::Recorder& r) {
+        const int kCells = 200;
+
+        QString buffer = "# %% 加载数据\n"
+                         "import time\n"
+                         "time.sleep(0.2)\n"
+                         "data = list(range(1000000))\n";
+        for (int i = 1; i < kCells; ++i) {
+            buffer += QString("\n# %% 单元格%1\nvalue_%1 = sum(data[:%1])\n").arg(i);
+        }
+
+        CellIndex     index;
+        QElapsedTimer timer;
+        timer.start();
+        index.update(buffer);
+        const qint64 updateNs = timer.nsecsElapsed();
+        if (index.cells().size() != kCells) {
+            r.fail(QString("expected %1 cells, found %2").arg(kCells).arg(index.cells().size()));
+            return;
+        }
+
+        QVector<int> all;
+        for (int i = 0; i < kCells; ++i) {
+            all.append(i);
+        }
+
+        // 每个单元格都只依赖开头的单元格：修改开头的单元格影响全部，修改中间的只影响自己
+        CellDependencies dependencies;
+        timer.restart();
+        dependencies.update(buffer, index);
+        if (dependencies.isPending()) {
+            QEventLoop loop;
+            QObject::connect(&dependencies, &CellDependencies::analyzed, &loop, [&]() {
+                if (!dependencies.isPending()) {
+                    loop.quit();
+                }
+            });
+            loop.exec();
+        }
+        const qint64 analyzeNs      = timer.nsecsElapsed();
+        const int    affectedByLoad = dependencies.affected(index, {0}).size();
+        const int    affectedByCell = dependencies.affected(index, {kCells / 2}).size();
+        if (affectedByLoad != kCells || affectedByCell != 1) {
+            r.fail(QString("unexpected dependencies: %1 and %2 affected cells")
+                       .arg(affectedByLoad)
+                       .arg(affectedByCell));
+            return;
+        }
+
+        const bool wasPersistent = pyManager.isPersistentNamespace();
+        pyManager.setPersistentNamespace(true);
+        runner->setBreakpoints(QSet<int>());
+
+        const qint64 fullNs = runOnce(runner, index.code(buffer, all));
+        index.markExecuted(index.hashes(all));
+
+        // 修改最后一个单元格，只有它变为已修改
+        buffer += " + 1\n";
+        index.update(buffer);
+        const QVector<int> stale = index.staleCells();
+        const qint64       cellNs = runOnce(runner, index.code(buffer, stale));
+
+        pyManager.setPersistentNamespace(wasPersistent);
+
+        if (stale.size() != 1) {
+            r.fail(QString("expected 1 changed cell, found %1").arg(stale.size()));
+            return;
+        }
+
+        r.record("update_us", updateNs / 1e3, "us");
+        r.record("analyze_us_per_cell", analyzeNs / 1e3 / kCells, "us");
+        r.record("full_run_ms", fullNs / 1e6, "ms");
+        r.record("changed_cell_ms", cellNs / 1e6, "ms");
+    });
+
+    // 语法高亮：20000行代码逐行词法分析，耗时应与字符数成正比
+    suite.add("editor/lex", [](BenchSuite::Recorder& r) {
+        const int   kLines = 20000;
+        QStringList lines;
+        lines.reserve(kLines);
+        for (int i = 0; lines.size() < kLines; ++i) {
+            lines << QString("def function_%1(value, items=None):").arg(i)
+                  << QString("    \"\"\"Docstring %1 with 'quotes' and # no comment\"\"\"").arg(i)
+                  << QString("    result = [len(str(x)) + 0x%1 for x in range(value) if x % 3]  # comment").arg(i, 0, 16)
+                  << QString("    return sorted(result, key=lambda item: (item, r'raw\\d+', f\"{item!r}\"))")
+                  << QString();
+        }
+
+        qint64 chars = 0;
+        for (const QString& line : lines) {
+            chars += line.size();
+        }
+
+        QVector<PythonLexer::Token> tokens;
+        int                         state = PythonLexer::kInitialState;
+        qint64                      count = 0;
+        QElapsedTimer               timer;
+        timer.start();
+        for (const QString& line : lines) {
+            state = PythonLexer::lexLine(line, state, &tokens);
+            count += tokens.size();
+        }
+        const qint64 lexNs = timer.nsecsElapsed();
+
+        if (state != PythonLexer::kInitialState || count == 0) {
+            r.fail(QString("unexpected final state %1 after %2 tokens").arg(state).arg(count));
+            return;
+        }
+        r.record("lex_ms", lexNs / 1e6, "ms");
+        r.record("lex_ns_per_char", static_cast<double>(lexNs) / chars, "ns");
+    });
+
+    // 分块加载：第一块到达的延迟和解码吞吐量（不含向编辑器追加）
+    suite.add("editor/load", [](BenchSuite::Recorder& r) {
+        const qint64   kFileBytes = qint64(64) << 20;
+        QTemporaryFile file;
+        if (!file.open()) {
+            r.fail("cannot create temporary file");
+            return;
+        }
+        const QByteArray line = QString("    result = [len(str(x)) for x in range(value)]  # 注释\n").toUtf8();
+        QByteArray       block;
+        while (block.size() < (1 << 20)) {
+            block += line;
+        }
+        while (file.size() < kFileBytes) {
+            file.write(block);
+        }
+        file.flush();
+        const qint64 fileBytes = file.size();
+
+        FileLoader    loader;
+        QElapsedTimer timer;
+        timer.start();
+        if (!loader.start(file.fileName())) {
+            r.fail(loader.errorString());
+            return;
+        }
+
+        QString text;
+        qint64  loadedBytes = 0;
+        qint64  firstNs     = -1;
+        qint64  chars       = 0;
+        while (!loader.isFinished()) {
+            if (!loader.takeChunk(&text, &loadedBytes)) {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            if (firstNs < 0) {
+                firstNs = timer.nsecsElapsed();
+            }
+            chars += text.size();
+        }
+        const qint64 totalNs = timer.nsecsElapsed();
+
+        if (loadedBytes != fileBytes || chars == 0) {
+            r.fail(QString("loaded %1 of %2 bytes").arg(loadedBytes).arg(fileBytes));
+            return;
+        }
+        r.record("first_chunk_ms", firstNs / 1e6, "ms");
+        r.record("load_ms", totalNs / 1e6, "ms");
+        r.record("load_mb_per_s", fileBytes / 1048576.0 / (totalNs / 1e9), "MB/s");
+    });
+
+    // 格式化结果与原文的逐行差分（界面线程只应用差分结果）
+    suite.add("editor/format_diff", [](BenchSuite::Recorder& r) {
+        const int   kLines = 20000;
+        QStringList before;
+        before.reserve(kLines);
+        for (int i = 0; i < kLines; ++i) {
+            before << QString("    value_%1 = compute(%1, items)").arg(i);
+        }
+        QStringList after = before;
+        for (int i = 100; i < kLines; i += kLines / 100) {
+            after[i] = after[i] + "  # formatted";
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<CodeFormatter::LineEdit> edits = CodeFormatter::diffLines(before, after);
+        const qint64                           diffNs = timer.nsecsElapsed();
+
+        if (edits.size() != 100) {
+            r.fail(QString("expected 100 edits, got %1").arg(edits.size()));
+            return;
+        }
+        r.record("diff_ms", diffNs / 1e6, "ms");
+        r.record("edits", edits.size(), "edits");
+    });
+
+    // 补全索引：逐行提取缓冲区中定义的名字（编辑后只重新分析新出现的行）
+    suite.add("editor/complete_scan", [](BenchSuite::Recorder& r) {
+        const int   kLines = 20000;
+        QStringList lines;
+        lines.reserve(kLines);
+        for (int i = 0; i < kLines; i += 4) {
+            lines << QString("def func_%1(items):").arg(i);
+            lines << QString("    value_%1 = compute(items)  # 注释").arg(i);
+            lines << QString("    for key, item in items:");
+            lines << QString("        print(\"%1\", key)").arg(i);
+        }
+
+        QSet<QString> names;
+        int           state = PythonLexer::kInitialState;
+        QElapsedTimer timer;
+        timer.start();
+        for (const QString& line : lines) {
+            const CompletionEngine::LineSymbols symbols = CompletionEngine::scanLine(line, state);
+            for (const QString& name : symbols.names) {
+                names.insert(name);
+            }
+            state = symbols.endState;
+        }
+        const qint64 scanNs = timer.nsecsElapsed();
+
+        // func_i、value_i，以及key和item
+        if (names.size() != kLines / 2 + 2) {
+            r.fail(QString("expected %1 names, got %2").arg(kLines / 2 + 2).arg(names.size()));
+            return;
+        }
+        r.record("scan_ms", scanNs / 1e6, "ms");
+        r.record("lines_per_s", kLines / (scanNs / 1e9), "lines/s");
+    });
+
+    // 大纲：整个缓冲区分析一次，之后每次编辑只分析被修改的行
+    suite.add("editor/outline_update", [](BenchSuite::Recorder& r) {
+        const int   kLines = 20000;
+        const int   kEdits = 10000;
+        QStringList lines;
+        lines.reserve(kLines);
+        for (int i = 0; i < kLines; i += 4) {
+            lines << QString("class Model_%1:").arg(i);
+            lines << QString("    def method_%1(self):").arg(i);
+            lines << QString("        value = compute(%1)").arg(i);
+            lines << QString();
+        }
+
+        OutlineIndex  index;
+        QElapsedTimer timer;
+        timer.start();
+        index.reset(lines);
+        const qint64 resetNs = timer.nsecsElapsed();
+
+        // 在中间反复插入一行再删除，其后的定义行号都会移动
+        timer.restart();
+        for (int i = 0; i < kEdits; ++i) {
+            const int line = kLines / 2 + i % 100;
+            index.update(line, 1, {QString("        value = %1").arg(i), lines[line]});
+            index.update(line, 2, {lines[line]});
+        }
+        const qint64 editNs = timer.nsecsElapsed();
+
+        if (index.lineCount() != kLines || index.symbols().size() != kLines / 2) {
+            r.fail(QString("expected %1 symbols, got %2").arg(kLines / 2).arg(index.symbols().size()));
+            return;
+        }
+        r.record("reset_ms", resetNs / 1e6, "ms");
+        r.record("edit_us", editNs / 1e3 / (2 * kEdits), "us");
+    });
+
+    // 诊断进程中一次检查的耗时（这里在本进程中直接检查），末行的语法错误须被报告
+    suite.add("editor/syntax_check", [](BenchSuite::Recorder& r) {
+        const int kLines = 2000;
+        QString   code;
+        for (int i = 0; i < kLines; i += 4) {
+            code += QString("def function_%1(value):\n"
+                            "    result = value * %1\n"
+                            "    return result\n"
+                            "\n")
+                        .arg(i);
+        }
+        code += "print(function_0(1)\n";
+
+        py::gil_scoped_acquire           acquire;
+        SyntaxCheck                      checker;
+        QElapsedTimer                    timer;
+        QVector<SyntaxCheck::Diagnostic> diagnostics;
+        timer.start();
+        diagnostics = checker.check(code);
+        const qint64 firstNs = timer.nsecsElapsed();
+        timer.restart();
+        diagnostics = checker.check(code);
+        const qint64 checkNs = timer.nsecsElapsed();
+
+        if (diagnostics.isEmpty() || diagnostics.first().severity != SyntaxCheck::Error) {
+            r.fail("syntax error not reported");
+            return;
+        }
+        r.record("first_ms", firstNs / 1e6, "ms");
+        r.record("check_ms", checkNs / 1e6, "ms");
+    });
+
+    // 读取设置：每次经QSettings查找与从内存中的配置取值
+    suite.add("config/get", [](BenchSuite::Recorder& r) {
+        const int      kReads = 100000;
+        QTemporaryFile file;
+        if (!file.open()) {
+            r.fail("cannot create temporary file");
+            return;
+        }
+        QSettings settings(file.fileName(), QSettings::IniFormat);
+        settings.setValue("Editor/fontSize", 12);
+        settings.sync();
+
+        QElapsedTimer timer;
+        qint64        sum = 0;
+        timer.start();
+        for (int i = 0; i < kReads; ++i) {
+            sum += settings.value("Editor/fontSize", 12).toInt();
+        }
+        const qint64 settingsNs = timer.nsecsElapsed();
+
+        const ConfigManager& config = ConfigManager::instance();
+        timer.restart();
+        for (int i = 0; i < kReads; ++i) {
+            sum += config.getEditorFontSize();
+        }
+        const qint64 memoryNs = timer.nsecsElapsed();
+
+        if (sum != 2LL * 12 * kReads) {
+            r.fail(QString("unexpected sum %1").arg(sum));
+            return;
+        }
+        r.record("qsettings_ns", static_cast<double>(settingsNs) / kReads, "ns");
+        r.record("memory_ns", static_cast<double>(memoryNs) / kReads, "ns");
+    });
+
+    // 每次运行新建命名空间的开销
+    suite.add("namespace/fresh", [&pyManager](BenchSuite::Recorder& r) {
+        const int              kNamespaces = 10000;
+        py::gil_scoped_acquire acquire;
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < kNamespaces; ++i) {
+            pyManager.runNamespace();
+        }
+        r.record("us", timer.nsecsElapsed() / 1e3 / kNamespaces, "us");
+    });
+
+    // 子解释器池：同一批任务分别用1个和全部工作线程运行
+    const int kPoolJobs = qMax(2, QThread::idealThreadCount());
+    suite.add(
+        "pool/batch",
+        [&](BenchSuite::Recorder& r) {
+            const int poolWorkers = InterpreterPool::hasPerInterpreterGil() ? kPoolJobs : 1;
+
+            InterpreterPool::Metrics serialMetrics;
+            InterpreterPool::Metrics parallelMetrics;
+            const qint64 serialNs   = runPoolBatch(1, kPoolJobs, loopCode, &serialMetrics);
+            const qint64 parallelNs = runPoolBatch(poolWorkers, kPoolJobs, loopCode, &parallelMetrics);
+            if (serialNs <= 0 || parallelNs <= 0) {
+                r.fail("interpreter pool did not start");
+                return;
+            }
+
+            r.record("per_interpreter_gil", InterpreterPool::hasPerInterpreterGil() ? 1 : 0, "bool");
+            r.record("workers", parallelMetrics.workers, "workers");
+            r.record("serial_ms", serialNs / 1e6, "ms");
+            r.record("parallel_ms", parallelNs / 1e6, "ms");
+            r.record("speedup", double(serialNs) / parallelNs, "x");
+            r.record("utilisation", parallelMetrics.utilisation, "ratio");
+            r.record("max_queue_wait_ms", parallelMetrics.maxQueueWaitNs / 1e6, "ms");
+        },
+        3,
+        0);
+
+    // 执行进程池：每个进程有自己的GIL，与Python版本无关
+    suite.add(
+        "process/batch",
+        [&](BenchSuite::Recorder& r) {
+            ProcessPool::Metrics serialMetrics;
+            ProcessPool::Metrics parallelMetrics;
+            const qint64 serialNs   = runProcessBatch(1, kPoolJobs, loopCode, &serialMetrics);
+            const qint64 parallelNs = runProcessBatch(kPoolJobs, kPoolJobs, loopCode, &parallelMetrics);
+            if (serialNs <= 0 || parallelNs <= 0) {
+                r.fail("process pool did not start");
+                return;
+            }
+
+            r.record("workers", parallelMetrics.workers, "workers");
+            r.record("serial_ms", serialNs / 1e6, "ms");
+            r.record("parallel_ms", parallelNs / 1e6, "ms");
+            r.record("speedup", double(serialNs) / parallelNs, "x");
+            r.record("utilisation", parallelMetrics.utilisation, "ratio");
+        },
+        3,
+        0);
+
+    // 执行进程崩溃后重新就绪的时间
+    suite.add(
+        "process/respawn",
+        [](BenchSuite::Recorder& r) {
+            const qint64 respawnNs = measureRespawn();
+            if (respawnNs <= 0) {
+                r.fail("execution worker did not respawn");
+                return;
+            }
+            r.record("ms", respawnNs / 1e6, "ms");
+        },
+        3,
+        0);
+
+    // 手动重启执行进程：没有备用进程时等待新进程初始化，有备用进程时直接换上
+    suite.add(
+        "process/restart",
+        [](BenchSuite::Recorder& r) {
+            const qint64 coldNs  = measureWorkerRestart(false);
+            const qint64 spareNs = measureWorkerRestart(true);
+            if (coldNs <= 0 || spareNs <= 0) {
+                r.fail("execution worker did not restart");
+                return;
+            }
+            r.record("cold_ms", coldNs / 1e6, "ms");
+            r.record("spare_ms", spareNs / 1e6, "ms");
+        },
+        3,
+        0);
+
+    // 本地执行服务：Ping和运行空代码的往返延迟，逐个等待回复与流水线发送对比
+    suite.add(
+        "server/roundtrip",
+        [](BenchSuite::Recorder& r) {
+            const int kPings = 1000;
+            const int kRuns  = 200;
+
+            ExecutionServer server;
+            if (!server.listen(QString("embed_bench-%1").arg(QCoreApplication::applicationPid()))) {
+                r.fail("server cannot listen: " + server.errorString());
+                return;
+            }
+            QLocalSocket socket;
+            socket.connectToServer(server.fullServerName());
+            if (!socket.waitForConnected(5000)) {
+                r.fail("cannot connect to server");
+                return;
+            }
+
+            QByteArray    buffer;
+            QElapsedTimer timer;
+
+            // 发送count条命令并等待同样多的回复，pipelined时先全部发出再统一等待
+            auto roundTrips = [&](quint16 command, quint16 reply, const QByteArray& payload, int count, bool pipelined) {
+                timer.restart();
+                for (int i = 0; i < count; ++i) {
+                    socket.write(ServerProtocol::encodeFrame(command, static_cast<quint32>(i), payload));
+                    if (!pipelined && !readServerFrames(&socket, &buffer, reply, 1)) {
+                        return qint64(-1);
+                    }
+                }
+                if (pipelined && !readServerFrames(&socket, &buffer, reply, count)) {
+                    return qint64(-1);
+                }
+                return timer.nsecsElapsed();
+            };
+
+            // 第一次运行等待运行器就绪，不计入
+            if (roundTrips(ServerProtocol::Run, ServerProtocol::Finished, "pass", 1, false) < 0) {
+                r.fail("warm-up run did not finish");
+                return;
+            }
+
+            const qint64 pingNs          = roundTrips(ServerProtocol::Ping, ServerProtocol::Pong, "x", kPings, false);
+            const qint64 pipelinedPingNs = roundTrips(ServerProtocol::Ping, ServerProtocol::Pong, "x", kPings, true);
+            const qint64 runNs           = roundTrips(ServerProtocol::Run, ServerProtocol::Finished, "pass", kRuns, false);
+            const qint64 pipelinedRunNs  = roundTrips(ServerProtocol::Run, ServerProtocol::Finished, "pass", kRuns, true);
+            if (pingNs < 0 || pipelinedPingNs < 0 || runNs < 0 || pipelinedRunNs < 0) {
+                r.fail("server did not reply");
+                return;
+            }
+
+            const ExecutionServer::Metrics metrics = server.metrics();
+            r.record("ping_us", pingNs / 1e3 / kPings, "us");
+            r.record("pipelined_ping_us", pipelinedPingNs / 1e3 / kPings, "us");
+            r.record("run_us", runNs / 1e3 / kRuns, "us");
+            r.record("pipelined_run_us", pipelinedRunNs / 1e3 / kRuns, "us");
+            r.record("server_reply_us", metrics.totalReplyNs / 1e3 / qMax<quint64>(1, metrics.commands), "us");
+        },
+        3,
+        0);
+
+    // 运行环境，写入JSON结果便于区分不同机器和版本的数据
+    const quint32          version = pyManager.pythonVersionHex();
+    QMap<QString, QString> environment;
+    environment.insert("python",
+                       QString("%1.%2.%3")
+                           .arg(version >> 24)
+                           .arg((version >> 16) & 0xFF)
+                           .arg((version >> 8) & 0xFF));
+    environment.insert("qt", QString::fromLatin1(qVersion()));
+    environment.insert("os", QSysInfo::prettyProductName());
+    environment.insert("cpu_arch", QSysInfo::currentCpuArchitecture());
+    environment.insert("cpus", QString::number(QThread::idealThreadCount()));
+
+    QStringList arguments = QCoreApplication::arguments();
+    arguments.removeFirst();
+    const int status = suite.run(arguments, environment);
+
+    runnerThread->quit();
+    runnerThread->wait();
+    delete runner;
+    delete runnerThread;
+
+    pyManager.cleanup();
+    return status;
+}
@@ -1,14 +1,37 @@
+#include "BatchRunner.h"
+#include "ConfigManager.h"
+#include "ExecutionWorker.h"
 #include "PyWindow.h"
+#include "WorkerProtocol.h"
 
 #include <QApplication>
 #include <QDir>
 
+#include <cstring>
+
 
 
 int main(int argc, char *argv[])
 {
+    // 执行进程模式：不创建窗口，只运行代码
+    if (argc >= 3 && strcmp(argv[1], WorkerProtocol::kWorkerArgument) == 0) {
+        QCoreApplication app(argc, argv);
+        ConfigManager::instance().initialize();
+        return ExecutionWorker::run(QString::fromLocal8Bit(argv[2]));
+    }
+
+    // 批量模式：不创建窗口，在执行进程池中运行脚本
+    if (argc >= 2 && strcmp(argv[1], BatchRunner::kBatchArgument) == 0) {
+        QCoreApplication app(argc, argv);
+        ConfigManager::instance().initialize();
+        return BatchRunner::main(QCoreApplication::arguments());
+    }
+
     QApplication app(argc, argv);
 
+    // 所有设置在这里读取一次，界面、编辑器和解释器都从内存中取值
+    ConfigManager::instance().initialize();
+
     PyWindow mainWindow;
     mainWindow.setWindowTitle("Python Code Editor & Runner");
     mainWindow.show();
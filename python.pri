@@ -0,0 +1,14 @@
+# Python解释器配置，主工程和bench子工程共用
+
+PYTHON_ROOT=C:/Users/w/.conda/pkgs/python-3.10.19-h981015d_0
+
+INCLUDEPATH += $$PWD/3rd/include
+INCLUDEPATH += $$PYTHON_ROOT/include
+
+win32:CONFIG(release, debug|release): LIBS += -L$$PYTHON_ROOT/libs/ -lpython310
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PYTHON_ROOT/libs/ -lpython310_d
+
+unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += python3-embed
+}